@@ -445,6 +445,97 @@ usage(void)
 	fprintf(stderr, "                      newest trace file in /dev/shm\n");
 #endif
 	fprintf(stderr, "                 '-j' to use JSON to format the output\n");
+	fprintf(stderr, "                 '-o' to save the traces as an indexed file\n");
+	fprintf(stderr, "                      for faster -r and -O queries\n");
+	fprintf(stderr, "                 '-r' to only display events within <start>,<end>\n");
+	fprintf(stderr, "                      in microseconds (either may be omitted)\n");
+	fprintf(stderr, "                 '-O' to only display events of a single\n");
+	fprintf(stderr, "                      object, using its id as displayed (e.g. R12)\n");
+}
+
+static int
+parse_time_range(const char *str, double *start, double *end)
+{
+	char *endptr;
+
+	*start = 0;
+	*end = -1;
+	if (*str != ',') {
+		*start = strtod(str, &endptr);
+		if (endptr == str || *start < 0) {
+			return -EINVAL;
+		}
+		str = endptr;
+	}
+
+	if (*str == '\0') {
+		return 0;
+	} else if (*str++ != ',') {
+		return -EINVAL;
+	}
+
+	if (*str != '\0') {
+		*end = strtod(str, &endptr);
+		if (endptr == str || *endptr != '\0' || *end < *start) {
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+static void
+seek_time_range(double start_us, double end_us)
+{
+	uint64_t tsc_rate = spdk_trace_get_tsc_rate(g_file);
+	uint64_t tsc_offset = spdk_trace_parser_get_tsc_offset(g_parser);
+	uint64_t tsc_end = UINT64_MAX;
+
+	if (end_us >= 0) {
+		tsc_end = tsc_offset + (uint64_t)(end_us * tsc_rate / (1000 * 1000));
+	}
+
+	spdk_trace_parser_seek_time_range(g_parser, tsc_offset +
+					  (uint64_t)(start_us * tsc_rate / (1000 * 1000)), tsc_end);
+}
+
+static int
+seek_object(const char *id)
+{
+	struct spdk_trace_section_object *obj_section = spdk_trace_get_object_section(g_file);
+	uint64_t index;
+	char *endptr;
+	uint16_t i;
+	int rc;
+
+	if (id[0] == '\0' || id[1] == '\0') {
+		fprintf(stderr, "Invalid object id: %s\n", id);
+		return -EINVAL;
+	}
+
+	index = strtoull(&id[1], &endptr, 10);
+	if (*endptr != '\0') {
+		fprintf(stderr, "Invalid object id: %s\n", id);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < obj_section->count; ++i) {
+		if (i != OBJECT_NONE && obj_section->object[i].id_prefix == id[0]) {
+			break;
+		}
+	}
+
+	if (i == obj_section->count) {
+		fprintf(stderr, "Unknown object type: %c\n", id[0]);
+		return -EINVAL;
+	}
+
+	rc = spdk_trace_parser_seek_object(g_parser, i, index);
+	if (rc != 0) {
+		fprintf(stderr, "Failed to find object %s: %s\n", id, spdk_strerror(-rc));
+	}
+
+	return rc;
 }
 
 #if defined(__linux__)
@@ -471,13 +562,17 @@ main(int argc, char **argv)
 	int				lcore = SPDK_TRACE_MAX_LCORE;
 	const char			*app_name = NULL;
 	const char			*file_name = NULL;
+	const char			*index_name = NULL;
+	const char			*object_id = NULL;
+	double				range_start = 0, range_end = -1;
+	bool				range = false;
 	int				op;
 	int				rc = 0;
 	char				shm_name[64];
 	int				shm_id = -1, shm_pid = -1;
 
 	g_exe_name = argv[0];
-	while ((op = getopt(argc, argv, "c:f:i:jp:s:tT")) != -1) {
+	while ((op = getopt(argc, argv, "c:f:i:jo:O:p:r:s:tT")) != -1) {
 		switch (op) {
 		case 'c':
 			lcore = atoi(optarg);
@@ -509,6 +604,20 @@ main(int argc, char **argv)
 		case 'j':
 			print_format = PRINT_FMT_JSON;
 			break;
+		case 'o':
+			index_name = optarg;
+			break;
+		case 'O':
+			object_id = optarg;
+			break;
+		case 'r':
+			if (parse_time_range(optarg, &range_start, &range_end) != 0) {
+				fprintf(stderr, "Invalid time range: %s\n", optarg);
+				usage();
+				exit(1);
+			}
+			range = true;
+			break;
 		default:
 			usage();
 			exit(1);
@@ -521,6 +630,12 @@ main(int argc, char **argv)
 		exit(1);
 	}
 
+	if (range && object_id != NULL) {
+		fprintf(stderr, "-r and -O are mutually exclusive\n");
+		usage();
+		exit(1);
+	}
+
 	if (file_name == NULL && app_name == NULL) {
 #if defined(__linux__)
 		nftw("/dev/shm", get_newest, 1, 0);
@@ -558,6 +673,27 @@ main(int argc, char **argv)
 	}
 
 	g_file = spdk_trace_parser_get_file(g_parser);
+	if (index_name != NULL) {
+		rc = spdk_trace_parser_save_index(g_parser, index_name);
+		if (rc != 0) {
+			fprintf(stderr, "Failed to save indexed trace file %s: %s\n", index_name,
+				spdk_strerror(-rc));
+		}
+		spdk_trace_parser_cleanup(g_parser);
+		return rc == 0 ? 0 : 1;
+	}
+
+	if (object_id != NULL) {
+		rc = seek_object(object_id);
+	} else if (range) {
+		seek_time_range(range_start, range_end);
+	}
+
+	if (rc != 0) {
+		spdk_trace_parser_cleanup(g_parser);
+		return 1;
+	}
+
 	switch (print_format) {
 	case PRINT_FMT_JSON:
 		rc = trace_print_json();
@@ -173,6 +173,7 @@ if [ $SPDK_RUN_FUNCTIONAL_TEST -eq 1 ]; then
 		run_test "bdev_raid" $rootdir/test/bdev/bdev_raid.sh
 		run_test "spdkcli_raid" $rootdir/test/spdkcli/raid.sh
 		run_test "blockdev_raid5f" $rootdir/test/bdev/blockdev.sh "raid5f"
+		run_test "blockdev_raid6" $rootdir/test/bdev/blockdev.sh "raid6"
 	fi
 
 	if [[ $(uname -s) == Linux ]]; then
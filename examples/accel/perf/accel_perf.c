@@ -14,6 +14,7 @@
 #include "spdk/crc32.h"
 #include "spdk/util.h"
 #include "spdk/xor.h"
+#include "spdk/pq.h"
 #include "spdk/dif.h"
 
 #define DATA_PATTERN 0x5a
@@ -143,6 +144,8 @@ dump_user_config(void)
 		printf("Failure inject: %u percent\n", g_fail_percent_goal);
 	} else if (g_workload_selection == SPDK_ACCEL_OPC_XOR) {
 		printf("Source buffers: %u\n", g_xor_src_count);
+	} else if (g_workload_selection == SPDK_ACCEL_OPC_PQ_GEN) {
+		printf("Data buffers:   %u\n", g_xor_src_count);
 	}
 	if (g_workload_selection == SPDK_ACCEL_OPC_COPY_CRC32C ||
 	    g_workload_selection == SPDK_ACCEL_OPC_DIF_VERIFY ||
@@ -186,13 +189,14 @@ usage(void)
 	printf("\t[-o transfer size in bytes (default: 4KiB. For compress/decompress, 0 means the input file size)]\n");
 	printf("\t[-t time in seconds]\n");
 	printf("\t[-w workload type must be one of these: copy, fill, crc32c, copy_crc32c, compare, compress, decompress, dualcast, xor,\n");
+	printf("\t[                                       pq_gen,\n");
 	printf("\t[                                       dif_verify, dif_verify_copy, dif_generate, dif_generate_copy, dix_generate, dix_verify\n");
 	printf("\t[-M assign module to the operation, not compatible with accel_assign_opc RPC\n");
 	printf("\t[-l for compress/decompress workloads, name of uncompressed input file\n");
 	printf("\t[-S for crc32c workload, use this seed value (default 0)\n");
 	printf("\t[-P for compare workload, percentage of operations that should miscompare (percent, default 0)\n");
 	printf("\t[-f for fill workload, use this BYTE value (default 255)\n");
-	printf("\t[-x for xor workload, use this number of source buffers (default, minimum: 2)]\n");
+	printf("\t[-x for xor and pq_gen workloads, use this number of source buffers (default, minimum: 2)]\n");
 	printf("\t[-y verify result if this switch is on]\n");
 	printf("\t[-a tasks to allocate per core (default: same value as -q)]\n");
 	printf("\t\tCan be used to spread operations across a wider range of memory.\n");
@@ -282,6 +286,8 @@ parse_args(int ch, char *arg)
 			g_workload_selection = SPDK_ACCEL_OPC_DECOMPRESS;
 		} else if (!strcmp(g_workload_type, "xor")) {
 			g_workload_selection = SPDK_ACCEL_OPC_XOR;
+		} else if (!strcmp(g_workload_type, "pq_gen")) {
+			g_workload_selection = SPDK_ACCEL_OPC_PQ_GEN;
 		} else if (!strcmp(g_workload_type, "dif_verify")) {
 			g_workload_selection = SPDK_ACCEL_OPC_DIF_VERIFY;
 		} else if (!strcmp(g_workload_type, "dif_verify_copy")) {
@@ -364,6 +370,17 @@ accel_perf_construct_iovs(void *buf, uint64_t sz, struct iovec *iovs, uint32_t i
 	assert(sz == 0);
 }
 
+static inline uint32_t
+_get_sources_count(void)
+{
+	/* pq_gen stores P and Q right after the data buffers */
+	if (g_workload_selection == SPDK_ACCEL_OPC_PQ_GEN) {
+		return g_xor_src_count + 2;
+	}
+
+	return g_xor_src_count;
+}
+
 static int
 _get_task_data_bufs(struct ap_task *task)
 {
@@ -552,14 +569,15 @@ _get_task_data_bufs(struct ap_task *task)
 			}
 			task->md_iov.iov_len = md_buff_len;
 		}
-	} else if (g_workload_selection == SPDK_ACCEL_OPC_XOR) {
+	} else if (g_workload_selection == SPDK_ACCEL_OPC_XOR ||
+		   g_workload_selection == SPDK_ACCEL_OPC_PQ_GEN) {
 		assert(g_xor_src_count > 1);
-		task->sources = calloc(g_xor_src_count, sizeof(*task->sources));
+		task->sources = calloc(_get_sources_count(), sizeof(*task->sources));
 		if (!task->sources) {
 			return -ENOMEM;
 		}
 
-		for (i = 0; i < g_xor_src_count; i++) {
+		for (i = 0; i < _get_sources_count(); i++) {
 			task->sources[i] = spdk_dma_zmalloc(g_xfer_size_bytes, 0, NULL);
 			if (!task->sources[i]) {
 				return -ENOMEM;
@@ -604,7 +622,8 @@ _get_task_data_bufs(struct ap_task *task)
 
 	/* For dualcast 2 buffers are needed for the operation.  */
 	if (g_workload_selection == SPDK_ACCEL_OPC_DUALCAST ||
-	    (g_workload_selection == SPDK_ACCEL_OPC_XOR && g_verify)) {
+	    (g_workload_selection == SPDK_ACCEL_OPC_XOR && g_verify) ||
+	    (g_workload_selection == SPDK_ACCEL_OPC_PQ_GEN && g_verify)) {
 		task->dst2 = spdk_dma_zmalloc(g_xfer_size_bytes, align, NULL);
 		if (task->dst2 == NULL) {
 			fprintf(stderr, "Unable to alloc dst buffer\n");
@@ -753,6 +772,10 @@ _submit_single(struct worker_thread *worker, struct ap_task *task)
 		rc = spdk_accel_submit_xor(worker->ch, task->dst, task->sources, g_xor_src_count,
 					   g_xfer_size_bytes, accel_done, task);
 		break;
+	case SPDK_ACCEL_OPC_PQ_GEN:
+		rc = spdk_accel_submit_pq_gen(worker->ch, task->sources, g_xor_src_count,
+					      g_xfer_size_bytes, accel_done, task);
+		break;
 	case SPDK_ACCEL_OPC_DIF_VERIFY:
 		rc = spdk_accel_submit_dif_verify(worker->ch, task->src_iovs, task->src_iovcnt, task->num_blocks,
 						  &task->dif_ctx, &task->dif_err, accel_done, task);
@@ -824,9 +847,10 @@ _free_task_buffers(struct ap_task *task)
 			free(task->dst_iovs);
 		}
 		spdk_dma_free(task->md_iov.iov_base);
-	} else if (g_workload_selection == SPDK_ACCEL_OPC_XOR) {
+	} else if (g_workload_selection == SPDK_ACCEL_OPC_XOR ||
+		   g_workload_selection == SPDK_ACCEL_OPC_PQ_GEN) {
 		if (task->sources) {
-			for (i = 0; i < g_xor_src_count; i++) {
+			for (i = 0; i < _get_sources_count(); i++) {
 				spdk_dma_free(task->sources[i]);
 			}
 			free(task->sources);
@@ -836,7 +860,8 @@ _free_task_buffers(struct ap_task *task)
 	}
 
 	spdk_dma_free(task->dst);
-	if (g_workload_selection == SPDK_ACCEL_OPC_DUALCAST || g_workload_selection == SPDK_ACCEL_OPC_XOR) {
+	if (g_workload_selection == SPDK_ACCEL_OPC_DUALCAST || g_workload_selection == SPDK_ACCEL_OPC_XOR ||
+	    g_workload_selection == SPDK_ACCEL_OPC_PQ_GEN) {
 		spdk_dma_free(task->dst2);
 	}
 }
@@ -863,6 +888,33 @@ _vector_memcmp(void *_dst, struct iovec *src_src_iovs, uint32_t iovcnt)
 	return 0;
 }
 
+static int
+_verify_pq(struct ap_task *task)
+{
+	void **buffers;
+	int rc;
+
+	buffers = calloc(g_xor_src_count + 2, sizeof(*buffers));
+	if (buffers == NULL) {
+		return -ENOMEM;
+	}
+
+	memcpy(buffers, task->sources, g_xor_src_count * sizeof(*buffers));
+	buffers[g_xor_src_count] = task->dst;
+	buffers[g_xor_src_count + 1] = task->dst2;
+
+	rc = spdk_pq_gen(buffers, g_xor_src_count, g_xfer_size_bytes);
+	if (rc == 0 &&
+	    (memcmp(task->dst, task->sources[g_xor_src_count], g_xfer_size_bytes) ||
+	     memcmp(task->dst2, task->sources[g_xor_src_count + 1], g_xfer_size_bytes))) {
+		rc = -1;
+	}
+
+	free(buffers);
+
+	return rc;
+}
+
 static int _worker_stop(void *arg);
 
 static void
@@ -942,6 +994,12 @@ accel_done(void *arg1, int status)
 				worker->xfer_failed++;
 			}
 			break;
+		case SPDK_ACCEL_OPC_PQ_GEN:
+			if (_verify_pq(task) != 0) {
+				SPDK_NOTICELOG("Data miscompare\n");
+				worker->xfer_failed++;
+			}
+			break;
 		case SPDK_ACCEL_OPC_DIF_VERIFY:
 			break;
 		case SPDK_ACCEL_OPC_DIF_GENERATE:
@@ -1597,7 +1655,8 @@ main(int argc, char **argv)
 		return -1;
 	}
 
-	if (g_workload_selection == SPDK_ACCEL_OPC_XOR && g_xor_src_count < 2) {
+	if ((g_workload_selection == SPDK_ACCEL_OPC_XOR ||
+	     g_workload_selection == SPDK_ACCEL_OPC_PQ_GEN) && g_xor_src_count < 2) {
 		usage();
 		return -1;
 	}
@@ -0,0 +1,172 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk/dif.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+
+struct dif_perf_format {
+	const char			*name;
+	uint32_t			data_size;
+	uint32_t			md_size;
+	enum spdk_dif_pi_format		pi_format;
+};
+
+static const struct dif_perf_format g_formats[] = {
+	{ "512+8 PI16", 512, 8, SPDK_DIF_PI_FORMAT_16 },
+	{ "4096+8 PI16", 4096, 8, SPDK_DIF_PI_FORMAT_16 },
+	{ "4096+16 PI32", 4096, 16, SPDK_DIF_PI_FORMAT_32 },
+	{ "4096+16 PI64", 4096, 16, SPDK_DIF_PI_FORMAT_64 },
+};
+
+static uint32_t g_io_size = 128 * 1024;
+static uint32_t g_iov_blocks;
+static uint32_t g_time_in_sec = 2;
+
+static void
+usage(const char *prog)
+{
+	printf("usage: %s [options]\n", prog);
+	printf("\t[-o io size in bytes of data, excluding metadata (default: 131072)]\n");
+	printf("\t[-n number of blocks per iovec (default: all blocks in one iovec)]\n");
+	printf("\t[-t time in seconds per format and operation (default: 2)]\n");
+}
+
+static uint64_t
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int
+run_format(const struct dif_perf_format *fmt)
+{
+	struct spdk_dif_ctx_init_ext_opts dif_opts;
+	struct spdk_dif_ctx ctx;
+	struct spdk_dif_error err_blk;
+	struct iovec *iovs;
+	uint32_t block_size, num_blocks, iov_blocks, iovcnt, i;
+	uint64_t start, end, ios, duration_ns;
+	double gbps[2];
+	uint8_t *buf;
+	int op, rc;
+
+	block_size = fmt->data_size + fmt->md_size;
+	num_blocks = g_io_size / fmt->data_size;
+	if (num_blocks == 0) {
+		fprintf(stderr, "I/O size %u is smaller than block size %u\n", g_io_size, fmt->data_size);
+		return -EINVAL;
+	}
+
+	iov_blocks = g_iov_blocks == 0 ? num_blocks : spdk_min(g_iov_blocks, num_blocks);
+	iovcnt = spdk_divide_round_up(num_blocks, iov_blocks);
+
+	buf = aligned_alloc(4096, SPDK_ALIGN_CEIL((size_t)block_size * num_blocks, 4096));
+	iovs = calloc(iovcnt, sizeof(*iovs));
+	if (buf == NULL || iovs == NULL) {
+		free(buf);
+		free(iovs);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < block_size * num_blocks; i++) {
+		buf[i] = rand();
+	}
+
+	for (i = 0; i < iovcnt; i++) {
+		iovs[i].iov_base = buf + (size_t)i * iov_blocks * block_size;
+		iovs[i].iov_len = (size_t)spdk_min(iov_blocks, num_blocks - i * iov_blocks) * block_size;
+	}
+
+	dif_opts.size = SPDK_SIZEOF(&dif_opts, dif_pi_format);
+	dif_opts.dif_pi_format = fmt->pi_format;
+	rc = spdk_dif_ctx_init(&ctx, block_size, fmt->md_size, true, false, SPDK_DIF_TYPE1,
+			       SPDK_DIF_FLAGS_GUARD_CHECK | SPDK_DIF_FLAGS_APPTAG_CHECK |
+			       SPDK_DIF_FLAGS_REFTAG_CHECK, 0x1234, 0xFFFF, 0x5678, 0, 0, &dif_opts);
+	if (rc != 0) {
+		goto out;
+	}
+
+	/* op 0 measures generate, op 1 measures verify */
+	for (op = 0; op < 2; op++) {
+		ios = 0;
+		start = now_ns();
+		do {
+			if (op == 0) {
+				rc = spdk_dif_generate(iovs, iovcnt, num_blocks, &ctx);
+			} else {
+				rc = spdk_dif_verify(iovs, iovcnt, num_blocks, &ctx, &err_blk);
+			}
+			if (rc != 0) {
+				fprintf(stderr, "%s failed for %s: %d\n", op == 0 ? "generate" : "verify",
+					fmt->name, rc);
+				goto out;
+			}
+			ios++;
+			end = now_ns();
+		} while (end - start < g_time_in_sec * 1000000000ULL);
+
+		duration_ns = end - start;
+		gbps[op] = (double)ios * num_blocks * fmt->data_size / duration_ns;
+	}
+
+	printf("%-14s %10u %10u %14.2f %14.2f\n", fmt->name, num_blocks, iovcnt, gbps[0], gbps[1]);
+
+out:
+	free(iovs);
+	free(buf);
+	return rc;
+}
+
+int
+main(int argc, char **argv)
+{
+	uint32_t i;
+	long val;
+	int op, rc;
+
+	while ((op = getopt(argc, argv, "ho:n:t:")) != -1) {
+		switch (op) {
+		case 'o':
+		case 'n':
+		case 't':
+			val = spdk_strtol(optarg, 10);
+			if (val <= 0) {
+				fprintf(stderr, "Invalid value for -%c: %s\n", op, optarg);
+				usage(argv[0]);
+				return 1;
+			}
+			if (op == 'o') {
+				g_io_size = val;
+			} else if (op == 'n') {
+				g_iov_blocks = val;
+			} else {
+				g_time_in_sec = val;
+			}
+			break;
+		case 'h':
+		default:
+			usage(argv[0]);
+			return op == 'h' ? 0 : 1;
+		}
+	}
+
+	printf("Single core DIF throughput, data bytes excluding metadata\n");
+	printf("%-14s %10s %10s %14s %14s\n", "Format", "Blocks", "Iovecs", "Generate GB/s",
+	       "Verify GB/s");
+
+	for (i = 0; i < SPDK_COUNTOF(g_formats); i++) {
+		rc = run_format(&g_formats[i]);
+		if (rc != 0) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -56,7 +56,9 @@ enum spdk_accel_opcode {
 	SPDK_ACCEL_OPC_DIF_GENERATE_COPY	= 14,
 	SPDK_ACCEL_OPC_DIX_GENERATE		= 15,
 	SPDK_ACCEL_OPC_DIX_VERIFY		= 16,
-	SPDK_ACCEL_OPC_LAST			= 17,
+	SPDK_ACCEL_OPC_PQ_GEN			= 17,
+	SPDK_ACCEL_OPC_PQ_RECOVER		= 18,
+	SPDK_ACCEL_OPC_LAST			= 19,
 };
 
 enum spdk_accel_cipher {
@@ -385,6 +387,48 @@ int spdk_accel_get_compress_level_range(enum spdk_accel_comp_algo comp_algo,
 int spdk_accel_submit_xor(struct spdk_io_channel *ch, void *dst, void **sources, uint32_t nsrcs,
 			  uint64_t nbytes, spdk_accel_completion_cb cb_fn, void *cb_arg);
 
+/**
+ * Submit a P+Q parity generation request.
+ *
+ * P is the XOR of the data buffers and Q is the GF(2^8) Reed-Solomon syndrome, see
+ * spdk/pq.h for the exact definition.
+ *
+ * \param ch I/O channel associated with this call.
+ * \param buffers Array of ndata + 2 buffers: the data buffers followed by the P and Q
+ * destination buffers. The array must stay valid until the operation completes.
+ * \param ndata Number of data buffers in the array.
+ * \param nbytes Length in bytes of each buffer.
+ * \param cb_fn Called when this operation completes.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_submit_pq_gen(struct spdk_io_channel *ch, void **buffers, uint32_t ndata,
+			     uint64_t nbytes, spdk_accel_completion_cb cb_fn, void *cb_arg);
+
+/**
+ * Submit a P+Q recovery request.
+ *
+ * Reconstructs up to two lost buffers (data, P or Q) of a set protected by P+Q parity
+ * generated with spdk_accel_submit_pq_gen().
+ *
+ * \param ch I/O channel associated with this call.
+ * \param buffers Array of ndata + 2 buffers laid out as for spdk_accel_submit_pq_gen().
+ * The buffers listed in \b failed are overwritten with the recovered data. The array must
+ * stay valid until the operation completes.
+ * \param ndata Number of data buffers in the array.
+ * \param nbytes Length in bytes of each buffer.
+ * \param failed Array of indices (into \b buffers) of the buffers to recover.
+ * \param nfailed Number of entries in \b failed, 1 or 2.
+ * \param cb_fn Called when this operation completes.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_submit_pq_recover(struct spdk_io_channel *ch, void **buffers, uint32_t ndata,
+				 uint64_t nbytes, const uint32_t *failed, uint32_t nfailed,
+				 spdk_accel_completion_cb cb_fn, void *cb_arg);
+
 /**
  * Build and submit a data encryption request.
  *
@@ -147,6 +147,10 @@ struct spdk_accel_task {
 			enum spdk_accel_comp_algo       algo; /* compresssion/decompression algorithm */
 			uint32_t                        level; /* compression alogrithm level */
 		} comp;
+		struct {
+			uint32_t			failed[2]; /* buffers to recover */
+			uint32_t			nfailed;
+		} pq;
 	};
 	union {
 		uint32_t		*crc_dst;
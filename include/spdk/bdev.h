@@ -278,6 +278,21 @@ union spdk_bdev_nvme_cdw13 {
 };
 SPDK_STATIC_ASSERT(sizeof(union spdk_bdev_nvme_cdw13) == 4, "Incorrect size");
 
+/**
+ * Priority class of an I/O, used by the bdev layer to order I/O queued inside a bdev channel.
+ */
+enum spdk_bdev_io_priority {
+	/** Default priority */
+	SPDK_BDEV_IO_PRIORITY_NORMAL = 0,
+	/** Served before any queued I/O of a lower class */
+	SPDK_BDEV_IO_PRIORITY_HIGH,
+	/**
+	 * Served after queued normal I/O, but not starved by it: a low priority I/O is passed
+	 * over by a limited number of normal priority I/Os only.
+	 */
+	SPDK_BDEV_IO_PRIORITY_LOW,
+};
+
 /**
  * Structure with optional IO request parameters
  */
@@ -308,8 +323,10 @@ struct spdk_bdev_ext_io_opts {
 	union spdk_bdev_nvme_cdw12 nvme_cdw12;
 	/** defined by \ref spdk_bdev_nvme_cdw13 */
 	union spdk_bdev_nvme_cdw13 nvme_cdw13;
+	/** Priority class of this IO, defined by \ref spdk_bdev_io_priority */
+	uint8_t priority;
 } __attribute__((packed));
-SPDK_STATIC_ASSERT(sizeof(struct spdk_bdev_ext_io_opts) == 52, "Incorrect size");
+SPDK_STATIC_ASSERT(sizeof(struct spdk_bdev_ext_io_opts) == 53, "Incorrect size");
 
 /**
  * Get the options for the bdev module.
@@ -899,6 +916,26 @@ void spdk_bdev_get_qos_rate_limits(struct spdk_bdev *bdev, uint64_t *limits);
 void spdk_bdev_set_qos_rate_limits(struct spdk_bdev *bdev, uint64_t *limits,
 				   void (*cb_fn)(void *cb_arg, int status), void *cb_arg);
 
+/**
+ * Set the I/O merging parameters of a bdev.
+ *
+ * When enabled, reads and writes submitted on a channel that continue exactly where the
+ * previous one of the same type ended are held for at most window_us microseconds and
+ * submitted to the bdev module as a single vectored I/O.  Each of them is completed
+ * individually once the merged I/O completes.  Merging is not done while QoS is enabled.
+ *
+ * \param bdev Block device.
+ * \param window_us Longest time an I/O may be held waiting for adjacent I/Os, 0 disables
+ * merging.
+ * \param max_size Largest size of a merged I/O in bytes, at least two blocks.
+ * \param cb_fn Callback function to be called when the settings have been applied to all
+ * channels of the bdev.  Status is -EINVAL if max_size is too small, -ENOTSUP if the bdev
+ * has separate or interleaved metadata, -EAGAIN if the settings are already being modified.
+ * \param cb_arg Argument to pass to cb_fn.
+ */
+void spdk_bdev_set_io_merge(struct spdk_bdev *bdev, uint32_t window_us, uint32_t max_size,
+			    void (*cb_fn)(void *cb_arg, int status), void *cb_arg);
+
 /**
  * Get minimum I/O buffer address alignment for a bdev.
  *
@@ -2396,6 +2433,14 @@ void *spdk_bdev_io_get_md_buf(struct spdk_bdev_io *bdev_io);
  */
 void *spdk_bdev_io_get_cb_arg(struct spdk_bdev_io *bdev_io);
 
+/**
+ * Get the priority class of bdev_io, as passed in \ref spdk_bdev_ext_io_opts.
+ *
+ * \param bdev_io I/O to get the priority from.
+ * \return Priority class of bdev_io.
+ */
+enum spdk_bdev_io_priority spdk_bdev_io_get_priority(const struct spdk_bdev_io *bdev_io);
+
 typedef void (*spdk_bdev_histogram_status_cb)(void *cb_arg, int status);
 typedef void (*spdk_bdev_histogram_data_cb)(void *cb_arg, int status,
 		struct spdk_histogram_data *histogram);
@@ -2581,6 +2626,26 @@ void spdk_bdev_for_each_channel_continue(struct spdk_bdev_channel_iter *i, int s
 void spdk_bdev_for_each_channel(struct spdk_bdev *bdev, spdk_bdev_for_each_channel_msg fn,
 				void *ctx, spdk_bdev_for_each_channel_done cpl);
 
+/**
+ * Call 'fn' on each channel associated with the given bdev, on all threads at once.
+ *
+ * Same as spdk_bdev_for_each_channel(), except that the channels are not visited
+ * one after another. 'fn' is sent to every thread up front, so calls to 'fn' may
+ * overlap in time and 'ctx' must be safe to access from several threads. Each
+ * call to 'fn' must call spdk_bdev_for_each_channel_continue() with the iterator
+ * it was given. A non-zero status does not stop the other channels; the first
+ * one is passed to 'cpl'.
+ *
+ * \param bdev 'fn' will be called on each channel associated with this given bdev.
+ * \param fn Called on the appropriate thread for each channel associated with the given bdev.
+ * \param ctx Context for the caller.
+ * \param cpl Called on the thread that spdk_bdev_for_each_channel_parallel was initially
+ * called from when 'fn' has been called on each channel.
+ */
+void spdk_bdev_for_each_channel_parallel(struct spdk_bdev *bdev,
+		spdk_bdev_for_each_channel_msg fn, void *ctx,
+		spdk_bdev_for_each_channel_done cpl);
+
 /**
  * Get controller attributes for the bdev.
  *
@@ -420,7 +420,7 @@ struct spdk_bdev_module_claim {
 	TAILQ_ENTRY(spdk_bdev_module_claim) link;
 };
 
-typedef TAILQ_HEAD(, spdk_bdev_io) bdev_io_tailq_t;
+typedef TAILQ_HEAD(bdev_io_tailq, spdk_bdev_io) bdev_io_tailq_t;
 typedef STAILQ_HEAD(, spdk_bdev_io) bdev_io_stailq_t;
 typedef TAILQ_HEAD(, lba_range) lba_range_tailq_t;
 
@@ -816,6 +816,13 @@ struct spdk_bdev {
 		uint64_t histogram_min_val;
 		uint64_t histogram_max_val;
 
+		/** I/O merging window in microseconds, 0 if merging is disabled */
+		uint32_t merge_window_us;
+		/** Largest size of a merged I/O in bytes */
+		uint32_t merge_max_size;
+		/** True if the I/O merging settings are being modified */
+		bool	 merge_mod_in_progress;
+
 		/** Currently locked ranges for this bdev.  Used to populate new channels. */
 		lba_range_tailq_t locked_ranges;
 
@@ -824,6 +831,11 @@ struct spdk_bdev {
 		 */
 		lba_range_tailq_t pending_locked_ranges;
 
+		/** Number of channels of this bdev.  Used to lock ranges without visiting
+		 *  every channel when possible.
+		 */
+		uint32_t num_channels;
+
 		/** Bdev name used for quick lookup */
 		struct spdk_bdev_name bdev_name;
 	} internal;
@@ -1012,7 +1024,7 @@ struct spdk_bdev_io_internal_fields {
 			/** Whether we are currently inside the submit request call */
 			uint8_t in_submit_request		: 1;
 
-			/** Whether the I/O is a sub-I/O of a split parent I/O */
+			/** Whether the I/O is a sub-I/O of a split parent I/O or a merged I/O */
 			uint8_t child_io		: 1;
 
 			/**
@@ -1030,7 +1042,13 @@ struct spdk_bdev_io_internal_fields {
 	/** Retry state (resubmit, re-pull, re-push, etc.) */
 	uint8_t retry_state;
 
-	uint8_t	reserved[5];
+	/** Priority class, defined by \ref spdk_bdev_io_priority */
+	uint8_t priority;
+
+	/** Number of higher priority I/Os queued ahead of this one while it was waiting */
+	uint8_t priority_passed;
+
+	uint8_t	reserved[3];
 
 	/** The bdev descriptor that was used when submitting this I/O. */
 	struct spdk_bdev_desc *desc;
@@ -1810,6 +1828,150 @@ struct spdk_bdev *spdk_bdev_part_get_base_bdev(struct spdk_bdev_part *part);
  */
 uint64_t spdk_bdev_part_get_offset_blocks(struct spdk_bdev_part *part);
 
+/**
+ * Block map of a virtual bdev, kept in memory and persisted in a range of blocks of its
+ * base bdev.
+ *
+ * A map is used by a single thread, the one that created it. Modules update entries in the
+ * buffer returned by spdk_bdev_map_get_buf() and mark the map blocks holding them as
+ * modified with spdk_bdev_map_update(). Only one write per map block is in flight at a
+ * time, updates made while it is outstanding are written by the next one.
+ */
+struct spdk_bdev_map;
+
+/**
+ * Completion callback of map operations.
+ *
+ * \param cb_arg Callback argument.
+ * \param rc 0 on success, negative errno otherwise.
+ */
+typedef void (*spdk_bdev_map_cb)(void *cb_arg, int rc);
+
+/**
+ * Context of a map operation, embedded by modules in their per-I/O context. The fields are
+ * private to the map.
+ */
+struct spdk_bdev_map_ctx {
+	spdk_bdev_map_cb		cb_fn;
+	void				*cb_arg;
+	struct spdk_bdev_map		*map;
+	uint64_t			first;
+	uint64_t			last;
+	uint64_t			seq;
+	enum spdk_bdev_io_type		io_type;
+	struct spdk_bdev_io_wait_entry	bdev_io_wait;
+	TAILQ_ENTRY(spdk_bdev_map_ctx)	link;
+};
+
+/**
+ * Create a zeroed map persisted in blocks of a base bdev.
+ *
+ * \param desc Descriptor of the base bdev, opened for writing.
+ * \param ch I/O channel of the base bdev on the calling thread.
+ * \param offset_blocks First block of the map on the base bdev.
+ * \param num_blocks Number of blocks of the map.
+ *
+ * \return the map, or NULL if it could not be allocated.
+ */
+struct spdk_bdev_map *spdk_bdev_map_create(struct spdk_bdev_desc *desc,
+		struct spdk_io_channel *ch,
+		uint64_t offset_blocks, uint64_t num_blocks);
+
+/**
+ * Free a map. No operation may be outstanding on it.
+ *
+ * \param map Map to free, may be NULL.
+ */
+void spdk_bdev_map_free(struct spdk_bdev_map *map);
+
+/**
+ * Get the in-memory copy of the map. It is DMA-able and num_blocks blocks of the base bdev
+ * long, block i of the buffer is persisted to block offset_blocks + i of the base bdev.
+ *
+ * \param map Map.
+ *
+ * \return the map buffer.
+ */
+void *spdk_bdev_map_get_buf(struct spdk_bdev_map *map);
+
+/**
+ * Mark a block of the map as modified.
+ *
+ * \param map Map.
+ * \param map_block Index of the modified block within the map.
+ */
+void spdk_bdev_map_update(struct spdk_bdev_map *map, uint64_t map_block);
+
+/**
+ * Persist a range of map blocks. cb_fn is called once all the modifications of the range
+ * made so far are on disk, immediately if they already are, or with an error if a write
+ * of one of the blocks fails.
+ *
+ * \param map Map.
+ * \param ctx Context of the operation, owned by the map until cb_fn is called.
+ * \param first First map block of the range.
+ * \param last Last map block of the range.
+ * \param cb_fn Completion callback.
+ * \param cb_arg Argument passed to cb_fn.
+ */
+void spdk_bdev_map_persist(struct spdk_bdev_map *map, struct spdk_bdev_map_ctx *ctx,
+			   uint64_t first, uint64_t last, spdk_bdev_map_cb cb_fn, void *cb_arg);
+
+/**
+ * Write the whole map to the base bdev, typically to format a new map.
+ *
+ * \param map Map.
+ * \param cb_fn Completion callback.
+ * \param cb_arg Argument passed to cb_fn.
+ */
+void spdk_bdev_map_write(struct spdk_bdev_map *map, spdk_bdev_map_cb cb_fn, void *cb_arg);
+
+/**
+ * Read the whole map from the base bdev.
+ *
+ * \param map Map.
+ * \param cb_fn Completion callback.
+ * \param cb_arg Argument passed to cb_fn.
+ */
+void spdk_bdev_map_read(struct spdk_bdev_map *map, spdk_bdev_map_cb cb_fn, void *cb_arg);
+
+/**
+ * Forward a flush or reset to the whole base bdev of a map. A flush completes immediately
+ * if the base bdev doesn't support it.
+ *
+ * \param map Map.
+ * \param ctx Context of the operation, owned by the map until cb_fn is called.
+ * \param type SPDK_BDEV_IO_TYPE_FLUSH or SPDK_BDEV_IO_TYPE_RESET.
+ * \param cb_fn Completion callback.
+ * \param cb_arg Argument passed to cb_fn.
+ */
+void spdk_bdev_map_submit_base_io(struct spdk_bdev_map *map, struct spdk_bdev_map_ctx *ctx,
+				  enum spdk_bdev_io_type type, spdk_bdev_map_cb cb_fn,
+				  void *cb_arg);
+
+/**
+ * Callback of spdk_bdev_map_examine().
+ *
+ * \param cb_arg Callback argument.
+ * \param bdev Examined bdev.
+ * \param block Content of its first block, valid only during the callback.
+ * \param rc 0 on success, negative errno otherwise.
+ */
+typedef void (*spdk_bdev_map_examine_cb)(void *cb_arg, struct spdk_bdev *bdev,
+		const void *block, int rc);
+
+/**
+ * Read the first block of a bdev being examined, where modules using a map keep the
+ * superblock describing it.
+ *
+ * \param bdev Bdev being examined.
+ * \param cb_fn Called with the content of the block, unless an error is returned.
+ * \param cb_arg Argument passed to cb_fn.
+ *
+ * \return 0 on success, negative errno otherwise.
+ */
+int spdk_bdev_map_examine(struct spdk_bdev *bdev, spdk_bdev_map_examine_cb cb_fn, void *cb_arg);
+
 /**
  * Push media management events.  To send the notification that new events are
  * available, spdk_bdev_notify_media_management needs to be called.
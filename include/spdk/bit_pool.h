@@ -126,6 +126,31 @@ int spdk_bit_pool_set_bit_allocated(struct spdk_bit_pool *pool, uint32_t bit_ind
  */
 void spdk_bit_pool_free_bit(struct spdk_bit_pool *pool, uint32_t bit_index);
 
+/**
+ * Allocate a run of contiguous bits from the bit pool.
+ *
+ * The lowest-indexed run of num_bits free bits is allocated.
+ *
+ * \param pool Bit pool to allocate the bits from.
+ * \param num_bits Number of contiguous bits to allocate.
+ *
+ * \return index of the first allocated bit, UINT32_MAX if num_bits is 0 or no run of
+ * num_bits free bits exists.
+ */
+uint32_t spdk_bit_pool_allocate_run(struct spdk_bit_pool *pool, uint32_t num_bits);
+
+/**
+ * Free a run of contiguous bits back to the bit pool.
+ *
+ * The same rules apply as for spdk_bit_pool_free_bit(): all bits within the run must
+ * have been allocated.
+ *
+ * \param pool Bit pool to place the freed bits.
+ * \param bit_index The index of the first bit to free.
+ * \param num_bits Number of contiguous bits to free.
+ */
+void spdk_bit_pool_free_run(struct spdk_bit_pool *pool, uint32_t bit_index, uint32_t num_bits);
+
 /**
  * Count the number of bits allocated from the pool.
  *
@@ -158,6 +158,37 @@ typedef int (*spdk_bs_esnap_dev_create)(void *bs_ctx, void *blob_ctx, struct spd
  */
 typedef void (*spdk_blob_shallow_copy_status)(uint64_t copied_clusters, void *cb_arg);
 
+/**
+ * Blob inflate status callback.
+ *
+ * \param copied_clusters Number of clusters copied so far, including the ones copied by earlier
+ * runs of the operation that were stopped.
+ * \param total_clusters Number of clusters the operation copies in total.
+ * \param cb_arg Callback argument.
+ */
+typedef void (*spdk_blob_inflate_status)(uint64_t copied_clusters, uint64_t total_clusters,
+		void *cb_arg);
+
+/**
+ * Blob diff extent callback.
+ *
+ * \param start_cluster First cluster of a range of clusters that differ.
+ * \param num_clusters Number of clusters in the range.
+ * \param cb_arg Callback argument.
+ */
+typedef void (*spdk_blob_diff_extent_cb)(uint64_t start_cluster, uint64_t num_clusters,
+		void *cb_arg);
+
+/**
+ * Blob diff copy status callback.
+ *
+ * \param copied_clusters Number of clusters copied so far.
+ * \param total_clusters Number of clusters that differ and are copied in total.
+ * \param cb_arg Callback argument.
+ */
+typedef void (*spdk_blob_diff_copy_status)(uint64_t copied_clusters, uint64_t total_clusters,
+		void *cb_arg);
+
 struct spdk_bs_dev_cb_args {
 	spdk_bs_dev_cpl		cb_fn;
 	struct spdk_io_channel	*channel;
@@ -315,8 +346,18 @@ struct spdk_bs_opts {
 	 * Context to pass with esnap_bs_dev_create.
 	 */
 	void *esnap_ctx;
+
+	/**
+	 * Number of free clusters each io channel claims in advance for allocations of
+	 * thin provisioned blobs, so that they don't contend on the blobstore's cluster map.
+	 * Pooled clusters still count as free and are taken back from the pools when an
+	 * allocation finds no other free cluster. Clusters left in the pools are returned when
+	 * the channels are destroyed.
+	 * 0 disables the pools.
+	 */
+	uint32_t channel_cluster_pool_size;
 } __attribute__((packed));
-SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_opts) == 88, "Incorrect size");
+SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_opts) == 92, "Incorrect size");
 
 /**
  * Initialize a spdk_bs_opts structure to the default blobstore option values.
@@ -804,6 +845,80 @@ void spdk_bs_inflate_blob(struct spdk_blob_store *bs, struct spdk_io_channel *ch
 void spdk_bs_blob_decouple_parent(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
 				  spdk_blob_id blobid, spdk_blob_op_complete cb_fn, void *cb_arg);
 
+struct spdk_bs_inflate_opts {
+	/**
+	 * The size of spdk_bs_inflate_opts according to the caller of this library is used for ABI
+	 * compatibility. The library uses this field to know how many fields in this
+	 * structure are valid. And the library will populate any remaining fields with default values.
+	 * New added fields should be put at the end of the struct.
+	 */
+	size_t opts_size;
+
+	/**
+	 * Only decouple the blob from its parent, as spdk_bs_blob_decouple_parent() does, instead
+	 * of allocating all of its clusters.
+	 */
+	bool decouple_parent;
+
+	/** Number of clusters copied concurrently. Default is 1. */
+	uint32_t clusters_in_flight;
+
+	/** Maximum bandwidth of cluster copies in MiB/s, 0 for no limit. */
+	uint32_t max_bandwidth_mb_sec;
+
+	/** Maximum number of clusters copied per second, 0 for no limit. */
+	uint32_t max_clusters_per_sec;
+
+	/** Called on the metadata thread each time a cluster is copied. */
+	spdk_blob_inflate_status status_cb_fn;
+
+	/** Argument passed to status_cb_fn. */
+	void *status_cb_arg;
+};
+SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_inflate_opts) == 40, "Incorrect size");
+
+/**
+ * Initialize a spdk_bs_inflate_opts structure to the default option values.
+ *
+ * \param opts spdk_bs_inflate_opts structure to initialize.
+ * \param opts_size It must be the size of spdk_bs_inflate_opts structure.
+ */
+void spdk_bs_inflate_opts_init(struct spdk_bs_inflate_opts *opts, size_t opts_size);
+
+/**
+ * Inflate a blob or decouple it from its parent in the background.
+ *
+ * This is the same operation as spdk_bs_inflate_blob() or spdk_bs_blob_decouple_parent(), but
+ * it copies several clusters at a time, optionally limited to a given rate so that it does not
+ * compete with the I/O of the blobstore users. Progress is checkpointed in the blob metadata.
+ * If the operation is stopped with spdk_bs_inflate_blob_stop() or interrupted by a shutdown,
+ * calling this function again resumes it and keeps reporting progress against the original
+ * number of clusters.
+ *
+ * \param bs blobstore.
+ * \param channel IO channel used to copy the clusters.
+ * \param blobid The id of the blob.
+ * \param opts Inflate options. Can be NULL to use the defaults.
+ * \param cb_fn Called when the operation is complete, with -ECANCELED if it was stopped.
+ * \param cb_arg Argument passed to function cb_fn.
+ */
+void spdk_bs_inflate_blob_ext(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+			      spdk_blob_id blobid, const struct spdk_bs_inflate_opts *opts,
+			      spdk_blob_op_complete cb_fn, void *cb_arg);
+
+/**
+ * Stop an inflate started with spdk_bs_inflate_blob_ext().
+ *
+ * The clusters being copied are completed and the progress is persisted before the operation
+ * completes with -ECANCELED. Must be called on the metadata thread.
+ *
+ * \param bs blobstore.
+ * \param blobid The id of the blob being inflated.
+ *
+ * \return 0 on success, -ENOENT if the blob is not being inflated.
+ */
+int spdk_bs_inflate_blob_stop(struct spdk_blob_store *bs, spdk_blob_id blobid);
+
 /**
  * Perform a shallow copy of a blob to a blobstore device.
  *
@@ -828,6 +943,57 @@ int spdk_bs_blob_shallow_copy(struct spdk_blob_store *bs, struct spdk_io_channel
 			      spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
 			      spdk_blob_op_complete cb_fn, void *cb_arg);
 
+/**
+ * Get the clusters of a blob that differ from an older snapshot in its chain.
+ *
+ * A cluster differs if it is allocated to the blob or to any snapshot between the blob and
+ * base_id, excluding base_id itself. The content of such a cluster may still be the same, but
+ * every cluster that is not reported reads the same from both. With base_id set to
+ * SPDK_BLOBID_INVALID every cluster allocated in the whole chain is reported, and every
+ * cluster of the blob if the chain ends with an external snapshot.
+ *
+ * extent_cb_fn is called for each range of differing clusters, in increasing order, right
+ * before cb_fn is called with 0.
+ *
+ * \param bs Blobstore
+ * \param blobid The id of the blob, usually the newer snapshot.
+ * \param base_id The id of the older snapshot, an ancestor of the blob, or SPDK_BLOBID_INVALID.
+ * \param extent_cb_fn Called for each range of clusters that differ.
+ * \param extent_cb_arg Argument passed to function extent_cb_fn.
+ * \param cb_fn Called when the operation is complete. It is -EINVAL if base_id is not an
+ * ancestor of the blob.
+ * \param cb_arg Argument passed to function cb_fn.
+ */
+void spdk_bs_blob_get_diff(struct spdk_blob_store *bs, spdk_blob_id blobid, spdk_blob_id base_id,
+			   spdk_blob_diff_extent_cb extent_cb_fn, void *extent_cb_arg,
+			   spdk_blob_op_complete cb_fn, void *cb_arg);
+
+/**
+ * Copy the clusters of a blob that differ from an older snapshot to a blobstore device.
+ *
+ * Clusters reported by spdk_bs_blob_get_diff() are read through the blob, so they hold the
+ * data of the blob whichever snapshot of the chain they are allocated to, and written at the
+ * same offset of the device. Applied to a device that holds a copy of base_id, it makes it a
+ * copy of the blob. Blob must be read only and blob size must be less or equal than device
+ * size. Blobstore block size must be a multiple of device block size.
+ *
+ * \param bs Blobstore
+ * \param channel IO channel used to copy the blob.
+ * \param blobid The id of the blob.
+ * \param base_id The id of the older snapshot, an ancestor of the blob, or SPDK_BLOBID_INVALID.
+ * \param ext_dev The device to copy on
+ * \param status_cb_fn Called repeatedly during operation with status updates
+ * \param status_cb_arg Argument passed to function status_cb_fn.
+ * \param cb_fn Called when the operation is complete.
+ * \param cb_arg Argument passed to function cb_fn.
+ *
+ * \return 0 if operation starts correctly, negative errno on failure.
+ */
+int spdk_bs_blob_diff_copy(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+			   spdk_blob_id blobid, spdk_blob_id base_id, struct spdk_bs_dev *ext_dev,
+			   spdk_blob_diff_copy_status status_cb_fn, void *status_cb_arg,
+			   spdk_blob_op_complete cb_fn, void *cb_arg);
+
 
 /**
  * Set a snapshot as the parent of a blob
@@ -60,6 +60,25 @@ uint32_t spdk_crc32c_iov_update(struct iovec *iov, int iovcnt, uint32_t crc32c);
  */
 uint32_t spdk_crc32c_nvme(const void *buf, size_t len, uint32_t crc);
 
+/**
+ * Calculate CRC-32C checksums of multiple equally sized buffers, for NVMe Protection
+ * Information
+ *
+ * The buffers are located at a fixed distance from each other, e.g. the data of consecutive
+ * logical blocks with interleaved metadata. Where supported by the CPU, checksums of
+ * independent buffers are computed concurrently, which is faster than calling
+ * spdk_crc32c_nvme() for each of them.
+ *
+ * \param buf First data buffer to checksum.
+ * \param len Length of each buffer in bytes.
+ * \param stride Distance in bytes between the start of consecutive buffers.
+ * \param count Number of buffers.
+ * \param crc Previous CRC-32C value, used for each buffer.
+ * \param crcs Array of count elements receiving the CRC-32C values.
+ */
+void spdk_crc32c_nvme_multi(const void *buf, size_t len, size_t stride, uint32_t count,
+			    uint32_t crc, uint32_t *crcs);
+
 #ifdef __cplusplus
 }
 #endif
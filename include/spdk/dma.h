@@ -32,6 +32,8 @@ enum spdk_dma_device_type {
 	SPDK_DMA_DEVICE_TYPE_DMA,
 	/** Virtual memory domain representing memory being transformed by accel framework */
 	SPDK_DMA_DEVICE_TYPE_ACCEL,
+	/** Memory of in-flight ublk requests, only reachable through the ublk character device. */
+	SPDK_DMA_DEVICE_TYPE_UBLK,
 	/**
 	 * Start of the range of vendor-specific DMA device types
 	 */
@@ -123,6 +125,14 @@ struct spdk_memory_domain_translation_result {
 			uint32_t lkey;
 			uint32_t rkey;
 		} rdma;
+		struct {
+			/* ublk character device the request belongs to */
+			int fd;
+			uint16_t q_id;
+			uint16_t tag;
+			/* Offset of the translated buffer within the request data */
+			uint64_t offset;
+		} ublk;
 	};
 };
 
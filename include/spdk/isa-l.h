@@ -26,11 +26,13 @@ extern "C" {
 #include <isa-l/crc64.h>
 #include <isa-l/igzip_lib.h>
 #include <isa-l/raid.h>
+#include <isa-l/erasure_code.h>
 #else
 #include "../isa-l/include/crc.h"
 #include "../isa-l/include/crc64.h"
 #include "../isa-l/include/igzip_lib.h"
 #include "../isa-l/include/raid.h"
+#include "../isa-l/include/erasure_code.h"
 #endif
 
 #ifdef __cplusplus
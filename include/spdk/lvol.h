@@ -386,6 +386,27 @@ void spdk_lvol_inflate(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void
  */
 void spdk_lvol_decouple_parent(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void *cb_arg);
 
+/**
+ * Inflate lvol or decouple its parent in the background, see spdk_bs_inflate_blob_ext().
+ *
+ * \param lvol Handle to lvol
+ * \param opts Inflate options, NULL for the defaults
+ * \param cb_fn Completion callback, called with -ECANCELED if the inflate was stopped
+ * \param cb_arg Completion callback custom arguments
+ */
+void spdk_lvol_inflate_ext(struct spdk_lvol *lvol, const struct spdk_bs_inflate_opts *opts,
+			   spdk_lvol_op_complete cb_fn, void *cb_arg);
+
+/**
+ * Stop an inflate started with spdk_lvol_inflate_ext(). Its progress is kept, so that starting
+ * it again resumes the copy.
+ *
+ * \param lvol Handle to lvol
+ *
+ * \return 0 on success, -ENOENT if the lvol is not being inflated.
+ */
+int spdk_lvol_inflate_stop(struct spdk_lvol *lvol);
+
 /**
  * Determine if an lvol is degraded. A degraded lvol cannot perform IO.
  *
@@ -413,6 +434,43 @@ int spdk_lvol_shallow_copy(struct spdk_lvol *lvol, struct spdk_bs_dev *ext_dev,
 			   spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
 			   spdk_lvol_op_complete cb_fn, void *cb_arg);
 
+/**
+ * Get the clusters of an lvol that differ from an older snapshot in its chain.
+ *
+ * See spdk_bs_blob_get_diff() for which clusters are reported.
+ *
+ * \param lvol Handle to lvol, usually the newer snapshot.
+ * \param base Handle to the older snapshot, or NULL to report every cluster of the chain.
+ * \param extent_cb_fn Called for each range of clusters that differ.
+ * \param extent_cb_arg Argument passed to function extent_cb_fn.
+ * \param cb_fn Completion callback
+ * \param cb_arg Completion callback custom arguments
+ */
+void spdk_lvol_get_diff(struct spdk_lvol *lvol, struct spdk_lvol *base,
+			spdk_blob_diff_extent_cb extent_cb_fn, void *extent_cb_arg,
+			spdk_lvol_op_complete cb_fn, void *cb_arg);
+
+/**
+ * Copy the clusters of an lvol that differ from an older snapshot on given bs_dev.
+ *
+ * Lvol must be read only and lvol size must be less or equal than bs_dev size. Applied to a
+ * bs_dev that holds a copy of base, it makes it a copy of lvol.
+ *
+ * \param lvol Handle to lvol
+ * \param base Handle to the older snapshot, or NULL to copy every cluster of the chain.
+ * \param ext_dev The bs_dev to copy on. This is created on the given bdev by using
+ * spdk_bdev_create_bs_dev_ext() beforehand
+ * \param status_cb_fn Called repeatedly during operation with status updates
+ * \param status_cb_arg Argument passed to function status_cb_fn.
+ * \param cb_fn Completion callback
+ * \param cb_arg Completion callback custom arguments
+ *
+ * \return 0 if operation starts correctly, negative errno on failure.
+ */
+int spdk_lvol_diff_copy(struct spdk_lvol *lvol, struct spdk_lvol *base, struct spdk_bs_dev *ext_dev,
+			spdk_blob_diff_copy_status status_cb_fn, void *status_cb_arg,
+			spdk_lvol_op_complete cb_fn, void *cb_arg);
+
 /**
  * Set a snapshot as the parent of a lvol
  *
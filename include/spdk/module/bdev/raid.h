@@ -17,6 +17,7 @@ enum spdk_bdev_raid_level {
 	SPDK_BDEV_RAID_LEVEL_INVALID	= -1,
 	SPDK_BDEV_RAID_LEVEL_RAID0	= 0,
 	SPDK_BDEV_RAID_LEVEL_RAID1	= 1,
+	SPDK_BDEV_RAID_LEVEL_RAID6	= 6,
 	SPDK_BDEV_RAID_LEVEL_RAID5F	= 95, /* 0x5f */
 	SPDK_BDEV_RAID_LEVEL_CONCAT	= 99,
 };
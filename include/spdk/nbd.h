@@ -52,6 +52,27 @@ typedef void (*spdk_nbd_start_cb)(void *cb_arg, struct spdk_nbd_disk *nbd,
 void spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 		    spdk_nbd_start_cb cb_fn, void *cb_arg);
 
+/**
+ * Maximum number of connections of a network block device.
+ */
+#define SPDK_NBD_MAX_CONNECTIONS 16
+
+/**
+ * Start a network block device backed by the bdev, served over several connections.
+ *
+ * Each connection is a socket pair handed to the kernel and polled by its own
+ * SPDK thread, so that I/O to the device is spread across reactors. The kernel
+ * distributes requests among the connections.
+ *
+ * \param bdev_name Name of bdev exposed as a network block device.
+ * \param nbd_path Path to the registered network block device.
+ * \param num_connections Number of connections, 1 to SPDK_NBD_MAX_CONNECTIONS.
+ * \param cb_fn Callback to be always called.
+ * \param cb_arg Passed to cb_fn.
+ */
+void spdk_nbd_start_ext(const char *bdev_name, const char *nbd_path, uint32_t num_connections,
+			spdk_nbd_start_cb cb_fn, void *cb_arg);
+
 /**
  * Stop the running network block device safely.
  *
@@ -0,0 +1,69 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+/**
+ * \file
+ * P+Q (RAID6-class) erasure coding utility functions
+ *
+ * P is the XOR of all data buffers and Q is the Reed-Solomon syndrome computed over
+ * GF(2^8) with the generator polynomial 0x11d and generator g = 2, i.e.
+ * Q = g^0 * D_0 + g^1 * D_1 + ... + g^(n-1) * D_(n-1). This is the same coding
+ * used by ISA-L's pq_gen() and the Linux md RAID6 driver.
+ */
+
+#ifndef SPDK_PQ_H
+#define SPDK_PQ_H
+
+#include "spdk/stdinc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of data buffers supported by the P+Q functions */
+#define SPDK_PQ_MAX_DATA	253
+
+/** Maximum number of buffers that can be recovered at once */
+#define SPDK_PQ_MAX_FAILED	2
+
+/**
+ * Generate P and Q parity from multiple data buffers.
+ *
+ * \param buffers Array of n + 2 buffers. The first n entries are the data buffers,
+ * followed by the P and the Q destination buffers.
+ * \param n Number of data buffers, from 2 to SPDK_PQ_MAX_DATA.
+ * \param len Length of each buffer in bytes.
+ * \return 0 on success, negative error code otherwise.
+ */
+int spdk_pq_gen(void **buffers, uint32_t n, uint32_t len);
+
+/**
+ * Recover up to two lost buffers of a P+Q protected set.
+ *
+ * The contents of the failed buffers are ignored and overwritten with the recovered
+ * data. Any combination of data, P and Q buffers may be recovered.
+ *
+ * \param buffers Array of n + 2 buffers laid out as for spdk_pq_gen().
+ * \param n Number of data buffers, from 2 to SPDK_PQ_MAX_DATA.
+ * \param len Length of each buffer in bytes.
+ * \param failed Array of indices (into \b buffers) of the buffers to recover.
+ * \param nfailed Number of entries in \b failed, 1 or SPDK_PQ_MAX_FAILED.
+ * \return 0 on success, negative error code otherwise.
+ */
+int spdk_pq_recover(void **buffers, uint32_t n, uint32_t len, const uint32_t *failed,
+		    uint32_t nfailed);
+
+/**
+ * Get the optimal buffer alignment for P+Q functions.
+ *
+ * \return The alignment in bytes.
+ */
+size_t spdk_pq_get_optimal_alignment(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPDK_PQ_H */
@@ -275,6 +275,39 @@ void spdk_scheduler_set_period(uint64_t period);
  */
 uint64_t spdk_scheduler_get_period(void);
 
+/**
+ * Enable or disable work stealing between reactors.
+ *
+ * With work stealing enabled, a reactor that was idle over the last work stealing
+ * period takes a thread from the busiest reactor right away, instead of waiting for
+ * the scheduler to rebalance threads in its next period. Bound threads, the app thread
+ * and threads that moved recently are never stolen.
+ *
+ * \param enable True to enable, false to disable.
+ */
+void spdk_scheduler_enable_work_stealing(bool enable);
+
+/**
+ * Check whether work stealing between reactors is enabled.
+ *
+ * \return true if enabled, false otherwise.
+ */
+bool spdk_scheduler_work_stealing_enabled(void);
+
+/**
+ * Change the period over which reactors measure their load for work stealing.
+ *
+ * \param period Period to set in microseconds.
+ */
+void spdk_scheduler_set_work_stealing_period(uint64_t period);
+
+/**
+ * Get the work stealing period.
+ *
+ * \return Work stealing period in microseconds.
+ */
+uint64_t spdk_scheduler_get_work_stealing_period(void);
+
 /**
  * Add the given scheduler to the list of registered schedulers.
  * This function should be invoked by referencing the macro
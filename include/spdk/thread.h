@@ -215,6 +215,29 @@ int spdk_thread_lib_init_ext(spdk_thread_op_fn thread_op_fn,
  */
 void spdk_thread_lib_fini(void);
 
+/**
+ * Enable or disable batching of messages sent between threads.
+ *
+ * When enabled, messages sent by a thread to other threads while it is being
+ * polled by spdk_thread_poll() are held in a small outbox and moved to the
+ * target threads' message rings at the latest when the poll completes,
+ * consecutive messages to the same thread in bulk. This reduces contention on
+ * the rings of threads receiving messages from many other threads. Messages
+ * are moved to the rings in the order they were sent, so the ordering between
+ * messages is the same as without batching, and a thread does not finish
+ * exiting while messages for it are held. Disabled by default.
+ *
+ * \param enable True to enable message batching, false to disable it.
+ */
+void spdk_thread_lib_set_msg_batching(bool enable);
+
+/**
+ * Check whether batching of messages sent between threads is enabled.
+ *
+ * \return True if message batching is enabled, false otherwise.
+ */
+bool spdk_thread_lib_get_msg_batching(void);
+
 /**
  * Creates a new SPDK thread object.
  *
@@ -475,6 +498,10 @@ struct spdk_thread *spdk_thread_get_by_id(uint64_t id);
 struct spdk_thread_stats {
 	uint64_t busy_tsc;
 	uint64_t idle_tsc;
+	/* Number of messages executed by the thread */
+	uint64_t msgs_executed;
+	/* Number of messages sent by the thread, including to itself */
+	uint64_t msgs_sent;
 };
 
 /**
@@ -798,6 +825,50 @@ struct spdk_thread *spdk_io_channel_get_thread(struct spdk_io_channel *ch);
 void spdk_for_each_channel(void *io_device, spdk_channel_msg fn, void *ctx,
 			   spdk_channel_for_each_cpl cpl);
 
+/**
+ * Call 'fn' on each channel associated with io_device, on all threads at once.
+ *
+ * This is a variant of spdk_for_each_channel() meant for operations that must
+ * reach many threads quickly. Instead of visiting the threads one after another,
+ * a message is sent to every thread holding a channel up front, so 'fn' may run
+ * concurrently on different threads and in any order. Each call to 'fn' must
+ * call spdk_for_each_channel_continue() with the iterator it was given. 'cpl'
+ * is called once all of them have done so.
+ *
+ * A non-zero status passed to spdk_for_each_channel_continue() does not stop
+ * the other channels, since they have already been messaged. The first non-zero
+ * status is passed to 'cpl'.
+ *
+ * \param io_device 'fn' will be called on each channel associated with this io_device.
+ * \param fn Called on the appropriate thread for each channel associated with io_device.
+ * \param ctx Context buffer registered to spdk_io_channel_iter that can be obtained
+ * form the function spdk_io_channel_iter_get_ctx(). It is shared by all channels.
+ * \param cpl Called on the thread that spdk_for_each_channel_parallel was initially
+ * called from when 'fn' has been called on each channel. Optional - may be NULL.
+ */
+void spdk_for_each_channel_parallel(void *io_device, spdk_channel_msg fn, void *ctx,
+				    spdk_channel_for_each_cpl cpl);
+
+/**
+ * Call 'fn' on each channel associated with io_device, on all threads at once,
+ * giving each channel a context of its own.
+ *
+ * Same as spdk_for_each_channel_parallel(), except that a zeroed buffer of
+ * channel_ctx_size bytes is allocated along with the iterator of each channel and
+ * can be obtained from spdk_io_channel_iter_get_channel_ctx(). It stays valid until
+ * 'cpl' returns, so 'fn' can keep per-channel state there without allocating.
+ *
+ * \param io_device 'fn' will be called on each channel associated with this io_device.
+ * \param fn Called on the appropriate thread for each channel associated with io_device.
+ * \param ctx Context buffer registered to spdk_io_channel_iter that can be obtained
+ * form the function spdk_io_channel_iter_get_ctx(). It is shared by all channels.
+ * \param channel_ctx_size Size of the context of each channel.
+ * \param cpl Called on the thread that spdk_for_each_channel_parallel_ext was initially
+ * called from when 'fn' has been called on each channel. Optional - may be NULL.
+ */
+void spdk_for_each_channel_parallel_ext(void *io_device, spdk_channel_msg fn, void *ctx,
+					size_t channel_ctx_size, spdk_channel_for_each_cpl cpl);
+
 /**
  * Get io_device from the I/O channel iterator.
  *
@@ -825,6 +896,16 @@ struct spdk_io_channel *spdk_io_channel_iter_get_channel(struct spdk_io_channel_
  */
 void *spdk_io_channel_iter_get_ctx(struct spdk_io_channel_iter *i);
 
+/**
+ * Get the context of the channel from the I/O channel iterator.
+ *
+ * \param i I/O channel iterator.
+ *
+ * \return a pointer to the context of the channel, given to the iterations started by
+ * spdk_for_each_channel_parallel_ext(), or NULL for other iterations.
+ */
+void *spdk_io_channel_iter_get_channel_ctx(struct spdk_io_channel_iter *i);
+
 /**
  * Get the io_device for the specified I/O channel.
  *
@@ -839,7 +920,8 @@ void *spdk_io_channel_get_io_device(struct spdk_io_channel *ch);
  *
  * \param i I/O channel iterator.
  * \param status Status for the I/O channel iterator;
- * for non 0 status remaining iterations are terminated.
+ * for non 0 status remaining iterations are terminated, except for iterations
+ * started by spdk_for_each_channel_parallel().
  */
 void spdk_for_each_channel_continue(struct spdk_io_channel_iter *i, int status);
 
@@ -607,6 +607,70 @@ uint64_t spdk_trace_create_tpoint_group_mask(const char *group_name);
  */
 uint64_t spdk_trace_create_tpoint_mask(uint32_t group_id, const char *tpoint_name);
 
+/**
+ * Set the rate at which events of a tracepoint group are recorded into the trace history.
+ *
+ * Sampling is done per object, so either all or none of the events of an object are
+ * recorded and start/completion pairs stay intact. Events without an object are sampled
+ * per core. Tracepoint counts and latency histograms still account for every event.
+ *
+ * \param group_id Tracepoint group id.
+ * \param rate Record 1 of every rate events. 1 records all events and 0 records none,
+ * e.g. when only the latency histograms are needed.
+ * \return 0 on success, -EINVAL if trace is not initialized or group_id is invalid.
+ */
+int spdk_trace_set_tpoint_group_sample_rate(uint32_t group_id, uint32_t rate);
+
+/**
+ * Get the rate at which events of a tracepoint group are recorded.
+ *
+ * \param group_id Tracepoint group id.
+ * \return sample rate of the group.
+ */
+uint32_t spdk_trace_get_tpoint_group_sample_rate(uint32_t group_id);
+
+/**
+ * Enable or disable latency histograms.
+ *
+ * While enabled, each event of an enabled tracepoint that belongs to an object is tallied
+ * into a per-tracepoint histogram of the time elapsed since the tracepoint that created
+ * the object. Enabling the histograms resets them.
+ *
+ * \param enable True to enable, false to disable.
+ */
+void spdk_trace_enable_latency_histograms(bool enable);
+
+/**
+ * Check whether latency histograms are enabled.
+ *
+ * \return true if enabled, false otherwise.
+ */
+bool spdk_trace_latency_histograms_enabled(void);
+
+struct spdk_histogram_data;
+
+/**
+ * Function called for each latency histogram.
+ *
+ * \param ctx Context passed to spdk_trace_get_latency_histograms().
+ * \param tpoint_id Tracepoint id.
+ * \param histogram Histogram of TSC deltas, only valid for the duration of the call.
+ */
+typedef void (*spdk_trace_latency_histogram_fn)(void *ctx, uint16_t tpoint_id,
+		const struct spdk_histogram_data *histogram);
+
+/**
+ * Get the latency histograms merged over all cores.
+ *
+ * The histograms are read while cores keep updating them, so they might miss datapoints
+ * added concurrently.
+ *
+ * \param fn Function called for each tracepoint that has accounted any latency.
+ * \param ctx Context passed to fn.
+ * \return 0 on success, -ENOMEM if memory could not be allocated.
+ */
+int spdk_trace_get_latency_histograms(spdk_trace_latency_histogram_fn fn, void *ctx);
+
 struct spdk_trace_register_fn {
 	const char *name;
 	uint8_t tgroup_id;
@@ -40,7 +40,8 @@ struct spdk_trace_parser_opts {
 /**
  * Initialize the parser using a specified trace file.  This results in parsing the traces, merging
  * entries from multiple cores together and sorting them by their tsc, so it can take a significant
- * amount of time to complete.
+ * amount of time to complete.  Indexed trace files (see spdk_trace_parser_save_index()) are merged
+ * on the fly instead.
  *
  * \param opts Describes the trace file to parse.
  *
@@ -126,6 +127,56 @@ bool spdk_trace_parser_next_entry(struct spdk_trace_parser *parser,
  */
 uint64_t spdk_trace_parser_get_entry_count(const struct spdk_trace_parser *parser, uint16_t lcore);
 
+/**
+ * Save the traces in an indexed format.  The resulting file is still a valid trace file, but with
+ * the entries of each core sorted by their tsc and followed by an index of time ranges and object
+ * lifetimes.  Parsers initialized with such a file memory-map the index instead of parsing and
+ * merging all of the entries, which makes the seek functions below cheap.
+ *
+ * Only the entries selected by the parser's options are saved.
+ *
+ * \param parser Parser object to be used.  It must not have been initialized with an indexed file.
+ * \param filename Name of the file to create.
+ *
+ * \return 0 on success, negative errno otherwise.
+ */
+int spdk_trace_parser_save_index(struct spdk_trace_parser *parser, const char *filename);
+
+/**
+ * Check if the parser was initialized with an indexed trace file.
+ *
+ * \param parser Parser object to be used.
+ *
+ * \return True if the trace file is indexed, false otherwise.
+ */
+bool spdk_trace_parser_is_indexed(const struct spdk_trace_parser *parser);
+
+/**
+ * Restrict the entries returned by spdk_trace_parser_next_entry() to a time window and restart
+ * the iteration from the first entry within that window.  This also clears the object selected by
+ * spdk_trace_parser_seek_object().
+ *
+ * \param parser Parser object to be used.
+ * \param tsc_start The tsc of the beginning of the window.
+ * \param tsc_end The tsc of the end of the window (inclusive).
+ */
+void spdk_trace_parser_seek_time_range(struct spdk_trace_parser *parser, uint64_t tsc_start,
+				       uint64_t tsc_end);
+
+/**
+ * Restrict the entries returned by spdk_trace_parser_next_entry() to the lifetime of a single
+ * object, i.e. the entries of that object from the one that created it to the last one referring
+ * to it, and restart the iteration from its first entry.
+ *
+ * \param parser Parser object to be used.
+ * \param object_type Type of the object.
+ * \param object_index Index of the object, as reported in spdk_trace_parser_entry.object_index.
+ *
+ * \return 0 on success, -ENOENT if there's no such object, negative errno otherwise.
+ */
+int spdk_trace_parser_seek_object(struct spdk_trace_parser *parser, uint8_t object_type,
+				  uint64_t object_index);
+
 #ifdef __cplusplus
 }
 #endif
@@ -256,6 +256,20 @@ size_t spdk_ioviter_nextv(struct spdk_ioviter *iter, void **out);
 void
 spdk_iov_memset(struct iovec *iovs, int iovcnt, int c);
 
+/**
+ * Describe a byte range of an iovec with another iovec, without copying the data.
+ *
+ * \param iovs Source iovec.
+ * \param iovcnt Number of elements in iovs.
+ * \param offset Offset of the range within iovs, in bytes.
+ * \param len Length of the range, in bytes.
+ * \param out Destination iovec, with at least iovcnt elements.
+ *
+ * \return the number of elements of out describing the range.
+ */
+int spdk_iov_slice(struct iovec *iovs, int iovcnt, uint64_t offset, uint64_t len,
+		   struct iovec *out);
+
 /**
  * Initialize an iovec with just the single given buffer.
  */
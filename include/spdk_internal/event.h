@@ -78,6 +78,13 @@ struct spdk_reactor {
 	struct spdk_fd_group				*fgrp;
 	int						resched_fd;
 	uint16_t					trace_id;
+
+	/* Work stealing state, the load in percent is read by other reactors */
+	uint32_t					load;
+	uint64_t					steal_window_tsc;
+	uint64_t					steal_window_busy_tsc;
+	uint64_t					steal_window_idle_tsc;
+	uint64_t					last_steal_tsc;
 } __attribute__((aligned(SPDK_CACHE_LINE_SIZE)));
 
 int spdk_reactors_init(size_t msg_mempool_size);
@@ -80,7 +80,7 @@ static const char *g_opcode_strings[SPDK_ACCEL_OPC_LAST] = {
 	"copy", "fill", "dualcast", "compare", "crc32c", "copy_crc32c",
 	"compress", "decompress", "encrypt", "decrypt", "xor",
 	"dif_verify", "dif_verify_copy", "dif_generate", "dif_generate_copy",
-	"dix_generate", "dix_verify"
+	"dix_generate", "dix_verify", "pq_gen", "pq_recover"
 };
 
 enum accel_sequence_state {
@@ -881,6 +881,60 @@ spdk_accel_submit_xor(struct spdk_io_channel *ch, void *dst, void **sources, uin
 	return accel_submit_task(accel_ch, accel_task);
 }
 
+int
+spdk_accel_submit_pq_gen(struct spdk_io_channel *ch, void **buffers, uint32_t ndata,
+			 uint64_t nbytes, spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+
+	accel_task = _get_task(accel_ch, cb_fn, cb_arg);
+	if (spdk_unlikely(accel_task == NULL)) {
+		return -ENOMEM;
+	}
+
+	accel_task->nsrcs.srcs = buffers;
+	accel_task->nsrcs.cnt = ndata;
+	accel_task->nbytes = nbytes;
+	accel_task->op_code = SPDK_ACCEL_OPC_PQ_GEN;
+	accel_task->src_domain = NULL;
+	accel_task->dst_domain = NULL;
+
+	return accel_submit_task(accel_ch, accel_task);
+}
+
+int
+spdk_accel_submit_pq_recover(struct spdk_io_channel *ch, void **buffers, uint32_t ndata,
+			     uint64_t nbytes, const uint32_t *failed, uint32_t nfailed,
+			     spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+	uint32_t i;
+
+	if (spdk_unlikely(nfailed == 0 || nfailed > SPDK_COUNTOF(accel_task->pq.failed))) {
+		return -EINVAL;
+	}
+
+	accel_task = _get_task(accel_ch, cb_fn, cb_arg);
+	if (spdk_unlikely(accel_task == NULL)) {
+		return -ENOMEM;
+	}
+
+	accel_task->nsrcs.srcs = buffers;
+	accel_task->nsrcs.cnt = ndata;
+	for (i = 0; i < nfailed; i++) {
+		accel_task->pq.failed[i] = failed[i];
+	}
+	accel_task->pq.nfailed = nfailed;
+	accel_task->nbytes = nbytes;
+	accel_task->op_code = SPDK_ACCEL_OPC_PQ_RECOVER;
+	accel_task->src_domain = NULL;
+	accel_task->dst_domain = NULL;
+
+	return accel_submit_task(accel_ch, accel_task);
+}
+
 int
 spdk_accel_submit_dif_verify(struct spdk_io_channel *ch,
 			     struct iovec *iovs, size_t iovcnt, uint32_t num_blocks,
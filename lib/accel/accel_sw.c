@@ -17,6 +17,7 @@
 #include "spdk/crc32.h"
 #include "spdk/util.h"
 #include "spdk/xor.h"
+#include "spdk/pq.h"
 #include "spdk/dif.h"
 
 #ifdef SPDK_CONFIG_HAVE_LZ4
@@ -112,6 +113,8 @@ sw_accel_supports_opcode(enum spdk_accel_opcode opc)
 	case SPDK_ACCEL_OPC_DIF_VERIFY_COPY:
 	case SPDK_ACCEL_OPC_DIX_GENERATE:
 	case SPDK_ACCEL_OPC_DIX_VERIFY:
+	case SPDK_ACCEL_OPC_PQ_GEN:
+	case SPDK_ACCEL_OPC_PQ_RECOVER:
 		return true;
 	default:
 		return false;
@@ -617,6 +620,24 @@ _sw_accel_xor(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_t
 			    accel_task->d.iovs[0].iov_len);
 }
 
+static int
+_sw_accel_pq_gen(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+{
+	return spdk_pq_gen(accel_task->nsrcs.srcs,
+			   accel_task->nsrcs.cnt,
+			   accel_task->nbytes);
+}
+
+static int
+_sw_accel_pq_recover(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+{
+	return spdk_pq_recover(accel_task->nsrcs.srcs,
+			       accel_task->nsrcs.cnt,
+			       accel_task->nbytes,
+			       accel_task->pq.failed,
+			       accel_task->pq.nfailed);
+}
+
 static int
 _sw_accel_dif_verify(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
 {
@@ -778,6 +799,12 @@ sw_accel_submit_tasks(struct spdk_io_channel *ch, struct spdk_accel_task *accel_
 		case SPDK_ACCEL_OPC_DIX_VERIFY:
 			rc = _sw_accel_dix_verify(sw_ch, accel_task);
 			break;
+		case SPDK_ACCEL_OPC_PQ_GEN:
+			rc = _sw_accel_pq_gen(sw_ch, accel_task);
+			break;
+		case SPDK_ACCEL_OPC_PQ_RECOVER:
+			rc = _sw_accel_pq_recover(sw_ch, accel_task);
+			break;
 		default:
 			assert(false);
 			break;
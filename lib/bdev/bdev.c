@@ -46,6 +46,7 @@ SPDK_LOG_DEPRECATION_REGISTER(bdev_get_memory_domains,
 #define BUF_SMALL_CACHE_SIZE			128
 #define BUF_LARGE_CACHE_SIZE			16
 #define NOMEM_THRESHOLD_COUNT			8
+#define BDEV_IO_PRIORITY_LOW_WEIGHT		8
 
 #define SPDK_BDEV_QOS_TIMESLICE_IN_USEC		1000
 #define SPDK_BDEV_QOS_MIN_IO_PER_TIMESLICE	1
@@ -146,8 +147,52 @@ struct lba_range {
 	struct spdk_bdev_channel	*owner_ch;
 	TAILQ_ENTRY(lba_range)		tailq;
 	TAILQ_ENTRY(lba_range)		tailq_module;
+
+	/* Per-channel copies of the range are kept in an interval tree. max_end is the
+	 * highest end of the ranges in the subtree rooted at this one.
+	 */
+	RB_ENTRY(lba_range)		node;
+	uint64_t			max_end;
 };
 
+RB_HEAD(lba_range_tree, lba_range);
+
+static int
+lba_range_cmp(struct lba_range *range1, struct lba_range *range2)
+{
+	if (range1->offset != range2->offset) {
+		return range1->offset < range2->offset ? -1 : 1;
+	}
+	if (range1->length != range2->length) {
+		return range1->length < range2->length ? -1 : 1;
+	}
+	if (range1->locked_ctx != range2->locked_ctx) {
+		return (uintptr_t)range1->locked_ctx < (uintptr_t)range2->locked_ctx ? -1 : 1;
+	}
+
+	return 0;
+}
+
+static inline void
+lba_range_tree_augment(struct lba_range *range)
+{
+	struct lba_range *left = RB_LEFT(range, node), *right = RB_RIGHT(range, node);
+
+	range->max_end = range->offset + range->length;
+	if (left != NULL) {
+		range->max_end = spdk_max(range->max_end, left->max_end);
+	}
+	if (right != NULL) {
+		range->max_end = spdk_max(range->max_end, right->max_end);
+	}
+}
+
+#undef RB_AUGMENT
+#define RB_AUGMENT(x) lba_range_tree_augment(x)
+RB_GENERATE_STATIC(lba_range_tree, lba_range, node, lba_range_cmp);
+#undef RB_AUGMENT
+#define RB_AUGMENT(x) break
+
 static struct spdk_bdev_opts	g_bdev_opts = {
 	.bdev_io_pool_size = SPDK_BDEV_IO_POOL_SIZE,
 	.bdev_io_cache_size = SPDK_BDEV_IO_CACHE_SIZE,
@@ -273,6 +318,23 @@ struct spdk_bdev_shared_resource {
 
 #define BDEV_CH_RESET_IN_PROGRESS	(1 << 0)
 #define BDEV_CH_QOS_ENABLED		(1 << 1)
+#define BDEV_CH_MERGE_ENABLED		(1 << 2)
+
+/* Number of merged I/Os a channel can have outstanding at the same time */
+#define BDEV_IO_MERGE_NUM_BATCHES	32
+
+struct bdev_io_merge_batch {
+	/* Adjacent I/Os of the same type, linked through internal.link */
+	bdev_io_tailq_t			ios;
+	uint64_t			offset_blocks;
+	uint64_t			num_blocks;
+	/* Limits the batch may grow to without the merged I/O having to be split */
+	uint64_t			max_blocks;
+	int				max_iovcnt;
+	int				iovcnt;
+	struct iovec			iovs[SPDK_BDEV_IO_NUM_CHILD_IOV];
+	TAILQ_ENTRY(bdev_io_merge_batch) link;
+};
 
 struct spdk_bdev_channel {
 	struct spdk_bdev	*bdev;
@@ -327,10 +389,18 @@ struct spdk_bdev_channel {
 	struct spdk_bdev_io_stat *prev_stat;
 #endif
 
-	lba_range_tailq_t	locked_ranges;
+	struct lba_range_tree	locked_ranges;
 
 	/** List of I/Os queued by QoS. */
 	bdev_io_tailq_t		qos_queued_io;
+
+	/** I/O merging state, batches are allocated once merging is first enabled */
+	struct bdev_io_merge_batch	*merge_batches;
+	TAILQ_HEAD(, bdev_io_merge_batch) merge_free_batches;
+	/** Batch still accepting adjacent I/Os */
+	struct bdev_io_merge_batch	*merge_batch;
+	struct spdk_poller		*merge_poller;
+	uint64_t			merge_max_blocks;
 };
 
 struct media_event_entry {
@@ -369,6 +439,8 @@ struct spdk_bdev_iostat_ctx {
 	enum spdk_bdev_reset_stat_mode reset_mode;
 	spdk_bdev_get_device_stat_cb cb;
 	void *cb_arg;
+	/* Protects stat, channels are visited in parallel */
+	struct spdk_spinlock lock;
 };
 
 struct set_qos_limit_ctx {
@@ -421,7 +493,7 @@ static int bdev_readv_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io
 				     uint64_t num_blocks,
 				     struct spdk_memory_domain *domain, void *domain_ctx,
 				     struct spdk_accel_sequence *seq, uint32_t dif_check_flags,
-				     bool has_metadata,
+				     bool has_metadata, uint8_t priority,
 				     spdk_bdev_io_completion_cb cb, void *cb_arg);
 static int bdev_writev_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 				      struct iovec *iov, int iovcnt, void *md_buf,
@@ -430,6 +502,7 @@ static int bdev_writev_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_i
 				      struct spdk_accel_sequence *seq, uint32_t dif_check_flags,
 				      bool has_metadata,
 				      uint32_t nvme_cdw12_raw, uint32_t nvme_cdw13_raw,
+				      uint8_t priority,
 				      spdk_bdev_io_completion_cb cb, void *cb_arg);
 
 static int bdev_lock_lba_range(struct spdk_bdev_desc *desc, struct spdk_io_channel *_ch,
@@ -451,6 +524,7 @@ static void claim_reset(struct spdk_bdev *bdev);
 static void bdev_ch_retry_io(struct spdk_bdev_channel *bdev_ch);
 
 static bool bdev_io_should_split(struct spdk_bdev_io *bdev_io);
+static void bdev_io_merge_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg);
 
 #define bdev_get_ext_io_opt(opts, field, defval) \
 	((opts) != NULL ? SPDK_GET_FIELD(opts, field, defval) : (defval))
@@ -998,6 +1072,49 @@ spdk_bdev_io_get_block_size(struct spdk_bdev_io *bdev_io)
 	}
 }
 
+/*
+ * Queue an I/O behind the ones of its own or higher priority class.  High priority I/O is only
+ * queued behind other high priority I/O.  Normal priority I/O overtakes queued low priority I/O,
+ * but each low priority I/O can only be overtaken BDEV_IO_PRIORITY_LOW_WEIGHT times, so that it
+ * is not starved by a steady stream of normal priority I/O.
+ */
+static void
+bdev_io_tailq_insert(bdev_io_tailq_t *queue, struct spdk_bdev_io *bdev_io)
+{
+	struct spdk_bdev_io *prev, *next;
+
+	bdev_io->internal.priority_passed = 0;
+
+	switch (bdev_io->internal.priority) {
+	case SPDK_BDEV_IO_PRIORITY_HIGH:
+		TAILQ_FOREACH(next, queue, internal.link) {
+			if (next->internal.priority != SPDK_BDEV_IO_PRIORITY_HIGH) {
+				TAILQ_INSERT_BEFORE(next, bdev_io, internal.link);
+				return;
+			}
+		}
+		break;
+	case SPDK_BDEV_IO_PRIORITY_NORMAL:
+		prev = TAILQ_LAST(queue, bdev_io_tailq);
+		while (prev != NULL && prev->internal.priority == SPDK_BDEV_IO_PRIORITY_LOW &&
+		       prev->internal.priority_passed < BDEV_IO_PRIORITY_LOW_WEIGHT) {
+			prev->internal.priority_passed++;
+			prev = TAILQ_PREV(prev, bdev_io_tailq, internal.link);
+		}
+
+		if (prev == NULL) {
+			TAILQ_INSERT_HEAD(queue, bdev_io, internal.link);
+		} else {
+			TAILQ_INSERT_AFTER(queue, prev, bdev_io, internal.link);
+		}
+		return;
+	default:
+		break;
+	}
+
+	TAILQ_INSERT_TAIL(queue, bdev_io, internal.link);
+}
+
 static inline void
 bdev_queue_nomem_io_head(struct spdk_bdev_shared_resource *shared_resource,
 			 struct spdk_bdev_io *bdev_io, enum bdev_io_retry_state state)
@@ -1024,7 +1141,7 @@ bdev_queue_nomem_io_tail(struct spdk_bdev_shared_resource *shared_resource,
 
 	assert(state != BDEV_IO_RETRY_STATE_INVALID);
 	bdev_io->internal.retry_state = state;
-	TAILQ_INSERT_TAIL(&shared_resource->nomem_io, bdev_io, internal.link);
+	bdev_io_tailq_insert(&shared_resource->nomem_io, bdev_io);
 }
 
 void
@@ -2112,6 +2229,25 @@ bdev_qos_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
 	spdk_json_write_object_end(w);
 }
 
+static void
+bdev_io_merge_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
+{
+	if (bdev->internal.merge_window_us == 0) {
+		return;
+	}
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "method", "bdev_set_io_merge");
+
+	spdk_json_write_named_object_begin(w, "params");
+	spdk_json_write_named_string(w, "name", bdev->name);
+	spdk_json_write_named_uint32(w, "window_us", bdev->internal.merge_window_us);
+	spdk_json_write_named_uint32(w, "max_size_kb", bdev->internal.merge_max_size / 1024);
+	spdk_json_write_object_end(w);
+
+	spdk_json_write_object_end(w);
+}
+
 void
 spdk_bdev_subsystem_config_json(struct spdk_json_write_ctx *w)
 {
@@ -2150,6 +2286,7 @@ spdk_bdev_subsystem_config_json(struct spdk_json_write_ctx *w)
 
 		bdev_qos_config_json(bdev, w);
 		bdev_enable_histogram_config_json(bdev, w);
+		bdev_io_merge_config_json(bdev, w);
 	}
 
 	spdk_spin_unlock(&g_bdev_mgr.spinlock);
@@ -3231,6 +3368,7 @@ bdev_io_split_submit(struct spdk_bdev_io *bdev_io, struct iovec *iov, int iovcnt
 					       bdev_io_use_memory_domain(bdev_io) ? bdev_io->u.bdev.memory_domain_ctx : NULL,
 					       NULL,
 					       bdev_io->u.bdev.dif_check_flags, bdev_io->internal.f.has_metadata,
+					       bdev_io->internal.priority,
 					       bdev_io_split_done, bdev_io);
 		break;
 	case SPDK_BDEV_IO_TYPE_WRITE:
@@ -3245,6 +3383,7 @@ bdev_io_split_submit(struct spdk_bdev_io *bdev_io, struct iovec *iov, int iovcnt
 						bdev_io->u.bdev.dif_check_flags, bdev_io->internal.f.has_metadata,
 						bdev_io->u.bdev.nvme_cdw12.raw,
 						bdev_io->u.bdev.nvme_cdw13.raw,
+						bdev_io->internal.priority,
 						bdev_io_split_done, bdev_io);
 		break;
 	case SPDK_BDEV_IO_TYPE_UNMAP:
@@ -3694,6 +3833,257 @@ bdev_rw_split_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_i
 	_bdev_rw_split(bdev_io);
 }
 
+static inline bool
+bdev_io_can_merge(struct spdk_bdev_io *bdev_io)
+{
+	if (bdev_io->type != SPDK_BDEV_IO_TYPE_READ && bdev_io->type != SPDK_BDEV_IO_TYPE_WRITE) {
+		return false;
+	}
+
+	/* Reads without a buffer get one allocated by the module, so they're passed down as is.
+	 * High priority I/O is never held back waiting for neighbours.
+	 */
+	return !bdev_io->internal.f.child_io &&
+	       bdev_io->internal.priority != SPDK_BDEV_IO_PRIORITY_HIGH &&
+	       !bdev_io->internal.f.has_bounce_buf &&
+	       !bdev_io_use_memory_domain(bdev_io) &&
+	       !bdev_io_use_accel_sequence(bdev_io) &&
+	       _is_buf_allocated(bdev_io->u.bdev.iovs);
+}
+
+static void
+bdev_io_merge_put_batch(struct spdk_bdev_channel *ch, struct bdev_io_merge_batch *batch)
+{
+	assert(TAILQ_EMPTY(&batch->ios));
+	TAILQ_INSERT_HEAD(&ch->merge_free_batches, batch, link);
+}
+
+static void
+bdev_io_merge_submit_each(struct spdk_bdev_channel *ch, struct bdev_io_merge_batch *batch)
+{
+	struct spdk_bdev_io *bdev_io;
+	bdev_io_tailq_t ios;
+
+	TAILQ_INIT(&ios);
+	TAILQ_SWAP(&ios, &batch->ios, spdk_bdev_io, internal.link);
+	bdev_io_merge_put_batch(ch, batch);
+
+	while (!TAILQ_EMPTY(&ios)) {
+		bdev_io = TAILQ_FIRST(&ios);
+		TAILQ_REMOVE(&ios, bdev_io, internal.link);
+		bdev_io_do_submit(ch, bdev_io);
+	}
+}
+
+static void
+bdev_io_merge_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct bdev_io_merge_batch *batch = cb_arg;
+	struct spdk_bdev_channel *ch = bdev_io->internal.ch;
+	struct spdk_bdev_io *child_io;
+	bdev_io_tailq_t ios;
+
+	TAILQ_INIT(&ios);
+	TAILQ_SWAP(&ios, &batch->ios, spdk_bdev_io, internal.link);
+	TAILQ_FOREACH(child_io, &ios, internal.link) {
+		child_io->internal.status = bdev_io->internal.status;
+		child_io->internal.error = bdev_io->internal.error;
+	}
+
+	spdk_bdev_free_io(bdev_io);
+	bdev_io_merge_put_batch(ch, batch);
+
+	while (!TAILQ_EMPTY(&ios)) {
+		child_io = TAILQ_FIRST(&ios);
+		TAILQ_REMOVE(&ios, child_io, internal.link);
+		bdev_ch_remove_from_io_submitted(child_io);
+		spdk_trace_record(TRACE_BDEV_IO_DONE, ch->trace_id, 0, (uintptr_t)child_io,
+				  child_io->internal.caller_ctx, ch->queue_depth);
+		child_io->internal.cb(child_io, success, child_io->internal.caller_ctx);
+	}
+}
+
+static void
+bdev_io_merge_flush(struct spdk_bdev_channel *ch)
+{
+	struct bdev_io_merge_batch *batch = ch->merge_batch;
+	struct spdk_io_channel *io_ch = spdk_io_channel_from_ctx(ch);
+	struct spdk_bdev_io *bdev_io;
+	int rc;
+
+	if (batch == NULL) {
+		return;
+	}
+
+	ch->merge_batch = NULL;
+	bdev_io = TAILQ_FIRST(&batch->ios);
+	if (TAILQ_NEXT(bdev_io, internal.link) == NULL) {
+		bdev_io_merge_submit_each(ch, batch);
+		return;
+	}
+
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_READ) {
+		rc = bdev_readv_blocks_with_md(bdev_io->internal.desc, io_ch, batch->iovs,
+					       batch->iovcnt, NULL, batch->offset_blocks,
+					       batch->num_blocks, NULL, NULL, NULL,
+					       bdev_io->u.bdev.dif_check_flags, false,
+					       bdev_io->internal.priority,
+					       bdev_io_merge_done, batch);
+	} else {
+		rc = bdev_writev_blocks_with_md(bdev_io->internal.desc, io_ch, batch->iovs,
+						batch->iovcnt, NULL, batch->offset_blocks,
+						batch->num_blocks, NULL, NULL, NULL,
+						bdev_io->u.bdev.dif_check_flags, false,
+						bdev_io->u.bdev.nvme_cdw12.raw,
+						bdev_io->u.bdev.nvme_cdw13.raw,
+						bdev_io->internal.priority,
+						bdev_io_merge_done, batch);
+	}
+
+	if (spdk_unlikely(rc != 0)) {
+		/* Out of bdev_ios, submit the I/Os one by one instead */
+		bdev_io_merge_submit_each(ch, batch);
+	}
+}
+
+static int
+bdev_io_merge_poll(void *arg)
+{
+	struct spdk_bdev_channel *ch = arg;
+
+	if (ch->merge_batch == NULL) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	/* The poller runs once per window, so nothing is held for longer than that */
+	bdev_io_merge_flush(ch);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static bool
+bdev_io_merge_batch_accepts(struct bdev_io_merge_batch *batch, struct spdk_bdev_io *bdev_io)
+{
+	struct spdk_bdev_io *first_io = TAILQ_FIRST(&batch->ios);
+
+	if (bdev_io->type != first_io->type ||
+	    bdev_io->internal.desc != first_io->internal.desc ||
+	    bdev_io->u.bdev.offset_blocks != batch->offset_blocks + batch->num_blocks ||
+	    bdev_io->u.bdev.dif_check_flags != first_io->u.bdev.dif_check_flags ||
+	    bdev_io->internal.priority != first_io->internal.priority) {
+		return false;
+	}
+
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE &&
+	    (bdev_io->u.bdev.nvme_cdw12.raw != first_io->u.bdev.nvme_cdw12.raw ||
+	     bdev_io->u.bdev.nvme_cdw13.raw != first_io->u.bdev.nvme_cdw13.raw)) {
+		return false;
+	}
+
+	return batch->num_blocks + bdev_io->u.bdev.num_blocks <= batch->max_blocks &&
+	       batch->iovcnt + bdev_io->u.bdev.iovcnt <= batch->max_iovcnt;
+}
+
+static void
+bdev_io_merge_batch_add(struct bdev_io_merge_batch *batch, struct spdk_bdev_io *bdev_io)
+{
+	memcpy(&batch->iovs[batch->iovcnt], bdev_io->u.bdev.iovs,
+	       sizeof(struct iovec) * bdev_io->u.bdev.iovcnt);
+	batch->iovcnt += bdev_io->u.bdev.iovcnt;
+	batch->num_blocks += bdev_io->u.bdev.num_blocks;
+	TAILQ_INSERT_TAIL(&batch->ios, bdev_io, internal.link);
+}
+
+static bool
+bdev_io_merge_batch_open(struct spdk_bdev_channel *ch, struct bdev_io_merge_batch *batch,
+			 struct spdk_bdev_io *bdev_io)
+{
+	struct spdk_bdev *bdev = ch->bdev;
+	uint64_t offset_blocks = bdev_io->u.bdev.offset_blocks;
+	uint32_t io_boundary;
+
+	/* The merged I/O must not need splitting, so stop at the boundaries the split path uses */
+	batch->max_blocks = ch->merge_max_blocks;
+	io_boundary = bdev_rw_get_io_boundary(bdev, bdev_io->type);
+	if (io_boundary) {
+		batch->max_blocks = spdk_min(batch->max_blocks,
+					     io_boundary - offset_blocks % io_boundary);
+	}
+	if (bdev->max_rw_size) {
+		batch->max_blocks = spdk_min(batch->max_blocks, bdev->max_rw_size);
+	}
+	batch->max_iovcnt = SPDK_BDEV_IO_NUM_CHILD_IOV;
+	if (bdev->max_num_segments) {
+		batch->max_iovcnt = spdk_min(batch->max_iovcnt, (int)bdev->max_num_segments);
+	}
+
+	if (bdev_io->u.bdev.num_blocks >= batch->max_blocks ||
+	    bdev_io->u.bdev.iovcnt >= batch->max_iovcnt) {
+		return false;
+	}
+
+	batch->offset_blocks = offset_blocks;
+	batch->num_blocks = 0;
+	batch->iovcnt = 0;
+	bdev_io_merge_batch_add(batch, bdev_io);
+
+	return true;
+}
+
+static bool
+bdev_io_merge_abort_io(struct spdk_bdev_channel *ch, struct spdk_bdev_io *bio_to_abort)
+{
+	struct bdev_io_merge_batch *batch = ch->merge_batch;
+
+	if (batch == NULL || !bdev_abort_queued_io(&batch->ios, bio_to_abort)) {
+		return false;
+	}
+
+	/* The remaining I/Os are no longer contiguous */
+	ch->merge_batch = NULL;
+	bdev_io_merge_submit_each(ch, batch);
+
+	return true;
+}
+
+static void
+bdev_io_merge(struct spdk_bdev_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	struct bdev_io_merge_batch *batch = ch->merge_batch;
+
+	if (!bdev_io_can_merge(bdev_io)) {
+		if (spdk_unlikely(bdev_io->type == SPDK_BDEV_IO_TYPE_ABORT) &&
+		    bdev_io_merge_abort_io(ch, bdev_io->u.abort.bio_to_abort)) {
+			_bdev_io_complete_in_submit(ch, bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+		} else {
+			bdev_io_do_submit(ch, bdev_io);
+		}
+		return;
+	}
+
+	if (batch != NULL) {
+		if (bdev_io_merge_batch_accepts(batch, bdev_io)) {
+			bdev_io_merge_batch_add(batch, bdev_io);
+			if (batch->num_blocks == batch->max_blocks ||
+			    batch->iovcnt == batch->max_iovcnt) {
+				bdev_io_merge_flush(ch);
+			}
+			return;
+		}
+
+		bdev_io_merge_flush(ch);
+	}
+
+	batch = TAILQ_FIRST(&ch->merge_free_batches);
+	if (batch == NULL || !bdev_io_merge_batch_open(ch, batch, bdev_io)) {
+		bdev_io_do_submit(ch, bdev_io);
+		return;
+	}
+
+	TAILQ_REMOVE(&ch->merge_free_batches, batch, link);
+	ch->merge_batch = batch;
+}
+
 static inline void
 _bdev_io_submit(struct spdk_bdev_io *bdev_io)
 {
@@ -3712,9 +4102,11 @@ _bdev_io_submit(struct spdk_bdev_io *bdev_io)
 		    bdev_abort_queued_io(&bdev_ch->qos_queued_io, bdev_io->u.abort.bio_to_abort)) {
 			_bdev_io_complete_in_submit(bdev_ch, bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
 		} else {
-			TAILQ_INSERT_TAIL(&bdev_ch->qos_queued_io, bdev_io, internal.link);
+			bdev_io_tailq_insert(&bdev_ch->qos_queued_io, bdev_io);
 			bdev_qos_io_submit(bdev_ch, bdev->internal.qos);
 		}
+	} else if (bdev_ch->flags & BDEV_CH_MERGE_ENABLED) {
+		bdev_io_merge(bdev_ch, bdev_io);
 	} else {
 		SPDK_ERRLOG("unknown bdev_ch flag %x found\n", bdev_ch->flags);
 		_bdev_io_complete_in_submit(bdev_ch, bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
@@ -3784,6 +4176,56 @@ bdev_io_range_is_locked(struct spdk_bdev_io *bdev_io, struct lba_range *range)
 	}
 }
 
+/* Look for a range locking the I/O among the ones overlapping [offset, end) in the subtree */
+static bool
+bdev_lba_range_tree_locks_io(struct lba_range *range, struct spdk_bdev_io *bdev_io,
+			     uint64_t offset, uint64_t end)
+{
+	while (range != NULL && range->max_end > offset) {
+		if (bdev_lba_range_tree_locks_io(RB_LEFT(range, node), bdev_io, offset, end)) {
+			return true;
+		}
+
+		/* Everything from here on starts at or after the end of the I/O */
+		if (range->offset >= end) {
+			return false;
+		}
+
+		if (bdev_io_range_is_locked(bdev_io, range)) {
+			return true;
+		}
+
+		range = RB_RIGHT(range, node);
+	}
+
+	return false;
+}
+
+static bool
+bdev_io_is_locked(struct spdk_bdev_io *bdev_io)
+{
+	struct spdk_bdev_channel *ch = bdev_io->internal.ch;
+	uint64_t offset;
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_NVME_IO:
+	case SPDK_BDEV_IO_TYPE_NVME_IO_MD:
+		return !RB_EMPTY(&ch->locked_ranges);
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_WRITE_UNCORRECTABLE:
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+	case SPDK_BDEV_IO_TYPE_ZCOPY:
+	case SPDK_BDEV_IO_TYPE_COPY:
+		offset = bdev_io->u.bdev.offset_blocks;
+		return bdev_lba_range_tree_locks_io(ch->locked_ranges.rbh_root, bdev_io, offset,
+						    offset + bdev_io->u.bdev.num_blocks);
+	default:
+		return false;
+	}
+}
+
 void
 bdev_io_submit(struct spdk_bdev_io *bdev_io)
 {
@@ -3793,15 +4235,10 @@ bdev_io_submit(struct spdk_bdev_io *bdev_io)
 
 	/* Child I/Os are not checked against locked ranges because their parent I/O was already
 	 * checked before splitting, so they must be allowed to proceed. */
-	if (!bdev_io->internal.f.child_io && !TAILQ_EMPTY(&ch->locked_ranges)) {
-		struct lba_range *range;
-
-		TAILQ_FOREACH(range, &ch->locked_ranges, tailq) {
-			if (bdev_io_range_is_locked(bdev_io, range)) {
-				TAILQ_INSERT_TAIL(&ch->io_locked, bdev_io, internal.ch_link);
-				return;
-			}
-		}
+	if (!bdev_io->internal.f.child_io && !RB_EMPTY(&ch->locked_ranges) &&
+	    bdev_io_is_locked(bdev_io)) {
+		TAILQ_INSERT_TAIL(&ch->io_locked, bdev_io, internal.ch_link);
+		return;
 	}
 
 	bdev_ch_add_to_io_submitted(bdev_io);
@@ -4019,7 +4456,11 @@ bdev_io_init(struct spdk_bdev_io *bdev_io,
 	bdev_io->internal.get_buf_cb = NULL;
 	bdev_io->internal.data_transfer_cpl = NULL;
 	bdev_io->internal.waitq_entry.dep_unblock = false;
-	if (cb == bdev_io_split_done) {
+	bdev_io->internal.priority = cb == bdev_io_split_done ?
+				     ((struct spdk_bdev_io *)cb_arg)->internal.priority :
+				     SPDK_BDEV_IO_PRIORITY_NORMAL;
+	bdev_io->internal.priority_passed = 0;
+	if (cb == bdev_io_split_done || cb == bdev_io_merge_done) {
 		bdev_io->internal.f.child_io = true;
 		bdev_io->internal.f.split = false;
 	} else {
@@ -4267,19 +4708,22 @@ static void
 bdev_channel_destroy_resource(struct spdk_bdev_channel *ch)
 {
 	struct spdk_bdev_shared_resource *shared_resource;
-	struct lba_range *range;
+	struct lba_range *range, *tmp;
 
 	bdev_free_io_stat(ch->stat);
 #ifdef SPDK_CONFIG_VTUNE
 	bdev_free_io_stat(ch->prev_stat);
 #endif
 
-	while (!TAILQ_EMPTY(&ch->locked_ranges)) {
-		range = TAILQ_FIRST(&ch->locked_ranges);
-		TAILQ_REMOVE(&ch->locked_ranges, range, tailq);
+	RB_FOREACH_SAFE(range, lba_range_tree, &ch->locked_ranges, tmp) {
+		RB_REMOVE(lba_range_tree, &ch->locked_ranges, range);
 		free(range);
 	}
 
+	assert(ch->merge_batch == NULL);
+	spdk_poller_unregister(&ch->merge_poller);
+	free(ch->merge_batches);
+
 	spdk_put_io_channel(ch->channel);
 	spdk_put_io_channel(ch->accel_channel);
 
@@ -4405,8 +4849,9 @@ bdev_channel_poll_timeout_io(struct spdk_bdev_channel_iter *i, struct spdk_bdev
 
 	now = spdk_get_ticks();
 	TAILQ_FOREACH(bdev_io, &bdev_ch->io_submitted, internal.ch_link) {
-		/* Exclude any I/O that are generated via splitting. */
-		if (bdev_io->internal.cb == bdev_io_split_done) {
+		/* Exclude any I/O that are generated via splitting or merging. */
+		if (bdev_io->internal.cb == bdev_io_split_done ||
+		    bdev_io->internal.cb == bdev_io_merge_done) {
 			continue;
 		}
 
@@ -4481,6 +4926,44 @@ spdk_bdev_set_timeout(struct spdk_bdev_desc *desc, uint64_t timeout_in_sec,
 	return 0;
 }
 
+static int
+bdev_channel_set_io_merge(struct spdk_bdev_channel *ch, uint32_t window_us, uint32_t max_size)
+{
+	int i;
+
+	bdev_io_merge_flush(ch);
+	spdk_poller_unregister(&ch->merge_poller);
+	ch->flags &= ~BDEV_CH_MERGE_ENABLED;
+
+	if (window_us == 0) {
+		return 0;
+	}
+
+	/* Batches of merged I/Os that are still outstanding are kept until the channel goes away */
+	if (ch->merge_batches == NULL) {
+		ch->merge_batches = calloc(BDEV_IO_MERGE_NUM_BATCHES, sizeof(*ch->merge_batches));
+		if (ch->merge_batches == NULL) {
+			return -ENOMEM;
+		}
+
+		TAILQ_INIT(&ch->merge_free_batches);
+		for (i = 0; i < BDEV_IO_MERGE_NUM_BATCHES; i++) {
+			TAILQ_INIT(&ch->merge_batches[i].ios);
+			TAILQ_INSERT_TAIL(&ch->merge_free_batches, &ch->merge_batches[i], link);
+		}
+	}
+
+	ch->merge_poller = SPDK_POLLER_REGISTER(bdev_io_merge_poll, ch, window_us);
+	if (ch->merge_poller == NULL) {
+		return -ENOMEM;
+	}
+
+	ch->merge_max_blocks = max_size / ch->bdev->blocklen;
+	ch->flags |= BDEV_CH_MERGE_ENABLED;
+
+	return 0;
+}
+
 static int
 bdev_channel_create(void *io_device, void *ctx_buf)
 {
@@ -4490,6 +4973,7 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 	struct spdk_bdev_mgmt_channel	*mgmt_ch;
 	struct spdk_bdev_shared_resource *shared_resource;
 	struct lba_range		*range;
+	uint32_t			merge_window_us, merge_max_size;
 
 	ch->bdev = bdev;
 	ch->channel = bdev->fn_table->get_io_channel(bdev->ctxt);
@@ -4549,7 +5033,7 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 	}
 
 	ch->io_outstanding = 0;
-	TAILQ_INIT(&ch->locked_ranges);
+	RB_INIT(&ch->locked_ranges);
 	TAILQ_INIT(&ch->qos_queued_io);
 	ch->flags = 0;
 	ch->trace_id = bdev->internal.trace_id;
@@ -4604,11 +5088,20 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 		new_range->length = range->length;
 		new_range->offset = range->offset;
 		new_range->locked_ctx = range->locked_ctx;
-		TAILQ_INSERT_TAIL(&ch->locked_ranges, new_range, tailq);
+		new_range->quiesce = range->quiesce;
+		RB_INSERT(lba_range_tree, &ch->locked_ranges, new_range);
 	}
 
+	bdev->internal.num_channels++;
+	merge_window_us = bdev->internal.merge_window_us;
+	merge_max_size = bdev->internal.merge_max_size;
 	spdk_spin_unlock(&bdev->internal.spinlock);
 
+	if (merge_window_us != 0 &&
+	    bdev_channel_set_io_merge(ch, merge_window_us, merge_max_size) != 0) {
+		SPDK_ERRLOG("Could not enable I/O merging\n");
+	}
+
 	return 0;
 }
 
@@ -5020,6 +5513,8 @@ bdev_channel_destroy(void *io_device, void *ctx_buf)
 	/* This channel is going away, so add its statistics into the bdev so that they don't get lost. */
 	spdk_spin_lock(&ch->bdev->internal.spinlock);
 	spdk_bdev_add_io_stat(ch->bdev->internal.stat, ch->stat);
+	assert(ch->bdev->internal.num_channels > 0);
+	ch->bdev->internal.num_channels--;
 	spdk_spin_unlock(&ch->bdev->internal.spinlock);
 
 	bdev_channel_abort_queued_ios(ch);
@@ -5973,7 +6468,7 @@ bdev_readv_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_channel *c
 			  struct iovec *iov, int iovcnt, void *md_buf, uint64_t offset_blocks,
 			  uint64_t num_blocks, struct spdk_memory_domain *domain, void *domain_ctx,
 			  struct spdk_accel_sequence *seq, uint32_t dif_check_flags,
-			  bool has_metadata,
+			  bool has_metadata, uint8_t priority,
 			  spdk_bdev_io_completion_cb cb, void *cb_arg)
 {
 	struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(desc);
@@ -5998,6 +6493,7 @@ bdev_readv_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_channel *c
 	bdev_io->u.bdev.num_blocks = num_blocks;
 	bdev_io->u.bdev.offset_blocks = offset_blocks;
 	bdev_io_init(bdev_io, bdev, cb_arg, cb);
+	bdev_io->internal.priority = priority;
 
 	if (seq != NULL) {
 		bdev_io->internal.f.has_accel_sequence = true;
@@ -6030,7 +6526,8 @@ spdk_bdev_readv_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 	struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(desc);
 
 	return bdev_readv_blocks_with_md(desc, ch, iov, iovcnt, NULL, offset_blocks,
-					 num_blocks, NULL, NULL, NULL, bdev->dif_check_flags, false, cb, cb_arg);
+					 num_blocks, NULL, NULL, NULL, bdev->dif_check_flags, false,
+					 SPDK_BDEV_IO_PRIORITY_NORMAL, cb, cb_arg);
 }
 
 int
@@ -6050,7 +6547,8 @@ spdk_bdev_readv_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_chann
 	}
 
 	return bdev_readv_blocks_with_md(desc, ch, iov, iovcnt, md_buf, offset_blocks,
-					 num_blocks, NULL, NULL, NULL, bdev->dif_check_flags, false, cb, cb_arg);
+					 num_blocks, NULL, NULL, NULL, bdev->dif_check_flags, false,
+					 SPDK_BDEV_IO_PRIORITY_NORMAL, cb, cb_arg);
 }
 
 static inline bool
@@ -6080,6 +6578,7 @@ spdk_bdev_readv_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *
 	void *domain_ctx = NULL, *md = NULL;
 	uint32_t dif_check_flags = 0;
 	uint32_t nvme_cdw12_raw;
+	uint8_t priority = SPDK_BDEV_IO_PRIORITY_NORMAL;
 	struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(desc);
 
 	if (opts) {
@@ -6092,6 +6591,10 @@ spdk_bdev_readv_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *
 		domain_ctx = bdev_get_ext_io_opt(opts, memory_domain_ctx, NULL);
 		seq = bdev_get_ext_io_opt(opts, accel_sequence, NULL);
 		nvme_cdw12_raw = bdev_get_ext_io_opt(opts, nvme_cdw12.raw, 0);
+		priority = bdev_get_ext_io_opt(opts, priority, SPDK_BDEV_IO_PRIORITY_NORMAL);
+		if (spdk_unlikely(priority > SPDK_BDEV_IO_PRIORITY_LOW)) {
+			return -EINVAL;
+		}
 		if (md) {
 			if (spdk_unlikely(!spdk_bdev_is_md_separate(bdev))) {
 				return -EINVAL;
@@ -6120,7 +6623,8 @@ spdk_bdev_readv_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *
 			   ~(bdev_get_ext_io_opt(opts, dif_check_flags_exclude_mask, 0));
 
 	return bdev_readv_blocks_with_md(desc, ch, iov, iovcnt, md, offset_blocks,
-					 num_blocks, domain, domain_ctx, seq, dif_check_flags, false, cb, cb_arg);
+					 num_blocks, domain, domain_ctx, seq, dif_check_flags, false,
+					 priority, cb, cb_arg);
 }
 
 static int
@@ -6159,6 +6663,8 @@ bdev_write_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_channel *c
 	bdev_io->u.bdev.memory_domain_ctx = NULL;
 	bdev_io->u.bdev.accel_sequence = NULL;
 	bdev_io->u.bdev.dif_check_flags = bdev->dif_check_flags;
+	bdev_io->u.bdev.nvme_cdw12.raw = 0;
+	bdev_io->u.bdev.nvme_cdw13.raw = 0;
 	bdev_io_init(bdev_io, bdev, cb_arg, cb);
 
 	bdev_io_submit(bdev_io);
@@ -6216,7 +6722,7 @@ bdev_writev_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_channel *
 			   struct spdk_memory_domain *domain, void *domain_ctx,
 			   struct spdk_accel_sequence *seq, uint32_t dif_check_flags,
 			   bool has_metadata,
-			   uint32_t nvme_cdw12_raw, uint32_t nvme_cdw13_raw,
+			   uint32_t nvme_cdw12_raw, uint32_t nvme_cdw13_raw, uint8_t priority,
 			   spdk_bdev_io_completion_cb cb, void *cb_arg)
 {
 	struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(desc);
@@ -6245,6 +6751,7 @@ bdev_writev_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_channel *
 	bdev_io->u.bdev.num_blocks = num_blocks;
 	bdev_io->u.bdev.offset_blocks = offset_blocks;
 	bdev_io_init(bdev_io, bdev, cb_arg, cb);
+	bdev_io->internal.priority = priority;
 	if (seq != NULL) {
 		bdev_io->internal.f.has_accel_sequence = true;
 		bdev_io->internal.accel_sequence = seq;
@@ -6294,7 +6801,7 @@ spdk_bdev_writev_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 
 	return bdev_writev_blocks_with_md(desc, ch, iov, iovcnt, NULL, offset_blocks,
 					  num_blocks, NULL, NULL, NULL, bdev->dif_check_flags, false, 0, 0,
-					  cb, cb_arg);
+					  SPDK_BDEV_IO_PRIORITY_NORMAL, cb, cb_arg);
 }
 
 int
@@ -6315,7 +6822,7 @@ spdk_bdev_writev_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_chan
 
 	return bdev_writev_blocks_with_md(desc, ch, iov, iovcnt, md_buf, offset_blocks,
 					  num_blocks, NULL, NULL, NULL, bdev->dif_check_flags, false, 0, 0,
-					  cb, cb_arg);
+					  SPDK_BDEV_IO_PRIORITY_NORMAL, cb, cb_arg);
 }
 
 int
@@ -6332,6 +6839,7 @@ spdk_bdev_writev_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel
 	struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(desc);
 	uint32_t nvme_cdw12_raw = 0;
 	uint32_t nvme_cdw13_raw = 0;
+	uint8_t priority = SPDK_BDEV_IO_PRIORITY_NORMAL;
 
 	if (opts) {
 		if (spdk_unlikely(!_bdev_io_check_opts(opts, iov))) {
@@ -6343,6 +6851,10 @@ spdk_bdev_writev_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel
 		seq = bdev_get_ext_io_opt(opts, accel_sequence, NULL);
 		nvme_cdw12_raw = bdev_get_ext_io_opt(opts, nvme_cdw12.raw, 0);
 		nvme_cdw13_raw = bdev_get_ext_io_opt(opts, nvme_cdw13.raw, 0);
+		priority = bdev_get_ext_io_opt(opts, priority, SPDK_BDEV_IO_PRIORITY_NORMAL);
+		if (spdk_unlikely(priority > SPDK_BDEV_IO_PRIORITY_LOW)) {
+			return -EINVAL;
+		}
 		if (md) {
 			if (spdk_unlikely(!spdk_bdev_is_md_separate(bdev))) {
 				return -EINVAL;
@@ -6372,7 +6884,8 @@ spdk_bdev_writev_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel
 
 	return bdev_writev_blocks_with_md(desc, ch, iov, iovcnt, md, offset_blocks, num_blocks,
 					  domain, domain_ctx, seq, dif_check_flags,
-					  false, nvme_cdw12_raw, nvme_cdw13_raw, cb, cb_arg);
+					  false, nvme_cdw12_raw, nvme_cdw13_raw, priority,
+					  cb, cb_arg);
 }
 
 static void
@@ -7084,9 +7597,8 @@ bdev_reset_check_outstanding_io(struct spdk_bdev_channel_iter *i, struct spdk_bd
 	if (cur_ch->io_outstanding > 0 ||
 	    !TAILQ_EMPTY(&cur_ch->io_memory_domain) ||
 	    !TAILQ_EMPTY(&cur_ch->io_accel_exec)) {
-		/* If a channel has outstanding IO, set status to -EBUSY code. This will stop
-		 * further iteration over the rest of the channels and pass non-zero status
-		 * to the callback function. */
+		/* If a channel has outstanding IO, set status to -EBUSY code. This will pass
+		 * non-zero status to the callback function. */
 		status = -EBUSY;
 	}
 	spdk_bdev_for_each_channel_continue(i, status);
@@ -7098,8 +7610,8 @@ bdev_reset_poll_for_outstanding_io(void *ctx)
 	struct spdk_bdev_io *bdev_io = ctx;
 
 	spdk_poller_unregister(&bdev_io->u.reset.wait_poller.poller);
-	spdk_bdev_for_each_channel(bdev_io->bdev, bdev_reset_check_outstanding_io, bdev_io,
-				   bdev_reset_check_outstanding_io_done);
+	spdk_bdev_for_each_channel_parallel(bdev_io->bdev, bdev_reset_check_outstanding_io, bdev_io,
+					    bdev_reset_check_outstanding_io_done);
 
 	return SPDK_POLLER_BUSY;
 }
@@ -7120,8 +7632,8 @@ bdev_reset_freeze_channel_done(struct spdk_bdev *bdev, void *_ctx, int status)
 	/* In case bdev->reset_io_drain_timeout is not equal to zero,
 	 * submit the reset to the underlying module only if outstanding I/O
 	 * remain after reset_io_drain_timeout seconds have passed. */
-	spdk_bdev_for_each_channel(bdev, bdev_reset_check_outstanding_io, bdev_io,
-				   bdev_reset_check_outstanding_io_done);
+	spdk_bdev_for_each_channel_parallel(bdev, bdev_reset_check_outstanding_io, bdev_io,
+					    bdev_reset_check_outstanding_io_done);
 }
 
 static void
@@ -7131,6 +7643,7 @@ bdev_reset_freeze_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bd
 	struct spdk_bdev_channel	*channel;
 	struct spdk_bdev_mgmt_channel	*mgmt_channel;
 	struct spdk_bdev_shared_resource *shared_resource;
+	struct bdev_io_merge_batch	*batch;
 
 	channel = __io_ch_to_bdev_ch(ch);
 	shared_resource = channel->shared_resource;
@@ -7149,6 +7662,13 @@ bdev_reset_freeze_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bd
 		bdev_abort_all_queued_io(&channel->qos_queued_io, channel);
 	}
 
+	if (channel->merge_batch != NULL) {
+		batch = channel->merge_batch;
+		channel->merge_batch = NULL;
+		bdev_abort_all_queued_io(&batch->ios, channel);
+		bdev_io_merge_put_batch(channel, batch);
+	}
+
 	spdk_bdev_for_each_channel_continue(i, 0);
 }
 
@@ -7179,8 +7699,8 @@ bdev_start_reset(struct spdk_bdev_io *bdev_io)
 	spdk_spin_unlock(&bdev->internal.spinlock);
 
 	if (freeze_channel) {
-		spdk_bdev_for_each_channel(bdev, bdev_reset_freeze_channel, bdev_io,
-					   bdev_reset_freeze_channel_done);
+		spdk_bdev_for_each_channel_parallel(bdev, bdev_reset_freeze_channel, bdev_io,
+						    bdev_reset_freeze_channel_done);
 	}
 }
 
@@ -7252,6 +7772,7 @@ bdev_get_device_stat_done(struct spdk_bdev *bdev, void *_ctx, int status)
 
 	bdev_iostat_ctx->cb(bdev, bdev_iostat_ctx->stat,
 			    bdev_iostat_ctx->cb_arg, 0);
+	spdk_spin_destroy(&bdev_iostat_ctx->lock);
 	free(bdev_iostat_ctx);
 }
 
@@ -7262,7 +7783,9 @@ bdev_get_each_channel_stat(struct spdk_bdev_channel_iter *i, struct spdk_bdev *b
 	struct spdk_bdev_iostat_ctx *bdev_iostat_ctx = _ctx;
 	struct spdk_bdev_channel *channel = __io_ch_to_bdev_ch(ch);
 
+	spdk_spin_lock(&bdev_iostat_ctx->lock);
 	spdk_bdev_add_io_stat(bdev_iostat_ctx->stat, channel->stat);
+	spdk_spin_unlock(&bdev_iostat_ctx->lock);
 	spdk_bdev_reset_io_stat(channel->stat, bdev_iostat_ctx->reset_mode);
 	spdk_bdev_for_each_channel_continue(i, 0);
 }
@@ -7288,6 +7811,7 @@ spdk_bdev_get_device_stat(struct spdk_bdev *bdev, struct spdk_bdev_io_stat *stat
 	bdev_iostat_ctx->cb = cb;
 	bdev_iostat_ctx->cb_arg = cb_arg;
 	bdev_iostat_ctx->reset_mode = reset_mode;
+	spdk_spin_init(&bdev_iostat_ctx->lock);
 
 	/* Start with the statistics from previously deleted channels. */
 	spdk_spin_lock(&bdev->internal.spinlock);
@@ -7295,9 +7819,9 @@ spdk_bdev_get_device_stat(struct spdk_bdev *bdev, struct spdk_bdev_io_stat *stat
 	spdk_bdev_reset_io_stat(bdev->internal.stat, reset_mode);
 	spdk_spin_unlock(&bdev->internal.spinlock);
 
-	/* Then iterate and add the statistics from each existing channel. */
-	spdk_bdev_for_each_channel(bdev, bdev_get_each_channel_stat, bdev_iostat_ctx,
-				   bdev_get_device_stat_done);
+	/* Then add the statistics from each existing channel. */
+	spdk_bdev_for_each_channel_parallel(bdev, bdev_get_each_channel_stat, bdev_iostat_ctx,
+					    bdev_get_device_stat_done);
 }
 
 struct bdev_iostat_reset_ctx {
@@ -7352,10 +7876,10 @@ bdev_reset_device_stat(struct spdk_bdev *bdev, enum spdk_bdev_reset_stat_mode mo
 	spdk_bdev_reset_io_stat(bdev->internal.stat, mode);
 	spdk_spin_unlock(&bdev->internal.spinlock);
 
-	spdk_bdev_for_each_channel(bdev,
-				   bdev_reset_each_channel_stat,
-				   ctx,
-				   bdev_reset_device_stat_done);
+	spdk_bdev_for_each_channel_parallel(bdev,
+					    bdev_reset_each_channel_stat,
+					    ctx,
+					    bdev_reset_device_stat_done);
 }
 
 int
@@ -8092,8 +8616,8 @@ spdk_bdev_io_complete(struct spdk_bdev_io *bdev_io, enum spdk_bdev_io_status sta
 
 	if (spdk_unlikely(bdev_io->type == SPDK_BDEV_IO_TYPE_RESET)) {
 		assert(bdev_io == bdev->internal.reset_in_progress);
-		spdk_bdev_for_each_channel(bdev, bdev_unfreeze_channel, bdev_io,
-					   bdev_reset_complete);
+		spdk_bdev_for_each_channel_parallel(bdev, bdev_unfreeze_channel, bdev_io,
+						    bdev_reset_complete);
 		return;
 	} else {
 		bdev_io_decrement_outstanding(bdev_ch, shared_resource);
@@ -8808,7 +9332,8 @@ bdev_start_qos(struct spdk_bdev *bdev)
 		}
 		ctx->bdev = bdev;
 		ctx->bdev->internal.qos_mod_in_progress = true;
-		spdk_bdev_for_each_channel(bdev, bdev_enable_qos_msg, ctx, bdev_enable_qos_done);
+		spdk_bdev_for_each_channel_parallel(bdev, bdev_enable_qos_msg, ctx,
+						    bdev_enable_qos_done);
 	}
 
 	return 0;
@@ -10016,6 +10541,12 @@ spdk_bdev_io_get_cb_arg(struct spdk_bdev_io *bdev_io)
 	return bdev_io->internal.caller_ctx;
 }
 
+enum spdk_bdev_io_priority
+spdk_bdev_io_get_priority(const struct spdk_bdev_io *bdev_io)
+{
+	return bdev_io->internal.priority;
+}
+
 void
 spdk_bdev_module_list_add(struct spdk_bdev_module *bdev_module)
 {
@@ -10344,9 +10875,13 @@ spdk_bdev_set_qos_rate_limits(struct spdk_bdev *bdev, uint64_t *limits,
 		if (bdev->internal.qos->thread == NULL) {
 			/* Enabling */
 			bdev_set_qos_rate_limits(bdev, limits);
+			if (bdev->internal.merge_window_us != 0) {
+				SPDK_NOTICELOG("I/O merging of bdev %s is suspended while QoS is enabled\n",
+					       bdev->name);
+			}
 
-			spdk_bdev_for_each_channel(bdev, bdev_enable_qos_msg, ctx,
-						   bdev_enable_qos_done);
+			spdk_bdev_for_each_channel_parallel(bdev, bdev_enable_qos_msg, ctx,
+							    bdev_enable_qos_done);
 		} else {
 			/* Updating */
 			bdev_set_qos_rate_limits(bdev, limits);
@@ -10359,8 +10894,8 @@ spdk_bdev_set_qos_rate_limits(struct spdk_bdev *bdev, uint64_t *limits,
 			bdev_set_qos_rate_limits(bdev, limits);
 
 			/* Disabling */
-			spdk_bdev_for_each_channel(bdev, bdev_disable_qos_msg, ctx,
-						   bdev_disable_qos_msg_done);
+			spdk_bdev_for_each_channel_parallel(bdev, bdev_disable_qos_msg, ctx,
+							    bdev_disable_qos_msg_done);
 		} else {
 			spdk_spin_unlock(&bdev->internal.spinlock);
 			bdev_set_qos_limit_done(ctx, 0);
@@ -10536,6 +11071,117 @@ spdk_bdev_histogram_enable(struct spdk_bdev *bdev, spdk_bdev_histogram_status_cb
 	spdk_bdev_histogram_enable_ext(bdev, cb_fn, cb_arg, enable, &opts);
 }
 
+struct set_io_merge_ctx {
+	void (*cb_fn)(void *cb_arg, int status);
+	void *cb_arg;
+	struct spdk_bdev *bdev;
+	int status;
+};
+
+static void
+bdev_set_io_merge_done(struct spdk_bdev *bdev, void *_ctx, int status)
+{
+	struct set_io_merge_ctx *ctx = _ctx;
+
+	spdk_spin_lock(&bdev->internal.spinlock);
+	bdev->internal.merge_mod_in_progress = false;
+	spdk_spin_unlock(&bdev->internal.spinlock);
+
+	ctx->cb_fn(ctx->cb_arg, ctx->status);
+	free(ctx);
+}
+
+static void
+bdev_disable_io_merge_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
+			      struct spdk_io_channel *_ch, void *_ctx)
+{
+	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
+
+	bdev_channel_set_io_merge(ch, 0, 0);
+	spdk_bdev_for_each_channel_continue(i, 0);
+}
+
+static void
+bdev_set_io_merge_channel_done(struct spdk_bdev *bdev, void *_ctx, int status)
+{
+	struct set_io_merge_ctx *ctx = _ctx;
+
+	if (status == 0) {
+		bdev_set_io_merge_done(bdev, ctx, 0);
+		return;
+	}
+
+	/* Don't leave merging enabled on some of the channels only */
+	ctx->status = status;
+	spdk_spin_lock(&bdev->internal.spinlock);
+	bdev->internal.merge_window_us = 0;
+	spdk_spin_unlock(&bdev->internal.spinlock);
+	spdk_bdev_for_each_channel(bdev, bdev_disable_io_merge_channel, ctx,
+				   bdev_set_io_merge_done);
+}
+
+static void
+bdev_set_io_merge_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
+			  struct spdk_io_channel *_ch, void *_ctx)
+{
+	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
+	int rc;
+
+	rc = bdev_channel_set_io_merge(ch, bdev->internal.merge_window_us,
+				       bdev->internal.merge_max_size);
+	spdk_bdev_for_each_channel_continue(i, rc);
+}
+
+void
+spdk_bdev_set_io_merge(struct spdk_bdev *bdev, uint32_t window_us, uint32_t max_size,
+		       void (*cb_fn)(void *cb_arg, int status), void *cb_arg)
+{
+	struct set_io_merge_ctx *ctx;
+	bool qos_enabled;
+
+	if (window_us != 0 && max_size < 2 * bdev->blocklen) {
+		cb_fn(cb_arg, -EINVAL);
+		return;
+	}
+
+	if (bdev->md_len != 0) {
+		cb_fn(cb_arg, -ENOTSUP);
+		return;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+	ctx->bdev = bdev;
+
+	spdk_spin_lock(&bdev->internal.spinlock);
+	if (bdev->internal.merge_mod_in_progress) {
+		spdk_spin_unlock(&bdev->internal.spinlock);
+		free(ctx);
+		cb_fn(cb_arg, -EAGAIN);
+		return;
+	}
+
+	bdev->internal.merge_mod_in_progress = true;
+	bdev->internal.merge_window_us = window_us;
+	bdev->internal.merge_max_size = window_us != 0 ? max_size : 0;
+	qos_enabled = bdev->internal.qos != NULL && bdev->internal.qos->thread != NULL;
+	spdk_spin_unlock(&bdev->internal.spinlock);
+
+	if (window_us != 0 && qos_enabled) {
+		SPDK_NOTICELOG("I/O merging of bdev %s is suspended while QoS is enabled\n",
+			       bdev->name);
+	}
+
+	spdk_bdev_for_each_channel(bdev, bdev_set_io_merge_channel, ctx,
+				   bdev_set_io_merge_channel_done);
+}
+
 struct spdk_bdev_histogram_data_ctx {
 	spdk_bdev_histogram_data_cb cb_fn;
 	void *cb_arg;
@@ -10747,32 +11393,24 @@ bdev_lock_lba_range_cb(struct spdk_bdev *bdev, void *_ctx, int status)
 	 */
 }
 
-static int
-bdev_lock_lba_range_check_io(void *_i)
+/* The range is now in the channel's locked_ranges, so no new IO can be submitted to this
+ * range.  But we need to wait until any outstanding IO overlapping with this range
+ * are completed.
+ */
+static bool
+bdev_channel_has_io_in_range(struct spdk_bdev_channel *ch, struct locked_lba_range_ctx *ctx)
 {
-	struct spdk_bdev_channel_iter *i = _i;
-	struct spdk_io_channel *_ch = spdk_io_channel_iter_get_channel(i->i);
-	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
-	struct locked_lba_range_ctx *ctx = i->ctx;
-	struct lba_range *range = ctx->current_range;
 	struct spdk_bdev_io *bdev_io;
 
-	spdk_poller_unregister(&ctx->poller);
-
-	/* The range is now in the locked_ranges, so no new IO can be submitted to this
-	 * range.  But we need to wait until any outstanding IO overlapping with this range
-	 * are completed.
-	 */
 	TAILQ_FOREACH(bdev_io, &ch->io_submitted, internal.ch_link) {
-		if (bdev_io_range_is_locked(bdev_io, range)) {
+		if (bdev_io_range_is_locked(bdev_io, ctx->current_range)) {
 			if (ctx->ch_ref == NULL) {
 				/* Take another reference to ch to prevent it getting freed while
 				 * the poller is running. */
 				ctx->ch_ref = spdk_get_io_channel(__bdev_to_io_dev(bdev_io->bdev));
 				assert(ctx->ch_ref != NULL);
 			}
-			ctx->poller = SPDK_POLLER_REGISTER(bdev_lock_lba_range_check_io, i, 100);
-			return SPDK_POLLER_BUSY;
+			return true;
 		}
 	}
 
@@ -10781,38 +11419,53 @@ bdev_lock_lba_range_check_io(void *_i)
 		ctx->ch_ref = NULL;
 	}
 
+	return false;
+}
+
+static int
+bdev_lock_lba_range_check_io(void *_i)
+{
+	struct spdk_bdev_channel_iter *i = _i;
+	struct spdk_io_channel *_ch = spdk_io_channel_iter_get_channel(i->i);
+	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
+	struct locked_lba_range_ctx *ctx = i->ctx;
+
+	spdk_poller_unregister(&ctx->poller);
+
+	if (bdev_channel_has_io_in_range(ch, ctx)) {
+		ctx->poller = SPDK_POLLER_REGISTER(bdev_lock_lba_range_check_io, i, 100);
+		return SPDK_POLLER_BUSY;
+	}
+
 	spdk_bdev_for_each_channel_continue(i, 0);
 	return SPDK_POLLER_BUSY;
 }
 
-static void
-bdev_lock_lba_range_get_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
-				struct spdk_io_channel *_ch, void *_ctx)
+/* Add a copy of the range to the channel and return it, or return NULL if the channel
+ * already has it.  Sets *rc to -ENOMEM if the copy could not be allocated.
+ */
+static struct lba_range *
+bdev_channel_add_locked_range(struct spdk_bdev_channel *ch, struct locked_lba_range_ctx *ctx,
+			      int *rc)
 {
-	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
-	struct locked_lba_range_ctx *ctx = _ctx;
 	struct lba_range *range;
 
-	TAILQ_FOREACH(range, &ch->locked_ranges, tailq) {
-		if (range->length == ctx->range.length &&
-		    range->offset == ctx->range.offset &&
-		    range->locked_ctx == ctx->range.locked_ctx) {
-			/* This range already exists on this channel, so don't add
-			 * it again.  This can happen when a new channel is created
-			 * while the for_each_channel operation is in progress.
-			 * Do not check for outstanding I/O in that case, since the
-			 * range was locked before any I/O could be submitted to the
-			 * new channel.
-			 */
-			spdk_bdev_for_each_channel_continue(i, 0);
-			return;
-		}
+	*rc = 0;
+	if (RB_FIND(lba_range_tree, &ch->locked_ranges, &ctx->range) != NULL) {
+		/* This range already exists on this channel, so don't add
+		 * it again.  This can happen when a new channel is created
+		 * while the for_each_channel operation is in progress.
+		 * Do not check for outstanding I/O in that case, since the
+		 * range was locked before any I/O could be submitted to the
+		 * new channel.
+		 */
+		return NULL;
 	}
 
 	range = calloc(1, sizeof(*range));
 	if (range == NULL) {
-		spdk_bdev_for_each_channel_continue(i, -ENOMEM);
-		return;
+		*rc = -ENOMEM;
+		return NULL;
 	}
 
 	range->length = ctx->range.length;
@@ -10827,10 +11480,73 @@ bdev_lock_lba_range_get_channel(struct spdk_bdev_channel_iter *i, struct spdk_bd
 		 */
 		ctx->owner_range = range;
 	}
-	TAILQ_INSERT_TAIL(&ch->locked_ranges, range, tailq);
+	RB_INSERT(lba_range_tree, &ch->locked_ranges, range);
+
+	return range;
+}
+
+static void
+bdev_lock_lba_range_get_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
+				struct spdk_io_channel *_ch, void *_ctx)
+{
+	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
+	struct locked_lba_range_ctx *ctx = _ctx;
+	int rc;
+
+	if (bdev_channel_add_locked_range(ch, ctx, &rc) == NULL) {
+		spdk_bdev_for_each_channel_continue(i, rc);
+		return;
+	}
+
 	bdev_lock_lba_range_check_io(i);
 }
 
+static int
+bdev_lock_lba_range_local_check_io(void *_ctx)
+{
+	struct locked_lba_range_ctx *ctx = _ctx;
+
+	spdk_poller_unregister(&ctx->poller);
+
+	if (bdev_channel_has_io_in_range(ctx->range.owner_ch, ctx)) {
+		ctx->poller = SPDK_POLLER_REGISTER(bdev_lock_lba_range_local_check_io, ctx, 100);
+		return SPDK_POLLER_BUSY;
+	}
+
+	bdev_lock_lba_range_cb(ctx->range.bdev, ctx, 0);
+	return SPDK_POLLER_BUSY;
+}
+
+/* Whether the channel taking the lock, if any, is the only channel of the bdev. Channels
+ * created later copy the range from the bdev's list, so there is no need to visit them all.
+ * Must be called with the bdev's spinlock held.
+ */
+static inline bool
+bdev_lba_range_is_local(struct spdk_bdev *bdev, struct locked_lba_range_ctx *ctx)
+{
+	return bdev->internal.num_channels == (ctx->range.owner_ch != NULL ? 1 : 0);
+}
+
+static void
+bdev_lock_lba_range_local(void *_ctx)
+{
+	struct locked_lba_range_ctx *ctx = _ctx;
+	int rc;
+
+	if (ctx->range.owner_ch == NULL) {
+		bdev_lock_lba_range_cb(ctx->range.bdev, ctx, 0);
+		return;
+	}
+
+	if (bdev_channel_add_locked_range(ctx->range.owner_ch, ctx, &rc) == NULL) {
+		bdev_lock_lba_range_cb(ctx->range.bdev, ctx, rc);
+		return;
+	}
+
+	bdev_lock_lba_range_local_check_io(ctx);
+}
+
+/* Must be called with the bdev's spinlock held */
 static void
 bdev_lock_lba_range_ctx(struct spdk_bdev *bdev, struct locked_lba_range_ctx *ctx)
 {
@@ -10838,6 +11554,11 @@ bdev_lock_lba_range_ctx(struct spdk_bdev *bdev, struct locked_lba_range_ctx *ctx
 	assert(ctx->range.owner_ch == NULL ||
 	       spdk_io_channel_get_thread(ctx->range.owner_ch->channel) == ctx->range.owner_thread);
 
+	if (bdev_lba_range_is_local(bdev, ctx)) {
+		spdk_thread_send_msg(ctx->range.owner_thread, bdev_lock_lba_range_local, ctx);
+		return;
+	}
+
 	/* We will add a copy of this range to each channel now. */
 	spdk_bdev_for_each_channel(bdev, bdev_lock_lba_range_get_channel, ctx,
 				   bdev_lock_lba_range_cb);
@@ -10915,8 +11636,11 @@ static void
 bdev_lock_lba_range_ctx_msg(void *_ctx)
 {
 	struct locked_lba_range_ctx *ctx = _ctx;
+	struct spdk_bdev *bdev = ctx->range.bdev;
 
-	bdev_lock_lba_range_ctx(ctx->range.bdev, ctx);
+	spdk_spin_lock(&bdev->internal.spinlock);
+	bdev_lock_lba_range_ctx(bdev, ctx);
+	spdk_spin_unlock(&bdev->internal.spinlock);
 }
 
 static void
@@ -10954,23 +11678,16 @@ bdev_unlock_lba_range_cb(struct spdk_bdev *bdev, void *_ctx, int status)
 }
 
 static void
-bdev_unlock_lba_range_get_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
-				  struct spdk_io_channel *_ch, void *_ctx)
+bdev_channel_unlock_range(struct spdk_bdev_channel *ch, struct locked_lba_range_ctx *ctx)
 {
-	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
-	struct locked_lba_range_ctx *ctx = _ctx;
 	TAILQ_HEAD(, spdk_bdev_io) io_locked;
 	struct spdk_bdev_io *bdev_io;
 	struct lba_range *range;
 
-	TAILQ_FOREACH(range, &ch->locked_ranges, tailq) {
-		if (ctx->range.offset == range->offset &&
-		    ctx->range.length == range->length &&
-		    ctx->range.locked_ctx == range->locked_ctx) {
-			TAILQ_REMOVE(&ch->locked_ranges, range, tailq);
-			free(range);
-			break;
-		}
+	range = RB_FIND(lba_range_tree, &ch->locked_ranges, &ctx->range);
+	if (range != NULL) {
+		RB_REMOVE(lba_range_tree, &ch->locked_ranges, range);
+		free(range);
 	}
 
 	/* Note: we should almost always be able to assert that the range specified
@@ -10994,10 +11711,27 @@ bdev_unlock_lba_range_get_channel(struct spdk_bdev_channel_iter *i, struct spdk_
 		TAILQ_REMOVE(&io_locked, bdev_io, internal.ch_link);
 		bdev_io_submit(bdev_io);
 	}
+}
 
+static void
+bdev_unlock_lba_range_get_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
+				  struct spdk_io_channel *_ch, void *_ctx)
+{
+	bdev_channel_unlock_range(__io_ch_to_bdev_ch(_ch), _ctx);
 	spdk_bdev_for_each_channel_continue(i, 0);
 }
 
+static void
+bdev_unlock_lba_range_local(void *_ctx)
+{
+	struct locked_lba_range_ctx *ctx = _ctx;
+
+	if (ctx->range.owner_ch != NULL) {
+		bdev_channel_unlock_range(ctx->range.owner_ch, ctx);
+	}
+	bdev_unlock_lba_range_cb(ctx->range.bdev, ctx, 0);
+}
+
 static int
 _bdev_unlock_lba_range(struct spdk_bdev *bdev, uint64_t offset, uint64_t length,
 		       lock_range_cb cb_fn, void *cb_arg)
@@ -11024,11 +11758,16 @@ _bdev_unlock_lba_range(struct spdk_bdev *bdev, uint64_t offset, uint64_t length,
 	}
 	TAILQ_REMOVE(&bdev->internal.locked_ranges, range, tailq);
 	ctx = SPDK_CONTAINEROF(range, struct locked_lba_range_ctx, range);
-	spdk_spin_unlock(&bdev->internal.spinlock);
-
 	ctx->cb_fn = cb_fn;
 	ctx->cb_arg = cb_arg;
 
+	if (bdev_lba_range_is_local(bdev, ctx)) {
+		spdk_spin_unlock(&bdev->internal.spinlock);
+		spdk_thread_send_msg(spdk_get_thread(), bdev_unlock_lba_range_local, ctx);
+		return 0;
+	}
+	spdk_spin_unlock(&bdev->internal.spinlock);
+
 	spdk_bdev_for_each_channel(bdev, bdev_unlock_lba_range_get_channel, ctx,
 				   bdev_unlock_lba_range_cb);
 	return 0;
@@ -11041,21 +11780,16 @@ bdev_unlock_lba_range(struct spdk_bdev_desc *desc, struct spdk_io_channel *_ch,
 {
 	struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(desc);
 	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
-	struct lba_range *range;
-	bool range_found = false;
+	struct lba_range *range, key = {};
 
 	/* Let's make sure the specified channel actually has a lock on
 	 * the specified range.  Note that the range must match exactly.
 	 */
-	TAILQ_FOREACH(range, &ch->locked_ranges, tailq) {
-		if (range->offset == offset && range->length == length &&
-		    range->owner_ch == ch && range->locked_ctx == cb_arg) {
-			range_found = true;
-			break;
-		}
-	}
-
-	if (!range_found) {
+	key.offset = offset;
+	key.length = length;
+	key.locked_ctx = cb_arg;
+	range = RB_FIND(lba_range_tree, &ch->locked_ranges, &key);
+	if (range == NULL || range->owner_ch != ch) {
 		return -EINVAL;
 	}
 
@@ -11326,6 +12060,20 @@ bdev_each_channel_msg(struct spdk_io_channel_iter *i)
 	iter->fn(iter, bdev, ch, iter->ctx);
 }
 
+static void
+bdev_each_channel_parallel_msg(struct spdk_io_channel_iter *i)
+{
+	struct spdk_bdev_channel_iter *iter = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_bdev *bdev = io_channel_iter_get_bdev(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct spdk_bdev_channel_iter *chan_iter = spdk_io_channel_iter_get_channel_ctx(i);
+
+	/* fn runs concurrently on all threads, so each of them gets its own iterator */
+	*chan_iter = *iter;
+	chan_iter->i = i;
+	chan_iter->fn(chan_iter, bdev, ch, chan_iter->ctx);
+}
+
 static void
 bdev_each_channel_cpl(struct spdk_io_channel_iter *i, int status)
 {
@@ -11361,6 +12109,30 @@ spdk_bdev_for_each_channel(struct spdk_bdev *bdev, spdk_bdev_for_each_channel_ms
 			      iter, bdev_each_channel_cpl);
 }
 
+void
+spdk_bdev_for_each_channel_parallel(struct spdk_bdev *bdev, spdk_bdev_for_each_channel_msg fn,
+				    void *ctx, spdk_bdev_for_each_channel_done cpl)
+{
+	struct spdk_bdev_channel_iter *iter;
+
+	assert(bdev != NULL && fn != NULL && ctx != NULL);
+
+	iter = calloc(1, sizeof(struct spdk_bdev_channel_iter));
+	if (iter == NULL) {
+		SPDK_ERRLOG("Unable to allocate iterator\n");
+		assert(false);
+		return;
+	}
+
+	iter->fn = fn;
+	iter->cpl = cpl;
+	iter->ctx = ctx;
+
+	spdk_for_each_channel_parallel_ext(__bdev_to_io_dev(bdev), bdev_each_channel_parallel_msg,
+					   iter, sizeof(struct spdk_bdev_channel_iter),
+					   bdev_each_channel_cpl);
+}
+
 static void
 bdev_copy_do_write_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 {
@@ -865,6 +865,61 @@ cleanup:
 
 SPDK_RPC_REGISTER("bdev_set_qos_limit", rpc_bdev_set_qos_limit, SPDK_RPC_RUNTIME)
 
+static void
+rpc_bdev_set_io_merge_complete(void *cb_arg, int status)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+
+	if (status != 0) {
+		spdk_jsonrpc_send_error_response_fmt(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						     "Failed to configure I/O merging: %s",
+						     spdk_strerror(-status));
+		return;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+
+static void
+rpc_bdev_set_io_merge(struct spdk_jsonrpc_request *request,
+		      const struct spdk_json_val *params)
+{
+	struct rpc_bdev_set_io_merge_ctx req = {.max_size_kb = 128};
+	struct spdk_bdev_desc *desc;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_set_io_merge_decoders,
+				    SPDK_COUNTOF(rpc_bdev_set_io_merge_decoders),
+				    &req)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	if (req.max_size_kb > UINT32_MAX / 1024) {
+		spdk_jsonrpc_send_error_response(request, -EINVAL, spdk_strerror(EINVAL));
+		goto cleanup;
+	}
+
+	rc = spdk_bdev_open_ext(req.name, false, dummy_bdev_event_cb, NULL, &desc);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to open bdev '%s': %d\n", req.name, rc);
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_bdev_set_io_merge(spdk_bdev_desc_get_bdev(desc), req.window_us, req.max_size_kb * 1024,
+			       rpc_bdev_set_io_merge_complete, request);
+
+	spdk_bdev_close(desc);
+
+cleanup:
+	free_rpc_bdev_set_io_merge(&req);
+}
+
+SPDK_RPC_REGISTER("bdev_set_io_merge", rpc_bdev_set_io_merge, SPDK_RPC_RUNTIME)
+
 static void
 bdev_histogram_status_cb(void *cb_arg, int status)
 {
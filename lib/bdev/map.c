@@ -0,0 +1,545 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+/*
+ * Common code for virtual bdevs keeping a block map on their base bdev.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/bdev.h"
+#include "spdk/env.h"
+#include "spdk/log.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+#include "spdk/bdev_module.h"
+
+/* Largest I/O used to read or write the whole map */
+#define BDEV_MAP_IO_SIZE	(1024 * 1024)
+
+/* Map block state */
+#define BDEV_MAP_WRITING	0x1
+
+struct spdk_bdev_map {
+	struct spdk_bdev_desc			*desc;
+	struct spdk_bdev			*bdev;
+	struct spdk_io_channel			*ch;
+	struct spdk_thread			*thread;
+	uint64_t				offset_blocks;
+	uint64_t				num_blocks;
+	uint32_t				block_size;
+	void					*buf;
+
+	/* Per map block: last modification, last persisted modification and state */
+	uint64_t				*gen;
+	uint64_t				*persisted;
+	uint8_t					*flags;
+	uint64_t				seq;
+
+	/* Contexts waiting for their blocks to be persisted */
+	TAILQ_HEAD(, spdk_bdev_map_ctx)		waiters;
+};
+
+struct bdev_map_write {
+	struct spdk_bdev_map			*map;
+	uint64_t				map_block;
+	uint64_t				gen;
+	struct spdk_bdev_io_wait_entry		bdev_io_wait;
+};
+
+/* Whole map read or write */
+struct bdev_map_io {
+	struct spdk_bdev_map			*map;
+	bool					write;
+	uint64_t				offset;
+	uint64_t				num_blocks;
+	spdk_bdev_map_cb			cb_fn;
+	void					*cb_arg;
+	struct spdk_bdev_io_wait_entry		bdev_io_wait;
+};
+
+struct bdev_map_examine_ctx {
+	struct spdk_bdev_desc			*desc;
+	struct spdk_io_channel			*ch;
+	void					*buf;
+	spdk_bdev_map_examine_cb		cb_fn;
+	void					*cb_arg;
+};
+
+static int bdev_map_flush(struct spdk_bdev_map *map, uint64_t map_block);
+static void bdev_map_write_retry(void *arg);
+
+struct spdk_bdev_map *
+spdk_bdev_map_create(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		     uint64_t offset_blocks, uint64_t num_blocks)
+{
+	struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(desc);
+	struct spdk_bdev_map *map;
+
+	map = calloc(1, sizeof(*map));
+	if (map == NULL) {
+		return NULL;
+	}
+
+	map->desc = desc;
+	map->bdev = bdev;
+	map->ch = ch;
+	map->thread = spdk_get_thread();
+	map->offset_blocks = offset_blocks;
+	map->num_blocks = num_blocks;
+	map->block_size = spdk_bdev_get_block_size(bdev);
+	TAILQ_INIT(&map->waiters);
+
+	/* Map blocks are written straight from the buffer */
+	map->buf = spdk_zmalloc(num_blocks * map->block_size,
+				spdk_max(spdk_bdev_get_buf_align(bdev), 64), NULL,
+				SPDK_ENV_NUMA_ID_ANY, SPDK_MALLOC_DMA);
+	map->gen = calloc(num_blocks, sizeof(uint64_t));
+	map->persisted = calloc(num_blocks, sizeof(uint64_t));
+	map->flags = calloc(num_blocks, sizeof(uint8_t));
+	if (!map->buf || !map->gen || !map->persisted || !map->flags) {
+		spdk_bdev_map_free(map);
+		return NULL;
+	}
+
+	return map;
+}
+
+void
+spdk_bdev_map_free(struct spdk_bdev_map *map)
+{
+	if (map == NULL) {
+		return;
+	}
+
+	assert(TAILQ_EMPTY(&map->waiters));
+
+	spdk_free(map->buf);
+	free(map->gen);
+	free(map->persisted);
+	free(map->flags);
+	free(map);
+}
+
+void *
+spdk_bdev_map_get_buf(struct spdk_bdev_map *map)
+{
+	return map->buf;
+}
+
+void
+spdk_bdev_map_update(struct spdk_bdev_map *map, uint64_t map_block)
+{
+	assert(map_block < map->num_blocks);
+
+	map->gen[map_block] = ++map->seq;
+}
+
+static bool
+bdev_map_ctx_persisted(struct spdk_bdev_map_ctx *ctx)
+{
+	struct spdk_bdev_map *map = ctx->map;
+	uint64_t mb;
+
+	/* Each map block has to be persisted at least up to the state it had when the context
+	 * started waiting. Any update made after that also covers it.
+	 */
+	for (mb = ctx->first; mb <= ctx->last; mb++) {
+		if (map->persisted[mb] < spdk_min(ctx->seq, map->gen[mb])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void
+bdev_map_check_waiters(struct spdk_bdev_map *map)
+{
+	struct spdk_bdev_map_ctx *ctx, *tmp;
+
+	TAILQ_FOREACH_SAFE(ctx, &map->waiters, link, tmp) {
+		if (bdev_map_ctx_persisted(ctx)) {
+			TAILQ_REMOVE(&map->waiters, ctx, link);
+			ctx->cb_fn(ctx->cb_arg, 0);
+		}
+	}
+}
+
+static void
+bdev_map_write_failed(struct spdk_bdev_map *map, uint64_t map_block)
+{
+	struct spdk_bdev_map_ctx *ctx, *tmp;
+
+	TAILQ_FOREACH_SAFE(ctx, &map->waiters, link, tmp) {
+		if (map_block >= ctx->first && map_block <= ctx->last) {
+			TAILQ_REMOVE(&map->waiters, ctx, link);
+			ctx->cb_fn(ctx->cb_arg, -EIO);
+		}
+	}
+}
+
+static void
+bdev_map_write_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct bdev_map_write *mw = cb_arg;
+	struct spdk_bdev_map *map = mw->map;
+	uint64_t map_block = mw->map_block;
+
+	spdk_bdev_free_io(bdev_io);
+
+	map->flags[map_block] &= ~BDEV_MAP_WRITING;
+
+	if (success) {
+		map->persisted[map_block] = mw->gen;
+		free(mw);
+		bdev_map_check_waiters(map);
+		/* Updates made while the write was in flight are picked up by the next one */
+		bdev_map_flush(map, map_block);
+		return;
+	}
+
+	SPDK_ERRLOG("Failed to write map block %" PRIu64 " to %s\n", map_block,
+		    spdk_bdev_get_name(map->bdev));
+	free(mw);
+
+	bdev_map_write_failed(map, map_block);
+}
+
+static int
+bdev_map_submit(struct bdev_map_write *mw)
+{
+	struct spdk_bdev_map *map = mw->map;
+	int rc;
+
+	rc = spdk_bdev_write_blocks(map->desc, map->ch,
+				    (uint8_t *)map->buf + mw->map_block * map->block_size,
+				    map->offset_blocks + mw->map_block, 1, bdev_map_write_done, mw);
+	if (rc == -ENOMEM) {
+		mw->bdev_io_wait.bdev = map->bdev;
+		mw->bdev_io_wait.cb_fn = bdev_map_write_retry;
+		mw->bdev_io_wait.cb_arg = mw;
+		rc = spdk_bdev_queue_io_wait(map->bdev, map->ch, &mw->bdev_io_wait);
+	}
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to submit map write to %s, rc=%d\n",
+			    spdk_bdev_get_name(map->bdev), rc);
+		map->flags[mw->map_block] &= ~BDEV_MAP_WRITING;
+		free(mw);
+	}
+
+	return rc;
+}
+
+static void
+bdev_map_write_retry(void *arg)
+{
+	struct bdev_map_write *mw = arg;
+	struct spdk_bdev_map *map = mw->map;
+	uint64_t map_block = mw->map_block;
+
+	if (bdev_map_submit(mw) != 0) {
+		bdev_map_write_failed(map, map_block);
+	}
+}
+
+/* Waiters covering the block are failed if the write cannot be submitted */
+static int
+bdev_map_flush(struct spdk_bdev_map *map, uint64_t map_block)
+{
+	struct bdev_map_write *mw;
+	int rc;
+
+	if ((map->flags[map_block] & BDEV_MAP_WRITING) ||
+	    map->persisted[map_block] >= map->gen[map_block]) {
+		return 0;
+	}
+
+	mw = calloc(1, sizeof(*mw));
+	if (mw == NULL) {
+		SPDK_ERRLOG("Failed to allocate map write to %s\n", spdk_bdev_get_name(map->bdev));
+		rc = -ENOMEM;
+	} else {
+		mw->map = map;
+		mw->map_block = map_block;
+		mw->gen = map->gen[map_block];
+		map->flags[map_block] |= BDEV_MAP_WRITING;
+
+		rc = bdev_map_submit(mw);
+	}
+
+	if (rc != 0) {
+		bdev_map_write_failed(map, map_block);
+	}
+
+	return rc;
+}
+
+void
+spdk_bdev_map_persist(struct spdk_bdev_map *map, struct spdk_bdev_map_ctx *ctx,
+		      uint64_t first, uint64_t last, spdk_bdev_map_cb cb_fn, void *cb_arg)
+{
+	uint64_t mb;
+	bool failed = false;
+
+	assert(map->thread == spdk_get_thread());
+	assert(first <= last && last < map->num_blocks);
+
+	ctx->map = map;
+	ctx->first = first;
+	ctx->last = last;
+	ctx->seq = map->seq;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	if (bdev_map_ctx_persisted(ctx)) {
+		cb_fn(cb_arg, 0);
+		return;
+	}
+
+	for (mb = first; mb <= last; mb++) {
+		if (bdev_map_flush(map, mb) != 0) {
+			failed = true;
+		}
+	}
+
+	if (failed) {
+		cb_fn(cb_arg, -EIO);
+		return;
+	}
+
+	TAILQ_INSERT_TAIL(&map->waiters, ctx, link);
+}
+
+static void bdev_map_io_next(void *arg);
+
+static void
+bdev_map_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct bdev_map_io *io = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		io->cb_fn(io->cb_arg, -EIO);
+		free(io);
+		return;
+	}
+
+	io->offset += io->num_blocks;
+	bdev_map_io_next(io);
+}
+
+static void
+bdev_map_io_next(void *arg)
+{
+	struct bdev_map_io *io = arg;
+	struct spdk_bdev_map *map = io->map;
+	uint64_t max_blocks = spdk_max(BDEV_MAP_IO_SIZE / map->block_size, 1);
+	uint64_t offset_blocks;
+	void *buf;
+	int rc;
+
+	if (io->offset == map->num_blocks) {
+		io->cb_fn(io->cb_arg, 0);
+		free(io);
+		return;
+	}
+
+	io->num_blocks = spdk_min(max_blocks, map->num_blocks - io->offset);
+	buf = (uint8_t *)map->buf + io->offset * map->block_size;
+	offset_blocks = map->offset_blocks + io->offset;
+	if (io->write) {
+		rc = spdk_bdev_write_blocks(map->desc, map->ch, buf, offset_blocks, io->num_blocks,
+					    bdev_map_io_done, io);
+	} else {
+		rc = spdk_bdev_read_blocks(map->desc, map->ch, buf, offset_blocks, io->num_blocks,
+					   bdev_map_io_done, io);
+	}
+	if (rc == -ENOMEM) {
+		io->bdev_io_wait.bdev = map->bdev;
+		io->bdev_io_wait.cb_fn = bdev_map_io_next;
+		io->bdev_io_wait.cb_arg = io;
+		rc = spdk_bdev_queue_io_wait(map->bdev, map->ch, &io->bdev_io_wait);
+	}
+	if (rc != 0) {
+		io->cb_fn(io->cb_arg, rc);
+		free(io);
+	}
+}
+
+static void
+bdev_map_io(struct spdk_bdev_map *map, bool write, spdk_bdev_map_cb cb_fn, void *cb_arg)
+{
+	struct bdev_map_io *io;
+
+	assert(map->thread == spdk_get_thread());
+
+	io = calloc(1, sizeof(*io));
+	if (io == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	io->map = map;
+	io->write = write;
+	io->cb_fn = cb_fn;
+	io->cb_arg = cb_arg;
+
+	bdev_map_io_next(io);
+}
+
+void
+spdk_bdev_map_write(struct spdk_bdev_map *map, spdk_bdev_map_cb cb_fn, void *cb_arg)
+{
+	uint64_t mb;
+
+	/* Everything modified so far is written */
+	for (mb = 0; mb < map->num_blocks; mb++) {
+		map->persisted[mb] = map->gen[mb];
+	}
+
+	bdev_map_io(map, true, cb_fn, cb_arg);
+}
+
+void
+spdk_bdev_map_read(struct spdk_bdev_map *map, spdk_bdev_map_cb cb_fn, void *cb_arg)
+{
+	bdev_map_io(map, false, cb_fn, cb_arg);
+}
+
+static void
+bdev_map_base_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct spdk_bdev_map_ctx *ctx = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	ctx->cb_fn(ctx->cb_arg, success ? 0 : -EIO);
+}
+
+static void
+bdev_map_base_io(void *arg)
+{
+	struct spdk_bdev_map_ctx *ctx = arg;
+	struct spdk_bdev_map *map = ctx->map;
+	int rc;
+
+	if (ctx->io_type == SPDK_BDEV_IO_TYPE_RESET) {
+		rc = spdk_bdev_reset(map->desc, map->ch, bdev_map_base_io_done, ctx);
+	} else if (spdk_bdev_io_type_supported(map->bdev, SPDK_BDEV_IO_TYPE_FLUSH)) {
+		rc = spdk_bdev_flush_blocks(map->desc, map->ch, 0,
+					    spdk_bdev_get_num_blocks(map->bdev),
+					    bdev_map_base_io_done, ctx);
+	} else {
+		ctx->cb_fn(ctx->cb_arg, 0);
+		return;
+	}
+
+	if (rc == -ENOMEM) {
+		ctx->bdev_io_wait.bdev = map->bdev;
+		ctx->bdev_io_wait.cb_fn = bdev_map_base_io;
+		ctx->bdev_io_wait.cb_arg = ctx;
+		rc = spdk_bdev_queue_io_wait(map->bdev, map->ch, &ctx->bdev_io_wait);
+	}
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to submit I/O to %s, rc=%d\n",
+			    spdk_bdev_get_name(map->bdev), rc);
+		ctx->cb_fn(ctx->cb_arg, rc);
+	}
+}
+
+void
+spdk_bdev_map_submit_base_io(struct spdk_bdev_map *map, struct spdk_bdev_map_ctx *ctx,
+			     enum spdk_bdev_io_type type, spdk_bdev_map_cb cb_fn, void *cb_arg)
+{
+	assert(map->thread == spdk_get_thread());
+	assert(type == SPDK_BDEV_IO_TYPE_FLUSH || type == SPDK_BDEV_IO_TYPE_RESET);
+
+	ctx->map = map;
+	ctx->io_type = type;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	bdev_map_base_io(ctx);
+}
+
+static void
+bdev_map_examine_ctx_free(struct bdev_map_examine_ctx *ctx)
+{
+	if (ctx->ch != NULL) {
+		spdk_put_io_channel(ctx->ch);
+	}
+	if (ctx->desc != NULL) {
+		spdk_bdev_close(ctx->desc);
+	}
+	spdk_dma_free(ctx->buf);
+	free(ctx);
+}
+
+static void
+bdev_map_examine_read_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct bdev_map_examine_ctx *ctx = cb_arg;
+	struct spdk_bdev *bdev = bdev_io->bdev;
+
+	spdk_bdev_free_io(bdev_io);
+
+	/* The descriptor is closed first, as the callback may claim the bdev */
+	spdk_put_io_channel(ctx->ch);
+	ctx->ch = NULL;
+	spdk_bdev_close(ctx->desc);
+	ctx->desc = NULL;
+
+	ctx->cb_fn(ctx->cb_arg, bdev, ctx->buf, success ? 0 : -EIO);
+	bdev_map_examine_ctx_free(ctx);
+}
+
+static void
+bdev_map_examine_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev,
+			  void *event_ctx)
+{
+}
+
+int
+spdk_bdev_map_examine(struct spdk_bdev *bdev, spdk_bdev_map_examine_cb cb_fn, void *cb_arg)
+{
+	struct bdev_map_examine_ctx *ctx;
+	int rc;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	rc = spdk_bdev_open_ext(spdk_bdev_get_name(bdev), false, bdev_map_examine_event_cb, NULL,
+				&ctx->desc);
+	if (rc != 0) {
+		goto err;
+	}
+
+	ctx->ch = spdk_bdev_get_io_channel(ctx->desc);
+	ctx->buf = spdk_dma_malloc(spdk_bdev_get_block_size(bdev), spdk_bdev_get_buf_align(bdev),
+				   NULL);
+	if (ctx->ch == NULL || ctx->buf == NULL) {
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	rc = spdk_bdev_read_blocks(ctx->desc, ctx->ch, ctx->buf, 0, 1, bdev_map_examine_read_done,
+				   ctx);
+	if (rc != 0) {
+		goto err;
+	}
+
+	return 0;
+err:
+	bdev_map_examine_ctx_free(ctx);
+	return rc;
+}
@@ -30,7 +30,7 @@ static int bs_register_md_thread(struct spdk_blob_store *bs);
 static int bs_unregister_md_thread(struct spdk_blob_store *bs);
 static void blob_close_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno);
 static void blob_insert_cluster_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num,
-		uint64_t cluster, uint32_t extent, struct spdk_blob_md_page *page,
+		uint64_t cluster, uint32_t *extent, struct spdk_blob_md_page *page,
 		spdk_blob_op_complete cb_fn, void *cb_arg);
 static void blob_free_cluster_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num,
 		uint32_t extent_page, struct spdk_blob_md_page *page, spdk_blob_op_complete cb_fn, void *cb_arg);
@@ -40,6 +40,7 @@ static int blob_set_xattr(struct spdk_blob *blob, const char *name, const void *
 static int blob_get_xattr_value(struct spdk_blob *blob, const char *name,
 				const void **value, size_t *value_len, bool internal);
 static int blob_remove_xattr(struct spdk_blob *blob, const char *name, bool internal);
+static void blob_sync_md(struct spdk_blob *blob, spdk_blob_op_complete cb_fn, void *cb_arg);
 
 static void blob_write_extent_page(struct spdk_blob *blob, uint32_t extent, uint64_t cluster_num,
 				   struct spdk_blob_md_page *page, spdk_blob_op_complete cb_fn, void *cb_arg);
@@ -124,6 +125,72 @@ bs_release_md_page(struct spdk_blob_store *bs, uint32_t page)
 	spdk_bit_array_clear(bs->used_md_pages, page);
 }
 
+static void
+bs_release_cluster(struct spdk_blob_store *bs, uint32_t cluster_num)
+{
+	assert(spdk_spin_held(&bs->used_lock));
+	assert(cluster_num < spdk_bit_pool_capacity(bs->used_clusters));
+	assert(spdk_bit_pool_is_allocated(bs->used_clusters, cluster_num) == true);
+	assert(bs->num_free_clusters < bs->total_clusters);
+
+	SPDK_DEBUGLOG(blob, "Releasing cluster %u\n", cluster_num);
+
+	spdk_bit_pool_free_bit(bs->used_clusters, cluster_num);
+	bs->num_free_clusters++;
+}
+
+/*
+ * Pop a cluster from a channel pool. The channel's thread pops without used_lock, while other
+ * threads only pop with used_lock held. The pool is only pushed to by its channel's thread with
+ * used_lock held, so the entry read before a successful exchange of the count is still valid.
+ */
+static uint32_t
+bs_channel_cluster_pool_pop(struct spdk_bs_channel *ch)
+{
+	uint32_t count, cluster;
+
+	count = __atomic_load_n(&ch->cluster_pool_count, __ATOMIC_ACQUIRE);
+	do {
+		if (count == 0) {
+			return UINT32_MAX;
+		}
+		cluster = ch->cluster_pool[count - 1];
+	} while (!__atomic_compare_exchange_n(&ch->cluster_pool_count, &count, count - 1, false,
+					      __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+	__atomic_fetch_sub(&ch->bs->num_pooled_clusters, 1, __ATOMIC_RELAXED);
+
+	return cluster;
+}
+
+/* Return up to count clusters held in channel pools to the blobstore */
+static uint64_t
+bs_cluster_pools_reclaim(struct spdk_blob_store *bs, uint64_t count)
+{
+	struct spdk_bs_channel *ch;
+	uint64_t reclaimed = 0;
+	uint32_t cluster;
+
+	assert(spdk_spin_held(&bs->used_lock));
+
+	TAILQ_FOREACH(ch, &bs->cluster_pools, cluster_pool_link) {
+		while (reclaimed < count) {
+			cluster = bs_channel_cluster_pool_pop(ch);
+			if (cluster == UINT32_MAX) {
+				break;
+			}
+			bs_release_cluster(bs, cluster);
+			reclaimed++;
+		}
+	}
+
+	if (reclaimed > 0) {
+		SPDK_DEBUGLOG(blob, "Reclaimed %" PRIu64 " pooled clusters\n", reclaimed);
+	}
+
+	return reclaimed;
+}
+
 static uint32_t
 bs_claim_cluster(struct spdk_blob_store *bs)
 {
@@ -133,7 +200,12 @@ bs_claim_cluster(struct spdk_blob_store *bs)
 
 	cluster_num = spdk_bit_pool_allocate_bit(bs->used_clusters);
 	if (cluster_num == UINT32_MAX) {
-		return UINT32_MAX;
+		/* The last free clusters may be sitting in the pools of other channels */
+		if (bs_cluster_pools_reclaim(bs, 1) == 0) {
+			return UINT32_MAX;
+		}
+		cluster_num = spdk_bit_pool_allocate_bit(bs->used_clusters);
+		assert(cluster_num != UINT32_MAX);
 	}
 
 	SPDK_DEBUGLOG(blob, "Claiming cluster %u\n", cluster_num);
@@ -142,20 +214,6 @@ bs_claim_cluster(struct spdk_blob_store *bs)
 	return cluster_num;
 }
 
-static void
-bs_release_cluster(struct spdk_blob_store *bs, uint32_t cluster_num)
-{
-	assert(spdk_spin_held(&bs->used_lock));
-	assert(cluster_num < spdk_bit_pool_capacity(bs->used_clusters));
-	assert(spdk_bit_pool_is_allocated(bs->used_clusters, cluster_num) == true);
-	assert(bs->num_free_clusters < bs->total_clusters);
-
-	SPDK_DEBUGLOG(blob, "Releasing cluster %u\n", cluster_num);
-
-	spdk_bit_pool_free_bit(bs->used_clusters, cluster_num);
-	bs->num_free_clusters++;
-}
-
 static int
 blob_insert_cluster(struct spdk_blob *blob, uint32_t cluster_num, uint64_t cluster)
 {
@@ -345,6 +403,54 @@ xattrs_free(struct spdk_xattr_tailq *xattrs)
 	}
 }
 
+#define BLOB_FLAT_MAP_ZEROES	UINT64_MAX
+
+struct blob_flat_map {
+	/* Value of bs->flat_map_gen when the map was allocated */
+	uint64_t		gen;
+	uint64_t		num_clusters;
+	struct blob_flat_map	*next_retired;
+	/* LBA of the snapshot cluster holding the data, BLOB_FLAT_MAP_ZEROES if the cluster reads
+	 * as zeroes or 0 if it is not resolved yet. Accessed atomically by readers on any thread.
+	 */
+	uint64_t		lba[];
+};
+
+static void
+bs_flat_maps_clear(struct spdk_blob_store *bs)
+{
+	/* Clones further down the chain may have resolved clusters to a snapshot that is being
+	 * detached. The maps are in use by I/O on other threads, so they cannot be modified
+	 * here. Instead, move to a new generation, so that every lookup replaces its map,
+	 * including one racing with a resolve that stores an LBA from before the detach.
+	 */
+	__atomic_fetch_add(&bs->flat_map_gen, 1, __ATOMIC_SEQ_CST);
+}
+
+static void
+blob_flat_maps_free(struct blob_flat_map *map)
+{
+	struct blob_flat_map *next;
+
+	while (map != NULL) {
+		next = map->next_retired;
+		free(map);
+		map = next;
+	}
+}
+
+static void
+blob_flat_map_free(struct spdk_blob *blob)
+{
+	/* Only called with I/O to the blob frozen */
+	assert(blob->frozen_refcnt > 0);
+
+	free(blob->flat_map);
+	blob->flat_map = NULL;
+	blob_flat_maps_free(blob->flat_map_retired);
+	blob->flat_map_retired = NULL;
+}
+
 static void
 blob_unref_back_bs_dev(struct spdk_blob *blob)
 {
@@ -374,6 +480,8 @@ blob_free(struct spdk_blob *blob)
 		blob_unref_back_bs_dev(blob);
 	}
 
+	free(blob->flat_map);
+	blob_flat_maps_free(blob->flat_map_retired);
 	free(blob);
 }
 
@@ -418,7 +526,9 @@ blob_back_bs_destroy(struct spdk_blob *blob)
 
 	blob_esnap_destroy_bs_dev_channels(blob, false, blob_back_bs_destroy_esnap_done,
 					   blob->back_bs_dev);
-	blob->back_bs_dev = NULL;
+	/* Reads resolving a flat map may be walking the chain on another thread */
+	__atomic_store_n(&blob->back_bs_dev, NULL, __ATOMIC_RELEASE);
+	bs_flat_maps_clear(blob->bs);
 }
 
 struct blob_parent {
@@ -567,6 +677,8 @@ blob_unfreeze_io(struct spdk_blob *blob, spdk_blob_op_complete cb_fn, void *cb_a
 
 	assert(blob->frozen_refcnt > 0);
 
+	/* Operations changing the chain of snapshots of a blob freeze its I/O */
+	blob_flat_map_free(blob);
 	blob->frozen_refcnt--;
 
 	spdk_for_each_channel(blob->bs, blob_execute_queued_io, ctx, blob_io_cpl);
@@ -2291,6 +2403,11 @@ blob_resize(struct spdk_blob *blob, uint64_t sz)
 	 */
 	if (sz > num_clusters && spdk_blob_is_thin_provisioned(blob) == false) {
 		spdk_spin_lock(&bs->used_lock);
+		if ((sz - num_clusters) > bs->num_free_clusters) {
+			/* Channels can pop pooled clusters at any time, so move the missing ones
+			 * back to the blobstore while the lock is held. */
+			bs_cluster_pools_reclaim(bs, sz - num_clusters - bs->num_free_clusters);
+		}
 		if ((sz - num_clusters) > bs->num_free_clusters) {
 			rc = -ENOSPC;
 			goto out;
@@ -2650,6 +2767,8 @@ struct spdk_blob_copy_cluster_ctx {
 	uint32_t new_extent_page;
 	spdk_bs_sequence_t *seq;
 	struct spdk_blob_md_page *new_cluster_page;
+	spdk_blob_op_complete cb_fn;
+	void *cb_arg;
 };
 
 struct spdk_blob_free_cluster_ctx {
@@ -2664,15 +2783,25 @@ struct spdk_blob_free_cluster_ctx {
 };
 
 static void
-blob_allocate_and_copy_cluster_cpl(void *cb_arg, int bserrno)
+blob_copy_cluster_cpl(void *cb_arg, int bserrno)
 {
 	struct spdk_blob_copy_cluster_ctx *ctx = cb_arg;
-	struct spdk_bs_request_set *set = (struct spdk_bs_request_set *)ctx->seq;
+
+	ctx->cb_fn(ctx->cb_arg, bserrno);
+
+	spdk_free(ctx->buf);
+	free(ctx);
+}
+
+static void
+blob_allocate_and_copy_cluster_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_bs_channel *ch = cb_arg;
 	TAILQ_HEAD(, spdk_bs_request_set) requests;
 	spdk_bs_user_op_t *op;
 
 	TAILQ_INIT(&requests);
-	TAILQ_SWAP(&set->channel->need_cluster_alloc, &requests, spdk_bs_request_set, link);
+	TAILQ_SWAP(&ch->need_cluster_alloc, &requests, spdk_bs_request_set, link);
 
 	while (!TAILQ_EMPTY(&requests)) {
 		op = TAILQ_FIRST(&requests);
@@ -2683,9 +2812,6 @@ blob_allocate_and_copy_cluster_cpl(void *cb_arg, int bserrno)
 			bs_user_op_abort(op, bserrno);
 		}
 	}
-
-	spdk_free(ctx->buf);
-	free(ctx);
 }
 
 static void
@@ -2816,7 +2942,7 @@ blob_write_copy_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 	cluster_number = bs_io_unit_to_cluster(ctx->blob->bs, ctx->io_unit);
 
 	blob_insert_cluster_on_md_thread(ctx->blob, cluster_number, ctx->new_cluster,
-					 ctx->new_extent_page, ctx->new_cluster_page, blob_insert_cluster_cpl, ctx);
+					 &ctx->new_extent_page, ctx->new_cluster_page, blob_insert_cluster_cpl, ctx);
 }
 
 static void
@@ -2847,7 +2973,7 @@ blob_can_copy(struct spdk_blob *blob, uint64_t cluster_start_io_unit, uint64_t *
 }
 
 static void
-blob_copy(struct spdk_blob_copy_cluster_ctx *ctx, spdk_bs_user_op_t *op, uint64_t src_lba)
+blob_copy(struct spdk_blob_copy_cluster_ctx *ctx, uint64_t src_lba)
 {
 	struct spdk_blob *blob = ctx->blob;
 	uint64_t lba_count = bs_dev_byte_to_lba(blob->back_bs_dev, blob->bs->cluster_sz);
@@ -2860,9 +2986,91 @@ blob_copy(struct spdk_blob_copy_cluster_ctx *ctx, spdk_bs_user_op_t *op, uint64_
 }
 
 static void
-bs_allocate_and_copy_cluster(struct spdk_blob *blob,
-			     struct spdk_io_channel *_ch,
-			     uint64_t io_unit, spdk_bs_user_op_t *op)
+bs_channel_cluster_pool_refill_msg(void *arg)
+{
+	struct spdk_io_channel *_ch = arg;
+	struct spdk_bs_channel *ch = spdk_io_channel_get_ctx(_ch);
+	struct spdk_blob_store *bs = ch->bs;
+
+	spdk_spin_lock(&bs->used_lock);
+	/* Leave the last clusters of a nearly full blobstore to whichever channel needs them */
+	while (ch->cluster_pool_count < bs->channel_cluster_pool_size &&
+	       bs->num_free_clusters > bs->channel_cluster_pool_size) {
+		ch->cluster_pool[ch->cluster_pool_count] = bs_claim_cluster(bs);
+		/* Publish the entry before other threads reclaiming clusters can pop it */
+		__atomic_store_n(&ch->cluster_pool_count, ch->cluster_pool_count + 1,
+				 __ATOMIC_RELEASE);
+		__atomic_fetch_add(&bs->num_pooled_clusters, 1, __ATOMIC_RELAXED);
+	}
+	spdk_spin_unlock(&bs->used_lock);
+
+	ch->cluster_pool_refilling = false;
+	spdk_put_io_channel(_ch);
+}
+
+static void
+bs_channel_cluster_pool_refill(struct spdk_bs_channel *ch)
+{
+	struct spdk_io_channel *_ch;
+
+	if (ch->cluster_pool_refilling) {
+		return;
+	}
+
+	/* Hold a reference, so that the channel is still there once the refill runs */
+	_ch = spdk_get_io_channel(ch->bs);
+	if (_ch == NULL) {
+		return;
+	}
+	assert(spdk_io_channel_get_ctx(_ch) == ch);
+
+	ch->cluster_pool_refilling = true;
+	spdk_thread_send_msg(spdk_get_thread(), bs_channel_cluster_pool_refill_msg, _ch);
+}
+
+static int
+bs_channel_allocate_cluster(struct spdk_bs_channel *ch, struct spdk_blob *blob,
+			    uint32_t cluster_num, uint64_t *cluster, uint32_t *lowest_free_md_page)
+{
+	struct spdk_blob_store *bs = blob->bs;
+	int rc = 0;
+
+	/* A new extent page has to be claimed from the blobstore anyway */
+	if (ch->cluster_pool == NULL ||
+	    (blob->use_extent_table && *bs_cluster_to_extent_page(blob, cluster_num) == 0)) {
+		*cluster = UINT32_MAX;
+	} else {
+		*cluster = bs_channel_cluster_pool_pop(ch);
+	}
+
+	if (*cluster == UINT32_MAX) {
+		spdk_spin_lock(&bs->used_lock);
+		rc = bs_allocate_cluster(blob, cluster_num, cluster, lowest_free_md_page, false);
+		spdk_spin_unlock(&bs->used_lock);
+	} else {
+		SPDK_DEBUGLOG(blob, "Claiming pooled cluster %" PRIu64 " for blob 0x%" PRIx64 "\n",
+			      *cluster, blob->id);
+	}
+
+	if (ch->cluster_pool != NULL &&
+	    __atomic_load_n(&ch->cluster_pool_count, __ATOMIC_RELAXED) <=
+	    bs->channel_cluster_pool_size / 2) {
+		bs_channel_cluster_pool_refill(ch);
+	}
+
+	return rc;
+}
+
+/*
+ * Allocate the cluster holding io_unit and copy its data from the back_bs_dev. new_cluster_page
+ * is used to update the extent page on the metadata thread and must not be shared by cluster
+ * copies in flight. Returns an error if the copy could not be started, otherwise cb_fn is
+ * called once the cluster is inserted into the blob.
+ */
+static int
+blob_copy_cluster(struct spdk_blob *blob, struct spdk_io_channel *_ch, uint64_t io_unit,
+		  struct spdk_blob_md_page *new_cluster_page,
+		  spdk_blob_op_complete cb_fn, void *cb_arg)
 {
 	struct spdk_bs_cpl cpl;
 	struct spdk_bs_channel *ch;
@@ -2877,14 +3085,6 @@ bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 
 	ch = spdk_io_channel_get_ctx(_ch);
 
-	if (!TAILQ_EMPTY(&ch->need_cluster_alloc)) {
-		/* There are already operations pending. Queue this user op
-		 * and return because it will be re-executed when the outstanding
-		 * cluster allocation completes. */
-		TAILQ_INSERT_TAIL(&ch->need_cluster_alloc, op, link);
-		return;
-	}
-
 	/* Round the io_unit offset down to the first io_unit in the cluster */
 	cluster_start_io_unit = bs_io_unit_to_cluster_start(blob, io_unit);
 
@@ -2894,15 +3094,16 @@ bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 
 	ctx = calloc(1, sizeof(*ctx));
 	if (!ctx) {
-		bs_user_op_abort(op, -ENOMEM);
-		return;
+		return -ENOMEM;
 	}
 
 	assert(blob->bs->cluster_sz % blob->back_bs_dev->blocklen == 0);
 
 	ctx->blob = blob;
 	ctx->io_unit = cluster_start_io_unit;
-	ctx->new_cluster_page = ch->new_cluster_page;
+	ctx->new_cluster_page = new_cluster_page;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
 
 	/* Check if the cluster that we intend to do CoW for is valid for
 	 * the backing dev. For zeroes backing dev, it'll be always valid.
@@ -2924,24 +3125,20 @@ bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 			SPDK_ERRLOG("DMA allocation for cluster of size = %" PRIu32 " failed.\n",
 				    blob->bs->cluster_sz);
 			free(ctx);
-			bs_user_op_abort(op, -ENOMEM);
-			return;
+			return -ENOMEM;
 		}
 	}
 
-	spdk_spin_lock(&blob->bs->used_lock);
-	rc = bs_allocate_cluster(blob, cluster_number, &ctx->new_cluster, &ctx->new_extent_page,
-				 false);
-	spdk_spin_unlock(&blob->bs->used_lock);
+	rc = bs_channel_allocate_cluster(ch, blob, cluster_number, &ctx->new_cluster,
+					 &ctx->new_extent_page);
 	if (rc != 0) {
 		spdk_free(ctx->buf);
 		free(ctx);
-		bs_user_op_abort(op, rc);
-		return;
+		return rc;
 	}
 
 	cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
-	cpl.u.blob_basic.cb_fn = blob_allocate_and_copy_cluster_cpl;
+	cpl.u.blob_basic.cb_fn = blob_copy_cluster_cpl;
 	cpl.u.blob_basic.cb_arg = ctx;
 
 	ctx->seq = bs_sequence_start_blob(_ch, &cpl, blob);
@@ -2951,16 +3148,12 @@ bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 		spdk_spin_unlock(&blob->bs->used_lock);
 		spdk_free(ctx->buf);
 		free(ctx);
-		bs_user_op_abort(op, -ENOMEM);
-		return;
+		return -ENOMEM;
 	}
 
-	/* Queue the user op to block other incoming operations */
-	TAILQ_INSERT_TAIL(&ch->need_cluster_alloc, op, link);
-
 	if (blob->parent_id != SPDK_BLOBID_INVALID && !is_zeroes) {
 		if (can_copy) {
-			blob_copy(ctx, op, copy_src_lba);
+			blob_copy(ctx, copy_src_lba);
 		} else {
 			/* Read cluster from backing device */
 			bs_sequence_read_bs_dev(ctx->seq, blob->back_bs_dev, ctx->buf,
@@ -2971,7 +3164,33 @@ bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 
 	} else {
 		blob_insert_cluster_on_md_thread(ctx->blob, cluster_number, ctx->new_cluster,
-						 ctx->new_extent_page, ctx->new_cluster_page, blob_insert_cluster_cpl, ctx);
+						 &ctx->new_extent_page, ctx->new_cluster_page, blob_insert_cluster_cpl, ctx);
+	}
+
+	return 0;
+}
+
+static void
+bs_allocate_and_copy_cluster(struct spdk_blob *blob,
+			     struct spdk_io_channel *_ch,
+			     uint64_t io_unit, spdk_bs_user_op_t *op)
+{
+	struct spdk_bs_channel *ch = spdk_io_channel_get_ctx(_ch);
+	bool pending = !TAILQ_EMPTY(&ch->need_cluster_alloc);
+	int rc;
+
+	/* Queue the user op to block other incoming operations. If there are already operations
+	 * pending, it will be re-executed when the outstanding cluster allocation completes. */
+	TAILQ_INSERT_TAIL(&ch->need_cluster_alloc, op, link);
+	if (pending) {
+		return;
+	}
+
+	rc = blob_copy_cluster(blob, _ch, io_unit, ch->new_cluster_page,
+			       blob_allocate_and_copy_cluster_cpl, ch);
+	if (rc != 0) {
+		TAILQ_REMOVE(&ch->need_cluster_alloc, op, link);
+		bs_user_op_abort(op, rc);
 	}
 }
 
@@ -2992,6 +3211,137 @@ blob_calculate_lba_and_lba_count(struct spdk_blob *blob, uint64_t io_unit, uint6
 	}
 }
 
+static uint64_t
+blob_flat_map_resolve(struct spdk_blob *blob, uint32_t cluster_num)
+{
+	struct spdk_bs_dev *back_bs_dev;
+	struct spdk_blob *parent;
+
+	/* All snapshots in the chain belong to the same blobstore, so a cluster has the same
+	 * number in each of them. */
+	while (blob->parent_id != SPDK_BLOBID_INVALID &&
+	       blob->parent_id != SPDK_BLOBID_EXTERNAL_SNAPSHOT) {
+		back_bs_dev = __atomic_load_n(&blob->back_bs_dev, __ATOMIC_ACQUIRE);
+		if (spdk_unlikely(back_bs_dev == NULL)) {
+			/* The chain is being changed, read through the back_bs_dev */
+			return 0;
+		}
+		parent = ((struct spdk_blob_bs_dev *)back_bs_dev)->blob;
+		if (cluster_num >= parent->active.num_clusters) {
+			/* The snapshot is smaller than its clone */
+			return BLOB_FLAT_MAP_ZEROES;
+		}
+		if (parent->active.clusters[cluster_num] != 0) {
+			return parent->active.clusters[cluster_num];
+		}
+		blob = parent;
+	}
+
+	if (blob_backed_with_zeroes_dev(blob)) {
+		return BLOB_FLAT_MAP_ZEROES;
+	}
+
+	/* The data comes from an external snapshot, which is read through the chain */
+	return 0;
+}
+
+static struct blob_flat_map *
+blob_flat_map_replace(struct spdk_blob *blob, struct blob_flat_map *old, uint64_t gen)
+{
+	struct blob_flat_map *map, *expected = old;
+
+	if (old != NULL && old->gen > gen) {
+		/* Another thread already moved to a newer generation than the one loaded here */
+		return NULL;
+	}
+
+	/* The map is allocated by the first read after each change of the generation, which
+	 * can happen on any thread.
+	 */
+	map = calloc(1, sizeof(*map) + blob->active.num_clusters * sizeof(map->lba[0]));
+	if (map == NULL) {
+		return NULL;
+	}
+	map->gen = gen;
+	map->num_clusters = blob->active.num_clusters;
+
+	if (!__atomic_compare_exchange_n(&blob->flat_map, &expected, map, false,
+					 __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+		free(map);
+		return expected != NULL && expected->gen == gen ? expected : NULL;
+	}
+
+	if (old != NULL) {
+		/* Reads on other threads may still be using the old map */
+		expected = __atomic_load_n(&blob->flat_map_retired, __ATOMIC_RELAXED);
+		do {
+			old->next_retired = expected;
+		} while (!__atomic_compare_exchange_n(&blob->flat_map_retired, &expected, old, false,
+						      __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+	}
+
+	return map;
+}
+
+/*
+ * Look up an unallocated io_unit of a clone in its flattened map, so that it is read directly
+ * from the snapshot that owns the cluster instead of descending the chain one back_bs_dev at a
+ * time. Returns false if the io_unit has to be read through the back_bs_dev.
+ */
+static bool
+blob_flat_map_lookup(struct spdk_blob *blob, uint64_t io_unit, uint64_t length,
+		     uint64_t *lba, uint64_t *lba_count, bool *is_zeroes)
+{
+	struct blob_flat_map *map;
+	uint32_t cluster_num;
+	uint64_t cluster_lba, gen;
+
+	if (blob->parent_id == SPDK_BLOBID_INVALID ||
+	    blob->parent_id == SPDK_BLOBID_EXTERNAL_SNAPSHOT) {
+		return false;
+	}
+
+	/* The generation has to be loaded before the map, so that a map allocated for a newer
+	 * generation is never replaced with one for an older generation.
+	 */
+	gen = __atomic_load_n(&blob->bs->flat_map_gen, __ATOMIC_ACQUIRE);
+	map = __atomic_load_n(&blob->flat_map, __ATOMIC_ACQUIRE);
+	if (spdk_unlikely(map == NULL || map->gen != gen)) {
+		map = blob_flat_map_replace(blob, map, gen);
+		if (map == NULL) {
+			return false;
+		}
+	}
+
+	cluster_num = bs_io_unit_to_cluster_number(blob, io_unit);
+	if (spdk_unlikely(cluster_num >= map->num_clusters)) {
+		return false;
+	}
+
+	cluster_lba = __atomic_load_n(&map->lba[cluster_num], __ATOMIC_RELAXED);
+	if (cluster_lba == 0) {
+		cluster_lba = blob_flat_map_resolve(blob, cluster_num);
+		if (cluster_lba == 0) {
+			return false;
+		}
+		/* If the chain changed while resolving, the generation has moved on and the next
+		 * lookup replaces this map, dropping the stale LBA.
+		 */
+		__atomic_store_n(&map->lba[cluster_num], cluster_lba, __ATOMIC_RELAXED);
+	}
+
+	*is_zeroes = cluster_lba == BLOB_FLAT_MAP_ZEROES;
+	if (*is_zeroes) {
+		*lba = 0;
+		*lba_count = length * (blob->bs->io_unit_size / bs_create_zeroes_dev()->blocklen);
+	} else {
+		*lba = cluster_lba + io_unit % blob->bs->io_units_per_cluster;
+		*lba_count = length;
+	}
+
+	return true;
+}
+
 struct op_split_ctx {
 	struct spdk_blob *blob;
 	struct spdk_io_channel *channel;
@@ -3172,6 +3522,7 @@ blob_request_submit_op_single(struct spdk_io_channel *_ch, struct spdk_blob *blo
 	uint64_t lba;
 	uint64_t lba_count;
 	bool is_allocated;
+	bool is_zeroes;
 
 	assert(blob != NULL);
 
@@ -3210,6 +3561,15 @@ blob_request_submit_op_single(struct spdk_io_channel *_ch, struct spdk_blob *blo
 		if (is_allocated) {
 			/* Read from the blob */
 			bs_batch_read_dev(batch, payload, lba, lba_count);
+		} else if (blob_flat_map_lookup(blob, offset, length, &lba, &lba_count,
+						&is_zeroes)) {
+			/* Read from the snapshot that owns the cluster */
+			if (is_zeroes) {
+				bs_batch_read_bs_dev(batch, bs_create_zeroes_dev(), payload,
+						     lba, lba_count);
+			} else {
+				bs_batch_read_dev(batch, payload, lba, lba_count);
+			}
 		} else {
 			/* Read from the backing block device */
 			bs_batch_read_bs_dev(batch, blob->back_bs_dev, payload, lba, lba_count);
@@ -3507,6 +3867,7 @@ blob_request_submit_rw_iov(struct spdk_blob *blob, struct spdk_io_channel *_chan
 		uint64_t lba_count;
 		uint64_t lba;
 		bool is_allocated;
+		bool is_zeroes;
 
 		cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
 		cpl.u.blob_basic.cb_fn = cb_fn;
@@ -3545,6 +3906,17 @@ blob_request_submit_rw_iov(struct spdk_blob *blob, struct spdk_io_channel *_chan
 
 			if (is_allocated) {
 				bs_sequence_readv_dev(seq, iov, iovcnt, lba, lba_count, rw_iov_done, NULL);
+			} else if (blob_flat_map_lookup(blob, offset, length, &lba, &lba_count,
+							&is_zeroes)) {
+				/* Read from the snapshot that owns the cluster */
+				if (is_zeroes) {
+					bs_sequence_readv_bs_dev(seq, bs_create_zeroes_dev(), iov,
+								 iovcnt, lba, lba_count,
+								 rw_iov_done, NULL);
+				} else {
+					bs_sequence_readv_dev(seq, iov, iovcnt, lba, lba_count,
+							      rw_iov_done, NULL);
+				}
 			} else {
 				bs_sequence_readv_bs_dev(seq, blob->back_bs_dev, iov, iovcnt, lba, lba_count,
 							 rw_iov_done, NULL);
@@ -3696,6 +4068,24 @@ bs_channel_create(void *io_device, void *ctx_buf)
 		return -1;
 	}
 
+	if (bs->channel_cluster_pool_size > 0) {
+		channel->cluster_pool = calloc(bs->channel_cluster_pool_size,
+					       sizeof(*channel->cluster_pool));
+		if (!channel->cluster_pool) {
+			SPDK_ERRLOG("Failed to allocate cluster pool\n");
+			spdk_free(channel->release_cluster_page);
+			spdk_free(channel->new_cluster_page);
+			free(channel->req_mem);
+			channel->dev->destroy_channel(channel->dev, channel->dev_channel);
+			return -1;
+		}
+
+		/* The pool is filled on the first allocation */
+		spdk_spin_lock(&bs->used_lock);
+		TAILQ_INSERT_TAIL(&bs->cluster_pools, channel, cluster_pool_link);
+		spdk_spin_unlock(&bs->used_lock);
+	}
+
 	TAILQ_INIT(&channel->need_cluster_alloc);
 	TAILQ_INIT(&channel->queued_io);
 	TAILQ_INIT(&channel->pending_free_cluster);
@@ -3710,6 +4100,7 @@ bs_channel_destroy(void *io_device, void *ctx_buf)
 {
 	struct spdk_bs_channel *channel = ctx_buf;
 	spdk_bs_user_op_t *op;
+	uint32_t cluster;
 
 	while (!TAILQ_EMPTY(&channel->need_cluster_alloc)) {
 		op = TAILQ_FIRST(&channel->need_cluster_alloc);
@@ -3725,6 +4116,16 @@ bs_channel_destroy(void *io_device, void *ctx_buf)
 
 	blob_esnap_destroy_bs_channel(channel);
 
+	if (channel->cluster_pool != NULL) {
+		spdk_spin_lock(&channel->bs->used_lock);
+		while ((cluster = bs_channel_cluster_pool_pop(channel)) != UINT32_MAX) {
+			bs_release_cluster(channel->bs, cluster);
+		}
+		TAILQ_REMOVE(&channel->bs->cluster_pools, channel, cluster_pool_link);
+		spdk_spin_unlock(&channel->bs->used_lock);
+		free(channel->cluster_pool);
+	}
+
 	free(channel->req_mem);
 	spdk_free(channel->new_cluster_page);
 	spdk_free(channel->release_cluster_page);
@@ -3897,6 +4298,7 @@ spdk_bs_opts_init(struct spdk_bs_opts *opts, size_t opts_size)
 	SET_FIELD(force_recover, false);
 	SET_FIELD(esnap_bs_dev_create, NULL);
 	SET_FIELD(esnap_ctx, NULL);
+	SET_FIELD(channel_cluster_pool_size, 0);
 
 #undef FIELD_OK
 #undef SET_FIELD
@@ -4043,6 +4445,8 @@ bs_alloc(struct spdk_bs_dev *dev, struct spdk_bs_opts *opts, struct spdk_blob_st
 	bs_init_per_cluster_fields(bs);
 
 	bs->max_channel_ops = opts->max_channel_ops;
+	bs->channel_cluster_pool_size = opts->channel_cluster_pool_size;
+	TAILQ_INIT(&bs->cluster_pools);
 	bs->super_blob = SPDK_BLOBID_INVALID;
 	memcpy(&bs->bstype, &opts->bstype, sizeof(opts->bstype));
 	bs->esnap_bs_dev_create = opts->esnap_bs_dev_create;
@@ -4094,7 +4498,9 @@ static void
 bs_write_used_clusters(spdk_bs_sequence_t *seq, void *arg, spdk_bs_sequence_cpl cb_fn)
 {
 	struct spdk_bs_load_ctx	*ctx = arg;
+	struct spdk_bs_channel	*channel;
 	uint64_t	mask_size, lba, lba_count;
+	uint32_t	i, cluster, count;
 
 	/* Write out the used clusters mask */
 	mask_size = ctx->super->used_cluster_mask_len * ctx->bs->md_page_size;
@@ -4114,7 +4520,17 @@ bs_write_used_clusters(spdk_bs_sequence_t *seq, void *arg, spdk_bs_sequence_cpl
 	 */
 	if (ctx->bs->used_clusters) {
 		assert(ctx->mask->length == spdk_bit_pool_capacity(ctx->bs->used_clusters));
+		spdk_spin_lock(&ctx->bs->used_lock);
 		spdk_bit_pool_store_mask(ctx->bs->used_clusters, ctx->mask->mask);
+		/* Clusters held in channel pools don't belong to any blob yet */
+		TAILQ_FOREACH(channel, &ctx->bs->cluster_pools, cluster_pool_link) {
+			count = __atomic_load_n(&channel->cluster_pool_count, __ATOMIC_ACQUIRE);
+			for (i = 0; i < count; i++) {
+				cluster = channel->cluster_pool[i];
+				ctx->mask->mask[cluster / 8] &= ~(1U << (cluster % 8));
+			}
+		}
+		spdk_spin_unlock(&ctx->bs->used_lock);
 	} else {
 		assert(ctx->mask->length == spdk_bit_array_capacity(ctx->used_clusters));
 		spdk_bit_array_store_mask(ctx->used_clusters, ctx->mask->mask);
@@ -5099,12 +5515,13 @@ bs_opts_copy(struct spdk_bs_opts *src, struct spdk_bs_opts *dst)
 	SET_FIELD(force_recover);
 	SET_FIELD(esnap_bs_dev_create);
 	SET_FIELD(esnap_ctx);
+	SET_FIELD(channel_cluster_pool_size);
 
 	dst->opts_size = src->opts_size;
 
 	/* You should not remove this statement, but need to update the assert statement
 	 * if you add a new field, and also add a corresponding SET_FIELD statement */
-	SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_opts) == 88, "Incorrect size");
+	SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_opts) == 92, "Incorrect size");
 
 #undef FIELD_OK
 #undef SET_FIELD
@@ -6201,7 +6618,8 @@ spdk_bs_get_io_unit_size(struct spdk_blob_store *bs)
 uint64_t
 spdk_bs_free_cluster_count(struct spdk_blob_store *bs)
 {
-	return bs->num_free_clusters;
+	/* Clusters held in channel pools can be reclaimed by any allocation */
+	return bs->num_free_clusters + __atomic_load_n(&bs->num_pooled_clusters, __ATOMIC_RELAXED);
 }
 
 uint64_t
@@ -6502,6 +6920,13 @@ spdk_bs_create_blob_ext(struct spdk_blob_store *bs, const struct spdk_blob_opts
 
 /* START blob_cleanup */
 
+struct bs_inflate_slot {
+	struct spdk_clone_snapshot_ctx	*ctx;
+	/* Extent page buffer of the cluster copy using this slot */
+	struct spdk_blob_md_page	*page;
+	bool				busy;
+};
+
 struct spdk_clone_snapshot_ctx {
 	struct spdk_bs_cpl      cpl;
 	int bserrno;
@@ -6516,6 +6941,28 @@ struct spdk_clone_snapshot_ctx {
 	 * thin-provisioning. Otherwise only decouple parent and keep clone thin. */
 	bool allocate_all;
 
+	struct {
+		struct bs_inflate_slot		*slots;
+		uint32_t			num_slots;
+		uint32_t			in_flight;
+		uint64_t			copied_clusters;
+		uint64_t			total_clusters;
+		/* copied_clusters at the time of the last checkpoint */
+		uint64_t			checkpoint_clusters;
+		bool				checkpoint_in_progress;
+		bool				stop;
+		int				bserrno;
+		/* Cluster copy budget, refilled over time when the inflate is rate limited */
+		bool				rate_limited;
+		double				clusters_per_tsc;
+		double				clusters_max;
+		double				clusters_available;
+		uint64_t			last_tsc;
+		struct spdk_poller		*poller;
+		spdk_blob_inflate_status	status_cb_fn;
+		void				*status_cb_arg;
+	} inflate;
+
 	struct {
 		spdk_blob_id id;
 		struct spdk_blob *blob;
@@ -6532,10 +6979,21 @@ struct spdk_clone_snapshot_ctx {
 };
 
 static void
-bs_clone_snapshot_cleanup_finish(void *cb_arg, int bserrno)
+bs_inflate_slots_free(struct spdk_clone_snapshot_ctx *ctx)
 {
-	struct spdk_clone_snapshot_ctx *ctx = cb_arg;
-	struct spdk_bs_cpl *cpl = &ctx->cpl;
+	uint32_t i;
+
+	for (i = 0; i < ctx->inflate.num_slots; i++) {
+		spdk_free(ctx->inflate.slots[i].page);
+	}
+	free(ctx->inflate.slots);
+}
+
+static void
+bs_clone_snapshot_cleanup_finish(void *cb_arg, int bserrno)
+{
+	struct spdk_clone_snapshot_ctx *ctx = cb_arg;
+	struct spdk_bs_cpl *cpl = &ctx->cpl;
 
 	if (bserrno != 0) {
 		if (ctx->bserrno != 0) {
@@ -6557,6 +7015,7 @@ bs_clone_snapshot_cleanup_finish(void *cb_arg, int bserrno)
 		break;
 	}
 
+	bs_inflate_slots_free(ctx);
 	free(ctx);
 }
 
@@ -7080,6 +7539,19 @@ spdk_bs_create_clone(struct spdk_blob_store *bs, spdk_blob_id blobid,
 
 /* START spdk_bs_inflate_blob */
 
+/* Number of copied clusters after which the progress of an inflate is persisted */
+#define BLOB_INFLATE_CHECKPOINT_CLUSTERS	64
+#define BLOB_INFLATE_POLL_PERIOD_US		1000
+
+/* Value of the BLOB_INFLATE_PROGRESS xattr */
+struct blob_inflate_progress {
+	uint64_t	copied_clusters;
+	uint64_t	total_clusters;
+	uint8_t		allocate_all;
+	uint8_t		reserved[7];
+};
+SPDK_STATIC_ASSERT(sizeof(struct blob_inflate_progress) == 24, "Incorrect size");
+
 static void
 bs_inflate_blob_set_parent_cpl(void *cb_arg, struct spdk_blob *_parent, int bserrno)
 {
@@ -7118,6 +7590,10 @@ bs_inflate_blob_done(struct spdk_clone_snapshot_ctx *ctx)
 	struct spdk_blob *_blob = ctx->original.blob;
 	struct spdk_blob *_parent;
 
+	/* Temporarily override md_ro flag for MD modification */
+	_blob->md_ro = false;
+	blob_remove_xattr(_blob, BLOB_INFLATE_PROGRESS, true);
+
 	if (ctx->allocate_all) {
 		/* remove thin provisioning */
 		bs_blob_list_remove(_blob);
@@ -7182,55 +7658,207 @@ bs_cluster_needs_allocation(struct spdk_blob *blob, uint64_t cluster, bool alloc
 	return (allocate_all || b->blob->active.clusters[cluster] != 0);
 }
 
+static void bs_inflate_blob_touch_next(void *cb_arg, int bserrno);
+
+static void
+bs_inflate_blob_checkpoint(struct spdk_clone_snapshot_ctx *ctx, spdk_blob_op_complete cb_fn)
+{
+	struct spdk_blob *_blob = ctx->original.blob;
+	struct blob_inflate_progress progress = {
+		.copied_clusters = ctx->inflate.copied_clusters,
+		.total_clusters = ctx->inflate.total_clusters,
+		.allocate_all = ctx->allocate_all,
+	};
+	int rc;
+
+	ctx->inflate.checkpoint_in_progress = true;
+	ctx->inflate.checkpoint_clusters = ctx->inflate.copied_clusters;
+
+	/* Temporarily override md_ro flag for MD modification */
+	_blob->md_ro = false;
+	rc = blob_set_xattr(_blob, BLOB_INFLATE_PROGRESS, &progress, sizeof(progress), true);
+	_blob->md_ro = ctx->original.md_ro;
+	if (rc != 0) {
+		cb_fn(ctx, rc);
+		return;
+	}
+
+	/* Clusters still being copied are persisted by their own metadata updates */
+	blob_sync_md(_blob, cb_fn, ctx);
+}
+
+static void
+bs_inflate_blob_checkpoint_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_clone_snapshot_ctx *ctx = cb_arg;
+
+	ctx->inflate.checkpoint_in_progress = false;
+	bs_inflate_blob_touch_next(ctx, bserrno);
+}
+
+static void
+bs_inflate_blob_stop_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_clone_snapshot_ctx *ctx = cb_arg;
+
+	ctx->inflate.checkpoint_in_progress = false;
+	if (bserrno != 0) {
+		SPDK_ERRLOG("blob 0x%" PRIx64 ": Failed to persist inflate progress: %d\n",
+			    ctx->original.id, bserrno);
+	}
+
+	bs_clone_snapshot_origblob_cleanup(ctx, ctx->inflate.bserrno ? : -ECANCELED);
+}
+
+static bool
+bs_inflate_blob_consume_token(struct spdk_clone_snapshot_ctx *ctx)
+{
+	uint64_t now;
+
+	if (!ctx->inflate.rate_limited) {
+		return true;
+	}
+
+	now = spdk_get_ticks();
+	ctx->inflate.clusters_available += (now - ctx->inflate.last_tsc) *
+					   ctx->inflate.clusters_per_tsc;
+	ctx->inflate.clusters_available = spdk_min(ctx->inflate.clusters_max,
+					  ctx->inflate.clusters_available);
+	ctx->inflate.last_tsc = now;
+	if (ctx->inflate.clusters_available > 0.0) {
+		ctx->inflate.clusters_available -= 1.0;
+		return true;
+	}
+
+	return false;
+}
+
+static int
+bs_inflate_blob_poll(void *arg)
+{
+	struct spdk_clone_snapshot_ctx *ctx = arg;
+
+	spdk_poller_unregister(&ctx->inflate.poller);
+	bs_inflate_blob_touch_next(ctx, 0);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+bs_inflate_blob_copy_cpl(void *cb_arg, int bserrno)
+{
+	struct bs_inflate_slot *slot = cb_arg;
+	struct spdk_clone_snapshot_ctx *ctx = slot->ctx;
+
+	slot->busy = false;
+	ctx->inflate.in_flight--;
+
+	if (bserrno == 0) {
+		ctx->inflate.copied_clusters++;
+		if (ctx->inflate.status_cb_fn != NULL) {
+			ctx->inflate.status_cb_fn(ctx->inflate.copied_clusters,
+						  ctx->inflate.total_clusters,
+						  ctx->inflate.status_cb_arg);
+		}
+	}
+
+	bs_inflate_blob_touch_next(ctx, bserrno);
+}
+
+static struct bs_inflate_slot *
+bs_inflate_blob_get_slot(struct spdk_clone_snapshot_ctx *ctx)
+{
+	uint32_t i;
+
+	for (i = 0; i < ctx->inflate.num_slots; i++) {
+		if (!ctx->inflate.slots[i].busy) {
+			return &ctx->inflate.slots[i];
+		}
+	}
+
+	return NULL;
+}
+
 static void
 bs_inflate_blob_touch_next(void *cb_arg, int bserrno)
 {
 	struct spdk_clone_snapshot_ctx *ctx = (struct spdk_clone_snapshot_ctx *)cb_arg;
 	struct spdk_blob *_blob = ctx->original.blob;
-	struct spdk_bs_cpl cpl;
-	spdk_bs_user_op_t *op;
-	uint64_t offset;
+	struct bs_inflate_slot *slot;
+	int rc;
 
-	if (bserrno != 0) {
-		bs_clone_snapshot_origblob_cleanup(ctx, bserrno);
-		return;
+	if (bserrno != 0 && ctx->inflate.bserrno == 0) {
+		ctx->inflate.bserrno = bserrno;
 	}
 
-	for (; ctx->cluster < _blob->active.num_clusters; ctx->cluster++) {
-		if (bs_cluster_needs_allocation(_blob, ctx->cluster, ctx->allocate_all)) {
+	while (!ctx->inflate.stop && ctx->inflate.bserrno == 0 && ctx->inflate.poller == NULL &&
+	       ctx->inflate.in_flight < ctx->inflate.num_slots) {
+		for (; ctx->cluster < _blob->active.num_clusters; ctx->cluster++) {
+			if (bs_cluster_needs_allocation(_blob, ctx->cluster, ctx->allocate_all)) {
+				break;
+			}
+		}
+
+		if (ctx->cluster == _blob->active.num_clusters) {
 			break;
 		}
-	}
 
-	if (ctx->cluster < _blob->active.num_clusters) {
-		offset = bs_cluster_to_lba(_blob->bs, ctx->cluster);
+		if (!bs_inflate_blob_consume_token(ctx)) {
+			ctx->inflate.poller = SPDK_POLLER_REGISTER(bs_inflate_blob_poll, ctx,
+					      BLOB_INFLATE_POLL_PERIOD_US);
+			break;
+		}
+
+		slot = bs_inflate_blob_get_slot(ctx);
+		assert(slot != NULL);
+		slot->busy = true;
+		ctx->inflate.in_flight++;
 
 		/* We may safely increment a cluster before copying */
 		ctx->cluster++;
 
-		/* Use a dummy 0B read as a context for cluster copy */
-		cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
-		cpl.u.blob_basic.cb_fn = bs_inflate_blob_touch_next;
-		cpl.u.blob_basic.cb_arg = ctx;
+		rc = blob_copy_cluster(_blob, ctx->channel,
+				       bs_cluster_to_io_unit(_blob->bs, ctx->cluster - 1),
+				       slot->page, bs_inflate_blob_copy_cpl, slot);
+		if (rc != 0) {
+			slot->busy = false;
+			ctx->inflate.in_flight--;
+			ctx->inflate.bserrno = rc;
+			break;
+		}
+	}
 
-		op = bs_user_op_alloc(ctx->channel, &cpl, SPDK_BLOB_READ, _blob,
-				      NULL, 0, offset, 0);
-		if (!op) {
-			bs_clone_snapshot_origblob_cleanup(ctx, -ENOMEM);
-			return;
+	if (ctx->inflate.stop || ctx->inflate.bserrno != 0) {
+		spdk_poller_unregister(&ctx->inflate.poller);
+	}
+
+	if (ctx->inflate.in_flight > 0 || ctx->inflate.checkpoint_in_progress ||
+	    ctx->inflate.poller != NULL) {
+		if (ctx->inflate.copied_clusters - ctx->inflate.checkpoint_clusters >=
+		    BLOB_INFLATE_CHECKPOINT_CLUSTERS && !ctx->inflate.checkpoint_in_progress) {
+			bs_inflate_blob_checkpoint(ctx, bs_inflate_blob_checkpoint_cpl);
 		}
+		return;
+	}
 
-		bs_allocate_and_copy_cluster(_blob, ctx->channel, offset, op);
-	} else {
-		bs_inflate_blob_done(ctx);
+	_blob->inflate_ctx = NULL;
+
+	if (ctx->inflate.stop || ctx->inflate.bserrno != 0) {
+		bs_inflate_blob_checkpoint(ctx, bs_inflate_blob_stop_cpl);
+		return;
 	}
+
+	bs_inflate_blob_done(ctx);
 }
 
 static void
 bs_inflate_blob_open_cpl(void *cb_arg, struct spdk_blob *_blob, int bserrno)
 {
 	struct spdk_clone_snapshot_ctx *ctx = (struct spdk_clone_snapshot_ctx *)cb_arg;
+	struct blob_inflate_progress progress;
 	uint64_t clusters_needed;
+	const void *value;
+	size_t len;
 	uint64_t i;
 
 	if (bserrno != 0) {
@@ -7288,22 +7916,103 @@ bs_inflate_blob_open_cpl(void *cb_arg, struct spdk_blob *_blob, int bserrno)
 		}
 	}
 
-	if (clusters_needed > _blob->bs->num_free_clusters) {
+	if (clusters_needed > spdk_bs_free_cluster_count(_blob->bs)) {
 		/* Not enough free clusters. Cannot satisfy the request. */
 		bs_clone_snapshot_origblob_cleanup(ctx, -ENOSPC);
 		return;
 	}
 
+	/* Keep reporting progress against the clusters counted by the run that was stopped */
+	ctx->inflate.total_clusters = clusters_needed;
+	if (blob_get_xattr_value(_blob, BLOB_INFLATE_PROGRESS, &value, &len, true) == 0 &&
+	    len == sizeof(progress)) {
+		memcpy(&progress, value, sizeof(progress));
+		if (progress.allocate_all == ctx->allocate_all &&
+		    progress.copied_clusters + clusters_needed <= _blob->active.num_clusters) {
+			ctx->inflate.copied_clusters = progress.copied_clusters;
+			ctx->inflate.checkpoint_clusters = progress.copied_clusters;
+			ctx->inflate.total_clusters += progress.copied_clusters;
+		}
+	}
+
+	_blob->inflate_ctx = ctx;
 	ctx->cluster = 0;
 	bs_inflate_blob_touch_next(ctx, 0);
 }
 
+void
+spdk_bs_inflate_opts_init(struct spdk_bs_inflate_opts *opts, size_t opts_size)
+{
+	if (!opts) {
+		SPDK_ERRLOG("opts should not be NULL\n");
+		return;
+	}
+
+	if (!opts_size) {
+		SPDK_ERRLOG("opts_size should not be zero value\n");
+		return;
+	}
+
+	memset(opts, 0, opts_size);
+	opts->opts_size = opts_size;
+
+#define FIELD_OK(field) \
+        offsetof(struct spdk_bs_inflate_opts, field) + sizeof(opts->field) <= opts_size
+
+#define SET_FIELD(field, value) \
+        if (FIELD_OK(field)) { \
+                opts->field = value; \
+        } \
+
+	SET_FIELD(clusters_in_flight, 1);
+
+#undef FIELD_OK
+#undef SET_FIELD
+}
+
+static void
+bs_inflate_opts_copy(const struct spdk_bs_inflate_opts *src, struct spdk_bs_inflate_opts *dst)
+{
+#define FIELD_OK(field) \
+        offsetof(struct spdk_bs_inflate_opts, field) + sizeof(src->field) <= src->opts_size
+
+#define SET_FIELD(field) \
+        if (FIELD_OK(field)) { \
+                dst->field = src->field; \
+        } \
+
+	SET_FIELD(decouple_parent);
+	SET_FIELD(clusters_in_flight);
+	SET_FIELD(max_bandwidth_mb_sec);
+	SET_FIELD(max_clusters_per_sec);
+	SET_FIELD(status_cb_fn);
+	SET_FIELD(status_cb_arg);
+
+	dst->opts_size = src->opts_size;
+
+	/* You should not remove this statement, but need to update the assert statement
+	 * if you add a new field, and also add a corresponding SET_FIELD statement */
+	SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_inflate_opts) == 40, "Incorrect size");
+
+#undef FIELD_OK
+#undef SET_FIELD
+}
+
 static void
 bs_inflate_blob(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
-		spdk_blob_id blobid, bool allocate_all, spdk_blob_op_complete cb_fn, void *cb_arg)
+		spdk_blob_id blobid, const struct spdk_bs_inflate_opts *opts,
+		spdk_blob_op_complete cb_fn, void *cb_arg)
 {
-	struct spdk_clone_snapshot_ctx *ctx = calloc(1, sizeof(*ctx));
+	struct spdk_clone_snapshot_ctx *ctx;
+	double clusters_per_sec = 0.0;
+	uint32_t i;
+
+	if (opts->clusters_in_flight == 0) {
+		cb_fn(cb_arg, -EINVAL);
+		return;
+	}
 
+	ctx = calloc(1, sizeof(*ctx));
 	if (!ctx) {
 		cb_fn(cb_arg, -ENOMEM);
 		return;
@@ -7314,7 +8023,44 @@ bs_inflate_blob(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
 	ctx->bserrno = 0;
 	ctx->original.id = blobid;
 	ctx->channel = channel;
-	ctx->allocate_all = allocate_all;
+	ctx->allocate_all = !opts->decouple_parent;
+	ctx->inflate.status_cb_fn = opts->status_cb_fn;
+	ctx->inflate.status_cb_arg = opts->status_cb_arg;
+
+	ctx->inflate.slots = calloc(opts->clusters_in_flight, sizeof(*ctx->inflate.slots));
+	if (!ctx->inflate.slots) {
+		free(ctx);
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+	ctx->inflate.num_slots = opts->clusters_in_flight;
+
+	for (i = 0; i < ctx->inflate.num_slots; i++) {
+		ctx->inflate.slots[i].ctx = ctx;
+		ctx->inflate.slots[i].page = spdk_zmalloc(bs->md_page_size, 0, NULL,
+					     SPDK_ENV_NUMA_ID_ANY, SPDK_MALLOC_DMA);
+		if (!ctx->inflate.slots[i].page) {
+			bs_inflate_slots_free(ctx);
+			free(ctx);
+			cb_fn(cb_arg, -ENOMEM);
+			return;
+		}
+	}
+
+	if (opts->max_bandwidth_mb_sec != 0) {
+		clusters_per_sec = opts->max_bandwidth_mb_sec * 1024 * 1024.0 / bs->cluster_sz;
+	}
+	if (opts->max_clusters_per_sec != 0 &&
+	    (clusters_per_sec == 0.0 || opts->max_clusters_per_sec < clusters_per_sec)) {
+		clusters_per_sec = opts->max_clusters_per_sec;
+	}
+	if (clusters_per_sec != 0.0) {
+		ctx->inflate.rate_limited = true;
+		ctx->inflate.last_tsc = spdk_get_ticks();
+		ctx->inflate.clusters_per_tsc = clusters_per_sec / spdk_get_ticks_hz();
+		ctx->inflate.clusters_max = clusters_per_sec / SPDK_SEC_TO_MSEC;
+		ctx->inflate.clusters_available = 0.0;
+	}
 
 	spdk_bs_open_blob(bs, ctx->original.id, bs_inflate_blob_open_cpl, ctx);
 }
@@ -7323,17 +8069,292 @@ void
 spdk_bs_inflate_blob(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
 		     spdk_blob_id blobid, spdk_blob_op_complete cb_fn, void *cb_arg)
 {
-	bs_inflate_blob(bs, channel, blobid, true, cb_fn, cb_arg);
+	struct spdk_bs_inflate_opts opts;
+
+	spdk_bs_inflate_opts_init(&opts, sizeof(opts));
+	bs_inflate_blob(bs, channel, blobid, &opts, cb_fn, cb_arg);
 }
 
 void
 spdk_bs_blob_decouple_parent(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
 			     spdk_blob_id blobid, spdk_blob_op_complete cb_fn, void *cb_arg)
 {
-	bs_inflate_blob(bs, channel, blobid, false, cb_fn, cb_arg);
+	struct spdk_bs_inflate_opts opts;
+
+	spdk_bs_inflate_opts_init(&opts, sizeof(opts));
+	opts.decouple_parent = true;
+	bs_inflate_blob(bs, channel, blobid, &opts, cb_fn, cb_arg);
+}
+
+void
+spdk_bs_inflate_blob_ext(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+			 spdk_blob_id blobid, const struct spdk_bs_inflate_opts *opts,
+			 spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_bs_inflate_opts opts_local;
+
+	spdk_bs_inflate_opts_init(&opts_local, sizeof(opts_local));
+	if (opts) {
+		bs_inflate_opts_copy(opts, &opts_local);
+	}
+
+	bs_inflate_blob(bs, channel, blobid, &opts_local, cb_fn, cb_arg);
+}
+
+int
+spdk_bs_inflate_blob_stop(struct spdk_blob_store *bs, spdk_blob_id blobid)
+{
+	struct spdk_blob *blob;
+
+	assert(spdk_get_thread() == bs->md_thread);
+
+	blob = blob_lookup(bs, blobid);
+	if (blob == NULL || blob->inflate_ctx == NULL) {
+		return -ENOENT;
+	}
+
+	blob->inflate_ctx->inflate.stop = true;
+	if (blob->inflate_ctx->inflate.poller != NULL) {
+		/* Nothing is in flight while waiting for the budget, so finish right away */
+		bs_inflate_blob_touch_next(blob->inflate_ctx, 0);
+	}
+
+	return 0;
 }
 /* END spdk_bs_inflate_blob */
 
+/* START spdk_bs_blob_get_diff */
+
+typedef void (*bs_blob_diff_collect_cpl)(void *cb_arg, struct spdk_bit_array *changed,
+		int bserrno);
+
+struct blob_diff_collect_ctx {
+	struct spdk_blob_store *bs;
+	spdk_blob_id base_id;
+	spdk_blob_id next_id;
+
+	/* One bit per cluster of the blob, set if any blob of the chain above base_id owns it */
+	struct spdk_bit_array *changed;
+
+	bs_blob_diff_collect_cpl cb_fn;
+	void *cb_arg;
+};
+
+static void bs_blob_diff_collect_next(struct blob_diff_collect_ctx *ctx);
+
+static void
+bs_blob_diff_collect_finish(struct blob_diff_collect_ctx *ctx, int bserrno)
+{
+	if (bserrno != 0) {
+		spdk_bit_array_free(&ctx->changed);
+	}
+
+	ctx->cb_fn(ctx->cb_arg, ctx->changed, bserrno);
+	free(ctx);
+}
+
+static void
+bs_blob_diff_collect_mark(struct blob_diff_collect_ctx *ctx, struct spdk_blob *blob)
+{
+	uint64_t num_clusters, i;
+
+	num_clusters = spdk_min(blob->active.num_clusters, spdk_bit_array_capacity(ctx->changed));
+	for (i = 0; i < num_clusters; i++) {
+		if (blob->active.clusters[i] != 0) {
+			spdk_bit_array_set(ctx->changed, i);
+		}
+	}
+}
+
+static void
+bs_blob_diff_collect_close_cpl(void *cb_arg, int bserrno)
+{
+	struct blob_diff_collect_ctx *ctx = cb_arg;
+
+	if (bserrno != 0) {
+		bs_blob_diff_collect_finish(ctx, bserrno);
+		return;
+	}
+
+	bs_blob_diff_collect_next(ctx);
+}
+
+static void
+bs_blob_diff_collect_open_cpl(void *cb_arg, struct spdk_blob *blob, int bserrno)
+{
+	struct blob_diff_collect_ctx *ctx = cb_arg;
+
+	if (bserrno != 0) {
+		bs_blob_diff_collect_finish(ctx, bserrno);
+		return;
+	}
+
+	bs_blob_diff_collect_mark(ctx, blob);
+	ctx->next_id = blob->parent_id;
+	spdk_blob_close(blob, bs_blob_diff_collect_close_cpl, ctx);
+}
+
+static void
+bs_blob_diff_collect_next(struct blob_diff_collect_ctx *ctx)
+{
+	uint32_t i;
+
+	if (ctx->next_id == ctx->base_id) {
+		bs_blob_diff_collect_finish(ctx, 0);
+		return;
+	}
+
+	switch (ctx->next_id) {
+	case SPDK_BLOBID_INVALID:
+		SPDK_DEBUGLOG(blob, "blob 0x%" PRIx64 " is not in the chain\n", ctx->base_id);
+		bs_blob_diff_collect_finish(ctx, -EINVAL);
+		break;
+	case SPDK_BLOBID_EXTERNAL_SNAPSHOT:
+		if (ctx->base_id != SPDK_BLOBID_INVALID) {
+			SPDK_DEBUGLOG(blob, "blob 0x%" PRIx64 " is not in the chain\n",
+				      ctx->base_id);
+			bs_blob_diff_collect_finish(ctx, -EINVAL);
+			break;
+		}
+		/* Nothing is known about the content of an external snapshot */
+		for (i = 0; i < spdk_bit_array_capacity(ctx->changed); i++) {
+			spdk_bit_array_set(ctx->changed, i);
+		}
+		bs_blob_diff_collect_finish(ctx, 0);
+		break;
+	default:
+		spdk_bs_open_blob(ctx->bs, ctx->next_id, bs_blob_diff_collect_open_cpl, ctx);
+		break;
+	}
+}
+
+/*
+ * Walk the chain of an open blob down to base_id and collect the clusters allocated on the
+ * way. The snapshots of the chain are opened one at a time, the blob itself is left open.
+ */
+static void
+bs_blob_diff_collect(struct spdk_blob *blob, spdk_blob_id base_id,
+		     bs_blob_diff_collect_cpl cb_fn, void *cb_arg)
+{
+	struct blob_diff_collect_ctx *ctx;
+
+	if (base_id == blob->id) {
+		cb_fn(cb_arg, NULL, -EINVAL);
+		return;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, NULL, -ENOMEM);
+		return;
+	}
+
+	ctx->changed = spdk_bit_array_create(blob->active.num_clusters);
+	if (ctx->changed == NULL) {
+		free(ctx);
+		cb_fn(cb_arg, NULL, -ENOMEM);
+		return;
+	}
+
+	ctx->bs = blob->bs;
+	ctx->base_id = base_id;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	bs_blob_diff_collect_mark(ctx, blob);
+	ctx->next_id = blob->parent_id;
+	bs_blob_diff_collect_next(ctx);
+}
+
+struct blob_get_diff_ctx {
+	struct spdk_blob *blob;
+	spdk_blob_id base_id;
+	struct spdk_bit_array *changed;
+	int bserrno;
+
+	spdk_blob_diff_extent_cb extent_cb_fn;
+	void *extent_cb_arg;
+	spdk_blob_op_complete cb_fn;
+	void *cb_arg;
+};
+
+static void
+bs_blob_get_diff_close_cpl(void *cb_arg, int bserrno)
+{
+	struct blob_get_diff_ctx *ctx = cb_arg;
+	uint32_t start, end, num_clusters;
+
+	if (ctx->bserrno == 0 && bserrno != 0) {
+		ctx->bserrno = bserrno;
+	}
+
+	if (ctx->bserrno == 0) {
+		num_clusters = spdk_bit_array_capacity(ctx->changed);
+		start = spdk_bit_array_find_first_set(ctx->changed, 0);
+		while (start != UINT32_MAX) {
+			end = spdk_bit_array_find_first_clear(ctx->changed, start);
+			if (end == UINT32_MAX) {
+				end = num_clusters;
+			}
+
+			ctx->extent_cb_fn(start, end - start, ctx->extent_cb_arg);
+			start = spdk_bit_array_find_first_set(ctx->changed, end);
+		}
+	}
+
+	spdk_bit_array_free(&ctx->changed);
+	ctx->cb_fn(ctx->cb_arg, ctx->bserrno);
+	free(ctx);
+}
+
+static void
+bs_blob_get_diff_collect_cpl(void *cb_arg, struct spdk_bit_array *changed, int bserrno)
+{
+	struct blob_get_diff_ctx *ctx = cb_arg;
+
+	ctx->changed = changed;
+	ctx->bserrno = bserrno;
+	spdk_blob_close(ctx->blob, bs_blob_get_diff_close_cpl, ctx);
+}
+
+static void
+bs_blob_get_diff_open_cpl(void *cb_arg, struct spdk_blob *blob, int bserrno)
+{
+	struct blob_get_diff_ctx *ctx = cb_arg;
+
+	if (bserrno != 0) {
+		ctx->cb_fn(ctx->cb_arg, bserrno);
+		free(ctx);
+		return;
+	}
+
+	ctx->blob = blob;
+	bs_blob_diff_collect(blob, ctx->base_id, bs_blob_get_diff_collect_cpl, ctx);
+}
+
+void
+spdk_bs_blob_get_diff(struct spdk_blob_store *bs, spdk_blob_id blobid, spdk_blob_id base_id,
+		      spdk_blob_diff_extent_cb extent_cb_fn, void *extent_cb_arg,
+		      spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	struct blob_get_diff_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->base_id = base_id;
+	ctx->extent_cb_fn = extent_cb_fn;
+	ctx->extent_cb_arg = extent_cb_arg;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	spdk_bs_open_blob(bs, blobid, bs_blob_get_diff_open_cpl, ctx);
+}
+/* END spdk_bs_blob_get_diff */
+
 /* START spdk_bs_blob_shallow_copy */
 
 struct shallow_copy_ctx {
@@ -7367,6 +8388,13 @@ struct shallow_copy_ctx {
 
 	/* Argument passed to function status_cb */
 	void *status_cb_arg;
+
+	/* Diff copy: only the clusters that differ from base_id are copied */
+	bool diff;
+	spdk_blob_id base_id;
+	struct spdk_bit_array *changed;
+	uint64_t total_clusters;
+	spdk_blob_diff_copy_status diff_status_cb;
 };
 
 static void
@@ -7382,6 +8410,7 @@ bs_shallow_copy_cleanup_finish(void *cb_arg, int bserrno)
 
 	ctx->ext_dev->destroy_channel(ctx->ext_dev, ctx->ext_channel);
 	spdk_free(ctx->read_buff);
+	spdk_bit_array_free(&ctx->changed);
 
 	cpl->u.blob_basic.cb_fn(cpl->u.blob_basic.cb_arg, ctx->bserrno);
 
@@ -7406,6 +8435,10 @@ bs_shallow_copy_bdev_write_cpl(struct spdk_io_channel *channel, void *cb_arg, in
 	if (ctx->status_cb) {
 		ctx->copied_clusters_count++;
 		ctx->status_cb(ctx->copied_clusters_count, ctx->status_cb_arg);
+	} else if (ctx->diff_status_cb) {
+		ctx->copied_clusters_count++;
+		ctx->diff_status_cb(ctx->copied_clusters_count, ctx->total_clusters,
+				    ctx->status_cb_arg);
 	}
 
 	bs_shallow_copy_cluster_find_next(ctx);
@@ -7443,7 +8476,8 @@ bs_shallow_copy_cluster_find_next(void *cb_arg)
 	struct spdk_blob *_blob = ctx->blob;
 
 	while (ctx->cluster < _blob->active.num_clusters) {
-		if (_blob->active.clusters[ctx->cluster] != 0) {
+		if (ctx->changed != NULL ? spdk_bit_array_get(ctx->changed, ctx->cluster) :
+		    _blob->active.clusters[ctx->cluster] != 0) {
 			break;
 		}
 
@@ -7461,6 +8495,30 @@ bs_shallow_copy_cluster_find_next(void *cb_arg)
 	}
 }
 
+static void
+bs_diff_copy_collect_cpl(void *cb_arg, struct spdk_bit_array *changed, int bserrno)
+{
+	struct shallow_copy_ctx *ctx = cb_arg;
+	struct spdk_blob *_blob = ctx->blob;
+
+	if (bserrno != 0) {
+		SPDK_ERRLOG("blob 0x%" PRIx64 " diff copy, cannot compare with blob 0x%" PRIx64
+			    ": %d\n", _blob->id, ctx->base_id, bserrno);
+		ctx->bserrno = bserrno;
+		_blob->locked_operation_in_progress = false;
+		spdk_blob_close(_blob, bs_shallow_copy_cleanup_finish, ctx);
+		return;
+	}
+
+	ctx->changed = changed;
+	ctx->total_clusters = spdk_bit_array_count_set(changed);
+	if (ctx->diff_status_cb) {
+		ctx->diff_status_cb(0, ctx->total_clusters, ctx->status_cb_arg);
+	}
+
+	bs_shallow_copy_cluster_find_next(ctx);
+}
+
 static void
 bs_shallow_copy_blob_open_cpl(void *cb_arg, struct spdk_blob *_blob, int bserrno)
 {
@@ -7514,13 +8572,17 @@ blobstore block size\n", _blob->id);
 	_blob->locked_operation_in_progress = true;
 
 	ctx->cluster = 0;
+	if (ctx->diff) {
+		bs_blob_diff_collect(_blob, ctx->base_id, bs_diff_copy_collect_cpl, ctx);
+		return;
+	}
+
 	bs_shallow_copy_cluster_find_next(ctx);
 }
 
-int
-spdk_bs_blob_shallow_copy(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+static struct shallow_copy_ctx *
+bs_shallow_copy_ctx_alloc(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
 			  spdk_blob_id blobid, struct spdk_bs_dev *ext_dev,
-			  spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
 			  spdk_blob_op_complete cb_fn, void *cb_arg)
 {
 	struct shallow_copy_ctx *ctx;
@@ -7528,7 +8590,7 @@ spdk_bs_blob_shallow_copy(struct spdk_blob_store *bs, struct spdk_io_channel *ch
 
 	ctx = calloc(1, sizeof(*ctx));
 	if (!ctx) {
-		return -ENOMEM;
+		return NULL;
 	}
 
 	ctx->bs = bs;
@@ -7538,24 +8600,68 @@ spdk_bs_blob_shallow_copy(struct spdk_blob_store *bs, struct spdk_io_channel *ch
 	ctx->cpl.u.bs_basic.cb_arg = cb_arg;
 	ctx->bserrno = 0;
 	ctx->blob_channel = channel;
-	ctx->status_cb = status_cb_fn;
-	ctx->status_cb_arg = status_cb_arg;
 	ctx->read_buff = spdk_malloc(bs->cluster_sz, bs->dev->blocklen, NULL,
 				     SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
 	if (!ctx->read_buff) {
 		free(ctx);
-		return -ENOMEM;
+		return NULL;
 	}
 
 	ext_channel = ext_dev->create_channel(ext_dev);
 	if (!ext_channel) {
 		spdk_free(ctx->read_buff);
 		free(ctx);
-		return -ENOMEM;
+		return NULL;
 	}
 	ctx->ext_dev = ext_dev;
 	ctx->ext_channel = ext_channel;
 
+	return ctx;
+}
+
+int
+spdk_bs_blob_shallow_copy(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+			  spdk_blob_id blobid, struct spdk_bs_dev *ext_dev,
+			  spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
+			  spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	struct shallow_copy_ctx *ctx;
+
+	ctx = bs_shallow_copy_ctx_alloc(bs, channel, blobid, ext_dev, cb_fn, cb_arg);
+	if (!ctx) {
+		return -ENOMEM;
+	}
+
+	ctx->status_cb = status_cb_fn;
+	ctx->status_cb_arg = status_cb_arg;
+
+	spdk_bs_open_blob(ctx->bs, ctx->blobid, bs_shallow_copy_blob_open_cpl, ctx);
+
+	return 0;
+}
+
+int
+spdk_bs_blob_diff_copy(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+		       spdk_blob_id blobid, spdk_blob_id base_id, struct spdk_bs_dev *ext_dev,
+		       spdk_blob_diff_copy_status status_cb_fn, void *status_cb_arg,
+		       spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	struct shallow_copy_ctx *ctx;
+
+	if (blobid == base_id) {
+		return -EINVAL;
+	}
+
+	ctx = bs_shallow_copy_ctx_alloc(bs, channel, blobid, ext_dev, cb_fn, cb_arg);
+	if (!ctx) {
+		return -ENOMEM;
+	}
+
+	ctx->diff = true;
+	ctx->base_id = base_id;
+	ctx->diff_status_cb = status_cb_fn;
+	ctx->status_cb_arg = status_cb_arg;
+
 	spdk_bs_open_blob(ctx->bs, ctx->blobid, bs_shallow_copy_blob_open_cpl, ctx);
 
 	return 0;
@@ -8869,6 +9975,9 @@ struct spdk_blob_cluster_op_ctx {
 	uint32_t		cluster;	/* cluster on disk */
 	uint32_t		extent_page;	/* extent page on disk */
 	struct spdk_blob_md_page *page; /* preallocated extent page */
+	/* Extent page claimed by the caller of an insert, told on completion whether it still
+	 * owns it. It does not once the page is released or recorded in the extent table. */
+	uint32_t		*caller_extent_page;
 	int			rc;
 	spdk_blob_op_complete	cb_fn;
 	void			*cb_arg;
@@ -8876,6 +9985,12 @@ struct spdk_blob_cluster_op_ctx {
 	/* for serializing concurrent cluster alloc/release operations on the same extent page */
 	spdk_msg_fn		msg_fn;
 	TAILQ_ENTRY(spdk_blob_cluster_op_ctx) link;
+
+	/* cluster inserts that arrived while this one was waiting and are persisted with it */
+	TAILQ_HEAD(, spdk_blob_cluster_op_ctx) batch;
+	TAILQ_ENTRY(spdk_blob_cluster_op_ctx) batch_link;
+	/* op of the batch whose extent page is claimed for the extent table */
+	struct spdk_blob_cluster_op_ctx *ep_owner;
 };
 
 static void
@@ -8883,6 +9998,9 @@ blob_op_cluster_msg_cpl(void *arg)
 {
 	struct spdk_blob_cluster_op_ctx *ctx = arg;
 
+	if (ctx->caller_extent_page != NULL) {
+		*ctx->caller_extent_page = ctx->extent_page;
+	}
 	ctx->cb_fn(ctx->cb_arg, ctx->rc);
 	free(ctx);
 }
@@ -8926,6 +10044,55 @@ _blob_cluster_op(void *arg)
 	}
 }
 
+static void blob_insert_cluster_msg(void *arg);
+
+/*
+ * Cluster inserts into the same extent page are persisted one at a time. Instead of queueing
+ * one more extent page write per insert behind the one in progress, inserts that arrive in
+ * the meantime join the last insert still waiting for that extent page. It then applies all
+ * of them and persists the extent page once, completing the whole batch together.
+ */
+static bool
+blob_insert_cluster_batch_join(struct spdk_blob_cluster_op_ctx *ctx)
+{
+	struct spdk_blob *blob = ctx->blob;
+	struct spdk_blob_cluster_op_ctx *tmp, *waiting = NULL;
+	uint32_t table_id = bs_cluster_to_extent_table_id(ctx->cluster_num);
+	bool in_progress = false;
+
+	TAILQ_FOREACH(tmp, &blob->cluster_op_queue, link) {
+		if (bs_cluster_to_extent_table_id(tmp->cluster_num) != table_id) {
+			continue;
+		}
+		/* The first op on this extent page is the one in progress */
+		if (!in_progress) {
+			in_progress = true;
+			continue;
+		}
+		waiting = tmp;
+	}
+
+	/* Only join the last op, so that inserts stay ordered with cluster releases */
+	if (waiting == NULL || waiting->msg_fn != blob_insert_cluster_msg) {
+		return false;
+	}
+
+	TAILQ_INSERT_TAIL(&waiting->batch, ctx, batch_link);
+	return true;
+}
+
+static void
+_blob_insert_cluster_op(void *arg)
+{
+	struct spdk_blob_cluster_op_ctx *ctx = arg;
+
+	if (ctx->blob->use_extent_table && blob_insert_cluster_batch_join(ctx)) {
+		return;
+	}
+
+	_blob_cluster_op(ctx);
+}
+
 static void
 blob_op_cluster_rm_and_trigger(struct spdk_blob_cluster_op_ctx *ctx)
 {
@@ -8972,16 +10139,40 @@ blob_op_cluster_msg_cb(void *arg, int bserrno)
 	spdk_thread_send_msg(ctx->thread, blob_op_cluster_msg_cpl, ctx);
 }
 
+static void
+blob_insert_cluster_batch_cb(void *arg, int bserrno)
+{
+	struct spdk_blob_cluster_op_ctx *ctx = arg;
+	struct spdk_blob_cluster_op_ctx *member;
+
+	while ((member = TAILQ_FIRST(&ctx->batch)) != NULL) {
+		TAILQ_REMOVE(&ctx->batch, member, batch_link);
+		member->rc = bserrno;
+		spdk_thread_send_msg(member->thread, blob_op_cluster_msg_cpl, member);
+	}
+
+	/* ctx->rc holds the error of inserting ctx's own cluster, if any */
+	blob_op_cluster_msg_cb(ctx, ctx->rc != 0 ? ctx->rc : bserrno);
+}
+
 static void
 blob_insert_new_ep_cb(void *arg, int bserrno)
 {
 	struct spdk_blob_cluster_op_ctx *ctx = arg;
+	struct spdk_blob_cluster_op_ctx *ep_owner = ctx->ep_owner;
 	uint32_t *extent_page;
 
+	if (bserrno != 0) {
+		/* The extent page stays with the caller that claimed it, which releases it */
+		blob_insert_cluster_batch_cb(ctx, bserrno);
+		return;
+	}
+
 	extent_page = bs_cluster_to_extent_page(ctx->blob, ctx->cluster_num);
-	*extent_page = ctx->extent_page;
+	*extent_page = ep_owner->extent_page;
+	ep_owner->extent_page = 0;
 	ctx->blob->state = SPDK_BLOB_STATE_DIRTY;
-	blob_sync_md(ctx->blob, blob_op_cluster_msg_cb, ctx);
+	blob_sync_md(ctx->blob, blob_insert_cluster_batch_cb, ctx);
 }
 
 struct spdk_blob_write_extent_page_ctx {
@@ -9088,15 +10279,28 @@ blob_write_extent_page(struct spdk_blob *blob, uint32_t extent, uint64_t cluster
 	bs_mark_dirty(seq, blob->bs, blob_write_extent_page_ready, ctx);
 }
 
+static void
+blob_release_extent_page(struct spdk_blob_cluster_op_ctx *ctx)
+{
+	if (ctx->extent_page != 0) {
+		spdk_spin_lock(&ctx->blob->bs->used_lock);
+		assert(spdk_bit_array_get(ctx->blob->bs->used_md_pages, ctx->extent_page) == true);
+		bs_release_md_page(ctx->blob->bs, ctx->extent_page);
+		spdk_spin_unlock(&ctx->blob->bs->used_lock);
+		ctx->extent_page = 0;
+	}
+}
+
 static void
 blob_insert_cluster_msg(void *arg)
 {
 	struct spdk_blob_cluster_op_ctx *ctx = arg;
+	struct spdk_blob_cluster_op_ctx *member, *tmp, *ep_owner;
 	uint32_t *extent_page;
 	int rc;
 
 	rc = blob_insert_cluster(ctx->blob, ctx->cluster_num, ctx->cluster);
-	if (rc != 0) {
+	if (rc != 0 && TAILQ_EMPTY(&ctx->batch)) {
 		blob_op_cluster_msg_cb(ctx, rc);
 		return;
 	}
@@ -9108,35 +10312,66 @@ blob_insert_cluster_msg(void *arg)
 		return;
 	}
 
+	/* Apply the batched inserts too. The ones that fail are completed right away, the
+	 * others are completed once the extent page is persisted. Any of the inserted clusters
+	 * can provide the newly claimed extent page and the buffer to write it from. */
+	ctx->rc = rc;
+	ep_owner = rc == 0 ? ctx : NULL;
+	TAILQ_FOREACH_SAFE(member, &ctx->batch, batch_link, tmp) {
+		rc = blob_insert_cluster(member->blob, member->cluster_num, member->cluster);
+		if (rc != 0) {
+			TAILQ_REMOVE(&ctx->batch, member, batch_link);
+			member->rc = rc;
+			spdk_thread_send_msg(member->thread, blob_op_cluster_msg_cpl, member);
+		} else if (ep_owner == NULL) {
+			ep_owner = member;
+		}
+	}
+
+	if (ep_owner == NULL) {
+		blob_insert_cluster_batch_cb(ctx, 0);
+		return;
+	}
+
 	extent_page = bs_cluster_to_extent_page(ctx->blob, ctx->cluster_num);
 	if (*extent_page == 0) {
 		/* Extent page requires allocation.
 		 * It was already claimed in the used_md_pages map and placed in ctx. */
-		assert(ctx->extent_page != 0);
-		assert(spdk_bit_array_get(ctx->blob->bs->used_md_pages, ctx->extent_page) == true);
-		blob_write_extent_page(ctx->blob, ctx->extent_page, ctx->cluster_num, ctx->page,
-				       blob_insert_new_ep_cb, ctx);
+		assert(ep_owner->extent_page != 0);
+		assert(spdk_bit_array_get(ctx->blob->bs->used_md_pages,
+					  ep_owner->extent_page) == true);
+		/* Release the extent pages claimed for the rest of the batch */
+		if (ctx->rc == 0 && ctx != ep_owner) {
+			blob_release_extent_page(ctx);
+		}
+		TAILQ_FOREACH(member, &ctx->batch, batch_link) {
+			if (member != ep_owner) {
+				blob_release_extent_page(member);
+			}
+		}
+		ctx->ep_owner = ep_owner;
+		blob_write_extent_page(ctx->blob, ep_owner->extent_page, ctx->cluster_num,
+				       ep_owner->page, blob_insert_new_ep_cb, ctx);
 	} else {
 		/* It is possible for original thread to allocate extent page for
 		 * different cluster in the same extent page. In such case proceed with
 		 * updating the existing extent page, but release the additional one. */
-		if (ctx->extent_page != 0) {
-			spdk_spin_lock(&ctx->blob->bs->used_lock);
-			assert(spdk_bit_array_get(ctx->blob->bs->used_md_pages, ctx->extent_page) == true);
-			bs_release_md_page(ctx->blob->bs, ctx->extent_page);
-			spdk_spin_unlock(&ctx->blob->bs->used_lock);
-			ctx->extent_page = 0;
+		if (ctx->rc == 0) {
+			blob_release_extent_page(ctx);
+		}
+		TAILQ_FOREACH(member, &ctx->batch, batch_link) {
+			blob_release_extent_page(member);
 		}
 		/* Extent page already allocated.
 		 * Every cluster allocation, requires just an update of single extent page. */
-		blob_write_extent_page(ctx->blob, *extent_page, ctx->cluster_num, ctx->page,
-				       blob_op_cluster_msg_cb, ctx);
+		blob_write_extent_page(ctx->blob, *extent_page, ctx->cluster_num, ep_owner->page,
+				       blob_insert_cluster_batch_cb, ctx);
 	}
 }
 
 static void
 blob_insert_cluster_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num,
-				 uint64_t cluster, uint32_t extent_page, struct spdk_blob_md_page *page,
+				 uint64_t cluster, uint32_t *extent_page, struct spdk_blob_md_page *page,
 				 spdk_blob_op_complete cb_fn, void *cb_arg)
 {
 	struct spdk_blob_cluster_op_ctx *ctx;
@@ -9151,13 +10386,15 @@ blob_insert_cluster_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num,
 	ctx->blob = blob;
 	ctx->cluster_num = cluster_num;
 	ctx->cluster = cluster;
-	ctx->extent_page = extent_page;
+	ctx->extent_page = *extent_page;
+	ctx->caller_extent_page = extent_page;
 	ctx->page = page;
 	ctx->cb_fn = cb_fn;
 	ctx->cb_arg = cb_arg;
 	ctx->msg_fn = blob_insert_cluster_msg;
+	TAILQ_INIT(&ctx->batch);
 
-	spdk_thread_send_msg(blob->bs->md_thread, _blob_cluster_op, ctx);
+	spdk_thread_send_msg(blob->bs->md_thread, _blob_insert_cluster_op, ctx);
 }
 
 static void
@@ -9219,6 +10456,7 @@ blob_free_cluster_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num, uin
 	ctx->cb_fn = cb_fn;
 	ctx->cb_arg = cb_arg;
 	ctx->msg_fn = blob_free_cluster_msg;
+	TAILQ_INIT(&ctx->batch);
 
 	spdk_thread_send_msg(blob->bs->md_thread, _blob_cluster_op, ctx);
 }
@@ -129,6 +129,13 @@ struct spdk_blob {
 
 	struct spdk_bs_dev *back_bs_dev;
 
+	/* Unallocated clusters of a clone resolved through its chain of snapshots. Allocated on
+	 * first read and replaced once bs->flat_map_gen moves past it. Replaced maps may still be
+	 * in use by in-flight reads, so they are kept on flat_map_retired until I/O is frozen.
+	 */
+	struct blob_flat_map *flat_map;
+	struct blob_flat_map *flat_map_retired;
+
 	/* TODO: The xattrs are mutable, but we don't want to be
 	 * copying them unnecessarily. Figure this out.
 	 */
@@ -139,6 +146,8 @@ struct spdk_blob {
 
 	uint32_t frozen_refcnt;
 	bool locked_operation_in_progress;
+	/* Background inflate of the blob, if one is running */
+	struct spdk_clone_snapshot_ctx *inflate_ctx;
 	enum blob_clear_method clear_method;
 	bool extent_rle_found;
 	bool extent_table_found;
@@ -162,6 +171,7 @@ struct spdk_blob_store {
 
 	struct spdk_io_channel		*md_channel;
 	uint32_t			max_channel_ops;
+	uint32_t			channel_cluster_pool_size;
 
 	struct spdk_thread		*md_thread;
 
@@ -178,6 +188,10 @@ struct spdk_blob_store {
 	uint64_t			total_clusters;
 	uint64_t			total_data_clusters;
 	uint64_t			num_free_clusters;	/* Protected by used_lock */
+	/* Channels holding pre-claimed clusters */
+	TAILQ_HEAD(, spdk_bs_channel)	cluster_pools;		/* Protected by used_lock */
+	/* Clusters held in channel pools. They are claimed in used_clusters, but still free. */
+	uint64_t			num_pooled_clusters;
 	uint64_t			pages_per_cluster;
 	uint64_t			io_units_per_cluster;
 	uint8_t				pages_per_cluster_shift;
@@ -205,6 +219,9 @@ struct spdk_blob_store {
 	uint32_t			esnap_channels_unloading;
 	spdk_bs_op_complete		esnap_unload_cb_fn;
 	void				*esnap_unload_cb_arg;
+
+	/* Bumped whenever a snapshot is detached from a chain, invalidating all flat maps */
+	uint64_t			flat_map_gen;
 };
 
 struct spdk_bs_channel {
@@ -228,6 +245,14 @@ struct spdk_bs_channel {
 	TAILQ_HEAD(, spdk_blob_free_cluster_ctx) pending_free_cluster;
 
 	RB_HEAD(blob_esnap_channel_tree, blob_esnap_channel) esnap_channels;
+
+	/* Clusters claimed in advance for allocations done on this channel. Popped by the
+	 * channel's thread without used_lock, and by other threads reclaiming them with it.
+	 */
+	uint32_t			*cluster_pool;
+	uint32_t			cluster_pool_count;
+	bool				cluster_pool_refilling;
+	TAILQ_ENTRY(spdk_bs_channel)	cluster_pool_link;
 };
 
 /** operation type */
@@ -246,6 +271,7 @@ enum spdk_blob_op_type {
 #define SNAPSHOT_IN_PROGRESS "SNAPTMP"
 #define SNAPSHOT_PENDING_REMOVAL "SNAPRM"
 #define BLOB_EXTERNAL_SNAPSHOT_ID "EXTSNAP"
+#define BLOB_INFLATE_PROGRESS "INFLATE"
 
 struct spdk_blob_bs_dev {
 	struct spdk_bs_dev bs_dev;
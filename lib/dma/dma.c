@@ -386,6 +386,8 @@ spdk_dma_device_type_get_name(enum spdk_dma_device_type type)
 		return "DMA";
 	case SPDK_DMA_DEVICE_TYPE_ACCEL:
 		return "ACCEL";
+	case SPDK_DMA_DEVICE_TYPE_UBLK:
+		return "UBLK";
 	default:
 		if (type >= SPDK_DMA_DEVICE_VENDOR_SPECIFIC_TYPE_START &&
 		    type <= SPDK_DMA_DEVICE_VENDOR_SPECIFIC_TYPE_END) {
@@ -147,6 +147,8 @@ _rpc_thread_get_stats(void *arg)
 		spdk_json_write_named_string(ctx->w, "cpumask", spdk_cpuset_fmt(&tmp_mask));
 		spdk_json_write_named_uint64(ctx->w, "busy", stats.busy_tsc);
 		spdk_json_write_named_uint64(ctx->w, "idle", stats.idle_tsc);
+		spdk_json_write_named_uint64(ctx->w, "msgs_executed", stats.msgs_executed);
+		spdk_json_write_named_uint64(ctx->w, "msgs_sent", stats.msgs_sent);
 		spdk_json_write_named_uint64(ctx->w, "active_pollers_count", active_pollers_count);
 		spdk_json_write_named_uint64(ctx->w, "timed_pollers_count", timed_pollers_count);
 		spdk_json_write_named_uint64(ctx->w, "paused_pollers_count", paused_pollers_count);
@@ -472,6 +474,9 @@ rpc_framework_get_scheduler(struct spdk_jsonrpc_request *request,
 	spdk_json_write_named_uint64(w, "scheduler_period", scheduler_period);
 	spdk_json_write_named_string(w, "isolated_core_mask", scheduler_get_isolated_core_mask());
 	spdk_json_write_named_uint32(w, "scheduling_core", scheduling_core);
+	spdk_json_write_named_bool(w, "work_stealing", spdk_scheduler_work_stealing_enabled());
+	spdk_json_write_named_uint64(w, "work_stealing_period",
+				     spdk_scheduler_get_work_stealing_period());
 	if (governor != NULL) {
 		spdk_json_write_named_string(w, "governor_name", governor->name);
 	}
@@ -550,6 +555,8 @@ rpc_scheduler_set_options(struct spdk_jsonrpc_request *request,
 	struct spdk_cpuset core_mask;
 
 	req.scheduling_core = spdk_scheduler_get_scheduling_lcore();
+	req.work_stealing = spdk_scheduler_work_stealing_enabled();
+	req.work_stealing_period = spdk_scheduler_get_work_stealing_period();
 
 	if (spdk_json_decode_object(params, rpc_scheduler_set_options_decoders,
 				    SPDK_COUNTOF(rpc_scheduler_set_options_decoders), &req)) {
@@ -578,6 +585,15 @@ rpc_scheduler_set_options(struct spdk_jsonrpc_request *request,
 		goto end;
 	}
 
+	if (req.work_stealing_period == 0) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Work stealing period cannot be 0.\n");
+		goto end;
+	}
+
+	spdk_scheduler_set_work_stealing_period(req.work_stealing_period);
+	spdk_scheduler_enable_work_stealing(req.work_stealing);
+
 	spdk_jsonrpc_send_bool_response(request, true);
 end:
 	free_rpc_scheduler_set_options(&req);
@@ -704,4 +720,24 @@ err:
 	free(ctx);
 }
 SPDK_RPC_REGISTER("thread_set_cpumask", rpc_thread_set_cpumask, SPDK_RPC_RUNTIME)
+
+static void
+rpc_thread_set_msg_batching(struct spdk_jsonrpc_request *request,
+			    const struct spdk_json_val *params)
+{
+	struct rpc_thread_set_msg_batching_ctx req = {};
+
+	if (spdk_json_decode_object(params, rpc_thread_set_msg_batching_decoders,
+				    SPDK_COUNTOF(rpc_thread_set_msg_batching_decoders),
+				    &req)) {
+		SPDK_DEBUGLOG(app_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		return;
+	}
+
+	spdk_thread_lib_set_msg_batching(req.enabled);
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+SPDK_RPC_REGISTER("thread_set_msg_batching", rpc_thread_set_msg_batching,
+		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
 SPDK_LOG_REGISTER_COMPONENT(app_rpc)
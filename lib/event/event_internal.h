@@ -24,6 +24,9 @@ struct spdk_lw_thread {
 	struct spdk_thread_stats	total_stats;
 	/* stats during the last scheduling period */
 	struct spdk_thread_stats	current_stats;
+	/* busy time during the current and the last work stealing period */
+	uint64_t			steal_busy_tsc;
+	uint64_t			steal_last_busy_tsc;
 };
 
 /**
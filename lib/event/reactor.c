@@ -53,6 +53,21 @@ static uint32_t g_scheduler_core_number;
 static struct spdk_scheduler_core_info *g_core_infos = NULL;
 static struct spdk_cpuset g_scheduler_isolated_core_mask;
 
+/* Reactors sample their load once per work stealing period. A reactor whose load dropped
+ * to WORK_STEALING_IDLE_LOAD percent or less takes a thread from the busiest reactor whose
+ * load is at least WORK_STEALING_BUSY_LOAD percent. To avoid threads bouncing between
+ * reactors, a thread that moved and a reactor that stole are both left alone for
+ * WORK_STEALING_COOLDOWN_PERIODS periods.
+ */
+#define WORK_STEALING_DEFAULT_PERIOD_US	100
+#define WORK_STEALING_IDLE_LOAD		10
+#define WORK_STEALING_BUSY_LOAD		90
+#define WORK_STEALING_COOLDOWN_PERIODS	100
+
+static bool g_work_stealing_enabled = false;
+static uint64_t g_work_stealing_period_in_us = WORK_STEALING_DEFAULT_PERIOD_US;
+static uint64_t g_work_stealing_period_in_tsc;
+
 TAILQ_HEAD(, spdk_governor) g_governor_list
 	= TAILQ_HEAD_INITIALIZER(g_governor_list);
 
@@ -146,6 +161,33 @@ spdk_scheduler_set_period(uint64_t period)
 	g_scheduler_period_in_tsc = period * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
 }
 
+void
+spdk_scheduler_enable_work_stealing(bool enable)
+{
+	/* Refresh the period, ticks_hz might not have been known when it was set */
+	spdk_scheduler_set_work_stealing_period(g_work_stealing_period_in_us);
+	g_work_stealing_enabled = enable;
+}
+
+bool
+spdk_scheduler_work_stealing_enabled(void)
+{
+	return g_work_stealing_enabled;
+}
+
+uint64_t
+spdk_scheduler_get_work_stealing_period(void)
+{
+	return g_work_stealing_period_in_us;
+}
+
+void
+spdk_scheduler_set_work_stealing_period(uint64_t period)
+{
+	g_work_stealing_period_in_us = period;
+	g_work_stealing_period_in_tsc = period * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+}
+
 void
 spdk_scheduler_register(struct spdk_scheduler *scheduler)
 {
@@ -977,6 +1019,7 @@ _reactor_run(struct spdk_reactor *reactor)
 			reactor->idle_tsc += now - reactor->tsc_last;
 		} else if (rc > 0) {
 			reactor->busy_tsc += now - reactor->tsc_last;
+			lw_thread->steal_busy_tsc += now - reactor->tsc_last;
 		}
 		reactor->tsc_last = now;
 
@@ -984,6 +1027,121 @@ _reactor_run(struct spdk_reactor *reactor)
 	}
 }
 
+/* Runs on the busy reactor on behalf of the idle reactor in arg1 */
+static void
+_reactor_steal_thread(void *arg1, void *arg2)
+{
+	struct spdk_reactor *thief = arg1;
+	struct spdk_reactor *reactor;
+	struct spdk_lw_thread *lw_thread, *hottest = NULL, *stolen = NULL;
+	struct spdk_thread *thread;
+	uint64_t cooldown_tsc;
+
+	reactor = spdk_reactor_get(spdk_env_get_current_core());
+	assert(reactor != NULL);
+
+	/* The load might have changed since the thief looked at it */
+	if (!g_work_stealing_enabled || g_scheduling_in_progress ||
+	    g_reactor_state != SPDK_REACTOR_STATE_RUNNING ||
+	    reactor->in_interrupt || thief->in_interrupt ||
+	    reactor->load < WORK_STEALING_BUSY_LOAD) {
+		return;
+	}
+
+	/* Keep the hottest thread, moving it would only move the hot spot to the thief */
+	TAILQ_FOREACH(lw_thread, &reactor->threads, link) {
+		if (hottest == NULL ||
+		    lw_thread->steal_last_busy_tsc > hottest->steal_last_busy_tsc) {
+			hottest = lw_thread;
+		}
+	}
+
+	cooldown_tsc = g_work_stealing_period_in_tsc * WORK_STEALING_COOLDOWN_PERIODS;
+	TAILQ_FOREACH(lw_thread, &reactor->threads, link) {
+		thread = spdk_thread_get_from_ctx(lw_thread);
+		if (lw_thread == hottest || lw_thread->resched ||
+		    lw_thread->tsc_start + cooldown_tsc > reactor->tsc_last ||
+		    !spdk_thread_is_running(thread) || spdk_thread_is_bound(thread) ||
+		    spdk_thread_is_app_thread(thread) ||
+		    !spdk_cpuset_get_cpu(spdk_thread_get_cpumask(thread), thief->lcore)) {
+			continue;
+		}
+
+		if (stolen == NULL ||
+		    lw_thread->steal_last_busy_tsc > stolen->steal_last_busy_tsc) {
+			stolen = lw_thread;
+		}
+	}
+
+	if (stolen == NULL) {
+		return;
+	}
+
+	SPDK_DEBUGLOG(reactor, "Reactor %u steals thread %s from reactor %u\n", thief->lcore,
+		      spdk_thread_get_name(spdk_thread_get_from_ctx(stolen)), reactor->lcore);
+
+	/* The thread is moved once it is done polling, same as for the scheduler */
+	stolen->lcore = thief->lcore;
+	stolen->resched = true;
+}
+
+static void
+reactor_work_stealing(struct spdk_reactor *reactor)
+{
+	struct spdk_lw_thread *lw_thread;
+	struct spdk_reactor *busiest = NULL, *other;
+	uint64_t busy_tsc, idle_tsc, cooldown_tsc;
+	uint32_t i, load, busiest_load = 0;
+
+	if (reactor->tsc_last - reactor->steal_window_tsc < g_work_stealing_period_in_tsc) {
+		return;
+	}
+
+	busy_tsc = reactor->busy_tsc - reactor->steal_window_busy_tsc;
+	idle_tsc = reactor->idle_tsc - reactor->steal_window_idle_tsc;
+	load = busy_tsc + idle_tsc > 0 ? busy_tsc * 100 / (busy_tsc + idle_tsc) : 0;
+	__atomic_store_n(&reactor->load, load, __ATOMIC_RELAXED);
+
+	reactor->steal_window_tsc = reactor->tsc_last;
+	reactor->steal_window_busy_tsc = reactor->busy_tsc;
+	reactor->steal_window_idle_tsc = reactor->idle_tsc;
+
+	TAILQ_FOREACH(lw_thread, &reactor->threads, link) {
+		lw_thread->steal_last_busy_tsc = lw_thread->steal_busy_tsc;
+		lw_thread->steal_busy_tsc = 0;
+	}
+
+	cooldown_tsc = g_work_stealing_period_in_tsc * WORK_STEALING_COOLDOWN_PERIODS;
+	if (load > WORK_STEALING_IDLE_LOAD || g_scheduling_in_progress ||
+	    scheduler_is_isolated_core(reactor->lcore) ||
+	    reactor->last_steal_tsc + cooldown_tsc > reactor->tsc_last) {
+		return;
+	}
+
+	/* Other reactors' state is only a hint here, the victim checks it again */
+	SPDK_ENV_FOREACH_CORE(i) {
+		other = spdk_reactor_get(i);
+		if (other == NULL || other == reactor || other->in_interrupt ||
+		    scheduler_is_isolated_core(i) ||
+		    __atomic_load_n(&other->thread_count, __ATOMIC_RELAXED) < 2) {
+			continue;
+		}
+
+		load = __atomic_load_n(&other->load, __ATOMIC_RELAXED);
+		if (load >= WORK_STEALING_BUSY_LOAD && load > busiest_load) {
+			busiest = other;
+			busiest_load = load;
+		}
+	}
+
+	if (busiest == NULL) {
+		return;
+	}
+
+	reactor->last_steal_tsc = reactor->tsc_last;
+	_event_call(busiest->lcore, _reactor_steal_thread, reactor, NULL);
+}
+
 static int
 reactor_run(void *arg)
 {
@@ -1011,6 +1169,10 @@ reactor_run(void *arg)
 			reactor_interrupt_run(reactor);
 		} else {
 			_reactor_run(reactor);
+
+			if (spdk_unlikely(g_work_stealing_enabled)) {
+				reactor_work_stealing(reactor);
+			}
 		}
 
 		if (g_framework_context_switch_monitor_enabled) {
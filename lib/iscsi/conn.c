@@ -126,6 +126,7 @@ iscsi_poll_group_add_conn(struct spdk_iscsi_poll_group *pg, struct spdk_iscsi_co
 
 	conn->is_stopped = false;
 	STAILQ_INSERT_TAIL(&pg->connections, conn, pg_link);
+	pg->num_conns++;
 }
 
 static void
@@ -142,6 +143,8 @@ iscsi_poll_group_remove_conn(struct spdk_iscsi_poll_group *pg, struct spdk_iscsi
 
 	conn->is_stopped = true;
 	STAILQ_REMOVE(&pg->connections, conn, spdk_iscsi_conn, pg_link);
+	assert(pg->num_conns > 0);
+	pg->num_conns--;
 }
 
 static int
@@ -219,6 +222,7 @@ iscsi_conn_construct(struct spdk_iscsi_portal *portal,
 	conn->pdu_recv_state = ISCSI_PDU_RECV_STATE_AWAIT_PDU_READY;
 
 	TAILQ_INIT(&conn->write_pdu_list);
+	TAILQ_INIT(&conn->digest_pdu_list);
 	TAILQ_INIT(&conn->snack_pdu_list);
 	TAILQ_INIT(&conn->queued_r2t_tasks);
 	TAILQ_INIT(&conn->active_r2t_tasks);
@@ -320,10 +324,15 @@ iscsi_conn_free_tasks(struct spdk_iscsi_conn *conn)
 		iscsi_conn_free_pdu(conn, pdu);
 	}
 
-	if (conn->pending_task_cnt) {
+	/* PDUs waiting for a data digest are moved to conn->write_pdu_list once accel
+	 *  completes, so wait for them too.
+	 */
+	if (conn->pending_task_cnt || conn->data_digest_cnt) {
 		return -1;
 	}
 
+	assert(TAILQ_EMPTY(&conn->digest_pdu_list));
+
 	return 0;
 }
 
@@ -1434,11 +1443,57 @@ iscsi_conn_pdu_generic_complete(void *cb_arg)
 {
 }
 
+static void
+_iscsi_conn_write_pdu(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu)
+{
+	TAILQ_INSERT_TAIL(&conn->write_pdu_list, pdu, tailq);
+
+	if (spdk_unlikely(conn->state >= ISCSI_CONN_STATE_EXITING)) {
+		return;
+	}
+	pdu->sock_req.iovcnt = iscsi_build_iovs(conn, pdu->iov, SPDK_COUNTOF(pdu->iov), pdu,
+						&pdu->mapped_length);
+	pdu->sock_req.cb_fn = _iscsi_conn_pdu_write_done;
+	pdu->sock_req.cb_arg = pdu;
+
+	spdk_sock_writev_async(conn->sock, &pdu->sock_req);
+}
+
+static void
+iscsi_conn_data_digest_done(void *cb_arg, int status)
+{
+	struct spdk_iscsi_pdu *pdu = cb_arg;
+	struct spdk_iscsi_conn *conn = pdu->conn;
+	uint32_t crc32c;
+
+	assert(conn->data_digest_cnt > 0);
+	conn->data_digest_cnt--;
+
+	if (spdk_unlikely(status != 0)) {
+		SPDK_ERRLOG("Failed to calculate data digest of pdu %p asynchronously, rc %d\n",
+			    pdu, status);
+		crc32c = iscsi_pdu_calc_data_digest(pdu);
+	} else {
+		crc32c = pdu->crc32c ^ SPDK_CRC32C_XOR;
+	}
+	MAKE_DIGEST_WORD(pdu->data_digest, crc32c);
+	pdu->data_digest_pending = false;
+
+	/* Send PDUs in the order they were written, up to the next one whose data digest
+	 *  is still being calculated.
+	 */
+	while ((pdu = TAILQ_FIRST(&conn->digest_pdu_list)) != NULL && !pdu->data_digest_pending) {
+		TAILQ_REMOVE(&conn->digest_pdu_list, pdu, tailq);
+		_iscsi_conn_write_pdu(conn, pdu);
+	}
+}
+
 void
 iscsi_conn_write_pdu(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu,
 		     iscsi_conn_xfer_complete_cb cb_fn,
 		     void *cb_arg)
 {
+	uint32_t data_len;
 	uint32_t crc32c;
 	ssize_t rc;
 
@@ -1459,31 +1514,39 @@ iscsi_conn_write_pdu(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu,
 		}
 
 		/* Data Digest */
-		if (conn->data_digest && DGET24(pdu->bhs.data_segment_len) != 0) {
-			crc32c = iscsi_pdu_calc_data_digest(pdu);
-			MAKE_DIGEST_WORD(pdu->data_digest, crc32c);
+		data_len = DGET24(pdu->bhs.data_segment_len);
+		if (conn->data_digest && data_len != 0) {
+			pdu->data_digest_pending = true;
+			conn->data_digest_cnt++;
+			rc = iscsi_pdu_submit_data_digest(conn, pdu, data_len,
+							  iscsi_conn_data_digest_done);
+			if (spdk_unlikely(rc != 0)) {
+				conn->data_digest_cnt--;
+				pdu->data_digest_pending = false;
+
+				crc32c = iscsi_pdu_calc_data_digest(pdu);
+				MAKE_DIGEST_WORD(pdu->data_digest, crc32c);
+			}
 		}
 	}
 
 	pdu->cb_fn = cb_fn;
 	pdu->cb_arg = cb_arg;
-	TAILQ_INSERT_TAIL(&conn->write_pdu_list, pdu, tailq);
 
-	if (spdk_unlikely(conn->state >= ISCSI_CONN_STATE_EXITING)) {
+	/* Keep the PDU behind the ones still waiting for their data digest. */
+	if (pdu->data_digest_pending || !TAILQ_EMPTY(&conn->digest_pdu_list)) {
+		TAILQ_INSERT_TAIL(&conn->digest_pdu_list, pdu, tailq);
 		return;
 	}
-	pdu->sock_req.iovcnt = iscsi_build_iovs(conn, pdu->iov, SPDK_COUNTOF(pdu->iov), pdu,
-						&pdu->mapped_length);
-	pdu->sock_req.cb_fn = _iscsi_conn_pdu_write_done;
-	pdu->sock_req.cb_arg = pdu;
 
-	spdk_sock_writev_async(conn->sock, &pdu->sock_req);
+	_iscsi_conn_write_pdu(conn, pdu);
 }
 
 static void
 iscsi_conn_sock_cb(void *arg, struct spdk_sock_group *group, struct spdk_sock *sock)
 {
 	struct spdk_iscsi_conn *conn = arg;
+	uint64_t tsc;
 	int rc;
 
 	assert(conn != NULL);
@@ -1493,11 +1556,22 @@ iscsi_conn_sock_cb(void *arg, struct spdk_sock_group *group, struct spdk_sock *s
 		return;
 	}
 
+	/* Incoming PDUs are left in the socket until the connection is migrated or resumed */
+	if (conn->migrating) {
+		return;
+	}
+
 	/* Handle incoming PDUs */
+	tsc = spdk_get_ticks();
 	rc = iscsi_handle_incoming_pdus(conn);
 	if (rc < 0) {
 		conn->state = ISCSI_CONN_STATE_EXITING;
 	}
+
+	/* Account the time to the target to let the balancer pick which one to move */
+	if (conn->scheduled) {
+		conn->target->busy_tsc += spdk_get_ticks() - tsc;
+	}
 }
 
 static void
@@ -1528,17 +1602,35 @@ iscsi_conn_full_feature_migrate(void *arg)
 	iscsi_poll_group_add_conn(conn->pg, conn);
 }
 
+/* Poll groups whose busy percentages fall into the same bucket are considered equally loaded */
+#define ISCSI_POLL_GROUP_BUSY_PCT_BUCKET	10
+
+static int
+iscsi_poll_group_cmp_load(struct spdk_iscsi_poll_group *pg1, struct spdk_iscsi_poll_group *pg2)
+{
+	uint32_t busy1 = pg1->busy_pct / ISCSI_POLL_GROUP_BUSY_PCT_BUCKET;
+	uint32_t busy2 = pg2->busy_pct / ISCSI_POLL_GROUP_BUSY_PCT_BUCKET;
+
+	if (busy1 != busy2) {
+		return busy1 < busy2 ? -1 : 1;
+	}
+	if (pg1->num_conns != pg2->num_conns) {
+		return pg1->num_conns < pg2->num_conns ? -1 : 1;
+	}
+	if (pg1->num_active_targets != pg2->num_active_targets) {
+		return pg1->num_active_targets < pg2->num_active_targets ? -1 : 1;
+	}
+
+	return 0;
+}
+
 static struct spdk_iscsi_poll_group *
 iscsi_get_idlest_poll_group(void)
 {
 	struct spdk_iscsi_poll_group *pg, *idle_pg = NULL;
-	uint32_t min_num_targets = UINT32_MAX;
 
 	TAILQ_FOREACH(pg, &g_iscsi.poll_group_head, link) {
-		if (pg->num_active_targets == 0) {
-			return pg;
-		} else if (pg->num_active_targets < min_num_targets) {
-			min_num_targets = pg->num_active_targets;
+		if (idle_pg == NULL || iscsi_poll_group_cmp_load(pg, idle_pg) < 0) {
 			idle_pg = pg;
 		}
 	}
@@ -1597,6 +1689,361 @@ iscsi_conn_schedule(struct spdk_iscsi_conn *conn)
 			     iscsi_conn_full_feature_migrate, conn);
 }
 
+static inline struct spdk_thread *
+iscsi_poll_group_get_thread(struct spdk_iscsi_poll_group *pg)
+{
+	return spdk_io_channel_get_thread(spdk_io_channel_from_ctx(pg));
+}
+
+/* How long to wait for the connections of a target to become idle before giving up */
+#define ISCSI_TGT_NODE_MIGRATE_TIMEOUT_MS	1000
+#define ISCSI_TGT_NODE_MIGRATE_POLL_US		100
+
+struct iscsi_tgt_node_migrate_ctx {
+	struct spdk_iscsi_tgt_node	*target;
+	struct spdk_iscsi_poll_group	*src_pg;
+	struct spdk_iscsi_poll_group	*dst_pg;
+	struct spdk_poller		*poller;
+	uint64_t			timeout_tsc;
+	struct spdk_thread		*orig_thread;
+	int				rc;
+	iscsi_conn_migrate_cb		cb_fn;
+	void				*cb_arg;
+};
+
+static bool
+iscsi_conn_has_lun_remove(struct spdk_iscsi_conn *conn)
+{
+	struct spdk_iscsi_lun *iscsi_lun;
+
+	TAILQ_FOREACH(iscsi_lun, &conn->luns, tailq) {
+		if (iscsi_lun->remove_poller != NULL) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* A connection can be moved once nothing of it is tied to the current thread. Tasks
+ * waiting for R2T data are not, so pending_task_cnt is not checked.
+ */
+static bool
+iscsi_conn_is_quiesced(struct spdk_iscsi_conn *conn)
+{
+	return conn->state == ISCSI_CONN_STATE_RUNNING &&
+	       conn->login_timer == NULL &&
+	       conn->logout_request_timer == NULL &&
+	       conn->logout_timer == NULL &&
+	       conn->data_digest_cnt == 0 &&
+	       TAILQ_EMPTY(&conn->write_pdu_list) &&
+	       TAILQ_EMPTY(&conn->digest_pdu_list) &&
+	       TAILQ_EMPTY(&conn->queued_datain_tasks) &&
+	       !spdk_scsi_dev_has_pending_tasks(conn->dev, conn->initiator_port) &&
+	       !iscsi_conn_has_lun_remove(conn);
+}
+
+static void
+iscsi_conn_migrate_to_poll_group(void *arg)
+{
+	struct spdk_iscsi_conn *conn = arg;
+
+	iscsi_conn_full_feature_migrate(conn);
+
+	/* The socket may have become readable while the connection was quiesced */
+	if (conn->state == ISCSI_CONN_STATE_RUNNING && iscsi_handle_incoming_pdus(conn) < 0) {
+		conn->state = ISCSI_CONN_STATE_EXITING;
+	}
+}
+
+static void
+iscsi_tgt_node_migrate_done(void *arg)
+{
+	struct iscsi_tgt_node_migrate_ctx *ctx = arg;
+	struct spdk_iscsi_tgt_node *target = ctx->target;
+
+	if (ctx->rc == 0) {
+		SPDK_INFOLOG(iscsi, "Moved connections of %s to %s\n", target->name,
+			     spdk_thread_get_name(iscsi_poll_group_get_thread(ctx->dst_pg)));
+	}
+
+	pthread_mutex_lock(&target->mutex);
+	target->migrating = false;
+	pthread_mutex_unlock(&target->mutex);
+
+	ctx->cb_fn(ctx->cb_arg, ctx->rc);
+	free(ctx);
+}
+
+static int
+iscsi_tgt_node_migrate_poll(void *arg)
+{
+	struct iscsi_tgt_node_migrate_ctx *ctx = arg;
+	struct spdk_iscsi_tgt_node *target = ctx->target;
+	struct spdk_iscsi_poll_group *src_pg = ctx->src_pg;
+	struct spdk_iscsi_conn *conn, *tmp;
+	uint32_t num_conns = 0;
+	bool quiesced = true;
+	int rc;
+
+	/* Stop reading from all connections of the target and wait until they become idle */
+	STAILQ_FOREACH(conn, &src_pg->connections, pg_link) {
+		if (conn->target != target || !conn->scheduled) {
+			continue;
+		}
+
+		conn->migrating = true;
+		num_conns++;
+		if (!iscsi_conn_is_quiesced(conn)) {
+			quiesced = false;
+		}
+	}
+
+	pthread_mutex_lock(&g_iscsi.mutex);
+	pthread_mutex_lock(&target->mutex);
+	if (target->destructed || target->num_active_conns == 0) {
+		rc = -ENODEV;
+	} else if (quiesced && num_conns == target->num_active_conns) {
+		/* Connections scheduled from now on go straight to the new poll group */
+		src_pg->num_active_targets--;
+		ctx->dst_pg->num_active_targets++;
+		target->pg = ctx->dst_pg;
+		rc = 0;
+	} else if (spdk_get_ticks() > ctx->timeout_tsc) {
+		rc = -ETIMEDOUT;
+	} else {
+		rc = -EAGAIN;
+	}
+	pthread_mutex_unlock(&target->mutex);
+	pthread_mutex_unlock(&g_iscsi.mutex);
+
+	if (rc == -EAGAIN) {
+		return SPDK_POLLER_BUSY;
+	}
+
+	spdk_poller_unregister(&ctx->poller);
+
+	STAILQ_FOREACH_SAFE(conn, &src_pg->connections, pg_link, tmp) {
+		if (!conn->migrating) {
+			continue;
+		}
+
+		conn->migrating = false;
+		if (rc == 0) {
+			/* LUN I/O channels are per thread, so all connections close them
+			 * before the first one reopens them in the new poll group.
+			 */
+			iscsi_conn_close_luns(conn);
+			iscsi_poll_group_remove_conn(src_pg, conn);
+			conn->pg = ctx->dst_pg;
+			spdk_thread_send_msg(iscsi_poll_group_get_thread(ctx->dst_pg),
+					     iscsi_conn_migrate_to_poll_group, conn);
+		} else if (conn->state == ISCSI_CONN_STATE_RUNNING &&
+			   iscsi_handle_incoming_pdus(conn) < 0) {
+			conn->state = ISCSI_CONN_STATE_EXITING;
+		}
+	}
+
+	if (rc != 0) {
+		SPDK_NOTICELOG("Failed to move connections of %s: %s\n", target->name,
+			       spdk_strerror(-rc));
+	}
+
+	ctx->rc = rc;
+	spdk_thread_send_msg(ctx->orig_thread, iscsi_tgt_node_migrate_done, ctx);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+_iscsi_tgt_node_migrate(void *arg)
+{
+	struct iscsi_tgt_node_migrate_ctx *ctx = arg;
+
+	ctx->timeout_tsc = spdk_get_ticks() + spdk_get_ticks_hz() *
+			   ISCSI_TGT_NODE_MIGRATE_TIMEOUT_MS / SPDK_SEC_TO_MSEC;
+	ctx->poller = SPDK_POLLER_REGISTER(iscsi_tgt_node_migrate_poll, ctx,
+					   ISCSI_TGT_NODE_MIGRATE_POLL_US);
+}
+
+/* All connections of a target share its poll group because a SCSI LUN has a single I/O
+ * channel, so connections are always moved together with the other ones of their target.
+ *
+ * Called with g_iscsi.mutex held.
+ */
+static int
+iscsi_tgt_node_migrate(struct spdk_iscsi_tgt_node *target, struct spdk_iscsi_poll_group *dst_pg,
+		       iscsi_conn_migrate_cb cb_fn, void *cb_arg)
+{
+	struct iscsi_tgt_node_migrate_ctx *ctx;
+	int rc = 0;
+
+	if (dst_pg == NULL) {
+		dst_pg = iscsi_get_idlest_poll_group();
+		if (dst_pg == NULL) {
+			return -ENODEV;
+		}
+	}
+
+	pthread_mutex_lock(&target->mutex);
+	if (target->destructed || target->num_active_conns == 0) {
+		rc = -ENODEV;
+	} else if (target->migrating) {
+		rc = -EBUSY;
+	} else if (target->pg == dst_pg) {
+		rc = -EALREADY;
+	}
+
+	if (rc != 0) {
+		pthread_mutex_unlock(&target->mutex);
+		return rc;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		pthread_mutex_unlock(&target->mutex);
+		return -ENOMEM;
+	}
+
+	ctx->target = target;
+	ctx->src_pg = target->pg;
+	ctx->dst_pg = dst_pg;
+	ctx->orig_thread = spdk_get_thread();
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	target->migrating = true;
+	pthread_mutex_unlock(&target->mutex);
+
+	spdk_thread_send_msg(iscsi_poll_group_get_thread(ctx->src_pg),
+			     _iscsi_tgt_node_migrate, ctx);
+
+	return 0;
+}
+
+int
+iscsi_conn_migrate(int id, const char *thread_name, iscsi_conn_migrate_cb cb_fn, void *cb_arg)
+{
+	struct spdk_iscsi_poll_group *pg, *dst_pg = NULL;
+	struct spdk_iscsi_tgt_node *target = NULL;
+	struct spdk_iscsi_conn *conn;
+	int rc;
+
+	pthread_mutex_lock(&g_iscsi.mutex);
+
+	if (thread_name != NULL) {
+		TAILQ_FOREACH(pg, &g_iscsi.poll_group_head, link) {
+			if (strcmp(spdk_thread_get_name(iscsi_poll_group_get_thread(pg)),
+				   thread_name) == 0) {
+				dst_pg = pg;
+				break;
+			}
+		}
+
+		if (dst_pg == NULL) {
+			SPDK_ERRLOG("No iSCSI poll group runs on thread %s\n", thread_name);
+			pthread_mutex_unlock(&g_iscsi.mutex);
+			return -EINVAL;
+		}
+	}
+
+	pthread_mutex_lock(&g_conns_mutex);
+	TAILQ_FOREACH(conn, &g_active_conns, conn_link) {
+		if (conn->id == id) {
+			/* Only full feature phase connections run in the target's poll group */
+			if (conn->scheduled) {
+				target = conn->target;
+			}
+			break;
+		}
+	}
+	pthread_mutex_unlock(&g_conns_mutex);
+
+	if (target == NULL) {
+		SPDK_ERRLOG("Connection %d is not in full feature phase\n", id);
+		rc = -ENODEV;
+	} else {
+		rc = iscsi_tgt_node_migrate(target, dst_pg, cb_fn, cb_arg);
+	}
+
+	pthread_mutex_unlock(&g_iscsi.mutex);
+
+	return rc;
+}
+
+static bool g_conns_balancing;
+static uint64_t g_conns_balance_tsc;
+
+static void
+iscsi_conns_balance_done(void *cb_arg, int rc)
+{
+	g_conns_balancing = false;
+}
+
+/* Move one target from the busiest to the idlest poll group if their load differs by
+ * more than the threshold. The target whose load brings the two closest is picked.
+ */
+void
+iscsi_conns_balance(void)
+{
+	struct spdk_iscsi_poll_group *pg, *src_pg = NULL, *dst_pg = NULL;
+	struct spdk_iscsi_tgt_node *target, *best_target = NULL;
+	uint64_t now, period_tsc, busy_tsc;
+	uint32_t diff, load, score, best_score = UINT32_MAX;
+	int rc;
+
+	now = spdk_get_ticks();
+	period_tsc = now - g_conns_balance_tsc;
+
+	pthread_mutex_lock(&g_iscsi.mutex);
+
+	TAILQ_FOREACH(pg, &g_iscsi.poll_group_head, link) {
+		if (src_pg == NULL || pg->busy_pct > src_pg->busy_pct) {
+			src_pg = pg;
+		}
+		if (dst_pg == NULL || pg->busy_pct < dst_pg->busy_pct) {
+			dst_pg = pg;
+		}
+	}
+
+	diff = src_pg != NULL ? src_pg->busy_pct - dst_pg->busy_pct : 0;
+
+	TAILQ_FOREACH(target, &g_iscsi.target_head, tailq) {
+		busy_tsc = target->busy_tsc - target->balance_busy_tsc;
+		target->balance_busy_tsc = target->busy_tsc;
+
+		/* The first run only takes the baseline */
+		if (g_conns_balance_tsc == 0 || target->pg != src_pg || target->migrating ||
+		    target->num_active_conns == 0) {
+			continue;
+		}
+
+		load = spdk_min(busy_tsc * 100 / period_tsc, 100);
+		if (load == 0 || load >= diff) {
+			continue;
+		}
+
+		score = diff > 2 * load ? diff - 2 * load : 2 * load - diff;
+		if (score < best_score) {
+			best_score = score;
+			best_target = target;
+		}
+	}
+
+	g_conns_balance_tsc = now;
+
+	if (!g_conns_balancing && best_target != NULL &&
+	    diff >= g_iscsi.conn_balance_threshold) {
+		SPDK_INFOLOG(iscsi, "Moving %s to balance poll groups at %u%% and %u%% busy\n",
+			     best_target->name, src_pg->busy_pct, dst_pg->busy_pct);
+
+		rc = iscsi_tgt_node_migrate(best_target, dst_pg, iscsi_conns_balance_done, NULL);
+		g_conns_balancing = rc == 0;
+	}
+
+	pthread_mutex_unlock(&g_iscsi.mutex);
+}
+
 static int
 logout_timeout(void *arg)
 {
@@ -37,6 +37,9 @@ enum iscsi_pdu_recv_state {
 	/* Active connection waiting for payload */
 	ISCSI_PDU_RECV_STATE_AWAIT_PDU_PAYLOAD,
 
+	/* Active connection waiting for accel to check the data digest */
+	ISCSI_PDU_RECV_STATE_AWAIT_DATA_DIGEST,
+
 	/* Active connection does not wait for payload */
 	ISCSI_PDU_RECV_STATE_ERROR,
 };
@@ -102,6 +105,8 @@ struct spdk_iscsi_conn {
 	enum iscsi_pdu_recv_state pdu_recv_state;
 
 	TAILQ_HEAD(, spdk_iscsi_pdu) write_pdu_list;
+	/* PDUs waiting for their own or an earlier PDU's data digest */
+	TAILQ_HEAD(, spdk_iscsi_pdu) digest_pdu_list;
 	TAILQ_HEAD(, spdk_iscsi_pdu) snack_pdu_list;
 
 	uint32_t pending_r2t;
@@ -142,6 +147,7 @@ struct spdk_iscsi_conn {
 	bool mutual_chap;
 	int32_t chap_group;
 	uint32_t pending_task_cnt;
+	uint32_t data_digest_cnt;
 	uint32_t data_out_cnt;
 	uint32_t data_in_cnt;
 
@@ -164,6 +170,7 @@ struct spdk_iscsi_conn {
 
 	STAILQ_ENTRY(spdk_iscsi_conn) pg_link;
 	bool			is_stopped;  /* Set true when connection is stopped for migration */
+	bool			migrating;   /* Set true while reads are held for migration */
 	TAILQ_HEAD(queued_r2t_tasks, spdk_iscsi_task)	queued_r2t_tasks;
 	TAILQ_HEAD(active_r2t_tasks, spdk_iscsi_task)	active_r2t_tasks;
 	TAILQ_HEAD(queued_datain_tasks, spdk_iscsi_task)	queued_datain_tasks;
@@ -181,6 +188,11 @@ void shutdown_iscsi_conns(void);
 void iscsi_conns_request_logout(struct spdk_iscsi_tgt_node *target, int pg_tag);
 int iscsi_get_active_conns(struct spdk_iscsi_tgt_node *target);
 
+typedef void (*iscsi_conn_migrate_cb)(void *cb_arg, int rc);
+int iscsi_conn_migrate(int id, const char *thread_name, iscsi_conn_migrate_cb cb_fn,
+		       void *cb_arg);
+void iscsi_conns_balance(void);
+
 int iscsi_conn_construct(struct spdk_iscsi_portal *portal, struct spdk_sock *sock);
 void iscsi_conn_destruct(struct spdk_iscsi_conn *conn);
 void iscsi_conn_handle_nop(struct spdk_iscsi_conn *conn);
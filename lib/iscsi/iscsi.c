@@ -353,6 +353,39 @@ iscsi_pdu_calc_data_digest(struct spdk_iscsi_pdu *pdu)
 	return crc32c ^ SPDK_CRC32C_XOR;
 }
 
+static const uint8_t g_iscsi_digest_pad[ISCSI_ALIGNMENT];
+
+/* Calculate the data digest over data_len bytes at pdu->data through accel, continuing
+ *  from pdu->crc32c. The CRC is left in pdu->crc32c, not finalized, when cb_fn is called.
+ */
+int
+iscsi_pdu_submit_data_digest(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu,
+			     uint32_t data_len, spdk_accel_completion_cb cb_fn)
+{
+	uint32_t mod;
+	int iovcnt = 1;
+
+	/* Connections are only offloaded once they have settled on their poll group. */
+	if (spdk_unlikely(pdu->dif_insert_or_strip) || !conn->scheduled ||
+	    conn->state >= ISCSI_CONN_STATE_EXITING || conn->pg->accel_ch == NULL) {
+		return -ENOTSUP;
+	}
+
+	/* pdu->iov is not used until the PDU is handed to the socket. */
+	pdu->iov[0].iov_base = pdu->data;
+	pdu->iov[0].iov_len = data_len;
+
+	mod = data_len % ISCSI_ALIGNMENT;
+	if (mod != 0) {
+		pdu->iov[1].iov_base = (void *)g_iscsi_digest_pad;
+		pdu->iov[1].iov_len = ISCSI_ALIGNMENT - mod;
+		iovcnt++;
+	}
+
+	return spdk_accel_submit_crc32cv(conn->pg->accel_ch, &pdu->crc32c, pdu->iov, iovcnt,
+					 ~pdu->crc32c, cb_fn, pdu);
+}
+
 static int
 iscsi_conn_read_data_segment(struct spdk_iscsi_conn *conn,
 			     struct spdk_iscsi_pdu *pdu,
@@ -4619,6 +4652,78 @@ iscsi_pdu_payload_handle(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pd
 	return rc;
 }
 
+/* Return zero if the PDU was handled, or negative number if any error. */
+static int
+iscsi_pdu_payload_done(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu)
+{
+	int rc;
+
+	/* All data for this PDU has now been read from the socket. */
+	spdk_trace_record(TRACE_ISCSI_READ_PDU, conn->trace_id, pdu->data_valid_bytes,
+			  (uintptr_t)pdu, pdu->bhs.opcode);
+
+	if (!pdu->is_rejected) {
+		rc = iscsi_pdu_payload_handle(conn, pdu);
+	} else {
+		rc = 0;
+	}
+	if (rc != 0) {
+		conn->pdu_recv_state = ISCSI_PDU_RECV_STATE_ERROR;
+		return rc;
+	}
+
+	spdk_trace_record(TRACE_ISCSI_TASK_EXECUTED, conn->trace_id, 0, (uintptr_t)pdu);
+	iscsi_put_pdu(pdu);
+	conn->pdu_in_progress = NULL;
+	conn->pdu_recv_state = ISCSI_PDU_RECV_STATE_AWAIT_PDU_READY;
+
+	return 0;
+}
+
+static void
+iscsi_pdu_data_digest_done(void *cb_arg, int status)
+{
+	struct spdk_iscsi_pdu *pdu = cb_arg;
+	struct spdk_iscsi_conn *conn = pdu->conn;
+	uint32_t crc32c;
+	int rc;
+
+	assert(conn->data_digest_cnt > 0);
+	conn->data_digest_cnt--;
+
+	if (spdk_unlikely(conn->pdu_in_progress != pdu)) {
+		/* The connection was destructed while the digest was calculated. */
+		iscsi_put_pdu(pdu);
+		return;
+	}
+	iscsi_put_pdu(pdu);
+
+	assert(conn->pdu_recv_state == ISCSI_PDU_RECV_STATE_AWAIT_DATA_DIGEST);
+	conn->pdu_recv_state = ISCSI_PDU_RECV_STATE_ERROR;
+
+	if (spdk_unlikely(status != 0)) {
+		SPDK_ERRLOG("data digest calculation failed (%s), rc %d\n", conn->initiator_name,
+			    status);
+	} else {
+		crc32c = pdu->crc32c ^ SPDK_CRC32C_XOR;
+		if (!MATCH_DIGEST_WORD(pdu->data_digest, crc32c)) {
+			SPDK_ERRLOG("data digest error (%s)\n", conn->initiator_name);
+		} else if (conn->state < ISCSI_CONN_STATE_EXITING) {
+			iscsi_pdu_payload_done(conn, pdu);
+		}
+	}
+
+	if (conn->state >= ISCSI_CONN_STATE_EXITING) {
+		return;
+	}
+
+	/* Pick up the PDUs which arrived while the digest was calculated. */
+	rc = iscsi_handle_incoming_pdus(conn);
+	if (rc < 0) {
+		conn->state = ISCSI_CONN_STATE_EXITING;
+	}
+}
+
 /* Return zero if completed to read payload, positive number if still in progress,
  * or negative number if any error.
  */
@@ -4720,6 +4825,19 @@ iscsi_pdu_payload_read(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu)
 
 	/* check data digest */
 	if (conn->data_digest) {
+		/* The PDU is held until the digest is checked in case the connection goes away. */
+		pdu->ref++;
+		conn->data_digest_cnt++;
+		rc = iscsi_pdu_submit_data_digest(conn, pdu,
+						  pdu->data_valid_bytes - pdu->data_offset,
+						  iscsi_pdu_data_digest_done);
+		if (spdk_likely(rc == 0)) {
+			conn->pdu_recv_state = ISCSI_PDU_RECV_STATE_AWAIT_DATA_DIGEST;
+			return 1;
+		}
+		conn->data_digest_cnt--;
+		pdu->ref--;
+
 		iscsi_pdu_calc_partial_data_digest(pdu);
 		crc32c = iscsi_pdu_calc_partial_data_digest_done(pdu);
 
@@ -4855,25 +4973,14 @@ iscsi_read_pdu(struct spdk_iscsi_conn *conn)
 				}
 			}
 
-			/* All data for this PDU has now been read from the socket. */
-			spdk_trace_record(TRACE_ISCSI_READ_PDU, conn->trace_id, pdu->data_valid_bytes,
-					  (uintptr_t)pdu, pdu->bhs.opcode);
-
-			if (!pdu->is_rejected) {
-				rc = iscsi_pdu_payload_handle(conn, pdu);
-			} else {
-				rc = 0;
-			}
+			rc = iscsi_pdu_payload_done(conn, pdu);
 			if (rc == 0) {
-				spdk_trace_record(TRACE_ISCSI_TASK_EXECUTED, conn->trace_id, 0, (uintptr_t)pdu);
-				iscsi_put_pdu(pdu);
-				conn->pdu_in_progress = NULL;
-				conn->pdu_recv_state = ISCSI_PDU_RECV_STATE_AWAIT_PDU_READY;
 				return 1;
-			} else {
-				conn->pdu_recv_state = ISCSI_PDU_RECV_STATE_ERROR;
 			}
 			break;
+		case ISCSI_PDU_RECV_STATE_AWAIT_DATA_DIGEST:
+			/* iscsi_pdu_data_digest_done() resumes reading. */
+			return 0;
 		case ISCSI_PDU_RECV_STATE_ERROR:
 			return SPDK_ISCSI_CONNECTION_FATAL;
 		default:
@@ -4895,6 +5002,10 @@ iscsi_handle_incoming_pdus(struct spdk_iscsi_conn *conn)
 
 	/* Read new PDUs from network */
 	for (i = 0; i < GET_PDU_LOOP_COUNT; i++) {
+		if (conn->migrating) {
+			break;
+		}
+
 		rc = iscsi_read_pdu(conn);
 		if (rc == 0) {
 			break;
@@ -8,6 +8,7 @@
 #define SPDK_ISCSI_H
 
 #include "spdk/stdinc.h"
+#include "spdk/accel.h"
 #include "spdk/env.h"
 #include "spdk/bdev.h"
 #include "spdk/iscsi_spec.h"
@@ -49,6 +50,8 @@
 #define DEFAULT_TIMEOUT 60
 #define MAX_NOPININTERVAL 60
 #define DEFAULT_NOPININTERVAL 30
+#define DEFAULT_CONN_BALANCE_INTERVAL 0
+#define DEFAULT_CONN_BALANCE_THRESHOLD 20
 
 /*
  * SPDK iSCSI target currently only supports 64KB as the maximum data segment length
@@ -163,6 +166,7 @@ struct spdk_iscsi_pdu {
 	uint32_t data_buf_len;
 	uint32_t data_offset;
 	uint32_t crc32c;
+	bool data_digest_pending; /* data digest is being calculated by accel */
 	bool dif_insert_or_strip;
 	struct spdk_dif_ctx dif_ctx;
 	struct spdk_iscsi_conn *conn;
@@ -287,8 +291,15 @@ struct spdk_iscsi_poll_group {
 	struct spdk_poller				*nop_poller;
 	STAILQ_HEAD(connections, spdk_iscsi_conn)	connections;
 	struct spdk_sock_group				*sock_group;
+	struct spdk_io_channel				*accel_ch;
 	TAILQ_ENTRY(spdk_iscsi_poll_group)		link;
 	uint32_t					num_active_targets;
+	uint32_t					num_conns;
+
+	/* Share of the last nop poller period the thread spent busy, in percent */
+	uint32_t					busy_pct;
+	uint64_t					last_busy_tsc;
+	uint64_t					last_idle_tsc;
 };
 
 struct spdk_iscsi_opts {
@@ -315,6 +326,8 @@ struct spdk_iscsi_opts {
 	uint32_t pdu_pool_size;
 	uint32_t immediate_data_pool_size;
 	uint32_t data_out_pool_size;
+	uint32_t conn_balance_interval;
+	uint32_t conn_balance_threshold;
 };
 
 struct spdk_iscsi_globals {
@@ -351,6 +364,8 @@ struct spdk_iscsi_globals {
 	uint32_t pdu_pool_size;
 	uint32_t immediate_data_pool_size;
 	uint32_t data_out_pool_size;
+	uint32_t conn_balance_interval;
+	uint32_t conn_balance_threshold;
 
 	struct spdk_mempool *pdu_pool;
 	struct spdk_mempool *pdu_immediate_data_pool;
@@ -436,6 +451,8 @@ bool iscsi_del_transfer_task(struct spdk_iscsi_conn *conn, uint32_t CmdSN);
 
 uint32_t iscsi_pdu_calc_header_digest(struct spdk_iscsi_pdu *pdu);
 uint32_t iscsi_pdu_calc_data_digest(struct spdk_iscsi_pdu *pdu);
+int iscsi_pdu_submit_data_digest(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu,
+				 uint32_t data_len, spdk_accel_completion_cb cb_fn);
 
 /* Memory management */
 void iscsi_put_pdu(struct spdk_iscsi_pdu *pdu);
@@ -641,6 +641,45 @@ rpc_iscsi_get_connections(struct spdk_jsonrpc_request *request,
 }
 SPDK_RPC_REGISTER("iscsi_get_connections", rpc_iscsi_get_connections, SPDK_RPC_RUNTIME)
 
+static void
+rpc_iscsi_migrate_connection_done(void *cb_arg, int rc)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		return;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+
+static void
+rpc_iscsi_migrate_connection(struct spdk_jsonrpc_request *request,
+			     const struct spdk_json_val *params)
+{
+	struct rpc_iscsi_migrate_connection_ctx req = {};
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_iscsi_migrate_connection_decoders,
+				    SPDK_COUNTOF(rpc_iscsi_migrate_connection_decoders), &req)) {
+		SPDK_ERRLOG("spdk_json_decode_object() failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid parameters");
+		goto cleanup;
+	}
+
+	rc = iscsi_conn_migrate(req.id, req.thread_name, rpc_iscsi_migrate_connection_done,
+				request);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+	}
+
+cleanup:
+	free_rpc_iscsi_migrate_connection(&req);
+}
+SPDK_RPC_REGISTER("iscsi_migrate_connection", rpc_iscsi_migrate_connection, SPDK_RPC_RUNTIME)
+
 struct rpc_iscsi_get_stats_ctx {
 	struct spdk_jsonrpc_request *request;
 	uint32_t invalid;
@@ -1201,6 +1240,8 @@ rpc_iscsi_set_options(struct spdk_jsonrpc_request *request,
 	req.pdu_pool_size = opts->pdu_pool_size;
 	req.immediate_data_pool_size = opts->immediate_data_pool_size;
 	req.data_out_pool_size = opts->data_out_pool_size;
+	req.conn_balance_interval = opts->conn_balance_interval;
+	req.conn_balance_threshold = opts->conn_balance_threshold;
 
 	if (params != NULL) {
 		if (spdk_json_decode_object(params, rpc_iscsi_set_options_decoders,
@@ -1239,6 +1280,8 @@ rpc_iscsi_set_options(struct spdk_jsonrpc_request *request,
 	opts->pdu_pool_size = req.pdu_pool_size;
 	opts->immediate_data_pool_size = req.immediate_data_pool_size;
 	opts->data_out_pool_size = req.data_out_pool_size;
+	opts->conn_balance_interval = req.conn_balance_interval;
+	opts->conn_balance_threshold = req.conn_balance_threshold;
 
 	g_spdk_iscsi_opts = iscsi_opts_copy(opts);
 	iscsi_opts_free(opts);
@@ -25,6 +25,8 @@ static void *g_init_cb_arg = NULL;
 static spdk_iscsi_fini_cb g_fini_cb_fn;
 static void *g_fini_cb_arg;
 
+static struct spdk_poller *g_balance_poller = NULL;
+
 #define ISCSI_DATA_BUFFER_ALIGNMENT	(0x1000)
 #define ISCSI_DATA_BUFFER_MASK		(ISCSI_DATA_BUFFER_ALIGNMENT - 1)
 
@@ -324,6 +326,8 @@ iscsi_opts_init(struct spdk_iscsi_opts *opts)
 	opts->pdu_pool_size = PDU_POOL_SIZE(opts);
 	opts->immediate_data_pool_size = IMMEDIATE_DATA_POOL_SIZE(opts);
 	opts->data_out_pool_size = DATA_OUT_POOL_SIZE(opts);
+	opts->conn_balance_interval = DEFAULT_CONN_BALANCE_INTERVAL;
+	opts->conn_balance_threshold = DEFAULT_CONN_BALANCE_THRESHOLD;
 }
 
 struct spdk_iscsi_opts *
@@ -401,6 +405,8 @@ iscsi_opts_copy(struct spdk_iscsi_opts *src)
 	dst->pdu_pool_size = src->pdu_pool_size;
 	dst->immediate_data_pool_size = src->immediate_data_pool_size;
 	dst->data_out_pool_size = src->data_out_pool_size;
+	dst->conn_balance_interval = src->conn_balance_interval;
+	dst->conn_balance_threshold = src->conn_balance_threshold;
 
 	return dst;
 }
@@ -505,6 +511,12 @@ iscsi_opts_verify(struct spdk_iscsi_opts *opts)
 		return -EINVAL;
 	}
 
+	if (opts->conn_balance_threshold == 0 || opts->conn_balance_threshold > 100) {
+		SPDK_ERRLOG("%u is invalid. conn_balance_threshold must be between 1 and 100\n",
+			    opts->conn_balance_threshold);
+		return -EINVAL;
+	}
+
 	return 0;
 }
 
@@ -553,6 +565,8 @@ iscsi_set_global_params(struct spdk_iscsi_opts *opts)
 	g_iscsi.pdu_pool_size = opts->pdu_pool_size;
 	g_iscsi.immediate_data_pool_size = opts->immediate_data_pool_size;
 	g_iscsi.data_out_pool_size = opts->data_out_pool_size;
+	g_iscsi.conn_balance_interval = opts->conn_balance_interval;
+	g_iscsi.conn_balance_threshold = opts->conn_balance_threshold;
 
 	iscsi_log_globals();
 
@@ -917,6 +931,14 @@ iscsi_initialize_global_params(void)
 	return rc;
 }
 
+static int
+iscsi_balance_poll(void *ctx)
+{
+	iscsi_conns_balance();
+
+	return SPDK_POLLER_BUSY;
+}
+
 static void
 iscsi_init_complete(int rc)
 {
@@ -926,6 +948,12 @@ iscsi_init_complete(int rc)
 	g_init_cb_fn = NULL;
 	g_init_cb_arg = NULL;
 
+	if (rc == 0 && g_iscsi.conn_balance_interval != 0) {
+		g_balance_poller = SPDK_POLLER_REGISTER(iscsi_balance_poll, NULL,
+							g_iscsi.conn_balance_interval *
+							SPDK_SEC_TO_USEC);
+	}
+
 	cb_fn(cb_arg, rc);
 }
 
@@ -975,12 +1003,34 @@ iscsi_poll_group_poll(void *ctx)
 	return rc != 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
 }
 
+static void
+iscsi_poll_group_update_load(struct spdk_iscsi_poll_group *group)
+{
+	struct spdk_thread_stats stats;
+	uint64_t busy_tsc, idle_tsc;
+
+	if (spdk_thread_get_stats(&stats) != 0) {
+		return;
+	}
+
+	busy_tsc = stats.busy_tsc - group->last_busy_tsc;
+	idle_tsc = stats.idle_tsc - group->last_idle_tsc;
+	if (busy_tsc + idle_tsc != 0) {
+		group->busy_pct = busy_tsc * 100 / (busy_tsc + idle_tsc);
+	}
+
+	group->last_busy_tsc = stats.busy_tsc;
+	group->last_idle_tsc = stats.idle_tsc;
+}
+
 static int
 iscsi_poll_group_handle_nop(void *ctx)
 {
 	struct spdk_iscsi_poll_group *group = ctx;
 	struct spdk_iscsi_conn *conn, *tmp;
 
+	iscsi_poll_group_update_load(group);
+
 	STAILQ_FOREACH_SAFE(conn, &group->connections, pg_link, tmp) {
 		iscsi_conn_handle_nop(conn);
 	}
@@ -997,6 +1047,12 @@ iscsi_poll_group_create(void *io_device, void *ctx_buf)
 	pg->sock_group = spdk_sock_group_create(NULL);
 	assert(pg->sock_group != NULL);
 
+	/* Data digests are calculated synchronously if there is no accel channel. */
+	pg->accel_ch = spdk_accel_get_io_channel();
+	if (pg->accel_ch == NULL) {
+		SPDK_NOTICELOG("Cannot get accel channel, data digests are calculated inline\n");
+	}
+
 	pg->poller = SPDK_POLLER_REGISTER(iscsi_poll_group_poll, pg, 0);
 	/* set the period to 1 sec */
 	pg->nop_poller = SPDK_POLLER_REGISTER(iscsi_poll_group_handle_nop, pg, 1000000);
@@ -1018,6 +1074,10 @@ iscsi_poll_group_destroy(void *io_device, void *ctx_buf)
 	spdk_poller_unregister(&pg->poller);
 	spdk_poller_unregister(&pg->nop_poller);
 
+	if (pg->accel_ch != NULL) {
+		spdk_put_io_channel(pg->accel_ch);
+	}
+
 	ch = spdk_io_channel_from_ctx(pg);
 	thread = spdk_io_channel_get_thread(ch);
 
@@ -1153,6 +1213,7 @@ spdk_iscsi_fini(spdk_iscsi_fini_cb cb_fn, void *cb_arg)
 	g_fini_cb_fn = cb_fn;
 	g_fini_cb_arg = cb_arg;
 
+	spdk_poller_unregister(&g_balance_poller);
 	iscsi_portal_grp_close_all();
 	shutdown_iscsi_conns();
 }
@@ -1262,6 +1323,9 @@ iscsi_opts_info_json(struct spdk_json_write_ctx *w)
 				     g_iscsi.immediate_data_pool_size);
 	spdk_json_write_named_uint32(w, "data_out_pool_size", g_iscsi.data_out_pool_size);
 
+	spdk_json_write_named_uint32(w, "conn_balance_interval", g_iscsi.conn_balance_interval);
+	spdk_json_write_named_uint32(w, "conn_balance_threshold", g_iscsi.conn_balance_threshold);
+
 	spdk_json_write_object_end(w);
 }
 
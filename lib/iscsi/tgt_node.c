@@ -702,7 +702,7 @@ iscsi_tgt_node_check_active_conns(void *arg)
 {
 	struct spdk_iscsi_tgt_node *target = arg;
 
-	if (iscsi_get_active_conns(target) != 0) {
+	if (iscsi_get_active_conns(target) != 0 || target->migrating) {
 		return SPDK_POLLER_BUSY;
 	}
 
@@ -738,7 +738,7 @@ iscsi_tgt_node_destruct(struct spdk_iscsi_tgt_node *target,
 
 	iscsi_conns_request_logout(target, -1);
 
-	if (iscsi_get_active_conns(target) != 0) {
+	if (iscsi_get_active_conns(target) != 0 || target->migrating) {
 		target->destruct_poller = SPDK_POLLER_REGISTER(iscsi_tgt_node_check_active_conns,
 					  target, 10);
 	} else {
@@ -59,6 +59,12 @@ struct spdk_iscsi_tgt_node {
 	uint32_t num_active_conns;
 	struct spdk_iscsi_poll_group *pg;
 
+	/* Set while the connections are being moved to another poll group */
+	bool migrating;
+	/* Ticks spent handling PDUs of this target, and the value at the last balancer run */
+	uint64_t busy_tsc;
+	uint64_t balance_busy_tsc;
+
 	int num_pg_maps;
 	TAILQ_HEAD(, spdk_iscsi_pg_map) pg_map_head;
 	TAILQ_ENTRY(spdk_iscsi_tgt_node) tailq;
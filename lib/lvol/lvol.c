@@ -1649,7 +1649,7 @@ lvol_inflate_cb(void *cb_arg, int lvolerrno)
 
 	spdk_bs_free_io_channel(req->channel);
 
-	if (lvolerrno < 0) {
+	if (lvolerrno < 0 && lvolerrno != -ECANCELED) {
 		SPDK_ERRLOG("Could not inflate lvol\n");
 	}
 
@@ -1729,6 +1729,54 @@ spdk_lvol_decouple_parent(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, v
 				     lvol_inflate_cb, req);
 }
 
+void
+spdk_lvol_inflate_ext(struct spdk_lvol *lvol, const struct spdk_bs_inflate_opts *opts,
+		      spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_lvol_req *req;
+	spdk_blob_id blob_id;
+
+	assert(cb_fn != NULL);
+
+	if (lvol == NULL) {
+		SPDK_ERRLOG("Lvol does not exist\n");
+		cb_fn(cb_arg, -ENODEV);
+		return;
+	}
+
+	req = calloc(1, sizeof(*req));
+	if (!req) {
+		SPDK_ERRLOG("Cannot alloc memory for lvol request pointer\n");
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	req->cb_fn = cb_fn;
+	req->cb_arg = cb_arg;
+	req->channel = spdk_bs_alloc_io_channel(lvol->lvol_store->blobstore);
+	if (req->channel == NULL) {
+		SPDK_ERRLOG("Cannot alloc io channel for lvol inflate request\n");
+		free(req);
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	blob_id = spdk_blob_get_id(lvol->blob);
+	spdk_bs_inflate_blob_ext(lvol->lvol_store->blobstore, req->channel, blob_id, opts,
+				 lvol_inflate_cb, req);
+}
+
+int
+spdk_lvol_inflate_stop(struct spdk_lvol *lvol)
+{
+	if (lvol == NULL) {
+		SPDK_ERRLOG("Lvol does not exist\n");
+		return -ENODEV;
+	}
+
+	return spdk_bs_inflate_blob_stop(lvol->lvol_store->blobstore, spdk_blob_get_id(lvol->blob));
+}
+
 static void
 lvs_grow_live_cb(void *cb_arg, int lvolerrno)
 {
@@ -2307,6 +2355,144 @@ spdk_lvol_shallow_copy(struct spdk_lvol *lvol, struct spdk_bs_dev *ext_dev,
 	return rc;
 }
 
+static void
+lvol_get_diff_cb(void *cb_arg, int lvolerrno)
+{
+	struct spdk_lvol_req *req = cb_arg;
+
+	if (lvolerrno < 0) {
+		SPDK_ERRLOG("Could not get the changed clusters of lvol %s, error %d\n",
+			    req->lvol->unique_id, lvolerrno);
+	}
+
+	req->cb_fn(req->cb_arg, lvolerrno);
+	free(req);
+}
+
+void
+spdk_lvol_get_diff(struct spdk_lvol *lvol, struct spdk_lvol *base,
+		   spdk_blob_diff_extent_cb extent_cb_fn, void *extent_cb_arg,
+		   spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_lvol_req *req;
+	spdk_blob_id base_id = SPDK_BLOBID_INVALID;
+
+	assert(cb_fn != NULL);
+	assert(extent_cb_fn != NULL);
+
+	if (lvol == NULL) {
+		SPDK_ERRLOG("lvol must not be NULL\n");
+		cb_fn(cb_arg, -EINVAL);
+		return;
+	}
+
+	assert(lvol->lvol_store->thread == spdk_get_thread());
+
+	if (base != NULL) {
+		if (base->lvol_store != lvol->lvol_store) {
+			SPDK_ERRLOG("lvol %s and %s must belong to the same lvol store\n",
+				    lvol->unique_id, base->unique_id);
+			cb_fn(cb_arg, -EINVAL);
+			return;
+		}
+		base_id = spdk_blob_get_id(base->blob);
+	}
+
+	req = calloc(1, sizeof(*req));
+	if (!req) {
+		SPDK_ERRLOG("lvol %s diff, cannot alloc memory for lvol request\n",
+			    lvol->unique_id);
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	req->lvol = lvol;
+	req->cb_fn = cb_fn;
+	req->cb_arg = cb_arg;
+
+	spdk_bs_blob_get_diff(lvol->lvol_store->blobstore, spdk_blob_get_id(lvol->blob), base_id,
+			      extent_cb_fn, extent_cb_arg, lvol_get_diff_cb, req);
+}
+
+static void
+lvol_diff_copy_cb(void *cb_arg, int lvolerrno)
+{
+	struct spdk_lvol_copy_req *req = cb_arg;
+	struct spdk_lvol *lvol = req->lvol;
+
+	spdk_bs_free_io_channel(req->channel);
+
+	if (lvolerrno < 0) {
+		SPDK_ERRLOG("Could not make a diff copy of lvol %s, error %d\n", lvol->unique_id,
+			    lvolerrno);
+	}
+
+	req->cb_fn(req->cb_arg, lvolerrno);
+	free(req);
+}
+
+int
+spdk_lvol_diff_copy(struct spdk_lvol *lvol, struct spdk_lvol *base, struct spdk_bs_dev *ext_dev,
+		    spdk_blob_diff_copy_status status_cb_fn, void *status_cb_arg,
+		    spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_lvol_copy_req *req;
+	spdk_blob_id base_id = SPDK_BLOBID_INVALID;
+	int rc;
+
+	assert(cb_fn != NULL);
+
+	if (lvol == NULL) {
+		SPDK_ERRLOG("lvol must not be NULL\n");
+		return -EINVAL;
+	}
+
+	assert(lvol->lvol_store->thread == spdk_get_thread());
+
+	if (ext_dev == NULL) {
+		SPDK_ERRLOG("lvol %s diff copy, ext_dev must not be NULL\n", lvol->unique_id);
+		return -EINVAL;
+	}
+
+	if (base != NULL) {
+		if (base->lvol_store != lvol->lvol_store) {
+			SPDK_ERRLOG("lvol %s and %s must belong to the same lvol store\n",
+				    lvol->unique_id, base->unique_id);
+			return -EINVAL;
+		}
+		base_id = spdk_blob_get_id(base->blob);
+	}
+
+	req = calloc(1, sizeof(*req));
+	if (!req) {
+		SPDK_ERRLOG("lvol %s diff copy, cannot alloc memory for lvol request\n",
+			    lvol->unique_id);
+		return -ENOMEM;
+	}
+
+	req->lvol = lvol;
+	req->cb_fn = cb_fn;
+	req->cb_arg = cb_arg;
+	req->channel = spdk_bs_alloc_io_channel(lvol->lvol_store->blobstore);
+	if (req->channel == NULL) {
+		SPDK_ERRLOG("lvol %s diff copy, cannot alloc io channel for lvol request\n",
+			    lvol->unique_id);
+		free(req);
+		return -ENOMEM;
+	}
+
+	rc = spdk_bs_blob_diff_copy(lvol->lvol_store->blobstore, req->channel,
+				    spdk_blob_get_id(lvol->blob), base_id, ext_dev,
+				    status_cb_fn, status_cb_arg, lvol_diff_copy_cb, req);
+	if (rc < 0) {
+		SPDK_ERRLOG("Could not make a diff copy of lvol %s\n", lvol->unique_id);
+		spdk_bs_free_io_channel(req->channel);
+		free(req);
+	}
+
+	return rc;
+}
+
 static void
 lvol_set_parent_cb(void *cb_arg, int lvolerrno)
 {
@@ -21,6 +21,7 @@
 #include "spdk/queue.h"
 
 #define GET_IO_LOOP_COUNT		16
+#define NBD_XMIT_IOV_COUNT		32
 #define NBD_START_BUSY_WAITING_MS	1000
 #define NBD_STOP_BUSY_WAITING_MS	10000
 #define NBD_BUSY_POLLING_INTERVAL_US	20000
@@ -31,14 +32,12 @@ enum nbd_io_state_t {
 	NBD_IO_RECV_REQ = 0,
 	/* Receiving write payload */
 	NBD_IO_RECV_PAYLOAD,
-	/* Transmitting or ready to transmit nbd response header */
+	/* Transmitting or ready to transmit nbd response header and read payload */
 	NBD_IO_XMIT_RESP,
-	/* Transmitting read payload */
-	NBD_IO_XMIT_PAYLOAD,
 };
 
 struct nbd_io {
-	struct spdk_nbd_disk	*nbd;
+	struct nbd_conn		*conn;
 	enum nbd_io_state_t	state;
 
 	void			*payload;
@@ -59,33 +58,58 @@ struct nbd_io {
 	TAILQ_ENTRY(nbd_io)	tailq;
 };
 
-struct spdk_nbd_disk {
-	struct spdk_bdev	*bdev;
-	struct spdk_bdev_desc	*bdev_desc;
+/* One socket pair of an nbd device, polled by a single SPDK thread */
+struct nbd_conn {
+	struct spdk_nbd_disk	*nbd;
+	uint32_t		id;
+	struct spdk_thread	*thread;
 	struct spdk_io_channel	*ch;
-	int			dev_fd;
-	char			*nbd_path;
 	int			kernel_sp_fd;
 	int			spdk_sp_fd;
-	struct spdk_poller	*nbd_poller;
+	struct spdk_poller	*poller;
 	struct spdk_interrupt	*intr;
 	bool			interrupt_mode;
+
+	struct nbd_io		*io_in_recv;
+	TAILQ_HEAD(, nbd_io)	received_io_list;
+	TAILQ_HEAD(, nbd_io)	executed_io_list;
+	TAILQ_HEAD(, nbd_io)	processing_io_list;
+
+	/* No new requests are executed, set on NBD_CMD_DISC or when the device stops */
+	bool			is_closing;
+	bool			is_stopped;
+	/* count of nbd_io in nbd_conn */
+	int			io_count;
+
+	/* Data read from the socket past the request being received */
+	uint32_t		recv_head;
+	uint32_t		recv_tail;
+	uint8_t			recv_buf[GET_IO_LOOP_COUNT * sizeof(struct nbd_request)];
+};
+
+struct spdk_nbd_disk {
+	struct spdk_bdev	*bdev;
+	struct spdk_bdev_desc	*bdev_desc;
+	int			dev_fd;
+	char			*nbd_path;
 	uint32_t		buf_align;
 
+	/* Thread that started the device, it owns everything but the connections */
+	struct spdk_thread	*thread;
+	struct nbd_conn		*conns;
+	uint32_t		num_conns;
+	/* Connections still polling and connection threads still to exit */
+	uint32_t		conns_active;
+	uint32_t		threads_active;
+	bool			conns_closing;
+
 	struct spdk_poller	*retry_poller;
 	int			retry_count;
 	/* Synchronize nbd_start_kernel pthread and nbd_stop */
 	bool			has_nbd_pthread;
 
-	struct nbd_io		*io_in_recv;
-	TAILQ_HEAD(, nbd_io)	received_io_list;
-	TAILQ_HEAD(, nbd_io)	executed_io_list;
-	TAILQ_HEAD(, nbd_io)	processing_io_list;
-
 	bool			is_started;
 	bool			is_closing;
-	/* count of nbd_io in spdk_nbd_disk */
-	int			io_count;
 
 	TAILQ_ENTRY(spdk_nbd_disk)	tailq;
 };
@@ -100,8 +124,8 @@ static void *g_fini_cb_arg;
 
 static void _nbd_fini(void *arg1);
 
-static int nbd_submit_bdev_io(struct spdk_nbd_disk *nbd, struct nbd_io *io);
-static int nbd_io_recv_internal(struct spdk_nbd_disk *nbd);
+static int nbd_submit_bdev_io(struct nbd_conn *conn, struct nbd_io *io);
+static int nbd_io_recv_internal(struct nbd_conn *conn);
 
 int
 spdk_nbd_init(void)
@@ -210,6 +234,12 @@ nbd_disk_get_bdev_name(struct spdk_nbd_disk *nbd)
 	return spdk_bdev_get_name(nbd->bdev);
 }
 
+uint32_t
+nbd_disk_get_num_connections(struct spdk_nbd_disk *nbd)
+{
+	return nbd->num_conns;
+}
+
 void
 spdk_nbd_write_config_json(struct spdk_json_write_ctx *w)
 {
@@ -225,6 +255,9 @@ spdk_nbd_write_config_json(struct spdk_json_write_ctx *w)
 		spdk_json_write_named_object_begin(w, "params");
 		spdk_json_write_named_string(w, "nbd_device",  nbd_disk_get_nbd_path(nbd));
 		spdk_json_write_named_string(w, "bdev_name", nbd_disk_get_bdev_name(nbd));
+		if (nbd->num_conns > 1) {
+			spdk_json_write_named_uint32(w, "num_connections", nbd->num_conns);
+		}
 		spdk_json_write_object_end(w);
 
 		spdk_json_write_object_end(w);
@@ -245,7 +278,7 @@ nbd_disconnect(struct spdk_nbd_disk *nbd)
 }
 
 static struct nbd_io *
-nbd_get_io(struct spdk_nbd_disk *nbd)
+nbd_get_io(struct nbd_conn *conn)
 {
 	struct nbd_io *io;
 
@@ -254,76 +287,100 @@ nbd_get_io(struct spdk_nbd_disk *nbd)
 		return NULL;
 	}
 
-	io->nbd = nbd;
+	io->conn = conn;
 	to_be32(&io->resp.magic, NBD_REPLY_MAGIC);
 
-	nbd->io_count++;
+	conn->io_count++;
 
 	return io;
 }
 
 static void
-nbd_put_io(struct spdk_nbd_disk *nbd, struct nbd_io *io)
+nbd_put_io(struct nbd_conn *conn, struct nbd_io *io)
 {
 	if (io->payload) {
 		spdk_free(io->payload);
 	}
 	free(io);
 
-	nbd->io_count--;
+	conn->io_count--;
+}
+
+static void
+nbd_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct nbd_io	*io = cb_arg;
+	struct nbd_conn *conn = io->conn;
+
+	if (success) {
+		io->resp.error = 0;
+	} else {
+		to_be32(&io->resp.error, EIO);
+	}
+
+	memcpy(&io->resp.handle, &io->req.handle, sizeof(io->resp.handle));
+
+	/* When there begins to have executed_io, enable socket writable notice in order to
+	 * get it processed in nbd_io_xmit
+	 */
+	if (conn->interrupt_mode && TAILQ_EMPTY(&conn->executed_io_list)) {
+		spdk_interrupt_set_event_types(conn->intr, SPDK_INTERRUPT_EVENT_IN | SPDK_INTERRUPT_EVENT_OUT);
+	}
+
+	TAILQ_REMOVE(&conn->processing_io_list, io, tailq);
+	TAILQ_INSERT_TAIL(&conn->executed_io_list, io, tailq);
+
+	if (bdev_io != NULL) {
+		spdk_bdev_free_io(bdev_io);
+	}
 }
 
 /*
- * Check whether received nbd_io are all executed,
- * and put back executed nbd_io instead of transmitting them
- *
- * \return 1 there is still some nbd_io under executing
- *         0 all nbd_io gotten are freed.
+ * Read remaining nbd commands from the socket and fail them, as well as those
+ * received but not executed yet. Commands under execution in bdev are left
+ * for their completion.
  */
-static int
-nbd_cleanup_io(struct spdk_nbd_disk *nbd)
+static void
+nbd_cleanup_io(struct nbd_conn *conn)
 {
+	struct nbd_io *io, *io_tmp;
+
 	/* Try to read the remaining nbd commands in the socket */
-	while (nbd_io_recv_internal(nbd) > 0);
+	while (nbd_io_recv_internal(conn) > 0);
 
 	/* free io_in_recv */
-	if (nbd->io_in_recv != NULL) {
-		nbd_put_io(nbd, nbd->io_in_recv);
-		nbd->io_in_recv = NULL;
+	if (conn->io_in_recv != NULL) {
+		nbd_put_io(conn, conn->io_in_recv);
+		conn->io_in_recv = NULL;
 	}
 
-	/*
-	 * Some nbd_io may be under executing in bdev.
-	 * Wait for their done operation.
-	 */
-	if (nbd->io_count != 0) {
-		return 1;
+	TAILQ_FOREACH_SAFE(io, &conn->received_io_list, tailq, io_tmp) {
+		TAILQ_REMOVE(&conn->received_io_list, io, tailq);
+		TAILQ_INSERT_TAIL(&conn->processing_io_list, io, tailq);
+		nbd_io_done(NULL, false, io);
 	}
-
-	return 0;
 }
 
 static int
 _nbd_stop(void *arg)
 {
 	struct spdk_nbd_disk *nbd = arg;
+	struct nbd_conn *conn;
+	uint32_t i;
 
-	if (nbd->nbd_poller) {
-		spdk_poller_unregister(&nbd->nbd_poller);
-	}
+	for (i = 0; nbd->conns != NULL && i < nbd->num_conns; i++) {
+		conn = &nbd->conns[i];
+		assert(conn->poller == NULL);
 
-	if (nbd->intr) {
-		spdk_interrupt_unregister(&nbd->intr);
-	}
-
-	if (nbd->spdk_sp_fd >= 0) {
-		close(nbd->spdk_sp_fd);
-		nbd->spdk_sp_fd = -1;
-	}
+		if (conn->spdk_sp_fd >= 0) {
+			close(conn->spdk_sp_fd);
+			conn->spdk_sp_fd = -1;
+		}
 
-	if (nbd->kernel_sp_fd >= 0) {
-		close(nbd->kernel_sp_fd);
-		nbd->kernel_sp_fd = -1;
+		if (conn->kernel_sp_fd >= 0) {
+			close(conn->kernel_sp_fd);
+			conn->kernel_sp_fd = -1;
+		}
 	}
 
 	/* Continue the stop procedure after the exit of nbd_start_kernel pthread */
@@ -359,11 +416,6 @@ _nbd_stop(void *arg)
 		free(nbd->nbd_path);
 	}
 
-	if (nbd->ch) {
-		spdk_put_io_channel(nbd->ch);
-		nbd->ch = NULL;
-	}
-
 	if (nbd->bdev_desc) {
 		spdk_bdev_close(nbd->bdev_desc);
 		nbd->bdev_desc = NULL;
@@ -371,102 +423,154 @@ _nbd_stop(void *arg)
 
 	nbd_disk_unregister(nbd);
 
+	free(nbd->conns);
 	free(nbd);
 
 	return 0;
 }
 
-int
-spdk_nbd_stop(struct spdk_nbd_disk *nbd)
+static void
+nbd_conn_thread_exited(void *arg)
 {
-	int rc = 0;
+	struct spdk_nbd_disk *nbd = arg;
 
-	if (nbd == NULL) {
-		return rc;
+	assert(nbd->threads_active > 0);
+	if (--nbd->threads_active == 0) {
+		_nbd_stop(nbd);
 	}
+}
 
-	nbd->is_closing = true;
+static void
+nbd_conn_thread_exit(void *arg)
+{
+	struct nbd_conn *conn = arg;
 
-	/* if nbd is not started, it will continue to call nbd stop later */
-	if (!nbd->is_started) {
-		return 1;
+	/* Any message the device thread sent to this connection is processed by now */
+	spdk_thread_exit(conn->thread);
+	spdk_thread_send_msg(conn->nbd->thread, nbd_conn_thread_exited, conn->nbd);
+}
+
+static void
+nbd_conn_stopped(void *arg)
+{
+	struct nbd_conn *conn = arg;
+	struct spdk_nbd_disk *nbd = conn->nbd;
+	uint32_t i;
+
+	assert(nbd->conns_active > 0);
+	if (--nbd->conns_active > 0) {
+		/* The device cannot keep serving with one of its connections gone */
+		spdk_nbd_stop(nbd);
+		return;
 	}
 
-	/*
-	 * Stop action should be called only after all nbd_io are executed.
-	 */
+	nbd->is_closing = true;
 
-	rc = nbd_cleanup_io(nbd);
-	if (!rc) {
-		_nbd_stop(nbd);
+	for (i = 0; i < nbd->num_conns; i++) {
+		conn = &nbd->conns[i];
+		if (conn->thread != nbd->thread) {
+			nbd->threads_active++;
+			spdk_thread_send_msg(conn->thread, nbd_conn_thread_exit, conn);
+		}
 	}
 
-	return rc;
+	if (nbd->threads_active == 0) {
+		_nbd_stop(nbd);
+	}
 }
 
-static int64_t
-nbd_socket_rw(int fd, void *buf, size_t length, bool read_op)
+static void
+nbd_conn_stop(struct nbd_conn *conn)
 {
-	ssize_t rc;
+	spdk_poller_unregister(&conn->poller);
 
-	if (read_op) {
-		rc = read(fd, buf, length);
-	} else {
-		rc = write(fd, buf, length);
+	if (conn->intr) {
+		spdk_interrupt_unregister(&conn->intr);
 	}
 
-	if (rc == 0) {
-		return -EIO;
-	} else if (rc == -1) {
-		if (errno != EAGAIN) {
-			return -errno;
-		}
-		return 0;
-	} else {
-		return rc;
+	if (conn->ch) {
+		spdk_put_io_channel(conn->ch);
+		conn->ch = NULL;
+	}
+
+	/* Closing our end of the socket pair tells the kernel this connection is gone */
+	if (conn->spdk_sp_fd >= 0) {
+		close(conn->spdk_sp_fd);
+		conn->spdk_sp_fd = -1;
 	}
+
+	conn->is_stopped = true;
+	spdk_thread_send_msg(conn->nbd->thread, nbd_conn_stopped, conn);
 }
 
 static void
-nbd_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+nbd_conn_close(void *arg)
 {
-	struct nbd_io	*io = cb_arg;
-	struct spdk_nbd_disk *nbd = io->nbd;
+	struct nbd_conn *conn = arg;
 
-	if (success) {
-		io->resp.error = 0;
-	} else {
-		to_be32(&io->resp.error, EIO);
+	if (conn->is_stopped) {
+		return;
 	}
 
-	memcpy(&io->resp.handle, &io->req.handle, sizeof(io->resp.handle));
+	conn->is_closing = true;
+	nbd_cleanup_io(conn);
 
-	/* When there begins to have executed_io, enable socket writable notice in order to
-	 * get it processed in nbd_io_xmit
+	/*
+	 * Otherwise the poller stops the connection once the remaining nbd_io
+	 * are executed and their responses transmitted.
 	 */
-	if (nbd->interrupt_mode && TAILQ_EMPTY(&nbd->executed_io_list)) {
-		spdk_interrupt_set_event_types(nbd->intr, SPDK_INTERRUPT_EVENT_IN | SPDK_INTERRUPT_EVENT_OUT);
+	if (conn->io_count == 0) {
+		nbd_conn_stop(conn);
 	}
+}
 
-	TAILQ_REMOVE(&nbd->processing_io_list, io, tailq);
-	TAILQ_INSERT_TAIL(&nbd->executed_io_list, io, tailq);
+int
+spdk_nbd_stop(struct spdk_nbd_disk *nbd)
+{
+	struct nbd_conn *conn;
+	uint32_t i;
 
-	if (bdev_io != NULL) {
-		spdk_bdev_free_io(bdev_io);
+	if (nbd == NULL) {
+		return 0;
+	}
+
+	nbd->is_closing = true;
+
+	/* if nbd is not started, it will continue to call nbd stop later */
+	if (!nbd->is_started) {
+		return 1;
+	}
+
+	/*
+	 * Each connection stops on its own thread after all of its nbd_io are
+	 * executed. The last one to stop releases the device.
+	 */
+	if (!nbd->conns_closing) {
+		nbd->conns_closing = true;
+		for (i = 0; i < nbd->num_conns; i++) {
+			conn = &nbd->conns[i];
+			if (conn->thread == nbd->thread) {
+				nbd_conn_close(conn);
+			} else {
+				spdk_thread_send_msg(conn->thread, nbd_conn_close, conn);
+			}
+		}
 	}
+
+	return 1;
 }
 
 static void
 nbd_resubmit_io(void *arg)
 {
 	struct nbd_io *io = (struct nbd_io *)arg;
-	struct spdk_nbd_disk *nbd = io->nbd;
+	struct nbd_conn *conn = io->conn;
 	int rc = 0;
 
-	rc = nbd_submit_bdev_io(nbd, io);
+	rc = nbd_submit_bdev_io(conn, io);
 	if (rc) {
 		SPDK_INFOLOG(nbd, "nbd: io resubmit for dev %s , io_type %d, returned %d.\n",
-			     nbd_disk_get_bdev_name(nbd), from_be32(&io->req.type), rc);
+			     nbd_disk_get_bdev_name(conn->nbd), from_be32(&io->req.type), rc);
 	}
 }
 
@@ -474,13 +578,13 @@ static void
 nbd_queue_io(struct nbd_io *io)
 {
 	int rc;
-	struct spdk_bdev *bdev = io->nbd->bdev;
+	struct spdk_bdev *bdev = io->conn->nbd->bdev;
 
 	io->bdev_io_wait.bdev = bdev;
 	io->bdev_io_wait.cb_fn = nbd_resubmit_io;
 	io->bdev_io_wait.cb_arg = io;
 
-	rc = spdk_bdev_queue_io_wait(bdev, io->nbd->ch, &io->bdev_io_wait);
+	rc = spdk_bdev_queue_io_wait(bdev, io->conn->ch, &io->bdev_io_wait);
 	if (rc != 0) {
 		SPDK_ERRLOG("Queue io failed in nbd_queue_io, rc=%d.\n", rc);
 		nbd_io_done(NULL, false, io);
@@ -488,10 +592,11 @@ nbd_queue_io(struct nbd_io *io)
 }
 
 static int
-nbd_submit_bdev_io(struct spdk_nbd_disk *nbd, struct nbd_io *io)
+nbd_submit_bdev_io(struct nbd_conn *conn, struct nbd_io *io)
 {
+	struct spdk_nbd_disk *nbd = conn->nbd;
 	struct spdk_bdev_desc *desc = nbd->bdev_desc;
-	struct spdk_io_channel *ch = nbd->ch;
+	struct spdk_io_channel *ch = conn->ch;
 	int rc = 0;
 
 	switch (from_be32(&io->req.type)) {
@@ -534,16 +639,16 @@ nbd_submit_bdev_io(struct spdk_nbd_disk *nbd, struct nbd_io *io)
 }
 
 static int
-nbd_io_exec(struct spdk_nbd_disk *nbd)
+nbd_io_exec(struct nbd_conn *conn)
 {
 	struct nbd_io *io, *io_tmp;
 	int io_count = 0;
 	int ret = 0;
 
-	TAILQ_FOREACH_SAFE(io, &nbd->received_io_list, tailq, io_tmp) {
-		TAILQ_REMOVE(&nbd->received_io_list, io, tailq);
-		TAILQ_INSERT_TAIL(&nbd->processing_io_list, io, tailq);
-		ret = nbd_submit_bdev_io(nbd, io);
+	TAILQ_FOREACH_SAFE(io, &conn->received_io_list, tailq, io_tmp) {
+		TAILQ_REMOVE(&conn->received_io_list, io, tailq);
+		TAILQ_INSERT_TAIL(&conn->processing_io_list, io, tailq);
+		ret = nbd_submit_bdev_io(conn, io);
 		if (ret < 0) {
 			return ret;
 		}
@@ -554,28 +659,78 @@ nbd_io_exec(struct spdk_nbd_disk *nbd)
 	return io_count;
 }
 
+/*
+ * Receive up to length bytes into buf. Data already buffered by a previous read
+ * is consumed first. Otherwise a single readv() fills buf directly and buffers
+ * whatever the kernel queued behind it, so that a batch of request headers is
+ * picked up with one system call without copying write payloads.
+ *
+ * \return number of bytes stored into buf, 0 if the socket has no data
+ *         or negated errno values on error.
+ */
+static int64_t
+nbd_conn_recv(struct nbd_conn *conn, void *buf, uint32_t length)
+{
+	struct iovec iov[2];
+	ssize_t rc;
+
+	if (conn->recv_head == conn->recv_tail) {
+		conn->recv_head = 0;
+		conn->recv_tail = 0;
+
+		iov[0].iov_base = buf;
+		iov[0].iov_len = length;
+		iov[1].iov_base = conn->recv_buf;
+		iov[1].iov_len = sizeof(conn->recv_buf);
+
+		rc = readv(conn->spdk_sp_fd, iov, SPDK_COUNTOF(iov));
+		if (rc == 0) {
+			return -EIO;
+		} else if (rc == -1) {
+			if (errno != EAGAIN) {
+				return -errno;
+			}
+			return 0;
+		}
+
+		if ((size_t)rc > length) {
+			conn->recv_tail = rc - length;
+			return length;
+		}
+
+		return rc;
+	}
+
+	length = spdk_min(length, conn->recv_tail - conn->recv_head);
+	memcpy(buf, conn->recv_buf + conn->recv_head, length);
+	conn->recv_head += length;
+
+	return length;
+}
+
 static int
-nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
+nbd_io_recv_internal(struct nbd_conn *conn)
 {
+	struct spdk_nbd_disk *nbd = conn->nbd;
 	struct nbd_io *io;
 	int ret = 0;
 	int received = 0;
 
-	if (nbd->io_in_recv == NULL) {
-		nbd->io_in_recv = nbd_get_io(nbd);
-		if (!nbd->io_in_recv) {
+	if (conn->io_in_recv == NULL) {
+		conn->io_in_recv = nbd_get_io(conn);
+		if (!conn->io_in_recv) {
 			return -ENOMEM;
 		}
 	}
 
-	io = nbd->io_in_recv;
+	io = conn->io_in_recv;
 
 	if (io->state == NBD_IO_RECV_REQ) {
-		ret = nbd_socket_rw(nbd->spdk_sp_fd, (char *)&io->req + io->offset,
-				    sizeof(io->req) - io->offset, true);
+		ret = nbd_conn_recv(conn, (char *)&io->req + io->offset,
+				    sizeof(io->req) - io->offset);
 		if (ret < 0) {
-			nbd_put_io(nbd, io);
-			nbd->io_in_recv = NULL;
+			nbd_put_io(conn, io);
+			conn->io_in_recv = NULL;
 			return ret;
 		}
 
@@ -589,18 +744,18 @@ nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 			/* req magic check */
 			if (from_be32(&io->req.magic) != NBD_REQUEST_MAGIC) {
 				SPDK_ERRLOG("invalid request magic\n");
-				nbd_put_io(nbd, io);
-				nbd->io_in_recv = NULL;
+				nbd_put_io(conn, io);
+				conn->io_in_recv = NULL;
 				return -EINVAL;
 			}
 
 			if (from_be32(&io->req.type) == NBD_CMD_DISC) {
-				nbd->is_closing = true;
-				nbd->io_in_recv = NULL;
-				if (nbd->interrupt_mode && TAILQ_EMPTY(&nbd->executed_io_list)) {
-					spdk_interrupt_set_event_types(nbd->intr, SPDK_INTERRUPT_EVENT_IN | SPDK_INTERRUPT_EVENT_OUT);
+				conn->is_closing = true;
+				conn->io_in_recv = NULL;
+				if (conn->interrupt_mode && TAILQ_EMPTY(&conn->executed_io_list)) {
+					spdk_interrupt_set_event_types(conn->intr, SPDK_INTERRUPT_EVENT_IN | SPDK_INTERRUPT_EVENT_OUT);
 				}
-				nbd_put_io(nbd, io);
+				nbd_put_io(conn, io);
 				/* After receiving NBD_CMD_DISC, nbd will not receive any new commands */
 				return received;
 			}
@@ -619,8 +774,8 @@ nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 							  SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
 				if (io->payload == NULL) {
 					SPDK_ERRLOG("could not allocate io->payload of size %d\n", io->payload_size);
-					nbd_put_io(nbd, io);
-					nbd->io_in_recv = NULL;
+					nbd_put_io(conn, io);
+					conn->io_in_recv = NULL;
 					return -ENOMEM;
 				}
 			} else {
@@ -632,22 +787,22 @@ nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 				io->state = NBD_IO_RECV_PAYLOAD;
 			} else {
 				io->state = NBD_IO_XMIT_RESP;
-				if (spdk_likely((!nbd->is_closing) && nbd->is_started)) {
-					TAILQ_INSERT_TAIL(&nbd->received_io_list, io, tailq);
+				if (spdk_likely(!conn->is_closing)) {
+					TAILQ_INSERT_TAIL(&conn->received_io_list, io, tailq);
 				} else {
-					TAILQ_INSERT_TAIL(&nbd->processing_io_list, io, tailq);
+					TAILQ_INSERT_TAIL(&conn->processing_io_list, io, tailq);
 					nbd_io_done(NULL, false, io);
 				}
-				nbd->io_in_recv = NULL;
+				conn->io_in_recv = NULL;
 			}
 		}
 	}
 
 	if (io->state == NBD_IO_RECV_PAYLOAD) {
-		ret = nbd_socket_rw(nbd->spdk_sp_fd, io->payload + io->offset, io->payload_size - io->offset, true);
+		ret = nbd_conn_recv(conn, io->payload + io->offset, io->payload_size - io->offset);
 		if (ret < 0) {
-			nbd_put_io(nbd, io);
-			nbd->io_in_recv = NULL;
+			nbd_put_io(conn, io);
+			conn->io_in_recv = NULL;
 			return ret;
 		}
 
@@ -658,13 +813,13 @@ nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 		if (io->offset == io->payload_size) {
 			io->offset = 0;
 			io->state = NBD_IO_XMIT_RESP;
-			if (spdk_likely((!nbd->is_closing) && nbd->is_started)) {
-				TAILQ_INSERT_TAIL(&nbd->received_io_list, io, tailq);
+			if (spdk_likely(!conn->is_closing)) {
+				TAILQ_INSERT_TAIL(&conn->received_io_list, io, tailq);
 			} else {
-				TAILQ_INSERT_TAIL(&nbd->processing_io_list, io, tailq);
+				TAILQ_INSERT_TAIL(&conn->processing_io_list, io, tailq);
 				nbd_io_done(NULL, false, io);
 			}
-			nbd->io_in_recv = NULL;
+			conn->io_in_recv = NULL;
 		}
 
 	}
@@ -673,142 +828,154 @@ nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 }
 
 static int
-nbd_io_recv(struct spdk_nbd_disk *nbd)
+nbd_io_recv(struct nbd_conn *conn)
 {
 	int i, rc, ret = 0;
 
 	/*
 	 * nbd server should not accept request after closing command
 	 */
-	if (nbd->is_closing) {
+	if (conn->is_closing) {
 		return 0;
 	}
 
-	for (i = 0; i < GET_IO_LOOP_COUNT; i++) {
-		rc = nbd_io_recv_internal(nbd);
+	/*
+	 * Buffered data does not raise socket events in interrupt mode,
+	 * so consume all of it even beyond the per-poll request limit.
+	 */
+	for (i = 0; i < GET_IO_LOOP_COUNT || conn->recv_head != conn->recv_tail; i++) {
+		rc = nbd_io_recv_internal(conn);
 		if (rc < 0) {
 			return rc;
 		}
-		ret += rc;
-		if (nbd->is_closing) {
+		if (rc == 0 || conn->is_closing) {
 			break;
 		}
+		ret += rc;
 	}
 
 	return ret;
 }
 
-static int
-nbd_io_xmit_internal(struct spdk_nbd_disk *nbd)
+static uint32_t
+nbd_io_xmit_size(struct nbd_io *io)
 {
-	struct nbd_io *io;
-	int ret = 0;
-	int sent = 0;
-
-	io = TAILQ_FIRST(&nbd->executed_io_list);
-	if (io == NULL) {
-		return 0;
+	/* transmit payload only when NBD_CMD_READ with no resp error */
+	if (from_be32(&io->req.type) == NBD_CMD_READ && io->resp.error == 0) {
+		return sizeof(io->resp) + io->payload_size;
 	}
 
-	/* Remove IO from list now assuming it will be completed.  It will be inserted
-	 *  back to the head if it cannot be completed.  This approach is specifically
-	 *  taken to work around a scan-build use-after-free mischaracterization.
-	 */
-	TAILQ_REMOVE(&nbd->executed_io_list, io, tailq);
+	return sizeof(io->resp);
+}
 
-	/* resp error and handler are already set in io_done */
+/*
+ * Transmit responses of executed nbd_io, gathering the headers and read payloads
+ * of as many of them as fit in one writev(). io->offset tracks the progress over
+ * the response header followed by the payload.
+ */
+static int
+nbd_io_xmit_internal(struct nbd_conn *conn)
+{
+	struct iovec iov[NBD_XMIT_IOV_COUNT];
+	struct nbd_io *io, *io_tmp;
+	int iovcnt = 0;
+	uint32_t offset, remaining;
+	ssize_t rc, sent;
 
-	if (io->state == NBD_IO_XMIT_RESP) {
-		ret = nbd_socket_rw(nbd->spdk_sp_fd, (char *)&io->resp + io->offset,
-				    sizeof(io->resp) - io->offset, false);
-		if (ret <= 0) {
-			goto reinsert;
+	/* resp error and handler are already set in io_done */
+	TAILQ_FOREACH(io, &conn->executed_io_list, tailq) {
+		if (iovcnt + 2 > NBD_XMIT_IOV_COUNT) {
+			break;
 		}
 
-		io->offset += ret;
-		sent = ret;
-
-		/* response is fully transmitted */
-		if (io->offset == sizeof(io->resp)) {
-			io->offset = 0;
+		if (io->offset < sizeof(io->resp)) {
+			iov[iovcnt].iov_base = (char *)&io->resp + io->offset;
+			iov[iovcnt].iov_len = sizeof(io->resp) - io->offset;
+			iovcnt++;
+		}
 
-			/* transmit payload only when NBD_CMD_READ with no resp error */
-			if (from_be32(&io->req.type) != NBD_CMD_READ || io->resp.error != 0) {
-				nbd_put_io(nbd, io);
-				return 0;
-			} else {
-				io->state = NBD_IO_XMIT_PAYLOAD;
-			}
+		if (nbd_io_xmit_size(io) > sizeof(io->resp)) {
+			offset = io->offset > sizeof(io->resp) ? io->offset - sizeof(io->resp) : 0;
+			iov[iovcnt].iov_base = (char *)io->payload + offset;
+			iov[iovcnt].iov_len = io->payload_size - offset;
+			iovcnt++;
 		}
 	}
 
-	if (io->state == NBD_IO_XMIT_PAYLOAD) {
-		ret = nbd_socket_rw(nbd->spdk_sp_fd, io->payload + io->offset, io->payload_size - io->offset,
-				    false);
-		if (ret <= 0) {
-			goto reinsert;
+	rc = writev(conn->spdk_sp_fd, iov, iovcnt);
+	if (rc == -1) {
+		if (errno != EAGAIN) {
+			return -errno;
 		}
+		return 0;
+	}
 
-		io->offset += ret;
-		sent += ret;
-
-		/* read payload is fully transmitted */
-		if (io->offset == io->payload_size) {
-			nbd_put_io(nbd, io);
-			return sent;
+	sent = rc;
+	TAILQ_FOREACH_SAFE(io, &conn->executed_io_list, tailq, io_tmp) {
+		remaining = nbd_io_xmit_size(io) - io->offset;
+		if ((size_t)rc < remaining) {
+			io->offset += rc;
+			break;
 		}
+
+		/* response is fully transmitted */
+		rc -= remaining;
+		TAILQ_REMOVE(&conn->executed_io_list, io, tailq);
+		nbd_put_io(conn, io);
 	}
 
-reinsert:
-	TAILQ_INSERT_HEAD(&nbd->executed_io_list, io, tailq);
-	return ret < 0 ? ret : sent;
+	return sent;
 }
 
 static int
-nbd_io_xmit(struct spdk_nbd_disk *nbd)
+nbd_io_xmit(struct nbd_conn *conn)
 {
 	int ret = 0;
 	int rc;
 
-	while (!TAILQ_EMPTY(&nbd->executed_io_list)) {
-		rc = nbd_io_xmit_internal(nbd);
+	while (!TAILQ_EMPTY(&conn->executed_io_list)) {
+		rc = nbd_io_xmit_internal(conn);
 		if (rc < 0) {
 			return rc;
 		}
+		if (rc == 0) {
+			/* socket is full, keep the writable notice to resume */
+			return ret;
+		}
 
 		ret += rc;
 	}
 
 	/* When there begins to have no executed_io, disable socket writable notice */
-	if (nbd->interrupt_mode) {
-		spdk_interrupt_set_event_types(nbd->intr, SPDK_INTERRUPT_EVENT_IN);
+	if (conn->interrupt_mode) {
+		spdk_interrupt_set_event_types(conn->intr, SPDK_INTERRUPT_EVENT_IN);
 	}
 
 	return ret;
 }
 
 /**
- * Poll an NBD instance.
+ * Poll an NBD connection.
  *
  * \return 0 on success or negated errno values on error (e.g. connection closed).
  */
 static int
-_nbd_poll(struct spdk_nbd_disk *nbd)
+_nbd_poll(struct nbd_conn *conn)
 {
 	int received, sent, executed;
 
 	/* transmit executed io first */
-	sent = nbd_io_xmit(nbd);
+	sent = nbd_io_xmit(conn);
 	if (sent < 0) {
 		return sent;
 	}
 
-	received = nbd_io_recv(nbd);
+	received = nbd_io_recv(conn);
 	if (received < 0) {
 		return received;
 	}
 
-	executed = nbd_io_exec(nbd);
+	executed = nbd_io_exec(conn);
 	if (executed < 0) {
 		return executed;
 	}
@@ -819,21 +986,97 @@ _nbd_poll(struct spdk_nbd_disk *nbd)
 static int
 nbd_poll(void *arg)
 {
-	struct spdk_nbd_disk *nbd = arg;
+	struct nbd_conn *conn = arg;
+	struct nbd_io *io, *io_tmp;
 	int rc;
 
-	rc = _nbd_poll(nbd);
+	rc = _nbd_poll(conn);
 	if (rc < 0) {
-		SPDK_INFOLOG(nbd, "nbd_poll() returned %s (%d); closing connection\n",
-			     spdk_strerror(-rc), rc);
-		_nbd_stop(nbd);
-		return SPDK_POLLER_IDLE;
+		if (!conn->is_closing) {
+			SPDK_INFOLOG(nbd, "nbd_poll() returned %s (%d); closing connection %u\n",
+				     spdk_strerror(-rc), rc, conn->id);
+			conn->is_closing = true;
+		}
+
+		/* Responses cannot be delivered anymore, wait for the bdev only */
+		nbd_cleanup_io(conn);
+		TAILQ_FOREACH_SAFE(io, &conn->executed_io_list, tailq, io_tmp) {
+			TAILQ_REMOVE(&conn->executed_io_list, io, tailq);
+			nbd_put_io(conn, io);
+		}
 	}
-	if (nbd->is_closing && nbd->io_count == 0) {
-		spdk_nbd_stop(nbd);
+	if (conn->is_closing && conn->io_count == 0) {
+		nbd_conn_stop(conn);
+		return SPDK_POLLER_BUSY;
 	}
 
-	return rc == 0 ? SPDK_POLLER_IDLE : SPDK_POLLER_BUSY;
+	return rc <= 0 ? SPDK_POLLER_IDLE : SPDK_POLLER_BUSY;
+}
+
+static void
+nbd_poller_set_interrupt_mode(struct spdk_poller *poller, void *cb_arg, bool interrupt_mode)
+{
+	struct nbd_conn *conn = cb_arg;
+
+	conn->interrupt_mode = interrupt_mode;
+}
+
+static void
+nbd_conn_start(void *arg)
+{
+	struct nbd_conn *conn = arg;
+
+	conn->ch = spdk_bdev_get_io_channel(conn->nbd->bdev_desc);
+	if (conn->ch == NULL) {
+		SPDK_ERRLOG("could not get io channel for %s connection %u\n",
+			    conn->nbd->nbd_path, conn->id);
+		conn->is_closing = true;
+	}
+
+	if (spdk_interrupt_mode_is_enabled()) {
+		conn->intr = SPDK_INTERRUPT_REGISTER(conn->spdk_sp_fd, nbd_poll, conn);
+	}
+
+	conn->poller = SPDK_POLLER_REGISTER(nbd_poll, conn, 0);
+	spdk_poller_register_interrupt(conn->poller, nbd_poller_set_interrupt_mode, conn);
+}
+
+/*
+ * The first connection is polled by the thread starting the device. Each other
+ * one gets a thread of its own, which the scheduler places on another reactor.
+ */
+static void
+nbd_start_conns(struct spdk_nbd_disk *nbd)
+{
+	struct nbd_conn *conn;
+	const char *dev_name;
+	char thread_name[32];
+	uint32_t i;
+
+	dev_name = strrchr(nbd->nbd_path, '/');
+	dev_name = dev_name ? dev_name + 1 : nbd->nbd_path;
+
+	for (i = 0; i < nbd->num_conns; i++) {
+		conn = &nbd->conns[i];
+		conn->thread = nbd->thread;
+
+		if (i > 0) {
+			snprintf(thread_name, sizeof(thread_name), "%s_conn%u", dev_name, i);
+			conn->thread = spdk_thread_create(thread_name, NULL);
+			if (conn->thread == NULL) {
+				SPDK_ERRLOG("could not create thread for %s connection %u\n",
+					    nbd->nbd_path, i);
+				conn->thread = nbd->thread;
+			}
+		}
+
+		nbd->conns_active++;
+		if (conn->thread == nbd->thread) {
+			nbd_conn_start(conn);
+		} else {
+			spdk_thread_send_msg(conn->thread, nbd_conn_start, conn);
+		}
+	}
 }
 
 struct spdk_nbd_start_ctx {
@@ -847,13 +1090,19 @@ static void
 nbd_start_complete(void *arg)
 {
 	struct spdk_nbd_start_ctx *ctx = arg;
+	struct spdk_nbd_disk *nbd = ctx->nbd;
+
+	nbd_start_conns(nbd);
 
 	if (ctx->cb_fn) {
-		ctx->cb_fn(ctx->cb_arg, ctx->nbd, 0);
+		ctx->cb_fn(ctx->cb_arg, nbd, 0);
 	}
 
 	/* nbd will possibly receive stop command while initing */
-	ctx->nbd->is_started = true;
+	nbd->is_started = true;
+	if (nbd->is_closing) {
+		spdk_nbd_stop(nbd);
+	}
 
 	free(ctx);
 }
@@ -883,15 +1132,7 @@ nbd_start_kernel(void *arg)
 static void
 nbd_bdev_hot_remove(struct spdk_nbd_disk *nbd)
 {
-	struct nbd_io *io, *io_tmp;
-
-	nbd->is_closing = true;
-	nbd_cleanup_io(nbd);
-
-	TAILQ_FOREACH_SAFE(io, &nbd->received_io_list, tailq, io_tmp) {
-		TAILQ_REMOVE(&nbd->received_io_list, io, tailq);
-		nbd_io_done(NULL, false, io);
-	}
+	spdk_nbd_stop(nbd);
 }
 
 static void
@@ -908,14 +1149,6 @@ nbd_bdev_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev,
 	}
 }
 
-static void
-nbd_poller_set_interrupt_mode(struct spdk_poller *poller, void *cb_arg, bool interrupt_mode)
-{
-	struct spdk_nbd_disk *nbd = cb_arg;
-
-	nbd->interrupt_mode = interrupt_mode;
-}
-
 static void
 nbd_start_continue(struct spdk_nbd_start_ctx *ctx)
 {
@@ -958,6 +1191,11 @@ nbd_start_continue(struct spdk_nbd_start_ctx *ctx)
 		nbd_flags |= NBD_FLAG_SEND_TRIM;
 	}
 #endif
+#ifdef NBD_FLAG_CAN_MULTI_CONN
+	if (ctx->nbd->num_conns > 1) {
+		nbd_flags |= NBD_FLAG_CAN_MULTI_CONN;
+	}
+#endif
 
 	if (nbd_flags) {
 		rc = ioctl(ctx->nbd->dev_fd, NBD_SET_FLAGS, nbd_flags);
@@ -984,12 +1222,6 @@ nbd_start_continue(struct spdk_nbd_start_ctx *ctx)
 		goto err;
 	}
 
-	if (spdk_interrupt_mode_is_enabled()) {
-		ctx->nbd->intr = SPDK_INTERRUPT_REGISTER(ctx->nbd->spdk_sp_fd, nbd_poll, ctx->nbd);
-	}
-
-	ctx->nbd->nbd_poller = SPDK_POLLER_REGISTER(nbd_poll, ctx->nbd, 0);
-	spdk_poller_register_interrupt(ctx->nbd->nbd_poller, nbd_poller_set_interrupt_mode, ctx->nbd);
 	return;
 
 err:
@@ -1004,13 +1236,22 @@ static int
 nbd_enable_kernel(void *arg)
 {
 	struct spdk_nbd_start_ctx *ctx = arg;
-	int rc;
+	uint32_t i;
+	int rc = 0;
 
-	/* Declare device setup by this process */
-	rc = ioctl(ctx->nbd->dev_fd, NBD_SET_SOCK, ctx->nbd->kernel_sp_fd);
+	/*
+	 * Declare device setup by this process. The kernel only accepts further
+	 * sockets from the task that added the first one, so add them all at once.
+	 */
+	for (i = 0; i < ctx->nbd->num_conns; i++) {
+		rc = ioctl(ctx->nbd->dev_fd, NBD_SET_SOCK, ctx->nbd->conns[i].kernel_sp_fd);
+		if (rc) {
+			break;
+		}
+	}
 
 	if (rc) {
-		if (errno == EBUSY) {
+		if (errno == EBUSY && i == 0) {
 			if (ctx->nbd->retry_poller == NULL) {
 				ctx->nbd->retry_count = NBD_START_BUSY_WAITING_MS * 1000ULL / NBD_BUSY_POLLING_INTERVAL_US;
 				ctx->nbd->retry_poller = SPDK_POLLER_REGISTER(nbd_enable_kernel, ctx,
@@ -1025,7 +1266,8 @@ nbd_enable_kernel(void *arg)
 			}
 		}
 
-		SPDK_ERRLOG("ioctl(NBD_SET_SOCK) failed: %s\n", spdk_strerror(errno));
+		rc = -errno;
+		SPDK_ERRLOG("ioctl(NBD_SET_SOCK) failed: %s\n", spdk_strerror(-rc));
 		if (ctx->nbd->retry_poller) {
 			spdk_poller_unregister(&ctx->nbd->retry_poller);
 		}
@@ -1033,7 +1275,7 @@ nbd_enable_kernel(void *arg)
 		_nbd_stop(ctx->nbd);
 
 		if (ctx->cb_fn) {
-			ctx->cb_fn(ctx->cb_arg, NULL, -errno);
+			ctx->cb_fn(ctx->cb_arg, NULL, rc);
 		}
 
 		free(ctx);
@@ -1050,15 +1292,23 @@ nbd_enable_kernel(void *arg)
 }
 
 void
-spdk_nbd_start(const char *bdev_name, const char *nbd_path,
-	       spdk_nbd_start_cb cb_fn, void *cb_arg)
+spdk_nbd_start_ext(const char *bdev_name, const char *nbd_path, uint32_t num_connections,
+		   spdk_nbd_start_cb cb_fn, void *cb_arg)
 {
 	struct spdk_nbd_start_ctx	*ctx = NULL;
 	struct spdk_nbd_disk		*nbd = NULL;
 	struct spdk_bdev		*bdev;
+	struct nbd_conn			*conn;
+	uint32_t			i;
 	int				rc;
 	int				sp[2];
 
+	if (num_connections == 0 || num_connections > SPDK_NBD_MAX_CONNECTIONS) {
+		SPDK_ERRLOG("num_connections must be between 1 and %u\n", SPDK_NBD_MAX_CONNECTIONS);
+		rc = -EINVAL;
+		goto err;
+	}
+
 	nbd = calloc(1, sizeof(*nbd));
 	if (nbd == NULL) {
 		rc = -ENOMEM;
@@ -1066,8 +1316,25 @@ spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 	}
 
 	nbd->dev_fd = -1;
-	nbd->spdk_sp_fd = -1;
-	nbd->kernel_sp_fd = -1;
+	nbd->thread = spdk_get_thread();
+
+	nbd->conns = calloc(num_connections, sizeof(*nbd->conns));
+	if (nbd->conns == NULL) {
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	nbd->num_conns = num_connections;
+	for (i = 0; i < num_connections; i++) {
+		conn = &nbd->conns[i];
+		conn->nbd = nbd;
+		conn->id = i;
+		conn->spdk_sp_fd = -1;
+		conn->kernel_sp_fd = -1;
+		TAILQ_INIT(&conn->received_io_list);
+		TAILQ_INIT(&conn->executed_io_list);
+		TAILQ_INIT(&conn->processing_io_list);
+	}
 
 	ctx = calloc(1, sizeof(*ctx));
 	if (ctx == NULL) {
@@ -1089,18 +1356,20 @@ spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 	bdev = spdk_bdev_desc_get_bdev(nbd->bdev_desc);
 	nbd->bdev = bdev;
 
-	nbd->ch = spdk_bdev_get_io_channel(nbd->bdev_desc);
 	nbd->buf_align = spdk_max(spdk_bdev_get_buf_align(bdev), 64);
 
-	rc = socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sp);
-	if (rc != 0) {
-		SPDK_ERRLOG("socketpair failed\n");
-		rc = -errno;
-		goto err;
+	for (i = 0; i < num_connections; i++) {
+		rc = socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sp);
+		if (rc != 0) {
+			SPDK_ERRLOG("socketpair failed\n");
+			rc = -errno;
+			goto err;
+		}
+
+		nbd->conns[i].spdk_sp_fd = sp[0];
+		nbd->conns[i].kernel_sp_fd = sp[1];
 	}
 
-	nbd->spdk_sp_fd = sp[0];
-	nbd->kernel_sp_fd = sp[1];
 	nbd->nbd_path = strdup(nbd_path);
 	if (!nbd->nbd_path) {
 		SPDK_ERRLOG("strdup allocation failure\n");
@@ -1108,10 +1377,6 @@ spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 		goto err;
 	}
 
-	TAILQ_INIT(&nbd->received_io_list);
-	TAILQ_INIT(&nbd->executed_io_list);
-	TAILQ_INIT(&nbd->processing_io_list);
-
 	/* Add nbd_disk to the end of disk list */
 	rc = nbd_disk_register(ctx->nbd);
 	if (rc != 0) {
@@ -1125,8 +1390,8 @@ spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 		goto err;
 	}
 
-	SPDK_INFOLOG(nbd, "Enabling kernel access to bdev %s via %s\n",
-		     bdev_name, nbd_path);
+	SPDK_INFOLOG(nbd, "Enabling kernel access to bdev %s via %s with %u connection(s)\n",
+		     bdev_name, nbd_path, num_connections);
 
 	nbd_enable_kernel(ctx);
 	return;
@@ -1142,6 +1407,13 @@ err:
 	}
 }
 
+void
+spdk_nbd_start(const char *bdev_name, const char *nbd_path,
+	       spdk_nbd_start_cb cb_fn, void *cb_arg)
+{
+	spdk_nbd_start_ext(bdev_name, nbd_path, 1, cb_fn, cb_arg);
+}
+
 const char *
 spdk_nbd_get_path(struct spdk_nbd_disk *nbd)
 {
@@ -114,7 +114,8 @@ rpc_start_nbd_done(void *cb_arg, struct spdk_nbd_disk *nbd, int rc)
 
 		req->nbd_device = find_available_nbd_disk(ereq->nbd_idx, &ereq->nbd_idx);
 		if (req->nbd_device != NULL) {
-			spdk_nbd_start(req->bdev_name, req->nbd_device, rpc_start_nbd_done, ereq);
+			spdk_nbd_start_ext(req->bdev_name, req->nbd_device, req->num_connections,
+					   rpc_start_nbd_done, ereq);
 			return;
 		}
 
@@ -149,6 +150,7 @@ rpc_nbd_start_disk(struct spdk_jsonrpc_request *request,
 		return;
 	}
 	req = &ereq->req;
+	req->num_connections = 1;
 
 	if (spdk_json_decode_object(params, rpc_nbd_start_disk_decoders,
 				    SPDK_COUNTOF(rpc_nbd_start_disk_decoders),
@@ -163,6 +165,13 @@ rpc_nbd_start_disk(struct spdk_jsonrpc_request *request,
 		goto invalid;
 	}
 
+	if (req->num_connections == 0 || req->num_connections > SPDK_NBD_MAX_CONNECTIONS) {
+		spdk_jsonrpc_send_error_response_fmt(request, -EINVAL,
+						     "num_connections must be between 1 and %u",
+						     SPDK_NBD_MAX_CONNECTIONS);
+		goto invalid;
+	}
+
 	if (req->nbd_device != NULL) {
 		ereq->nbd_idx_specified = true;
 		rc = check_available_nbd_disk(req->nbd_device);
@@ -190,8 +199,8 @@ rpc_nbd_start_disk(struct spdk_jsonrpc_request *request,
 	}
 
 	req->request = request;
-	spdk_nbd_start(req->bdev_name, req->nbd_device,
-		       rpc_start_nbd_done, ereq);
+	spdk_nbd_start_ext(req->bdev_name, req->nbd_device, req->num_connections,
+			   rpc_start_nbd_done, ereq);
 
 	return;
 
@@ -300,6 +309,8 @@ rpc_dump_nbd_info(struct spdk_json_write_ctx *w,
 
 	spdk_json_write_named_string(w, "bdev_name", nbd_disk_get_bdev_name(nbd));
 
+	spdk_json_write_named_uint32(w, "num_connections", nbd_disk_get_num_connections(nbd));
+
 	spdk_json_write_object_end(w);
 }
 
@@ -1271,10 +1271,10 @@ spdk_nvmf_tgt_pause_polling(struct spdk_nvmf_tgt *tgt, spdk_nvmf_tgt_pause_polli
 	ctx->cb_fn = cb_fn;
 	ctx->cb_arg = cb_arg;
 
-	spdk_for_each_channel(tgt,
-			      _nvmf_tgt_pause_polling,
-			      ctx,
-			      _nvmf_tgt_pause_polling_done);
+	spdk_for_each_channel_parallel(tgt,
+				       _nvmf_tgt_pause_polling,
+				       ctx,
+				       _nvmf_tgt_pause_polling_done);
 	return 0;
 }
 
@@ -1332,10 +1332,10 @@ spdk_nvmf_tgt_resume_polling(struct spdk_nvmf_tgt *tgt, spdk_nvmf_tgt_resume_pol
 	ctx->cb_fn = cb_fn;
 	ctx->cb_arg = cb_arg;
 
-	spdk_for_each_channel(tgt,
-			      _nvmf_tgt_resume_polling,
-			      ctx,
-			      _nvmf_tgt_resume_polling_done);
+	spdk_for_each_channel_parallel(tgt,
+				       _nvmf_tgt_resume_polling,
+				       ctx,
+				       _nvmf_tgt_resume_polling_done);
 	return 0;
 }
 
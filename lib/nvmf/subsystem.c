@@ -801,10 +801,10 @@ subsystem_state_change_done(struct spdk_io_channel_iter *i, int status)
 			goto out;
 		}
 		ctx->requested_state = ctx->original_state;
-		spdk_for_each_channel(ctx->subsystem->tgt,
-				      subsystem_state_change_on_pg,
-				      ctx,
-				      subsystem_state_change_revert_done);
+		spdk_for_each_channel_parallel(ctx->subsystem->tgt,
+					       subsystem_state_change_on_pg,
+					       ctx,
+					       subsystem_state_change_revert_done);
 		return;
 	}
 
@@ -890,10 +890,10 @@ nvmf_subsystem_do_state_change(struct nvmf_subsystem_state_change_ctx *ctx)
 	if (subsystem->state == ctx->requested_state) {
 		if (subsystem->state == SPDK_NVMF_SUBSYSTEM_PAUSED && ctx->nsid != 0) {
 			ctx->original_state = SPDK_NVMF_SUBSYSTEM_PAUSED;
-			spdk_for_each_channel(subsystem->tgt,
-					      subsystem_state_change_on_pg,
-					      ctx,
-					      subsystem_pause_ns_drain_done);
+			spdk_for_each_channel_parallel(subsystem->tgt,
+						       subsystem_state_change_on_pg,
+						       ctx,
+						       subsystem_pause_ns_drain_done);
 			return;
 		}
 		nvmf_subsystem_state_change_complete(ctx, 0);
@@ -911,10 +911,10 @@ nvmf_subsystem_do_state_change(struct nvmf_subsystem_state_change_ctx *ctx)
 		return;
 	}
 
-	spdk_for_each_channel(subsystem->tgt,
-			      subsystem_state_change_on_pg,
-			      ctx,
-			      subsystem_state_change_done);
+	spdk_for_each_channel_parallel(subsystem->tgt,
+				       subsystem_state_change_on_pg,
+				       ctx,
+				       subsystem_state_change_done);
 }
 
 
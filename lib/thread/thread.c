@@ -32,6 +32,8 @@
 #endif
 
 #define SPDK_MSG_BATCH_SIZE		8
+#define SPDK_MSG_BATCH_SIZE_MAX		64
+#define SPDK_MSG_OUTBOX_SIZE		32
 #define SPDK_MAX_DEVICE_NAME_LEN	256
 #define SPDK_THREAD_EXIT_TIMEOUT_SEC	5
 #define SPDK_MAX_POLLER_NAME_LEN	256
@@ -111,6 +113,18 @@ struct spdk_thread_post_poller_handler {
 
 #define SPDK_THREAD_MAX_POST_POLLER_HANDLERS (4)
 
+/*
+ * Messages sent by a polled thread to other threads while message batching
+ *  is enabled, in the order they were sent. They are moved to the target rings
+ *  in that same order when the outbox fills up or the sending thread finishes
+ *  its poll, consecutive messages to the same target in a single bulk operation.
+ */
+struct spdk_msg_outbox {
+	uint32_t			count;
+	const struct spdk_thread	*threads[SPDK_MSG_OUTBOX_SIZE];
+	struct spdk_msg			*msgs[SPDK_MSG_OUTBOX_SIZE];
+};
+
 struct spdk_thread {
 	uint64_t			tsc_last;
 	struct spdk_thread_stats	stats;
@@ -138,6 +152,11 @@ struct spdk_thread {
 	int				msg_fd;
 	SLIST_HEAD(, spdk_msg)		msg_cache;
 	size_t				msg_cache_count;
+	struct spdk_msg_outbox		msg_outbox;
+	/* Number of messages to this thread held in outboxes of other threads */
+	uint32_t			outbox_msg_count;
+	/* Number of messages drained per poll, adapted to the ring occupancy */
+	uint32_t			msg_batch_size;
 	spdk_msg_fn			critical_msg;
 	uint64_t			id;
 	uint64_t			next_poller_id;
@@ -160,6 +179,8 @@ struct spdk_thread {
 	/* Indicates whether this spdk_thread currently runs in interrupt. */
 	bool				in_interrupt;
 	bool				poller_unregistered;
+	/* Set while the thread is polled with message batching enabled. */
+	bool				msg_batching;
 	struct spdk_fd_group		*fgrp;
 
 	uint16_t			trace_id;
@@ -188,6 +209,8 @@ static size_t g_ctx_sz = 0;
  */
 static uint64_t g_thread_id = 1;
 
+static bool g_msg_batching = false;
+
 enum spin_error {
 	SPIN_ERR_NONE,
 	/* Trying to use an SPDK lock while not on an SPDK thread */
@@ -553,6 +576,7 @@ spdk_thread_create(const char *name, const struct spdk_cpuset *cpumask)
 	TAILQ_INIT(&thread->paused_pollers);
 	SLIST_INIT(&thread->msg_cache);
 	thread->msg_cache_count = 0;
+	thread->msg_batch_size = SPDK_MSG_BATCH_SIZE;
 
 	thread->tsc_last = spdk_get_ticks();
 
@@ -675,6 +699,16 @@ thread_exit(struct spdk_thread *thread, uint64_t now)
 	struct spdk_poller *poller;
 	struct spdk_io_channel *ch;
 
+	/* Messages sent to this thread are only held by other threads until the end of their
+	 * current poll, so wait for them even once the timeout expires.  This is checked before
+	 * the ring, as they are only removed from the count after being enqueued to it.
+	 */
+	if (__atomic_load_n(&thread->outbox_msg_count, __ATOMIC_ACQUIRE) > 0) {
+		SPDK_INFOLOG(thread, "thread %s still has messages held by other threads\n",
+			     thread->name);
+		return;
+	}
+
 	if (now >= thread->exit_timeout_tsc) {
 		SPDK_ERRLOG("thread %s got timeout, and move it to the exited state forcefully\n",
 			    thread->name);
@@ -784,6 +818,8 @@ spdk_thread_destroy(struct spdk_thread *thread)
 	SPDK_DEBUGLOG(thread, "Destroy thread %s\n", thread->name);
 
 	assert(thread->state == SPDK_THREAD_STATE_EXITED);
+	assert(thread->outbox_msg_count == 0);
+	assert(thread->msg_outbox.count == 0);
 
 	if (tls_thread == thread) {
 		tls_thread = NULL;
@@ -857,8 +893,9 @@ static inline uint32_t
 msg_queue_run_batch(struct spdk_thread *thread, uint32_t max_msgs)
 {
 	unsigned count, i;
-	void *messages[SPDK_MSG_BATCH_SIZE];
+	void *messages[SPDK_MSG_BATCH_SIZE_MAX];
 	uint64_t notify = 1;
+	bool adaptive = false;
 	int rc;
 
 #ifdef DEBUG
@@ -873,10 +910,21 @@ msg_queue_run_batch(struct spdk_thread *thread, uint32_t max_msgs)
 	if (max_msgs > 0) {
 		max_msgs = spdk_min(max_msgs, SPDK_MSG_BATCH_SIZE);
 	} else {
-		max_msgs = SPDK_MSG_BATCH_SIZE;
+		max_msgs = thread->msg_batch_size;
+		adaptive = true;
 	}
 
 	count = spdk_ring_dequeue(thread->messages, messages, max_msgs);
+	if (adaptive) {
+		/* Drain more messages per poll while the ring keeps filling up the whole
+		 * batch, and fall back to the default once the load goes down.
+		 */
+		if (count == max_msgs) {
+			thread->msg_batch_size = spdk_min(max_msgs * 2, SPDK_MSG_BATCH_SIZE_MAX);
+		} else if (count < max_msgs / 2) {
+			thread->msg_batch_size = spdk_max(max_msgs / 2, SPDK_MSG_BATCH_SIZE);
+		}
+	}
 	if (spdk_unlikely(thread->in_interrupt) &&
 	    spdk_ring_count(thread->messages) != 0) {
 		rc = write(thread->msg_fd, &notify, sizeof(notify));
@@ -888,6 +936,8 @@ msg_queue_run_batch(struct spdk_thread *thread, uint32_t max_msgs)
 		return 0;
 	}
 
+	thread->stats.msgs_executed += count;
+
 	for (i = 0; i < count; i++) {
 		struct spdk_msg *msg = messages[i];
 
@@ -1219,6 +1269,8 @@ _thread_exit(void *ctx)
 	}
 }
 
+static void thread_flush_msg_outbox(struct spdk_thread *local_thread);
+
 int
 spdk_thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 {
@@ -1233,6 +1285,8 @@ spdk_thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 	}
 
 	if (spdk_likely(!thread->in_interrupt)) {
+		thread->msg_batching = g_msg_batching;
+
 		rc = thread_poll(thread, max_msgs, now);
 		if (spdk_unlikely(thread->in_interrupt)) {
 			/* The thread transitioned to interrupt mode during the above poll.
@@ -1242,6 +1296,11 @@ spdk_thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 			rc = thread_poll(thread, max_msgs, now);
 		}
 
+		if (thread->msg_batching) {
+			thread->msg_batching = false;
+			thread_flush_msg_outbox(thread);
+		}
+
 		if (spdk_unlikely(thread->state == SPDK_THREAD_STATE_EXITING)) {
 			thread_exit(thread, now);
 		}
@@ -1412,6 +1471,67 @@ thread_send_msg_notification(const struct spdk_thread *target_thread)
 	}
 }
 
+static void
+thread_flush_msg_outbox(struct spdk_thread *local_thread)
+{
+	struct spdk_msg_outbox *outbox = &local_thread->msg_outbox;
+	const struct spdk_thread *thread;
+	uint32_t i, j;
+	size_t rc;
+
+	/* Flush in send order, so that no message overtakes one sent earlier to another thread,
+	 * even if the message it depends on is the response of that other thread.
+	 */
+	for (i = 0; i < outbox->count; i = j) {
+		thread = outbox->threads[i];
+		j = i + 1;
+		while (j < outbox->count && outbox->threads[j] == thread) {
+			j++;
+		}
+
+		/* thread_exit() waits for the messages held for a thread */
+		assert(thread->state != SPDK_THREAD_STATE_EXITED);
+
+		rc = spdk_ring_enqueue(thread->messages, (void **)&outbox->msgs[i], j - i, NULL);
+		if (rc != j - i) {
+			SPDK_ERRLOG("msg could not be enqueued\n");
+			abort();
+		}
+
+		__atomic_fetch_sub(&((struct spdk_thread *)thread)->outbox_msg_count, j - i,
+				   __ATOMIC_RELEASE);
+		thread_send_msg_notification(thread);
+	}
+
+	outbox->count = 0;
+}
+
+static void
+msg_outbox_put(struct spdk_thread *local_thread, const struct spdk_thread *thread,
+	       struct spdk_msg *msg)
+{
+	struct spdk_msg_outbox *outbox = &local_thread->msg_outbox;
+
+	__atomic_fetch_add(&((struct spdk_thread *)thread)->outbox_msg_count, 1, __ATOMIC_RELAXED);
+	outbox->threads[outbox->count] = thread;
+	outbox->msgs[outbox->count] = msg;
+	if (++outbox->count == SPDK_MSG_OUTBOX_SIZE) {
+		thread_flush_msg_outbox(local_thread);
+	}
+}
+
+void
+spdk_thread_lib_set_msg_batching(bool enable)
+{
+	g_msg_batching = enable;
+}
+
+bool
+spdk_thread_lib_get_msg_batching(void)
+{
+	return g_msg_batching;
+}
+
 int
 spdk_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx)
 {
@@ -1449,6 +1569,14 @@ spdk_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx
 	msg->fn = fn;
 	msg->arg = ctx;
 
+	if (local_thread != NULL) {
+		local_thread->stats.msgs_sent++;
+		if (local_thread->msg_batching && local_thread != thread) {
+			msg_outbox_put(local_thread, thread, msg);
+			return 0;
+		}
+	}
+
 	rc = spdk_ring_enqueue(thread->messages, (void **)&msg, 1, NULL);
 	if (rc != 1) {
 		SPDK_ERRLOG("msg could not be enqueued\n");
@@ -2617,6 +2745,15 @@ struct spdk_io_channel_iter {
 
 	struct spdk_thread *orig_thread;
 	spdk_channel_for_each_cpl cpl;
+
+	/* Only used by spdk_for_each_channel_parallel(). Each per-thread iterator
+	 *  points to the parent iterator, which counts the channels that have not
+	 *  called spdk_for_each_channel_continue() yet.
+	 */
+	struct spdk_io_channel_iter *parent;
+	uint32_t outstanding;
+	/* Context of the channel, see spdk_for_each_channel_parallel_ext() */
+	void *channel_ctx;
 };
 
 void *
@@ -2631,6 +2768,12 @@ spdk_io_channel_iter_get_channel(struct spdk_io_channel_iter *i)
 	return i->ch;
 }
 
+void *
+spdk_io_channel_iter_get_channel_ctx(struct spdk_io_channel_iter *i)
+{
+	return i->channel_ctx;
+}
+
 void *
 spdk_io_channel_iter_get_ctx(struct spdk_io_channel_iter *i)
 {
@@ -2672,6 +2815,35 @@ _call_channel(void *ctx)
 	}
 }
 
+static void
+__pending_unregister(void *arg)
+{
+	struct io_device *dev = arg;
+
+	assert(dev->pending_unregister);
+	assert(dev->for_each_count == 0);
+	spdk_io_device_unregister(dev->io_device, dev->unregister_cb);
+}
+
+static void
+for_each_channel_done(struct spdk_io_channel_iter *i)
+{
+	struct io_device *dev = i->dev;
+
+	pthread_mutex_lock(&g_devlist_mutex);
+	dev->for_each_count--;
+	i->ch = NULL;
+	pthread_mutex_unlock(&g_devlist_mutex);
+
+	spdk_thread_send_msg(i->orig_thread, _call_completion, i);
+
+	pthread_mutex_lock(&g_devlist_mutex);
+	if (dev->pending_unregister && dev->for_each_count == 0) {
+		spdk_thread_send_msg(dev->unregister_thread, __pending_unregister, dev);
+	}
+	pthread_mutex_unlock(&g_devlist_mutex);
+}
+
 void
 spdk_for_each_channel(void *io_device, spdk_channel_msg fn, void *ctx,
 		      spdk_channel_for_each_cpl cpl)
@@ -2727,14 +2899,125 @@ end:
 	spdk_thread_send_msg(i->orig_thread, _call_completion, i);
 }
 
+
+void
+spdk_for_each_channel_parallel(void *io_device, spdk_channel_msg fn, void *ctx,
+			       spdk_channel_for_each_cpl cpl)
+{
+	spdk_for_each_channel_parallel_ext(io_device, fn, ctx, 0, cpl);
+}
+
+void
+spdk_for_each_channel_parallel_ext(void *io_device, spdk_channel_msg fn, void *ctx,
+				   size_t channel_ctx_size, spdk_channel_for_each_cpl cpl)
+{
+	struct spdk_io_channel_iter *i, *child;
+	struct thread_link *thr_link;
+	struct io_device *dev;
+	uint8_t *channel_ctx;
+	uint32_t count = 0, idx = 0;
+
+	pthread_mutex_lock(&g_devlist_mutex);
+	dev = io_device_get(io_device);
+	if (dev != NULL) {
+		RB_FOREACH(thr_link, thread_link_tree, &dev->threads) {
+			count++;
+		}
+	}
+
+	/* The per-thread iterators and their channel contexts are allocated together
+	 *  with the parent, so they are all released by _call_completion().
+	 */
+	channel_ctx_size = SPDK_ALIGN_CEIL(channel_ctx_size, sizeof(uint64_t));
+	i = calloc(1, (1 + count) * sizeof(*i) + count * channel_ctx_size);
+	if (!i) {
+		pthread_mutex_unlock(&g_devlist_mutex);
+		SPDK_ERRLOG("Unable to allocate iterator\n");
+		assert(false);
+		return;
+	}
+
+	i->io_device = io_device;
+	i->dev = dev;
+	i->fn = fn;
+	i->ctx = ctx;
+	i->cpl = cpl;
+	i->orig_thread = _get_thread();
+
+	i->orig_thread->for_each_count++;
+
+	if (dev == NULL) {
+		SPDK_ERRLOG("could not find io_device %p\n", io_device);
+		assert(false);
+		i->status = -ENODEV;
+		goto end;
+	}
+
+	if (dev->pending_unregister) {
+		SPDK_ERRLOG("io_device %p has a pending unregister\n", io_device);
+		i->status = -ENODEV;
+		goto end;
+	}
+
+	if (count == 0) {
+		goto end;
+	}
+
+	dev->for_each_count++;
+	i->outstanding = count;
+	channel_ctx = (uint8_t *)&i[1 + count];
+	RB_FOREACH(thr_link, thread_link_tree, &dev->threads) {
+		child = &i[1 + idx];
+		if (channel_ctx_size != 0) {
+			child->channel_ctx = channel_ctx + idx * channel_ctx_size;
+		}
+		idx++;
+		child->io_device = io_device;
+		child->dev = dev;
+		child->fn = fn;
+		child->ctx = ctx;
+		child->orig_thread = i->orig_thread;
+		child->cur_thread = thr_link->thread;
+		child->parent = i;
+	}
+	assert(idx == count);
+
+	/* Send the messages only after all iterators are set up. A channel that
+	 *  completes right away may otherwise observe a partially built array.
+	 */
+	for (idx = 0; idx < count; idx++) {
+		child = &i[1 + idx];
+		spdk_thread_send_msg(child->cur_thread, _call_channel, child);
+	}
+	pthread_mutex_unlock(&g_devlist_mutex);
+	return;
+
+end:
+	pthread_mutex_unlock(&g_devlist_mutex);
+
+	spdk_thread_send_msg(i->orig_thread, _call_completion, i);
+}
+
 static void
-__pending_unregister(void *arg)
+for_each_channel_parallel_continue(struct spdk_io_channel_iter *i, int status)
 {
-	struct io_device *dev = arg;
+	struct spdk_io_channel_iter *parent = i->parent;
+	int expected = 0;
 
-	assert(dev->pending_unregister);
-	assert(dev->for_each_count == 0);
-	spdk_io_device_unregister(dev->io_device, dev->unregister_cb);
+	i->ch = NULL;
+	if (status != 0) {
+		/* Keep the first error. Channels that were already visited are not rolled
+		 *  back, it is up to the caller to handle that in its completion callback.
+		 */
+		__atomic_compare_exchange_n(&parent->status, &expected, status, false,
+					    __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+	}
+
+	if (__atomic_sub_fetch(&parent->outstanding, 1, __ATOMIC_ACQ_REL) != 0) {
+		return;
+	}
+
+	for_each_channel_done(parent);
 }
 
 static struct spdk_thread *
@@ -2751,14 +3034,17 @@ void
 spdk_for_each_channel_continue(struct spdk_io_channel_iter *i, int status)
 {
 	struct spdk_thread *thread;
-	struct io_device *dev;
 
 	assert(i->cur_thread == spdk_get_thread());
 
+	if (i->parent != NULL) {
+		for_each_channel_parallel_continue(i, status);
+		return;
+	}
+
 	i->status = status;
 
 	pthread_mutex_lock(&g_devlist_mutex);
-	dev = i->dev;
 	if (status) {
 		goto end;
 	}
@@ -2772,17 +3058,9 @@ spdk_for_each_channel_continue(struct spdk_io_channel_iter *i, int status)
 	}
 
 end:
-	dev->for_each_count--;
-	i->ch = NULL;
 	pthread_mutex_unlock(&g_devlist_mutex);
 
-	spdk_thread_send_msg(i->orig_thread, _call_completion, i);
-
-	pthread_mutex_lock(&g_devlist_mutex);
-	if (dev->pending_unregister && dev->for_each_count == 0) {
-		spdk_thread_send_msg(dev->unregister_thread, __pending_unregister, dev);
-	}
-	pthread_mutex_unlock(&g_devlist_mutex);
+	for_each_channel_done(i);
 }
 
 static void
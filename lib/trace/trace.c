@@ -14,6 +14,7 @@
 #include "spdk/cpuset.h"
 #include "spdk/likely.h"
 #include "spdk/bit_array.h"
+#include "spdk/histogram_data.h"
 #include "trace_internal.h"
 
 static int g_trace_fd = -1;
@@ -33,6 +34,32 @@ SPDK_STATIC_ASSERT(sizeof(struct spdk_trace_owner) == 9, "incorrect size");
 SPDK_STATIC_ASSERT(sizeof(struct spdk_trace_owner) + TRACE_OWNER_DESCRIPTION_SIZE == 128,
 		   "incorrect size");
 
+/* Record 1 of every N events of each tpoint group into the trace history, 0 records none */
+static uint32_t g_tpoint_group_sample_rate[SPDK_TRACE_MAX_GROUP_ID];
+static __thread uint64_t t_sample_count;
+
+/* Number of objects per core whose start tsc is remembered for the latency histograms.
+ * An object that collides with another one before it completes is not accounted.
+ */
+#define TRACE_LATENCY_NUM_OBJECTS	4096
+#define TRACE_LATENCY_GRANULARITY	5
+
+struct trace_latency_object {
+	uint64_t	object_id;
+	uint64_t	tsc;
+	uint8_t		object_type;
+};
+
+struct trace_latency {
+	struct trace_latency_object	objects[TRACE_LATENCY_NUM_OBJECTS];
+	/* Histograms are allocated on the first event of their tpoint */
+	struct spdk_histogram_data	*histograms[SPDK_TRACE_MAX_TPOINT_ID];
+};
+
+static bool g_latency_enabled;
+/* Indexed the same as the per lcore trace histories, each updated only by its owner */
+static struct trace_latency *g_latency[SPDK_TRACE_MAX_LCORE];
+
 static inline void
 trace_history_increment_tpoint_count(struct spdk_trace_history *history, uint16_t tpoint_id)
 {
@@ -45,6 +72,79 @@ trace_history_increment_tpoint_count(struct spdk_trace_history *history, uint16_
 	counts[tpoint_id]++;
 }
 
+static inline uint64_t
+trace_hash_object(uint64_t object_id)
+{
+	/* Object ids are mostly pointers, use the upper bits of a multiplicative hash */
+	return (object_id * 0x9E3779B97F4A7C15ULL) >> 32;
+}
+
+static inline bool
+trace_sample_event(uint16_t tpoint_id, uint64_t object_id)
+{
+	uint32_t rate = g_tpoint_group_sample_rate[tpoint_id >> 6];
+
+	if (spdk_likely(rate == 1)) {
+		return true;
+	} else if (rate == 0) {
+		return false;
+	}
+
+	/* Sample by object, so that either all or none of an object's events are recorded */
+	if (object_id != 0) {
+		return trace_hash_object(object_id) % rate == 0;
+	}
+
+	return t_sample_count++ % rate == 0;
+}
+
+static void
+trace_account_latency(struct spdk_trace_history *history, struct spdk_trace_tpoint *tpoint,
+		      uint64_t tsc, uint64_t object_id)
+{
+	struct trace_latency *latency;
+	struct trace_latency_object *object;
+	struct spdk_histogram_data *histogram;
+
+	if (tpoint->object_type == OBJECT_NONE || object_id == 0) {
+		return;
+	}
+
+	latency = g_latency[history->lcore];
+	if (spdk_unlikely(latency == NULL)) {
+		latency = calloc(1, sizeof(*latency));
+		if (latency == NULL) {
+			return;
+		}
+		__atomic_store_n(&g_latency[history->lcore], latency, __ATOMIC_RELEASE);
+	}
+
+	object = &latency->objects[trace_hash_object(object_id) & (TRACE_LATENCY_NUM_OBJECTS - 1)];
+	if (tpoint->new_object) {
+		object->object_id = object_id;
+		object->object_type = tpoint->object_type;
+		object->tsc = tsc;
+		return;
+	}
+
+	if (object->object_id != object_id || object->object_type != tpoint->object_type ||
+	    object->tsc > tsc) {
+		return;
+	}
+
+	histogram = latency->histograms[tpoint->tpoint_id];
+	if (spdk_unlikely(histogram == NULL)) {
+		histogram = spdk_histogram_data_alloc_sized(TRACE_LATENCY_GRANULARITY);
+		if (histogram == NULL) {
+			return;
+		}
+		__atomic_store_n(&latency->histograms[tpoint->tpoint_id], histogram,
+				 __ATOMIC_RELEASE);
+	}
+
+	spdk_histogram_data_tally(histogram, tsc - object->tsc);
+}
+
 static inline struct spdk_trace_entry *
 get_trace_entry(struct spdk_trace_history *history, uint64_t offset)
 {
@@ -87,6 +187,14 @@ _spdk_trace_record(uint64_t tsc, uint16_t tpoint_id, uint16_t owner_id, uint32_t
 		return;
 	}
 
+	if (g_latency_enabled) {
+		trace_account_latency(lcore_history, tpoint, tsc, object_id);
+	}
+
+	if (!trace_sample_event(tpoint_id, object_id)) {
+		return;
+	}
+
 	/* Get next entry index in the circular buffer */
 	next_entry = get_trace_entry(lcore_history, lcore_history->next_entry);
 	next_entry->tsc = tsc;
@@ -267,6 +375,10 @@ spdk_trace_init(const char *shm_name, uint64_t num_entries, uint32_t num_threads
 		return 0;
 	}
 
+	for (i = 0; i < SPDK_TRACE_MAX_GROUP_ID; i++) {
+		g_tpoint_group_sample_rate[i] = 1;
+	}
+
 	if (num_threads >= SPDK_TRACE_MAX_LCORE) {
 		SPDK_ERRLOG("cannot alloc trace entries for %d user threads\n", num_threads);
 		SPDK_ERRLOG("supported maximum %d threads\n", SPDK_TRACE_MAX_LCORE - 1);
@@ -443,6 +555,21 @@ trace_init_err:
 
 }
 
+static void
+trace_latency_free(struct trace_latency *latency)
+{
+	uint32_t i;
+
+	if (latency == NULL) {
+		return;
+	}
+
+	for (i = 0; i < SPDK_TRACE_MAX_TPOINT_ID; i++) {
+		spdk_histogram_data_free(latency->histograms[i]);
+	}
+	free(latency);
+}
+
 void
 spdk_trace_cleanup(void)
 {
@@ -477,6 +604,12 @@ spdk_trace_cleanup(void)
 	close(g_trace_fd);
 	spdk_bit_array_free(&g_ut_array);
 
+	g_latency_enabled = false;
+	for (i = 0; i < SPDK_TRACE_MAX_LCORE; i++) {
+		trace_latency_free(g_latency[i]);
+		g_latency[i] = NULL;
+	}
+
 	if (unlink) {
 		shm_unlink(g_shm_name);
 	}
@@ -487,3 +620,106 @@ trace_get_shm_name(void)
 {
 	return g_shm_name;
 }
+
+int
+spdk_trace_set_tpoint_group_sample_rate(uint32_t group_id, uint32_t rate)
+{
+	if (g_trace_file == NULL) {
+		SPDK_ERRLOG("trace is not initialized\n");
+		return -EINVAL;
+	}
+
+	if (group_id >= SPDK_TRACE_MAX_GROUP_ID) {
+		SPDK_ERRLOG("invalid group ID %d\n", group_id);
+		return -EINVAL;
+	}
+
+	g_tpoint_group_sample_rate[group_id] = rate;
+	return 0;
+}
+
+uint32_t
+spdk_trace_get_tpoint_group_sample_rate(uint32_t group_id)
+{
+	if (group_id >= SPDK_TRACE_MAX_GROUP_ID) {
+		SPDK_ERRLOG("invalid group ID %d\n", group_id);
+		return 0;
+	}
+
+	return g_tpoint_group_sample_rate[group_id];
+}
+
+void
+spdk_trace_enable_latency_histograms(bool enable)
+{
+	struct trace_latency *latency;
+	struct spdk_histogram_data *histogram;
+	uint32_t i, j;
+
+	if (enable && !g_latency_enabled) {
+		/* Start over. Cores that are still accounting while histograms are enabled
+		 * again might lose a few datapoints.
+		 */
+		for (i = 0; i < SPDK_TRACE_MAX_LCORE; i++) {
+			latency = __atomic_load_n(&g_latency[i], __ATOMIC_ACQUIRE);
+			if (latency == NULL) {
+				continue;
+			}
+
+			for (j = 0; j < SPDK_TRACE_MAX_TPOINT_ID; j++) {
+				histogram = __atomic_load_n(&latency->histograms[j],
+							    __ATOMIC_ACQUIRE);
+				if (histogram != NULL) {
+					spdk_histogram_data_reset(histogram);
+				}
+			}
+		}
+	}
+
+	g_latency_enabled = enable;
+}
+
+bool
+spdk_trace_latency_histograms_enabled(void)
+{
+	return g_latency_enabled;
+}
+
+int
+spdk_trace_get_latency_histograms(spdk_trace_latency_histogram_fn fn, void *ctx)
+{
+	struct trace_latency *latency;
+	struct spdk_histogram_data *histogram, *merged = NULL;
+	uint32_t i, j;
+
+	for (i = 0; i < SPDK_TRACE_MAX_TPOINT_ID; i++) {
+		for (j = 0; j < SPDK_TRACE_MAX_LCORE; j++) {
+			latency = __atomic_load_n(&g_latency[j], __ATOMIC_ACQUIRE);
+			if (latency == NULL) {
+				continue;
+			}
+
+			histogram = __atomic_load_n(&latency->histograms[i], __ATOMIC_ACQUIRE);
+			if (histogram == NULL) {
+				continue;
+			}
+
+			if (merged == NULL) {
+				merged = spdk_histogram_data_alloc_sized(TRACE_LATENCY_GRANULARITY);
+				if (merged == NULL) {
+					return -ENOMEM;
+				}
+			}
+
+			spdk_histogram_data_merge(merged, histogram);
+		}
+
+		if (merged != NULL) {
+			fn(ctx, i, merged);
+			spdk_histogram_data_free(merged);
+			merged = NULL;
+		}
+	}
+
+	return 0;
+}
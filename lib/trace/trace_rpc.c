@@ -7,6 +7,10 @@
 #include "spdk/util.h"
 #include "spdk/trace.h"
 #include "spdk/log.h"
+#include "spdk/base64.h"
+#include "spdk/env.h"
+#include "spdk/histogram_data.h"
+#include "spdk/string.h"
 
 #include "spdk_internal/rpc_autogen.h"
 #include "trace_internal.h"
@@ -242,6 +246,7 @@ rpc_trace_get_info(struct spdk_jsonrpc_request *request,
 	uint64_t tpoint_mask;
 	char tpoint_mask_str[20];
 	char mask_str[20];
+	uint32_t sample_rate;
 	struct spdk_json_write_ctx *w;
 	struct spdk_trace_register_fn *register_fn;
 
@@ -260,6 +265,8 @@ rpc_trace_get_info(struct spdk_jsonrpc_request *request,
 
 	snprintf(mask_str, sizeof(mask_str), "0x%" PRIx64, tpoint_group_mask);
 	spdk_json_write_named_string(w, "tpoint_group_mask", mask_str);
+	spdk_json_write_named_bool(w, "latency_histograms",
+				   spdk_trace_latency_histograms_enabled());
 
 	register_fn = spdk_trace_get_first_register_fn();
 	while (register_fn) {
@@ -271,6 +278,8 @@ rpc_trace_get_info(struct spdk_jsonrpc_request *request,
 		spdk_json_write_named_string(w, "mask", mask_str);
 		snprintf(tpoint_mask_str, sizeof(tpoint_mask_str), "0x%lx", tpoint_mask);
 		spdk_json_write_named_string(w, "tpoint_mask", tpoint_mask_str);
+		sample_rate = spdk_trace_get_tpoint_group_sample_rate(register_fn->tgroup_id);
+		spdk_json_write_named_uint32(w, "sample_rate", sample_rate);
 		spdk_json_write_object_end(w);
 
 		register_fn = spdk_trace_get_next_register_fn(register_fn);
@@ -281,3 +290,180 @@ rpc_trace_get_info(struct spdk_jsonrpc_request *request,
 }
 SPDK_RPC_REGISTER("trace_get_info", rpc_trace_get_info,
 		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
+
+static void
+rpc_trace_set_tpoint_group_sample_rate(struct spdk_jsonrpc_request *request,
+				       const struct spdk_json_val *params)
+{
+	struct rpc_trace_set_tpoint_group_sample_rate_ctx req = {};
+	uint64_t tpoint_group_mask;
+	uint32_t i;
+
+	if (spdk_json_decode_object(params, rpc_trace_set_tpoint_group_sample_rate_decoders,
+				    SPDK_COUNTOF(rpc_trace_set_tpoint_group_sample_rate_decoders),
+				    &req)) {
+		SPDK_DEBUGLOG(trace, "spdk_json_decode_object failed\n");
+		goto invalid;
+	}
+
+	tpoint_group_mask = spdk_trace_create_tpoint_group_mask(req.name);
+	if (tpoint_group_mask == 0) {
+		goto invalid;
+	}
+
+	for (i = 0; i < SPDK_TRACE_MAX_GROUP_ID; i++) {
+		if ((tpoint_group_mask & SPDK_BIT(i)) &&
+		    spdk_trace_set_tpoint_group_sample_rate(i, req.rate) != 0) {
+			goto invalid;
+		}
+	}
+
+	free_rpc_trace_set_tpoint_group_sample_rate(&req);
+
+	spdk_jsonrpc_send_bool_response(request, true);
+	return;
+
+invalid:
+	spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+	free_rpc_trace_set_tpoint_group_sample_rate(&req);
+}
+SPDK_RPC_REGISTER("trace_set_tpoint_group_sample_rate", rpc_trace_set_tpoint_group_sample_rate,
+		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
+
+static void
+rpc_trace_enable_latency_histograms(struct spdk_jsonrpc_request *request,
+				    const struct spdk_json_val *params)
+{
+	struct rpc_trace_enable_latency_histograms_ctx req = {};
+
+	if (spdk_json_decode_object(params, rpc_trace_enable_latency_histograms_decoders,
+				    SPDK_COUNTOF(rpc_trace_enable_latency_histograms_decoders),
+				    &req)) {
+		SPDK_DEBUGLOG(trace, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid parameters");
+		return;
+	}
+
+	if (g_trace_file == NULL) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_STATE,
+						 "Trace is not initialized");
+		return;
+	}
+
+	spdk_trace_enable_latency_histograms(req.enable);
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+SPDK_RPC_REGISTER("trace_enable_latency_histograms", rpc_trace_enable_latency_histograms,
+		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
+
+struct rpc_trace_latency_histograms_ctx {
+	struct spdk_json_write_ctx	*w;
+	int				rc;
+};
+
+static const char *
+rpc_trace_get_group_name(uint32_t group_id)
+{
+	struct spdk_trace_register_fn *register_fn;
+
+	register_fn = spdk_trace_get_first_register_fn();
+	while (register_fn) {
+		if (register_fn->tgroup_id == group_id) {
+			return register_fn->name;
+		}
+		register_fn = spdk_trace_get_next_register_fn(register_fn);
+	}
+
+	return "";
+}
+
+static void
+rpc_trace_write_latency_histogram(void *_ctx, uint16_t tpoint_id,
+				  const struct spdk_histogram_data *histogram)
+{
+	struct rpc_trace_latency_histograms_ctx *ctx = _ctx;
+	struct spdk_json_write_ctx *w = ctx->w;
+	struct spdk_trace_tpoint *tpoint;
+	char *encoded_histogram;
+	size_t src_len, dst_len;
+	uint64_t i, count = 0;
+	int rc;
+
+	if (ctx->rc != 0) {
+		return;
+	}
+
+	src_len = SPDK_HISTOGRAM_NUM_BUCKETS(histogram) * sizeof(uint64_t);
+	dst_len = spdk_base64_get_encoded_strlen(src_len) + 1;
+
+	encoded_histogram = malloc(dst_len);
+	if (encoded_histogram == NULL) {
+		ctx->rc = -ENOMEM;
+		return;
+	}
+
+	rc = spdk_base64_encode(encoded_histogram, histogram->bucket, src_len);
+	if (rc != 0) {
+		ctx->rc = rc;
+		free(encoded_histogram);
+		return;
+	}
+
+	for (i = 0; i < SPDK_HISTOGRAM_NUM_BUCKETS(histogram); i++) {
+		count += histogram->bucket[i];
+	}
+
+	tpoint = &spdk_trace_get_tpoint_section(g_trace_file)->tpoint[tpoint_id];
+
+	/* Each entry has the format of bdev_get_histogram, so scripts/histogram.py can read it */
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "group", rpc_trace_get_group_name(tpoint_id >> 6));
+	spdk_json_write_named_string(w, "tpoint_name", tpoint->name);
+	spdk_json_write_named_uint64(w, "count", count);
+	spdk_json_write_named_string(w, "histogram", encoded_histogram);
+	spdk_json_write_named_int64(w, "granularity", histogram->granularity);
+	spdk_json_write_named_uint32(w, "min_range", histogram->min_range);
+	spdk_json_write_named_uint32(w, "max_range", histogram->max_range);
+	spdk_json_write_named_int64(w, "tsc_rate", spdk_get_ticks_hz());
+	spdk_json_write_object_end(w);
+
+	free(encoded_histogram);
+}
+
+static void
+rpc_trace_get_latency_histograms(struct spdk_jsonrpc_request *request,
+				 const struct spdk_json_val *params)
+{
+	struct rpc_trace_latency_histograms_ctx ctx = {};
+	int rc;
+
+	if (params != NULL) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "trace_get_latency_histograms requires no parameters");
+		return;
+	}
+
+	if (g_trace_file == NULL) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_STATE,
+						 "Trace is not initialized");
+		return;
+	}
+
+	ctx.w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_array_begin(ctx.w);
+
+	rc = spdk_trace_get_latency_histograms(rpc_trace_write_latency_histogram, &ctx);
+	if (rc == 0) {
+		rc = ctx.rc;
+	}
+	if (rc != 0) {
+		/* The result has already been started, so report the failure in the log only */
+		SPDK_ERRLOG("Failed to get latency histograms: %s\n", spdk_strerror(-rc));
+	}
+
+	spdk_json_write_array_end(ctx.w);
+	spdk_jsonrpc_end_result(request, ctx.w);
+}
+SPDK_RPC_REGISTER("trace_get_latency_histograms", rpc_trace_get_latency_histograms,
+		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
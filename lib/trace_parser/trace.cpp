@@ -10,9 +10,12 @@
 #include "spdk/util.h"
 #include "spdk/env.h"
 
+#include <algorithm>
 #include <exception>
 #include <map>
 #include <new>
+#include <queue>
+#include <vector>
 
 struct entry_key {
 	entry_key(uint16_t _lcore, uint64_t _tsc) : lcore(_lcore), tsc(_tsc) {}
@@ -33,7 +36,85 @@ public:
 	}
 };
 
+class compare_entry_key_reverse
+{
+public:
+	bool operator()(const entry_key &first, const entry_key &second) const
+	{
+		return compare_entry_key()(second, first);
+	}
+};
+
 typedef std::map<entry_key, spdk_trace_entry *, compare_entry_key> entry_map;
+typedef std::priority_queue<entry_key, std::vector<entry_key>, compare_entry_key_reverse>
+entry_queue;
+
+/*
+ * An indexed trace file is a regular trace file with the history of each lcore unrolled, so that
+ * the entries are sorted by their tsc starting at index 0, followed by the index below, placed at
+ * the first 64B boundary after spdk_trace_file.file_size.  Tools unaware of the index still see a
+ * valid trace file.  All offsets within the index are relative to the start of trace_index_header.
+ */
+#define TRACE_INDEX_MAGIC	"SPDKTIDX"
+#define TRACE_INDEX_VERSION	1
+#define TRACE_INDEX_ALIGN	64
+#define TRACE_INDEX_BLOCK_SIZE	4096
+
+struct trace_index_header {
+	char		magic[8];
+	uint32_t	version;
+	/* Number of entries described by each trace_index_block */
+	uint32_t	block_size;
+	uint64_t	tsc_offset;
+	uint64_t	num_lcores;
+	/* Array of trace_index_lcore */
+	uint64_t	lcores_offset;
+	uint64_t	num_blocks;
+	/* Array of trace_index_block */
+	uint64_t	blocks_offset;
+	uint64_t	num_objects;
+	/* Array of trace_index_object sorted by type, object_id and start */
+	uint64_t	objects_offset;
+	/* Positions in the objects array sorted by type and index */
+	uint64_t	objects_by_index_offset;
+	/* First position in objects_by_index array of each object type */
+	uint64_t	object_types[SPDK_TRACE_MAX_OBJECT + 1];
+};
+
+struct trace_index_lcore {
+	uint64_t	lcore;
+	uint64_t	num_entries;
+	/* Column of entries' tsc values */
+	uint64_t	tsc_offset;
+	/* Column of entries' positions within the lcore's trace history */
+	uint64_t	position_offset;
+	uint64_t	first_block;
+	uint64_t	num_blocks;
+};
+
+struct trace_index_block {
+	uint64_t	first_tsc;
+	uint64_t	last_tsc;
+};
+
+struct trace_index_object {
+	uint64_t	object_id;
+	/* The tsc of the entry that created the object and the last entry referring to it */
+	uint64_t	start;
+	uint64_t	end;
+	/* Index of the object, the same as reported in spdk_trace_parser_entry.object_index */
+	uint64_t	index;
+	uint8_t		type;
+	uint8_t		reserved[7];
+};
+
+struct index_cursor {
+	spdk_trace_history		*history;
+	const trace_index_lcore		*lcore;
+	const uint64_t			*tsc;
+	const uint64_t			*position;
+	uint64_t			entry;
+};
 
 struct argument_context {
 	spdk_trace_entry	*entry;
@@ -69,13 +150,23 @@ struct spdk_trace_parser {
 	spdk_trace_parser &operator=(const spdk_trace_parser &) = delete;
 	const spdk_trace_file *file() const { return _trace_file; }
 	uint64_t tsc_offset() const { return _tsc_offset; }
+	bool indexed() const { return _index != NULL; }
 	bool next_entry(spdk_trace_parser_entry *entry);
 	uint64_t entry_count(uint16_t lcore) const;
+	void seek_time_range(uint64_t tsc_start, uint64_t tsc_end);
+	int seek_object(uint8_t object_type, uint64_t object_index);
+	int save_index(const char *filename);
 private:
 	spdk_trace_entry_buffer *get_next_buffer(spdk_trace_entry_buffer *buf, uint16_t lcore);
 	bool build_arg(argument_context *argctx, const spdk_trace_argument *arg, int argid,
 		       spdk_trace_parser_entry *pe);
 	void populate_events(spdk_trace_history *history, int num_entries, bool overflowed);
+	bool next_raw_entry(spdk_trace_entry **entry, uint16_t *lcore);
+	const trace_index_object *find_object(uint8_t object_type, uint64_t object_id,
+					      uint64_t tsc) const;
+	void build_objects();
+	uint64_t entry_chain_length(spdk_trace_entry *entry, uint16_t lcore);
+	bool init_index(const spdk_trace_parser_opts *opts, size_t file_size);
 	bool init(const spdk_trace_parser_opts *opts);
 	void cleanup();
 
@@ -86,6 +177,23 @@ private:
 	entry_map		_entries;
 	entry_map::iterator	_iter;
 	object_stats		_stats[SPDK_TRACE_MAX_OBJECT];
+	/* Iteration window and the object it is limited to, if any */
+	uint64_t		_tsc_start;
+	uint64_t		_tsc_end;
+	uint8_t			_filter_type;
+	uint64_t		_filter_id;
+	/* Set when the trace file carries an index, entries are then merged on the fly */
+	const trace_index_header	*_index;
+	std::vector<index_cursor>	_cursors;
+	entry_queue			_queue;
+	/* Object lifetimes, either pointing to the index or to the tables below */
+	const trace_index_object	*_objects;
+	const uint64_t			*_objects_by_index;
+	const uint64_t			*_object_types;
+	uint64_t			_num_objects;
+	std::vector<trace_index_object>	_object_table;
+	std::vector<uint64_t>		_object_by_index_table;
+	std::vector<uint64_t>		_object_type_table;
 };
 
 uint64_t
@@ -157,34 +265,117 @@ spdk_trace_parser::build_arg(argument_context *argctx, const spdk_trace_argument
 	return true;
 }
 
+bool
+spdk_trace_parser::next_raw_entry(spdk_trace_entry **entry, uint16_t *lcore)
+{
+	index_cursor *cursor;
+
+	if (_index == NULL) {
+		if (_iter == _entries.end()) {
+			return false;
+		}
+
+		*entry = _iter->second;
+		*lcore = _iter->first.lcore;
+		_iter++;
+		return true;
+	}
+
+	if (_queue.empty()) {
+		return false;
+	}
+
+	*lcore = _queue.top().lcore;
+	_queue.pop();
+
+	cursor = &_cursors[*lcore];
+	if (spdk_unlikely(cursor->position[cursor->entry] >= cursor->history->num_entries)) {
+		SPDK_ERRLOG("Invalid trace index entry on lcore %u\n", *lcore);
+		return false;
+	}
+
+	*entry = spdk_trace_history_get_entry(cursor->history, cursor->position[cursor->entry]);
+	if (++cursor->entry < cursor->lcore->num_entries) {
+		_queue.push(entry_key(*lcore, cursor->tsc[cursor->entry]));
+	}
+
+	return true;
+}
+
+const trace_index_object *
+spdk_trace_parser::find_object(uint8_t object_type, uint64_t object_id, uint64_t tsc) const
+{
+	const trace_index_object *begin, *end, *obj;
+
+	begin = &_objects[_object_types[object_type]];
+	end = &_objects[_object_types[object_type + 1]];
+	/* Find the most recent object with this ID created at or before the tsc */
+	obj = std::upper_bound(begin, end, std::make_pair(object_id, tsc),
+	[](const std::pair<uint64_t, uint64_t> &key, const trace_index_object &o) {
+		return key.first < o.object_id ||
+		       (key.first == o.object_id && key.second < o.start);
+	});
+	if (obj == begin || (obj - 1)->object_id != object_id) {
+		return NULL;
+	}
+
+	return obj - 1;
+}
+
 bool
 spdk_trace_parser::next_entry(spdk_trace_parser_entry *pe)
 {
 	spdk_trace_tpoint *tpoint;
 	spdk_trace_entry *entry;
 	object_stats *stats;
+	const trace_index_object *obj;
 	std::map<uint64_t, uint64_t>::iterator related_kv;
+	uint16_t lcore;
 
-	if (_iter == _entries.end()) {
-		return false;
+	while (true) {
+		if (!next_raw_entry(&entry, &lcore)) {
+			return false;
+		}
+
+		if (entry->tsc > _tsc_end) {
+			/* Make sure that subsequent calls don't return anything either */
+			_iter = _entries.end();
+			_queue = entry_queue();
+			return false;
+		}
+
+		tpoint = &spdk_trace_get_tpoint_section(_trace_file)->tpoint[entry->tpoint_id];
+		stats = &_stats[tpoint->object_type];
+
+		/* Without the index, objects need to be tracked from the very first entry */
+		if (_index == NULL && tpoint->new_object) {
+			stats->index[entry->object_id] = stats->counter++;
+			stats->start[entry->object_id] = entry->tsc;
+		}
+
+		if (entry->tsc < _tsc_start) {
+			continue;
+		}
+
+		if (_filter_type == OBJECT_NONE ||
+		    (tpoint->object_type == _filter_type && entry->object_id == _filter_id)) {
+			break;
+		}
 	}
 
-	pe->entry = entry = _iter->second;
-	pe->lcore = _iter->first.lcore;
+	pe->entry = entry;
+	pe->lcore = lcore;
 	pe->tname = spdk_get_per_lcore_history(_trace_file, pe->lcore)->tname;
 	/* Set related index to the max value to indicate "empty" state */
 	pe->related_index = UINT64_MAX;
 	pe->related_type = OBJECT_NONE;
-	tpoint = &spdk_trace_get_tpoint_section(_trace_file)->tpoint[entry->tpoint_id];
-	stats = &_stats[tpoint->object_type];
-
-	if (tpoint->new_object) {
-		stats->index[entry->object_id] = stats->counter++;
-		stats->start[entry->object_id] = entry->tsc;
-	}
 
 	if (tpoint->object_type != OBJECT_NONE) {
-		if (spdk_likely(stats->start.find(entry->object_id) != stats->start.end())) {
+		if (_index != NULL) {
+			obj = find_object(tpoint->object_type, entry->object_id, entry->tsc);
+			pe->object_index = obj != NULL ? obj->index : UINT64_MAX;
+			pe->object_start = obj != NULL ? obj->start : UINT64_MAX;
+		} else if (spdk_likely(stats->start.find(entry->object_id) != stats->start.end())) {
 			pe->object_index = stats->index[entry->object_id];
 			pe->object_start = stats->start[entry->object_id];
 		} else {
@@ -202,26 +393,371 @@ spdk_trace_parser::next_entry(spdk_trace_parser_entry *pe)
 	}
 
 	for (uint8_t i = 0; i < SPDK_TRACE_MAX_RELATIONS; ++i) {
+		uint8_t related_type = tpoint->related_objects[i].object_type;
+		uint64_t related_id;
+
 		/* The relations are stored inside a tpoint, which means there might be
 		 * multiple objects bound to a single tpoint. */
-		if (tpoint->related_objects[i].object_type == OBJECT_NONE) {
+		if (related_type == OBJECT_NONE) {
 			break;
 		}
-		stats = &_stats[tpoint->related_objects[i].object_type];
-		related_kv = stats->index.find(reinterpret_cast<uint64_t>
-					       (pe->args[tpoint->related_objects[i].arg_index].u.pointer));
+		related_id = reinterpret_cast<uint64_t>
+			     (pe->args[tpoint->related_objects[i].arg_index].u.pointer);
+		if (_index != NULL) {
+			obj = find_object(related_type, related_id, entry->tsc);
+			if (obj == NULL) {
+				continue;
+			}
+			pe->related_index = obj->index;
+		} else {
+			stats = &_stats[related_type];
+			related_kv = stats->index.find(related_id);
+			if (related_kv == stats->index.end()) {
+				continue;
+			}
+			pe->related_index = related_kv->second;
+		}
 		/* To avoid parsing the whole array, object index and type are stored
 		 * directly inside spdk_trace_parser_entry. */
-		if (related_kv != stats->index.end()) {
-			pe->related_index = related_kv->second;
-			pe->related_type = tpoint->related_objects[i].object_type;
-			pe->args[tpoint->related_objects[i].arg_index].is_related = true;
+		pe->related_type = related_type;
+		pe->args[tpoint->related_objects[i].arg_index].is_related = true;
+		break;
+	}
+
+	return true;
+}
+
+void
+spdk_trace_parser::seek_time_range(uint64_t tsc_start, uint64_t tsc_end)
+{
+	const trace_index_block *blocks, *block, *last_block;
+	const uint64_t *tsc;
+	index_cursor *cursor;
+	uint64_t first, last;
+	size_t i;
+
+	_tsc_start = tsc_start;
+	_tsc_end = tsc_end;
+	_filter_type = OBJECT_NONE;
+	_filter_id = 0;
+
+	if (_index == NULL) {
+		/* Object indices depend on all preceding entries, so start from the beginning and
+		 * skip the entries outside of the window in next_entry().
+		 */
+		for (i = 0; i < SPDK_TRACE_MAX_OBJECT; ++i) {
+			_stats[i] = object_stats();
+		}
+		_iter = _entries.begin();
+		return;
+	}
+
+	blocks = reinterpret_cast<const trace_index_block *>(
+			 reinterpret_cast<const char *>(_index) + _index->blocks_offset);
+	_queue = entry_queue();
+	for (i = 0; i < _cursors.size(); ++i) {
+		cursor = &_cursors[i];
+		if (cursor->lcore == NULL || cursor->lcore->num_entries == 0) {
+			continue;
+		}
+
+		/* Find the block containing the start of the window first, so that only a single
+		 * block's worth of the tsc column needs to be touched.
+		 */
+		last_block = &blocks[cursor->lcore->first_block + cursor->lcore->num_blocks];
+		block = std::lower_bound(&blocks[cursor->lcore->first_block], last_block, tsc_start,
+		[](const trace_index_block & b, uint64_t t) {
+			return b.last_tsc < t;
+		});
+		if (block == last_block) {
+			cursor->entry = cursor->lcore->num_entries;
+			continue;
+		}
+
+		first = (block - &blocks[cursor->lcore->first_block]) * _index->block_size;
+		last = spdk_min(first + _index->block_size, cursor->lcore->num_entries);
+		tsc = std::lower_bound(&cursor->tsc[first], &cursor->tsc[last], tsc_start);
+		cursor->entry = tsc - cursor->tsc;
+		if (cursor->entry < cursor->lcore->num_entries) {
+			_queue.push(entry_key(i, cursor->tsc[cursor->entry]));
+		}
+	}
+}
+
+int
+spdk_trace_parser::seek_object(uint8_t object_type, uint64_t object_index)
+{
+	const trace_index_object *obj;
+	uint64_t position;
+
+	if (object_type == OBJECT_NONE) {
+		return -EINVAL;
+	}
+
+	if (_objects == NULL) {
+		build_objects();
+	}
+
+	position = _object_types[object_type] + object_index;
+	if (object_index >= _object_types[object_type + 1] - _object_types[object_type] ||
+	    _objects_by_index[position] >= _num_objects) {
+		return -ENOENT;
+	}
+
+	obj = &_objects[_objects_by_index[position]];
+	seek_time_range(obj->start, obj->end);
+	_filter_type = object_type;
+	_filter_id = obj->object_id;
+
+	return 0;
+}
+
+void
+spdk_trace_parser::build_objects()
+{
+	std::map<uint64_t, uint64_t> live[SPDK_TRACE_MAX_OBJECT];
+	std::map<uint64_t, uint64_t>::iterator it;
+	std::vector<trace_index_object> &objects = _object_table;
+	std::vector<uint64_t> order;
+	spdk_trace_tpoint *tpoint;
+	spdk_trace_entry *entry;
+	trace_index_object obj = {};
+	uint64_t counter[SPDK_TRACE_MAX_OBJECT] = {};
+	uint64_t i;
+
+	assert(_index == NULL);
+	for (entry_map::iterator e = _entries.begin(); e != _entries.end(); ++e) {
+		entry = e->second;
+		tpoint = &spdk_trace_get_tpoint_section(_trace_file)->tpoint[entry->tpoint_id];
+		if (tpoint->object_type == OBJECT_NONE) {
+			continue;
+		}
+
+		if (tpoint->new_object) {
+			obj.object_id = entry->object_id;
+			obj.start = obj.end = entry->tsc;
+			obj.index = counter[tpoint->object_type]++;
+			obj.type = tpoint->object_type;
+			live[obj.type][obj.object_id] = objects.size();
+			objects.push_back(obj);
+		} else {
+			it = live[tpoint->object_type].find(entry->object_id);
+			if (it != live[tpoint->object_type].end()) {
+				objects[it->second].end = entry->tsc;
+			}
+		}
+	}
+
+	/* Objects are created in index order, so remember the creation order before sorting */
+	order.resize(objects.size());
+	for (i = 0; i < order.size(); ++i) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&objects](uint64_t a, uint64_t b) {
+		const trace_index_object &x = objects[a], &y = objects[b];
+
+		if (x.type != y.type) {
+			return x.type < y.type;
+		} else if (x.object_id != y.object_id) {
+			return x.object_id < y.object_id;
+		}
+		return x.start < y.start;
+	});
+
+	std::vector<trace_index_object> sorted(objects.size());
+	_object_by_index_table.resize(objects.size());
+	_object_type_table.assign(SPDK_TRACE_MAX_OBJECT + 1, 0);
+	for (i = 0; i < order.size(); ++i) {
+		sorted[i] = objects[order[i]];
+		_object_type_table[sorted[i].type + 1]++;
+	}
+	for (i = 1; i <= SPDK_TRACE_MAX_OBJECT; ++i) {
+		_object_type_table[i] += _object_type_table[i - 1];
+	}
+	for (i = 0; i < sorted.size(); ++i) {
+		_object_by_index_table[_object_type_table[sorted[i].type] + sorted[i].index] = i;
+	}
+	objects.swap(sorted);
+
+	_objects = _object_table.data();
+	_objects_by_index = _object_by_index_table.data();
+	_object_types = _object_type_table.data();
+	_num_objects = _object_table.size();
+}
+
+uint64_t
+spdk_trace_parser::entry_chain_length(spdk_trace_entry *entry, uint16_t lcore)
+{
+	spdk_trace_entry_buffer *buffer = reinterpret_cast<spdk_trace_entry_buffer *>(entry);
+	spdk_trace_history *history = spdk_get_per_lcore_history(_trace_file, lcore);
+	uint64_t length = 1;
+
+	/* Count the buffers holding the arguments that didn't fit in the entry itself */
+	while (length < history->num_entries) {
+		buffer = get_next_buffer(buffer, lcore);
+		if (buffer->tpoint_id != SPDK_TRACE_MAX_TPOINT_ID || buffer->tsc != entry->tsc) {
 			break;
 		}
+		length++;
 	}
 
-	_iter++;
-	return true;
+	return length;
+}
+
+int
+spdk_trace_parser::save_index(const char *filename)
+{
+	std::map<uint16_t, std::vector<spdk_trace_entry *>> lcores;
+	std::vector<spdk_trace_entry *> *entries;
+	spdk_trace_history *src, *dst;
+	trace_index_header *hdr;
+	trace_index_lcore *lc;
+	trace_index_block *blocks;
+	uint64_t *tsc, *position;
+	uint64_t index_offset, index_size, offset, num_blocks, block, pos, length, i;
+	char *buf;
+	int fd, rc = 0;
+
+	if (_index != NULL) {
+		return -EINVAL;
+	}
+
+	if (_objects == NULL) {
+		build_objects();
+	}
+
+	num_blocks = 0;
+	for (entry_map::iterator e = _entries.begin(); e != _entries.end(); ++e) {
+		lcores[e->first.lcore].push_back(e->second);
+	}
+	for (auto &l : lcores) {
+		num_blocks += SPDK_CEIL_DIV(l.second.size(), TRACE_INDEX_BLOCK_SIZE);
+	}
+
+	index_offset = SPDK_ALIGN_CEIL(_map_size, TRACE_INDEX_ALIGN);
+	index_size = sizeof(*hdr) + lcores.size() * sizeof(*lc) + num_blocks * sizeof(*blocks) +
+		     _num_objects * (sizeof(trace_index_object) + sizeof(uint64_t));
+	for (auto &l : lcores) {
+		index_size += 2 * l.second.size() * sizeof(uint64_t);
+	}
+
+	fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if (fd < 0) {
+		SPDK_ERRLOG("Could not open index file: %s (%d)\n", filename, errno);
+		return -errno;
+	}
+
+	if (ftruncate(fd, index_offset + index_size) != 0) {
+		rc = -errno;
+		SPDK_ERRLOG("Could not resize index file: %s (%d)\n", filename, errno);
+		goto out;
+	}
+
+	buf = static_cast<char *>(mmap(NULL, index_offset + index_size, PROT_READ | PROT_WRITE,
+				       MAP_SHARED, fd, 0));
+	if (buf == MAP_FAILED) {
+		rc = -errno;
+		SPDK_ERRLOG("Could not mmap index file: %s (%d)\n", filename, errno);
+		goto out;
+	}
+
+	memcpy(buf, _trace_file, _map_size);
+	/* Unroll the histories, so that entries are sorted by their tsc starting at index 0 */
+	for (i = 0; i < SPDK_TRACE_MAX_LCORE; ++i) {
+		dst = spdk_get_per_lcore_history(reinterpret_cast<spdk_trace_file *>(buf), i);
+		if (dst != NULL) {
+			memset(spdk_trace_history_get_entry(dst, 0), 0,
+			       dst->num_entries * sizeof(spdk_trace_entry));
+			dst->next_entry = 0;
+		}
+	}
+
+	hdr = reinterpret_cast<trace_index_header *>(buf + index_offset);
+	memcpy(hdr->magic, TRACE_INDEX_MAGIC, sizeof(hdr->magic));
+	hdr->version = TRACE_INDEX_VERSION;
+	hdr->block_size = TRACE_INDEX_BLOCK_SIZE;
+	hdr->tsc_offset = _tsc_offset;
+	hdr->num_lcores = lcores.size();
+	hdr->lcores_offset = sizeof(*hdr);
+	hdr->num_blocks = num_blocks;
+	hdr->blocks_offset = hdr->lcores_offset + hdr->num_lcores * sizeof(*lc);
+	hdr->num_objects = _num_objects;
+	hdr->objects_offset = hdr->blocks_offset + num_blocks * sizeof(*blocks);
+	hdr->objects_by_index_offset = hdr->objects_offset +
+				       _num_objects * sizeof(trace_index_object);
+	memcpy(hdr->object_types, _object_types, sizeof(hdr->object_types));
+	memcpy(reinterpret_cast<char *>(hdr) + hdr->objects_offset, _objects,
+	       _num_objects * sizeof(trace_index_object));
+	memcpy(reinterpret_cast<char *>(hdr) + hdr->objects_by_index_offset, _objects_by_index,
+	       _num_objects * sizeof(uint64_t));
+
+	lc = reinterpret_cast<trace_index_lcore *>(reinterpret_cast<char *>(hdr) +
+			hdr->lcores_offset);
+	blocks = reinterpret_cast<trace_index_block *>(reinterpret_cast<char *>(hdr) +
+			hdr->blocks_offset);
+	offset = hdr->objects_by_index_offset + _num_objects * sizeof(uint64_t);
+	block = 0;
+	for (auto &l : lcores) {
+		entries = &l.second;
+		src = spdk_get_per_lcore_history(_trace_file, l.first);
+		dst = spdk_get_per_lcore_history(reinterpret_cast<spdk_trace_file *>(buf), l.first);
+
+		lc->lcore = l.first;
+		lc->num_entries = entries->size();
+		lc->tsc_offset = offset;
+		lc->position_offset = offset + entries->size() * sizeof(uint64_t);
+		lc->first_block = block;
+		lc->num_blocks = SPDK_CEIL_DIV(entries->size(), TRACE_INDEX_BLOCK_SIZE);
+		tsc = reinterpret_cast<uint64_t *>(reinterpret_cast<char *>(hdr) + lc->tsc_offset);
+		position = reinterpret_cast<uint64_t *>(reinterpret_cast<char *>(hdr) +
+							lc->position_offset);
+
+		pos = 0;
+		for (i = 0; i < entries->size(); ++i) {
+			spdk_trace_entry_buffer *buffer;
+
+			length = entry_chain_length((*entries)[i], l.first);
+			buffer = reinterpret_cast<spdk_trace_entry_buffer *>((*entries)[i]);
+			tsc[i] = (*entries)[i]->tsc;
+			position[i] = pos;
+			for (uint64_t j = 0; j < length; ++j) {
+				memcpy(spdk_trace_history_get_entry(dst, pos++), buffer,
+				       sizeof(*buffer));
+				buffer = get_next_buffer(buffer, l.first);
+			}
+
+			if (i % TRACE_INDEX_BLOCK_SIZE == 0) {
+				blocks[block].first_tsc = tsc[i];
+			}
+			blocks[block].last_tsc = tsc[i];
+			if (i % TRACE_INDEX_BLOCK_SIZE == TRACE_INDEX_BLOCK_SIZE - 1) {
+				block++;
+			}
+		}
+		if (entries->size() % TRACE_INDEX_BLOCK_SIZE != 0) {
+			block++;
+		}
+
+		assert(pos <= src->num_entries);
+		dst->next_entry = pos % src->num_entries;
+		offset += 2 * entries->size() * sizeof(uint64_t);
+		lc++;
+	}
+	assert(block == num_blocks);
+	assert(offset == index_size);
+
+	if (msync(buf, index_offset + index_size, MS_SYNC) != 0) {
+		rc = -errno;
+		SPDK_ERRLOG("Could not write index file: %s (%d)\n", filename, errno);
+	}
+	munmap(buf, index_offset + index_size);
+out:
+	close(fd);
+	if (rc != 0) {
+		unlink(filename);
+	}
+
+	return rc;
 }
 
 void
@@ -281,6 +817,108 @@ spdk_trace_parser::populate_events(spdk_trace_history *history, int num_entries,
 	}
 }
 
+static bool
+index_range_valid(uint64_t offset, uint64_t count, size_t size, uint64_t index_size)
+{
+	return offset <= index_size && count <= (index_size - offset) / size;
+}
+
+bool
+spdk_trace_parser::init_index(const spdk_trace_parser_opts *opts, size_t file_size)
+{
+	const trace_index_lcore *lcores, *lc;
+	spdk_trace_history *history;
+	index_cursor *cursor;
+	const char *base;
+	uint64_t index_offset, index_size, i;
+
+	munmap(_trace_file, _map_size);
+	_map_size = file_size;
+	_trace_file = static_cast<spdk_trace_file *>(mmap(NULL, _map_size, PROT_READ,
+			MAP_SHARED, _fd, 0));
+	if (_trace_file == MAP_FAILED) {
+		SPDK_ERRLOG("Could not mmap trace file: %s\n", opts->filename);
+		_trace_file = NULL;
+		return false;
+	}
+
+	index_offset = SPDK_ALIGN_CEIL(spdk_get_trace_file_size(_trace_file), TRACE_INDEX_ALIGN);
+	index_size = file_size - index_offset;
+	base = reinterpret_cast<const char *>(_trace_file) + index_offset;
+	_index = reinterpret_cast<const trace_index_header *>(base);
+	if (_index->version != TRACE_INDEX_VERSION || _index->block_size == 0 ||
+	    !index_range_valid(_index->lcores_offset, _index->num_lcores,
+			       sizeof(trace_index_lcore), index_size) ||
+	    !index_range_valid(_index->blocks_offset, _index->num_blocks,
+			       sizeof(trace_index_block), index_size) ||
+	    !index_range_valid(_index->objects_offset, _index->num_objects,
+			       sizeof(trace_index_object), index_size) ||
+	    !index_range_valid(_index->objects_by_index_offset, _index->num_objects,
+			       sizeof(uint64_t), index_size) ||
+	    _index->object_types[SPDK_TRACE_MAX_OBJECT] != _index->num_objects) {
+		SPDK_ERRLOG("Invalid trace index in %s\n", opts->filename);
+		return false;
+	}
+
+	for (i = 0; i < SPDK_TRACE_MAX_OBJECT; ++i) {
+		if (_index->object_types[i] > _index->object_types[i + 1]) {
+			SPDK_ERRLOG("Invalid trace index in %s\n", opts->filename);
+			return false;
+		}
+	}
+
+	_objects = reinterpret_cast<const trace_index_object *>(base + _index->objects_offset);
+	_objects_by_index = reinterpret_cast<const uint64_t *>(base +
+			    _index->objects_by_index_offset);
+	_object_types = _index->object_types;
+	_num_objects = _index->num_objects;
+	_tsc_offset = _index->tsc_offset;
+
+	if (opts->lcore != SPDK_TRACE_MAX_LCORE &&
+	    spdk_get_per_lcore_history(_trace_file, opts->lcore) == NULL) {
+		SPDK_ERRLOG("Trace file %s has no trace history for lcore %d\n",
+			    opts->filename, opts->lcore);
+		return false;
+	}
+
+	_cursors.resize(SPDK_TRACE_MAX_LCORE);
+	lcores = reinterpret_cast<const trace_index_lcore *>(base + _index->lcores_offset);
+	for (i = 0; i < _index->num_lcores; ++i) {
+		lc = &lcores[i];
+		history = lc->lcore < SPDK_TRACE_MAX_LCORE ?
+			  spdk_get_per_lcore_history(_trace_file, lc->lcore) : NULL;
+		if (history == NULL || lc->num_entries > history->num_entries ||
+		    !index_range_valid(lc->tsc_offset, lc->num_entries, sizeof(uint64_t),
+				       index_size) ||
+		    !index_range_valid(lc->position_offset, lc->num_entries, sizeof(uint64_t),
+				       index_size) ||
+		    lc->first_block > _index->num_blocks ||
+		    lc->num_blocks != SPDK_CEIL_DIV(lc->num_entries, _index->block_size) ||
+		    lc->num_blocks > _index->num_blocks - lc->first_block) {
+			SPDK_ERRLOG("Invalid trace index in %s\n", opts->filename);
+			return false;
+		}
+
+		if (opts->lcore != SPDK_TRACE_MAX_LCORE && opts->lcore != lc->lcore) {
+			continue;
+		}
+
+		cursor = &_cursors[lc->lcore];
+		cursor->history = history;
+		cursor->lcore = lc;
+		cursor->tsc = reinterpret_cast<const uint64_t *>(base + lc->tsc_offset);
+		cursor->position = reinterpret_cast<const uint64_t *>(base + lc->position_offset);
+		if (opts->lcore != SPDK_TRACE_MAX_LCORE && lc->num_entries > 0) {
+			/* Match the offset used when parsing a single lcore without the index */
+			_tsc_offset = cursor->tsc[0];
+		}
+	}
+
+	seek_time_range(0, UINT64_MAX);
+
+	return true;
+}
+
 bool
 spdk_trace_parser::init(const spdk_trace_parser_opts *opts)
 {
@@ -288,6 +926,7 @@ spdk_trace_parser::init(const spdk_trace_parser_opts *opts)
 	struct stat st;
 	int rc, i, entry_num;
 	bool overflowed;
+	char magic[sizeof(TRACE_INDEX_MAGIC) - 1];
 
 	switch (opts->mode) {
 	case SPDK_TRACE_PARSER_MODE_FILE:
@@ -343,6 +982,15 @@ spdk_trace_parser::init(const spdk_trace_parser_opts *opts)
 		return false;
 	}
 
+	/* Use the index instead of parsing all of the entries if there's one */
+	if (opts->mode == SPDK_TRACE_PARSER_MODE_FILE &&
+	    (size_t)st.st_size >= SPDK_ALIGN_CEIL(_map_size, TRACE_INDEX_ALIGN) +
+	    sizeof(trace_index_header) &&
+	    pread(_fd, magic, sizeof(magic), SPDK_ALIGN_CEIL(_map_size, TRACE_INDEX_ALIGN)) ==
+	    (ssize_t)sizeof(magic) && memcmp(magic, TRACE_INDEX_MAGIC, sizeof(magic)) == 0) {
+		return init_index(opts, st.st_size);
+	}
+
 	if (opts->lcore == SPDK_TRACE_MAX_LCORE) {
 		/* Check if any reactors have overwritten their circular buffer. */
 		for (i = 0; i < SPDK_TRACE_MAX_LCORE; i++) {
@@ -408,7 +1056,16 @@ spdk_trace_parser::spdk_trace_parser(const spdk_trace_parser_opts *opts) :
 	_trace_file(NULL),
 	_map_size(0),
 	_fd(-1),
-	_tsc_offset(0)
+	_tsc_offset(0),
+	_tsc_start(0),
+	_tsc_end(UINT64_MAX),
+	_filter_type(OBJECT_NONE),
+	_filter_id(0),
+	_index(NULL),
+	_objects(NULL),
+	_objects_by_index(NULL),
+	_object_types(NULL),
+	_num_objects(0)
 {
 	if (!init(opts)) {
 		cleanup();
@@ -461,3 +1118,37 @@ spdk_trace_parser_get_entry_count(const struct spdk_trace_parser *parser, uint16
 {
 	return parser->entry_count(lcore);
 }
+
+bool
+spdk_trace_parser_is_indexed(const struct spdk_trace_parser *parser)
+{
+	return parser->indexed();
+}
+
+void
+spdk_trace_parser_seek_time_range(struct spdk_trace_parser *parser, uint64_t tsc_start,
+				  uint64_t tsc_end)
+{
+	parser->seek_time_range(tsc_start, tsc_end);
+}
+
+int
+spdk_trace_parser_seek_object(struct spdk_trace_parser *parser, uint8_t object_type,
+			      uint64_t object_index)
+{
+	try {
+		return parser->seek_object(object_type, object_index);
+	} catch (...) {
+		return -ENOMEM;
+	}
+}
+
+int
+spdk_trace_parser_save_index(struct spdk_trace_parser *parser, const char *filename)
+{
+	try {
+		return parser->save_index(filename);
+	} catch (...) {
+		return -ENOMEM;
+	}
+}
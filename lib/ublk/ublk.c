@@ -8,6 +8,7 @@
 #include "spdk/stdinc.h"
 #include "spdk/string.h"
 #include "spdk/bdev.h"
+#include "spdk/dma.h"
 #include "spdk/endian.h"
 #include "spdk/env.h"
 #include "spdk/likely.h"
@@ -46,6 +47,7 @@ static uint32_t g_next_ublk_poll_group = 0;
 static uint32_t g_ublks_max = UBLK_DEFAULT_MAX_SUPPORTED_DEVS;
 static struct spdk_cpuset g_core_mask;
 static bool g_disable_user_copy = false;
+static bool g_disable_zero_copy = false;
 
 struct ublk_queue;
 struct ublk_poll_group;
@@ -93,6 +95,8 @@ struct ublk_io {
 	/* for bdev io_wait */
 	struct spdk_bdev_io_wait_entry bdev_io_wait;
 	struct spdk_iobuf_entry	iobuf;
+	/* Request data in the ublk memory domain, used in zero-copy mode */
+	struct iovec		zc_iov;
 
 	TAILQ_ENTRY(ublk_io)	tailq;
 };
@@ -139,6 +143,8 @@ struct spdk_ublk_dev {
 	uint32_t		ctrl_ops_in_progress;
 	bool			is_closing;
 	bool			is_recovering;
+	/* Request data is handed to the bdev without copying it */
+	bool			zero_copy;
 
 	TAILQ_ENTRY(spdk_ublk_dev) tailq;
 	TAILQ_ENTRY(spdk_ublk_dev) wait_tailq;
@@ -169,6 +175,10 @@ struct ublk_tgt {
 	bool			user_copy;
 	/* `ublk_drv` supports UBLK_F_USER_RECOVERY */
 	bool			user_recovery;
+	/* `ublk_drv` supports UBLK_F_SUPPORT_ZERO_COPY */
+	bool			zero_copy;
+	/* Memory domain describing request data in zero-copy mode */
+	struct spdk_memory_domain	*memory_domain;
 };
 
 static TAILQ_HEAD(, spdk_ublk_dev) g_ublk_devs = TAILQ_HEAD_INITIALIZER(g_ublk_devs);
@@ -277,6 +287,136 @@ ublk_user_copy_pos(uint16_t q_id, uint16_t tag)
 				uint64_t)tag) << UBLK_TAG_OFF));
 }
 
+/*
+ * In zero-copy mode request data is described by its user-copy position on the ublk
+ * character device.  Bdevs that understand the ublk memory domain translate it and let
+ * the kernel move the data, everything else falls back to pull/push, which copies the
+ * data through the character device just like user copy does.
+ */
+static int
+ublk_memory_domain_translate(struct spdk_memory_domain *src_domain, void *src_domain_ctx,
+			     struct spdk_memory_domain *dst_domain,
+			     struct spdk_memory_domain_translation_ctx *dst_domain_ctx,
+			     void *addr, size_t len,
+			     struct spdk_memory_domain_translation_result *result)
+{
+	struct ublk_io *io = src_domain_ctx;
+	uint64_t pos = ublk_user_copy_pos(io->q->q_id, io->tag);
+
+	if (spdk_memory_domain_get_dma_device_type(dst_domain) != SPDK_DMA_DEVICE_TYPE_UBLK) {
+		return -ENOTSUP;
+	}
+
+	if ((uintptr_t)addr < pos || (uintptr_t)addr + len > pos + io->payload_size) {
+		return -EINVAL;
+	}
+
+	result->iov_count = 1;
+	result->iov.iov_base = addr;
+	result->iov.iov_len = len;
+	result->dst_domain = dst_domain;
+	result->ublk.fd = io->q->dev->cdev_fd;
+	result->ublk.q_id = io->q->q_id;
+	result->ublk.tag = io->tag;
+	result->ublk.offset = (uintptr_t)addr - pos;
+
+	return 0;
+}
+
+static int
+ublk_memory_domain_copy(struct ublk_io *io, struct iovec *ublk_iov, uint32_t ublk_iovcnt,
+			struct iovec *iov, uint32_t iovcnt, bool is_pull)
+{
+	struct spdk_ioviter iter;
+	void *ublk_buf, *buf;
+	size_t len;
+	ssize_t rc;
+
+	for (len = spdk_ioviter_first(&iter, ublk_iov, ublk_iovcnt, iov, iovcnt, &ublk_buf, &buf);
+	     len != 0; len = spdk_ioviter_next(&iter, &ublk_buf, &buf)) {
+		if (is_pull) {
+			rc = pread(io->q->dev->cdev_fd, buf, len, (off_t)(uintptr_t)ublk_buf);
+		} else {
+			rc = pwrite(io->q->dev->cdev_fd, buf, len, (off_t)(uintptr_t)ublk_buf);
+		}
+		if (rc != (ssize_t)len) {
+			return rc < 0 ? -errno : -EIO;
+		}
+	}
+
+	return 0;
+}
+
+static int
+ublk_memory_domain_pull(struct spdk_memory_domain *src_domain, void *src_domain_ctx,
+			struct iovec *src_iov, uint32_t src_iovcnt, struct iovec *dst_iov,
+			uint32_t dst_iovcnt, spdk_memory_domain_data_cpl_cb cpl_cb,
+			void *cpl_cb_arg)
+{
+	int rc;
+
+	rc = ublk_memory_domain_copy(src_domain_ctx, src_iov, src_iovcnt, dst_iov, dst_iovcnt,
+				     true);
+	if (rc != 0) {
+		return rc;
+	}
+
+	cpl_cb(cpl_cb_arg, 0);
+	return 0;
+}
+
+static int
+ublk_memory_domain_push(struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
+			struct iovec *dst_iov, uint32_t dst_iovcnt, struct iovec *src_iov,
+			uint32_t src_iovcnt, spdk_memory_domain_data_cpl_cb cpl_cb,
+			void *cpl_cb_arg)
+{
+	int rc;
+
+	rc = ublk_memory_domain_copy(dst_domain_ctx, dst_iov, dst_iovcnt, src_iov, src_iovcnt,
+				     false);
+	if (rc != 0) {
+		return rc;
+	}
+
+	cpl_cb(cpl_cb_arg, 0);
+	return 0;
+}
+
+static int
+ublk_memory_domain_create(void)
+{
+	int rc;
+
+	rc = spdk_memory_domain_create(&g_ublk_tgt.memory_domain, SPDK_DMA_DEVICE_TYPE_UBLK, NULL,
+				       "ublk");
+	if (rc != 0) {
+		return rc;
+	}
+
+	spdk_memory_domain_set_translation(g_ublk_tgt.memory_domain, ublk_memory_domain_translate);
+	spdk_memory_domain_set_pull(g_ublk_tgt.memory_domain, ublk_memory_domain_pull);
+	spdk_memory_domain_set_push(g_ublk_tgt.memory_domain, ublk_memory_domain_push);
+
+	return 0;
+}
+
+static bool
+ublk_bdev_supports_zero_copy(struct spdk_bdev *bdev)
+{
+	enum spdk_dma_device_type types[8];
+	int i, num_types;
+
+	num_types = spdk_bdev_get_memory_domain_types(bdev, types, SPDK_COUNTOF(types));
+	for (i = 0; i < spdk_min(num_types, (int)SPDK_COUNTOF(types)); i++) {
+		if (types[i] == SPDK_DMA_DEVICE_TYPE_UBLK) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 void
 spdk_ublk_init(void)
 {
@@ -356,6 +496,11 @@ ublk_ctrl_process_cqe(struct io_uring_cqe *cqe)
 
 	switch (ublk->current_cmd_op) {
 	case UBLK_CMD_ADD_DEV:
+		/* Kernels without zero-copy support silently clear the flag */
+		if (ublk->zero_copy && !(ublk->dev_info.flags & UBLK_F_SUPPORT_ZERO_COPY)) {
+			SPDK_NOTICELOG("ublk %u falls back to user copy\n", ublk->ublk_id);
+			ublk->zero_copy = false;
+		}
 		rc = ublk_set_params(ublk);
 		if (rc < 0) {
 			ublk_delete_dev(ublk);
@@ -569,7 +714,12 @@ ublk_ctrl_cmd_get_features(void)
 		g_ublk_tgt.user_copy = !!(g_ublk_tgt.features & UBLK_F_USER_COPY);
 		g_ublk_tgt.user_copy &= !g_disable_user_copy;
 		g_ublk_tgt.user_recovery = !!(g_ublk_tgt.features & UBLK_F_USER_RECOVERY);
+		/* Zero copy shares the command layout of user copy */
+		g_ublk_tgt.zero_copy = g_ublk_tgt.user_copy &&
+				       !!(g_ublk_tgt.features & UBLK_F_SUPPORT_ZERO_COPY);
+		g_ublk_tgt.zero_copy &= !g_disable_zero_copy;
 		SPDK_NOTICELOG("User Copy %s\n", g_ublk_tgt.user_copy ? "enabled" : "disabled");
+		SPDK_NOTICELOG("Zero Copy %s\n", g_ublk_tgt.zero_copy ? "enabled" : "disabled");
 	}
 	io_uring_cqe_seen(&g_ublk_tgt.ctrl_ring, cqe);
 
@@ -686,7 +836,7 @@ ublk_poller_register(void *args)
 }
 
 int
-ublk_create_target(const char *cpumask_str, bool disable_user_copy)
+ublk_create_target(const char *cpumask_str, bool disable_user_copy, bool disable_zero_copy)
 {
 	int rc;
 	uint32_t i;
@@ -704,6 +854,7 @@ ublk_create_target(const char *cpumask_str, bool disable_user_copy)
 	}
 
 	g_disable_user_copy = disable_user_copy;
+	g_disable_zero_copy = disable_zero_copy;
 
 	assert(g_ublk_tgt.poll_groups == NULL);
 	g_ublk_tgt.poll_groups = calloc(spdk_env_get_core_count(), sizeof(*poll_group));
@@ -719,6 +870,15 @@ ublk_create_target(const char *cpumask_str, bool disable_user_copy)
 		return rc;
 	}
 
+	if (g_ublk_tgt.zero_copy) {
+		rc = ublk_memory_domain_create();
+		if (rc != 0) {
+			SPDK_WARNLOG("Fail to create ublk memory domain, error=%s\n",
+				     spdk_strerror(-rc));
+			g_ublk_tgt.zero_copy = false;
+		}
+	}
+
 	spdk_iobuf_register_module("ublk");
 
 	SPDK_ENV_FOREACH_CORE(i) {
@@ -756,6 +916,9 @@ _ublk_fini_done(void *args)
 	g_ublk_tgt.ioctl_encode = false;
 	g_ublk_tgt.user_copy = false;
 	g_ublk_tgt.user_recovery = false;
+	g_ublk_tgt.zero_copy = false;
+	spdk_memory_domain_destroy(g_ublk_tgt.memory_domain);
+	g_ublk_tgt.memory_domain = NULL;
 
 	if (g_ublk_tgt.cb_fn) {
 		g_ublk_tgt.cb_fn(g_ublk_tgt.cb_arg);
@@ -912,6 +1075,12 @@ ublk_dev_get_bdev_name(struct spdk_ublk_dev *ublk)
 	return spdk_bdev_get_name(ublk->bdev);
 }
 
+bool
+ublk_dev_is_zero_copy(struct spdk_ublk_dev *ublk)
+{
+	return ublk->zero_copy;
+}
+
 void
 spdk_ublk_write_config_json(struct spdk_json_write_ctx *w)
 {
@@ -925,6 +1094,12 @@ spdk_ublk_write_config_json(struct spdk_json_write_ctx *w)
 		spdk_json_write_named_string(w, "method", "ublk_create_target");
 		spdk_json_write_named_object_begin(w, "params");
 		spdk_json_write_named_string(w, "cpumask", spdk_cpuset_fmt(&g_core_mask));
+		if (g_disable_user_copy) {
+			spdk_json_write_named_bool(w, "disable_user_copy", true);
+		}
+		if (g_disable_zero_copy) {
+			spdk_json_write_named_bool(w, "disable_zero_copy", true);
+		}
 		spdk_json_write_object_end(w);
 
 		spdk_json_write_object_end(w);
@@ -1225,6 +1400,29 @@ ublk_io_put_buffer(struct ublk_io *io, struct spdk_iobuf_channel *iobuf_ch)
 	}
 }
 
+static int
+ublk_submit_zero_copy_io(struct ublk_io *io, uint8_t ublk_op, uint64_t offset_blocks,
+			 uint64_t num_blocks)
+{
+	struct spdk_bdev_ext_io_opts opts = {
+		.size = SPDK_SIZEOF(&opts, memory_domain_ctx),
+		.memory_domain = g_ublk_tgt.memory_domain,
+		.memory_domain_ctx = io,
+	};
+
+	io->zc_iov.iov_base = (void *)(uintptr_t)ublk_user_copy_pos(io->q->q_id, io->tag);
+	io->zc_iov.iov_len = io->payload_size;
+
+	if (ublk_op == UBLK_IO_OP_READ) {
+		return spdk_bdev_readv_blocks_ext(io->bdev_desc, io->bdev_ch, &io->zc_iov, 1,
+						  offset_blocks, num_blocks, ublk_io_done, io,
+						  &opts);
+	}
+
+	return spdk_bdev_writev_blocks_ext(io->bdev_desc, io->bdev_ch, &io->zc_iov, 1,
+					   offset_blocks, num_blocks, ublk_io_done, io, &opts);
+}
+
 static void
 _ublk_submit_bdev_io(struct ublk_queue *q, struct ublk_io *io)
 {
@@ -1241,6 +1439,11 @@ _ublk_submit_bdev_io(struct ublk_queue *q, struct ublk_io *io)
 	offset_blocks = iod->start_sector >> ublk->sector_per_block_shift;
 	num_blocks = iod->nr_sectors >> ublk->sector_per_block_shift;
 
+	if (ublk->zero_copy && (ublk_op == UBLK_IO_OP_READ || ublk_op == UBLK_IO_OP_WRITE)) {
+		rc = ublk_submit_zero_copy_io(io, ublk_op, offset_blocks, num_blocks);
+		goto out;
+	}
+
 	switch (ublk_op) {
 	case UBLK_IO_OP_READ:
 		if (g_ublk_tgt.user_copy) {
@@ -1266,6 +1469,7 @@ _ublk_submit_bdev_io(struct ublk_queue *q, struct ublk_io *io)
 		rc = -1;
 	}
 
+out:
 	if (rc < 0) {
 		if (rc == -ENOMEM) {
 			SPDK_INFOLOG(ublk, "No memory, start to queue io.\n");
@@ -1298,6 +1502,13 @@ ublk_submit_bdev_io(struct ublk_queue *q, struct ublk_io *io)
 
 	io->result = iod->nr_sectors * (1ULL << LINUX_SECTOR_SHIFT);
 	ublk_op = ublksrv_get_op(iod);
+	if (q->dev->zero_copy && (ublk_op == UBLK_IO_OP_READ || ublk_op == UBLK_IO_OP_WRITE)) {
+		/* The bdev accesses the request pages directly, no bounce buffer is needed */
+		io->payload_size = io->result;
+		_ublk_submit_bdev_io(q, io);
+		return;
+	}
+
 	switch (ublk_op) {
 	case UBLK_IO_OP_READ:
 		ublk_io_get_buffer(io, iobuf_ch, read_get_buffer_done);
@@ -1683,6 +1894,9 @@ ublk_dev_info_init(struct spdk_ublk_dev *ublk)
 
 	if (g_ublk_tgt.user_copy) {
 		uinfo.flags |= UBLK_F_USER_COPY;
+		if (ublk->zero_copy) {
+			uinfo.flags |= UBLK_F_SUPPORT_ZERO_COPY;
+		}
 	} else {
 		uinfo.flags |= UBLK_F_NEED_GET_DATA;
 	}
@@ -1938,6 +2152,7 @@ ublk_start_disk(const char *bdev_name, uint32_t ublk_id,
 		ublk->queues[i].ring.ring_fd = -1;
 	}
 
+	ublk->zero_copy = g_ublk_tgt.zero_copy && ublk_bdev_supports_zero_copy(bdev);
 	ublk_dev_info_init(ublk);
 	ublk_info_param_init(ublk);
 	rc = ublk_ios_init(ublk);
@@ -2016,6 +2231,9 @@ ublk_ctrl_start_recovery(struct spdk_ublk_dev *ublk)
 	ublk->num_queues = ublk->dev_info.nr_hw_queues;
 	ublk->queue_depth = ublk->dev_info.queue_depth;
 	ublk->dev_info.ublksrv_pid = getpid();
+	/* Zero-copy devices still accept user copy, so the bdev may have changed in between */
+	ublk->zero_copy = !!(ublk->dev_info.flags & UBLK_F_SUPPORT_ZERO_COPY) &&
+			  g_ublk_tgt.zero_copy && ublk_bdev_supports_zero_copy(ublk->bdev);
 
 	SPDK_DEBUGLOG(ublk, "Recovering ublk %d, num queues %u, queue depth %u, flags 0x%llx\n",
 		      ublk->ublk_id,
@@ -54,7 +54,7 @@ extern "C" {
 
 typedef void (*ublk_ctrl_cb)(void *cb_arg, int result);
 
-int ublk_create_target(const char *cpumask_str, bool disable_user_copy);
+int ublk_create_target(const char *cpumask_str, bool disable_user_copy, bool disable_zero_copy);
 int ublk_destroy_target(spdk_ublk_fini_cb cb_fn, void *cb_arg);
 int ublk_start_disk(const char *bdev_name, uint32_t ublk_id,
 		    uint32_t num_queues, uint32_t queue_depth,
@@ -70,6 +70,7 @@ struct spdk_ublk_dev *ublk_dev_first(void);
 struct spdk_ublk_dev *ublk_dev_next(struct spdk_ublk_dev *prev);
 uint32_t ublk_dev_get_queue_depth(struct spdk_ublk_dev *ublk);
 uint32_t ublk_dev_get_num_queues(struct spdk_ublk_dev *ublk);
+bool ublk_dev_is_zero_copy(struct spdk_ublk_dev *ublk);
 
 #ifdef __cplusplus
 }
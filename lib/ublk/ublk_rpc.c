@@ -27,7 +27,7 @@ rpc_ublk_create_target(struct spdk_jsonrpc_request *request, const struct spdk_j
 			goto invalid;
 		}
 	}
-	rc = ublk_create_target(req.cpumask, req.disable_user_copy);
+	rc = ublk_create_target(req.cpumask, req.disable_user_copy, req.disable_zero_copy);
 	if (rc != 0) {
 		goto invalid;
 	}
@@ -176,6 +176,7 @@ rpc_dump_ublk_info(struct spdk_json_write_ctx *w,
 	spdk_json_write_named_uint32(w, "queue_depth", ublk_dev_get_queue_depth(ublk));
 	spdk_json_write_named_uint32(w, "num_queues", ublk_dev_get_num_queues(ublk));
 	spdk_json_write_named_string(w, "bdev_name", ublk_dev_get_bdev_name(ublk));
+	spdk_json_write_named_bool(w, "zero_copy", ublk_dev_is_zero_copy(ublk));
 
 	spdk_json_write_object_end(w);
 }
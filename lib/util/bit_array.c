@@ -20,9 +20,26 @@ typedef uint64_t spdk_bit_array_word;
 #define SPDK_BIT_ARRAY_WORD_BITS	(SPDK_BIT_ARRAY_WORD_BYTES * 8)
 #define SPDK_BIT_ARRAY_WORD_INDEX_SHIFT	spdk_u32log2(SPDK_BIT_ARRAY_WORD_BITS)
 #define SPDK_BIT_ARRAY_WORD_INDEX_MASK	((1u << SPDK_BIT_ARRAY_WORD_INDEX_SHIFT) - 1)
+#define SPDK_BIT_ARRAY_WORD_FULL	SPDK_BIT_ARRAY_WORD_C(-1)
 
+/*
+ * Number of summary levels needed to reduce the maximum number of words (UINT32_MAX bits)
+ * down to a single summary word.
+ */
+#define SPDK_BIT_ARRAY_MAX_LEVELS	5
+
+/*
+ * Besides the bit words themselves, the array keeps a hierarchy of summary bitmaps that
+ * make find_first_clear logarithmic instead of linear.  Bit i of level 1 is set when
+ * words[i] is full (all ones), bit i of level N is set when word i of level N - 1 is full.
+ * The top level is always a single word.  Bits past the end of each summary level are
+ * kept set, so that they're never reported as having clear bits.  Summary words are
+ * stored in words[] right after the extra word (see spdk_bit_array_resize()).
+ */
 struct spdk_bit_array {
 	uint32_t bit_count;
+	uint32_t level_count;
+	uint32_t level_offset[SPDK_BIT_ARRAY_MAX_LEVELS];
 	spdk_bit_array_word words[];
 };
 
@@ -63,11 +80,147 @@ bit_array_word_mask(uint32_t num_bits)
 	return (SPDK_BIT_ARRAY_WORD_C(1) << num_bits) - 1;
 }
 
+static uint32_t
+bit_array_summary_word_count(uint32_t word_count, uint32_t *level_count)
+{
+	uint32_t count = 0, levels = 0;
+
+	while (word_count > 1) {
+		word_count = bit_array_word_count(word_count);
+		count += word_count;
+		levels++;
+	}
+
+	assert(levels <= SPDK_BIT_ARRAY_MAX_LEVELS);
+	if (level_count != NULL) {
+		*level_count = levels;
+	}
+
+	return count;
+}
+
+static void
+bit_array_summary_build(struct spdk_bit_array *ba)
+{
+	const spdk_bit_array_word *lower;
+	spdk_bit_array_word *summary;
+	uint32_t lower_count, count, level, i;
+
+	lower = ba->words;
+	lower_count = bit_array_word_count(ba->bit_count);
+
+	for (level = 0; level < ba->level_count; level++) {
+		summary = &ba->words[ba->level_offset[level]];
+		count = bit_array_word_count(lower_count);
+		memset(summary, 0, count * SPDK_BIT_ARRAY_WORD_BYTES);
+
+		for (i = 0; i < lower_count; i++) {
+			if (lower[i] == SPDK_BIT_ARRAY_WORD_FULL) {
+				summary[i >> SPDK_BIT_ARRAY_WORD_INDEX_SHIFT] |=
+					SPDK_BIT_ARRAY_WORD_C(1) << (i & SPDK_BIT_ARRAY_WORD_INDEX_MASK);
+			}
+		}
+
+		/* Mark the entries past the end of the lower level as full */
+		if (lower_count & SPDK_BIT_ARRAY_WORD_INDEX_MASK) {
+			summary[count - 1] |= ~bit_array_word_mask(lower_count & SPDK_BIT_ARRAY_WORD_INDEX_MASK);
+		}
+
+		lower = summary;
+		lower_count = count;
+	}
+}
+
+/* Called after words[word_index] became full */
+static inline void
+bit_array_summary_set(struct spdk_bit_array *ba, uint32_t word_index)
+{
+	spdk_bit_array_word *summary;
+	uint32_t level;
+
+	for (level = 0; level < ba->level_count; level++) {
+		summary = &ba->words[ba->level_offset[level] + (word_index >> SPDK_BIT_ARRAY_WORD_INDEX_SHIFT)];
+		*summary |= SPDK_BIT_ARRAY_WORD_C(1) << (word_index & SPDK_BIT_ARRAY_WORD_INDEX_MASK);
+		if (*summary != SPDK_BIT_ARRAY_WORD_FULL) {
+			break;
+		}
+
+		word_index >>= SPDK_BIT_ARRAY_WORD_INDEX_SHIFT;
+	}
+}
+
+/* Called after words[word_index] stopped being full */
+static inline void
+bit_array_summary_clear(struct spdk_bit_array *ba, uint32_t word_index)
+{
+	spdk_bit_array_word *summary, old;
+	uint32_t level;
+
+	for (level = 0; level < ba->level_count; level++) {
+		summary = &ba->words[ba->level_offset[level] + (word_index >> SPDK_BIT_ARRAY_WORD_INDEX_SHIFT)];
+		old = *summary;
+		*summary &= ~(SPDK_BIT_ARRAY_WORD_C(1) << (word_index & SPDK_BIT_ARRAY_WORD_INDEX_MASK));
+		if (old != SPDK_BIT_ARRAY_WORD_FULL) {
+			break;
+		}
+
+		word_index >>= SPDK_BIT_ARRAY_WORD_INDEX_SHIFT;
+	}
+}
+
+/*
+ * Find the index of the first word at or after word_index that is not full.  Returns a value
+ * greater than or equal to the word count if there's no such word.
+ */
+static uint32_t
+bit_array_summary_find_first_clear(const struct spdk_bit_array *ba, uint32_t word_index)
+{
+	const spdk_bit_array_word *summary;
+	spdk_bit_array_word word;
+	uint32_t level, count, index;
+
+	count = bit_array_word_count(ba->bit_count);
+	index = word_index;
+
+	/* Go up the hierarchy until a summary word with a clear bit at or after index is found */
+	for (level = 0; level < ba->level_count; level++) {
+		summary = &ba->words[ba->level_offset[level]];
+		count = bit_array_word_count(count);
+		if ((index >> SPDK_BIT_ARRAY_WORD_INDEX_SHIFT) >= count) {
+			return UINT32_MAX;
+		}
+
+		word = ~summary[index >> SPDK_BIT_ARRAY_WORD_INDEX_SHIFT] &
+		       ~bit_array_word_mask(index & SPDK_BIT_ARRAY_WORD_INDEX_MASK);
+		if (word != 0) {
+			index = (index & ~SPDK_BIT_ARRAY_WORD_INDEX_MASK) + SPDK_BIT_ARRAY_WORD_TZCNT(word);
+			break;
+		}
+
+		index = (index >> SPDK_BIT_ARRAY_WORD_INDEX_SHIFT) + 1;
+	}
+
+	if (level == ba->level_count) {
+		return UINT32_MAX;
+	}
+
+	/* ...and then back down, following the first clear bit on each level */
+	while (level-- > 0) {
+		summary = &ba->words[ba->level_offset[level]];
+		word = ~summary[index];
+		assert(word != 0);
+		index = (index << SPDK_BIT_ARRAY_WORD_INDEX_SHIFT) + SPDK_BIT_ARRAY_WORD_TZCNT(word);
+	}
+
+	return index;
+}
+
 int
 spdk_bit_array_resize(struct spdk_bit_array **bap, uint32_t num_bits)
 {
 	struct spdk_bit_array *new_ba;
-	uint32_t old_word_count, new_word_count;
+	uint32_t old_word_count, new_word_count, summary_word_count, level_count, level;
+	uint32_t offset, count;
 	size_t new_size;
 
 	/*
@@ -87,6 +240,10 @@ spdk_bit_array_resize(struct spdk_bit_array **bap, uint32_t num_bits)
 	 */
 	new_size += SPDK_BIT_ARRAY_WORD_BYTES;
 
+	/* The summary levels follow the extra word */
+	summary_word_count = bit_array_summary_word_count(new_word_count, &level_count);
+	new_size += summary_word_count * SPDK_BIT_ARRAY_WORD_BYTES;
+
 	new_ba = (struct spdk_bit_array *)spdk_realloc(*bap, new_size, 64);
 	if (!new_ba) {
 		return -ENOMEM;
@@ -112,17 +269,27 @@ spdk_bit_array_resize(struct spdk_bit_array **bap, uint32_t num_bits)
 		/* Zero out new entries */
 		memset(&new_ba->words[old_word_count], 0,
 		       (new_word_count - old_word_count) * SPDK_BIT_ARRAY_WORD_BYTES);
-	} else if (new_word_count == old_word_count && num_bits < new_ba->bit_count) {
+	} else if (num_bits < new_ba->bit_count && (num_bits & SPDK_BIT_ARRAY_WORD_INDEX_MASK)) {
 		/* Make sure any existing partial last word is cleared beyond the new num_bits. */
 		uint32_t last_word_bits;
 		spdk_bit_array_word mask;
 
 		last_word_bits = num_bits & SPDK_BIT_ARRAY_WORD_INDEX_MASK;
 		mask = bit_array_word_mask(last_word_bits);
-		new_ba->words[old_word_count - 1] &= mask;
+		new_ba->words[new_word_count - 1] &= mask;
 	}
 
 	new_ba->bit_count = num_bits;
+	new_ba->level_count = level_count;
+	offset = new_word_count + 1;
+	count = new_word_count;
+	for (level = 0; level < level_count; level++) {
+		count = bit_array_word_count(count);
+		new_ba->level_offset[level] = offset;
+		offset += count;
+	}
+	bit_array_summary_build(new_ba);
+
 	*bap = new_ba;
 	return 0;
 }
@@ -168,7 +335,15 @@ spdk_bit_array_set(struct spdk_bit_array *ba, uint32_t bit_index)
 		return -EINVAL;
 	}
 
+	if (ba->words[word_index] == SPDK_BIT_ARRAY_WORD_FULL) {
+		return 0;
+	}
+
 	ba->words[word_index] |= (SPDK_BIT_ARRAY_WORD_C(1) << word_bit_index);
+	if (ba->words[word_index] == SPDK_BIT_ARRAY_WORD_FULL) {
+		bit_array_summary_set(ba, word_index);
+	}
+
 	return 0;
 }
 
@@ -185,6 +360,10 @@ spdk_bit_array_clear(struct spdk_bit_array *ba, uint32_t bit_index)
 		return;
 	}
 
+	if (ba->words[word_index] == SPDK_BIT_ARRAY_WORD_FULL) {
+		bit_array_summary_clear(ba, word_index);
+	}
+
 	ba->words[word_index] &= ~(SPDK_BIT_ARRAY_WORD_C(1) << word_bit_index);
 }
 
@@ -246,9 +425,31 @@ spdk_bit_array_find_first_set(const struct spdk_bit_array *ba, uint32_t start_bi
 uint32_t
 spdk_bit_array_find_first_clear(const struct spdk_bit_array *ba, uint32_t start_bit_index)
 {
-	uint32_t bit_index;
+	uint32_t word_index, bit_index;
+	spdk_bit_array_word word;
+
+	if (spdk_unlikely(start_bit_index >= ba->bit_count)) {
+		return UINT32_MAX;
+	}
+
+	/*
+	 * Check the remainder of the first word directly and then use the summary levels to
+	 * skip over full words.  A partial last word is never full, so if there are no clear
+	 * bits in the array, this will end up pointing past bit_count.
+	 */
+	word_index = start_bit_index >> SPDK_BIT_ARRAY_WORD_INDEX_SHIFT;
+	word = ~ba->words[word_index] &
+	       ~bit_array_word_mask(start_bit_index & SPDK_BIT_ARRAY_WORD_INDEX_MASK);
+	if (word == 0) {
+		word_index = bit_array_summary_find_first_clear(ba, word_index + 1);
+		if (word_index >= bit_array_word_count(ba->bit_count)) {
+			return UINT32_MAX;
+		}
+
+		word = ~ba->words[word_index];
+	}
 
-	bit_index = bit_array_find_first(ba, start_bit_index, SPDK_BIT_ARRAY_WORD_C(-1));
+	bit_index = (word_index << SPDK_BIT_ARRAY_WORD_INDEX_SHIFT) + SPDK_BIT_ARRAY_WORD_TZCNT(word);
 
 	/*
 	 * If we ran off the end of the array and found the 0 bit in the extra word,
@@ -261,6 +462,82 @@ spdk_bit_array_find_first_clear(const struct spdk_bit_array *ba, uint32_t start_
 	return bit_index;
 }
 
+/*
+ * Return the index of the first set bit within [start_bit_index, start_bit_index + num_bits),
+ * or UINT32_MAX if all bits in that range are clear.  The range must be within the array.
+ */
+static uint32_t
+bit_array_range_find_first_set(const struct spdk_bit_array *ba, uint32_t start_bit_index,
+			       uint32_t num_bits)
+{
+	uint32_t word_index, end_word_index, end_bit_index;
+	spdk_bit_array_word word;
+
+	assert(num_bits > 0 && start_bit_index + num_bits <= ba->bit_count);
+
+	end_bit_index = start_bit_index + num_bits - 1;
+	word_index = start_bit_index >> SPDK_BIT_ARRAY_WORD_INDEX_SHIFT;
+	end_word_index = end_bit_index >> SPDK_BIT_ARRAY_WORD_INDEX_SHIFT;
+	word = ba->words[word_index] &
+	       ~bit_array_word_mask(start_bit_index & SPDK_BIT_ARRAY_WORD_INDEX_MASK);
+
+	while (true) {
+		if (word_index == end_word_index &&
+		    (end_bit_index & SPDK_BIT_ARRAY_WORD_INDEX_MASK) != SPDK_BIT_ARRAY_WORD_INDEX_MASK) {
+			word &= bit_array_word_mask((end_bit_index & SPDK_BIT_ARRAY_WORD_INDEX_MASK) + 1);
+		}
+
+		if (word != 0) {
+			return (word_index << SPDK_BIT_ARRAY_WORD_INDEX_SHIFT) + SPDK_BIT_ARRAY_WORD_TZCNT(word);
+		}
+
+		if (word_index == end_word_index) {
+			return UINT32_MAX;
+		}
+
+		word = ba->words[++word_index];
+	}
+}
+
+/* Set or clear all bits within [start_bit_index, start_bit_index + num_bits) */
+static void
+bit_array_range_update(struct spdk_bit_array *ba, uint32_t start_bit_index, uint32_t num_bits,
+		       bool set)
+{
+	uint32_t word_index, word_bit_index, count;
+	spdk_bit_array_word mask;
+
+	assert(start_bit_index + num_bits <= ba->bit_count);
+
+	while (num_bits > 0) {
+		word_index = start_bit_index >> SPDK_BIT_ARRAY_WORD_INDEX_SHIFT;
+		word_bit_index = start_bit_index & SPDK_BIT_ARRAY_WORD_INDEX_MASK;
+		count = spdk_min(num_bits, SPDK_BIT_ARRAY_WORD_BITS - word_bit_index);
+		if (count == SPDK_BIT_ARRAY_WORD_BITS) {
+			mask = SPDK_BIT_ARRAY_WORD_FULL;
+		} else {
+			mask = bit_array_word_mask(count) << word_bit_index;
+		}
+
+		if (set) {
+			if (ba->words[word_index] != SPDK_BIT_ARRAY_WORD_FULL) {
+				ba->words[word_index] |= mask;
+				if (ba->words[word_index] == SPDK_BIT_ARRAY_WORD_FULL) {
+					bit_array_summary_set(ba, word_index);
+				}
+			}
+		} else {
+			if (ba->words[word_index] == SPDK_BIT_ARRAY_WORD_FULL) {
+				bit_array_summary_clear(ba, word_index);
+			}
+			ba->words[word_index] &= ~mask;
+		}
+
+		start_bit_index += count;
+		num_bits -= count;
+	}
+}
+
 uint32_t
 spdk_bit_array_count_set(const struct spdk_bit_array *ba)
 {
@@ -319,6 +596,8 @@ spdk_bit_array_load_mask(struct spdk_bit_array *ba, const void *mask)
 			spdk_bit_array_clear(ba, i + size * CHAR_BIT);
 		}
 	}
+
+	bit_array_summary_build(ba);
 }
 
 void
@@ -333,6 +612,8 @@ spdk_bit_array_clear_mask(struct spdk_bit_array *ba)
 	for (i = 0; i < num_bits % CHAR_BIT; i++) {
 		spdk_bit_array_clear(ba, i + size * CHAR_BIT);
 	}
+
+	bit_array_summary_build(ba);
 }
 
 struct spdk_bit_pool {
@@ -480,6 +761,53 @@ spdk_bit_pool_free_bit(struct spdk_bit_pool *pool, uint32_t bit_index)
 	pool->free_count++;
 }
 
+uint32_t
+spdk_bit_pool_allocate_run(struct spdk_bit_pool *pool, uint32_t num_bits)
+{
+	uint32_t bit_index, set_bit_index, capacity;
+
+	capacity = spdk_bit_array_capacity(pool->array);
+	if (num_bits == 0 || num_bits > pool->free_count) {
+		return UINT32_MAX;
+	}
+
+	bit_index = pool->lowest_free_bit;
+	while (bit_index != UINT32_MAX && capacity - bit_index >= num_bits) {
+		set_bit_index = bit_array_range_find_first_set(pool->array, bit_index, num_bits);
+		if (set_bit_index == UINT32_MAX) {
+			bit_array_range_update(pool->array, bit_index, num_bits, true);
+			if (pool->lowest_free_bit == bit_index) {
+				pool->lowest_free_bit = spdk_bit_array_find_first_clear(pool->array,
+							bit_index + num_bits);
+			}
+			pool->free_count -= num_bits;
+			return bit_index;
+		}
+
+		/* Skip past the allocated bit, which also skips over any fully allocated words */
+		bit_index = spdk_bit_array_find_first_clear(pool->array, set_bit_index);
+	}
+
+	return UINT32_MAX;
+}
+
+void
+spdk_bit_pool_free_run(struct spdk_bit_pool *pool, uint32_t bit_index, uint32_t num_bits)
+{
+	if (num_bits == 0) {
+		return;
+	}
+
+	assert(spdk_bit_array_get(pool->array, bit_index) == true);
+	assert(spdk_bit_array_get(pool->array, bit_index + num_bits - 1) == true);
+
+	bit_array_range_update(pool->array, bit_index, num_bits, false);
+	if (pool->lowest_free_bit > bit_index) {
+		pool->lowest_free_bit = bit_index;
+	}
+	pool->free_count += num_bits;
+}
+
 uint32_t
 spdk_bit_pool_count_allocated(const struct spdk_bit_pool *pool)
 {
@@ -289,6 +289,33 @@ _dif_generate_guard(uint64_t guard_seed, void *buf, size_t buf_len,
 	return guard;
 }
 
+/* Maximum number of logical blocks whose guards are computed at once. */
+#define DIF_GUARD_BATCH	16
+
+/* Compute the guards of num_blocks contiguous logical blocks starting at buf. */
+static void
+dif_generate_guard_multi(uint8_t *buf, uint32_t num_blocks, uint64_t *guards,
+			 const struct spdk_dif_ctx *ctx)
+{
+	uint32_t crcs[DIF_GUARD_BATCH];
+	uint32_t i;
+
+	assert(num_blocks <= DIF_GUARD_BATCH);
+
+	if (ctx->dif_pi_format == SPDK_DIF_PI_FORMAT_32) {
+		spdk_crc32c_nvme_multi(buf, ctx->guard_interval, ctx->block_size, num_blocks,
+				       ctx->guard_seed, crcs);
+		for (i = 0; i < num_blocks; i++) {
+			guards[i] = crcs[i];
+		}
+	} else {
+		for (i = 0; i < num_blocks; i++) {
+			guards[i] = _dif_generate_guard(ctx->guard_seed, buf + i * ctx->block_size,
+							ctx->guard_interval, ctx->dif_pi_format);
+		}
+	}
+}
+
 static uint64_t
 dif_generate_guard_split(uint64_t guard_seed, struct _dif_sgl *sgl, uint32_t start,
 			 uint32_t len, const struct spdk_dif_ctx *ctx)
@@ -717,23 +744,38 @@ _dif_generate(void *_dif, uint64_t guard, uint32_t offset_blocks,
 	}
 }
 
+/*
+ * Each iovec holds a whole number of logical blocks, so process all blocks of an iovec
+ * in batches, computing the guards of a batch at once before storing its DIF fields.
+ */
 static void
 dif_generate(struct _dif_sgl *sgl, uint32_t num_blocks, const struct spdk_dif_ctx *ctx)
 {
-	uint32_t offset_blocks;
+	uint32_t offset_blocks = 0, iov_blocks, batch, i;
+	uint32_t buf_len;
 	uint8_t *buf;
-	uint64_t guard = 0;
+	uint64_t guards[DIF_GUARD_BATCH] = {};
 
-	for (offset_blocks = 0; offset_blocks < num_blocks; offset_blocks++) {
-		_dif_sgl_get_buf(sgl, &buf, NULL);
+	while (offset_blocks < num_blocks) {
+		_dif_sgl_get_buf(sgl, &buf, &buf_len);
+		iov_blocks = spdk_min(buf_len / ctx->block_size, num_blocks - offset_blocks);
+		_dif_sgl_advance(sgl, iov_blocks * ctx->block_size);
 
-		if (ctx->dif_flags & SPDK_DIF_FLAGS_GUARD_CHECK) {
-			guard = _dif_generate_guard(ctx->guard_seed, buf, ctx->guard_interval, ctx->dif_pi_format);
-		}
+		while (iov_blocks > 0) {
+			batch = spdk_min(iov_blocks, DIF_GUARD_BATCH);
 
-		_dif_generate(buf + ctx->guard_interval, guard, offset_blocks, ctx);
+			if (ctx->dif_flags & SPDK_DIF_FLAGS_GUARD_CHECK) {
+				dif_generate_guard_multi(buf, batch, guards, ctx);
+			}
 
-		_dif_sgl_advance(sgl, ctx->block_size);
+			for (i = 0; i < batch; i++) {
+				_dif_generate(buf + ctx->guard_interval, guards[i], offset_blocks, ctx);
+				buf += ctx->block_size;
+				offset_blocks++;
+			}
+
+			iov_blocks -= batch;
+		}
 	}
 }
 
@@ -948,28 +990,40 @@ _dif_verify(void *_dif, uint64_t guard, uint32_t offset_blocks,
 	return 0;
 }
 
+/* Same batching as dif_generate(). */
 static int
 dif_verify(struct _dif_sgl *sgl, uint32_t num_blocks,
 	   const struct spdk_dif_ctx *ctx, struct spdk_dif_error *err_blk)
 {
-	uint32_t offset_blocks;
+	uint32_t offset_blocks = 0, iov_blocks, batch, i;
+	uint32_t buf_len;
 	int rc;
 	uint8_t *buf;
-	uint64_t guard = 0;
+	uint64_t guards[DIF_GUARD_BATCH] = {};
 
-	for (offset_blocks = 0; offset_blocks < num_blocks; offset_blocks++) {
-		_dif_sgl_get_buf(sgl, &buf, NULL);
+	while (offset_blocks < num_blocks) {
+		_dif_sgl_get_buf(sgl, &buf, &buf_len);
+		iov_blocks = spdk_min(buf_len / ctx->block_size, num_blocks - offset_blocks);
+		_dif_sgl_advance(sgl, iov_blocks * ctx->block_size);
 
-		if (ctx->dif_flags & SPDK_DIF_FLAGS_GUARD_CHECK) {
-			guard = _dif_generate_guard(ctx->guard_seed, buf, ctx->guard_interval, ctx->dif_pi_format);
-		}
+		while (iov_blocks > 0) {
+			batch = spdk_min(iov_blocks, DIF_GUARD_BATCH);
 
-		rc = _dif_verify(buf + ctx->guard_interval, guard, offset_blocks, ctx, err_blk);
-		if (rc != 0) {
-			return rc;
-		}
+			if (ctx->dif_flags & SPDK_DIF_FLAGS_GUARD_CHECK) {
+				dif_generate_guard_multi(buf, batch, guards, ctx);
+			}
 
-		_dif_sgl_advance(sgl, ctx->block_size);
+			for (i = 0; i < batch; i++) {
+				rc = _dif_verify(buf + ctx->guard_interval, guards[i], offset_blocks, ctx, err_blk);
+				if (rc != 0) {
+					return rc;
+				}
+				buf += ctx->block_size;
+				offset_blocks++;
+			}
+
+			iov_blocks -= batch;
+		}
 	}
 
 	return 0;
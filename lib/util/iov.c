@@ -19,6 +19,27 @@ spdk_iov_memset(struct iovec *iovs, int iovcnt, int c)
 	}
 }
 
+int
+spdk_iov_slice(struct iovec *iovs, int iovcnt, uint64_t offset, uint64_t len, struct iovec *out)
+{
+	int i, n = 0;
+
+	for (i = 0; i < iovcnt && len > 0; i++) {
+		if (offset >= iovs[i].iov_len) {
+			offset -= iovs[i].iov_len;
+			continue;
+		}
+
+		out[n].iov_base = (uint8_t *)iovs[i].iov_base + offset;
+		out[n].iov_len = spdk_min(iovs[i].iov_len - offset, len);
+		len -= out[n].iov_len;
+		offset = 0;
+		n++;
+	}
+
+	return n;
+}
+
 size_t
 spdk_ioviter_first(struct spdk_ioviter *iter,
 		   struct iovec *siov, size_t siovcnt,
@@ -0,0 +1,422 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/pq.h"
+#include "spdk/config.h"
+#include "spdk/assert.h"
+#include "spdk/util.h"
+
+/* GF(2^8) generator polynomial x^8 + x^4 + x^3 + x^2 + 1 */
+#define PQ_GF_POLY	0x11d
+
+#define PQ_MAX_BUFS	(SPDK_PQ_MAX_DATA + 2)
+
+static uint8_t g_gf_exp[512];
+static uint8_t g_gf_log[256];
+
+__attribute__((constructor)) static void
+pq_init_gf_tables(void)
+{
+	uint32_t x = 1;
+	uint32_t i;
+
+	for (i = 0; i < 255; i++) {
+		g_gf_exp[i] = x;
+		g_gf_log[x] = i;
+		x <<= 1;
+		if (x & 0x100) {
+			x ^= PQ_GF_POLY;
+		}
+	}
+
+	/* Duplicate the table so that gf_mul() doesn't need a modulo */
+	for (i = 255; i < SPDK_COUNTOF(g_gf_exp); i++) {
+		g_gf_exp[i] = g_gf_exp[i - 255];
+	}
+}
+
+static inline uint8_t
+gf_mul(uint8_t a, uint8_t b)
+{
+	if (a == 0 || b == 0) {
+		return 0;
+	}
+
+	return g_gf_exp[g_gf_log[a] + g_gf_log[b]];
+}
+
+static inline uint8_t
+gf_inv(uint8_t a)
+{
+	assert(a != 0);
+
+	return g_gf_exp[255 - g_gf_log[a]];
+}
+
+/* g^i for generator g = 2 */
+static inline uint8_t
+gf_gen_pow(uint32_t i)
+{
+	return g_gf_exp[i % 255];
+}
+
+static inline bool
+is_aligned(void *ptr, size_t alignment)
+{
+	uintptr_t p = (uintptr_t)ptr;
+
+	return p == SPDK_ALIGN_FLOOR(p, alignment);
+}
+
+static bool
+buffers_aligned(void **buffers, uint32_t n, size_t alignment)
+{
+	uint32_t i;
+
+	for (i = 0; i < n; i++) {
+		if (!is_aligned(buffers[i], alignment)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Multiply each byte of a 64-bit word by g = 2 in GF(2^8) */
+static inline uint64_t
+gf_mul2_u64(uint64_t v)
+{
+	uint64_t mask = v & 0x8080808080808080ULL;
+
+	mask = (mask << 1) - (mask >> 7);
+
+	return ((v << 1) & 0xfefefefefefefefeULL) ^ (mask & 0x1d1d1d1d1d1d1d1dULL);
+}
+
+static inline uint8_t
+gf_mul2_u8(uint8_t v)
+{
+	return (v << 1) ^ ((v & 0x80) ? (PQ_GF_POLY & 0xff) : 0);
+}
+
+static void
+pq_gen_unaligned(void **buffers, uint32_t n, uint32_t off, uint32_t len)
+{
+	uint8_t *p = (uint8_t *)buffers[n] + off;
+	uint8_t *q = (uint8_t *)buffers[n + 1] + off;
+	uint32_t i;
+	int j;
+
+	for (i = 0; i < len; i++) {
+		uint8_t pb, qb;
+
+		pb = qb = ((uint8_t *)buffers[n - 1])[off + i];
+		for (j = n - 2; j >= 0; j--) {
+			uint8_t d = ((uint8_t *)buffers[j])[off + i];
+
+			pb ^= d;
+			qb = gf_mul2_u8(qb) ^ d;
+		}
+		p[i] = pb;
+		q[i] = qb;
+	}
+}
+
+/*
+ * Compute P and Q using Horner's scheme, Q = ((D_(n-1) * g + D_(n-2)) * g + ...) * g + D_0,
+ * which only requires multiplications by g that can be done on whole 64-bit words.
+ */
+static void
+pq_gen_basic(void **buffers, uint32_t n, uint32_t len)
+{
+	uint32_t len_div, len_rem;
+	uint32_t i;
+	int j;
+
+	if (!buffers_aligned(buffers, n + 2, sizeof(uint64_t))) {
+		pq_gen_unaligned(buffers, n, 0, len);
+		return;
+	}
+
+	len_div = len / sizeof(uint64_t);
+	len_rem = len_div * sizeof(uint64_t);
+
+	for (i = 0; i < len_div; i++) {
+		uint64_t p, q;
+
+		p = q = ((uint64_t *)buffers[n - 1])[i];
+		for (j = n - 2; j >= 0; j--) {
+			uint64_t d = ((uint64_t *)buffers[j])[i];
+
+			p ^= d;
+			q = gf_mul2_u64(q) ^ d;
+		}
+		((uint64_t *)buffers[n])[i] = p;
+		((uint64_t *)buffers[n + 1])[i] = q;
+	}
+
+	if (len_rem < len) {
+		pq_gen_unaligned(buffers, n, len_rem, len - len_rem);
+	}
+}
+
+#ifdef SPDK_CONFIG_ISAL
+#include "spdk/isa-l.h"
+
+#define SPDK_PQ_BUF_ALIGN 32
+
+static int
+do_pq_gen(void **buffers, uint32_t n, uint32_t len)
+{
+	if (buffers_aligned(buffers, n + 2, SPDK_PQ_BUF_ALIGN) && len % SPDK_PQ_BUF_ALIGN == 0) {
+		if (pq_gen(n + 2, len, buffers)) {
+			return -EINVAL;
+		}
+	} else {
+		pq_gen_basic(buffers, n, len);
+	}
+
+	return 0;
+}
+
+static void
+do_pq_encode(uint8_t **srcs, uint32_t k, uint8_t **outs, uint32_t rows, uint8_t *coefs,
+	     uint32_t len)
+{
+	uint8_t gftbls[32 * PQ_MAX_BUFS * SPDK_PQ_MAX_FAILED];
+
+	ec_init_tables(k, rows, coefs, gftbls);
+	ec_encode_data(len, k, rows, gftbls, srcs, outs);
+}
+
+#else
+
+#define SPDK_PQ_BUF_ALIGN sizeof(uint64_t)
+
+static void
+pq_xor_into(uint8_t *dst, const uint8_t *src, uint32_t len)
+{
+	uint32_t i = 0;
+
+	if (is_aligned(dst, sizeof(uint64_t)) && is_aligned((void *)src, sizeof(uint64_t))) {
+		for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+			*(uint64_t *)(dst + i) ^= *(const uint64_t *)(src + i);
+		}
+	}
+
+	for (; i < len; i++) {
+		dst[i] ^= src[i];
+	}
+}
+
+static void
+pq_mul_into(uint8_t *dst, const uint8_t *src, uint8_t coef, uint32_t len, bool accumulate)
+{
+	uint8_t tbl[256];
+	uint32_t i;
+
+	if (coef == 1) {
+		if (accumulate) {
+			pq_xor_into(dst, src, len);
+		} else if (dst != src) {
+			memcpy(dst, src, len);
+		}
+		return;
+	}
+
+	for (i = 0; i < SPDK_COUNTOF(tbl); i++) {
+		tbl[i] = gf_mul(coef, i);
+	}
+
+	if (accumulate) {
+		for (i = 0; i < len; i++) {
+			dst[i] ^= tbl[src[i]];
+		}
+	} else {
+		for (i = 0; i < len; i++) {
+			dst[i] = tbl[src[i]];
+		}
+	}
+}
+
+static void
+pq_encode_basic(uint8_t **srcs, uint32_t k, uint8_t **outs, uint32_t rows,
+		const uint8_t *coefs, uint32_t len)
+{
+	uint32_t r, i;
+
+	for (r = 0; r < rows; r++) {
+		for (i = 0; i < k; i++) {
+			pq_mul_into(outs[r], srcs[i], coefs[r * k + i], len, i > 0);
+		}
+	}
+}
+
+static inline int
+do_pq_gen(void **buffers, uint32_t n, uint32_t len)
+{
+	pq_gen_basic(buffers, n, len);
+	return 0;
+}
+
+static inline void
+do_pq_encode(uint8_t **srcs, uint32_t k, uint8_t **outs, uint32_t rows, uint8_t *coefs,
+	     uint32_t len)
+{
+	pq_encode_basic(srcs, k, outs, rows, coefs, len);
+}
+
+#endif
+
+int
+spdk_pq_gen(void **buffers, uint32_t n, uint32_t len)
+{
+	if (n < 2 || n > SPDK_PQ_MAX_DATA) {
+		return -EINVAL;
+	}
+
+	return do_pq_gen(buffers, n, len);
+}
+
+/*
+ * Compute the coefficients expressing buffer f as a linear combination of the buffers
+ * that have not failed. coefs has an entry for each of the n + 2 buffers, entries of
+ * failed buffers are left zero.
+ */
+static void
+pq_recover_coefs(uint32_t n, uint32_t f, const uint32_t *failed, uint32_t nfailed,
+		 uint8_t *coefs)
+{
+	uint32_t p = n, q = n + 1;
+	uint32_t other = UINT32_MAX;
+	uint8_t c;
+	uint32_t i;
+
+	if (nfailed == SPDK_PQ_MAX_FAILED) {
+		other = failed[0] == f ? failed[1] : failed[0];
+	}
+
+	if (f == p && other != q && other != UINT32_MAX) {
+		/* P and data buffer "other" lost, P = D_other + sum(D_i), D_other from Q */
+		c = gf_inv(gf_gen_pow(other));
+		for (i = 0; i < n; i++) {
+			if (i != other) {
+				coefs[i] = 1 ^ gf_mul(gf_gen_pow(i), c);
+			}
+		}
+		coefs[q] = c;
+	} else if (f == p) {
+		/* P = sum(D_i) */
+		for (i = 0; i < n; i++) {
+			coefs[i] = 1;
+		}
+	} else if (f == q && other != p && other != UINT32_MAX) {
+		/* Q and data buffer "other" lost, Q = g^other * D_other + sum(g^i * D_i), D_other from P */
+		for (i = 0; i < n; i++) {
+			if (i != other) {
+				coefs[i] = gf_gen_pow(i) ^ gf_gen_pow(other);
+			}
+		}
+		coefs[p] = gf_gen_pow(other);
+	} else if (f == q) {
+		/* Q = sum(g^i * D_i) */
+		for (i = 0; i < n; i++) {
+			coefs[i] = gf_gen_pow(i);
+		}
+	} else if (other == UINT32_MAX || other == q) {
+		/* D_f = P + sum(D_i) */
+		for (i = 0; i < n; i++) {
+			if (i != f) {
+				coefs[i] = 1;
+			}
+		}
+		coefs[p] = 1;
+	} else if (other == p) {
+		/* D_f = g^-f * (Q + sum(g^i * D_i)) */
+		c = gf_inv(gf_gen_pow(f));
+		for (i = 0; i < n; i++) {
+			if (i != f) {
+				coefs[i] = gf_mul(gf_gen_pow(i), c);
+			}
+		}
+		coefs[q] = c;
+	} else {
+		/*
+		 * Two data buffers lost. With Pxy = P + sum(D_i) = D_f + D_o and
+		 * Qxy = Q + sum(g^i * D_i) = g^f * D_f + g^o * D_o:
+		 * D_f = (Qxy + g^o * Pxy) / (g^f + g^o)
+		 */
+		c = gf_inv(gf_gen_pow(f) ^ gf_gen_pow(other));
+		for (i = 0; i < n; i++) {
+			if (i != f && i != other) {
+				coefs[i] = gf_mul(c, gf_gen_pow(i) ^ gf_gen_pow(other));
+			}
+		}
+		coefs[p] = gf_mul(c, gf_gen_pow(other));
+		coefs[q] = c;
+	}
+}
+
+int
+spdk_pq_recover(void **buffers, uint32_t n, uint32_t len, const uint32_t *failed,
+		uint32_t nfailed)
+{
+	uint8_t coefs[SPDK_PQ_MAX_FAILED][PQ_MAX_BUFS] = {};
+	uint8_t enc_coefs[SPDK_PQ_MAX_FAILED * PQ_MAX_BUFS];
+	uint8_t *srcs[PQ_MAX_BUFS];
+	uint8_t *outs[SPDK_PQ_MAX_FAILED];
+	uint32_t i, r, k;
+
+	if (n < 2 || n > SPDK_PQ_MAX_DATA || nfailed == 0 || nfailed > SPDK_PQ_MAX_FAILED) {
+		return -EINVAL;
+	}
+
+	for (r = 0; r < nfailed; r++) {
+		if (failed[r] >= n + 2 || (r > 0 && failed[r] == failed[0])) {
+			return -EINVAL;
+		}
+	}
+
+	if (nfailed == SPDK_PQ_MAX_FAILED && failed[0] >= n && failed[1] >= n) {
+		/* Both parities lost, just regenerate them */
+		return do_pq_gen(buffers, n, len);
+	}
+
+	for (r = 0; r < nfailed; r++) {
+		pq_recover_coefs(n, failed[r], failed, nfailed, coefs[r]);
+		outs[r] = buffers[failed[r]];
+	}
+
+	/* Only pass the sources that are actually used by any of the outputs */
+	k = 0;
+	for (i = 0; i < n + 2; i++) {
+		if (coefs[0][i] == 0 && (nfailed == 1 || coefs[1][i] == 0)) {
+			continue;
+		}
+		for (r = 0; r < nfailed; r++) {
+			enc_coefs[r * PQ_MAX_BUFS + k] = coefs[r][i];
+		}
+		srcs[k++] = buffers[i];
+	}
+
+	/* Pack the coefficient matrix rows to the actual number of sources */
+	for (r = 1; r < nfailed; r++) {
+		memmove(&enc_coefs[r * k], &enc_coefs[r * PQ_MAX_BUFS], k);
+	}
+
+	do_pq_encode(srcs, k, outs, nfailed, enc_coefs, len);
+
+	return 0;
+}
+
+size_t
+spdk_pq_get_optimal_alignment(void)
+{
+	return SPDK_PQ_BUF_ALIGN;
+}
+
+SPDK_STATIC_ASSERT(SPDK_PQ_BUF_ALIGN > 0 && !(SPDK_PQ_BUF_ALIGN & (SPDK_PQ_BUF_ALIGN - 1)),
+		   "Must be power of 2");
+SPDK_STATIC_ASSERT(PQ_MAX_BUFS <= 255, "Too many buffers for GF(2^8)");
@@ -371,11 +371,11 @@ static void
 check_session_vq_io_stats(struct spdk_vhost_session *vsession,
 			  struct spdk_vhost_virtqueue *virtqueue, uint64_t now)
 {
-	if (now < vsession->next_stats_check_time) {
+	if (now < virtqueue->next_stats_check_time) {
 		return;
 	}
 
-	vsession->next_stats_check_time = now + vsession->stats_check_interval;
+	virtqueue->next_stats_check_time = now + vsession->stats_check_interval;
 	session_vq_io_stats_update(vsession, virtqueue, now);
 }
 
@@ -950,7 +950,6 @@ new_connection(int vid)
 
 	vsession->started = false;
 	vsession->starting = false;
-	vsession->next_stats_check_time = 0;
 	vsession->stats_check_interval = SPDK_VHOST_STATS_CHECK_INTERVAL_MS *
 					 spdk_get_ticks_hz() / 1000UL;
 	TAILQ_INSERT_TAIL(&user_dev->vsessions, vsession, tailq);
@@ -14,6 +14,7 @@
 #include "spdk/util.h"
 #include "spdk/vhost.h"
 #include "spdk/json.h"
+#include "spdk_internal/rpc_autogen.h"
 
 #include "vhost_internal.h"
 #include <rte_version.h>
@@ -37,10 +38,13 @@
 
 #define VIRTIO_BLK_DEFAULT_TRANSPORT "vhost_user_blk"
 
+#define VHOST_BLK_MAX_QUEUE_THREADS 64
+
 struct spdk_vhost_user_blk_task {
 	struct spdk_vhost_blk_task blk_task;
 	struct spdk_vhost_blk_session *bvsession;
 	struct spdk_vhost_virtqueue *vq;
+	struct vhost_blk_queue_group *group;
 
 	uint16_t req_idx;
 	uint16_t num_descs;
@@ -58,15 +62,46 @@ struct spdk_vhost_blk_dev {
 	const struct spdk_virtio_blk_transport_ops *ops;
 
 	bool readonly;
+
+	/* Threads polling the virtqueues. The first one is always vdev.thread, so
+	 * queue_threads[0] is left unused.
+	 */
+	struct spdk_thread *queue_threads[VHOST_BLK_MAX_QUEUE_THREADS];
+	uint32_t num_queue_threads;
+	/* Index of the queue thread polling each virtqueue */
+	uint8_t vq_thread[SPDK_VHOST_MAX_VQUEUES];
+	/* Number of leading entries of vq_thread set explicitly by the user */
+	uint32_t queue_thread_map_len;
+
+	/* Hot remove waits for all queue threads to stop using the bdev */
+	int remove_pending;
+	struct spdk_thread *remove_thread;
+	bdev_event_cb_complete remove_cb;
+	void *remove_cb_arg;
 };
 
+/* Virtqueues of a session polled by one of the device's queue threads */
+struct vhost_blk_queue_group {
+	struct spdk_vhost_blk_session *bvsession;
+	struct spdk_thread *thread;
+	struct spdk_poller *requestq_poller;
+	struct spdk_io_channel *io_channel;
+	struct spdk_poller *stop_poller;
+	/* Group 0 counts its tasks in the session so they are reported with it */
+	int *task_cnt;
+	int remote_task_cnt;
+	uint8_t idx;
+	bool active;
+} __attribute((aligned(SPDK_CACHE_LINE_SIZE)));
+
 struct spdk_vhost_blk_session {
 	/* The parent session must be the very first field in this struct */
 	struct spdk_vhost_session vsession;
 	struct spdk_vhost_blk_dev *bvdev;
-	struct spdk_poller *requestq_poller;
-	struct spdk_io_channel *io_channel;
 	struct spdk_poller *stop_poller;
+	/* Remote groups that have not released their channel yet */
+	uint32_t groups_stopping;
+	struct vhost_blk_queue_group groups[VHOST_BLK_MAX_QUEUE_THREADS];
 };
 
 /* forward declaration */
@@ -81,7 +116,7 @@ vhost_user_process_blk_request(struct spdk_vhost_user_blk_task *user_task)
 	struct spdk_vhost_blk_session *bvsession = user_task->bvsession;
 	struct spdk_vhost_dev *vdev = &bvsession->bvdev->vdev;
 
-	return virtio_blk_process_request(vdev, bvsession->io_channel, &user_task->blk_task,
+	return virtio_blk_process_request(vdev, user_task->group->io_channel, &user_task->blk_task,
 					  vhost_user_blk_request_finish, NULL);
 }
 
@@ -117,17 +152,31 @@ to_blk_session(struct spdk_vhost_session *vsession)
 	return (struct spdk_vhost_blk_session *)vsession;
 }
 
+static inline struct spdk_thread *
+vhost_blk_queue_thread(struct spdk_vhost_blk_dev *bvdev, uint32_t idx)
+{
+	return idx == 0 ? bvdev->vdev.thread : bvdev->queue_threads[idx];
+}
+
+static inline struct vhost_blk_queue_group *
+vhost_blk_vq_group(struct spdk_vhost_blk_session *bvsession, struct spdk_vhost_virtqueue *vq)
+{
+	struct spdk_vhost_blk_dev *bvdev = to_blk_dev(bvsession->vsession.vdev);
+
+	return &bvsession->groups[bvdev->vq_thread[vq->vring_idx]];
+}
+
 static inline void
 blk_task_inc_task_cnt(struct spdk_vhost_user_blk_task *task)
 {
-	task->bvsession->vsession.task_cnt++;
+	(*task->group->task_cnt)++;
 }
 
 static inline void
 blk_task_dec_task_cnt(struct spdk_vhost_user_blk_task *task)
 {
-	assert(task->bvsession->vsession.task_cnt > 0);
-	task->bvsession->vsession.task_cnt--;
+	assert(*task->group->task_cnt > 0);
+	(*task->group->task_cnt)--;
 }
 
 static void
@@ -943,12 +992,16 @@ vdev_vq_worker(void *arg)
 static int
 vdev_worker(void *arg)
 {
-	struct spdk_vhost_blk_session *bvsession = arg;
+	struct vhost_blk_queue_group *group = arg;
+	struct spdk_vhost_blk_session *bvsession = group->bvsession;
 	struct spdk_vhost_session *vsession = &bvsession->vsession;
 	uint16_t q_idx;
 	int rc = 0;
 
 	for (q_idx = 0; q_idx < vsession->max_queues; q_idx++) {
+		if (bvsession->bvdev->vq_thread[q_idx] != group->idx) {
+			continue;
+		}
 		rc += _vdev_vq_worker(&vsession->virtqueue[q_idx]);
 	}
 
@@ -1024,6 +1077,7 @@ _no_bdev_vdev_vq_worker(struct spdk_vhost_virtqueue *vq)
 {
 	struct spdk_vhost_session *vsession = vq->vsession;
 	struct spdk_vhost_blk_session *bvsession = to_blk_session(vsession);
+	struct vhost_blk_queue_group *group = vhost_blk_vq_group(bvsession, vq);
 	bool packed_ring;
 
 	packed_ring = vq->packed.packed_ring;
@@ -1035,9 +1089,9 @@ _no_bdev_vdev_vq_worker(struct spdk_vhost_virtqueue *vq)
 
 	vhost_session_vq_used_signal(vq);
 
-	if (vsession->task_cnt == 0 && bvsession->io_channel) {
-		vhost_blk_put_io_channel(bvsession->io_channel);
-		bvsession->io_channel = NULL;
+	if (*group->task_cnt == 0 && group->io_channel) {
+		vhost_blk_put_io_channel(group->io_channel);
+		group->io_channel = NULL;
 	}
 
 	return SPDK_POLLER_BUSY;
@@ -1054,11 +1108,15 @@ no_bdev_vdev_vq_worker(void *arg)
 static int
 no_bdev_vdev_worker(void *arg)
 {
-	struct spdk_vhost_blk_session *bvsession = arg;
+	struct vhost_blk_queue_group *group = arg;
+	struct spdk_vhost_blk_session *bvsession = group->bvsession;
 	struct spdk_vhost_session *vsession = &bvsession->vsession;
 	uint16_t q_idx;
 
 	for (q_idx = 0; q_idx < vsession->max_queues; q_idx++) {
+		if (bvsession->bvdev->vq_thread[q_idx] != group->idx) {
+			continue;
+		}
 		_no_bdev_vdev_vq_worker(&vsession->virtqueue[q_idx]);
 	}
 
@@ -1066,8 +1124,9 @@ no_bdev_vdev_worker(void *arg)
 }
 
 static void
-vhost_blk_session_unregister_interrupts(struct spdk_vhost_blk_session *bvsession)
+vhost_blk_group_unregister_interrupts(struct vhost_blk_queue_group *group)
 {
+	struct spdk_vhost_blk_session *bvsession = group->bvsession;
 	struct spdk_vhost_session *vsession = &bvsession->vsession;
 	struct spdk_vhost_virtqueue *vq;
 	int i;
@@ -1075,8 +1134,8 @@ vhost_blk_session_unregister_interrupts(struct spdk_vhost_blk_session *bvsession
 	SPDK_DEBUGLOG(vhost_blk, "unregister virtqueues interrupt\n");
 	for (i = 0; i < vsession->max_queues; i++) {
 		vq = &vsession->virtqueue[i];
-		if (vq->intr == NULL) {
-			break;
+		if (bvsession->bvdev->vq_thread[i] != group->idx || vq->intr == NULL) {
+			continue;
 		}
 
 		SPDK_DEBUGLOG(vhost_blk, "unregister vq[%d]'s kickfd is %d\n",
@@ -1110,22 +1169,31 @@ _vhost_blk_vq_register_interrupt(void *arg)
 static int
 vhost_blk_vq_enable(struct spdk_vhost_session *vsession, struct spdk_vhost_virtqueue *vq)
 {
+	struct spdk_vhost_blk_dev *bvdev = to_blk_dev(vsession->vdev);
+
+	assert(bvdev != NULL);
+
 	if (spdk_interrupt_mode_is_enabled()) {
-		spdk_thread_send_msg(vsession->vdev->thread, _vhost_blk_vq_register_interrupt, vq);
+		spdk_thread_send_msg(vhost_blk_queue_thread(bvdev, bvdev->vq_thread[vq->vring_idx]),
+				     _vhost_blk_vq_register_interrupt, vq);
 	}
 
 	return 0;
 }
 
 static int
-vhost_blk_session_register_no_bdev_interrupts(struct spdk_vhost_blk_session *bvsession)
+vhost_blk_group_register_no_bdev_interrupts(struct vhost_blk_queue_group *group)
 {
+	struct spdk_vhost_blk_session *bvsession = group->bvsession;
 	struct spdk_vhost_session *vsession = &bvsession->vsession;
 	struct spdk_vhost_virtqueue *vq = NULL;
 	int i;
 
 	SPDK_DEBUGLOG(vhost_blk, "Register virtqueues interrupt\n");
 	for (i = 0; i < vsession->max_queues; i++) {
+		if (bvsession->bvdev->vq_thread[i] != group->idx) {
+			continue;
+		}
 		vq = &vsession->virtqueue[i];
 		SPDK_DEBUGLOG(vhost_blk, "Register vq[%d]'s kickfd is %d\n",
 			      i, vq->vring.kickfd);
@@ -1140,16 +1208,16 @@ vhost_blk_session_register_no_bdev_interrupts(struct spdk_vhost_blk_session *bvs
 	return 0;
 
 err:
-	vhost_blk_session_unregister_interrupts(bvsession);
+	vhost_blk_group_unregister_interrupts(group);
 	return -1;
 }
 
 static void
 vhost_blk_poller_set_interrupt_mode(struct spdk_poller *poller, void *cb_arg, bool interrupt_mode)
 {
-	struct spdk_vhost_blk_session *bvsession = cb_arg;
+	struct vhost_blk_queue_group *group = cb_arg;
 
-	vhost_user_session_set_interrupt_mode(&bvsession->vsession, interrupt_mode);
+	vhost_user_session_set_interrupt_mode(&group->bvsession->vsession, interrupt_mode);
 }
 
 static void
@@ -1191,41 +1259,107 @@ vhost_user_blk_resize_cb(struct spdk_vhost_dev *vdev, bdev_event_cb_complete cb,
 }
 
 static int
-vhost_user_session_bdev_remove_cb(struct spdk_vhost_dev *vdev,
-				  struct spdk_vhost_session *vsession,
-				  void *ctx)
+vhost_blk_group_bdev_remove(struct vhost_blk_queue_group *group)
 {
-	struct spdk_vhost_blk_session *bvsession;
+	struct spdk_vhost_session *vsession = &group->bvsession->vsession;
 	int rc;
 
-	bvsession = to_blk_session(vsession);
-	if (bvsession->requestq_poller) {
-		spdk_poller_unregister(&bvsession->requestq_poller);
+	if (group->requestq_poller) {
+		spdk_poller_unregister(&group->requestq_poller);
 		if (spdk_interrupt_mode_is_enabled()) {
-			vhost_blk_session_unregister_interrupts(bvsession);
-			rc = vhost_blk_session_register_no_bdev_interrupts(bvsession);
+			vhost_blk_group_unregister_interrupts(group);
+			rc = vhost_blk_group_register_no_bdev_interrupts(group);
 			if (rc) {
 				SPDK_ERRLOG("%s: Interrupt register failed\n", vsession->name);
 				return rc;
 			}
 		}
 
-		bvsession->requestq_poller = SPDK_POLLER_REGISTER(no_bdev_vdev_worker, bvsession, 0);
-		spdk_poller_register_interrupt(bvsession->requestq_poller, vhost_blk_poller_set_interrupt_mode,
-					       bvsession);
+		group->requestq_poller = SPDK_POLLER_REGISTER(no_bdev_vdev_worker, group, 0);
+		spdk_poller_register_interrupt(group->requestq_poller,
+					       vhost_blk_poller_set_interrupt_mode, group);
 	}
 
 	return 0;
 }
 
+static void
+_vhost_blk_bdev_remove_done(void *arg)
+{
+	struct spdk_vhost_blk_dev *bvdev = arg;
+
+	bvdev->remove_cb(&bvdev->vdev, bvdev->remove_cb_arg);
+}
+
+static void
+vhost_blk_bdev_remove_put(struct spdk_vhost_blk_dev *bvdev)
+{
+	if (__atomic_sub_fetch(&bvdev->remove_pending, 1, __ATOMIC_SEQ_CST) == 0) {
+		spdk_thread_send_msg(bvdev->remove_thread, _vhost_blk_bdev_remove_done, bvdev);
+	}
+}
+
+static void
+_vhost_blk_group_bdev_remove(void *arg)
+{
+	struct vhost_blk_queue_group *group = arg;
+
+	vhost_blk_group_bdev_remove(group);
+	vhost_blk_bdev_remove_put(group->bvsession->bvdev);
+}
+
+static int
+vhost_user_session_bdev_remove_cb(struct spdk_vhost_dev *vdev,
+				  struct spdk_vhost_session *vsession,
+				  void *ctx)
+{
+	struct spdk_vhost_blk_session *bvsession;
+	struct spdk_vhost_blk_dev *bvdev;
+	uint32_t i;
+
+	bvsession = to_blk_session(vsession);
+	bvdev = to_blk_dev(vdev);
+	if (bvsession->groups[0].requestq_poller == NULL) {
+		return 0;
+	}
+
+	/* Messages to the other queue threads are queued ahead of any stop request,
+	 * so the groups are guaranteed to be still running when they process them.
+	 */
+	for (i = 1; i < bvdev->num_queue_threads; i++) {
+		if (!bvsession->groups[i].active) {
+			continue;
+		}
+		__atomic_add_fetch(&bvdev->remove_pending, 1, __ATOMIC_SEQ_CST);
+		spdk_thread_send_msg(bvsession->groups[i].thread, _vhost_blk_group_bdev_remove,
+				     &bvsession->groups[i]);
+	}
+
+	return vhost_blk_group_bdev_remove(&bvsession->groups[0]);
+}
+
+static void
+vhost_user_bdev_remove_cpl(struct spdk_vhost_dev *vdev, void *ctx)
+{
+	vhost_blk_bdev_remove_put(to_blk_dev(vdev));
+}
+
 static void
 vhost_user_bdev_remove_cb(struct spdk_vhost_dev *vdev, bdev_event_cb_complete cb, void *cb_arg)
 {
+	struct spdk_vhost_blk_dev *bvdev = to_blk_dev(vdev);
+
 	SPDK_WARNLOG("%s: hot-removing bdev - all further requests will fail.\n",
 		     vdev->name);
 
+	/* The bdev can only be closed once every queue thread stopped submitting I/O */
+	bvdev->remove_thread = spdk_get_thread();
+	bvdev->remove_cb = cb;
+	bvdev->remove_cb_arg = cb_arg;
+	bvdev->remove_pending = 1;
+
 	vhost_user_dev_foreach_session(vdev, vhost_user_session_bdev_remove_cb,
-				       cb, cb_arg);
+				       vhost_user_bdev_remove_cpl, NULL);
 }
 
 static void
@@ -1291,11 +1425,14 @@ static int
 alloc_vq_task_pool(struct spdk_vhost_session *vsession, uint16_t qid)
 {
 	struct spdk_vhost_blk_session *bvsession = to_blk_session(vsession);
+	struct spdk_vhost_blk_dev *bvdev = to_blk_dev(vsession->vdev);
 	struct spdk_vhost_virtqueue *vq;
 	struct spdk_vhost_user_blk_task *task;
 	uint32_t task_cnt;
 	uint32_t j;
 
+	assert(bvdev != NULL);
+
 	if (qid >= SPDK_VHOST_MAX_VQUEUES) {
 		return -EINVAL;
 	}
@@ -1324,6 +1461,7 @@ alloc_vq_task_pool(struct spdk_vhost_session *vsession, uint16_t qid)
 	for (j = 0; j < task_cnt; j++) {
 		task = &((struct spdk_vhost_user_blk_task *)vq->tasks)[j];
 		task->bvsession = bvsession;
+		task->group = &bvsession->groups[bvdev->vq_thread[qid]];
 		task->req_idx = j;
 		task->vq = vq;
 	}
@@ -1331,16 +1469,55 @@ alloc_vq_task_pool(struct spdk_vhost_session *vsession, uint16_t qid)
 	return 0;
 }
 
+static int
+vhost_blk_group_start(struct vhost_blk_queue_group *group)
+{
+	struct spdk_vhost_blk_dev *bvdev = group->bvsession->bvdev;
+
+	if (bvdev->bdev) {
+		group->io_channel = vhost_blk_get_io_channel(&bvdev->vdev);
+		if (!group->io_channel) {
+			return -1;
+		}
+		group->requestq_poller = SPDK_POLLER_REGISTER(vdev_worker, group, 0);
+	} else {
+		group->requestq_poller = SPDK_POLLER_REGISTER(no_bdev_vdev_worker, group, 0);
+	}
+	SPDK_INFOLOG(vhost, "%s: started poller on lcore %d\n",
+		     group->bvsession->vsession.name, spdk_env_get_current_core());
+
+	spdk_poller_register_interrupt(group->requestq_poller, vhost_blk_poller_set_interrupt_mode,
+				       group);
+
+	return 0;
+}
+
+static void
+_vhost_blk_group_start(void *arg)
+{
+	struct vhost_blk_queue_group *group = arg;
+
+	if (vhost_blk_group_start(group) != 0) {
+		/* Keep the group's queues serviced, failing all of their requests */
+		SPDK_ERRLOG("%s: I/O channel allocation failed on thread %s\n",
+			    group->bvsession->vsession.name, spdk_thread_get_name(group->thread));
+		group->requestq_poller = SPDK_POLLER_REGISTER(no_bdev_vdev_worker, group, 0);
+		spdk_poller_register_interrupt(group->requestq_poller,
+					       vhost_blk_poller_set_interrupt_mode, group);
+	}
+}
+
 static int
 vhost_blk_start(struct spdk_vhost_dev *vdev,
 		struct spdk_vhost_session *vsession, void *unused)
 {
 	struct spdk_vhost_blk_session *bvsession = to_blk_session(vsession);
 	struct spdk_vhost_blk_dev *bvdev;
-	int i;
+	struct vhost_blk_queue_group *group;
+	uint32_t i;
 
 	/* return if start is already in progress */
-	if (bvsession->requestq_poller) {
+	if (bvsession->groups[0].requestq_poller) {
 		SPDK_INFOLOG(vhost, "%s: start in progress\n", vsession->name);
 		return -EINPROGRESS;
 	}
@@ -1360,43 +1537,92 @@ vhost_blk_start(struct spdk_vhost_dev *vdev,
 	assert(bvdev != NULL);
 	bvsession->bvdev = bvdev;
 
-	if (bvdev->bdev) {
-		bvsession->io_channel = vhost_blk_get_io_channel(vdev);
-		if (!bvsession->io_channel) {
-			free_task_pool(bvsession);
-			SPDK_ERRLOG("%s: I/O channel allocation failed\n", vsession->name);
-			return -1;
-		}
+	for (i = 0; i < bvdev->num_queue_threads; i++) {
+		group = &bvsession->groups[i];
+		group->bvsession = bvsession;
+		group->idx = i;
+		group->thread = vhost_blk_queue_thread(bvdev, i);
+		group->task_cnt = i == 0 ? &vsession->task_cnt : &group->remote_task_cnt;
+		/* Group 0 is always started, it is the one stopping the session */
+		group->active = i == 0;
+	}
+	for (i = 0; i < vsession->max_queues; i++) {
+		bvsession->groups[bvdev->vq_thread[i]].active = true;
 	}
 
-	if (bvdev->bdev) {
-		bvsession->requestq_poller = SPDK_POLLER_REGISTER(vdev_worker, bvsession, 0);
-	} else {
-		bvsession->requestq_poller = SPDK_POLLER_REGISTER(no_bdev_vdev_worker, bvsession, 0);
+	if (vhost_blk_group_start(&bvsession->groups[0]) != 0) {
+		free_task_pool(bvsession);
+		SPDK_ERRLOG("%s: I/O channel allocation failed\n", vsession->name);
+		return -1;
 	}
-	SPDK_INFOLOG(vhost, "%s: started poller on lcore %d\n",
-		     vsession->name, spdk_env_get_current_core());
 
-	spdk_poller_register_interrupt(bvsession->requestq_poller, vhost_blk_poller_set_interrupt_mode,
-				       bvsession);
+	for (i = 1; i < bvdev->num_queue_threads; i++) {
+		if (bvsession->groups[i].active) {
+			spdk_thread_send_msg(bvsession->groups[i].thread, _vhost_blk_group_start,
+					     &bvsession->groups[i]);
+		}
+	}
 
 	return 0;
 }
 
+static void
+_vhost_blk_group_stopped(void *arg)
+{
+	struct spdk_vhost_blk_session *bvsession = arg;
+
+	assert(bvsession->groups_stopping > 0);
+	bvsession->groups_stopping--;
+}
+
+static int
+vhost_blk_group_stop_poller_cb(void *arg)
+{
+	struct vhost_blk_queue_group *group = arg;
+
+	if (*group->task_cnt > 0) {
+		return SPDK_POLLER_BUSY;
+	}
+
+	if (group->io_channel) {
+		vhost_blk_put_io_channel(group->io_channel);
+		group->io_channel = NULL;
+	}
+
+	spdk_poller_unregister(&group->stop_poller);
+	spdk_thread_send_msg(group->bvsession->vsession.vdev->thread, _vhost_blk_group_stopped,
+			     group->bvsession);
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+_vhost_blk_group_stop(void *arg)
+{
+	struct vhost_blk_queue_group *group = arg;
+
+	spdk_poller_unregister(&group->requestq_poller);
+	vhost_blk_group_unregister_interrupts(group);
+
+	group->stop_poller = SPDK_POLLER_REGISTER(vhost_blk_group_stop_poller_cb, group,
+			     SPDK_VHOST_SESSION_STOP_RETRY_PERIOD_IN_US);
+}
+
 static int
 destroy_session_poller_cb(void *arg)
 {
 	struct spdk_vhost_blk_session *bvsession = arg;
 	struct spdk_vhost_session *vsession = &bvsession->vsession;
 	struct spdk_vhost_user_dev *user_dev = to_user_dev(vsession->vdev);
+	struct vhost_blk_queue_group *group = &bvsession->groups[0];
 	int i;
 
-	if (vsession->task_cnt > 0 || (pthread_mutex_trylock(&user_dev->lock) != 0)) {
+	if (vsession->task_cnt > 0 || bvsession->groups_stopping > 0 ||
+	    (pthread_mutex_trylock(&user_dev->lock) != 0)) {
 		assert(vsession->stop_retry_count > 0);
 		vsession->stop_retry_count--;
 		if (vsession->stop_retry_count == 0) {
-			SPDK_ERRLOG("%s: Timedout when destroy session (task_cnt %d)\n", vsession->name,
-				    vsession->task_cnt);
+			SPDK_ERRLOG("%s: Timedout when destroy session (task_cnt %d, groups %u)\n",
+				    vsession->name, vsession->task_cnt, bvsession->groups_stopping);
 			spdk_poller_unregister(&bvsession->stop_poller);
 			vhost_user_session_stop_done(vsession, -ETIMEDOUT);
 		}
@@ -1412,9 +1638,9 @@ destroy_session_poller_cb(void *arg)
 	SPDK_INFOLOG(vhost, "%s: stopping poller on lcore %d\n",
 		     vsession->name, spdk_env_get_current_core());
 
-	if (bvsession->io_channel) {
-		vhost_blk_put_io_channel(bvsession->io_channel);
-		bvsession->io_channel = NULL;
+	if (group->io_channel) {
+		vhost_blk_put_io_channel(group->io_channel);
+		group->io_channel = NULL;
 	}
 
 	free_task_pool(bvsession);
@@ -1430,14 +1656,26 @@ vhost_blk_stop(struct spdk_vhost_dev *vdev,
 	       struct spdk_vhost_session *vsession, void *unused)
 {
 	struct spdk_vhost_blk_session *bvsession = to_blk_session(vsession);
+	struct vhost_blk_queue_group *group;
+	uint32_t i;
 
 	/* return if stop is already in progress */
 	if (bvsession->stop_poller) {
 		return -EINPROGRESS;
 	}
 
-	spdk_poller_unregister(&bvsession->requestq_poller);
-	vhost_blk_session_unregister_interrupts(bvsession);
+	if (bvsession->groups[0].requestq_poller) {
+		for (i = 1; i < bvsession->bvdev->num_queue_threads; i++) {
+			group = &bvsession->groups[i];
+			if (group->active) {
+				bvsession->groups_stopping++;
+				spdk_thread_send_msg(group->thread, _vhost_blk_group_stop, group);
+			}
+		}
+	}
+
+	spdk_poller_unregister(&bvsession->groups[0].requestq_poller);
+	vhost_blk_group_unregister_interrupts(&bvsession->groups[0]);
 
 	bvsession->vsession.stop_retry_count = (SPDK_VHOST_SESSION_STOP_RETRY_TIMEOUT_IN_SEC * 1000 *
 						1000) / SPDK_VHOST_SESSION_STOP_RETRY_PERIOD_IN_US;
@@ -1465,6 +1703,7 @@ vhost_blk_dump_info_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_ctx
 		spdk_json_write_null(w);
 	}
 	spdk_json_write_named_string(w, "transport", bvdev->ops->name);
+	spdk_json_write_named_uint32(w, "num_queue_threads", bvdev->num_queue_threads);
 
 	spdk_json_write_object_end(w);
 }
@@ -1473,6 +1712,7 @@ static void
 vhost_blk_write_config_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_ctx *w)
 {
 	struct spdk_vhost_blk_dev *bvdev;
+	uint32_t i;
 
 	bvdev = to_blk_dev(vdev);
 	assert(bvdev != NULL);
@@ -1491,6 +1731,16 @@ vhost_blk_write_config_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_
 				     spdk_cpuset_fmt(spdk_thread_get_cpumask(vdev->thread)));
 	spdk_json_write_named_bool(w, "readonly", bvdev->readonly);
 	spdk_json_write_named_string(w, "transport", bvdev->ops->name);
+	if (bvdev->num_queue_threads > 1) {
+		spdk_json_write_named_uint32(w, "num_queue_threads", bvdev->num_queue_threads);
+	}
+	if (bvdev->queue_thread_map_len > 0) {
+		spdk_json_write_named_array_begin(w, "queue_thread_map");
+		for (i = 0; i < bvdev->queue_thread_map_len; i++) {
+			spdk_json_write_uint32(w, bvdev->vq_thread[i]);
+		}
+		spdk_json_write_array_end(w);
+	}
 	spdk_json_write_object_end(w);
 
 	spdk_json_write_object_end(w);
@@ -1665,6 +1915,7 @@ spdk_vhost_blk_construct(const char *name, const char *cpumask, const char *dev_
 
 	bvdev->bdev = bdev;
 	bvdev->readonly = false;
+	bvdev->num_queue_threads = 1;
 	ret = vhost_dev_register(vdev, name, cpumask, params, &vhost_blk_device_backend,
 				 &vhost_blk_user_device_backend, false);
 	if (ret != 0) {
@@ -1761,19 +2012,100 @@ vhost_user_blk_destroy(struct spdk_virtio_blk_transport *transport,
 struct rpc_vhost_blk {
 	bool readonly;
 	bool packed_ring;
+	uint32_t num_queue_threads;
+	struct rpc_vhost_blk_queue_thread_map queue_thread_map;
 };
 
 static const struct spdk_json_object_decoder rpc_construct_vhost_blk[] = {
 	{"readonly", offsetof(struct rpc_vhost_blk, readonly), spdk_json_decode_bool, true},
 	{"packed_ring", offsetof(struct rpc_vhost_blk, packed_ring), spdk_json_decode_bool, true},
+	{
+		"num_queue_threads", offsetof(struct rpc_vhost_blk, num_queue_threads),
+		spdk_json_decode_uint32, true
+	},
+	{
+		"queue_thread_map", offsetof(struct rpc_vhost_blk, queue_thread_map),
+		rpc_decode_vhost_blk_queue_thread_map, true
+	},
 };
 
+static void
+vhost_blk_queue_thread_exit(void *arg)
+{
+	spdk_thread_exit(spdk_get_thread());
+}
+
+static void
+vhost_blk_exit_queue_threads(struct spdk_vhost_blk_dev *bvdev)
+{
+	uint32_t i;
+
+	for (i = 1; i < bvdev->num_queue_threads; i++) {
+		spdk_thread_send_msg(bvdev->queue_threads[i], vhost_blk_queue_thread_exit, NULL);
+		bvdev->queue_threads[i] = NULL;
+	}
+	bvdev->num_queue_threads = 1;
+}
+
+static int
+vhost_blk_set_queue_threads(struct spdk_vhost_blk_dev *bvdev, struct spdk_cpuset *cpumask,
+			    const struct rpc_vhost_blk *req)
+{
+	char thread_name[32];
+	uint32_t num_threads = req->num_queue_threads;
+	size_t i;
+
+	if (num_threads == 0) {
+		/* Use as many threads as the map refers to */
+		num_threads = 1;
+		for (i = 0; i < req->queue_thread_map.count; i++) {
+			num_threads = spdk_max(num_threads, req->queue_thread_map.items[i] + 1);
+		}
+	}
+	if (num_threads > VHOST_BLK_MAX_QUEUE_THREADS) {
+		SPDK_ERRLOG("%s: at most %u queue threads are supported\n", bvdev->vdev.name,
+			    VHOST_BLK_MAX_QUEUE_THREADS);
+		return -EINVAL;
+	}
+
+	/* Queues without an explicit entry in the map are spread round-robin */
+	for (i = 0; i < SPDK_VHOST_MAX_VQUEUES; i++) {
+		if (i < req->queue_thread_map.count) {
+			if (req->queue_thread_map.items[i] >= num_threads) {
+				SPDK_ERRLOG("%s: queue %zu mapped to thread %u, only %u threads used\n",
+					    bvdev->vdev.name, i, req->queue_thread_map.items[i],
+					    num_threads);
+				return -EINVAL;
+			}
+			bvdev->vq_thread[i] = req->queue_thread_map.items[i];
+		} else {
+			bvdev->vq_thread[i] = i % num_threads;
+		}
+	}
+	bvdev->queue_thread_map_len = req->queue_thread_map.count;
+
+	bvdev->num_queue_threads = 1;
+	for (i = 1; i < num_threads; i++) {
+		snprintf(thread_name, sizeof(thread_name), "%s_q%zu", bvdev->vdev.name, i);
+		bvdev->queue_threads[i] = spdk_thread_create(thread_name, cpumask);
+		if (bvdev->queue_threads[i] == NULL) {
+			SPDK_ERRLOG("%s: failed to create queue thread %zu\n", bvdev->vdev.name, i);
+			vhost_blk_exit_queue_threads(bvdev);
+			return -EIO;
+		}
+		bvdev->num_queue_threads++;
+	}
+
+	return 0;
+}
+
 static int
 vhost_user_blk_create_ctrlr(struct spdk_vhost_dev *vdev, struct spdk_cpuset *cpumask,
 			    const char *address, const struct spdk_json_val *params, void *custom_opts)
 {
 	struct rpc_vhost_blk req = {0};
 	struct spdk_vhost_blk_dev *bvdev = to_blk_dev(vdev);
+	int rc;
 
 	assert(bvdev != NULL);
 
@@ -1792,13 +2124,36 @@ vhost_user_blk_create_ctrlr(struct spdk_vhost_dev *vdev, struct spdk_cpuset *cpu
 		bvdev->readonly = req.readonly;
 	}
 
-	return vhost_user_dev_create(vdev, address, cpumask, custom_opts, false);
+	/* Queue threads have to exist before the socket is registered and a
+	 * session can be started.
+	 */
+	rc = vhost_blk_set_queue_threads(bvdev, cpumask, &req);
+	if (rc != 0) {
+		return rc;
+	}
+
+	rc = vhost_user_dev_create(vdev, address, cpumask, custom_opts, false);
+	if (rc != 0) {
+		vhost_blk_exit_queue_threads(bvdev);
+	}
+
+	return rc;
 }
 
 static int
 vhost_user_blk_destroy_ctrlr(struct spdk_vhost_dev *vdev)
 {
-	return vhost_user_dev_unregister(vdev);
+	struct spdk_vhost_blk_dev *bvdev = to_blk_dev(vdev);
+	int rc;
+
+	assert(bvdev != NULL);
+
+	rc = vhost_user_dev_unregister(vdev);
+	if (rc == 0) {
+		vhost_blk_exit_queue_threads(bvdev);
+	}
+
+	return rc;
 }
 
 static void
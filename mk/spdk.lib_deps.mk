@@ -74,7 +74,7 @@ DEPDIRS-ftl += trace
 endif
 DEPDIRS-nbd := log util thread $(JSON_LIBS) bdev
 ifeq ($(CONFIG_UBLK),y)
-DEPDIRS-ublk := log util thread $(JSON_LIBS) bdev
+DEPDIRS-ublk := log util thread $(JSON_LIBS) bdev dma
 endif
 DEPDIRS-nvmf := accel log sock util nvme thread $(JSON_LIBS) trace bdev keyring
 ifeq ($(CONFIG_RDMA),y)
@@ -85,7 +85,7 @@ DEPDIRS-mlx5 = log rdma_utils util rdma_cm
 endif
 DEPDIRS-scsi := log util thread $(JSON_LIBS) trace bdev
 
-DEPDIRS-iscsi := log sock util conf thread $(JSON_LIBS) trace scsi
+DEPDIRS-iscsi := log sock util conf thread $(JSON_LIBS) trace scsi accel
 DEPDIRS-vhost = log util thread $(JSON_LIBS) bdev scsi
 
 DEPDIRS-fsdev := log thread util $(JSON_LIBS) notify
@@ -148,7 +148,11 @@ DEPDIRS-bdev_rpc := $(BDEV_DEPS)
 DEPDIRS-bdev_split := $(BDEV_DEPS)
 
 DEPDIRS-bdev_aio := $(BDEV_DEPS_THREAD)
+DEPDIRS-bdev_cache := $(BDEV_DEPS_THREAD)
+DEPDIRS-bdev_readahead := $(BDEV_DEPS_THREAD)
+DEPDIRS-bdev_compress := $(BDEV_DEPS_THREAD) accel
 DEPDIRS-bdev_crypto := $(BDEV_DEPS_THREAD) accel dma
+DEPDIRS-bdev_dedup := $(BDEV_DEPS_THREAD)
 DEPDIRS-bdev_delay := $(BDEV_DEPS_THREAD)
 DEPDIRS-bdev_error := $(BDEV_DEPS_THREAD)
 DEPDIRS-bdev_iscsi := $(BDEV_DEPS_THREAD)
@@ -158,11 +162,11 @@ DEPDIRS-bdev_nvme = $(BDEV_DEPS_THREAD) accel dma keyring nvme trace
 DEPDIRS-bdev_ocf := $(BDEV_DEPS_THREAD)
 DEPDIRS-bdev_passthru := $(BDEV_DEPS_THREAD)
 DEPDIRS-bdev_raid := $(BDEV_DEPS_THREAD) dma trace
-ifeq ($(CONFIG_RAID5F),y)
+ifneq (,$(filter y,$(CONFIG_RAID5F) $(CONFIG_RAID6)))
 DEPDIRS-bdev_raid += accel
 endif
 DEPDIRS-bdev_rbd := $(BDEV_DEPS_THREAD)
-DEPDIRS-bdev_uring := $(BDEV_DEPS_THREAD)
+DEPDIRS-bdev_uring := $(BDEV_DEPS_THREAD) dma
 DEPDIRS-bdev_virtio := $(BDEV_DEPS_THREAD) virtio
 DEPDIRS-bdev_zone_block := $(BDEV_DEPS_THREAD)
 DEPDIRS-bdev_xnvme := $(BDEV_DEPS_THREAD)
@@ -194,7 +198,7 @@ DEPDIRS-event_nvmf := init nvme nvmf event_bdev event_scheduler event_sock event
 		      event_accel event_iobuf thread log bdev util $(JSON_LIBS)
 DEPDIRS-event_scsi := init scsi event_bdev
 
-DEPDIRS-event_iscsi := init iscsi event_scheduler event_scsi event_sock
+DEPDIRS-event_iscsi := init iscsi event_scheduler event_scsi event_sock event_accel
 DEPDIRS-event_vhost_blk := init vhost
 DEPDIRS-event_vhost_scsi := init vhost event_scheduler event_scsi
 DEPDIRS-event_sock := init sock log util thread
@@ -0,0 +1,1572 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+/*
+ * Read cache virtual bdev.
+ *
+ * Data of a slow base bdev is cached in fixed size lines, either in DRAM or on
+ * a faster cache bdev. The cache is a set associative table: a line maps to one
+ * set of CACHE_WAYS slots through a hash of its number, and slot i of the table
+ * holds its data at offset i * line_size of the DRAM buffer or the cache bdev.
+ *
+ * Lookups take no lock. Each slot has a sequence number that changes whenever
+ * its contents change and that is odd while the slot is being filled. A reader
+ * samples it, copies the data (or reads it from the cache bdev) and checks it
+ * again; a changed sequence number turns the hit into a miss. Slots are only
+ * modified with the spinlock of their set held, which also protects an epoch
+ * bumped by every write touching the set. A read miss samples the epochs of its
+ * lines before reading the base bdev and fills a line only if its epoch did not
+ * change, so data older than a completed write never makes it into the cache.
+ *
+ * Missed lines are admitted with a TinyLFU policy: a count-min sketch estimates
+ * how often lines were read recently, and a line replaces the least frequently
+ * read line of its set only if it was read more often. The sketch counters are
+ * halved periodically so that old popularity fades away.
+ *
+ * Writes go to the base bdev. In write-through mode the lines they fully cover
+ * are then stored in the cache, in write-around mode they are dropped from it.
+ * With a cache bdev, I/Os complete once their lines are written to it.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "vbdev_cache.h"
+#include "vbdev_cache_common.h"
+#include "spdk/env.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+#include "spdk/uuid.h"
+
+#include "spdk/bdev_module.h"
+#include "spdk/log.h"
+
+/* This namespace UUID was generated using uuid_generate() method. */
+#define BDEV_CACHE_NAMESPACE_UUID "a3c1f5e2-7d4b-4e8a-9f06-2b5d8c1e7a93"
+
+#define CACHE_WAYS		8
+#define CACHE_MAX_LINE_SIZE	(128 * 1024)
+/* Larger reads are passed to the base bdev without looking them up */
+#define CACHE_MAX_IO_LINES	16
+/* Bounce buffers of each channel used to access the cache bdev */
+#define CACHE_CH_BUFS		64
+
+#define CACHE_SKETCH_DEPTH	4
+#define CACHE_SKETCH_MAX	15
+/* The sketch is aged after this many reads per cache line */
+#define CACHE_SKETCH_SAMPLE	10
+/* Reads counted by a channel before they are added to the shared count */
+#define CACHE_SKETCH_BATCH	64
+#define CACHE_SKETCH_SEED	0x9e3779b97f4a7c15ULL
+
+struct cache_slot {
+	/* Line number plus one, 0 if the slot is empty */
+	uint64_t			tag;
+	/* Changed on every update of the slot, odd while it is being filled */
+	uint32_t			seq;
+};
+
+struct cache_set {
+	pthread_spinlock_t		lock;
+	uint32_t			epoch;
+	uint32_t			hand;
+	struct cache_slot		slots[CACHE_WAYS];
+};
+
+struct vbdev_cache {
+	struct spdk_bdev		bdev;
+	struct spdk_bdev		*base_bdev;
+	struct spdk_bdev_desc		*base_desc;
+	/* NULL when the lines are kept in DRAM */
+	struct spdk_bdev		*cache_bdev;
+	struct spdk_bdev_desc		*cache_desc;
+	struct spdk_thread		*thread;
+	TAILQ_ENTRY(vbdev_cache)	link;
+
+	struct bdev_cache_opts		opts;
+	uint32_t			line_size;
+	uint32_t			line_blocks;
+	uint64_t			num_lines;
+	uint64_t			num_sets;
+	struct cache_set		*sets;
+	void				*data;
+	uint64_t			used_lines;
+
+	/* Count-min sketch of the read frequency of lines, NULL without admission filter */
+	uint8_t				*sketch;
+	uint64_t			sketch_width;
+	uint64_t			sketch_ops;
+	uint64_t			sketch_reset;
+
+	/* Channels, whose statistics are added to the ones of destroyed channels */
+	pthread_mutex_t			mutex;
+	TAILQ_HEAD(, cache_io_channel)	channels;
+	struct bdev_cache_stats		stats;
+};
+
+static TAILQ_HEAD(, vbdev_cache) g_cache_nodes = TAILQ_HEAD_INITIALIZER(g_cache_nodes);
+
+/* Cache bdevs to create once their base and cache bdevs show up */
+static struct vbdev_cache_assoc_list g_cache_assocs = TAILQ_HEAD_INITIALIZER(g_cache_assocs);
+
+struct cache_bdev_io;
+
+struct cache_buf {
+	void				*data;
+	struct cache_bdev_io		*io;
+	/* Slot filled from this buffer and the sequence number it was claimed with */
+	struct cache_set		*set;
+	uint32_t			way;
+	uint32_t			seq;
+	STAILQ_ENTRY(cache_buf)		link;
+};
+
+struct cache_io_channel {
+	struct vbdev_cache		*cache;
+	struct spdk_io_channel		*base_ch;
+	struct spdk_io_channel		*cache_ch;
+	struct cache_buf		*buf_array;
+	void				*buf_data;
+	STAILQ_HEAD(, cache_buf)	bufs;
+	uint32_t			sketch_ops;
+	struct bdev_cache_stats		stats;
+	TAILQ_ENTRY(cache_io_channel)	link;
+};
+
+struct cache_line_io {
+	/* Part of the line read from the cache bdev */
+	struct cache_buf		*buf;
+	/* Slot the line was found in and its sequence number at that time */
+	uint32_t			way;
+	uint32_t			seq;
+	/* Epoch of the set of the line when the base bdev read was started */
+	uint32_t			epoch;
+};
+
+struct cache_bdev_io {
+	struct vbdev_cache_io		base;
+	struct cache_io_channel		*ch;
+	enum spdk_bdev_io_status	status;
+	uint64_t			first_line;
+	uint32_t			num_lines;
+	/* Cache bdev I/Os in flight and whether one of them failed */
+	uint32_t			outstanding;
+	bool				failed;
+	bool				hit;
+	uint64_t			tsc;
+	struct cache_line_io		lines[CACHE_MAX_IO_LINES];
+};
+
+static int vbdev_cache_init(void);
+static int vbdev_cache_get_ctx_size(void);
+static void vbdev_cache_examine(struct spdk_bdev *bdev);
+static void vbdev_cache_finish(void);
+static int vbdev_cache_config_json(struct spdk_json_write_ctx *w);
+
+static struct spdk_bdev_module cache_if = {
+	.name = "cache",
+	.module_init = vbdev_cache_init,
+	.get_ctx_size = vbdev_cache_get_ctx_size,
+	.examine_config = vbdev_cache_examine,
+	.module_fini = vbdev_cache_finish,
+	.config_json = vbdev_cache_config_json
+};
+
+SPDK_BDEV_MODULE_REGISTER(cache, &cache_if)
+
+static const char *
+cache_mode_name(enum bdev_cache_mode mode)
+{
+	switch (mode) {
+	case BDEV_CACHE_MODE_WRITE_THROUGH:
+		return "write_through";
+	case BDEV_CACHE_MODE_WRITE_AROUND:
+		return "write_around";
+	default:
+		return "unknown";
+	}
+}
+
+static inline uint64_t
+cache_hash(uint64_t x)
+{
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ULL;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebULL;
+	x ^= x >> 31;
+
+	return x;
+}
+
+/* Admission sketch */
+
+static inline uint8_t *
+cache_sketch_counter(struct vbdev_cache *cache, uint64_t hash, uint32_t row)
+{
+	uint64_t step = (hash >> 32) | 1;
+
+	return &cache->sketch[row * cache->sketch_width +
+			      ((hash + row * step) & (cache->sketch_width - 1))];
+}
+
+static uint32_t
+cache_sketch_estimate(struct vbdev_cache *cache, uint64_t line)
+{
+	uint64_t hash = cache_hash(line ^ CACHE_SKETCH_SEED);
+	uint32_t row, freq = CACHE_SKETCH_MAX;
+
+	for (row = 0; row < CACHE_SKETCH_DEPTH; row++) {
+		freq = spdk_min(freq, __atomic_load_n(cache_sketch_counter(cache, hash, row),
+						      __ATOMIC_RELAXED));
+	}
+
+	return freq;
+}
+
+static void
+cache_sketch_age(struct vbdev_cache *cache)
+{
+	uint64_t *words = (uint64_t *)cache->sketch;
+	uint64_t i, word;
+
+	/* Halve all the counters, eight at a time */
+	for (i = 0; i < CACHE_SKETCH_DEPTH * cache->sketch_width / sizeof(uint64_t); i++) {
+		word = __atomic_load_n(&words[i], __ATOMIC_RELAXED);
+		__atomic_store_n(&words[i], (word >> 1) & 0x7f7f7f7f7f7f7f7fULL, __ATOMIC_RELAXED);
+	}
+}
+
+static void
+cache_sketch_add(struct cache_io_channel *ch, uint64_t line)
+{
+	struct vbdev_cache *cache = ch->cache;
+	uint64_t hash = cache_hash(line ^ CACHE_SKETCH_SEED);
+	uint64_t ops;
+	uint8_t *counter, value;
+	uint32_t row;
+
+	/* Increments racing on another thread may be lost, the sketch is an estimate anyway */
+	for (row = 0; row < CACHE_SKETCH_DEPTH; row++) {
+		counter = cache_sketch_counter(cache, hash, row);
+		value = __atomic_load_n(counter, __ATOMIC_RELAXED);
+		if (value < CACHE_SKETCH_MAX) {
+			__atomic_store_n(counter, value + 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	if (++ch->sketch_ops < CACHE_SKETCH_BATCH) {
+		return;
+	}
+
+	ch->sketch_ops = 0;
+	ops = __atomic_add_fetch(&cache->sketch_ops, CACHE_SKETCH_BATCH, __ATOMIC_RELAXED);
+	if (ops >= cache->sketch_reset &&
+	    __atomic_compare_exchange_n(&cache->sketch_ops, &ops, 0, false, __ATOMIC_RELAXED,
+					__ATOMIC_RELAXED)) {
+		cache_sketch_age(cache);
+	}
+}
+
+/* Cache index */
+
+static inline struct cache_set *
+cache_get_set(struct vbdev_cache *cache, uint64_t line)
+{
+	return &cache->sets[cache_hash(line) % cache->num_sets];
+}
+
+static inline uint64_t
+cache_slot_index(struct vbdev_cache *cache, struct cache_set *set, uint32_t way)
+{
+	return (uint64_t)(set - cache->sets) * CACHE_WAYS + way;
+}
+
+static inline uint8_t *
+cache_slot_data(struct vbdev_cache *cache, struct cache_set *set, uint32_t way)
+{
+	return (uint8_t *)cache->data + cache_slot_index(cache, set, way) * cache->line_size;
+}
+
+/* Lock-free lookup of a line. Returns the slot holding it and its sequence number, which
+ * has to be checked again with cache_slot_check() once the data is copied.
+ */
+static int
+cache_lookup(struct cache_set *set, uint64_t line, uint32_t *seq)
+{
+	struct cache_slot *slot;
+	uint32_t way, s;
+
+	for (way = 0; way < CACHE_WAYS; way++) {
+		slot = &set->slots[way];
+		s = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		if ((s & 1) == 0 && __atomic_load_n(&slot->tag, __ATOMIC_RELAXED) == line + 1) {
+			*seq = s;
+			return way;
+		}
+	}
+
+	return -1;
+}
+
+static bool
+cache_slot_check(struct cache_slot *slot, uint32_t seq)
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+	return __atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == seq;
+}
+
+/* The functions below modify slots and are called with the set locked */
+
+static int
+cache_find(struct cache_set *set, uint64_t line)
+{
+	uint32_t way;
+
+	for (way = 0; way < CACHE_WAYS; way++) {
+		if (set->slots[way].tag == line + 1) {
+			return way;
+		}
+	}
+
+	return -1;
+}
+
+static uint32_t
+cache_slot_claim(struct vbdev_cache *cache, struct cache_slot *slot, uint64_t line)
+{
+	uint32_t seq = slot->seq + 1;
+
+	assert(seq & 1);
+	if (slot->tag == 0) {
+		__atomic_add_fetch(&cache->used_lines, 1, __ATOMIC_RELAXED);
+	}
+
+	__atomic_store_n(&slot->seq, seq, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&slot->tag, line + 1, __ATOMIC_RELAXED);
+
+	return seq;
+}
+
+static void
+cache_slot_publish(struct cache_slot *slot)
+{
+	assert(slot->seq & 1);
+	__atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELEASE);
+}
+
+static void
+cache_slot_clear(struct vbdev_cache *cache, struct cache_slot *slot)
+{
+	__atomic_store_n(&slot->tag, 0, __ATOMIC_RELAXED);
+	/* Next even value, for both filled and claimed slots */
+	__atomic_store_n(&slot->seq, (slot->seq | 1) + 1, __ATOMIC_RELEASE);
+	__atomic_sub_fetch(&cache->used_lines, 1, __ATOMIC_RELAXED);
+}
+
+static void
+cache_slot_drop(struct cache_io_channel *ch, struct cache_set *set, uint32_t way)
+{
+	struct cache_slot *slot = &set->slots[way];
+
+	if (slot->seq & 1) {
+		/* Being written to the cache bdev, the slot is cleared once that completes */
+		__atomic_store_n(&slot->tag, 0, __ATOMIC_RELAXED);
+	} else {
+		cache_slot_clear(ch->cache, slot);
+	}
+
+	ch->stats.lines_invalidated++;
+}
+
+static void
+cache_set_invalidate(struct cache_io_channel *ch, struct cache_set *set, uint64_t line)
+{
+	int way;
+
+	__atomic_store_n(&set->epoch, set->epoch + 1, __ATOMIC_RELEASE);
+	way = cache_find(set, line);
+	if (way >= 0) {
+		cache_slot_drop(ch, set, way);
+	}
+}
+
+/* Pick the slot a line goes to. Returns -1 if no slot is available or if the admission
+ * filter turns the line down.
+ */
+static int
+cache_select_slot(struct cache_io_channel *ch, struct cache_set *set, uint64_t line)
+{
+	struct vbdev_cache *cache = ch->cache;
+	struct cache_slot *slot;
+	uint32_t i, way, freq, victim_freq = UINT32_MAX;
+	int victim = -1;
+
+	for (i = 0; i < CACHE_WAYS; i++) {
+		way = (set->hand + i) % CACHE_WAYS;
+		slot = &set->slots[way];
+		if (slot->seq & 1) {
+			continue;
+		}
+		if (slot->tag == 0) {
+			ch->stats.lines_admitted++;
+			return way;
+		}
+		if (cache->sketch == NULL) {
+			/* Without admission filter, lines are replaced round-robin */
+			if (victim < 0) {
+				victim = way;
+			}
+			continue;
+		}
+
+		freq = cache_sketch_estimate(cache, slot->tag - 1);
+		if (freq < victim_freq) {
+			victim = way;
+			victim_freq = freq;
+		}
+	}
+
+	if (victim < 0) {
+		return -1;
+	}
+
+	if (cache->sketch != NULL && cache_sketch_estimate(cache, line) <= victim_freq) {
+		ch->stats.lines_rejected++;
+		return -1;
+	}
+
+	set->hand = (victim + 1) % CACHE_WAYS;
+	ch->stats.lines_evicted++;
+	ch->stats.lines_admitted++;
+
+	return victim;
+}
+
+static void
+cache_invalidate_line(struct cache_io_channel *ch, uint64_t line)
+{
+	struct cache_set *set = cache_get_set(ch->cache, line);
+
+	pthread_spin_lock(&set->lock);
+	cache_set_invalidate(ch, set, line);
+	pthread_spin_unlock(&set->lock);
+}
+
+static void
+cache_invalidate_range(struct cache_io_channel *ch, uint64_t first_line, uint64_t num_lines)
+{
+	struct vbdev_cache *cache = ch->cache;
+	struct cache_set *set;
+	uint64_t i, line;
+	uint32_t way;
+
+	if (num_lines <= cache->num_sets) {
+		for (i = 0; i < num_lines; i++) {
+			cache_invalidate_line(ch, first_line + i);
+		}
+		return;
+	}
+
+	/* Going through the whole cache is cheaper than going through every line */
+	for (i = 0; i < cache->num_sets; i++) {
+		set = &cache->sets[i];
+		pthread_spin_lock(&set->lock);
+		__atomic_store_n(&set->epoch, set->epoch + 1, __ATOMIC_RELEASE);
+		for (way = 0; way < CACHE_WAYS; way++) {
+			line = set->slots[way].tag - 1;
+			if (set->slots[way].tag != 0 && line >= first_line &&
+			    line - first_line < num_lines) {
+				cache_slot_drop(ch, set, way);
+			}
+		}
+		pthread_spin_unlock(&set->lock);
+	}
+}
+
+/* I/O path */
+
+static struct cache_buf *
+cache_get_buf(struct cache_io_channel *ch)
+{
+	struct cache_buf *buf = STAILQ_FIRST(&ch->bufs);
+
+	if (buf != NULL) {
+		STAILQ_REMOVE_HEAD(&ch->bufs, link);
+	}
+
+	return buf;
+}
+
+static void
+cache_put_buf(struct cache_io_channel *ch, struct cache_buf *buf)
+{
+	STAILQ_INSERT_HEAD(&ch->bufs, buf, link);
+}
+
+static void
+cache_put_line_bufs(struct cache_bdev_io *io, uint32_t count)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; i++) {
+		cache_put_buf(io->ch, io->lines[i].buf);
+		io->lines[i].buf = NULL;
+	}
+}
+
+/* Copy len bytes between buf and the request buffers, starting offset bytes into them */
+static void
+cache_iov_copy(struct iovec *iovs, int iovcnt, uint64_t offset, void *buf, size_t len,
+	       bool to_iovs)
+{
+	uint8_t *data = buf;
+	size_t n;
+	int i;
+
+	for (i = 0; i < iovcnt && len > 0; i++) {
+		if (offset >= iovs[i].iov_len) {
+			offset -= iovs[i].iov_len;
+			continue;
+		}
+
+		n = spdk_min(iovs[i].iov_len - offset, len);
+		if (to_iovs) {
+			memcpy((uint8_t *)iovs[i].iov_base + offset, data, n);
+		} else {
+			memcpy(data, (uint8_t *)iovs[i].iov_base + offset, n);
+		}
+		data += n;
+		len -= n;
+		offset = 0;
+	}
+
+	assert(len == 0);
+}
+
+/* Part of a line of the request: offset in the line, offset in the request, length */
+static void
+cache_io_line_range(struct cache_bdev_io *io, uint32_t i, uint64_t *line_offset,
+		    uint64_t *io_offset, uint64_t *num_blocks)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+	struct vbdev_cache *cache = io->ch->cache;
+	uint64_t line_start = (io->first_line + i) * cache->line_blocks;
+	uint64_t start = spdk_max(line_start, bdev_io->u.bdev.offset_blocks);
+	uint64_t end = spdk_min(line_start + cache->line_blocks,
+				bdev_io->u.bdev.offset_blocks + bdev_io->u.bdev.num_blocks);
+
+	*line_offset = start - line_start;
+	*io_offset = start - bdev_io->u.bdev.offset_blocks;
+	*num_blocks = end - start;
+}
+
+static bool
+cache_io_line_full(struct cache_bdev_io *io, uint32_t i)
+{
+	uint64_t line_offset, io_offset, num_blocks;
+
+	cache_io_line_range(io, i, &line_offset, &io_offset, &num_blocks);
+
+	return num_blocks == io->ch->cache->line_blocks;
+}
+
+static void
+cache_io_done(struct cache_bdev_io *io)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+	struct bdev_cache_stats *stats = &io->ch->stats;
+	uint64_t ticks;
+
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_READ && io->status == SPDK_BDEV_IO_STATUS_SUCCESS) {
+		ticks = spdk_get_ticks() - io->tsc;
+		if (io->hit) {
+			stats->read_hits++;
+			stats->hit_ticks += ticks;
+		} else {
+			if (io->num_lines > CACHE_MAX_IO_LINES) {
+				stats->read_bypassed++;
+			} else {
+				stats->read_misses++;
+			}
+			stats->miss_ticks += ticks;
+		}
+	}
+
+	spdk_bdev_io_complete(bdev_io, io->status);
+}
+
+static void
+cache_fill_end(struct cache_buf *buf, bool success)
+{
+	struct cache_bdev_io *io = buf->io;
+	struct cache_set *set = buf->set;
+	struct cache_slot *slot = &set->slots[buf->way];
+
+	pthread_spin_lock(&set->lock);
+	/* Claimed slots are never reused, but a write may have dropped the line meanwhile */
+	assert(slot->seq == buf->seq);
+	if (success && slot->tag != 0) {
+		cache_slot_publish(slot);
+	} else {
+		cache_slot_clear(io->ch->cache, slot);
+	}
+	pthread_spin_unlock(&set->lock);
+
+	cache_put_buf(io->ch, buf);
+	io->outstanding--;
+}
+
+static void
+cache_fill_done(struct spdk_bdev_io *cache_io, bool success, void *cb_arg)
+{
+	struct cache_buf *buf = cb_arg;
+	struct cache_bdev_io *io = buf->io;
+
+	spdk_bdev_free_io(cache_io);
+
+	cache_fill_end(buf, success);
+	if (io->outstanding == 0) {
+		cache_io_done(io);
+	}
+}
+
+/* Store a line fully covered by the request in the cache. Writes replace the cached line,
+ * reads only fill lines whose set was not written since the base bdev read was started.
+ */
+static void
+cache_fill_line(struct cache_bdev_io *io, uint32_t i, bool write)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+	struct cache_io_channel *ch = io->ch;
+	struct vbdev_cache *cache = ch->cache;
+	uint64_t line = io->first_line + i;
+	struct cache_set *set = cache_get_set(cache, line);
+	uint64_t offset = (line * cache->line_blocks - bdev_io->u.bdev.offset_blocks) *
+			  cache->bdev.blocklen;
+	struct cache_buf *buf = NULL;
+	uint32_t seq;
+	int way, rc;
+
+	if (cache->cache_desc != NULL) {
+		buf = cache_get_buf(ch);
+		if (buf == NULL) {
+			if (write) {
+				cache_invalidate_line(ch, line);
+			}
+			return;
+		}
+		/* Copied before the slot is claimed to keep the set locked briefly */
+		cache_iov_copy(bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt, offset, buf->data,
+			       cache->line_size, false);
+	}
+
+	pthread_spin_lock(&set->lock);
+	if (write) {
+		cache_set_invalidate(ch, set, line);
+		way = cache_select_slot(ch, set, line);
+	} else if (set->epoch != io->lines[i].epoch || cache_find(set, line) >= 0) {
+		way = -1;
+	} else {
+		way = cache_select_slot(ch, set, line);
+	}
+
+	if (way < 0) {
+		pthread_spin_unlock(&set->lock);
+		if (buf != NULL) {
+			cache_put_buf(ch, buf);
+		}
+		return;
+	}
+
+	seq = cache_slot_claim(cache, &set->slots[way], line);
+	if (buf == NULL) {
+		cache_iov_copy(bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt, offset,
+			       cache_slot_data(cache, set, way), cache->line_size, false);
+		cache_slot_publish(&set->slots[way]);
+		pthread_spin_unlock(&set->lock);
+		return;
+	}
+	pthread_spin_unlock(&set->lock);
+
+	buf->io = io;
+	buf->set = set;
+	buf->way = way;
+	buf->seq = seq;
+	io->outstanding++;
+
+	rc = spdk_bdev_write_blocks(cache->cache_desc, ch->cache_ch, buf->data,
+				    cache_slot_index(cache, set, way) * cache->line_blocks,
+				    cache->line_blocks, cache_fill_done, buf);
+	if (rc != 0) {
+		cache_fill_end(buf, false);
+	}
+}
+
+static void
+cache_read_miss(struct cache_bdev_io *io)
+{
+	struct vbdev_cache *cache = io->ch->cache;
+	struct cache_set *set;
+	uint32_t i;
+
+	for (i = 0; i < io->num_lines; i++) {
+		set = cache_get_set(cache, io->first_line + i);
+		io->lines[i].epoch = __atomic_load_n(&set->epoch, __ATOMIC_ACQUIRE);
+	}
+
+	vbdev_cache_io_submit_base(&io->base);
+}
+
+static void
+cache_read_base_done(struct spdk_bdev_io *base_io, bool success, void *cb_arg)
+{
+	struct cache_bdev_io *io = cb_arg;
+	uint32_t i;
+
+	spdk_bdev_free_io(base_io);
+
+	if (!success) {
+		io->status = SPDK_BDEV_IO_STATUS_FAILED;
+		cache_io_done(io);
+		return;
+	}
+
+	if (io->num_lines <= CACHE_MAX_IO_LINES) {
+		for (i = 0; i < io->num_lines; i++) {
+			if (cache_io_line_full(io, i)) {
+				cache_fill_line(io, i, false);
+			}
+		}
+	}
+
+	if (io->outstanding == 0) {
+		cache_io_done(io);
+	}
+}
+
+static bool
+cache_read_dram(struct cache_bdev_io *io)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+	struct vbdev_cache *cache = io->ch->cache;
+	uint32_t blocklen = cache->bdev.blocklen;
+	uint64_t line_offset, io_offset, num_blocks;
+	struct cache_set *set;
+	uint32_t i, seq;
+	int way;
+
+	for (i = 0; i < io->num_lines; i++) {
+		set = cache_get_set(cache, io->first_line + i);
+		way = cache_lookup(set, io->first_line + i, &seq);
+		if (way < 0) {
+			return false;
+		}
+
+		cache_io_line_range(io, i, &line_offset, &io_offset, &num_blocks);
+		cache_iov_copy(bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt, io_offset * blocklen,
+			       cache_slot_data(cache, set, way) + line_offset * blocklen,
+			       num_blocks * blocklen, true);
+		if (!cache_slot_check(&set->slots[way], seq)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void
+cache_read_hit_finish(struct cache_bdev_io *io)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+	struct vbdev_cache *cache = io->ch->cache;
+	uint32_t blocklen = cache->bdev.blocklen;
+	uint64_t line_offset, io_offset, num_blocks;
+	struct cache_set *set;
+	uint32_t i;
+
+	/* Lines replaced while they were being read are read again from the base bdev */
+	for (i = 0; i < io->num_lines && !io->failed; i++) {
+		set = cache_get_set(cache, io->first_line + i);
+		if (!cache_slot_check(&set->slots[io->lines[i].way], io->lines[i].seq)) {
+			io->failed = true;
+		}
+	}
+
+	if (io->failed) {
+		cache_put_line_bufs(io, io->num_lines);
+		io->failed = false;
+		cache_read_miss(io);
+		return;
+	}
+
+	for (i = 0; i < io->num_lines; i++) {
+		cache_io_line_range(io, i, &line_offset, &io_offset, &num_blocks);
+		cache_iov_copy(bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt, io_offset * blocklen,
+			       io->lines[i].buf->data, num_blocks * blocklen, true);
+	}
+	cache_put_line_bufs(io, io->num_lines);
+
+	io->hit = true;
+	cache_io_done(io);
+}
+
+static void
+cache_read_hit_done(struct spdk_bdev_io *cache_io, bool success, void *cb_arg)
+{
+	struct cache_bdev_io *io = cb_arg;
+
+	spdk_bdev_free_io(cache_io);
+
+	if (!success) {
+		io->failed = true;
+	}
+
+	if (--io->outstanding == 0) {
+		cache_read_hit_finish(io);
+	}
+}
+
+/* Read the request from the cache bdev if all of its lines are cached */
+static bool
+cache_read_hit_submit(struct cache_bdev_io *io)
+{
+	struct cache_io_channel *ch = io->ch;
+	struct vbdev_cache *cache = ch->cache;
+	struct cache_line_io *line;
+	uint64_t line_offset, io_offset, num_blocks, offset;
+	struct cache_set *set;
+	uint32_t i;
+	int way, rc;
+
+	for (i = 0; i < io->num_lines; i++) {
+		line = &io->lines[i];
+		set = cache_get_set(cache, io->first_line + i);
+		way = cache_lookup(set, io->first_line + i, &line->seq);
+		line->buf = way >= 0 ? cache_get_buf(ch) : NULL;
+		if (line->buf == NULL) {
+			cache_put_line_bufs(io, i);
+			return false;
+		}
+		line->way = way;
+	}
+
+	io->outstanding = io->num_lines;
+	for (i = 0; i < io->num_lines; i++) {
+		line = &io->lines[i];
+		set = cache_get_set(cache, io->first_line + i);
+		cache_io_line_range(io, i, &line_offset, &io_offset, &num_blocks);
+		offset = cache_slot_index(cache, set, line->way) * cache->line_blocks + line_offset;
+		rc = spdk_bdev_read_blocks(cache->cache_desc, ch->cache_ch, line->buf->data, offset,
+					   num_blocks, cache_read_hit_done, io);
+		if (rc != 0) {
+			io->failed = true;
+			io->outstanding--;
+		}
+	}
+
+	if (io->outstanding == 0) {
+		cache_read_hit_finish(io);
+	}
+
+	return true;
+}
+
+static void
+cache_read(struct vbdev_cache_io *base)
+{
+	struct cache_bdev_io *io = SPDK_CONTAINEROF(base, struct cache_bdev_io, base);
+	struct cache_io_channel *ch = io->ch;
+	struct vbdev_cache *cache = ch->cache;
+	uint32_t i;
+
+	if (io->num_lines > CACHE_MAX_IO_LINES) {
+		vbdev_cache_io_submit_base(&io->base);
+		return;
+	}
+
+	if (cache->sketch != NULL) {
+		for (i = 0; i < io->num_lines; i++) {
+			cache_sketch_add(ch, io->first_line + i);
+		}
+	}
+
+	if (cache->cache_desc == NULL) {
+		if (cache_read_dram(io)) {
+			io->hit = true;
+			cache_io_done(io);
+			return;
+		}
+	} else if (cache_read_hit_submit(io)) {
+		return;
+	}
+
+	cache_read_miss(io);
+}
+
+static void
+cache_write_base_done(struct spdk_bdev_io *base_io, bool success, void *cb_arg)
+{
+	struct cache_bdev_io *io = cb_arg;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+	struct cache_io_channel *ch = io->ch;
+	struct vbdev_cache *cache = ch->cache;
+	uint32_t i;
+
+	spdk_bdev_free_io(base_io);
+
+	if (!success) {
+		io->status = SPDK_BDEV_IO_STATUS_FAILED;
+	}
+
+	/* Lines are dropped even if the write failed, their contents are unknown */
+	if (success && bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE &&
+	    cache->opts.mode == BDEV_CACHE_MODE_WRITE_THROUGH &&
+	    io->num_lines <= CACHE_MAX_IO_LINES) {
+		for (i = 0; i < io->num_lines; i++) {
+			if (cache_io_line_full(io, i)) {
+				cache_fill_line(io, i, true);
+			} else {
+				cache_invalidate_line(ch, io->first_line + i);
+			}
+		}
+	} else {
+		cache_invalidate_range(ch, io->first_line, io->num_lines);
+	}
+
+	if (io->outstanding == 0) {
+		cache_io_done(io);
+	}
+}
+
+static const struct vbdev_cache_io_ops g_cache_io_ops = {
+	.read		= cache_read,
+	.read_done	= cache_read_base_done,
+	.write_done	= cache_write_base_done,
+};
+
+static void
+vbdev_cache_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	struct vbdev_cache *cache = bdev_io->bdev->ctxt;
+	struct cache_bdev_io *io = (struct cache_bdev_io *)bdev_io->driver_ctx;
+	uint64_t offset_blocks = bdev_io->u.bdev.offset_blocks;
+
+	io->ch = spdk_io_channel_get_ctx(ch);
+	vbdev_cache_io_init(&io->base, &g_cache_io_ops, cache->base_desc, io->ch->base_ch);
+	io->status = SPDK_BDEV_IO_STATUS_SUCCESS;
+	io->outstanding = 0;
+	io->failed = false;
+	io->hit = false;
+	io->tsc = spdk_get_ticks();
+	io->first_line = 0;
+	io->num_lines = 0;
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+		io->first_line = offset_blocks / cache->line_blocks;
+		io->num_lines = (offset_blocks + bdev_io->u.bdev.num_blocks - 1) /
+				cache->line_blocks - io->first_line + 1;
+		break;
+	default:
+		break;
+	}
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+		vbdev_cache_io_read(&io->base);
+		break;
+	case SPDK_BDEV_IO_TYPE_WRITE:
+		io->ch->stats.writes++;
+		vbdev_cache_io_submit_base(&io->base);
+		break;
+	default:
+		vbdev_cache_io_submit_base(&io->base);
+		break;
+	}
+}
+
+static bool
+vbdev_cache_io_type_supported(void *ctx, enum spdk_bdev_io_type io_type)
+{
+	struct vbdev_cache *cache = ctx;
+
+	switch (io_type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+		return true;
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+	case SPDK_BDEV_IO_TYPE_FLUSH:
+	case SPDK_BDEV_IO_TYPE_RESET:
+		return spdk_bdev_io_type_supported(cache->base_bdev, io_type);
+	default:
+		return false;
+	}
+}
+
+static struct spdk_io_channel *
+vbdev_cache_get_io_channel(void *ctx)
+{
+	struct vbdev_cache *cache = ctx;
+
+	return spdk_get_io_channel(cache);
+}
+
+static void
+cache_stats_add(struct bdev_cache_stats *stats, const struct bdev_cache_stats *add)
+{
+	stats->read_hits += add->read_hits;
+	stats->read_misses += add->read_misses;
+	stats->read_bypassed += add->read_bypassed;
+	stats->writes += add->writes;
+	stats->lines_admitted += add->lines_admitted;
+	stats->lines_rejected += add->lines_rejected;
+	stats->lines_evicted += add->lines_evicted;
+	stats->lines_invalidated += add->lines_invalidated;
+	stats->hit_ticks += add->hit_ticks;
+	stats->miss_ticks += add->miss_ticks;
+}
+
+/* Counters of other threads' channels are read without synchronization and may lag a bit */
+static void
+cache_get_stats(struct vbdev_cache *cache, struct bdev_cache_stats *stats)
+{
+	struct cache_io_channel *ch;
+
+	pthread_mutex_lock(&cache->mutex);
+	*stats = cache->stats;
+	TAILQ_FOREACH(ch, &cache->channels, link) {
+		cache_stats_add(stats, &ch->stats);
+	}
+	pthread_mutex_unlock(&cache->mutex);
+
+	stats->capacity_lines = cache->num_lines;
+	stats->cached_lines = __atomic_load_n(&cache->used_lines, __ATOMIC_RELAXED);
+}
+
+static int
+vbdev_cache_dump_info_json(void *ctx, struct spdk_json_write_ctx *w)
+{
+	struct vbdev_cache *cache = ctx;
+
+	spdk_json_write_named_object_begin(w, "cache");
+	spdk_json_write_named_string(w, "name", spdk_bdev_get_name(&cache->bdev));
+	spdk_json_write_named_string(w, "base_bdev_name", spdk_bdev_get_name(cache->base_bdev));
+	if (cache->cache_bdev != NULL) {
+		spdk_json_write_named_string(w, "cache_bdev_name",
+					     spdk_bdev_get_name(cache->cache_bdev));
+	}
+	spdk_json_write_named_uint32(w, "line_size", cache->line_size);
+	spdk_json_write_named_uint64(w, "capacity_lines", cache->num_lines);
+	spdk_json_write_named_string(w, "mode", cache_mode_name(cache->opts.mode));
+	spdk_json_write_named_bool(w, "admission_filter", cache->opts.admission_filter);
+	spdk_json_write_object_end(w);
+
+	return 0;
+}
+
+static void
+vbdev_cache_write_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
+{
+	/* Cache bdevs are recreated from the module configuration */
+}
+
+static int
+vbdev_cache_config_json(struct spdk_json_write_ctx *w)
+{
+	struct vbdev_cache *cache;
+
+	TAILQ_FOREACH(cache, &g_cache_nodes, link) {
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "method", "bdev_cache_create");
+		spdk_json_write_named_object_begin(w, "params");
+		spdk_json_write_named_string(w, "name", spdk_bdev_get_name(&cache->bdev));
+		spdk_json_write_named_string(w, "base_bdev_name",
+					     spdk_bdev_get_name(cache->base_bdev));
+		if (cache->cache_bdev != NULL) {
+			spdk_json_write_named_string(w, "cache_bdev_name",
+						     spdk_bdev_get_name(cache->cache_bdev));
+		}
+		if (cache->opts.cache_size != 0) {
+			spdk_json_write_named_uint64(w, "cache_size_mb",
+						     cache->opts.cache_size / (1024 * 1024));
+		}
+		spdk_json_write_named_uint32(w, "line_size", cache->line_size);
+		spdk_json_write_named_string(w, "mode", cache_mode_name(cache->opts.mode));
+		spdk_json_write_named_bool(w, "admission_filter", cache->opts.admission_filter);
+		spdk_json_write_object_end(w);
+		spdk_json_write_object_end(w);
+	}
+
+	return 0;
+}
+
+static void
+cache_free(struct vbdev_cache *cache)
+{
+	uint64_t i;
+
+	if (cache->sets != NULL) {
+		for (i = 0; i < cache->num_sets; i++) {
+			pthread_spin_destroy(&cache->sets[i].lock);
+		}
+	}
+
+	free(cache->sets);
+	free(cache->sketch);
+	free(cache->data);
+	pthread_mutex_destroy(&cache->mutex);
+	free(cache->bdev.name);
+	free(cache);
+}
+
+static void
+cache_io_device_unregister_cb(void *io_device)
+{
+	cache_free(io_device);
+}
+
+static void
+_vbdev_cache_destruct(void *ctx)
+{
+	struct vbdev_cache *cache = ctx;
+
+	spdk_bdev_close(cache->base_desc);
+	if (cache->cache_desc != NULL) {
+		spdk_bdev_close(cache->cache_desc);
+	}
+
+	spdk_io_device_unregister(cache, cache_io_device_unregister_cb);
+}
+
+static int
+vbdev_cache_destruct(void *ctx)
+{
+	struct vbdev_cache *cache = ctx;
+
+	TAILQ_REMOVE(&g_cache_nodes, cache, link);
+
+	spdk_bdev_module_release_bdev(cache->base_bdev);
+	if (cache->cache_bdev != NULL) {
+		spdk_bdev_module_release_bdev(cache->cache_bdev);
+	}
+
+	/* Close the descriptors on the thread they were opened on */
+	if (cache->thread != spdk_get_thread()) {
+		spdk_thread_send_msg(cache->thread, _vbdev_cache_destruct, cache);
+	} else {
+		_vbdev_cache_destruct(cache);
+	}
+
+	return 0;
+}
+
+static const struct spdk_bdev_fn_table vbdev_cache_fn_table = {
+	.destruct		= vbdev_cache_destruct,
+	.submit_request		= vbdev_cache_submit_request,
+	.io_type_supported	= vbdev_cache_io_type_supported,
+	.get_io_channel		= vbdev_cache_get_io_channel,
+	.dump_info_json		= vbdev_cache_dump_info_json,
+	.write_config_json	= vbdev_cache_write_config_json,
+};
+
+static void
+cache_ch_free(struct cache_io_channel *ch)
+{
+	spdk_dma_free(ch->buf_data);
+	free(ch->buf_array);
+	if (ch->cache_ch != NULL) {
+		spdk_put_io_channel(ch->cache_ch);
+	}
+	if (ch->base_ch != NULL) {
+		spdk_put_io_channel(ch->base_ch);
+	}
+}
+
+static int
+cache_ch_create_cb(void *io_device, void *ctx_buf)
+{
+	struct vbdev_cache *cache = io_device;
+	struct cache_io_channel *ch = ctx_buf;
+	struct cache_buf *buf;
+	uint32_t i;
+
+	ch->cache = cache;
+	STAILQ_INIT(&ch->bufs);
+
+	ch->base_ch = spdk_bdev_get_io_channel(cache->base_desc);
+	if (ch->base_ch == NULL) {
+		return -ENOMEM;
+	}
+
+	if (cache->cache_desc != NULL) {
+		ch->cache_ch = spdk_bdev_get_io_channel(cache->cache_desc);
+		ch->buf_array = calloc(CACHE_CH_BUFS, sizeof(*ch->buf_array));
+		ch->buf_data = spdk_dma_zmalloc((size_t)CACHE_CH_BUFS * cache->line_size,
+						spdk_bdev_get_buf_align(cache->cache_bdev), NULL);
+		if (ch->cache_ch == NULL || ch->buf_array == NULL || ch->buf_data == NULL) {
+			cache_ch_free(ch);
+			return -ENOMEM;
+		}
+
+		for (i = 0; i < CACHE_CH_BUFS; i++) {
+			buf = &ch->buf_array[i];
+			buf->data = (uint8_t *)ch->buf_data + (size_t)i * cache->line_size;
+			STAILQ_INSERT_TAIL(&ch->bufs, buf, link);
+		}
+	}
+
+	pthread_mutex_lock(&cache->mutex);
+	TAILQ_INSERT_TAIL(&cache->channels, ch, link);
+	pthread_mutex_unlock(&cache->mutex);
+
+	return 0;
+}
+
+static void
+cache_ch_destroy_cb(void *io_device, void *ctx_buf)
+{
+	struct vbdev_cache *cache = io_device;
+	struct cache_io_channel *ch = ctx_buf;
+
+	pthread_mutex_lock(&cache->mutex);
+	cache_stats_add(&cache->stats, &ch->stats);
+	TAILQ_REMOVE(&cache->channels, ch, link);
+	pthread_mutex_unlock(&cache->mutex);
+
+	cache_ch_free(ch);
+}
+
+static void
+vbdev_cache_base_bdev_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev,
+			       void *event_ctx)
+{
+	struct vbdev_cache *cache, *tmp;
+
+	switch (type) {
+	case SPDK_BDEV_EVENT_REMOVE:
+		TAILQ_FOREACH_SAFE(cache, &g_cache_nodes, link, tmp) {
+			if (cache->base_bdev == bdev || cache->cache_bdev == bdev) {
+				spdk_bdev_unregister(&cache->bdev, NULL, NULL);
+			}
+		}
+		break;
+	default:
+		SPDK_NOTICELOG("Unsupported bdev event: type %d\n", type);
+		break;
+	}
+}
+
+/* Size the cache and allocate its index, sketch and DRAM lines */
+static int
+cache_alloc(struct vbdev_cache *cache, const struct bdev_cache_opts *opts)
+{
+	struct spdk_bdev *base_bdev = cache->base_bdev;
+	struct spdk_bdev *cache_bdev = cache->cache_bdev;
+	uint64_t size, i;
+
+	if (base_bdev->md_len != 0 || opts->line_size % base_bdev->blocklen != 0) {
+		SPDK_ERRLOG("Bdev %s format is not supported with %" PRIu32 " byte lines\n",
+			    base_bdev->name, opts->line_size);
+		return -EINVAL;
+	}
+
+	size = opts->cache_size != 0 ? opts->cache_size : BDEV_CACHE_DEFAULT_SIZE;
+	if (cache_bdev != NULL) {
+		if (cache_bdev->md_len != 0 || cache_bdev->blocklen != base_bdev->blocklen) {
+			SPDK_ERRLOG("Cache bdev %s must have the block size of %s\n",
+				    cache_bdev->name, base_bdev->name);
+			return -EINVAL;
+		}
+
+		size = cache_bdev->blockcnt * cache_bdev->blocklen;
+		if (opts->cache_size != 0) {
+			size = spdk_min(size, opts->cache_size);
+		}
+	}
+
+	cache->opts = *opts;
+	cache->line_size = opts->line_size;
+	cache->line_blocks = opts->line_size / base_bdev->blocklen;
+	cache->num_sets = size / opts->line_size / CACHE_WAYS;
+	cache->num_lines = cache->num_sets * CACHE_WAYS;
+	if (cache->num_sets == 0) {
+		SPDK_ERRLOG("Cache size %" PRIu64 " is too small for %" PRIu32 " byte lines\n",
+			    size, opts->line_size);
+		return -EINVAL;
+	}
+
+	cache->sets = calloc(cache->num_sets, sizeof(*cache->sets));
+	if (cache->sets == NULL) {
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < cache->num_sets; i++) {
+		pthread_spin_init(&cache->sets[i].lock, PTHREAD_PROCESS_PRIVATE);
+	}
+
+	if (opts->admission_filter) {
+		cache->sketch_width = spdk_align64pow2(spdk_max(cache->num_lines, 64));
+		cache->sketch_reset = cache->num_lines * CACHE_SKETCH_SAMPLE;
+		cache->sketch = calloc(CACHE_SKETCH_DEPTH, cache->sketch_width);
+		if (cache->sketch == NULL) {
+			return -ENOMEM;
+		}
+	}
+
+	if (cache_bdev == NULL) {
+		cache->data = calloc(cache->num_lines, cache->line_size);
+		if (cache->data == NULL) {
+			SPDK_ERRLOG("Could not allocate %" PRIu64 " bytes of cache\n", size);
+			return -ENOMEM;
+		}
+	}
+
+	return 0;
+}
+
+static int
+cache_register(struct vbdev_cache_assoc *assoc)
+{
+	struct vbdev_cache *cache;
+	struct spdk_bdev *bdev;
+	struct spdk_uuid ns_uuid;
+	int rc;
+
+	if (spdk_bdev_get_by_name(assoc->vbdev_name) != NULL) {
+		return -EEXIST;
+	}
+
+	cache = calloc(1, sizeof(*cache));
+	if (cache == NULL) {
+		return -ENOMEM;
+	}
+
+	pthread_mutex_init(&cache->mutex, NULL);
+	TAILQ_INIT(&cache->channels);
+
+	cache->bdev.name = strdup(assoc->vbdev_name);
+	if (cache->bdev.name == NULL) {
+		cache_free(cache);
+		return -ENOMEM;
+	}
+
+	rc = spdk_bdev_open_ext(assoc->bdev_name, true, vbdev_cache_base_bdev_event_cb, NULL,
+				&cache->base_desc);
+	if (rc != 0) {
+		if (rc != -ENODEV) {
+			SPDK_ERRLOG("Could not open bdev %s\n", assoc->bdev_name);
+		}
+		cache_free(cache);
+		return rc;
+	}
+	cache->base_bdev = spdk_bdev_desc_get_bdev(cache->base_desc);
+
+	if (assoc->cache_bdev_name != NULL) {
+		rc = spdk_bdev_open_ext(assoc->cache_bdev_name, true,
+					vbdev_cache_base_bdev_event_cb, NULL, &cache->cache_desc);
+		if (rc != 0) {
+			if (rc != -ENODEV) {
+				SPDK_ERRLOG("Could not open bdev %s\n", assoc->cache_bdev_name);
+			}
+			goto err_close;
+		}
+		cache->cache_bdev = spdk_bdev_desc_get_bdev(cache->cache_desc);
+	}
+
+	rc = cache_alloc(cache, assoc->opts);
+	if (rc != 0) {
+		goto err_close;
+	}
+
+	bdev = cache->base_bdev;
+	spdk_uuid_parse(&ns_uuid, BDEV_CACHE_NAMESPACE_UUID);
+	rc = spdk_uuid_generate_sha1(&cache->bdev.uuid, &ns_uuid, (const char *)&bdev->uuid,
+				     sizeof(struct spdk_uuid));
+	if (rc != 0) {
+		SPDK_ERRLOG("Unable to generate new UUID for cache bdev\n");
+		goto err_close;
+	}
+
+	cache->bdev.product_name = "cache";
+	cache->bdev.write_cache = bdev->write_cache;
+	cache->bdev.required_alignment = bdev->required_alignment;
+	cache->bdev.optimal_io_boundary = bdev->optimal_io_boundary;
+	cache->bdev.blocklen = bdev->blocklen;
+	cache->bdev.blockcnt = bdev->blockcnt;
+	cache->bdev.numa = bdev->numa;
+	cache->bdev.ctxt = cache;
+	cache->bdev.fn_table = &vbdev_cache_fn_table;
+	cache->bdev.module = &cache_if;
+	cache->thread = spdk_get_thread();
+
+	rc = spdk_bdev_module_claim_bdev(bdev, cache->base_desc, &cache_if);
+	if (rc != 0) {
+		SPDK_ERRLOG("Could not claim bdev %s\n", bdev->name);
+		goto err_close;
+	}
+
+	if (cache->cache_bdev != NULL) {
+		rc = spdk_bdev_module_claim_bdev(cache->cache_bdev, cache->cache_desc, &cache_if);
+		if (rc != 0) {
+			SPDK_ERRLOG("Could not claim bdev %s\n", cache->cache_bdev->name);
+			goto err_release;
+		}
+	}
+
+	spdk_io_device_register(cache, cache_ch_create_cb, cache_ch_destroy_cb,
+				sizeof(struct cache_io_channel), assoc->vbdev_name);
+	TAILQ_INSERT_TAIL(&g_cache_nodes, cache, link);
+
+	rc = spdk_bdev_register(&cache->bdev);
+	if (rc != 0) {
+		SPDK_ERRLOG("Could not register cache bdev %s\n", assoc->vbdev_name);
+		TAILQ_REMOVE(&g_cache_nodes, cache, link);
+		spdk_io_device_unregister(cache, NULL);
+		if (cache->cache_bdev != NULL) {
+			spdk_bdev_module_release_bdev(cache->cache_bdev);
+		}
+		goto err_release;
+	}
+
+	SPDK_NOTICELOG("Created cache bdev %s on %s with %" PRIu64 " lines in %s\n",
+		       assoc->vbdev_name, assoc->bdev_name, cache->num_lines,
+		       assoc->cache_bdev_name != NULL ? assoc->cache_bdev_name : "DRAM");
+
+	return 0;
+
+err_release:
+	spdk_bdev_module_release_bdev(cache->base_bdev);
+err_close:
+	if (cache->cache_desc != NULL) {
+		spdk_bdev_close(cache->cache_desc);
+	}
+	spdk_bdev_close(cache->base_desc);
+	cache_free(cache);
+
+	return rc;
+}
+
+void
+bdev_cache_get_default_opts(struct bdev_cache_opts *opts)
+{
+	memset(opts, 0, sizeof(*opts));
+	opts->line_size = BDEV_CACHE_DEFAULT_LINE_SIZE;
+	opts->mode = BDEV_CACHE_MODE_WRITE_THROUGH;
+	opts->admission_filter = true;
+}
+
+int
+bdev_cache_create_disk(const char *bdev_name, const char *cache_bdev_name,
+		       const char *vbdev_name, const struct bdev_cache_opts *opts)
+{
+	struct vbdev_cache_assoc *assoc;
+	int rc;
+
+	if (!spdk_u32_is_pow2(opts->line_size) || opts->line_size < 512 ||
+	    opts->line_size > CACHE_MAX_LINE_SIZE) {
+		SPDK_ERRLOG("Line size %" PRIu32 " is not supported\n", opts->line_size);
+		return -EINVAL;
+	}
+
+	if (opts->mode != BDEV_CACHE_MODE_WRITE_THROUGH &&
+	    opts->mode != BDEV_CACHE_MODE_WRITE_AROUND) {
+		SPDK_ERRLOG("Invalid cache mode %d\n", opts->mode);
+		return -EINVAL;
+	}
+
+	if (cache_bdev_name != NULL && strcmp(cache_bdev_name, bdev_name) == 0) {
+		SPDK_ERRLOG("Bdev %s cannot cache itself\n", bdev_name);
+		return -EINVAL;
+	}
+
+	rc = vbdev_cache_assoc_add(&g_cache_assocs, vbdev_name, bdev_name, cache_bdev_name, opts,
+				   sizeof(*opts), &assoc);
+	if (rc == -EEXIST) {
+		SPDK_ERRLOG("Cache bdev %s already exists\n", vbdev_name);
+	}
+	if (rc != 0) {
+		return rc;
+	}
+
+	rc = cache_register(assoc);
+	if (rc == -ENODEV) {
+		SPDK_NOTICELOG("Cache bdev %s creation deferred pending bdev arrival\n",
+			       vbdev_name);
+		return 0;
+	}
+
+	if (rc != 0) {
+		vbdev_cache_assoc_remove(&g_cache_assocs, assoc);
+	}
+
+	return rc;
+}
+
+void
+bdev_cache_delete_disk(const char *bdev_name, spdk_bdev_unregister_cb cb_fn, void *cb_arg)
+{
+	vbdev_cache_delete_disk(&g_cache_assocs, &cache_if, bdev_name, cb_fn, cb_arg);
+}
+
+int
+bdev_cache_get_stats(const char *bdev_name, bdev_cache_stats_cb cb_fn, void *cb_arg)
+{
+	struct vbdev_cache *cache;
+	struct bdev_cache_stats stats;
+	bool found = false;
+
+	TAILQ_FOREACH(cache, &g_cache_nodes, link) {
+		if (bdev_name != NULL && strcmp(bdev_name, cache->bdev.name) != 0) {
+			continue;
+		}
+
+		cache_get_stats(cache, &stats);
+		cb_fn(cb_arg, cache->bdev.name, &stats);
+		found = true;
+	}
+
+	return (bdev_name == NULL || found) ? 0 : -ENODEV;
+}
+
+static void
+vbdev_cache_examine(struct spdk_bdev *bdev)
+{
+	struct vbdev_cache_assoc *assoc;
+
+	TAILQ_FOREACH(assoc, &g_cache_assocs, link) {
+		if (vbdev_cache_assoc_uses(assoc, bdev->name)) {
+			cache_register(assoc);
+		}
+	}
+
+	spdk_bdev_module_examine_done(&cache_if);
+}
+
+static int
+vbdev_cache_init(void)
+{
+	return 0;
+}
+
+static void
+vbdev_cache_finish(void)
+{
+	vbdev_cache_assoc_clear(&g_cache_assocs);
+}
+
+static int
+vbdev_cache_get_ctx_size(void)
+{
+	return sizeof(struct cache_bdev_io);
+}
+
+SPDK_LOG_REGISTER_COMPONENT(vbdev_cache)
@@ -0,0 +1,102 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#ifndef SPDK_VBDEV_CACHE_H
+#define SPDK_VBDEV_CACHE_H
+
+#include "spdk/stdinc.h"
+
+#include "spdk/bdev.h"
+#include "spdk/bdev_module.h"
+
+#define BDEV_CACHE_DEFAULT_SIZE		(64 * 1024 * 1024)
+#define BDEV_CACHE_DEFAULT_LINE_SIZE	4096
+
+enum bdev_cache_mode {
+	/* Written lines are stored in the cache once the base bdev write completes */
+	BDEV_CACHE_MODE_WRITE_THROUGH,
+	/* Written lines are only dropped from the cache */
+	BDEV_CACHE_MODE_WRITE_AROUND,
+};
+
+struct bdev_cache_opts {
+	/* Cache capacity in bytes, 0 for the default DRAM size or the whole cache bdev */
+	uint64_t		cache_size;
+	/* Size of the cache lines in bytes, a power of two and a multiple of the block size */
+	uint32_t		line_size;
+	enum bdev_cache_mode	mode;
+	/* Admit a missed line only if it is used more often than the line it replaces */
+	bool			admission_filter;
+};
+
+struct bdev_cache_stats {
+	/* Lines the cache can hold and lines currently held */
+	uint64_t capacity_lines;
+	uint64_t cached_lines;
+	/* Reads served from the cache, from the base bdev, and passed to the base bdev
+	 * without a lookup because they span too many lines
+	 */
+	uint64_t read_hits;
+	uint64_t read_misses;
+	uint64_t read_bypassed;
+	uint64_t writes;
+	/* Lines inserted into the cache and missed lines turned down by the admission filter */
+	uint64_t lines_admitted;
+	uint64_t lines_rejected;
+	/* Lines replaced to make room and lines dropped because they were written */
+	uint64_t lines_evicted;
+	uint64_t lines_invalidated;
+	/* Time spent in reads served from the cache and from the base bdev, in ticks */
+	uint64_t hit_ticks;
+	uint64_t miss_ticks;
+};
+
+typedef void (*bdev_cache_stats_cb)(void *cb_arg, const char *name,
+				    const struct bdev_cache_stats *stats);
+
+/**
+ * Initialize cache bdev options with default values.
+ *
+ * \param opts Options to initialize.
+ */
+void bdev_cache_get_default_opts(struct bdev_cache_opts *opts);
+
+/**
+ * Create a cache bdev on top of a base bdev.
+ *
+ * The cache is volatile: its contents are lost when the cache bdev is deleted or
+ * the application exits. If the base bdev or the cache bdev do not exist yet, the
+ * cache bdev is created once both of them appear.
+ *
+ * \param bdev_name Base bdev name.
+ * \param cache_bdev_name Name of the bdev holding the cached data, NULL to keep
+ * it in DRAM.
+ * \param vbdev_name Name of the cache bdev.
+ * \param opts Cache bdev options.
+ * \return 0 on success, negative errno on failure.
+ */
+int bdev_cache_create_disk(const char *bdev_name, const char *cache_bdev_name,
+			   const char *vbdev_name, const struct bdev_cache_opts *opts);
+
+/**
+ * Delete cache bdev.
+ *
+ * \param bdev_name Name of the cache bdev.
+ * \param cb_fn Function to call after deletion.
+ * \param cb_arg Argument to pass to cb_fn.
+ */
+void bdev_cache_delete_disk(const char *bdev_name, spdk_bdev_unregister_cb cb_fn, void *cb_arg);
+
+/**
+ * Get statistics of cache bdevs.
+ *
+ * \param bdev_name Name of the cache bdev or NULL to report all of them.
+ * \param cb_fn Function called synchronously for each reported bdev.
+ * \param cb_arg Argument to pass to cb_fn.
+ * \return 0 on success, -ENODEV if bdev_name is not a cache bdev.
+ */
+int bdev_cache_get_stats(const char *bdev_name, bdev_cache_stats_cb cb_fn, void *cb_arg);
+
+#endif /* SPDK_VBDEV_CACHE_H */
@@ -0,0 +1,274 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+/*
+ * Plumbing shared by the caching virtual bdevs: the configured bdevs waiting for the bdevs
+ * they are built on, and the I/Os passed through to the base bdev. The cache and readahead
+ * modules are separate libraries linked as whole archives, so the helpers are inline and
+ * each library carries its own copy.
+ */
+
+#ifndef SPDK_VBDEV_CACHE_COMMON_H
+#define SPDK_VBDEV_CACHE_COMMON_H
+
+#include "spdk/stdinc.h"
+
+#include "spdk/bdev.h"
+#include "spdk/bdev_module.h"
+#include "spdk/log.h"
+#include "spdk/queue.h"
+#include "spdk/string.h"
+
+/* Virtual bdev to create once its base bdev, and its cache bdev if any, show up */
+struct vbdev_cache_assoc {
+	char				*vbdev_name;
+	char				*bdev_name;
+	char				*cache_bdev_name;
+	/* Module specific options, copied after the structure */
+	void				*opts;
+	TAILQ_ENTRY(vbdev_cache_assoc)	link;
+};
+
+TAILQ_HEAD(vbdev_cache_assoc_list, vbdev_cache_assoc);
+
+static inline void
+vbdev_cache_assoc_free(struct vbdev_cache_assoc *assoc)
+{
+	free(assoc->vbdev_name);
+	free(assoc->bdev_name);
+	free(assoc->cache_bdev_name);
+	free(assoc);
+}
+
+static inline struct vbdev_cache_assoc *
+vbdev_cache_assoc_find(struct vbdev_cache_assoc_list *list, const char *vbdev_name)
+{
+	struct vbdev_cache_assoc *assoc;
+
+	TAILQ_FOREACH(assoc, list, link) {
+		if (strcmp(assoc->vbdev_name, vbdev_name) == 0) {
+			return assoc;
+		}
+	}
+
+	return NULL;
+}
+
+/* Returns -EEXIST if an association of the same virtual bdev is already on the list */
+static inline int
+vbdev_cache_assoc_add(struct vbdev_cache_assoc_list *list, const char *vbdev_name,
+		      const char *bdev_name, const char *cache_bdev_name, const void *opts,
+		      size_t opts_size, struct vbdev_cache_assoc **_assoc)
+{
+	struct vbdev_cache_assoc *assoc;
+
+	if (vbdev_cache_assoc_find(list, vbdev_name) != NULL) {
+		return -EEXIST;
+	}
+
+	assoc = calloc(1, sizeof(*assoc) + opts_size);
+	if (assoc == NULL) {
+		return -ENOMEM;
+	}
+
+	assoc->vbdev_name = strdup(vbdev_name);
+	assoc->bdev_name = strdup(bdev_name);
+	assoc->cache_bdev_name = cache_bdev_name != NULL ? strdup(cache_bdev_name) : NULL;
+	if (assoc->vbdev_name == NULL || assoc->bdev_name == NULL ||
+	    (cache_bdev_name != NULL && assoc->cache_bdev_name == NULL)) {
+		vbdev_cache_assoc_free(assoc);
+		return -ENOMEM;
+	}
+
+	assoc->opts = assoc + 1;
+	memcpy(assoc->opts, opts, opts_size);
+	TAILQ_INSERT_TAIL(list, assoc, link);
+	*_assoc = assoc;
+
+	return 0;
+}
+
+static inline void
+vbdev_cache_assoc_remove(struct vbdev_cache_assoc_list *list, struct vbdev_cache_assoc *assoc)
+{
+	TAILQ_REMOVE(list, assoc, link);
+	vbdev_cache_assoc_free(assoc);
+}
+
+static inline void
+vbdev_cache_assoc_clear(struct vbdev_cache_assoc_list *list)
+{
+	struct vbdev_cache_assoc *assoc;
+
+	while ((assoc = TAILQ_FIRST(list))) {
+		vbdev_cache_assoc_remove(list, assoc);
+	}
+}
+
+/* Whether the virtual bdev is built on the bdev */
+static inline bool
+vbdev_cache_assoc_uses(const struct vbdev_cache_assoc *assoc, const char *bdev_name)
+{
+	return strcmp(assoc->bdev_name, bdev_name) == 0 ||
+	       (assoc->cache_bdev_name != NULL && strcmp(assoc->cache_bdev_name, bdev_name) == 0);
+}
+
+/* Unregister the virtual bdev and drop its association. A virtual bdev whose creation is
+ * still pending is deleted right away.
+ */
+static inline void
+vbdev_cache_delete_disk(struct vbdev_cache_assoc_list *list, struct spdk_bdev_module *module,
+			const char *vbdev_name, spdk_bdev_unregister_cb cb_fn, void *cb_arg)
+{
+	struct vbdev_cache_assoc *assoc;
+	int rc;
+
+	rc = spdk_bdev_unregister_by_name(vbdev_name, module, cb_fn, cb_arg);
+
+	assoc = vbdev_cache_assoc_find(list, vbdev_name);
+	if (assoc != NULL && (rc == 0 || rc == -ENODEV)) {
+		vbdev_cache_assoc_remove(list, assoc);
+		if (rc == -ENODEV) {
+			/* Creation was still pending on its bdevs */
+			cb_fn(cb_arg, 0);
+			return;
+		}
+	}
+
+	if (rc != 0) {
+		cb_fn(cb_arg, rc);
+	}
+}
+
+struct vbdev_cache_io;
+
+struct vbdev_cache_io_ops {
+	/* Called once the buffer of a read is allocated */
+	void				(*read)(struct vbdev_cache_io *io);
+	/* Completion of the reads, and of the writes, unmaps and write zeroes passed to the
+	 * base bdev. Flushes and resets are completed with the status of the base bdev I/O.
+	 */
+	spdk_bdev_io_completion_cb	read_done;
+	spdk_bdev_io_completion_cb	write_done;
+};
+
+/* First member of the driver context of the virtual bdev I/Os */
+struct vbdev_cache_io {
+	const struct vbdev_cache_io_ops	*ops;
+	struct spdk_bdev_desc		*base_desc;
+	struct spdk_io_channel		*base_ch;
+	struct spdk_bdev_io_wait_entry	bdev_io_wait;
+};
+
+static inline void
+vbdev_cache_io_init(struct vbdev_cache_io *io, const struct vbdev_cache_io_ops *ops,
+		    struct spdk_bdev_desc *base_desc, struct spdk_io_channel *base_ch)
+{
+	io->ops = ops;
+	io->base_desc = base_desc;
+	io->base_ch = base_ch;
+}
+
+static inline void
+vbdev_cache_read_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io,
+			    bool success)
+{
+	struct vbdev_cache_io *io = (struct vbdev_cache_io *)bdev_io->driver_ctx;
+
+	if (!success) {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	io->ops->read(io);
+}
+
+/* Allocate the buffer of a read if needed and call the read function of the I/O */
+static inline void
+vbdev_cache_io_read(struct vbdev_cache_io *io)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+
+	spdk_bdev_io_get_buf(bdev_io, vbdev_cache_read_get_buf_cb,
+			     bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen);
+}
+
+static inline void
+vbdev_cache_base_done(struct spdk_bdev_io *base_io, bool success, void *cb_arg)
+{
+	struct vbdev_cache_io *io = cb_arg;
+
+	spdk_bdev_io_complete_base_io_status(spdk_bdev_io_from_ctx(io), base_io);
+	spdk_bdev_free_io(base_io);
+}
+
+static inline void vbdev_cache_io_submit_base(struct vbdev_cache_io *io);
+
+static inline void
+vbdev_cache_io_retry(void *arg)
+{
+	vbdev_cache_io_submit_base(arg);
+}
+
+/* Pass the I/O to the base bdev, retrying once resources are available. The completion
+ * callbacks get the I/O as argument.
+ */
+static inline void
+vbdev_cache_io_submit_base(struct vbdev_cache_io *io)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+	struct spdk_bdev *base_bdev = spdk_bdev_desc_get_bdev(io->base_desc);
+	const struct vbdev_cache_io_ops *ops = io->ops;
+	uint64_t offset_blocks = bdev_io->u.bdev.offset_blocks;
+	uint64_t num_blocks = bdev_io->u.bdev.num_blocks;
+	int rc;
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+		rc = spdk_bdev_readv_blocks(io->base_desc, io->base_ch, bdev_io->u.bdev.iovs,
+					    bdev_io->u.bdev.iovcnt, offset_blocks, num_blocks,
+					    ops->read_done, io);
+		break;
+	case SPDK_BDEV_IO_TYPE_WRITE:
+		rc = spdk_bdev_writev_blocks(io->base_desc, io->base_ch, bdev_io->u.bdev.iovs,
+					     bdev_io->u.bdev.iovcnt, offset_blocks, num_blocks,
+					     ops->write_done, io);
+		break;
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+		rc = spdk_bdev_unmap_blocks(io->base_desc, io->base_ch, offset_blocks, num_blocks,
+					    ops->write_done, io);
+		break;
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+		rc = spdk_bdev_write_zeroes_blocks(io->base_desc, io->base_ch, offset_blocks,
+						   num_blocks, ops->write_done, io);
+		break;
+	case SPDK_BDEV_IO_TYPE_FLUSH:
+		rc = spdk_bdev_flush_blocks(io->base_desc, io->base_ch, offset_blocks, num_blocks,
+					    vbdev_cache_base_done, io);
+		break;
+	case SPDK_BDEV_IO_TYPE_RESET:
+		rc = spdk_bdev_reset(io->base_desc, io->base_ch, vbdev_cache_base_done, io);
+		break;
+	default:
+		SPDK_ERRLOG("%s: unknown I/O type %d\n", bdev_io->bdev->name, bdev_io->type);
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	if (rc == -ENOMEM) {
+		io->bdev_io_wait.bdev = base_bdev;
+		io->bdev_io_wait.cb_fn = vbdev_cache_io_retry;
+		io->bdev_io_wait.cb_arg = io;
+		rc = spdk_bdev_queue_io_wait(base_bdev, io->base_ch, &io->bdev_io_wait);
+	}
+
+	if (rc != 0) {
+		SPDK_ERRLOG("Could not submit I/O to %s: %s\n", spdk_bdev_get_name(base_bdev),
+			    spdk_strerror(-rc));
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+#endif /* SPDK_VBDEV_CACHE_COMMON_H */
@@ -0,0 +1,176 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "vbdev_cache.h"
+#include "spdk/env.h"
+#include "spdk/rpc.h"
+#include "spdk/util.h"
+#include "spdk/string.h"
+#include "spdk/log.h"
+#include "spdk_internal/rpc_autogen.h"
+
+static void
+rpc_bdev_cache_create(struct spdk_jsonrpc_request *request,
+		      const struct spdk_json_val *params)
+{
+	struct rpc_bdev_cache_create_ctx req = {};
+	struct bdev_cache_opts opts;
+	struct spdk_json_write_ctx *w;
+	int rc;
+
+	bdev_cache_get_default_opts(&opts);
+	req.line_size = opts.line_size;
+	req.mode = (enum rpc_bdev_cache_mode)opts.mode;
+	req.admission_filter = opts.admission_filter;
+
+	if (spdk_json_decode_object(params, rpc_bdev_cache_create_decoders,
+				    SPDK_COUNTOF(rpc_bdev_cache_create_decoders),
+				    &req)) {
+		SPDK_DEBUGLOG(vbdev_cache, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	if (req.cache_size_mb > UINT64_MAX / (1024 * 1024)) {
+		spdk_jsonrpc_send_error_response(request, -EINVAL, spdk_strerror(EINVAL));
+		goto cleanup;
+	}
+
+	opts.cache_size = req.cache_size_mb * 1024 * 1024;
+	opts.line_size = req.line_size;
+	opts.mode = (enum bdev_cache_mode)req.mode;
+	opts.admission_filter = req.admission_filter;
+
+	rc = bdev_cache_create_disk(req.base_bdev_name, req.cache_bdev_name, req.name, &opts);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_string(w, req.name);
+	spdk_jsonrpc_end_result(request, w);
+
+cleanup:
+	free_rpc_bdev_cache_create(&req);
+}
+SPDK_RPC_REGISTER("bdev_cache_create", rpc_bdev_cache_create, SPDK_RPC_RUNTIME)
+
+static void
+rpc_bdev_cache_delete_cb(void *cb_arg, int bdeverrno)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+
+	if (bdeverrno == 0) {
+		spdk_jsonrpc_send_bool_response(request, true);
+	} else {
+		spdk_jsonrpc_send_error_response(request, bdeverrno, spdk_strerror(-bdeverrno));
+	}
+}
+
+static void
+rpc_bdev_cache_delete(struct spdk_jsonrpc_request *request,
+		      const struct spdk_json_val *params)
+{
+	struct rpc_bdev_cache_delete_ctx req = {};
+
+	if (spdk_json_decode_object(params, rpc_bdev_cache_delete_decoders,
+				    SPDK_COUNTOF(rpc_bdev_cache_delete_decoders),
+				    &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	bdev_cache_delete_disk(req.name, rpc_bdev_cache_delete_cb, request);
+
+cleanup:
+	free_rpc_bdev_cache_delete(&req);
+}
+SPDK_RPC_REGISTER("bdev_cache_delete", rpc_bdev_cache_delete, SPDK_RPC_RUNTIME)
+
+struct rpc_bdev_cache_get_stats_cb_ctx {
+	struct spdk_jsonrpc_request	*request;
+	struct spdk_json_write_ctx	*w;
+};
+
+static double
+rpc_bdev_cache_ticks_to_us(uint64_t ticks, uint64_t ops)
+{
+	return ops == 0 ? 0.0 : (double)ticks * SPDK_SEC_TO_USEC / spdk_get_ticks_hz() / ops;
+}
+
+static void
+rpc_bdev_cache_write_stats(void *cb_arg, const char *name, const struct bdev_cache_stats *stats)
+{
+	struct rpc_bdev_cache_get_stats_cb_ctx *ctx = cb_arg;
+	struct spdk_json_write_ctx *w;
+	uint64_t reads = stats->read_hits + stats->read_misses + stats->read_bypassed;
+
+	/* The result is only started once we know the request does not fail */
+	if (ctx->w == NULL) {
+		ctx->w = spdk_jsonrpc_begin_result(ctx->request);
+		spdk_json_write_array_begin(ctx->w);
+	}
+	w = ctx->w;
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "name", name);
+	spdk_json_write_named_uint64(w, "capacity_lines", stats->capacity_lines);
+	spdk_json_write_named_uint64(w, "cached_lines", stats->cached_lines);
+	spdk_json_write_named_uint64(w, "read_hits", stats->read_hits);
+	spdk_json_write_named_uint64(w, "read_misses", stats->read_misses);
+	spdk_json_write_named_uint64(w, "read_bypassed", stats->read_bypassed);
+	spdk_json_write_named_double(w, "hit_ratio", reads == 0 ? 0.0 :
+				     (double)stats->read_hits / reads);
+	spdk_json_write_named_uint64(w, "writes", stats->writes);
+	spdk_json_write_named_uint64(w, "lines_admitted", stats->lines_admitted);
+	spdk_json_write_named_uint64(w, "lines_rejected", stats->lines_rejected);
+	spdk_json_write_named_uint64(w, "lines_evicted", stats->lines_evicted);
+	spdk_json_write_named_uint64(w, "lines_invalidated", stats->lines_invalidated);
+	spdk_json_write_named_double(w, "hit_latency_us",
+				     rpc_bdev_cache_ticks_to_us(stats->hit_ticks,
+						     stats->read_hits));
+	spdk_json_write_named_double(w, "miss_latency_us",
+				     rpc_bdev_cache_ticks_to_us(stats->miss_ticks,
+						     stats->read_misses + stats->read_bypassed));
+	spdk_json_write_object_end(w);
+}
+
+static void
+rpc_bdev_cache_get_stats(struct spdk_jsonrpc_request *request,
+			 const struct spdk_json_val *params)
+{
+	struct rpc_bdev_cache_get_stats_ctx req = {};
+	struct rpc_bdev_cache_get_stats_cb_ctx ctx = { .request = request };
+	int rc;
+
+	if (params && spdk_json_decode_object(params, rpc_bdev_cache_get_stats_decoders,
+					      SPDK_COUNTOF(rpc_bdev_cache_get_stats_decoders),
+					      &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = bdev_cache_get_stats(req.name, rpc_bdev_cache_write_stats, &ctx);
+	if (rc != 0) {
+		assert(ctx.w == NULL);
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	if (ctx.w == NULL) {
+		ctx.w = spdk_jsonrpc_begin_result(request);
+		spdk_json_write_array_begin(ctx.w);
+	}
+	spdk_json_write_array_end(ctx.w);
+	spdk_jsonrpc_end_result(request, ctx.w);
+
+cleanup:
+	free_rpc_bdev_cache_get_stats(&req);
+}
+SPDK_RPC_REGISTER("bdev_cache_get_stats", rpc_bdev_cache_get_stats, SPDK_RPC_RUNTIME)
@@ -0,0 +1,1795 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+/*
+ * Compression virtual bdev.
+ *
+ * The logical address space is split into fixed size chunks that are
+ * compressed as a unit through the accel framework. The base bdev holds a
+ * superblock, a chunk map and a data region:
+ *
+ *   | superblock | map: one 16-byte entry per logical chunk | data blocks |
+ *
+ * Compressed chunks are packed into runs of contiguous data blocks, as many
+ * as the compressed size needs. A chunk that does not shrink by at least one
+ * block is stored uncompressed. A map entry with a length of 0 means the
+ * chunk is unmapped and reads as zeroes, so all-zero chunks take no space.
+ * Free data blocks are tracked by a bit pool that is rebuilt from the map
+ * when the base bdev is examined.
+ *
+ * Chunks are never overwritten in place. A write compresses the new chunk
+ * contents (merged with the old ones for partial writes) into a freshly
+ * allocated run, and the map entry is switched only after the data is on
+ * disk. The run referenced by the previous entry is freed only after the map
+ * block with the new entry has been written, so the on-disk map always points
+ * at valid data.
+ *
+ * All metadata is owned by the thread that created or loaded the bdev. I/O
+ * submitted on other threads is forwarded there and completed back on the
+ * submitting thread. I/Os touching the same chunk are serialized by a per-chunk
+ * lock that readers share.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "vbdev_compress.h"
+#include "spdk/bit_array.h"
+#include "spdk/bit_pool.h"
+#include "spdk/crc32.h"
+#include "spdk/env.h"
+#include "spdk/likely.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+#include "spdk/uuid.h"
+
+#include "spdk/bdev_module.h"
+#include "spdk/log.h"
+
+#define COMPRESS_SB_MAGIC		"SPDKCOMP"
+#define COMPRESS_SB_VERSION		1
+#define COMPRESS_SB_NAME_MAX		64
+
+#define COMPRESS_MAX_CHUNK_SIZE		(128 * 1024)
+
+/* Largest data region that can be tracked by the bit pool */
+#define COMPRESS_MAX_DATA_BLOCKS	(UINT32_MAX - 1)
+
+/* Number of chunks whose map entries are persisted and released at once */
+#define COMPRESS_BATCH_CHUNKS		1024
+
+struct compress_sb {
+	char			magic[8];
+	uint32_t		version;
+	uint32_t		block_size;
+	uint64_t		num_blocks;
+	uint32_t		chunk_size;
+	uint32_t		comp_algo;
+	uint32_t		comp_level;
+	uint32_t		reserved0;
+	uint64_t		map_offset;
+	uint64_t		map_blocks;
+	uint64_t		data_offset;
+	uint64_t		data_blocks;
+	struct spdk_uuid	uuid;
+	char			name[COMPRESS_SB_NAME_MAX];
+	uint8_t			reserved[100];
+	uint32_t		crc;
+};
+SPDK_STATIC_ASSERT(sizeof(struct compress_sb) == 256, "Incorrect size");
+
+struct compress_map_entry {
+	/* First data block of the chunk */
+	uint64_t		offset;
+	/* Bytes of compressed data, 0 if unmapped and the chunk size if stored uncompressed */
+	uint32_t		len;
+	uint32_t		reserved;
+};
+SPDK_STATIC_ASSERT(sizeof(struct compress_map_entry) == 16, "Incorrect size");
+
+/* Chunk lock: a writer, I/Os waiting for the chunk, and the number of readers */
+#define COMPRESS_LOCK_EXCL	(1u << 31)
+#define COMPRESS_LOCK_WAITERS	(1u << 30)
+
+struct vbdev_compress {
+	struct spdk_bdev		bdev;
+	struct spdk_bdev		*base_bdev;
+	struct spdk_bdev_desc		*base_desc;
+	/* Channels of the base bdev and accel, used only on the owner thread */
+	struct spdk_io_channel		*base_ch;
+	struct spdk_io_channel		*accel_ch;
+	struct spdk_thread		*thread;
+	TAILQ_ENTRY(vbdev_compress)	link;
+
+	uint32_t			block_size;
+	uint32_t			chunk_size;
+	uint32_t			chunk_blocks;
+	uint32_t			entries_per_block;
+	enum spdk_accel_comp_algo	comp_algo;
+	uint32_t			comp_level;
+	uint64_t			num_chunks;
+	uint64_t			map_offset;
+	uint64_t			map_blocks;
+	uint64_t			data_offset;
+	uint32_t			data_blocks;
+
+	/* Chunk map, kept in a DMA buffer so map blocks are written straight from it */
+	struct spdk_bdev_map		*base_map;
+	struct compress_map_entry	*map;
+
+	/* Per chunk lock words and the I/Os waiting for a lock */
+	uint32_t			*locks;
+	TAILQ_HEAD(, compress_bdev_io)	blocked;
+	struct spdk_bit_pool		*pool;
+
+	/* Cached bounce buffers, linked through their first bytes */
+	void				*bufs;
+
+	struct bdev_compress_stats	stats;
+};
+
+static TAILQ_HEAD(, vbdev_compress) g_compress_nodes = TAILQ_HEAD_INITIALIZER(g_compress_nodes);
+
+struct compress_bdev_io {
+	struct vbdev_compress		*comp;
+	enum spdk_bdev_io_status	status;
+	/* Chunk being processed and one past the last chunk of the request */
+	uint64_t			chunk;
+	uint64_t			end;
+	/* First chunk of the batch whose map updates are pending */
+	uint64_t			batch;
+	/* Lock mode wanted or held on the current chunk */
+	bool				excl;
+	bool				locked;
+	/* Byte range of the current chunk covered by the request */
+	uint32_t			offset;
+	uint32_t			len;
+	/* Entry of the current chunk being written */
+	struct compress_map_entry	entry;
+	uint32_t			output_size;
+	uint64_t			tsc;
+	/* Two chunks: uncompressed data and compressed data */
+	void				*buf;
+	struct iovec			iov;
+	struct iovec			comp_iov;
+	/* Data written for the current chunk, either the request buffers or iov */
+	struct iovec			*src_iovs;
+	int				src_iovcnt;
+	/* Request buffers covering the current chunk */
+	struct iovec			*iovs;
+	int				iovcnt;
+	/* Previous map entries of the batch, released once the batch is persisted */
+	struct compress_map_entry	*old;
+	struct spdk_bdev_map_ctx	map_ctx;
+	struct spdk_bdev_io_wait_entry	bdev_io_wait;
+	TAILQ_ENTRY(compress_bdev_io)	link;
+};
+
+struct compress_init_ctx {
+	struct vbdev_compress		*comp;
+	struct compress_sb		sb;
+	bool				create;
+	void				*buf;
+	bdev_compress_create_cb		cb_fn;
+	void				*cb_arg;
+	struct spdk_bdev_io_wait_entry	bdev_io_wait;
+};
+
+static int vbdev_compress_init(void);
+static int vbdev_compress_get_ctx_size(void);
+static void vbdev_compress_examine_disk(struct spdk_bdev *bdev);
+
+static struct spdk_bdev_module compress_if = {
+	.name = "compress",
+	.module_init = vbdev_compress_init,
+	.get_ctx_size = vbdev_compress_get_ctx_size,
+	.examine_disk = vbdev_compress_examine_disk,
+};
+
+SPDK_BDEV_MODULE_REGISTER(compress, &compress_if)
+
+static void compress_write_continue(struct compress_bdev_io *io);
+static void compress_read_continue(struct compress_bdev_io *io);
+static void compress_io_resume(struct compress_bdev_io *io);
+
+static const char *
+compress_algo_name(enum spdk_accel_comp_algo algo)
+{
+	switch (algo) {
+	case SPDK_ACCEL_COMP_ALGO_DEFLATE:
+		return "deflate";
+	case SPDK_ACCEL_COMP_ALGO_LZ4:
+		return "lz4";
+	default:
+		return "unknown";
+	}
+}
+
+static uint32_t
+compress_sb_crc(const struct compress_sb *sb)
+{
+	return spdk_crc32c_update(sb, offsetof(struct compress_sb, crc), ~0);
+}
+
+static void *
+compress_get_buf(struct vbdev_compress *comp)
+{
+	void *buf = comp->bufs;
+
+	if (buf != NULL) {
+		comp->bufs = *(void **)buf;
+		return buf;
+	}
+
+	return spdk_dma_malloc(2 * comp->chunk_size, spdk_bdev_get_buf_align(comp->base_bdev),
+			       NULL);
+}
+
+static void
+compress_put_buf(struct vbdev_compress *comp, void *buf)
+{
+	*(void **)buf = comp->bufs;
+	comp->bufs = buf;
+}
+
+static inline uint32_t
+compress_entry_blocks(struct vbdev_compress *comp, const struct compress_map_entry *entry)
+{
+	return spdk_divide_round_up(entry->len, comp->block_size);
+}
+
+static void
+compress_free_run(struct vbdev_compress *comp, const struct compress_map_entry *entry)
+{
+	uint32_t num_blocks = compress_entry_blocks(comp, entry);
+
+	spdk_bit_pool_free_run(comp->pool, entry->offset, num_blocks);
+	comp->stats.used_blocks -= num_blocks;
+}
+
+/* Chunk locks */
+
+static inline bool
+compress_lock_available(uint32_t word, bool excl)
+{
+	return excl ? (word & ~COMPRESS_LOCK_WAITERS) == 0 : !(word & COMPRESS_LOCK_EXCL);
+}
+
+static inline uint32_t
+compress_lock_acquire(uint32_t word, bool excl)
+{
+	return excl ? word | COMPRESS_LOCK_EXCL : word + 1;
+}
+
+/* Lock the current chunk of the request. If the chunk is busy, or other I/Os already
+ * wait for it, the request is queued and resumed once it gets the lock.
+ */
+static bool
+compress_chunk_lock(struct compress_bdev_io *io, bool excl)
+{
+	struct vbdev_compress *comp = io->comp;
+	uint32_t *word = &comp->locks[io->chunk];
+
+	io->excl = excl;
+
+	if (!(*word & COMPRESS_LOCK_WAITERS) && compress_lock_available(*word, excl)) {
+		*word = compress_lock_acquire(*word, excl);
+		io->locked = true;
+		return true;
+	}
+
+	*word |= COMPRESS_LOCK_WAITERS;
+	TAILQ_INSERT_TAIL(&comp->blocked, io, link);
+
+	return false;
+}
+
+static void
+compress_chunk_wake(struct vbdev_compress *comp, uint64_t chunk)
+{
+	TAILQ_HEAD(, compress_bdev_io) ready = TAILQ_HEAD_INITIALIZER(ready);
+	struct compress_bdev_io *io, *tmp;
+	uint32_t *word = &comp->locks[chunk];
+	bool waiting = false;
+
+	*word &= ~COMPRESS_LOCK_WAITERS;
+
+	/* Grant the lock in arrival order, stopping at the first I/O that has to wait */
+	TAILQ_FOREACH_SAFE(io, &comp->blocked, link, tmp) {
+		if (io->chunk != chunk) {
+			continue;
+		}
+
+		if (!waiting && compress_lock_available(*word, io->excl)) {
+			*word = compress_lock_acquire(*word, io->excl);
+			io->locked = true;
+			TAILQ_REMOVE(&comp->blocked, io, link);
+			TAILQ_INSERT_TAIL(&ready, io, link);
+		} else {
+			waiting = true;
+		}
+	}
+
+	if (waiting) {
+		*word |= COMPRESS_LOCK_WAITERS;
+	}
+
+	while ((io = TAILQ_FIRST(&ready)) != NULL) {
+		TAILQ_REMOVE(&ready, io, link);
+		compress_io_resume(io);
+	}
+}
+
+static void
+compress_chunk_unlock(struct compress_bdev_io *io)
+{
+	struct vbdev_compress *comp = io->comp;
+	uint32_t *word = &comp->locks[io->chunk];
+
+	if (!io->locked) {
+		return;
+	}
+
+	io->locked = false;
+	*word = io->excl ? *word & ~COMPRESS_LOCK_EXCL : *word - 1;
+
+	if ((*word & COMPRESS_LOCK_WAITERS) && compress_lock_available(*word, true)) {
+		compress_chunk_wake(comp, io->chunk);
+	}
+}
+
+/* Chunk map */
+
+static struct compress_map_entry
+compress_map_set(struct vbdev_compress *comp, uint64_t chunk,
+		 const struct compress_map_entry *entry)
+{
+	struct compress_map_entry old = comp->map[chunk];
+
+	if (old.len == 0 && entry->len == 0) {
+		return old;
+	}
+
+	if (old.len == 0) {
+		comp->stats.mapped_blocks += comp->chunk_blocks;
+	} else if (entry->len == 0) {
+		comp->stats.mapped_blocks -= comp->chunk_blocks;
+	}
+
+	comp->map[chunk] = *entry;
+	spdk_bdev_map_update(comp->base_map, chunk / comp->entries_per_block);
+
+	return old;
+}
+
+static void
+_compress_io_complete(void *ctx)
+{
+	struct spdk_bdev_io *bdev_io = ctx;
+	struct compress_bdev_io *io = (struct compress_bdev_io *)bdev_io->driver_ctx;
+
+	spdk_bdev_io_complete(bdev_io, io->status);
+}
+
+static void
+compress_io_complete(struct compress_bdev_io *io, enum spdk_bdev_io_status status)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+	struct spdk_thread *thread = spdk_bdev_io_get_thread(bdev_io);
+
+	compress_chunk_unlock(io);
+
+	if (io->buf != NULL) {
+		compress_put_buf(io->comp, io->buf);
+		io->buf = NULL;
+	}
+	free(io->old);
+	io->old = NULL;
+	free(io->iovs);
+	io->iovs = NULL;
+
+	if (io->status == SPDK_BDEV_IO_STATUS_SUCCESS) {
+		io->status = status;
+	}
+
+	if (thread == spdk_get_thread()) {
+		spdk_bdev_io_complete(bdev_io, io->status);
+	} else {
+		spdk_thread_send_msg(thread, _compress_io_complete, bdev_io);
+	}
+}
+
+static int
+compress_queue_io(struct compress_bdev_io *io, spdk_bdev_io_wait_cb cb_fn)
+{
+	struct vbdev_compress *comp = io->comp;
+
+	io->bdev_io_wait.bdev = comp->base_bdev;
+	io->bdev_io_wait.cb_fn = cb_fn;
+	io->bdev_io_wait.cb_arg = io;
+
+	return spdk_bdev_queue_io_wait(comp->base_bdev, comp->base_ch, &io->bdev_io_wait);
+}
+
+static void
+compress_batch_done(struct compress_bdev_io *io, bool release)
+{
+	struct vbdev_compress *comp = io->comp;
+	uint64_t i;
+
+	/* If the map could not be written, the old entries may still be referenced
+	 * on disk so their runs stay allocated until the map is reloaded.
+	 */
+	for (i = 0; release && i < io->chunk - io->batch; i++) {
+		if (io->old[i].len != 0) {
+			compress_free_run(comp, &io->old[i]);
+		}
+	}
+
+	if (!release) {
+		io->status = SPDK_BDEV_IO_STATUS_FAILED;
+	}
+
+	io->batch = io->chunk;
+
+	if (io->status != SPDK_BDEV_IO_STATUS_SUCCESS || io->chunk == io->end) {
+		compress_io_complete(io, io->status);
+	} else {
+		compress_write_continue(io);
+	}
+}
+
+/* Wait until the map updates of the current batch are persisted, then free the runs
+ * referenced by the previous entries.
+ */
+static void
+compress_batch_persisted(void *cb_arg, int rc)
+{
+	compress_batch_done(cb_arg, rc == 0);
+}
+
+static void
+compress_batch_persist(struct compress_bdev_io *io)
+{
+	struct vbdev_compress *comp = io->comp;
+	uint64_t first, last;
+
+	if (io->chunk == io->batch) {
+		compress_batch_done(io, true);
+		return;
+	}
+
+	first = io->batch / comp->entries_per_block;
+	last = (io->chunk - 1) / comp->entries_per_block;
+
+	spdk_bdev_map_persist(comp->base_map, &io->map_ctx, first, last, compress_batch_persisted,
+			      io);
+}
+
+/* Request buffers and range of the current chunk */
+
+static bool
+compress_iovs_all_zero(struct iovec *iovs, int iovcnt)
+{
+	int i;
+
+	for (i = 0; i < iovcnt; i++) {
+		if (!spdk_mem_all_zero(iovs[i].iov_base, iovs[i].iov_len)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void
+compress_io_range(struct compress_bdev_io *io)
+{
+	struct vbdev_compress *comp = io->comp;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+	uint64_t start = bdev_io->u.bdev.offset_blocks;
+	uint64_t end = start + bdev_io->u.bdev.num_blocks;
+	uint64_t chunk_start = io->chunk * comp->chunk_blocks;
+	uint64_t first, last;
+
+	first = spdk_max(start, chunk_start);
+	last = spdk_min(end, chunk_start + comp->chunk_blocks);
+
+	io->offset = (first - chunk_start) * comp->block_size;
+	io->len = (last - first) * comp->block_size;
+
+	if (bdev_io->u.bdev.iovcnt != 0) {
+		io->iovcnt = spdk_iov_slice(bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
+					    (first - start) * comp->block_size, io->len, io->iovs);
+	}
+}
+
+/* Decompress the current chunk, read into the second half of the buffer */
+static int
+compress_decompress(struct compress_bdev_io *io, struct iovec *iovs, int iovcnt,
+		    spdk_accel_completion_cb cb_fn)
+{
+	struct vbdev_compress *comp = io->comp;
+
+	io->comp_iov.iov_base = (uint8_t *)io->buf + comp->chunk_size;
+	io->comp_iov.iov_len = comp->map[io->chunk].len;
+	io->tsc = spdk_get_ticks();
+
+	return spdk_accel_submit_decompress_ext(comp->accel_ch, iovs, iovcnt, &io->comp_iov, 1,
+						comp->comp_algo, &io->output_size, cb_fn, io);
+}
+
+static bool
+compress_decompress_done(struct compress_bdev_io *io, int status)
+{
+	struct vbdev_compress *comp = io->comp;
+
+	comp->stats.decompress_ops++;
+	comp->stats.decompress_ticks += spdk_get_ticks() - io->tsc;
+
+	if (status != 0 || io->output_size != comp->chunk_size) {
+		SPDK_ERRLOG("Failed to decompress chunk %" PRIu64 " of %s, rc=%d\n", io->chunk,
+			    comp->bdev.name, status);
+		return false;
+	}
+
+	return true;
+}
+
+/* Write path, also used by unmap and write zeroes */
+
+static void
+compress_write_fail(struct compress_bdev_io *io, enum spdk_bdev_io_status status)
+{
+	/* Chunks already remapped by this request still need their map updates persisted
+	 * so that their previous runs can be freed.
+	 */
+	compress_chunk_unlock(io);
+	io->status = status;
+	compress_batch_persist(io);
+}
+
+static void
+compress_write_set(struct compress_bdev_io *io, const struct compress_map_entry *entry)
+{
+	io->old[io->chunk - io->batch] = compress_map_set(io->comp, io->chunk, entry);
+	compress_chunk_unlock(io);
+	io->chunk++;
+}
+
+static void
+compress_write_data_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct compress_bdev_io *io = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		compress_free_run(io->comp, &io->entry);
+		compress_write_fail(io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	compress_write_set(io, &io->entry);
+	compress_write_continue(io);
+}
+
+static void
+compress_write_data(void *arg)
+{
+	struct compress_bdev_io *io = arg;
+	struct vbdev_compress *comp = io->comp;
+	int rc;
+
+	rc = spdk_bdev_writev_blocks(comp->base_desc, comp->base_ch, io->src_iovs, io->src_iovcnt,
+				     comp->data_offset + io->entry.offset,
+				     compress_entry_blocks(comp, &io->entry),
+				     compress_write_data_done, io);
+	if (rc == -ENOMEM) {
+		rc = compress_queue_io(io, compress_write_data);
+	}
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to submit data write of %s, rc=%d\n", comp->bdev.name, rc);
+		compress_free_run(comp, &io->entry);
+		compress_write_fail(io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+static void
+compress_write_alloc(struct compress_bdev_io *io)
+{
+	struct vbdev_compress *comp = io->comp;
+	uint32_t num_blocks = compress_entry_blocks(comp, &io->entry);
+	uint32_t offset;
+
+	offset = spdk_bit_pool_allocate_run(comp->pool, num_blocks);
+	if (offset == UINT32_MAX) {
+		SPDK_ERRLOG("%s is out of space\n", comp->bdev.name);
+		compress_write_fail(io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	comp->stats.used_blocks += num_blocks;
+	io->entry.offset = offset;
+	compress_write_data(io);
+}
+
+static void
+compress_write_compress_done(void *cb_arg, int status)
+{
+	struct compress_bdev_io *io = cb_arg;
+	struct vbdev_compress *comp = io->comp;
+	uint8_t *comp_buf = (uint8_t *)io->buf + comp->chunk_size;
+	uint32_t num_blocks;
+
+	comp->stats.compress_ops++;
+	comp->stats.compress_ticks += spdk_get_ticks() - io->tsc;
+	comp->stats.compress_bytes_in += comp->chunk_size;
+
+	memset(&io->entry, 0, sizeof(io->entry));
+
+	/* The output buffer is a block short of a chunk, so compression either saves at
+	 * least one block or fails and the chunk is stored as is.
+	 */
+	if (status == 0 && io->output_size > 0 && io->output_size < comp->chunk_size) {
+		io->entry.len = io->output_size;
+		num_blocks = compress_entry_blocks(comp, &io->entry);
+		memset(comp_buf + io->output_size, 0,
+		       num_blocks * comp->block_size - io->output_size);
+
+		io->iov.iov_base = comp_buf;
+		io->iov.iov_len = num_blocks * comp->block_size;
+		io->src_iovs = &io->iov;
+		io->src_iovcnt = 1;
+	} else {
+		io->entry.len = comp->chunk_size;
+		comp->stats.incompressible_writes++;
+	}
+
+	comp->stats.compress_bytes_out += io->entry.len;
+	compress_write_alloc(io);
+}
+
+static void
+compress_write_compress(struct compress_bdev_io *io)
+{
+	struct vbdev_compress *comp = io->comp;
+	int rc;
+
+	io->tsc = spdk_get_ticks();
+	rc = spdk_accel_submit_compress_ext(comp->accel_ch, (uint8_t *)io->buf + comp->chunk_size,
+					    comp->chunk_size - comp->block_size, io->src_iovs,
+					    io->src_iovcnt, comp->comp_algo, comp->comp_level,
+					    &io->output_size, compress_write_compress_done, io);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to submit compress of %s, rc=%d\n", comp->bdev.name, rc);
+		compress_write_fail(io, rc == -ENOMEM ? SPDK_BDEV_IO_STATUS_NOMEM :
+				    SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+/* Merge the request into the previous chunk contents held in the buffer */
+static bool
+compress_write_merge(struct compress_bdev_io *io)
+{
+	struct vbdev_compress *comp = io->comp;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+	struct compress_map_entry zero = {};
+	struct iovec iov;
+
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE) {
+		iov.iov_base = (uint8_t *)io->buf + io->offset;
+		iov.iov_len = io->len;
+		spdk_iovcpy(io->iovs, io->iovcnt, &iov, 1);
+	} else {
+		memset((uint8_t *)io->buf + io->offset, 0, io->len);
+	}
+
+	if (spdk_mem_all_zero(io->buf, comp->chunk_size)) {
+		compress_write_set(io, &zero);
+		return true;
+	}
+
+	io->iov.iov_base = io->buf;
+	io->iov.iov_len = comp->chunk_size;
+	io->src_iovs = &io->iov;
+	io->src_iovcnt = 1;
+	compress_write_compress(io);
+
+	return false;
+}
+
+static void
+compress_write_decompress_done(void *cb_arg, int status)
+{
+	struct compress_bdev_io *io = cb_arg;
+
+	if (!compress_decompress_done(io, status)) {
+		compress_write_fail(io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	if (compress_write_merge(io)) {
+		compress_write_continue(io);
+	}
+}
+
+static void
+compress_write_read_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct compress_bdev_io *io = cb_arg;
+	struct vbdev_compress *comp = io->comp;
+	int rc;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		compress_write_fail(io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	if (comp->map[io->chunk].len == comp->chunk_size) {
+		if (compress_write_merge(io)) {
+			compress_write_continue(io);
+		}
+		return;
+	}
+
+	io->iov.iov_base = io->buf;
+	io->iov.iov_len = comp->chunk_size;
+	rc = compress_decompress(io, &io->iov, 1, compress_write_decompress_done);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to submit decompress of %s, rc=%d\n", comp->bdev.name, rc);
+		compress_write_fail(io, rc == -ENOMEM ? SPDK_BDEV_IO_STATUS_NOMEM :
+				    SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+/* Read the previous contents of a partially written chunk */
+static void
+compress_write_read(void *arg)
+{
+	struct compress_bdev_io *io = arg;
+	struct vbdev_compress *comp = io->comp;
+	struct compress_map_entry *entry = &comp->map[io->chunk];
+	uint8_t *buf = io->buf;
+	int rc;
+
+	/* Uncompressed chunks go straight to the merge buffer */
+	if (entry->len != comp->chunk_size) {
+		buf += comp->chunk_size;
+	}
+
+	rc = spdk_bdev_read_blocks(comp->base_desc, comp->base_ch, buf,
+				   comp->data_offset + entry->offset,
+				   compress_entry_blocks(comp, entry),
+				   compress_write_read_done, io);
+	if (rc == -ENOMEM) {
+		rc = compress_queue_io(io, compress_write_read);
+	}
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to submit read of %s, rc=%d\n", comp->bdev.name, rc);
+		compress_write_fail(io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+/* Returns true if the chunk was handled without waiting for anything */
+static bool
+compress_write_chunk(struct compress_bdev_io *io)
+{
+	struct vbdev_compress *comp = io->comp;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+	struct compress_map_entry zero = {};
+	bool write = bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE;
+
+	compress_io_range(io);
+
+	if (io->len == comp->chunk_size) {
+		if (write && !compress_iovs_all_zero(io->iovs, io->iovcnt)) {
+			io->src_iovs = io->iovs;
+			io->src_iovcnt = io->iovcnt;
+			compress_write_compress(io);
+			return false;
+		}
+
+		if (write) {
+			comp->stats.zero_writes++;
+		}
+		compress_write_set(io, &zero);
+		return true;
+	}
+
+	comp->stats.partial_writes++;
+
+	if (comp->map[io->chunk].len == 0) {
+		memset(io->buf, 0, comp->chunk_size);
+		return compress_write_merge(io);
+	}
+
+	compress_write_read(io);
+
+	return false;
+}
+
+static void
+compress_write_continue(struct compress_bdev_io *io)
+{
+	while (io->chunk < io->end) {
+		if (io->chunk - io->batch == COMPRESS_BATCH_CHUNKS) {
+			compress_batch_persist(io);
+			return;
+		}
+
+		if (!compress_chunk_lock(io, true) || !compress_write_chunk(io)) {
+			return;
+		}
+	}
+
+	compress_batch_persist(io);
+}
+
+static void
+compress_write(struct compress_bdev_io *io)
+{
+	io->old = calloc(spdk_min(io->end - io->chunk, COMPRESS_BATCH_CHUNKS),
+			 sizeof(struct compress_map_entry));
+	if (io->old == NULL) {
+		compress_io_complete(io, SPDK_BDEV_IO_STATUS_NOMEM);
+		return;
+	}
+
+	compress_write_continue(io);
+}
+
+/* Read path */
+
+static void
+compress_read_next(struct compress_bdev_io *io)
+{
+	compress_chunk_unlock(io);
+	io->chunk++;
+}
+
+static void
+compress_read_decompress_done(void *cb_arg, int status)
+{
+	struct compress_bdev_io *io = cb_arg;
+	struct vbdev_compress *comp = io->comp;
+	struct iovec iov;
+
+	if (!compress_decompress_done(io, status)) {
+		compress_io_complete(io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	if (io->len != comp->chunk_size) {
+		iov.iov_base = (uint8_t *)io->buf + io->offset;
+		iov.iov_len = io->len;
+		spdk_iovcpy(&iov, 1, io->iovs, io->iovcnt);
+	}
+
+	compress_read_next(io);
+	compress_read_continue(io);
+}
+
+static void
+compress_read_data_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct compress_bdev_io *io = cb_arg;
+	struct vbdev_compress *comp = io->comp;
+	int rc;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		compress_io_complete(io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	if (comp->map[io->chunk].len == comp->chunk_size) {
+		compress_read_next(io);
+		compress_read_continue(io);
+		return;
+	}
+
+	/* Whole chunks are decompressed straight into the request buffers */
+	if (io->len == comp->chunk_size) {
+		rc = compress_decompress(io, io->iovs, io->iovcnt, compress_read_decompress_done);
+	} else {
+		io->iov.iov_base = io->buf;
+		io->iov.iov_len = comp->chunk_size;
+		rc = compress_decompress(io, &io->iov, 1, compress_read_decompress_done);
+	}
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to submit decompress of %s, rc=%d\n", comp->bdev.name, rc);
+		compress_io_complete(io, rc == -ENOMEM ? SPDK_BDEV_IO_STATUS_NOMEM :
+				     SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+static void
+compress_read_data(void *arg)
+{
+	struct compress_bdev_io *io = arg;
+	struct vbdev_compress *comp = io->comp;
+	struct compress_map_entry *entry = &comp->map[io->chunk];
+	int rc;
+
+	if (entry->len == comp->chunk_size) {
+		/* Uncompressed chunks are read straight into the request buffers */
+		rc = spdk_bdev_readv_blocks(comp->base_desc, comp->base_ch, io->iovs, io->iovcnt,
+					    comp->data_offset + entry->offset +
+					    io->offset / comp->block_size,
+					    io->len / comp->block_size,
+					    compress_read_data_done, io);
+	} else {
+		rc = spdk_bdev_read_blocks(comp->base_desc, comp->base_ch,
+					   (uint8_t *)io->buf + comp->chunk_size,
+					   comp->data_offset + entry->offset,
+					   compress_entry_blocks(comp, entry),
+					   compress_read_data_done, io);
+	}
+	if (rc == -ENOMEM) {
+		rc = compress_queue_io(io, compress_read_data);
+	}
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to submit read of %s, rc=%d\n", comp->bdev.name, rc);
+		compress_io_complete(io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+/* Returns true if the chunk was handled without waiting for anything */
+static bool
+compress_read_chunk(struct compress_bdev_io *io)
+{
+	struct vbdev_compress *comp = io->comp;
+
+	compress_io_range(io);
+
+	if (comp->map[io->chunk].len == 0) {
+		spdk_iov_memset(io->iovs, io->iovcnt, 0);
+		compress_read_next(io);
+		return true;
+	}
+
+	compress_read_data(io);
+
+	return false;
+}
+
+static void
+compress_read_continue(struct compress_bdev_io *io)
+{
+	while (io->chunk < io->end) {
+		if (!compress_chunk_lock(io, false) || !compress_read_chunk(io)) {
+			return;
+		}
+	}
+
+	compress_io_complete(io, SPDK_BDEV_IO_STATUS_SUCCESS);
+}
+
+static void
+compress_io_resume(struct compress_bdev_io *io)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_READ) {
+		if (compress_read_chunk(io)) {
+			compress_read_continue(io);
+		}
+	} else {
+		if (compress_write_chunk(io)) {
+			compress_write_continue(io);
+		}
+	}
+}
+
+/* Flush and reset are passed to the base bdev */
+
+static void
+compress_base_io_done(void *cb_arg, int rc)
+{
+	struct compress_bdev_io *io = cb_arg;
+
+	compress_io_complete(io, rc == 0 ? SPDK_BDEV_IO_STATUS_SUCCESS :
+			     SPDK_BDEV_IO_STATUS_FAILED);
+}
+
+static void
+compress_base_io(struct compress_bdev_io *io)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+
+	spdk_bdev_map_submit_base_io(io->comp->base_map, &io->map_ctx, bdev_io->type,
+				     compress_base_io_done, io);
+}
+
+static void
+compress_submit_on_owner(void *ctx)
+{
+	struct spdk_bdev_io *bdev_io = ctx;
+	struct compress_bdev_io *io = (struct compress_bdev_io *)bdev_io->driver_ctx;
+	struct vbdev_compress *comp = io->comp;
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+		break;
+	case SPDK_BDEV_IO_TYPE_FLUSH:
+	case SPDK_BDEV_IO_TYPE_RESET:
+		compress_base_io(io);
+		return;
+	default:
+		SPDK_ERRLOG("compress: unknown I/O type %d\n", bdev_io->type);
+		compress_io_complete(io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	io->chunk = bdev_io->u.bdev.offset_blocks / comp->chunk_blocks;
+	io->end = spdk_divide_round_up(bdev_io->u.bdev.offset_blocks + bdev_io->u.bdev.num_blocks,
+				       comp->chunk_blocks);
+	io->batch = io->chunk;
+
+	io->buf = compress_get_buf(comp);
+	if (io->buf == NULL) {
+		compress_io_complete(io, SPDK_BDEV_IO_STATUS_NOMEM);
+		return;
+	}
+
+	if (bdev_io->u.bdev.iovcnt != 0) {
+		io->iovs = calloc(bdev_io->u.bdev.iovcnt, sizeof(struct iovec));
+		if (io->iovs == NULL) {
+			compress_io_complete(io, SPDK_BDEV_IO_STATUS_NOMEM);
+			return;
+		}
+	}
+
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_READ) {
+		compress_read_continue(io);
+	} else {
+		compress_write(io);
+	}
+}
+
+static void
+compress_submit(struct spdk_bdev_io *bdev_io)
+{
+	struct vbdev_compress *comp = bdev_io->bdev->ctxt;
+
+	if (comp->thread == spdk_get_thread()) {
+		compress_submit_on_owner(bdev_io);
+	} else {
+		spdk_thread_send_msg(comp->thread, compress_submit_on_owner, bdev_io);
+	}
+}
+
+static void
+compress_read_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io, bool success)
+{
+	if (!success) {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	compress_submit(bdev_io);
+}
+
+static void
+vbdev_compress_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	struct compress_bdev_io *io = (struct compress_bdev_io *)bdev_io->driver_ctx;
+
+	memset(io, 0, sizeof(*io));
+	io->comp = bdev_io->bdev->ctxt;
+	io->status = SPDK_BDEV_IO_STATUS_SUCCESS;
+
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_READ) {
+		spdk_bdev_io_get_buf(bdev_io, compress_read_get_buf_cb,
+				     bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen);
+		return;
+	}
+
+	compress_submit(bdev_io);
+}
+
+static bool
+vbdev_compress_io_type_supported(void *ctx, enum spdk_bdev_io_type io_type)
+{
+	switch (io_type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+	case SPDK_BDEV_IO_TYPE_FLUSH:
+	case SPDK_BDEV_IO_TYPE_RESET:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static struct spdk_io_channel *
+vbdev_compress_get_io_channel(void *ctx)
+{
+	struct vbdev_compress *comp = ctx;
+
+	return spdk_get_io_channel(comp);
+}
+
+static void
+compress_get_stats(struct vbdev_compress *comp, struct bdev_compress_stats *stats)
+{
+	*stats = comp->stats;
+	stats->logical_blocks = comp->bdev.blockcnt;
+	stats->physical_blocks = comp->data_blocks;
+}
+
+static int
+vbdev_compress_dump_info_json(void *ctx, struct spdk_json_write_ctx *w)
+{
+	struct vbdev_compress *comp = ctx;
+	struct bdev_compress_stats stats;
+
+	compress_get_stats(comp, &stats);
+
+	spdk_json_write_named_object_begin(w, "compress");
+	spdk_json_write_named_string(w, "name", spdk_bdev_get_name(&comp->bdev));
+	spdk_json_write_named_string(w, "base_bdev_name", spdk_bdev_get_name(comp->base_bdev));
+	spdk_json_write_named_uint32(w, "chunk_size", comp->chunk_size);
+	spdk_json_write_named_string(w, "comp_algo", compress_algo_name(comp->comp_algo));
+	spdk_json_write_named_uint32(w, "comp_level", comp->comp_level);
+	spdk_json_write_named_uint64(w, "physical_blocks", stats.physical_blocks);
+	spdk_json_write_named_uint64(w, "mapped_blocks", stats.mapped_blocks);
+	spdk_json_write_named_uint64(w, "used_blocks", stats.used_blocks);
+	spdk_json_write_object_end(w);
+
+	return 0;
+}
+
+static void
+vbdev_compress_write_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
+{
+	/* Compress bdevs are described by their superblock and brought back by examine */
+}
+
+static void
+compress_free(struct vbdev_compress *comp)
+{
+	void *buf;
+
+	while ((buf = comp->bufs) != NULL) {
+		comp->bufs = *(void **)buf;
+		spdk_dma_free(buf);
+	}
+
+	spdk_bdev_map_free(comp->base_map);
+	free(comp->locks);
+	spdk_bit_pool_free(&comp->pool);
+	free(comp->bdev.name);
+	free(comp);
+}
+
+static void
+compress_io_device_unregister_cb(void *io_device)
+{
+	compress_free(io_device);
+}
+
+static void
+compress_close_base(struct vbdev_compress *comp)
+{
+	if (comp->accel_ch != NULL) {
+		spdk_put_io_channel(comp->accel_ch);
+		comp->accel_ch = NULL;
+	}
+	if (comp->base_ch != NULL) {
+		spdk_put_io_channel(comp->base_ch);
+		comp->base_ch = NULL;
+	}
+	spdk_bdev_module_release_bdev(comp->base_bdev);
+	spdk_bdev_close(comp->base_desc);
+}
+
+static void
+_vbdev_compress_destruct(void *ctx)
+{
+	struct vbdev_compress *comp = ctx;
+
+	assert(TAILQ_EMPTY(&comp->blocked));
+
+	compress_close_base(comp);
+	spdk_io_device_unregister(comp, compress_io_device_unregister_cb);
+}
+
+static int
+vbdev_compress_destruct(void *ctx)
+{
+	struct vbdev_compress *comp = ctx;
+
+	TAILQ_REMOVE(&g_compress_nodes, comp, link);
+
+	/* The base and accel channels and the descriptor belong to the owner thread */
+	if (comp->thread != spdk_get_thread()) {
+		spdk_thread_send_msg(comp->thread, _vbdev_compress_destruct, comp);
+	} else {
+		_vbdev_compress_destruct(comp);
+	}
+
+	return 0;
+}
+
+static const struct spdk_bdev_fn_table vbdev_compress_fn_table = {
+	.destruct		= vbdev_compress_destruct,
+	.submit_request		= vbdev_compress_submit_request,
+	.io_type_supported	= vbdev_compress_io_type_supported,
+	.get_io_channel		= vbdev_compress_get_io_channel,
+	.dump_info_json		= vbdev_compress_dump_info_json,
+	.write_config_json	= vbdev_compress_write_config_json,
+};
+
+static int
+compress_ch_create_cb(void *io_device, void *ctx_buf)
+{
+	return 0;
+}
+
+static void
+compress_ch_destroy_cb(void *io_device, void *ctx_buf)
+{
+}
+
+static void
+vbdev_compress_base_bdev_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev,
+				  void *event_ctx)
+{
+	struct vbdev_compress *comp, *tmp;
+
+	switch (type) {
+	case SPDK_BDEV_EVENT_REMOVE:
+		TAILQ_FOREACH_SAFE(comp, &g_compress_nodes, link, tmp) {
+			if (comp->base_bdev == bdev) {
+				spdk_bdev_unregister(&comp->bdev, NULL, NULL);
+			}
+		}
+		break;
+	default:
+		SPDK_NOTICELOG("Unsupported bdev event: type %d\n", type);
+		break;
+	}
+}
+
+/* Create, load and register */
+
+static int
+compress_sb_init(struct compress_sb *sb, struct spdk_bdev *base_bdev, const char *name,
+		 const struct bdev_compress_opts *opts)
+{
+	uint64_t entries_per_block = base_bdev->blocklen / sizeof(struct compress_map_entry);
+	uint64_t chunk_blocks = opts->chunk_size / base_bdev->blocklen;
+	uint64_t avail = base_bdev->blockcnt - 1;
+	uint64_t num_chunks = opts->num_blocks / chunk_blocks;
+
+	if (base_bdev->blockcnt < 3) {
+		return -ENOSPC;
+	}
+
+	if (num_chunks == 0) {
+		/* Map and data regions sized so every chunk fits uncompressed */
+		num_chunks = avail * entries_per_block / (entries_per_block * chunk_blocks + 1);
+		while (num_chunks > 0 && num_chunks * chunk_blocks +
+		       spdk_divide_round_up(num_chunks, entries_per_block) > avail) {
+			num_chunks--;
+		}
+	}
+
+	memset(sb, 0, sizeof(*sb));
+	memcpy(sb->magic, COMPRESS_SB_MAGIC, sizeof(sb->magic));
+	sb->version = COMPRESS_SB_VERSION;
+	sb->block_size = base_bdev->blocklen;
+	sb->num_blocks = num_chunks * chunk_blocks;
+	sb->chunk_size = opts->chunk_size;
+	sb->comp_algo = opts->comp_algo;
+	sb->comp_level = opts->comp_level;
+	sb->map_offset = 1;
+	sb->map_blocks = spdk_divide_round_up(num_chunks, entries_per_block);
+	sb->data_offset = sb->map_offset + sb->map_blocks;
+	if (num_chunks == 0 || sb->data_offset + chunk_blocks > base_bdev->blockcnt) {
+		return -ENOSPC;
+	}
+	sb->data_blocks = spdk_min(base_bdev->blockcnt - sb->data_offset, COMPRESS_MAX_DATA_BLOCKS);
+	spdk_uuid_generate(&sb->uuid);
+	snprintf(sb->name, sizeof(sb->name), "%s", name);
+	sb->crc = compress_sb_crc(sb);
+
+	return 0;
+}
+
+static bool
+compress_sb_valid(const struct compress_sb *sb, struct spdk_bdev *base_bdev)
+{
+	uint64_t entries_per_block = base_bdev->blocklen / sizeof(struct compress_map_entry);
+	uint64_t chunk_blocks;
+
+	if (memcmp(sb->magic, COMPRESS_SB_MAGIC, sizeof(sb->magic)) != 0) {
+		return false;
+	}
+
+	if (sb->crc != compress_sb_crc(sb)) {
+		SPDK_ERRLOG("Compress superblock on %s has invalid crc\n", base_bdev->name);
+		return false;
+	}
+
+	chunk_blocks = sb->chunk_size / base_bdev->blocklen;
+
+	if (sb->version != COMPRESS_SB_VERSION || sb->block_size != base_bdev->blocklen ||
+	    sb->chunk_size % sb->block_size != 0 || chunk_blocks < 2 ||
+	    sb->chunk_size > COMPRESS_MAX_CHUNK_SIZE ||
+	    sb->comp_algo > SPDK_ACCEL_COMP_ALGO_LZ4 ||
+	    sb->num_blocks == 0 || sb->num_blocks % chunk_blocks != 0 || sb->map_offset != 1 ||
+	    sb->map_blocks != spdk_divide_round_up(sb->num_blocks / chunk_blocks,
+						   entries_per_block) ||
+	    sb->data_offset != sb->map_offset + sb->map_blocks || sb->data_blocks < chunk_blocks ||
+	    sb->data_blocks > COMPRESS_MAX_DATA_BLOCKS ||
+	    sb->data_offset + sb->data_blocks > base_bdev->blockcnt ||
+	    strnlen(sb->name, sizeof(sb->name)) == sizeof(sb->name)) {
+		SPDK_ERRLOG("Compress superblock on %s is invalid\n", base_bdev->name);
+		return false;
+	}
+
+	return true;
+}
+
+static int
+compress_alloc(struct vbdev_compress *comp, const struct compress_sb *sb)
+{
+	comp->block_size = sb->block_size;
+	comp->chunk_size = sb->chunk_size;
+	comp->chunk_blocks = sb->chunk_size / sb->block_size;
+	comp->entries_per_block = sb->block_size / sizeof(struct compress_map_entry);
+	comp->comp_algo = sb->comp_algo;
+	comp->comp_level = sb->comp_level;
+	comp->num_chunks = sb->num_blocks / comp->chunk_blocks;
+	comp->map_offset = sb->map_offset;
+	comp->map_blocks = sb->map_blocks;
+	comp->data_offset = sb->data_offset;
+	comp->data_blocks = sb->data_blocks;
+	TAILQ_INIT(&comp->blocked);
+
+	comp->base_map = spdk_bdev_map_create(comp->base_desc, comp->base_ch, comp->map_offset,
+					      comp->map_blocks);
+	if (comp->base_map == NULL) {
+		return -ENOMEM;
+	}
+	comp->map = spdk_bdev_map_get_buf(comp->base_map);
+
+	comp->locks = calloc(comp->num_chunks, sizeof(uint32_t));
+	if (comp->locks == NULL) {
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void
+compress_init_done(struct compress_init_ctx *ctx, int rc)
+{
+	struct vbdev_compress *comp = ctx->comp;
+
+	if (rc == 0) {
+		TAILQ_INSERT_TAIL(&g_compress_nodes, comp, link);
+		spdk_io_device_register(comp, compress_ch_create_cb, compress_ch_destroy_cb, 0,
+					comp->bdev.name);
+
+		rc = spdk_bdev_register(&comp->bdev);
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to register %s: %s\n", comp->bdev.name,
+				    spdk_strerror(-rc));
+			TAILQ_REMOVE(&g_compress_nodes, comp, link);
+			compress_close_base(comp);
+			spdk_io_device_unregister(comp, compress_io_device_unregister_cb);
+		}
+	} else {
+		SPDK_ERRLOG("Failed to %s compress bdev on %s: %s\n",
+			    ctx->create ? "create" : "load", comp->base_bdev->name,
+			    spdk_strerror(-rc));
+		compress_close_base(comp);
+		compress_free(comp);
+	}
+
+	ctx->cb_fn(ctx->cb_arg, rc);
+
+	spdk_dma_free(ctx->buf);
+	free(ctx);
+}
+
+static int
+compress_init_queue_io(struct compress_init_ctx *ctx, spdk_bdev_io_wait_cb cb_fn)
+{
+	struct vbdev_compress *comp = ctx->comp;
+
+	ctx->bdev_io_wait.bdev = comp->base_bdev;
+	ctx->bdev_io_wait.cb_fn = cb_fn;
+	ctx->bdev_io_wait.cb_arg = ctx;
+
+	return spdk_bdev_queue_io_wait(comp->base_bdev, comp->base_ch, &ctx->bdev_io_wait);
+}
+
+/* Data blocks referenced by the map are allocated, all others are free */
+static int
+compress_load_pool(struct vbdev_compress *comp)
+{
+	struct compress_map_entry *entry;
+	struct spdk_bit_array *array;
+	uint64_t chunk;
+	uint32_t i, num_blocks;
+
+	array = spdk_bit_array_create(comp->data_blocks);
+	if (array == NULL) {
+		return -ENOMEM;
+	}
+
+	for (chunk = 0; chunk < comp->num_chunks; chunk++) {
+		entry = &comp->map[chunk];
+		if (entry->len == 0) {
+			continue;
+		}
+
+		num_blocks = compress_entry_blocks(comp, entry);
+		if (entry->len > comp->chunk_size ||
+		    entry->offset + num_blocks > comp->data_blocks) {
+			SPDK_ERRLOG("Map entry %" PRIu64 " of %s is out of range\n", chunk,
+				    comp->bdev.name);
+			spdk_bit_array_free(&array);
+			return -EILSEQ;
+		}
+
+		for (i = 0; i < num_blocks; i++) {
+			if (spdk_bit_array_get(array, entry->offset + i)) {
+				SPDK_ERRLOG("Map entry %" PRIu64 " of %s overlaps another chunk\n",
+					    chunk, comp->bdev.name);
+				spdk_bit_array_free(&array);
+				return -EILSEQ;
+			}
+			spdk_bit_array_set(array, entry->offset + i);
+		}
+
+		comp->stats.mapped_blocks += comp->chunk_blocks;
+		comp->stats.used_blocks += num_blocks;
+	}
+
+	comp->pool = spdk_bit_pool_create_from_array(array);
+	if (comp->pool == NULL) {
+		spdk_bit_array_free(&array);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void
+compress_load_map_done(void *cb_arg, int rc)
+{
+	struct compress_init_ctx *ctx = cb_arg;
+
+	if (rc != 0) {
+		compress_init_done(ctx, rc);
+		return;
+	}
+
+	compress_init_done(ctx, compress_load_pool(ctx->comp));
+}
+
+static void
+compress_create_sb_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct compress_init_ctx *ctx = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	compress_init_done(ctx, success ? 0 : -EIO);
+}
+
+/* The superblock goes last, so an interrupted format is never examined */
+static void
+compress_create_sb(void *arg)
+{
+	struct compress_init_ctx *ctx = arg;
+	struct vbdev_compress *comp = ctx->comp;
+	int rc;
+
+	memset(ctx->buf, 0, comp->block_size);
+	memcpy(ctx->buf, &ctx->sb, sizeof(ctx->sb));
+
+	rc = spdk_bdev_write_blocks(comp->base_desc, comp->base_ch, ctx->buf, 0, 1,
+				    compress_create_sb_done, ctx);
+	if (rc == -ENOMEM) {
+		rc = compress_init_queue_io(ctx, compress_create_sb);
+	}
+	if (rc != 0) {
+		compress_init_done(ctx, rc);
+	}
+}
+
+static void
+compress_create_map_done(void *cb_arg, int rc)
+{
+	struct compress_init_ctx *ctx = cb_arg;
+
+	if (rc != 0) {
+		compress_init_done(ctx, rc);
+		return;
+	}
+
+	compress_create_sb(ctx);
+}
+
+static void
+compress_start(const char *bdev_name, const struct compress_sb *sb, bool create,
+	       bdev_compress_create_cb cb_fn, void *cb_arg)
+{
+	struct compress_init_ctx *ctx;
+	struct vbdev_compress *comp;
+	int rc;
+
+	ctx = calloc(1, sizeof(*ctx));
+	comp = calloc(1, sizeof(*comp));
+	if (ctx == NULL || comp == NULL) {
+		free(ctx);
+		free(comp);
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->comp = comp;
+	ctx->sb = *sb;
+	ctx->create = create;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	rc = spdk_bdev_open_ext(bdev_name, true, vbdev_compress_base_bdev_event_cb, NULL,
+				&comp->base_desc);
+	if (rc != 0) {
+		SPDK_ERRLOG("Could not open bdev %s: %s\n", bdev_name, spdk_strerror(-rc));
+		goto err;
+	}
+
+	comp->base_bdev = spdk_bdev_desc_get_bdev(comp->base_desc);
+
+	rc = spdk_bdev_module_claim_bdev(comp->base_bdev, comp->base_desc, &compress_if);
+	if (rc != 0) {
+		SPDK_ERRLOG("Could not claim bdev %s\n", bdev_name);
+		spdk_bdev_close(comp->base_desc);
+		goto err;
+	}
+
+	comp->thread = spdk_get_thread();
+	comp->base_ch = spdk_bdev_get_io_channel(comp->base_desc);
+	comp->accel_ch = spdk_accel_get_io_channel();
+	if (comp->base_ch == NULL || comp->accel_ch == NULL) {
+		rc = -ENOMEM;
+		goto err_close;
+	}
+
+	comp->bdev.name = strdup(sb->name);
+	if (comp->bdev.name == NULL) {
+		rc = -ENOMEM;
+		goto err_close;
+	}
+
+	rc = compress_alloc(comp, sb);
+	if (rc != 0) {
+		goto err_close;
+	}
+
+	ctx->buf = spdk_dma_malloc(comp->block_size, spdk_bdev_get_buf_align(comp->base_bdev),
+				   NULL);
+	if (ctx->buf == NULL) {
+		rc = -ENOMEM;
+		goto err_close;
+	}
+
+	comp->bdev.product_name = "Compress disk";
+	comp->bdev.write_cache = comp->base_bdev->write_cache;
+	comp->bdev.required_alignment = comp->base_bdev->required_alignment;
+	comp->bdev.blocklen = comp->block_size;
+	comp->bdev.blockcnt = sb->num_blocks;
+	/* Advertise the chunk size, I/Os covering whole chunks avoid read-modify-write */
+	comp->bdev.optimal_io_boundary = comp->chunk_blocks;
+	comp->bdev.numa = comp->base_bdev->numa;
+	spdk_uuid_copy(&comp->bdev.uuid, &sb->uuid);
+	comp->bdev.ctxt = comp;
+	comp->bdev.fn_table = &vbdev_compress_fn_table;
+	comp->bdev.module = &compress_if;
+
+	if (create) {
+		rc = compress_load_pool(comp);
+		if (rc != 0) {
+			goto err_close;
+		}
+		/* The map is still zeroed, write it out instead of relying on write zeroes */
+		spdk_bdev_map_write(comp->base_map, compress_create_map_done, ctx);
+	} else {
+		spdk_bdev_map_read(comp->base_map, compress_load_map_done, ctx);
+	}
+
+	return;
+
+err_close:
+	spdk_dma_free(ctx->buf);
+	compress_close_base(comp);
+err:
+	compress_free(comp);
+	free(ctx);
+	cb_fn(cb_arg, rc);
+}
+
+void
+bdev_compress_get_default_opts(struct bdev_compress_opts *opts)
+{
+	memset(opts, 0, sizeof(*opts));
+	opts->chunk_size = BDEV_COMPRESS_DEFAULT_CHUNK_SIZE;
+	opts->comp_algo = SPDK_ACCEL_COMP_ALGO_DEFLATE;
+	opts->comp_level = 1;
+}
+
+void
+bdev_compress_create_disk(const char *bdev_name, const char *vbdev_name,
+			  const struct bdev_compress_opts *opts,
+			  bdev_compress_create_cb cb_fn, void *cb_arg)
+{
+	struct spdk_bdev *base_bdev;
+	struct compress_sb sb;
+	uint32_t min_level, max_level;
+	int rc;
+
+	if (strnlen(vbdev_name, COMPRESS_SB_NAME_MAX) == COMPRESS_SB_NAME_MAX) {
+		SPDK_ERRLOG("Compress bdev name %s is too long\n", vbdev_name);
+		cb_fn(cb_arg, -ENAMETOOLONG);
+		return;
+	}
+
+	if (spdk_bdev_get_by_name(vbdev_name) != NULL) {
+		SPDK_ERRLOG("Bdev %s already exists\n", vbdev_name);
+		cb_fn(cb_arg, -EEXIST);
+		return;
+	}
+
+	base_bdev = spdk_bdev_get_by_name(bdev_name);
+	if (base_bdev == NULL) {
+		SPDK_ERRLOG("Could not find bdev %s\n", bdev_name);
+		cb_fn(cb_arg, -ENODEV);
+		return;
+	}
+
+	if (base_bdev->md_len != 0 || base_bdev->blocklen < sizeof(struct compress_sb)) {
+		SPDK_ERRLOG("Bdev %s format is not supported by compress\n", bdev_name);
+		cb_fn(cb_arg, -EINVAL);
+		return;
+	}
+
+	if (opts->chunk_size % base_bdev->blocklen != 0 ||
+	    opts->chunk_size < 2 * base_bdev->blocklen ||
+	    opts->chunk_size > COMPRESS_MAX_CHUNK_SIZE) {
+		SPDK_ERRLOG("Chunk size %" PRIu32 " is not supported on %s\n", opts->chunk_size,
+			    bdev_name);
+		cb_fn(cb_arg, -EINVAL);
+		return;
+	}
+
+	if (opts->num_blocks % (opts->chunk_size / base_bdev->blocklen) != 0) {
+		SPDK_ERRLOG("Number of blocks must be a multiple of the chunk size\n");
+		cb_fn(cb_arg, -EINVAL);
+		return;
+	}
+
+	rc = spdk_accel_get_compress_level_range(opts->comp_algo, &min_level, &max_level);
+	if (rc != 0) {
+		SPDK_ERRLOG("Compression algorithm %s is not supported\n",
+			    compress_algo_name(opts->comp_algo));
+		cb_fn(cb_arg, rc);
+		return;
+	}
+
+	if (opts->comp_level < min_level || opts->comp_level > max_level) {
+		SPDK_ERRLOG("Compression level %" PRIu32 " is out of range [%" PRIu32 ", %" PRIu32
+			    "]\n", opts->comp_level, min_level, max_level);
+		cb_fn(cb_arg, -EINVAL);
+		return;
+	}
+
+	rc = compress_sb_init(&sb, base_bdev, vbdev_name, opts);
+	if (rc != 0) {
+		SPDK_ERRLOG("Bdev %s is too small\n", bdev_name);
+		cb_fn(cb_arg, rc);
+		return;
+	}
+
+	compress_start(bdev_name, &sb, true, cb_fn, cb_arg);
+}
+
+void
+bdev_compress_delete_disk(const char *bdev_name, spdk_bdev_unregister_cb cb_fn, void *cb_arg)
+{
+	int rc;
+
+	rc = spdk_bdev_unregister_by_name(bdev_name, &compress_if, cb_fn, cb_arg);
+	if (rc != 0) {
+		cb_fn(cb_arg, rc);
+	}
+}
+
+int
+bdev_compress_get_stats(const char *bdev_name, bdev_compress_stats_cb cb_fn, void *cb_arg)
+{
+	struct vbdev_compress *comp;
+	struct bdev_compress_stats stats;
+	bool found = false;
+
+	TAILQ_FOREACH(comp, &g_compress_nodes, link) {
+		if (bdev_name != NULL && strcmp(bdev_name, comp->bdev.name) != 0) {
+			continue;
+		}
+
+		compress_get_stats(comp, &stats);
+		cb_fn(cb_arg, comp->bdev.name, comp->chunk_size, &stats);
+		found = true;
+	}
+
+	return (bdev_name == NULL || found) ? 0 : -ENODEV;
+}
+
+/* Examine */
+
+static void
+compress_examine_load_done(void *cb_arg, int rc)
+{
+	spdk_bdev_module_examine_done(&compress_if);
+}
+
+static void
+compress_examine_read_done(void *cb_arg, struct spdk_bdev *bdev, const void *block, int rc)
+{
+	struct compress_sb sb;
+
+	if (rc != 0) {
+		spdk_bdev_module_examine_done(&compress_if);
+		return;
+	}
+
+	memcpy(&sb, block, sizeof(sb));
+	if (!compress_sb_valid(&sb, bdev)) {
+		spdk_bdev_module_examine_done(&compress_if);
+		return;
+	}
+
+	SPDK_NOTICELOG("Loading compress bdev %s from %s\n", sb.name, bdev->name);
+	compress_start(bdev->name, &sb, false, compress_examine_load_done, NULL);
+}
+
+static void
+vbdev_compress_examine_disk(struct spdk_bdev *bdev)
+{
+	if (bdev->md_len != 0 || bdev->blocklen < sizeof(struct compress_sb) ||
+	    spdk_bdev_map_examine(bdev, compress_examine_read_done, NULL) != 0) {
+		spdk_bdev_module_examine_done(&compress_if);
+	}
+}
+
+static int
+vbdev_compress_init(void)
+{
+	return 0;
+}
+
+static int
+vbdev_compress_get_ctx_size(void)
+{
+	return sizeof(struct compress_bdev_io);
+}
+
+SPDK_LOG_REGISTER_COMPONENT(vbdev_compress)
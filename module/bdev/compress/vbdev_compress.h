@@ -0,0 +1,97 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#ifndef SPDK_VBDEV_COMPRESS_H
+#define SPDK_VBDEV_COMPRESS_H
+
+#include "spdk/stdinc.h"
+
+#include "spdk/accel.h"
+#include "spdk/bdev.h"
+#include "spdk/bdev_module.h"
+
+#define BDEV_COMPRESS_DEFAULT_CHUNK_SIZE	(16 * 1024)
+
+struct bdev_compress_opts {
+	/* Number of blocks exposed by the compress bdev, 0 to match the data region */
+	uint64_t			num_blocks;
+	/* Size of the logical chunks that are compressed as a unit, in bytes */
+	uint32_t			chunk_size;
+	enum spdk_accel_comp_algo	comp_algo;
+	uint32_t			comp_level;
+};
+
+struct bdev_compress_stats {
+	/* Size of the compress bdev */
+	uint64_t logical_blocks;
+	/* Size of the data region on the base bdev */
+	uint64_t physical_blocks;
+	/* Logical blocks in chunks that hold data */
+	uint64_t mapped_blocks;
+	/* Data blocks holding compressed or uncompressed chunks */
+	uint64_t used_blocks;
+	/* Chunk writes that were all zeroes and needed no data blocks */
+	uint64_t zero_writes;
+	/* Chunk writes that had to read and merge the previous chunk contents */
+	uint64_t partial_writes;
+	/* Chunks stored uncompressed because compression did not save a block */
+	uint64_t incompressible_writes;
+	/* Accel compress and decompress operations, bytes and time spent in ticks */
+	uint64_t compress_ops;
+	uint64_t compress_bytes_in;
+	uint64_t compress_bytes_out;
+	uint64_t compress_ticks;
+	uint64_t decompress_ops;
+	uint64_t decompress_ticks;
+};
+
+typedef void (*bdev_compress_create_cb)(void *cb_arg, int rc);
+typedef void (*bdev_compress_stats_cb)(void *cb_arg, const char *name, uint32_t chunk_size,
+				       const struct bdev_compress_stats *stats);
+
+/**
+ * Initialize compress bdev options with default values.
+ *
+ * \param opts Options to initialize.
+ */
+void bdev_compress_get_default_opts(struct bdev_compress_opts *opts);
+
+/**
+ * Format a base bdev and create a compress bdev on top of it.
+ *
+ * Any data on the base bdev is lost. Once created, the compress bdev is brought
+ * back by examine whenever the base bdev appears.
+ *
+ * \param bdev_name Base bdev name.
+ * \param vbdev_name Name of the compress bdev.
+ * \param opts Compress bdev options.
+ * \param cb_fn Function to call once the bdev is registered or creation failed.
+ * \param cb_arg Argument to pass to cb_fn.
+ */
+void bdev_compress_create_disk(const char *bdev_name, const char *vbdev_name,
+			       const struct bdev_compress_opts *opts,
+			       bdev_compress_create_cb cb_fn, void *cb_arg);
+
+/**
+ * Delete compress bdev. The on-disk metadata is left intact.
+ *
+ * \param bdev_name Name of the compress bdev.
+ * \param cb_fn Function to call after deletion.
+ * \param cb_arg Argument to pass to cb_fn.
+ */
+void bdev_compress_delete_disk(const char *bdev_name, spdk_bdev_unregister_cb cb_fn,
+			       void *cb_arg);
+
+/**
+ * Get statistics of compress bdevs.
+ *
+ * \param bdev_name Name of the compress bdev or NULL to report all of them.
+ * \param cb_fn Function called synchronously for each reported bdev.
+ * \param cb_arg Argument to pass to cb_fn.
+ * \return 0 on success, -ENODEV if bdev_name is not a compress bdev.
+ */
+int bdev_compress_get_stats(const char *bdev_name, bdev_compress_stats_cb cb_fn, void *cb_arg);
+
+#endif /* SPDK_VBDEV_COMPRESS_H */
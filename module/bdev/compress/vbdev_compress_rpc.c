@@ -0,0 +1,198 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "vbdev_compress.h"
+#include "spdk/env.h"
+#include "spdk/rpc.h"
+#include "spdk/util.h"
+#include "spdk/string.h"
+#include "spdk/log.h"
+#include "spdk_internal/rpc_autogen.h"
+
+struct rpc_bdev_compress_create_cb_ctx {
+	struct spdk_jsonrpc_request	*request;
+	char				*name;
+};
+
+static void
+rpc_bdev_compress_create_cb(void *cb_arg, int rc)
+{
+	struct rpc_bdev_compress_create_cb_ctx *ctx = cb_arg;
+	struct spdk_json_write_ctx *w;
+
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(ctx->request, rc, spdk_strerror(-rc));
+	} else {
+		w = spdk_jsonrpc_begin_result(ctx->request);
+		spdk_json_write_string(w, ctx->name);
+		spdk_jsonrpc_end_result(ctx->request, w);
+	}
+
+	free(ctx->name);
+	free(ctx);
+}
+
+static void
+rpc_bdev_compress_create(struct spdk_jsonrpc_request *request,
+			 const struct spdk_json_val *params)
+{
+	struct rpc_bdev_compress_create_ctx req = {};
+	struct rpc_bdev_compress_create_cb_ctx *ctx;
+	struct bdev_compress_opts opts;
+
+	bdev_compress_get_default_opts(&opts);
+	req.chunk_size = opts.chunk_size;
+	req.comp_algo = (enum rpc_bdev_compress_algo)opts.comp_algo;
+	req.comp_level = opts.comp_level;
+
+	if (spdk_json_decode_object(params, rpc_bdev_compress_create_decoders,
+				    SPDK_COUNTOF(rpc_bdev_compress_create_decoders),
+				    &req)) {
+		SPDK_DEBUGLOG(vbdev_compress, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		spdk_jsonrpc_send_error_response(request, -ENOMEM, spdk_strerror(ENOMEM));
+		goto cleanup;
+	}
+
+	ctx->request = request;
+	ctx->name = req.name;
+	req.name = NULL;
+
+	opts.num_blocks = req.num_blocks;
+	opts.chunk_size = req.chunk_size;
+	opts.comp_algo = (enum spdk_accel_comp_algo)req.comp_algo;
+	opts.comp_level = req.comp_level;
+
+	bdev_compress_create_disk(req.base_bdev_name, ctx->name, &opts,
+				  rpc_bdev_compress_create_cb, ctx);
+
+cleanup:
+	free_rpc_bdev_compress_create(&req);
+}
+SPDK_RPC_REGISTER("bdev_compress_create", rpc_bdev_compress_create, SPDK_RPC_RUNTIME)
+
+static void
+rpc_bdev_compress_delete_cb(void *cb_arg, int bdeverrno)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+
+	if (bdeverrno == 0) {
+		spdk_jsonrpc_send_bool_response(request, true);
+	} else {
+		spdk_jsonrpc_send_error_response(request, bdeverrno, spdk_strerror(-bdeverrno));
+	}
+}
+
+static void
+rpc_bdev_compress_delete(struct spdk_jsonrpc_request *request,
+			 const struct spdk_json_val *params)
+{
+	struct rpc_bdev_compress_delete_ctx req = {};
+
+	if (spdk_json_decode_object(params, rpc_bdev_compress_delete_decoders,
+				    SPDK_COUNTOF(rpc_bdev_compress_delete_decoders),
+				    &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	bdev_compress_delete_disk(req.name, rpc_bdev_compress_delete_cb, request);
+
+cleanup:
+	free_rpc_bdev_compress_delete(&req);
+}
+SPDK_RPC_REGISTER("bdev_compress_delete", rpc_bdev_compress_delete, SPDK_RPC_RUNTIME)
+
+struct rpc_bdev_compress_get_stats_cb_ctx {
+	struct spdk_jsonrpc_request	*request;
+	struct spdk_json_write_ctx	*w;
+};
+
+static double
+rpc_bdev_compress_ticks_to_us(uint64_t ticks, uint64_t ops)
+{
+	return ops == 0 ? 0.0 : (double)ticks * SPDK_SEC_TO_USEC / spdk_get_ticks_hz() / ops;
+}
+
+static void
+rpc_bdev_compress_write_stats(void *cb_arg, const char *name, uint32_t chunk_size,
+			      const struct bdev_compress_stats *stats)
+{
+	struct rpc_bdev_compress_get_stats_cb_ctx *ctx = cb_arg;
+	struct spdk_json_write_ctx *w;
+
+	/* The result is only started once we know the request does not fail */
+	if (ctx->w == NULL) {
+		ctx->w = spdk_jsonrpc_begin_result(ctx->request);
+		spdk_json_write_array_begin(ctx->w);
+	}
+	w = ctx->w;
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "name", name);
+	spdk_json_write_named_uint32(w, "chunk_size", chunk_size);
+	spdk_json_write_named_uint64(w, "logical_blocks", stats->logical_blocks);
+	spdk_json_write_named_uint64(w, "mapped_blocks", stats->mapped_blocks);
+	spdk_json_write_named_uint64(w, "physical_blocks", stats->physical_blocks);
+	spdk_json_write_named_uint64(w, "used_blocks", stats->used_blocks);
+	spdk_json_write_named_double(w, "compression_ratio", stats->used_blocks == 0 ? 0.0 :
+				     (double)stats->mapped_blocks / stats->used_blocks);
+	spdk_json_write_named_uint64(w, "zero_writes", stats->zero_writes);
+	spdk_json_write_named_uint64(w, "partial_writes", stats->partial_writes);
+	spdk_json_write_named_uint64(w, "incompressible_writes", stats->incompressible_writes);
+	spdk_json_write_named_uint64(w, "compress_ops", stats->compress_ops);
+	spdk_json_write_named_uint64(w, "compress_bytes_in", stats->compress_bytes_in);
+	spdk_json_write_named_uint64(w, "compress_bytes_out", stats->compress_bytes_out);
+	spdk_json_write_named_double(w, "compress_latency_us",
+				     rpc_bdev_compress_ticks_to_us(stats->compress_ticks,
+						     stats->compress_ops));
+	spdk_json_write_named_uint64(w, "decompress_ops", stats->decompress_ops);
+	spdk_json_write_named_double(w, "decompress_latency_us",
+				     rpc_bdev_compress_ticks_to_us(stats->decompress_ticks,
+						     stats->decompress_ops));
+	spdk_json_write_object_end(w);
+}
+
+static void
+rpc_bdev_compress_get_stats(struct spdk_jsonrpc_request *request,
+			    const struct spdk_json_val *params)
+{
+	struct rpc_bdev_compress_get_stats_ctx req = {};
+	struct rpc_bdev_compress_get_stats_cb_ctx ctx = { .request = request };
+	int rc;
+
+	if (params && spdk_json_decode_object(params, rpc_bdev_compress_get_stats_decoders,
+					      SPDK_COUNTOF(rpc_bdev_compress_get_stats_decoders),
+					      &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = bdev_compress_get_stats(req.name, rpc_bdev_compress_write_stats, &ctx);
+	if (rc != 0) {
+		assert(ctx.w == NULL);
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	if (ctx.w == NULL) {
+		ctx.w = spdk_jsonrpc_begin_result(request);
+		spdk_json_write_array_begin(ctx.w);
+	}
+	spdk_json_write_array_end(ctx.w);
+	spdk_jsonrpc_end_result(request, ctx.w);
+
+cleanup:
+	free_rpc_bdev_compress_get_stats(&req);
+}
+SPDK_RPC_REGISTER("bdev_compress_get_stats", rpc_bdev_compress_get_stats, SPDK_RPC_RUNTIME)
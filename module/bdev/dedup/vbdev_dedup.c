@@ -0,0 +1,1529 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+/*
+ * Block-level deduplication virtual bdev.
+ *
+ * The base bdev is split into a superblock, a block map and a data region:
+ *
+ *   | superblock | map: one 64-bit entry per logical block | data blocks |
+ *
+ * A map entry of 0 means the logical block is unmapped and reads as zeroes,
+ * any other value is the index of the physical data block plus one. Physical
+ * blocks are reference counted and may be shared by any number of logical
+ * blocks. Written blocks are fingerprinted with CRC-32C and looked up in an
+ * in-memory index; a fingerprint match is only trusted after the candidate
+ * block has been read back and compared, so a duplicate write costs a read
+ * and a map update instead of a data write.
+ *
+ * Data blocks are never overwritten in place. New data goes to a free
+ * physical block and the map entry is switched only after the data is on
+ * disk. The reference held through the previous map entry is dropped only
+ * after the map block with the new entry has been written, so the on-disk
+ * map always points at valid data and a crash at any point leaves, at worst,
+ * unreferenced physical blocks behind. Reference counts, the free block pool
+ * and the fingerprint index are not persisted; they are rebuilt from the map
+ * (and the referenced data) when the base bdev is examined.
+ *
+ * All metadata is owned by the thread that created or loaded the bdev. I/O
+ * submitted on other threads is forwarded there and completed back on the
+ * submitting thread.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "vbdev_dedup.h"
+#include "spdk/bit_array.h"
+#include "spdk/bit_pool.h"
+#include "spdk/crc32.h"
+#include "spdk/env.h"
+#include "spdk/likely.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+#include "spdk/uuid.h"
+
+#include "spdk/bdev_module.h"
+#include "spdk/log.h"
+
+#define DEDUP_SB_MAGIC		"SPDKDDUP"
+#define DEDUP_SB_VERSION	1
+#define DEDUP_SB_NAME_MAX	64
+
+/* Largest data region that can be tracked, physical block indexes are 32-bit */
+#define DEDUP_MAX_DATA_BLOCKS	(UINT32_MAX - 1)
+
+/* Number of logical blocks whose map entries are persisted and released at once */
+#define DEDUP_BATCH_BLOCKS	4096
+
+/* Size of the I/Os used to load the fingerprint index */
+#define DEDUP_LOAD_CHUNK_SIZE	(1024 * 1024)
+
+struct dedup_sb {
+	char			magic[8];
+	uint32_t		version;
+	uint32_t		block_size;
+	uint64_t		num_blocks;
+	uint64_t		map_offset;
+	uint64_t		map_blocks;
+	uint64_t		data_offset;
+	uint64_t		data_blocks;
+	struct spdk_uuid	uuid;
+	char			name[DEDUP_SB_NAME_MAX];
+	uint8_t			reserved[116];
+	uint32_t		crc;
+};
+SPDK_STATIC_ASSERT(sizeof(struct dedup_sb) == 256, "Incorrect size");
+
+struct vbdev_dedup {
+	struct spdk_bdev		bdev;
+	struct spdk_bdev		*base_bdev;
+	struct spdk_bdev_desc		*base_desc;
+	/* Channel of the base bdev, used only on the owner thread */
+	struct spdk_io_channel		*base_ch;
+	struct spdk_thread		*thread;
+	TAILQ_ENTRY(vbdev_dedup)	link;
+
+	uint32_t			block_size;
+	uint32_t			entries_per_block;
+	uint64_t			map_offset;
+	uint64_t			map_blocks;
+	uint64_t			data_offset;
+	uint32_t			data_blocks;
+
+	/* Block map persisted on the base bdev and its in-memory copy */
+	struct spdk_bdev_map		*base_map;
+	uint64_t			*map;
+
+	/* Per physical block: reference count, fingerprint and next block in the bucket */
+	uint32_t			*refcnt;
+	uint32_t			*crc;
+	uint32_t			*next;
+	/* Fingerprint index buckets, both they and next[] hold block index plus one */
+	uint32_t			*buckets;
+	uint32_t			bucket_mask;
+	struct spdk_bit_pool		*pool;
+
+	/* Cached bounce buffers, linked through their first bytes */
+	void				*bufs;
+
+	struct bdev_dedup_stats		stats;
+};
+
+static TAILQ_HEAD(, vbdev_dedup) g_dedup_nodes = TAILQ_HEAD_INITIALIZER(g_dedup_nodes);
+
+struct dedup_bdev_io {
+	struct vbdev_dedup		*dedup;
+	enum spdk_bdev_io_status	status;
+	/* Index of the next block of the request to process */
+	uint64_t			idx;
+	/* First block of the batch whose map updates are pending */
+	uint64_t			batch;
+	/* Physical block being read or written and the length of the read run */
+	uint32_t			phys;
+	uint32_t			run;
+	uint32_t			crc;
+	/* Two blocks: the data being written and a candidate duplicate */
+	void				*buf;
+	/* Previous map entries of the batch, released once the batch is persisted */
+	uint64_t			*old;
+	struct spdk_iov_xfer		ix;
+	struct iovec			*iovs;
+	struct spdk_bdev_io_wait_entry	bdev_io_wait;
+	struct spdk_bdev_map_ctx	map_ctx;
+};
+
+struct dedup_init_ctx {
+	struct vbdev_dedup		*dedup;
+	struct dedup_sb			sb;
+	bool				create;
+	void				*buf;
+	uint64_t			offset;
+	uint64_t			num_blocks;
+	bdev_dedup_create_cb		cb_fn;
+	void				*cb_arg;
+	struct spdk_bdev_io_wait_entry	bdev_io_wait;
+};
+
+static int vbdev_dedup_init(void);
+static int vbdev_dedup_get_ctx_size(void);
+static void vbdev_dedup_examine_disk(struct spdk_bdev *bdev);
+
+static struct spdk_bdev_module dedup_if = {
+	.name = "dedup",
+	.module_init = vbdev_dedup_init,
+	.get_ctx_size = vbdev_dedup_get_ctx_size,
+	.examine_disk = vbdev_dedup_examine_disk,
+};
+
+SPDK_BDEV_MODULE_REGISTER(dedup, &dedup_if)
+
+static void dedup_write_continue(struct dedup_bdev_io *io);
+static void dedup_read_continue(struct dedup_bdev_io *io);
+static void dedup_trim_continue(struct dedup_bdev_io *io);
+
+static uint32_t
+dedup_sb_crc(const struct dedup_sb *sb)
+{
+	return spdk_crc32c_update(sb, offsetof(struct dedup_sb, crc), ~0);
+}
+
+static void *
+dedup_get_buf(struct vbdev_dedup *dedup)
+{
+	void *buf = dedup->bufs;
+
+	if (buf != NULL) {
+		dedup->bufs = *(void **)buf;
+		return buf;
+	}
+
+	return spdk_dma_malloc(2 * dedup->block_size, spdk_bdev_get_buf_align(dedup->base_bdev),
+			       NULL);
+}
+
+static void
+dedup_put_buf(struct vbdev_dedup *dedup, void *buf)
+{
+	*(void **)buf = dedup->bufs;
+	dedup->bufs = buf;
+}
+
+/* Fingerprint index */
+
+static inline uint32_t
+dedup_bucket(struct vbdev_dedup *dedup, uint32_t crc)
+{
+	return crc & dedup->bucket_mask;
+}
+
+static void
+dedup_index_insert(struct vbdev_dedup *dedup, uint32_t phys)
+{
+	uint32_t bucket = dedup_bucket(dedup, dedup->crc[phys]);
+
+	dedup->next[phys] = dedup->buckets[bucket];
+	dedup->buckets[bucket] = phys + 1;
+}
+
+static void
+dedup_index_remove(struct vbdev_dedup *dedup, uint32_t phys)
+{
+	uint32_t *prev = &dedup->buckets[dedup_bucket(dedup, dedup->crc[phys])];
+
+	/* Blocks that failed to be written never made it to the index */
+	while (*prev != 0) {
+		if (*prev == phys + 1) {
+			*prev = dedup->next[phys];
+			dedup->next[phys] = 0;
+			return;
+		}
+		prev = &dedup->next[*prev - 1];
+	}
+}
+
+static void
+dedup_phys_put(struct vbdev_dedup *dedup, uint32_t phys)
+{
+	assert(dedup->refcnt[phys] > 0);
+
+	if (--dedup->refcnt[phys] == 0) {
+		dedup_index_remove(dedup, phys);
+		spdk_bit_pool_free_bit(dedup->pool, phys);
+		dedup->stats.used_blocks--;
+	}
+}
+
+/* Block map */
+
+static uint64_t
+dedup_map_set(struct vbdev_dedup *dedup, uint64_t lba, uint64_t entry)
+{
+	uint64_t old = dedup->map[lba];
+
+	if (old == entry) {
+		return old;
+	}
+
+	if (old == 0) {
+		dedup->stats.mapped_blocks++;
+	} else if (entry == 0) {
+		dedup->stats.mapped_blocks--;
+	}
+
+	dedup->map[lba] = entry;
+	spdk_bdev_map_update(dedup->base_map, lba / dedup->entries_per_block);
+
+	return old;
+}
+
+static void
+_dedup_io_complete(void *ctx)
+{
+	struct spdk_bdev_io *bdev_io = ctx;
+	struct dedup_bdev_io *io = (struct dedup_bdev_io *)bdev_io->driver_ctx;
+
+	spdk_bdev_io_complete(bdev_io, io->status);
+}
+
+static void
+dedup_io_complete(struct dedup_bdev_io *io, enum spdk_bdev_io_status status)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+	struct spdk_thread *thread = spdk_bdev_io_get_thread(bdev_io);
+
+	if (io->buf != NULL) {
+		dedup_put_buf(io->dedup, io->buf);
+		io->buf = NULL;
+	}
+	free(io->old);
+	io->old = NULL;
+	free(io->iovs);
+	io->iovs = NULL;
+
+	if (io->status == SPDK_BDEV_IO_STATUS_SUCCESS) {
+		io->status = status;
+	}
+
+	if (thread == spdk_get_thread()) {
+		spdk_bdev_io_complete(bdev_io, io->status);
+	} else {
+		spdk_thread_send_msg(thread, _dedup_io_complete, bdev_io);
+	}
+}
+
+static int
+dedup_queue_io(struct dedup_bdev_io *io, spdk_bdev_io_wait_cb cb_fn)
+{
+	struct vbdev_dedup *dedup = io->dedup;
+
+	io->bdev_io_wait.bdev = dedup->base_bdev;
+	io->bdev_io_wait.cb_fn = cb_fn;
+	io->bdev_io_wait.cb_arg = io;
+
+	return spdk_bdev_queue_io_wait(dedup->base_bdev, dedup->base_ch, &io->bdev_io_wait);
+}
+
+static void
+dedup_batch_done(struct dedup_bdev_io *io, bool release)
+{
+	struct vbdev_dedup *dedup = io->dedup;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+	uint64_t i;
+
+	/* If the map could not be written, the old entries may still be referenced
+	 * on disk so their blocks stay allocated until the map is reloaded.
+	 */
+	for (i = 0; release && i < io->idx - io->batch; i++) {
+		if (io->old[i] != 0) {
+			dedup_phys_put(dedup, io->old[i] - 1);
+		}
+	}
+
+	if (!release) {
+		io->status = SPDK_BDEV_IO_STATUS_FAILED;
+	}
+
+	io->batch = io->idx;
+
+	if (io->status != SPDK_BDEV_IO_STATUS_SUCCESS || io->idx == bdev_io->u.bdev.num_blocks) {
+		dedup_io_complete(io, io->status);
+	} else if (bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE) {
+		dedup_write_continue(io);
+	} else {
+		dedup_trim_continue(io);
+	}
+}
+
+/* Wait until the map updates of the current batch are persisted, then release the
+ * blocks referenced by the previous entries.
+ */
+static void
+dedup_batch_persisted(void *cb_arg, int rc)
+{
+	dedup_batch_done(cb_arg, rc == 0);
+}
+
+static void
+dedup_batch_persist(struct dedup_bdev_io *io)
+{
+	struct vbdev_dedup *dedup = io->dedup;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+	uint64_t first, last;
+
+	if (io->idx == io->batch) {
+		dedup_batch_done(io, true);
+		return;
+	}
+
+	first = (bdev_io->u.bdev.offset_blocks + io->batch) / dedup->entries_per_block;
+	last = (bdev_io->u.bdev.offset_blocks + io->idx - 1) / dedup->entries_per_block;
+
+	spdk_bdev_map_persist(dedup->base_map, &io->map_ctx, first, last, dedup_batch_persisted, io);
+}
+
+static bool
+dedup_io_alloc_batch(struct dedup_bdev_io *io)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+
+	io->old = calloc(spdk_min(bdev_io->u.bdev.num_blocks, DEDUP_BATCH_BLOCKS),
+			 sizeof(uint64_t));
+
+	return io->old != NULL;
+}
+
+static void
+dedup_batch_add(struct dedup_bdev_io *io, uint64_t entry)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+
+	uint64_t lba = bdev_io->u.bdev.offset_blocks + io->idx;
+
+	io->old[io->idx - io->batch] = dedup_map_set(io->dedup, lba, entry);
+	io->idx++;
+}
+
+/* Write path */
+
+static void dedup_write_lookup(struct dedup_bdev_io *io, uint32_t cand);
+
+static void
+dedup_write_fail(struct dedup_bdev_io *io, enum spdk_bdev_io_status status)
+{
+	/* Blocks already remapped by this request still need their map updates persisted
+	 * so that their previous blocks can be released.
+	 */
+	io->status = status;
+	dedup_batch_persist(io);
+}
+
+static void
+dedup_write_update(struct dedup_bdev_io *io, uint64_t entry)
+{
+	dedup_batch_add(io, entry);
+	dedup_write_continue(io);
+}
+
+static void
+dedup_write_data_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct dedup_bdev_io *io = cb_arg;
+	struct vbdev_dedup *dedup = io->dedup;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		dedup_phys_put(dedup, io->phys);
+		dedup_write_fail(io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	/* Only blocks that are on disk can be found by other writers */
+	dedup_index_insert(dedup, io->phys);
+	dedup->stats.unique_writes++;
+
+	dedup_write_update(io, io->phys + 1ULL);
+}
+
+static void
+dedup_write_data(void *arg)
+{
+	struct dedup_bdev_io *io = arg;
+	struct vbdev_dedup *dedup = io->dedup;
+	int rc;
+
+	rc = spdk_bdev_write_blocks(dedup->base_desc, dedup->base_ch, io->buf,
+				    dedup->data_offset + io->phys, 1, dedup_write_data_done, io);
+	if (rc == -ENOMEM) {
+		rc = dedup_queue_io(io, dedup_write_data);
+	}
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to submit data write of %s, rc=%d\n", dedup->bdev.name, rc);
+		dedup_phys_put(dedup, io->phys);
+		dedup_write_fail(io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+static void
+dedup_write_alloc(struct dedup_bdev_io *io)
+{
+	struct vbdev_dedup *dedup = io->dedup;
+	uint32_t phys;
+
+	phys = spdk_bit_pool_allocate_bit(dedup->pool);
+	if (phys == UINT32_MAX) {
+		SPDK_ERRLOG("%s is out of space\n", dedup->bdev.name);
+		dedup_write_fail(io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	assert(dedup->refcnt[phys] == 0);
+	dedup->refcnt[phys] = 1;
+	dedup->crc[phys] = io->crc;
+	dedup->next[phys] = 0;
+	dedup->stats.used_blocks++;
+
+	io->phys = phys;
+	dedup_write_data(io);
+}
+
+static void
+dedup_write_verify_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct dedup_bdev_io *io = cb_arg;
+	struct vbdev_dedup *dedup = io->dedup;
+	uint32_t next;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		dedup_phys_put(dedup, io->phys);
+		dedup_write_fail(io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	if (memcmp(io->buf, (uint8_t *)io->buf + dedup->block_size, dedup->block_size) == 0) {
+		/* Keep the reference, it now belongs to the map entry */
+		dedup->stats.index_hits++;
+		dedup_write_update(io, io->phys + 1ULL);
+		return;
+	}
+
+	/* Our reference kept the candidate in the index, so its next pointer is current */
+	dedup->stats.index_collisions++;
+	next = dedup->next[io->phys];
+	dedup_phys_put(dedup, io->phys);
+
+	dedup_write_lookup(io, next);
+}
+
+static void
+dedup_write_verify(void *arg)
+{
+	struct dedup_bdev_io *io = arg;
+	struct vbdev_dedup *dedup = io->dedup;
+	int rc;
+
+	rc = spdk_bdev_read_blocks(dedup->base_desc, dedup->base_ch,
+				   (uint8_t *)io->buf + dedup->block_size,
+				   dedup->data_offset + io->phys, 1, dedup_write_verify_done, io);
+	if (rc == -ENOMEM) {
+		rc = dedup_queue_io(io, dedup_write_verify);
+	}
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to submit verify read of %s, rc=%d\n", dedup->bdev.name, rc);
+		dedup_phys_put(dedup, io->phys);
+		dedup_write_fail(io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+static void
+dedup_write_lookup(struct dedup_bdev_io *io, uint32_t cand)
+{
+	struct vbdev_dedup *dedup = io->dedup;
+
+	while (cand != 0 && dedup->crc[cand - 1] != io->crc) {
+		cand = dedup->next[cand - 1];
+	}
+
+	if (cand == 0) {
+		dedup_write_alloc(io);
+		return;
+	}
+
+	/* Hold the candidate while its data is compared */
+	io->phys = cand - 1;
+	dedup->refcnt[io->phys]++;
+	dedup_write_verify(io);
+}
+
+static void
+dedup_write_continue(struct dedup_bdev_io *io)
+{
+	struct vbdev_dedup *dedup = io->dedup;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+
+	while (io->idx < bdev_io->u.bdev.num_blocks) {
+		if (io->idx - io->batch == DEDUP_BATCH_BLOCKS) {
+			dedup_batch_persist(io);
+			return;
+		}
+
+		spdk_iov_xfer_to_buf(&io->ix, io->buf, dedup->block_size);
+
+		if (spdk_mem_all_zero(io->buf, dedup->block_size)) {
+			dedup->stats.zero_writes++;
+			dedup_batch_add(io, 0);
+			continue;
+		}
+
+		io->crc = spdk_crc32c_update(io->buf, dedup->block_size, ~0);
+		dedup->stats.index_lookups++;
+		dedup_write_lookup(io, dedup->buckets[dedup_bucket(dedup, io->crc)]);
+		return;
+	}
+
+	dedup_batch_persist(io);
+}
+
+static void
+dedup_write(struct dedup_bdev_io *io)
+{
+	struct vbdev_dedup *dedup = io->dedup;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+
+	io->buf = dedup_get_buf(dedup);
+	if (io->buf == NULL || !dedup_io_alloc_batch(io)) {
+		dedup_io_complete(io, SPDK_BDEV_IO_STATUS_NOMEM);
+		return;
+	}
+
+	spdk_iov_xfer_init(&io->ix, bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt);
+	dedup_write_continue(io);
+}
+
+/* Unmap and write zeroes both drop the mapping, unmapped blocks read as zeroes */
+
+static void
+dedup_trim_continue(struct dedup_bdev_io *io)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+
+	while (io->idx < bdev_io->u.bdev.num_blocks && io->idx - io->batch < DEDUP_BATCH_BLOCKS) {
+		dedup_batch_add(io, 0);
+	}
+
+	dedup_batch_persist(io);
+}
+
+static void
+dedup_trim(struct dedup_bdev_io *io)
+{
+	if (!dedup_io_alloc_batch(io)) {
+		dedup_io_complete(io, SPDK_BDEV_IO_STATUS_NOMEM);
+		return;
+	}
+
+	dedup_trim_continue(io);
+}
+
+/* Read path */
+
+static void
+dedup_read_put_run(struct dedup_bdev_io *io)
+{
+	uint32_t i;
+
+	for (i = 0; i < io->run; i++) {
+		dedup_phys_put(io->dedup, io->phys + i);
+	}
+}
+
+static void
+dedup_read_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct dedup_bdev_io *io = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	dedup_read_put_run(io);
+
+	if (!success) {
+		dedup_io_complete(io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	io->idx += io->run;
+	dedup_read_continue(io);
+}
+
+static void
+dedup_read_run(void *arg)
+{
+	struct dedup_bdev_io *io = arg;
+	struct vbdev_dedup *dedup = io->dedup;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+	int iovcnt, rc;
+
+	iovcnt = spdk_iov_slice(bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
+				io->idx * dedup->block_size, (uint64_t)io->run * dedup->block_size,
+				io->iovs);
+
+	rc = spdk_bdev_readv_blocks(dedup->base_desc, dedup->base_ch, io->iovs, iovcnt,
+				    dedup->data_offset + io->phys, io->run, dedup_read_done, io);
+	if (rc == -ENOMEM) {
+		rc = dedup_queue_io(io, dedup_read_run);
+	}
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to submit read of %s, rc=%d\n", dedup->bdev.name, rc);
+		dedup_read_put_run(io);
+		dedup_io_complete(io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+static void
+dedup_read_continue(struct dedup_bdev_io *io)
+{
+	struct vbdev_dedup *dedup = io->dedup;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+	uint64_t *map = dedup->map + bdev_io->u.bdev.offset_blocks;
+	uint64_t num_blocks = bdev_io->u.bdev.num_blocks;
+	uint64_t entry, run;
+	uint32_t i;
+	int iovcnt;
+
+	while (io->idx < num_blocks) {
+		entry = map[io->idx];
+
+		if (entry == 0) {
+			run = 1;
+			while (io->idx + run < num_blocks && map[io->idx + run] == 0) {
+				run++;
+			}
+
+			iovcnt = spdk_iov_slice(bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
+						io->idx * dedup->block_size, run * dedup->block_size,
+						io->iovs);
+			spdk_iov_memset(io->iovs, iovcnt, 0);
+			io->idx += run;
+			continue;
+		}
+
+		/* Read physically contiguous blocks with a single I/O */
+		run = 1;
+		while (io->idx + run < num_blocks && map[io->idx + run] == entry + run) {
+			run++;
+		}
+
+		io->phys = entry - 1;
+		io->run = run;
+		for (i = 0; i < io->run; i++) {
+			dedup->refcnt[io->phys + i]++;
+		}
+
+		dedup_read_run(io);
+		return;
+	}
+
+	dedup_io_complete(io, SPDK_BDEV_IO_STATUS_SUCCESS);
+}
+
+static void
+dedup_read(struct dedup_bdev_io *io)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+
+	io->iovs = calloc(bdev_io->u.bdev.iovcnt, sizeof(struct iovec));
+	if (io->iovs == NULL) {
+		dedup_io_complete(io, SPDK_BDEV_IO_STATUS_NOMEM);
+		return;
+	}
+
+	dedup_read_continue(io);
+}
+
+/* Flush and reset are passed to the base bdev */
+
+static void
+dedup_base_io_done(void *cb_arg, int rc)
+{
+	struct dedup_bdev_io *io = cb_arg;
+
+	dedup_io_complete(io, rc == 0 ? SPDK_BDEV_IO_STATUS_SUCCESS : SPDK_BDEV_IO_STATUS_FAILED);
+}
+
+static void
+dedup_base_io(struct dedup_bdev_io *io)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+
+	spdk_bdev_map_submit_base_io(io->dedup->base_map, &io->map_ctx, bdev_io->type,
+				     dedup_base_io_done, io);
+}
+
+static void
+dedup_submit_on_owner(void *ctx)
+{
+	struct spdk_bdev_io *bdev_io = ctx;
+	struct dedup_bdev_io *io = (struct dedup_bdev_io *)bdev_io->driver_ctx;
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+		dedup_read(io);
+		break;
+	case SPDK_BDEV_IO_TYPE_WRITE:
+		dedup_write(io);
+		break;
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+		dedup_trim(io);
+		break;
+	case SPDK_BDEV_IO_TYPE_FLUSH:
+	case SPDK_BDEV_IO_TYPE_RESET:
+		dedup_base_io(io);
+		break;
+	default:
+		SPDK_ERRLOG("dedup: unknown I/O type %d\n", bdev_io->type);
+		dedup_io_complete(io, SPDK_BDEV_IO_STATUS_FAILED);
+		break;
+	}
+}
+
+static void
+dedup_submit(struct spdk_bdev_io *bdev_io)
+{
+	struct vbdev_dedup *dedup = bdev_io->bdev->ctxt;
+
+	if (dedup->thread == spdk_get_thread()) {
+		dedup_submit_on_owner(bdev_io);
+	} else {
+		spdk_thread_send_msg(dedup->thread, dedup_submit_on_owner, bdev_io);
+	}
+}
+
+static void
+dedup_read_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io, bool success)
+{
+	if (!success) {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	dedup_submit(bdev_io);
+}
+
+static void
+vbdev_dedup_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	struct dedup_bdev_io *io = (struct dedup_bdev_io *)bdev_io->driver_ctx;
+
+	memset(io, 0, sizeof(*io));
+	io->dedup = bdev_io->bdev->ctxt;
+	io->status = SPDK_BDEV_IO_STATUS_SUCCESS;
+
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_READ) {
+		spdk_bdev_io_get_buf(bdev_io, dedup_read_get_buf_cb,
+				     bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen);
+		return;
+	}
+
+	dedup_submit(bdev_io);
+}
+
+static bool
+vbdev_dedup_io_type_supported(void *ctx, enum spdk_bdev_io_type io_type)
+{
+	switch (io_type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+	case SPDK_BDEV_IO_TYPE_FLUSH:
+	case SPDK_BDEV_IO_TYPE_RESET:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static struct spdk_io_channel *
+vbdev_dedup_get_io_channel(void *ctx)
+{
+	struct vbdev_dedup *dedup = ctx;
+
+	return spdk_get_io_channel(dedup);
+}
+
+static void
+dedup_get_stats(struct vbdev_dedup *dedup, struct bdev_dedup_stats *stats)
+{
+	*stats = dedup->stats;
+	stats->logical_blocks = dedup->bdev.blockcnt;
+	stats->physical_blocks = dedup->data_blocks;
+}
+
+static int
+vbdev_dedup_dump_info_json(void *ctx, struct spdk_json_write_ctx *w)
+{
+	struct vbdev_dedup *dedup = ctx;
+	struct bdev_dedup_stats stats;
+
+	dedup_get_stats(dedup, &stats);
+
+	spdk_json_write_named_object_begin(w, "dedup");
+	spdk_json_write_named_string(w, "name", spdk_bdev_get_name(&dedup->bdev));
+	spdk_json_write_named_string(w, "base_bdev_name", spdk_bdev_get_name(dedup->base_bdev));
+	spdk_json_write_named_uint64(w, "physical_blocks", stats.physical_blocks);
+	spdk_json_write_named_uint64(w, "mapped_blocks", stats.mapped_blocks);
+	spdk_json_write_named_uint64(w, "used_blocks", stats.used_blocks);
+	spdk_json_write_object_end(w);
+
+	return 0;
+}
+
+static void
+vbdev_dedup_write_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
+{
+	/* Dedup bdevs are described by their superblock and brought back by examine */
+}
+
+static void
+dedup_free(struct vbdev_dedup *dedup)
+{
+	void *buf;
+
+	while ((buf = dedup->bufs) != NULL) {
+		dedup->bufs = *(void **)buf;
+		spdk_dma_free(buf);
+	}
+
+	spdk_bdev_map_free(dedup->base_map);
+	free(dedup->refcnt);
+	free(dedup->crc);
+	free(dedup->next);
+	free(dedup->buckets);
+	spdk_bit_pool_free(&dedup->pool);
+	free(dedup->bdev.name);
+	free(dedup);
+}
+
+static void
+dedup_io_device_unregister_cb(void *io_device)
+{
+	dedup_free(io_device);
+}
+
+static void
+dedup_close_base(struct vbdev_dedup *dedup)
+{
+	if (dedup->base_ch != NULL) {
+		spdk_put_io_channel(dedup->base_ch);
+		dedup->base_ch = NULL;
+	}
+	spdk_bdev_module_release_bdev(dedup->base_bdev);
+	spdk_bdev_close(dedup->base_desc);
+}
+
+static void
+_vbdev_dedup_destruct(void *ctx)
+{
+	struct vbdev_dedup *dedup = ctx;
+
+	dedup_close_base(dedup);
+	spdk_io_device_unregister(dedup, dedup_io_device_unregister_cb);
+}
+
+static int
+vbdev_dedup_destruct(void *ctx)
+{
+	struct vbdev_dedup *dedup = ctx;
+
+	TAILQ_REMOVE(&g_dedup_nodes, dedup, link);
+
+	/* The base channel and descriptor belong to the owner thread */
+	if (dedup->thread != spdk_get_thread()) {
+		spdk_thread_send_msg(dedup->thread, _vbdev_dedup_destruct, dedup);
+	} else {
+		_vbdev_dedup_destruct(dedup);
+	}
+
+	return 0;
+}
+
+static const struct spdk_bdev_fn_table vbdev_dedup_fn_table = {
+	.destruct		= vbdev_dedup_destruct,
+	.submit_request		= vbdev_dedup_submit_request,
+	.io_type_supported	= vbdev_dedup_io_type_supported,
+	.get_io_channel		= vbdev_dedup_get_io_channel,
+	.dump_info_json		= vbdev_dedup_dump_info_json,
+	.write_config_json	= vbdev_dedup_write_config_json,
+};
+
+static int
+dedup_ch_create_cb(void *io_device, void *ctx_buf)
+{
+	return 0;
+}
+
+static void
+dedup_ch_destroy_cb(void *io_device, void *ctx_buf)
+{
+}
+
+static void
+vbdev_dedup_base_bdev_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev,
+			       void *event_ctx)
+{
+	struct vbdev_dedup *dedup, *tmp;
+
+	switch (type) {
+	case SPDK_BDEV_EVENT_REMOVE:
+		TAILQ_FOREACH_SAFE(dedup, &g_dedup_nodes, link, tmp) {
+			if (dedup->base_bdev == bdev) {
+				spdk_bdev_unregister(&dedup->bdev, NULL, NULL);
+			}
+		}
+		break;
+	default:
+		SPDK_NOTICELOG("Unsupported bdev event: type %d\n", type);
+		break;
+	}
+}
+
+/* Create, load and register */
+
+static int
+dedup_sb_init(struct dedup_sb *sb, struct spdk_bdev *base_bdev, const char *name,
+	      uint64_t num_blocks)
+{
+	uint64_t entries_per_block = base_bdev->blocklen / sizeof(uint64_t);
+	uint64_t avail = base_bdev->blockcnt - 1;
+
+	if (base_bdev->blockcnt < 3) {
+		return -ENOSPC;
+	}
+
+	if (num_blocks == 0) {
+		/* Map and data regions sized so every logical block can own a physical one */
+		num_blocks = avail * entries_per_block / (entries_per_block + 1);
+		while (num_blocks + spdk_divide_round_up(num_blocks, entries_per_block) > avail) {
+			num_blocks--;
+		}
+	}
+
+	memset(sb, 0, sizeof(*sb));
+	memcpy(sb->magic, DEDUP_SB_MAGIC, sizeof(sb->magic));
+	sb->version = DEDUP_SB_VERSION;
+	sb->block_size = base_bdev->blocklen;
+	sb->num_blocks = num_blocks;
+	sb->map_offset = 1;
+	sb->map_blocks = spdk_divide_round_up(num_blocks, entries_per_block);
+	sb->data_offset = sb->map_offset + sb->map_blocks;
+	if (num_blocks == 0 || sb->data_offset >= base_bdev->blockcnt) {
+		return -ENOSPC;
+	}
+	sb->data_blocks = spdk_min(base_bdev->blockcnt - sb->data_offset, DEDUP_MAX_DATA_BLOCKS);
+	spdk_uuid_generate(&sb->uuid);
+	snprintf(sb->name, sizeof(sb->name), "%s", name);
+	sb->crc = dedup_sb_crc(sb);
+
+	return 0;
+}
+
+static bool
+dedup_sb_valid(const struct dedup_sb *sb, struct spdk_bdev *base_bdev)
+{
+	uint64_t entries_per_block = base_bdev->blocklen / sizeof(uint64_t);
+
+	if (memcmp(sb->magic, DEDUP_SB_MAGIC, sizeof(sb->magic)) != 0) {
+		return false;
+	}
+
+	if (sb->crc != dedup_sb_crc(sb)) {
+		SPDK_ERRLOG("Dedup superblock on %s has invalid crc\n", base_bdev->name);
+		return false;
+	}
+
+	if (sb->version != DEDUP_SB_VERSION || sb->block_size != base_bdev->blocklen ||
+	    sb->num_blocks == 0 || sb->map_offset != 1 ||
+	    sb->map_blocks != spdk_divide_round_up(sb->num_blocks, entries_per_block) ||
+	    sb->data_offset != sb->map_offset + sb->map_blocks || sb->data_blocks == 0 ||
+	    sb->data_blocks > DEDUP_MAX_DATA_BLOCKS ||
+	    sb->data_offset + sb->data_blocks > base_bdev->blockcnt ||
+	    strnlen(sb->name, sizeof(sb->name)) == sizeof(sb->name)) {
+		SPDK_ERRLOG("Dedup superblock on %s is invalid\n", base_bdev->name);
+		return false;
+	}
+
+	return true;
+}
+
+static int
+dedup_alloc(struct vbdev_dedup *dedup, const struct dedup_sb *sb)
+{
+	uint32_t num_buckets;
+
+	dedup->block_size = sb->block_size;
+	dedup->entries_per_block = sb->block_size / sizeof(uint64_t);
+	dedup->map_offset = sb->map_offset;
+	dedup->map_blocks = sb->map_blocks;
+	dedup->data_offset = sb->data_offset;
+	dedup->data_blocks = sb->data_blocks;
+
+	/* Aim for an average chain length of at most one once the bdev is full */
+	num_buckets = spdk_align32pow2(spdk_min(spdk_max(dedup->data_blocks, 2), 1u << 31));
+	dedup->bucket_mask = num_buckets - 1;
+
+	dedup->base_map = spdk_bdev_map_create(dedup->base_desc, dedup->base_ch, dedup->map_offset,
+					       dedup->map_blocks);
+	if (dedup->base_map == NULL) {
+		return -ENOMEM;
+	}
+	dedup->map = spdk_bdev_map_get_buf(dedup->base_map);
+
+	dedup->refcnt = calloc(dedup->data_blocks, sizeof(uint32_t));
+	dedup->crc = calloc(dedup->data_blocks, sizeof(uint32_t));
+	dedup->next = calloc(dedup->data_blocks, sizeof(uint32_t));
+	dedup->buckets = calloc(num_buckets, sizeof(uint32_t));
+	if (!dedup->refcnt || !dedup->crc || !dedup->next || !dedup->buckets) {
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+/* Physical blocks with a reference are allocated, all others are free */
+static int
+dedup_init_pool(struct vbdev_dedup *dedup)
+{
+	struct spdk_bit_array *array;
+	uint32_t phys;
+
+	array = spdk_bit_array_create(dedup->data_blocks);
+	if (array == NULL) {
+		return -ENOMEM;
+	}
+
+	for (phys = 0; phys < dedup->data_blocks; phys++) {
+		if (dedup->refcnt[phys] != 0) {
+			spdk_bit_array_set(array, phys);
+		}
+	}
+
+	dedup->pool = spdk_bit_pool_create_from_array(array);
+	if (dedup->pool == NULL) {
+		spdk_bit_array_free(&array);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void
+dedup_init_done(struct dedup_init_ctx *ctx, int rc)
+{
+	struct vbdev_dedup *dedup = ctx->dedup;
+
+	if (rc == 0) {
+		TAILQ_INSERT_TAIL(&g_dedup_nodes, dedup, link);
+		spdk_io_device_register(dedup, dedup_ch_create_cb, dedup_ch_destroy_cb, 0,
+					dedup->bdev.name);
+
+		rc = spdk_bdev_register(&dedup->bdev);
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to register %s: %s\n", dedup->bdev.name,
+				    spdk_strerror(-rc));
+			TAILQ_REMOVE(&g_dedup_nodes, dedup, link);
+			dedup_close_base(dedup);
+			spdk_io_device_unregister(dedup, dedup_io_device_unregister_cb);
+		}
+	} else {
+		SPDK_ERRLOG("Failed to %s dedup bdev on %s: %s\n", ctx->create ? "create" : "load",
+			    dedup->base_bdev->name, spdk_strerror(-rc));
+		dedup_close_base(dedup);
+		dedup_free(dedup);
+	}
+
+	ctx->cb_fn(ctx->cb_arg, rc);
+
+	spdk_dma_free(ctx->buf);
+	free(ctx);
+}
+
+static int
+dedup_init_queue_io(struct dedup_init_ctx *ctx, spdk_bdev_io_wait_cb cb_fn)
+{
+	struct vbdev_dedup *dedup = ctx->dedup;
+
+	ctx->bdev_io_wait.bdev = dedup->base_bdev;
+	ctx->bdev_io_wait.cb_fn = cb_fn;
+	ctx->bdev_io_wait.cb_arg = ctx;
+
+	return spdk_bdev_queue_io_wait(dedup->base_bdev, dedup->base_ch, &ctx->bdev_io_wait);
+}
+
+static void dedup_load_index(void *arg);
+
+static void
+dedup_load_index_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct dedup_init_ctx *ctx = cb_arg;
+	struct vbdev_dedup *dedup = ctx->dedup;
+	uint64_t i;
+	uint32_t phys;
+	void *buf;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		dedup_init_done(ctx, -EIO);
+		return;
+	}
+
+	for (i = 0; i < ctx->num_blocks; i++) {
+		phys = ctx->offset + i;
+		if (dedup->refcnt[phys] != 0) {
+			buf = (uint8_t *)ctx->buf + i * dedup->block_size;
+			dedup->crc[phys] = spdk_crc32c_update(buf, dedup->block_size, ~0);
+			dedup_index_insert(dedup, phys);
+		}
+	}
+
+	ctx->offset += ctx->num_blocks;
+	dedup_load_index(ctx);
+}
+
+/* Rebuild the fingerprint index from the referenced data blocks */
+static void
+dedup_load_index(void *arg)
+{
+	struct dedup_init_ctx *ctx = arg;
+	struct vbdev_dedup *dedup = ctx->dedup;
+	uint64_t chunk = DEDUP_LOAD_CHUNK_SIZE / dedup->block_size;
+	uint64_t i;
+	int rc;
+
+	while (ctx->offset < dedup->data_blocks) {
+		ctx->num_blocks = spdk_min(chunk, dedup->data_blocks - ctx->offset);
+
+		for (i = 0; i < ctx->num_blocks; i++) {
+			if (dedup->refcnt[ctx->offset + i] != 0) {
+				break;
+			}
+		}
+		if (i == ctx->num_blocks) {
+			ctx->offset += ctx->num_blocks;
+			continue;
+		}
+
+		rc = spdk_bdev_read_blocks(dedup->base_desc, dedup->base_ch, ctx->buf,
+					   dedup->data_offset + ctx->offset, ctx->num_blocks,
+					   dedup_load_index_done, ctx);
+		if (rc == -ENOMEM) {
+			rc = dedup_init_queue_io(ctx, dedup_load_index);
+		}
+		if (rc != 0) {
+			dedup_init_done(ctx, rc);
+		}
+		return;
+	}
+
+	dedup_init_done(ctx, 0);
+}
+
+static void
+dedup_load_refs(struct dedup_init_ctx *ctx)
+{
+	struct vbdev_dedup *dedup = ctx->dedup;
+	uint64_t lba, entry;
+	int rc;
+
+	for (lba = 0; lba < dedup->bdev.blockcnt; lba++) {
+		entry = dedup->map[lba];
+		if (entry == 0) {
+			continue;
+		}
+
+		if (entry > dedup->data_blocks) {
+			SPDK_ERRLOG("Map entry %" PRIu64 " of %s is out of range\n", lba,
+				    dedup->bdev.name);
+			dedup_init_done(ctx, -EILSEQ);
+			return;
+		}
+
+		dedup->stats.mapped_blocks++;
+		if (dedup->refcnt[entry - 1]++ == 0) {
+			dedup->stats.used_blocks++;
+		}
+	}
+
+	rc = dedup_init_pool(dedup);
+	if (rc != 0) {
+		dedup_init_done(ctx, rc);
+		return;
+	}
+
+	ctx->offset = 0;
+	dedup_load_index(ctx);
+}
+
+static void
+dedup_load_map_done(void *cb_arg, int rc)
+{
+	struct dedup_init_ctx *ctx = cb_arg;
+
+	if (rc != 0) {
+		dedup_init_done(ctx, rc);
+		return;
+	}
+
+	dedup_load_refs(ctx);
+}
+
+static void
+dedup_create_sb_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct dedup_init_ctx *ctx = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	dedup_init_done(ctx, success ? 0 : -EIO);
+}
+
+/* The superblock goes last, so an interrupted format is never examined */
+static void
+dedup_create_sb(void *arg)
+{
+	struct dedup_init_ctx *ctx = arg;
+	struct vbdev_dedup *dedup = ctx->dedup;
+	int rc;
+
+	memset(ctx->buf, 0, dedup->block_size);
+	memcpy(ctx->buf, &ctx->sb, sizeof(ctx->sb));
+
+	rc = spdk_bdev_write_blocks(dedup->base_desc, dedup->base_ch, ctx->buf, 0, 1,
+				    dedup_create_sb_done, ctx);
+	if (rc == -ENOMEM) {
+		rc = dedup_init_queue_io(ctx, dedup_create_sb);
+	}
+	if (rc != 0) {
+		dedup_init_done(ctx, rc);
+	}
+}
+
+static void
+dedup_create_map_done(void *cb_arg, int rc)
+{
+	struct dedup_init_ctx *ctx = cb_arg;
+
+	if (rc != 0) {
+		dedup_init_done(ctx, rc);
+		return;
+	}
+
+	dedup_create_sb(ctx);
+}
+
+static void
+dedup_start(const char *bdev_name, const struct dedup_sb *sb, bool create,
+	    bdev_dedup_create_cb cb_fn, void *cb_arg)
+{
+	struct dedup_init_ctx *ctx;
+	struct vbdev_dedup *dedup;
+	int rc;
+
+	ctx = calloc(1, sizeof(*ctx));
+	dedup = calloc(1, sizeof(*dedup));
+	if (ctx == NULL || dedup == NULL) {
+		free(ctx);
+		free(dedup);
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->dedup = dedup;
+	ctx->sb = *sb;
+	ctx->create = create;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	rc = spdk_bdev_open_ext(bdev_name, true, vbdev_dedup_base_bdev_event_cb, NULL,
+				&dedup->base_desc);
+	if (rc != 0) {
+		SPDK_ERRLOG("Could not open bdev %s: %s\n", bdev_name, spdk_strerror(-rc));
+		goto err;
+	}
+
+	dedup->base_bdev = spdk_bdev_desc_get_bdev(dedup->base_desc);
+
+	rc = spdk_bdev_module_claim_bdev(dedup->base_bdev, dedup->base_desc, &dedup_if);
+	if (rc != 0) {
+		SPDK_ERRLOG("Could not claim bdev %s\n", bdev_name);
+		spdk_bdev_close(dedup->base_desc);
+		goto err;
+	}
+
+	dedup->thread = spdk_get_thread();
+	dedup->base_ch = spdk_bdev_get_io_channel(dedup->base_desc);
+	if (dedup->base_ch == NULL) {
+		rc = -ENOMEM;
+		goto err_close;
+	}
+
+	dedup->bdev.name = strdup(sb->name);
+	if (dedup->bdev.name == NULL) {
+		rc = -ENOMEM;
+		goto err_close;
+	}
+
+	rc = dedup_alloc(dedup, sb);
+	if (rc != 0) {
+		goto err_close;
+	}
+
+	ctx->buf = spdk_dma_malloc(DEDUP_LOAD_CHUNK_SIZE, spdk_bdev_get_buf_align(dedup->base_bdev),
+				   NULL);
+	if (ctx->buf == NULL) {
+		rc = -ENOMEM;
+		goto err_close;
+	}
+
+	dedup->bdev.product_name = "Dedup disk";
+	dedup->bdev.write_cache = dedup->base_bdev->write_cache;
+	dedup->bdev.required_alignment = dedup->base_bdev->required_alignment;
+	dedup->bdev.blocklen = dedup->block_size;
+	dedup->bdev.blockcnt = sb->num_blocks;
+	dedup->bdev.numa = dedup->base_bdev->numa;
+	spdk_uuid_copy(&dedup->bdev.uuid, &sb->uuid);
+	dedup->bdev.ctxt = dedup;
+	dedup->bdev.fn_table = &vbdev_dedup_fn_table;
+	dedup->bdev.module = &dedup_if;
+
+	if (create) {
+		rc = dedup_init_pool(dedup);
+		if (rc != 0) {
+			goto err_close;
+		}
+		/* The map is still zeroed, write it out instead of relying on write zeroes */
+		spdk_bdev_map_write(dedup->base_map, dedup_create_map_done, ctx);
+	} else {
+		spdk_bdev_map_read(dedup->base_map, dedup_load_map_done, ctx);
+	}
+
+	return;
+
+err_close:
+	dedup_close_base(dedup);
+err:
+	dedup_free(dedup);
+	free(ctx);
+	cb_fn(cb_arg, rc);
+}
+
+void
+bdev_dedup_create_disk(const char *bdev_name, const char *vbdev_name, uint64_t num_blocks,
+		       bdev_dedup_create_cb cb_fn, void *cb_arg)
+{
+	struct spdk_bdev *base_bdev;
+	struct dedup_sb sb;
+	int rc;
+
+	if (strnlen(vbdev_name, DEDUP_SB_NAME_MAX) == DEDUP_SB_NAME_MAX) {
+		SPDK_ERRLOG("Dedup bdev name %s is too long\n", vbdev_name);
+		cb_fn(cb_arg, -ENAMETOOLONG);
+		return;
+	}
+
+	if (spdk_bdev_get_by_name(vbdev_name) != NULL) {
+		SPDK_ERRLOG("Bdev %s already exists\n", vbdev_name);
+		cb_fn(cb_arg, -EEXIST);
+		return;
+	}
+
+	base_bdev = spdk_bdev_get_by_name(bdev_name);
+	if (base_bdev == NULL) {
+		SPDK_ERRLOG("Could not find bdev %s\n", bdev_name);
+		cb_fn(cb_arg, -ENODEV);
+		return;
+	}
+
+	if (base_bdev->md_len != 0 || base_bdev->blocklen < sizeof(struct dedup_sb)) {
+		SPDK_ERRLOG("Bdev %s format is not supported by dedup\n", bdev_name);
+		cb_fn(cb_arg, -EINVAL);
+		return;
+	}
+
+	rc = dedup_sb_init(&sb, base_bdev, vbdev_name, num_blocks);
+	if (rc != 0) {
+		SPDK_ERRLOG("Bdev %s is too small\n", bdev_name);
+		cb_fn(cb_arg, rc);
+		return;
+	}
+
+	dedup_start(bdev_name, &sb, true, cb_fn, cb_arg);
+}
+
+void
+bdev_dedup_delete_disk(const char *bdev_name, spdk_bdev_unregister_cb cb_fn, void *cb_arg)
+{
+	int rc;
+
+	rc = spdk_bdev_unregister_by_name(bdev_name, &dedup_if, cb_fn, cb_arg);
+	if (rc != 0) {
+		cb_fn(cb_arg, rc);
+	}
+}
+
+int
+bdev_dedup_get_stats(const char *bdev_name, bdev_dedup_stats_cb cb_fn, void *cb_arg)
+{
+	struct vbdev_dedup *dedup;
+	struct bdev_dedup_stats stats;
+	bool found = false;
+
+	TAILQ_FOREACH(dedup, &g_dedup_nodes, link) {
+		if (bdev_name != NULL && strcmp(bdev_name, dedup->bdev.name) != 0) {
+			continue;
+		}
+
+		dedup_get_stats(dedup, &stats);
+		cb_fn(cb_arg, dedup->bdev.name, &stats);
+		found = true;
+	}
+
+	return (bdev_name == NULL || found) ? 0 : -ENODEV;
+}
+
+/* Examine */
+
+static void
+dedup_examine_load_done(void *cb_arg, int rc)
+{
+	spdk_bdev_module_examine_done(&dedup_if);
+}
+
+static void
+dedup_examine_read_done(void *cb_arg, struct spdk_bdev *bdev, const void *block, int rc)
+{
+	struct dedup_sb sb;
+
+	if (rc != 0) {
+		spdk_bdev_module_examine_done(&dedup_if);
+		return;
+	}
+
+	memcpy(&sb, block, sizeof(sb));
+	if (!dedup_sb_valid(&sb, bdev)) {
+		spdk_bdev_module_examine_done(&dedup_if);
+		return;
+	}
+
+	SPDK_NOTICELOG("Loading dedup bdev %s from %s\n", sb.name, bdev->name);
+	dedup_start(bdev->name, &sb, false, dedup_examine_load_done, NULL);
+}
+
+static void
+vbdev_dedup_examine_disk(struct spdk_bdev *bdev)
+{
+	if (bdev->md_len != 0 || bdev->blocklen < sizeof(struct dedup_sb) ||
+	    spdk_bdev_map_examine(bdev, dedup_examine_read_done, NULL) != 0) {
+		spdk_bdev_module_examine_done(&dedup_if);
+	}
+}
+
+static int
+vbdev_dedup_init(void)
+{
+	return 0;
+}
+
+static int
+vbdev_dedup_get_ctx_size(void)
+{
+	return sizeof(struct dedup_bdev_io);
+}
+
+SPDK_LOG_REGISTER_COMPONENT(vbdev_dedup)
@@ -0,0 +1,72 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#ifndef SPDK_VBDEV_DEDUP_H
+#define SPDK_VBDEV_DEDUP_H
+
+#include "spdk/stdinc.h"
+
+#include "spdk/bdev.h"
+#include "spdk/bdev_module.h"
+
+struct bdev_dedup_stats {
+	/* Size of the dedup bdev */
+	uint64_t logical_blocks;
+	/* Logical blocks that reference a physical block */
+	uint64_t mapped_blocks;
+	/* Size of the data region on the base bdev */
+	uint64_t physical_blocks;
+	/* Physical blocks referenced by at least one logical block */
+	uint64_t used_blocks;
+	/* Written blocks that were all zeroes and needed no physical block */
+	uint64_t zero_writes;
+	/* Fingerprint index lookups, hits and fingerprint matches that failed verification */
+	uint64_t index_lookups;
+	uint64_t index_hits;
+	uint64_t index_collisions;
+	/* Written blocks that were stored in a newly allocated physical block */
+	uint64_t unique_writes;
+};
+
+typedef void (*bdev_dedup_create_cb)(void *cb_arg, int rc);
+typedef void (*bdev_dedup_stats_cb)(void *cb_arg, const char *name,
+				    const struct bdev_dedup_stats *stats);
+
+/**
+ * Format a base bdev and create a dedup bdev on top of it.
+ *
+ * Any data on the base bdev is lost. Once created, the dedup bdev is brought
+ * back by examine whenever the base bdev appears.
+ *
+ * \param bdev_name Base bdev name.
+ * \param vbdev_name Name of the dedup bdev.
+ * \param num_blocks Number of blocks exposed by the dedup bdev, 0 to match the
+ * number of data blocks available on the base bdev.
+ * \param cb_fn Function to call once the bdev is registered or creation failed.
+ * \param cb_arg Argument to pass to cb_fn.
+ */
+void bdev_dedup_create_disk(const char *bdev_name, const char *vbdev_name, uint64_t num_blocks,
+			    bdev_dedup_create_cb cb_fn, void *cb_arg);
+
+/**
+ * Delete dedup bdev. The on-disk metadata is left intact.
+ *
+ * \param bdev_name Name of the dedup bdev.
+ * \param cb_fn Function to call after deletion.
+ * \param cb_arg Argument to pass to cb_fn.
+ */
+void bdev_dedup_delete_disk(const char *bdev_name, spdk_bdev_unregister_cb cb_fn, void *cb_arg);
+
+/**
+ * Get statistics of dedup bdevs.
+ *
+ * \param bdev_name Name of the dedup bdev or NULL to report all of them.
+ * \param cb_fn Function called synchronously for each reported bdev.
+ * \param cb_arg Argument to pass to cb_fn.
+ * \return 0 on success, -ENODEV if bdev_name is not a dedup bdev.
+ */
+int bdev_dedup_get_stats(const char *bdev_name, bdev_dedup_stats_cb cb_fn, void *cb_arg);
+
+#endif /* SPDK_VBDEV_DEDUP_H */
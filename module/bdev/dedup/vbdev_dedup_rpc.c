@@ -0,0 +1,173 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "vbdev_dedup.h"
+#include "spdk/rpc.h"
+#include "spdk/util.h"
+#include "spdk/string.h"
+#include "spdk/log.h"
+#include "spdk_internal/rpc_autogen.h"
+
+struct rpc_bdev_dedup_create_cb_ctx {
+	struct spdk_jsonrpc_request	*request;
+	char				*name;
+};
+
+static void
+rpc_bdev_dedup_create_cb(void *cb_arg, int rc)
+{
+	struct rpc_bdev_dedup_create_cb_ctx *ctx = cb_arg;
+	struct spdk_json_write_ctx *w;
+
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(ctx->request, rc, spdk_strerror(-rc));
+	} else {
+		w = spdk_jsonrpc_begin_result(ctx->request);
+		spdk_json_write_string(w, ctx->name);
+		spdk_jsonrpc_end_result(ctx->request, w);
+	}
+
+	free(ctx->name);
+	free(ctx);
+}
+
+static void
+rpc_bdev_dedup_create(struct spdk_jsonrpc_request *request,
+		      const struct spdk_json_val *params)
+{
+	struct rpc_bdev_dedup_create_ctx req = {};
+	struct rpc_bdev_dedup_create_cb_ctx *ctx;
+
+	if (spdk_json_decode_object(params, rpc_bdev_dedup_create_decoders,
+				    SPDK_COUNTOF(rpc_bdev_dedup_create_decoders),
+				    &req)) {
+		SPDK_DEBUGLOG(vbdev_dedup, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		spdk_jsonrpc_send_error_response(request, -ENOMEM, spdk_strerror(ENOMEM));
+		goto cleanup;
+	}
+
+	ctx->request = request;
+	ctx->name = req.name;
+	req.name = NULL;
+
+	bdev_dedup_create_disk(req.base_bdev_name, ctx->name, req.num_blocks,
+			       rpc_bdev_dedup_create_cb, ctx);
+
+cleanup:
+	free_rpc_bdev_dedup_create(&req);
+}
+SPDK_RPC_REGISTER("bdev_dedup_create", rpc_bdev_dedup_create, SPDK_RPC_RUNTIME)
+
+static void
+rpc_bdev_dedup_delete_cb(void *cb_arg, int bdeverrno)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+
+	if (bdeverrno == 0) {
+		spdk_jsonrpc_send_bool_response(request, true);
+	} else {
+		spdk_jsonrpc_send_error_response(request, bdeverrno, spdk_strerror(-bdeverrno));
+	}
+}
+
+static void
+rpc_bdev_dedup_delete(struct spdk_jsonrpc_request *request,
+		      const struct spdk_json_val *params)
+{
+	struct rpc_bdev_dedup_delete_ctx req = {};
+
+	if (spdk_json_decode_object(params, rpc_bdev_dedup_delete_decoders,
+				    SPDK_COUNTOF(rpc_bdev_dedup_delete_decoders),
+				    &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	bdev_dedup_delete_disk(req.name, rpc_bdev_dedup_delete_cb, request);
+
+cleanup:
+	free_rpc_bdev_dedup_delete(&req);
+}
+SPDK_RPC_REGISTER("bdev_dedup_delete", rpc_bdev_dedup_delete, SPDK_RPC_RUNTIME)
+
+struct rpc_bdev_dedup_get_stats_cb_ctx {
+	struct spdk_jsonrpc_request	*request;
+	struct spdk_json_write_ctx	*w;
+};
+
+static void
+rpc_bdev_dedup_write_stats(void *cb_arg, const char *name, const struct bdev_dedup_stats *stats)
+{
+	struct rpc_bdev_dedup_get_stats_cb_ctx *ctx = cb_arg;
+	struct spdk_json_write_ctx *w;
+
+	/* The result is only started once we know the request does not fail */
+	if (ctx->w == NULL) {
+		ctx->w = spdk_jsonrpc_begin_result(ctx->request);
+		spdk_json_write_array_begin(ctx->w);
+	}
+	w = ctx->w;
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "name", name);
+	spdk_json_write_named_uint64(w, "logical_blocks", stats->logical_blocks);
+	spdk_json_write_named_uint64(w, "mapped_blocks", stats->mapped_blocks);
+	spdk_json_write_named_uint64(w, "physical_blocks", stats->physical_blocks);
+	spdk_json_write_named_uint64(w, "used_blocks", stats->used_blocks);
+	spdk_json_write_named_uint64(w, "saved_blocks", stats->mapped_blocks - stats->used_blocks);
+	spdk_json_write_named_double(w, "dedup_ratio", stats->used_blocks == 0 ? 0.0 :
+				     (double)stats->mapped_blocks / stats->used_blocks);
+	spdk_json_write_named_uint64(w, "zero_writes", stats->zero_writes);
+	spdk_json_write_named_uint64(w, "index_lookups", stats->index_lookups);
+	spdk_json_write_named_uint64(w, "index_hits", stats->index_hits);
+	spdk_json_write_named_uint64(w, "index_collisions", stats->index_collisions);
+	spdk_json_write_named_double(w, "index_hit_rate", stats->index_lookups == 0 ? 0.0 :
+				     (double)stats->index_hits / stats->index_lookups);
+	spdk_json_write_named_uint64(w, "unique_writes", stats->unique_writes);
+	spdk_json_write_object_end(w);
+}
+
+static void
+rpc_bdev_dedup_get_stats(struct spdk_jsonrpc_request *request,
+			 const struct spdk_json_val *params)
+{
+	struct rpc_bdev_dedup_get_stats_ctx req = {};
+	struct rpc_bdev_dedup_get_stats_cb_ctx ctx = { .request = request };
+	int rc;
+
+	if (params && spdk_json_decode_object(params, rpc_bdev_dedup_get_stats_decoders,
+					      SPDK_COUNTOF(rpc_bdev_dedup_get_stats_decoders),
+					      &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = bdev_dedup_get_stats(req.name, rpc_bdev_dedup_write_stats, &ctx);
+	if (rc != 0) {
+		assert(ctx.w == NULL);
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	if (ctx.w == NULL) {
+		ctx.w = spdk_jsonrpc_begin_result(request);
+		spdk_json_write_array_begin(ctx.w);
+	}
+	spdk_json_write_array_end(ctx.w);
+	spdk_jsonrpc_end_result(request, ctx.w);
+
+cleanup:
+	free_rpc_bdev_dedup_get_stats(&req);
+}
+SPDK_RPC_REGISTER("bdev_dedup_get_stats", rpc_bdev_dedup_get_stats, SPDK_RPC_RUNTIME)
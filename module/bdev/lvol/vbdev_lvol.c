@@ -2008,7 +2008,7 @@ _vbdev_lvol_shallow_copy_cb(void *cb_arg, int lvolerrno)
 	struct spdk_lvol *lvol = req->lvol;
 
 	if (lvolerrno != 0) {
-		SPDK_ERRLOG("Could not make a shallow copy of lvol %s due to error: %d\n",
+		SPDK_ERRLOG("Could not make a copy of lvol %s due to error: %d\n",
 			    lvol->name, lvolerrno);
 	}
 
@@ -2017,23 +2017,17 @@ _vbdev_lvol_shallow_copy_cb(void *cb_arg, int lvolerrno)
 	free(req);
 }
 
-int
-vbdev_lvol_shallow_copy(struct spdk_lvol *lvol, const char *bdev_name,
-			spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
-			spdk_lvol_op_complete cb_fn, void *cb_arg)
+static struct spdk_lvol_copy_req *
+_vbdev_lvol_copy_req_alloc(struct spdk_lvol *lvol, const char *bdev_name,
+			   spdk_lvol_op_complete cb_fn, void *cb_arg, int *rc)
 {
 	struct spdk_bs_dev *ext_dev;
 	struct spdk_lvol_copy_req *req;
-	int rc;
-
-	if (lvol == NULL) {
-		SPDK_ERRLOG("lvol must not be NULL\n");
-		return -EINVAL;
-	}
 
 	if (bdev_name == NULL) {
 		SPDK_ERRLOG("lvol %s, bdev name must not be NULL\n", lvol->name);
-		return -EINVAL;
+		*rc = -EINVAL;
+		return NULL;
 	}
 
 	assert(lvol->bdev != NULL);
@@ -2041,23 +2035,25 @@ vbdev_lvol_shallow_copy(struct spdk_lvol *lvol, const char *bdev_name,
 	req = calloc(1, sizeof(*req));
 	if (req == NULL) {
 		SPDK_ERRLOG("lvol %s, cannot alloc memory for lvol copy request\n", lvol->name);
-		return -ENOMEM;
+		*rc = -ENOMEM;
+		return NULL;
 	}
 
-	rc = spdk_bdev_create_bs_dev_ext(bdev_name, _vbdev_lvol_shallow_copy_base_bdev_event_cb,
-					 NULL, &ext_dev);
-	if (rc < 0) {
+	*rc = spdk_bdev_create_bs_dev_ext(bdev_name, _vbdev_lvol_shallow_copy_base_bdev_event_cb,
+					  NULL, &ext_dev);
+	if (*rc < 0) {
 		SPDK_ERRLOG("lvol %s, cannot create blobstore block device from bdev %s\n", lvol->name, bdev_name);
 		free(req);
-		return rc;
+		return NULL;
 	}
 
-	rc = spdk_bs_bdev_claim(ext_dev, &g_lvol_if);
-	if (rc != 0) {
-		SPDK_ERRLOG("lvol %s, unable to claim bdev %s, error %d\n", lvol->name, bdev_name, rc);
+	*rc = spdk_bs_bdev_claim(ext_dev, &g_lvol_if);
+	if (*rc != 0) {
+		SPDK_ERRLOG("lvol %s, unable to claim bdev %s, error %d\n", lvol->name, bdev_name,
+			    *rc);
 		ext_dev->destroy(ext_dev);
 		free(req);
-		return rc;
+		return NULL;
 	}
 
 	req->cb_fn = cb_fn;
@@ -2065,11 +2061,61 @@ vbdev_lvol_shallow_copy(struct spdk_lvol *lvol, const char *bdev_name,
 	req->lvol = lvol;
 	req->ext_dev = ext_dev;
 
-	rc = spdk_lvol_shallow_copy(lvol, ext_dev, status_cb_fn, status_cb_arg, _vbdev_lvol_shallow_copy_cb,
-				    req);
+	return req;
+}
+
+int
+vbdev_lvol_shallow_copy(struct spdk_lvol *lvol, const char *bdev_name,
+			spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
+			spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_lvol_copy_req *req;
+	int rc;
+
+	if (lvol == NULL) {
+		SPDK_ERRLOG("lvol must not be NULL\n");
+		return -EINVAL;
+	}
+
+	req = _vbdev_lvol_copy_req_alloc(lvol, bdev_name, cb_fn, cb_arg, &rc);
+	if (req == NULL) {
+		return rc;
+	}
+
+	rc = spdk_lvol_shallow_copy(lvol, req->ext_dev, status_cb_fn, status_cb_arg,
+				    _vbdev_lvol_shallow_copy_cb, req);
 
 	if (rc < 0) {
-		ext_dev->destroy(ext_dev);
+		req->ext_dev->destroy(req->ext_dev);
+		free(req);
+	}
+
+	return rc;
+}
+
+int
+vbdev_lvol_diff_copy(struct spdk_lvol *lvol, struct spdk_lvol *base, const char *bdev_name,
+		     spdk_blob_diff_copy_status status_cb_fn, void *status_cb_arg,
+		     spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_lvol_copy_req *req;
+	int rc;
+
+	if (lvol == NULL) {
+		SPDK_ERRLOG("lvol must not be NULL\n");
+		return -EINVAL;
+	}
+
+	req = _vbdev_lvol_copy_req_alloc(lvol, bdev_name, cb_fn, cb_arg, &rc);
+	if (req == NULL) {
+		return rc;
+	}
+
+	rc = spdk_lvol_diff_copy(lvol, base, req->ext_dev, status_cb_fn, status_cb_arg,
+				 _vbdev_lvol_shallow_copy_cb, req);
+
+	if (rc < 0) {
+		req->ext_dev->destroy(req->ext_dev);
 		free(req);
 	}
 
@@ -135,6 +135,23 @@ int vbdev_lvol_shallow_copy(struct spdk_lvol *lvol, const char *bdev_name,
 			    spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
 			    spdk_lvol_op_complete cb_fn, void *cb_arg);
 
+/**
+ * \brief Copy the clusters of lvol that differ from an older snapshot over a bdev
+ *
+ * \param lvol Handle to lvol
+ * \param base Handle to the older snapshot, or NULL to copy every cluster of the chain
+ * \param bdev_name Name of the bdev to copy on
+ * \param status_cb_fn Called repeatedly during operation with status updates
+ * \param status_cb_arg Argument passed to function status_cb_fn.
+ * \param cb_fn Completion callback
+ * \param cb_arg Completion callback custom arguments
+ *
+ * \return 0 if operation starts correctly, negative errno on failure.
+ */
+int vbdev_lvol_diff_copy(struct spdk_lvol *lvol, struct spdk_lvol *base, const char *bdev_name,
+			 spdk_blob_diff_copy_status status_cb_fn, void *status_cb_arg,
+			 spdk_lvol_op_complete cb_fn, void *cb_arg);
+
 /**
  * \brief Set an external snapshot as the parent of a lvol.
  *
@@ -16,6 +16,7 @@ SPDK_LOG_REGISTER_COMPONENT(lvol_rpc)
 
 struct rpc_shallow_copy_status {
 	uint32_t				operation_id;
+	bool					completed;
 	/*
 	 * 0 means ongoing or successfully completed operation
 	 * a negative value is the -errno of an aborted operation
@@ -30,6 +31,20 @@ static uint32_t g_shallow_copy_count = 0;
 static LIST_HEAD(, rpc_shallow_copy_status) g_shallow_copy_status_list = LIST_HEAD_INITIALIZER(
 			&g_shallow_copy_status_list);
 
+struct rpc_inflate_status {
+	uint32_t				operation_id;
+	bool					completed;
+	/* -errno of a failed operation, -ECANCELED if it was stopped */
+	int					result;
+	uint64_t				copied_clusters;
+	uint64_t				total_clusters;
+	LIST_ENTRY(rpc_inflate_status)		link;
+};
+
+static uint32_t g_inflate_count = 0;
+static LIST_HEAD(, rpc_inflate_status) g_inflate_status_list = LIST_HEAD_INITIALIZER(
+			&g_inflate_status_list);
+
 static int
 vbdev_get_lvol_store_by_uuid_xor_name(const char *uuid, const char *lvs_name,
 				      struct spdk_lvol_store **lvs)
@@ -1026,6 +1041,7 @@ rpc_bdev_lvol_shallow_copy_cb(void *cb_arg, int lvolerrno)
 {
 	struct rpc_bdev_lvol_shallow_copy_ctx *ctx = cb_arg;
 
+	ctx->status->completed = true;
 	ctx->status->result = lvolerrno;
 
 	free(ctx);
@@ -1132,6 +1148,7 @@ rpc_bdev_lvol_check_shallow_copy(struct spdk_jsonrpc_request *request,
 	struct rpc_shallow_copy_status *status;
 	struct spdk_json_write_ctx *w;
 	uint64_t copied_clusters, total_clusters;
+	bool completed;
 	int result;
 
 	SPDK_INFOLOG(lvol_rpc, "Shallow copy check\n");
@@ -1159,6 +1176,7 @@ rpc_bdev_lvol_check_shallow_copy(struct spdk_jsonrpc_request *request,
 
 	copied_clusters = status->copied_clusters;
 	total_clusters = status->total_clusters;
+	completed = status->completed;
 	result = status->result;
 
 	w = spdk_jsonrpc_begin_result(request);
@@ -1167,9 +1185,9 @@ rpc_bdev_lvol_check_shallow_copy(struct spdk_jsonrpc_request *request,
 
 	spdk_json_write_named_uint64(w, "copied_clusters", copied_clusters);
 	spdk_json_write_named_uint64(w, "total_clusters", total_clusters);
-	if (copied_clusters < total_clusters && result == 0) {
+	if (!completed && result == 0) {
 		spdk_json_write_named_string(w, "state", "in progress");
-	} else if (copied_clusters == total_clusters && result == 0) {
+	} else if (result == 0) {
 		spdk_json_write_named_string(w, "state", "complete");
 		LIST_REMOVE(status, link);
 		free(status);
@@ -1191,6 +1209,429 @@ cleanup:
 SPDK_RPC_REGISTER("bdev_lvol_check_shallow_copy", rpc_bdev_lvol_check_shallow_copy,
 		  SPDK_RPC_RUNTIME)
 
+static struct spdk_lvol *
+rpc_bdev_lvol_get_by_name(struct spdk_jsonrpc_request *request, const char *name)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_lvol *lvol;
+
+	bdev = spdk_bdev_get_by_name(name);
+	if (bdev == NULL) {
+		SPDK_ERRLOG("lvol bdev '%s' does not exist\n", name);
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		return NULL;
+	}
+
+	lvol = vbdev_lvol_get_from_bdev(bdev);
+	if (lvol == NULL) {
+		SPDK_ERRLOG("lvol does not exist\n");
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		return NULL;
+	}
+
+	return lvol;
+}
+
+struct rpc_bdev_lvol_get_diff_cb_ctx {
+	struct spdk_jsonrpc_request	*request;
+	struct spdk_json_write_ctx	*w;
+	uint64_t			cluster_size;
+};
+
+static void
+rpc_bdev_lvol_get_diff_begin(struct rpc_bdev_lvol_get_diff_cb_ctx *ctx)
+{
+	ctx->w = spdk_jsonrpc_begin_result(ctx->request);
+	spdk_json_write_object_begin(ctx->w);
+	spdk_json_write_named_uint64(ctx->w, "cluster_size", ctx->cluster_size);
+	spdk_json_write_named_array_begin(ctx->w, "extents");
+}
+
+static void
+rpc_bdev_lvol_get_diff_extent_cb(uint64_t start_cluster, uint64_t num_clusters, void *cb_arg)
+{
+	struct rpc_bdev_lvol_get_diff_cb_ctx *ctx = cb_arg;
+
+	/* Extents are only reported once the comparison succeeded */
+	if (ctx->w == NULL) {
+		rpc_bdev_lvol_get_diff_begin(ctx);
+	}
+
+	spdk_json_write_object_begin(ctx->w);
+	spdk_json_write_named_uint64(ctx->w, "offset", start_cluster * ctx->cluster_size);
+	spdk_json_write_named_uint64(ctx->w, "length", num_clusters * ctx->cluster_size);
+	spdk_json_write_object_end(ctx->w);
+}
+
+static void
+rpc_bdev_lvol_get_diff_cb(void *cb_arg, int lvolerrno)
+{
+	struct rpc_bdev_lvol_get_diff_cb_ctx *ctx = cb_arg;
+
+	if (lvolerrno != 0) {
+		assert(ctx->w == NULL);
+		spdk_jsonrpc_send_error_response(ctx->request, lvolerrno,
+						 spdk_strerror(-lvolerrno));
+		free(ctx);
+		return;
+	}
+
+	if (ctx->w == NULL) {
+		rpc_bdev_lvol_get_diff_begin(ctx);
+	}
+	spdk_json_write_array_end(ctx->w);
+	spdk_json_write_object_end(ctx->w);
+	spdk_jsonrpc_end_result(ctx->request, ctx->w);
+	free(ctx);
+}
+
+static void
+rpc_bdev_lvol_get_diff(struct spdk_jsonrpc_request *request,
+		       const struct spdk_json_val *params)
+{
+	struct rpc_bdev_lvol_get_diff_ctx req = {};
+	struct rpc_bdev_lvol_get_diff_cb_ctx *ctx;
+	struct spdk_lvol *src_lvol, *base_lvol = NULL;
+
+	SPDK_INFOLOG(lvol_rpc, "Getting lvol diff\n");
+
+	if (spdk_json_decode_object(params, rpc_bdev_lvol_get_diff_decoders,
+				    SPDK_COUNTOF(rpc_bdev_lvol_get_diff_decoders),
+				    &req)) {
+		SPDK_INFOLOG(lvol_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	src_lvol = rpc_bdev_lvol_get_by_name(request, req.src_lvol_name);
+	if (src_lvol == NULL) {
+		goto cleanup;
+	}
+
+	if (req.base_lvol_name != NULL) {
+		base_lvol = rpc_bdev_lvol_get_by_name(request, req.base_lvol_name);
+		if (base_lvol == NULL) {
+			goto cleanup;
+		}
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		spdk_jsonrpc_send_error_response(request, -ENOMEM, spdk_strerror(ENOMEM));
+		goto cleanup;
+	}
+	ctx->request = request;
+	ctx->cluster_size = spdk_bs_get_cluster_size(src_lvol->lvol_store->blobstore);
+
+	spdk_lvol_get_diff(src_lvol, base_lvol, rpc_bdev_lvol_get_diff_extent_cb, ctx,
+			   rpc_bdev_lvol_get_diff_cb, ctx);
+
+cleanup:
+	free_rpc_bdev_lvol_get_diff(&req);
+}
+
+SPDK_RPC_REGISTER("bdev_lvol_get_diff", rpc_bdev_lvol_get_diff, SPDK_RPC_RUNTIME)
+
+static void
+rpc_bdev_lvol_diff_copy_status_cb(uint64_t copied_clusters, uint64_t total_clusters, void *cb_arg)
+{
+	struct rpc_shallow_copy_status *status = cb_arg;
+
+	status->copied_clusters = copied_clusters;
+	status->total_clusters = total_clusters;
+}
+
+static void
+rpc_bdev_lvol_start_diff_copy(struct spdk_jsonrpc_request *request,
+			      const struct spdk_json_val *params)
+{
+	struct rpc_bdev_lvol_start_diff_copy_ctx req = {};
+	struct rpc_bdev_lvol_shallow_copy_ctx *ctx;
+	struct spdk_lvol *src_lvol, *base_lvol = NULL;
+	struct rpc_shallow_copy_status *status;
+	struct spdk_json_write_ctx *w;
+	int rc;
+
+	SPDK_INFOLOG(lvol_rpc, "Diff copying lvol\n");
+
+	if (spdk_json_decode_object(params, rpc_bdev_lvol_start_diff_copy_decoders,
+				    SPDK_COUNTOF(rpc_bdev_lvol_start_diff_copy_decoders),
+				    &req)) {
+		SPDK_INFOLOG(lvol_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	src_lvol = rpc_bdev_lvol_get_by_name(request, req.src_lvol_name);
+	if (src_lvol == NULL) {
+		goto cleanup;
+	}
+
+	if (req.base_lvol_name != NULL) {
+		base_lvol = rpc_bdev_lvol_get_by_name(request, req.base_lvol_name);
+		if (base_lvol == NULL) {
+			goto cleanup;
+		}
+	}
+
+	status = calloc(1, sizeof(*status));
+	if (status == NULL) {
+		SPDK_ERRLOG("Cannot allocate status entry for diff copy of '%s'\n",
+			    req.src_lvol_name);
+		spdk_jsonrpc_send_error_response(request, -ENOMEM, spdk_strerror(ENOMEM));
+		goto cleanup;
+	}
+
+	/* The number of clusters to copy is only known once the chain has been walked */
+	status->operation_id = ++g_shallow_copy_count;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		SPDK_ERRLOG("Cannot allocate context for diff copy of '%s'\n", req.src_lvol_name);
+		spdk_jsonrpc_send_error_response(request, -ENOMEM, spdk_strerror(ENOMEM));
+		free(status);
+		goto cleanup;
+	}
+	ctx->request = request;
+	ctx->status = status;
+
+	LIST_INSERT_HEAD(&g_shallow_copy_status_list, status, link);
+	rc = vbdev_lvol_diff_copy(src_lvol, base_lvol, req.dst_bdev_name,
+				  rpc_bdev_lvol_diff_copy_status_cb, status,
+				  rpc_bdev_lvol_shallow_copy_cb, ctx);
+
+	if (rc < 0) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 spdk_strerror(-rc));
+		LIST_REMOVE(status, link);
+		free(ctx);
+		free(status);
+	} else {
+		w = spdk_jsonrpc_begin_result(request);
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_uint32(w, "operation_id", status->operation_id);
+		spdk_json_write_object_end(w);
+
+		spdk_jsonrpc_end_result(request, w);
+	}
+
+cleanup:
+	free_rpc_bdev_lvol_start_diff_copy(&req);
+}
+
+SPDK_RPC_REGISTER("bdev_lvol_start_diff_copy", rpc_bdev_lvol_start_diff_copy,
+		  SPDK_RPC_RUNTIME)
+
+static void
+rpc_bdev_lvol_inflate_status_cb(uint64_t copied_clusters, uint64_t total_clusters, void *cb_arg)
+{
+	struct rpc_inflate_status *status = cb_arg;
+
+	status->copied_clusters = copied_clusters;
+	status->total_clusters = total_clusters;
+}
+
+static void
+rpc_bdev_lvol_start_inflate_cb(void *cb_arg, int lvolerrno)
+{
+	struct rpc_inflate_status *status = cb_arg;
+
+	status->completed = true;
+	status->result = lvolerrno;
+}
+
+static void
+rpc_bdev_lvol_start_inflate(struct spdk_jsonrpc_request *request,
+			    const struct spdk_json_val *params)
+{
+	struct rpc_bdev_lvol_start_inflate_ctx req = {};
+	struct spdk_bs_inflate_opts opts;
+	struct rpc_inflate_status *status;
+	struct spdk_json_write_ctx *w;
+	struct spdk_bdev *bdev;
+	struct spdk_lvol *lvol;
+
+	SPDK_INFOLOG(lvol_rpc, "Starting background inflate of lvol\n");
+
+	spdk_bs_inflate_opts_init(&opts, sizeof(opts));
+	req.clusters_in_flight = opts.clusters_in_flight;
+
+	if (spdk_json_decode_object(params, rpc_bdev_lvol_start_inflate_decoders,
+				    SPDK_COUNTOF(rpc_bdev_lvol_start_inflate_decoders),
+				    &req)) {
+		SPDK_INFOLOG(lvol_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	if (req.clusters_in_flight == 0) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "clusters_in_flight must be greater than 0");
+		goto cleanup;
+	}
+
+	bdev = spdk_bdev_get_by_name(req.name);
+	if (bdev == NULL) {
+		SPDK_ERRLOG("bdev '%s' does not exist\n", req.name);
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		goto cleanup;
+	}
+
+	lvol = vbdev_lvol_get_from_bdev(bdev);
+	if (lvol == NULL) {
+		SPDK_ERRLOG("lvol does not exist\n");
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		goto cleanup;
+	}
+
+	status = calloc(1, sizeof(*status));
+	if (status == NULL) {
+		SPDK_ERRLOG("Cannot allocate status entry for inflate of '%s'\n", req.name);
+		spdk_jsonrpc_send_error_response(request, -ENOMEM, spdk_strerror(ENOMEM));
+		goto cleanup;
+	}
+
+	status->operation_id = ++g_inflate_count;
+	LIST_INSERT_HEAD(&g_inflate_status_list, status, link);
+
+	opts.decouple_parent = req.decouple_parent;
+	opts.clusters_in_flight = req.clusters_in_flight;
+	opts.max_bandwidth_mb_sec = req.max_bandwidth_mb_sec;
+	opts.max_clusters_per_sec = req.max_clusters_per_sec;
+	opts.status_cb_fn = rpc_bdev_lvol_inflate_status_cb;
+	opts.status_cb_arg = status;
+
+	/* Failures to start are reported through the status of the operation */
+	spdk_lvol_inflate_ext(lvol, &opts, rpc_bdev_lvol_start_inflate_cb, status);
+
+	w = spdk_jsonrpc_begin_result(request);
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_uint32(w, "operation_id", status->operation_id);
+	spdk_json_write_object_end(w);
+
+	spdk_jsonrpc_end_result(request, w);
+
+cleanup:
+	free_rpc_bdev_lvol_start_inflate(&req);
+}
+
+SPDK_RPC_REGISTER("bdev_lvol_start_inflate", rpc_bdev_lvol_start_inflate, SPDK_RPC_RUNTIME)
+
+static void
+rpc_bdev_lvol_check_inflate(struct spdk_jsonrpc_request *request,
+			    const struct spdk_json_val *params)
+{
+	struct rpc_bdev_lvol_check_inflate_ctx req = {};
+	struct rpc_inflate_status *status;
+	struct spdk_json_write_ctx *w;
+
+	SPDK_INFOLOG(lvol_rpc, "Inflate check\n");
+
+	if (spdk_json_decode_object(params, rpc_bdev_lvol_check_inflate_decoders,
+				    SPDK_COUNTOF(rpc_bdev_lvol_check_inflate_decoders),
+				    &req)) {
+		SPDK_INFOLOG(lvol_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	LIST_FOREACH(status, &g_inflate_status_list, link) {
+		if (status->operation_id == req.operation_id) {
+			break;
+		}
+	}
+
+	if (!status) {
+		SPDK_ERRLOG("operation id '%d' does not exist\n", req.operation_id);
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		goto cleanup;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+
+	spdk_json_write_object_begin(w);
+
+	spdk_json_write_named_uint64(w, "copied_clusters", status->copied_clusters);
+	spdk_json_write_named_uint64(w, "total_clusters", status->total_clusters);
+	if (!status->completed) {
+		spdk_json_write_named_string(w, "state", "in progress");
+	} else {
+		if (status->result == 0) {
+			spdk_json_write_named_string(w, "state", "complete");
+		} else if (status->result == -ECANCELED) {
+			spdk_json_write_named_string(w, "state", "stopped");
+		} else {
+			spdk_json_write_named_string(w, "state", "error");
+			spdk_json_write_named_string(w, "error", spdk_strerror(-status->result));
+		}
+		LIST_REMOVE(status, link);
+		free(status);
+	}
+
+	spdk_json_write_object_end(w);
+
+	spdk_jsonrpc_end_result(request, w);
+
+cleanup:
+	free_rpc_bdev_lvol_check_inflate(&req);
+}
+
+SPDK_RPC_REGISTER("bdev_lvol_check_inflate", rpc_bdev_lvol_check_inflate, SPDK_RPC_RUNTIME)
+
+static void
+rpc_bdev_lvol_stop_inflate(struct spdk_jsonrpc_request *request,
+			   const struct spdk_json_val *params)
+{
+	struct rpc_bdev_lvol_stop_inflate_ctx req = {};
+	struct spdk_bdev *bdev;
+	struct spdk_lvol *lvol;
+	int rc;
+
+	SPDK_INFOLOG(lvol_rpc, "Stopping background inflate of lvol\n");
+
+	if (spdk_json_decode_object(params, rpc_bdev_lvol_stop_inflate_decoders,
+				    SPDK_COUNTOF(rpc_bdev_lvol_stop_inflate_decoders),
+				    &req)) {
+		SPDK_INFOLOG(lvol_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	bdev = spdk_bdev_get_by_name(req.name);
+	if (bdev == NULL) {
+		SPDK_ERRLOG("bdev '%s' does not exist\n", req.name);
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		goto cleanup;
+	}
+
+	lvol = vbdev_lvol_get_from_bdev(bdev);
+	if (lvol == NULL) {
+		SPDK_ERRLOG("lvol does not exist\n");
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		goto cleanup;
+	}
+
+	rc = spdk_lvol_inflate_stop(lvol);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+
+cleanup:
+	free_rpc_bdev_lvol_stop_inflate(&req);
+}
+
+SPDK_RPC_REGISTER("bdev_lvol_stop_inflate", rpc_bdev_lvol_stop_inflate, SPDK_RPC_RUNTIME)
+
 static void
 rpc_bdev_lvol_set_parent_cb(void *cb_arg, int lvolerrno)
 {
@@ -941,6 +941,7 @@ raid_bdev_io_init(struct raid_bdev_io *raid_io, struct raid_bdev_io_channel *rai
 	raid_io->memory_domain = memory_domain;
 	raid_io->memory_domain_ctx = memory_domain_ctx;
 	raid_io->md_buf = md_buf;
+	raid_io->priority = SPDK_BDEV_IO_PRIORITY_NORMAL;
 
 	raid_io->raid_bdev = raid_bdev;
 	raid_io->raid_ch = raid_ch;
@@ -972,6 +973,7 @@ raid_bdev_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_i
 			  bdev_io->u.bdev.offset_blocks, bdev_io->u.bdev.num_blocks,
 			  bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt, bdev_io->u.bdev.md_buf,
 			  bdev_io->u.bdev.memory_domain, bdev_io->u.bdev.memory_domain_ctx);
+	raid_io->priority = spdk_bdev_io_get_priority(bdev_io);
 
 	spdk_trace_record(TRACE_BDEV_RAID_IO_START, 0, 0, (uintptr_t)raid_io, (uintptr_t)bdev_io);
 
@@ -1327,6 +1329,8 @@ static struct {
 	{ "1", SPDK_BDEV_RAID_LEVEL_RAID1 },
 	{ "raid5f", SPDK_BDEV_RAID_LEVEL_RAID5F },
 	{ "5f", SPDK_BDEV_RAID_LEVEL_RAID5F },
+	{ "raid6", SPDK_BDEV_RAID_LEVEL_RAID6 },
+	{ "6", SPDK_BDEV_RAID_LEVEL_RAID6 },
 	{ "concat", SPDK_BDEV_RAID_LEVEL_CONCAT },
 	{ }
 };
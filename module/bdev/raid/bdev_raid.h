@@ -103,6 +103,8 @@ struct raid_bdev_io {
 	struct spdk_memory_domain *memory_domain;
 	void *memory_domain_ctx;
 	void *md_buf;
+	/* Priority class passed to the base bdevs, defined by enum spdk_bdev_io_priority */
+	uint8_t priority;
 
 	/* WaitQ entry, used only in waitq logic */
 	struct spdk_bdev_io_wait_entry	waitq_entry;
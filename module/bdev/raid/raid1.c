@@ -46,6 +46,7 @@ raid1_init_ext_io_opts(struct spdk_bdev_ext_io_opts *opts, struct raid_bdev_io *
 	opts->memory_domain = raid_io->memory_domain;
 	opts->memory_domain_ctx = raid_io->memory_domain_ctx;
 	opts->metadata = raid_io->md_buf;
+	opts->priority = raid_io->priority;
 }
 
 static void
@@ -571,6 +572,8 @@ raid1_submit_process_request(struct raid_bdev_process_request *process_req,
 	raid_bdev_io_init(raid_io, raid_ch, SPDK_BDEV_IO_TYPE_READ,
 			  process_req->offset_blocks, process_req->num_blocks,
 			  &process_req->iov, 1, process_req->md_buf, NULL, NULL);
+	/* Keep the resync out of the way of user I/O queued on the base bdevs */
+	raid_io->priority = SPDK_BDEV_IO_PRIORITY_LOW;
 	raid_io->completion_cb = raid1_process_read_completed;
 
 	ret = raid1_submit_read_request(raid_io);
@@ -413,6 +413,7 @@ raid5f_init_ext_io_opts(struct spdk_bdev_ext_io_opts *opts, struct raid_bdev_io
 	opts->memory_domain = raid_io->memory_domain;
 	opts->memory_domain_ctx = raid_io->memory_domain_ctx;
 	opts->metadata = raid_io->md_buf;
+	opts->priority = raid_io->priority;
 }
 
 static int
@@ -1214,6 +1215,7 @@ raid5f_submit_process_request(struct raid_bdev_process_request *process_req,
 	raid_bdev_io_init(raid_io, raid_ch, SPDK_BDEV_IO_TYPE_READ,
 			  process_req->offset_blocks, raid_bdev->strip_size,
 			  iov, 1, process_req->md_buf, NULL, NULL);
+	raid_io->priority = SPDK_BDEV_IO_PRIORITY_LOW;
 
 	ret = raid5f_submit_reconstruct_read(raid_io, stripe_index, chunk_idx, 0,
 					     raid5f_process_stripe_request_reconstruct_xor_done);
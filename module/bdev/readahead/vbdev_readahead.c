@@ -0,0 +1,1105 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+/*
+ * Readahead virtual bdev.
+ *
+ * Each channel tracks a few read streams. A stream is the sequence of reads that start where
+ * the previous one ended; once it saw enough of them, the stream is prefetched: the base bdev
+ * is read ahead of it in segments, aligned chunks of the size of an iobuf large buffer, and
+ * reads of the stream are served from the segments, waiting for them if they are still being
+ * read. The number of segments read ahead, the window, doubles every time a read has to wait
+ * for a segment and is halved every time a segment is released without being read, up to a
+ * maximum set per bdev.
+ *
+ * Prefetched data belongs to the channel that read it, writes from any channel invalidate it
+ * through a table of generation numbers indexed by segment: writes bump the generation of the
+ * segments they cover once they complete, and a segment is only used if its generation did not
+ * change since its prefetch was started.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "vbdev_readahead.h"
+#include "vbdev_cache_common.h"
+#include "spdk/env.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+#include "spdk/uuid.h"
+
+#include "spdk/bdev_module.h"
+#include "spdk/log.h"
+
+/* This namespace UUID was generated using uuid_generate() method. */
+#define BDEV_READAHEAD_NAMESPACE_UUID "5f0c9a7e-3b2d-4c61-8e4f-a1d7b6c2e903"
+
+#define READAHEAD_IOBUF_NAME	"bdev_readahead"
+#define READAHEAD_SEGMENT_SIZE	(128 * 1024)
+#define READAHEAD_STREAMS	8
+/* Sequential reads after which a stream is prefetched */
+#define READAHEAD_TRIGGER	2
+#define READAHEAD_MIN_WINDOW	1
+#define READAHEAD_GENS		1024
+/* Prefetched data of streams idle for this long is released */
+#define READAHEAD_IDLE_US	(100 * 1000)
+
+enum ra_segment_state {
+	RA_SEGMENT_PENDING,
+	RA_SEGMENT_READY,
+	RA_SEGMENT_FAILED,
+};
+
+struct ra_io_channel;
+struct ra_stream;
+
+struct ra_segment {
+	uint64_t			index;
+	uint64_t			num_blocks;
+	void				*buf;
+	/* Generation of the segment when its prefetch was started */
+	uint32_t			gen;
+	enum ra_segment_state		state;
+	/* Whether a read was served from the segment or had to wait for it */
+	bool				used;
+	bool				waited;
+	struct ra_io_channel		*ch;
+	struct ra_stream		*stream;
+	TAILQ_ENTRY(ra_segment)		link;
+};
+
+struct ra_bdev_io;
+
+struct ra_stream {
+	/* Block following the last read, 0 reads if the stream is not in use */
+	uint64_t			next_block;
+	uint32_t			seq_reads;
+	/* Segments to read ahead and index of the next segment to prefetch */
+	uint32_t			window;
+	uint64_t			prefetch_next;
+	uint64_t			last_used;
+	uint64_t			last_tsc;
+	uint32_t			num_pending;
+	/* Prefetched segments, by increasing index */
+	TAILQ_HEAD(, ra_segment)	segments;
+	/* Reads waiting for pending segments */
+	TAILQ_HEAD(, ra_bdev_io)	waiters;
+};
+
+struct vbdev_readahead {
+	struct spdk_bdev		bdev;
+	struct spdk_bdev		*base_bdev;
+	struct spdk_bdev_desc		*base_desc;
+	struct spdk_thread		*thread;
+	TAILQ_ENTRY(vbdev_readahead)	link;
+
+	struct bdev_readahead_opts	opts;
+	uint32_t			seg_size;
+	uint32_t			seg_blocks;
+	uint64_t			num_segments;
+	uint32_t			max_window;
+	/* Bumped by writes to the segments hashing to them */
+	uint32_t			gens[READAHEAD_GENS];
+
+	/* Channels, whose statistics are added to the ones of destroyed channels */
+	pthread_mutex_t			mutex;
+	TAILQ_HEAD(, ra_io_channel)	channels;
+	struct bdev_readahead_stats	stats;
+};
+
+static TAILQ_HEAD(, vbdev_readahead) g_ra_nodes = TAILQ_HEAD_INITIALIZER(g_ra_nodes);
+
+/* Readahead bdevs to create once their base bdevs show up */
+static struct vbdev_cache_assoc_list g_ra_assocs = TAILQ_HEAD_INITIALIZER(g_ra_assocs);
+
+struct ra_io_channel {
+	struct vbdev_readahead		*ra;
+	struct spdk_io_channel		*base_ch;
+	struct spdk_iobuf_channel	iobuf;
+	struct spdk_poller		*poller;
+	struct ra_segment		*segment_array;
+	TAILQ_HEAD(, ra_segment)	free_segments;
+	/* Prefetch reads in flight, which hold a reference to the channel */
+	uint32_t			inflight;
+	struct spdk_io_channel		*self;
+	uint64_t			clock;
+	struct ra_stream		streams[READAHEAD_STREAMS];
+	struct bdev_readahead_stats	stats;
+	TAILQ_ENTRY(ra_io_channel)	link;
+};
+
+struct ra_bdev_io {
+	struct vbdev_cache_io		base;
+	struct ra_io_channel		*ch;
+	struct ra_stream		*stream;
+	TAILQ_ENTRY(ra_bdev_io)		link;
+};
+
+enum ra_serve_result {
+	RA_MISS,
+	RA_WAIT,
+	RA_HIT,
+};
+
+static int vbdev_readahead_init(void);
+static int vbdev_readahead_get_ctx_size(void);
+static void vbdev_readahead_examine(struct spdk_bdev *bdev);
+static void vbdev_readahead_finish(void);
+static int vbdev_readahead_config_json(struct spdk_json_write_ctx *w);
+
+static struct spdk_bdev_module readahead_if = {
+	.name = "readahead",
+	.module_init = vbdev_readahead_init,
+	.get_ctx_size = vbdev_readahead_get_ctx_size,
+	.examine_config = vbdev_readahead_examine,
+	.module_fini = vbdev_readahead_finish,
+	.config_json = vbdev_readahead_config_json
+};
+
+SPDK_BDEV_MODULE_REGISTER(readahead, &readahead_if)
+
+static inline uint32_t *
+ra_gen(struct vbdev_readahead *ra, uint64_t index)
+{
+	return &ra->gens[index % READAHEAD_GENS];
+}
+
+/* Called once writes complete, so that data prefetched before is not used afterwards */
+static void
+ra_invalidate(struct vbdev_readahead *ra, uint64_t offset_blocks, uint64_t num_blocks)
+{
+	uint64_t first = offset_blocks / ra->seg_blocks;
+	uint64_t last = (offset_blocks + spdk_max(num_blocks, 1) - 1) / ra->seg_blocks;
+	uint64_t i;
+
+	if (last - first >= READAHEAD_GENS) {
+		first = 0;
+		last = READAHEAD_GENS - 1;
+	}
+
+	for (i = first; i <= last; i++) {
+		__atomic_add_fetch(ra_gen(ra, i), 1, __ATOMIC_RELEASE);
+	}
+}
+
+/* Channel and streams */
+
+static void
+ra_ch_hold(struct ra_io_channel *ch)
+{
+	/* Prefetch reads keep the channel alive after the reads that started them completed */
+	if (ch->inflight++ == 0) {
+		ch->self = spdk_get_io_channel(ch->ra);
+		assert(ch->self == spdk_io_channel_from_ctx(ch));
+	}
+}
+
+static void
+ra_ch_release(struct ra_io_channel *ch)
+{
+	assert(ch->inflight > 0);
+	if (--ch->inflight == 0) {
+		spdk_put_io_channel(ch->self);
+	}
+}
+
+static void
+ra_segment_free(struct ra_io_channel *ch, struct ra_segment *seg)
+{
+	struct vbdev_readahead *ra = ch->ra;
+
+	assert(seg->state != RA_SEGMENT_PENDING);
+	if (seg->state == RA_SEGMENT_READY && !seg->used) {
+		ch->stats.prefetch_unused_bytes += seg->num_blocks * ra->bdev.blocklen;
+	}
+
+	TAILQ_REMOVE(&seg->stream->segments, seg, link);
+	spdk_iobuf_put(&ch->iobuf, seg->buf, ra->seg_size);
+	seg->buf = NULL;
+	seg->stream = NULL;
+	TAILQ_INSERT_HEAD(&ch->free_segments, seg, link);
+}
+
+static void
+ra_stream_release(struct ra_io_channel *ch, struct ra_stream *s)
+{
+	struct ra_segment *seg;
+
+	assert(s->num_pending == 0);
+	assert(TAILQ_EMPTY(&s->waiters));
+	while ((seg = TAILQ_FIRST(&s->segments))) {
+		ra_segment_free(ch, seg);
+	}
+
+	s->next_block = 0;
+	s->seq_reads = 0;
+	s->window = READAHEAD_MIN_WINDOW;
+	s->prefetch_next = 0;
+}
+
+/* Stream a read continues, either right after its last read or within its prefetched data */
+static struct ra_stream *
+ra_stream_find(struct ra_io_channel *ch, uint64_t offset_blocks)
+{
+	uint32_t seg_blocks = ch->ra->seg_blocks;
+	struct ra_segment *seg;
+	struct ra_stream *s;
+	uint32_t i;
+
+	for (i = 0; i < READAHEAD_STREAMS; i++) {
+		s = &ch->streams[i];
+		if (s->seq_reads == 0) {
+			continue;
+		}
+
+		if (offset_blocks == s->next_block) {
+			return s;
+		}
+
+		seg = TAILQ_FIRST(&s->segments);
+		if (seg != NULL && offset_blocks >= seg->index * seg_blocks &&
+		    offset_blocks < s->prefetch_next * seg_blocks) {
+			return s;
+		}
+	}
+
+	return NULL;
+}
+
+/* Take the least recently used stream without I/O in flight */
+static struct ra_stream *
+ra_stream_new(struct ra_io_channel *ch)
+{
+	struct ra_stream *s, *victim = NULL;
+	uint32_t i;
+
+	for (i = 0; i < READAHEAD_STREAMS; i++) {
+		s = &ch->streams[i];
+		if (s->num_pending != 0 || !TAILQ_EMPTY(&s->waiters)) {
+			continue;
+		}
+		if (victim == NULL || s->last_used < victim->last_used) {
+			victim = s;
+		}
+	}
+
+	if (victim != NULL) {
+		ra_stream_release(ch, victim);
+	}
+
+	return victim;
+}
+
+/* Serve a read from the segments of its stream if they hold all of its data */
+static enum ra_serve_result
+ra_serve(struct ra_bdev_io *io)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+	struct ra_io_channel *ch = io->ch;
+	struct vbdev_readahead *ra = ch->ra;
+	struct ra_stream *s = io->stream;
+	uint32_t blocklen = ra->bdev.blocklen;
+	uint64_t start = bdev_io->u.bdev.offset_blocks;
+	uint64_t end = start + bdev_io->u.bdev.num_blocks;
+	uint64_t first_index = start / ra->seg_blocks, index, seg_start, from, to;
+	struct ra_segment *seg, *first = NULL, *pending = NULL;
+	struct spdk_iov_xfer ix;
+
+	TAILQ_FOREACH(seg, &s->segments, link) {
+		if (seg->index == first_index) {
+			first = seg;
+			break;
+		}
+	}
+
+	for (seg = first, index = first_index; index * ra->seg_blocks < end;
+	     seg = TAILQ_NEXT(seg, link), index++) {
+		if (seg == NULL || seg->index != index || seg->state == RA_SEGMENT_FAILED) {
+			return RA_MISS;
+		}
+
+		if (seg->state == RA_SEGMENT_PENDING) {
+			if (pending == NULL) {
+				pending = seg;
+			}
+			continue;
+		}
+
+		if (seg->gen != __atomic_load_n(ra_gen(ra, seg->index), __ATOMIC_ACQUIRE)) {
+			ch->stats.invalidations++;
+			ra_segment_free(ch, seg);
+			return RA_MISS;
+		}
+	}
+
+	if (pending != NULL) {
+		/* Prefetching does not keep up with the stream, read further ahead */
+		if (!pending->waited) {
+			pending->waited = true;
+			s->window = spdk_min(s->window * 2, ra->max_window);
+		}
+		return RA_WAIT;
+	}
+
+	spdk_iov_xfer_init(&ix, bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt);
+	for (seg = first; seg != NULL && seg->index * ra->seg_blocks < end;
+	     seg = TAILQ_NEXT(seg, link)) {
+		seg_start = seg->index * ra->seg_blocks;
+		from = spdk_max(start, seg_start);
+		to = spdk_min(end, seg_start + seg->num_blocks);
+		spdk_iov_xfer_from_buf(&ix, (uint8_t *)seg->buf + (from - seg_start) * blocklen,
+				       (to - from) * blocklen);
+		seg->used = true;
+	}
+
+	return RA_HIT;
+}
+
+/* Release the segments a stream moved past. Pending segments are kept until they complete,
+ * and all of them as long as reads wait, since those may need them.
+ */
+static void
+ra_stream_advance(struct ra_io_channel *ch, struct ra_stream *s)
+{
+	struct vbdev_readahead *ra = ch->ra;
+	struct ra_segment *seg, *tmp;
+
+	if (!TAILQ_EMPTY(&s->waiters)) {
+		return;
+	}
+
+	TAILQ_FOREACH_SAFE(seg, &s->segments, link, tmp) {
+		if (seg->index * ra->seg_blocks + seg->num_blocks > s->next_block) {
+			break;
+		}
+		if (seg->state == RA_SEGMENT_PENDING) {
+			continue;
+		}
+
+		/* Read too far ahead, or the stream skipped data */
+		if (seg->state == RA_SEGMENT_READY && !seg->used) {
+			s->window = spdk_max(s->window / 2, READAHEAD_MIN_WINDOW);
+		}
+		ra_segment_free(ch, seg);
+	}
+}
+
+static void ra_prefetch_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg);
+
+/* Prefetch the segments of the window ahead of the stream that are not read yet */
+static void
+ra_stream_prefetch(struct ra_io_channel *ch, struct ra_stream *s)
+{
+	struct vbdev_readahead *ra = ch->ra;
+	uint64_t current = s->next_block / ra->seg_blocks;
+	uint64_t limit = spdk_min(current + s->window, ra->num_segments);
+	struct ra_segment *seg;
+	int rc;
+
+	if (s->seq_reads < READAHEAD_TRIGGER) {
+		return;
+	}
+
+	s->prefetch_next = spdk_max(s->prefetch_next, current);
+	while (s->prefetch_next < limit) {
+		seg = TAILQ_FIRST(&ch->free_segments);
+		if (seg == NULL) {
+			break;
+		}
+
+		/* Prefetching is speculative, it does not wait for buffers */
+		seg->buf = spdk_iobuf_get(&ch->iobuf, ra->seg_size, NULL, NULL);
+		if (seg->buf == NULL) {
+			ch->stats.prefetch_nobuf++;
+			break;
+		}
+
+		seg->index = s->prefetch_next;
+		seg->num_blocks = spdk_min(ra->seg_blocks,
+					   ra->bdev.blockcnt - seg->index * ra->seg_blocks);
+		seg->gen = __atomic_load_n(ra_gen(ra, seg->index), __ATOMIC_ACQUIRE);
+		seg->state = RA_SEGMENT_PENDING;
+		seg->used = false;
+		seg->waited = false;
+		seg->stream = s;
+
+		rc = spdk_bdev_read_blocks(ra->base_desc, ch->base_ch, seg->buf,
+					   seg->index * ra->seg_blocks, seg->num_blocks,
+					   ra_prefetch_done, seg);
+		if (rc != 0) {
+			spdk_iobuf_put(&ch->iobuf, seg->buf, ra->seg_size);
+			seg->buf = NULL;
+			seg->stream = NULL;
+			break;
+		}
+
+		TAILQ_REMOVE(&ch->free_segments, seg, link);
+		TAILQ_INSERT_TAIL(&s->segments, seg, link);
+		s->num_pending++;
+		s->prefetch_next++;
+		ra_ch_hold(ch);
+
+		ch->stats.prefetch_reads++;
+		ch->stats.prefetch_bytes += seg->num_blocks * ra->bdev.blocklen;
+	}
+}
+
+/* I/O path */
+
+static void
+ra_complete_hit(struct ra_bdev_io *io, bool waited)
+{
+	io->ch->stats.read_hits++;
+	if (waited) {
+		io->ch->stats.read_waits++;
+	}
+
+	spdk_bdev_io_complete(spdk_bdev_io_from_ctx(io), SPDK_BDEV_IO_STATUS_SUCCESS);
+}
+
+static void
+ra_stream_wake(struct ra_io_channel *ch, struct ra_stream *s)
+{
+	struct ra_bdev_io *io, *tmp;
+
+	TAILQ_FOREACH_SAFE(io, &s->waiters, link, tmp) {
+		switch (ra_serve(io)) {
+		case RA_WAIT:
+			break;
+		case RA_HIT:
+			TAILQ_REMOVE(&s->waiters, io, link);
+			ra_complete_hit(io, true);
+			break;
+		case RA_MISS:
+			TAILQ_REMOVE(&s->waiters, io, link);
+			vbdev_cache_io_submit_base(&io->base);
+			break;
+		}
+	}
+}
+
+static void
+ra_prefetch_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct ra_segment *seg = cb_arg;
+	struct ra_io_channel *ch = seg->ch;
+	struct ra_stream *s = seg->stream;
+
+	spdk_bdev_free_io(bdev_io);
+
+	seg->state = success ? RA_SEGMENT_READY : RA_SEGMENT_FAILED;
+	s->num_pending--;
+
+	ra_stream_wake(ch, s);
+	if (!success) {
+		ra_segment_free(ch, seg);
+	}
+	ra_stream_advance(ch, s);
+	ra_stream_prefetch(ch, s);
+
+	ra_ch_release(ch);
+}
+
+static void
+ra_read(struct vbdev_cache_io *base)
+{
+	struct ra_bdev_io *io = SPDK_CONTAINEROF(base, struct ra_bdev_io, base);
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+	struct ra_io_channel *ch = io->ch;
+	uint64_t offset_blocks = bdev_io->u.bdev.offset_blocks;
+	uint64_t end = offset_blocks + bdev_io->u.bdev.num_blocks;
+	struct ra_stream *s;
+
+	s = ra_stream_find(ch, offset_blocks);
+	if (s == NULL) {
+		s = ra_stream_new(ch);
+		if (s != NULL) {
+			s->next_block = end;
+			s->seq_reads = 1;
+			s->last_used = ++ch->clock;
+			s->last_tsc = spdk_get_ticks();
+		}
+		vbdev_cache_io_submit_base(&io->base);
+		return;
+	}
+
+	s->next_block = spdk_max(s->next_block, end);
+	s->last_used = ++ch->clock;
+	s->last_tsc = spdk_get_ticks();
+	if (s->seq_reads < READAHEAD_TRIGGER && ++s->seq_reads == READAHEAD_TRIGGER) {
+		ch->stats.streams_detected++;
+	}
+
+	io->stream = s;
+	switch (ra_serve(io)) {
+	case RA_HIT:
+		ra_complete_hit(io, false);
+		break;
+	case RA_WAIT:
+		TAILQ_INSERT_TAIL(&s->waiters, io, link);
+		break;
+	case RA_MISS:
+		vbdev_cache_io_submit_base(&io->base);
+		break;
+	}
+
+	ra_stream_advance(ch, s);
+	ra_stream_prefetch(ch, s);
+}
+
+static void
+ra_read_base_done(struct spdk_bdev_io *base_io, bool success, void *cb_arg)
+{
+	struct ra_bdev_io *io = cb_arg;
+
+	if (success) {
+		io->ch->stats.read_misses++;
+	}
+
+	spdk_bdev_io_complete_base_io_status(spdk_bdev_io_from_ctx(io), base_io);
+	spdk_bdev_free_io(base_io);
+}
+
+static void
+ra_write_base_done(struct spdk_bdev_io *base_io, bool success, void *cb_arg)
+{
+	struct ra_bdev_io *io = cb_arg;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(io);
+
+	/* Also when the write failed, the contents of the blocks are unknown */
+	ra_invalidate(io->ch->ra, bdev_io->u.bdev.offset_blocks, bdev_io->u.bdev.num_blocks);
+
+	spdk_bdev_io_complete_base_io_status(bdev_io, base_io);
+	spdk_bdev_free_io(base_io);
+}
+
+static const struct vbdev_cache_io_ops g_ra_io_ops = {
+	.read		= ra_read,
+	.read_done	= ra_read_base_done,
+	.write_done	= ra_write_base_done,
+};
+
+static void
+vbdev_readahead_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	struct ra_bdev_io *io = (struct ra_bdev_io *)bdev_io->driver_ctx;
+
+	io->ch = spdk_io_channel_get_ctx(ch);
+	io->stream = NULL;
+	vbdev_cache_io_init(&io->base, &g_ra_io_ops, io->ch->ra->base_desc, io->ch->base_ch);
+
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_READ) {
+		vbdev_cache_io_read(&io->base);
+	} else {
+		vbdev_cache_io_submit_base(&io->base);
+	}
+}
+
+static bool
+vbdev_readahead_io_type_supported(void *ctx, enum spdk_bdev_io_type io_type)
+{
+	struct vbdev_readahead *ra = ctx;
+
+	switch (io_type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+		return true;
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+	case SPDK_BDEV_IO_TYPE_FLUSH:
+	case SPDK_BDEV_IO_TYPE_RESET:
+		return spdk_bdev_io_type_supported(ra->base_bdev, io_type);
+	default:
+		return false;
+	}
+}
+
+static struct spdk_io_channel *
+vbdev_readahead_get_io_channel(void *ctx)
+{
+	struct vbdev_readahead *ra = ctx;
+
+	return spdk_get_io_channel(ra);
+}
+
+static void
+ra_stats_add(struct bdev_readahead_stats *stats, const struct bdev_readahead_stats *add)
+{
+	stats->read_hits += add->read_hits;
+	stats->read_waits += add->read_waits;
+	stats->read_misses += add->read_misses;
+	stats->streams_detected += add->streams_detected;
+	stats->prefetch_reads += add->prefetch_reads;
+	stats->prefetch_bytes += add->prefetch_bytes;
+	stats->prefetch_unused_bytes += add->prefetch_unused_bytes;
+	stats->prefetch_nobuf += add->prefetch_nobuf;
+	stats->invalidations += add->invalidations;
+}
+
+/* Counters of other threads' channels are read without synchronization and may lag a bit */
+static void
+ra_get_stats(struct vbdev_readahead *ra, struct bdev_readahead_stats *stats)
+{
+	struct ra_io_channel *ch;
+
+	pthread_mutex_lock(&ra->mutex);
+	*stats = ra->stats;
+	TAILQ_FOREACH(ch, &ra->channels, link) {
+		ra_stats_add(stats, &ch->stats);
+	}
+	pthread_mutex_unlock(&ra->mutex);
+}
+
+static int
+vbdev_readahead_dump_info_json(void *ctx, struct spdk_json_write_ctx *w)
+{
+	struct vbdev_readahead *ra = ctx;
+
+	spdk_json_write_named_object_begin(w, "readahead");
+	spdk_json_write_named_string(w, "name", spdk_bdev_get_name(&ra->bdev));
+	spdk_json_write_named_string(w, "base_bdev_name", spdk_bdev_get_name(ra->base_bdev));
+	spdk_json_write_named_uint32(w, "segment_size", ra->seg_size);
+	spdk_json_write_named_uint32(w, "max_window_size", ra->max_window * ra->seg_size);
+	spdk_json_write_object_end(w);
+
+	return 0;
+}
+
+static void
+vbdev_readahead_write_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
+{
+	/* Readahead bdevs are recreated from the module configuration */
+}
+
+static int
+vbdev_readahead_config_json(struct spdk_json_write_ctx *w)
+{
+	struct vbdev_readahead *ra;
+
+	TAILQ_FOREACH(ra, &g_ra_nodes, link) {
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "method", "bdev_readahead_create");
+		spdk_json_write_named_object_begin(w, "params");
+		spdk_json_write_named_string(w, "name", spdk_bdev_get_name(&ra->bdev));
+		spdk_json_write_named_string(w, "base_bdev_name",
+					     spdk_bdev_get_name(ra->base_bdev));
+		spdk_json_write_named_uint32(w, "max_window_kb", ra->opts.max_window_size / 1024);
+		spdk_json_write_object_end(w);
+		spdk_json_write_object_end(w);
+	}
+
+	return 0;
+}
+
+static void
+ra_free(struct vbdev_readahead *ra)
+{
+	pthread_mutex_destroy(&ra->mutex);
+	free(ra->bdev.name);
+	free(ra);
+}
+
+static void
+ra_io_device_unregister_cb(void *io_device)
+{
+	struct vbdev_readahead *ra = io_device;
+
+	/* Closed once the channels, and the prefetch reads they hold, are gone */
+	spdk_bdev_close(ra->base_desc);
+	ra_free(ra);
+}
+
+static void
+_vbdev_readahead_destruct(void *ctx)
+{
+	struct vbdev_readahead *ra = ctx;
+
+	spdk_io_device_unregister(ra, ra_io_device_unregister_cb);
+}
+
+static int
+vbdev_readahead_destruct(void *ctx)
+{
+	struct vbdev_readahead *ra = ctx;
+
+	TAILQ_REMOVE(&g_ra_nodes, ra, link);
+
+	spdk_bdev_module_release_bdev(ra->base_bdev);
+
+	/* Close the descriptor on the thread it was opened on */
+	if (ra->thread != spdk_get_thread()) {
+		spdk_thread_send_msg(ra->thread, _vbdev_readahead_destruct, ra);
+	} else {
+		_vbdev_readahead_destruct(ra);
+	}
+
+	return 0;
+}
+
+static const struct spdk_bdev_fn_table vbdev_readahead_fn_table = {
+	.destruct		= vbdev_readahead_destruct,
+	.submit_request		= vbdev_readahead_submit_request,
+	.io_type_supported	= vbdev_readahead_io_type_supported,
+	.get_io_channel		= vbdev_readahead_get_io_channel,
+	.dump_info_json		= vbdev_readahead_dump_info_json,
+	.write_config_json	= vbdev_readahead_write_config_json,
+};
+
+/* Release the prefetched data of streams that stopped */
+static int
+ra_ch_poll(void *arg)
+{
+	struct ra_io_channel *ch = arg;
+	uint64_t now = spdk_get_ticks();
+	uint64_t idle_ticks = READAHEAD_IDLE_US * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+	struct ra_stream *s;
+	int released = 0;
+	uint32_t i;
+
+	for (i = 0; i < READAHEAD_STREAMS; i++) {
+		s = &ch->streams[i];
+		if (!TAILQ_EMPTY(&s->segments) && s->num_pending == 0 &&
+		    TAILQ_EMPTY(&s->waiters) && now - s->last_tsc > idle_ticks) {
+			ra_stream_release(ch, s);
+			released++;
+		}
+	}
+
+	return released > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
+static void
+ra_ch_free(struct ra_io_channel *ch)
+{
+	uint32_t i;
+
+	spdk_poller_unregister(&ch->poller);
+	if (ch->segment_array != NULL) {
+		for (i = 0; i < READAHEAD_STREAMS; i++) {
+			ra_stream_release(ch, &ch->streams[i]);
+		}
+		free(ch->segment_array);
+	}
+	spdk_iobuf_channel_fini(&ch->iobuf);
+	spdk_put_io_channel(ch->base_ch);
+}
+
+static int
+ra_ch_create_cb(void *io_device, void *ctx_buf)
+{
+	struct vbdev_readahead *ra = io_device;
+	struct ra_io_channel *ch = ctx_buf;
+	uint32_t i, num_segments;
+	int rc;
+
+	ch->ra = ra;
+	TAILQ_INIT(&ch->free_segments);
+	for (i = 0; i < READAHEAD_STREAMS; i++) {
+		TAILQ_INIT(&ch->streams[i].segments);
+		TAILQ_INIT(&ch->streams[i].waiters);
+		ch->streams[i].window = READAHEAD_MIN_WINDOW;
+	}
+
+	ch->base_ch = spdk_bdev_get_io_channel(ra->base_desc);
+	if (ch->base_ch == NULL) {
+		return -ENOMEM;
+	}
+
+	rc = spdk_iobuf_channel_init(&ch->iobuf, READAHEAD_IOBUF_NAME, 0, 0);
+	if (rc != 0) {
+		SPDK_ERRLOG("Could not create iobuf channel: %s\n", spdk_strerror(-rc));
+		spdk_put_io_channel(ch->base_ch);
+		return rc;
+	}
+
+	/* Segments of full windows, and as many the streams moved past but are still pending */
+	num_segments = READAHEAD_STREAMS * ra->max_window * 2;
+	ch->segment_array = calloc(num_segments, sizeof(*ch->segment_array));
+	ch->poller = SPDK_POLLER_REGISTER(ra_ch_poll, ch, READAHEAD_IDLE_US);
+	if (ch->segment_array == NULL || ch->poller == NULL) {
+		ra_ch_free(ch);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < num_segments; i++) {
+		ch->segment_array[i].ch = ch;
+		TAILQ_INSERT_TAIL(&ch->free_segments, &ch->segment_array[i], link);
+	}
+
+	pthread_mutex_lock(&ra->mutex);
+	TAILQ_INSERT_TAIL(&ra->channels, ch, link);
+	pthread_mutex_unlock(&ra->mutex);
+
+	return 0;
+}
+
+static void
+ra_ch_destroy_cb(void *io_device, void *ctx_buf)
+{
+	struct vbdev_readahead *ra = io_device;
+	struct ra_io_channel *ch = ctx_buf;
+
+	assert(ch->inflight == 0);
+
+	/* Releasing the segments accounts for the unused ones */
+	ra_ch_free(ch);
+
+	pthread_mutex_lock(&ra->mutex);
+	ra_stats_add(&ra->stats, &ch->stats);
+	TAILQ_REMOVE(&ra->channels, ch, link);
+	pthread_mutex_unlock(&ra->mutex);
+}
+
+static void
+vbdev_readahead_base_bdev_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev,
+				   void *event_ctx)
+{
+	struct vbdev_readahead *ra, *tmp;
+
+	switch (type) {
+	case SPDK_BDEV_EVENT_REMOVE:
+		TAILQ_FOREACH_SAFE(ra, &g_ra_nodes, link, tmp) {
+			if (ra->base_bdev == bdev) {
+				spdk_bdev_unregister(&ra->bdev, NULL, NULL);
+			}
+		}
+		break;
+	default:
+		SPDK_NOTICELOG("Unsupported bdev event: type %d\n", type);
+		break;
+	}
+}
+
+/* Segments are as large as iobuf buffers allow, the window is a number of segments */
+static int
+ra_init_segments(struct vbdev_readahead *ra, const struct bdev_readahead_opts *opts)
+{
+	struct spdk_bdev *base_bdev = ra->base_bdev;
+	struct spdk_iobuf_opts iobuf_opts;
+	uint32_t seg_size;
+
+	if (base_bdev->md_len != 0) {
+		SPDK_ERRLOG("Bdev %s with separate metadata is not supported\n", base_bdev->name);
+		return -EINVAL;
+	}
+
+	spdk_iobuf_get_opts(&iobuf_opts, sizeof(iobuf_opts));
+	seg_size = spdk_min(READAHEAD_SEGMENT_SIZE, iobuf_opts.large_bufsize);
+	ra->seg_blocks = seg_size / base_bdev->blocklen;
+	if (ra->seg_blocks == 0) {
+		SPDK_ERRLOG("Block size of bdev %s exceeds iobuf buffers\n", base_bdev->name);
+		return -EINVAL;
+	}
+
+	ra->opts = *opts;
+	ra->seg_size = ra->seg_blocks * base_bdev->blocklen;
+	ra->num_segments = spdk_divide_round_up(base_bdev->blockcnt, ra->seg_blocks);
+	ra->max_window = spdk_max(opts->max_window_size / ra->seg_size, READAHEAD_MIN_WINDOW);
+
+	return 0;
+}
+
+static int
+ra_register(struct vbdev_cache_assoc *assoc)
+{
+	struct vbdev_readahead *ra;
+	struct spdk_bdev *bdev;
+	struct spdk_uuid ns_uuid;
+	int rc;
+
+	if (spdk_bdev_get_by_name(assoc->vbdev_name) != NULL) {
+		return -EEXIST;
+	}
+
+	ra = calloc(1, sizeof(*ra));
+	if (ra == NULL) {
+		return -ENOMEM;
+	}
+
+	pthread_mutex_init(&ra->mutex, NULL);
+	TAILQ_INIT(&ra->channels);
+
+	ra->bdev.name = strdup(assoc->vbdev_name);
+	if (ra->bdev.name == NULL) {
+		ra_free(ra);
+		return -ENOMEM;
+	}
+
+	rc = spdk_bdev_open_ext(assoc->bdev_name, true, vbdev_readahead_base_bdev_event_cb, NULL,
+				&ra->base_desc);
+	if (rc != 0) {
+		if (rc != -ENODEV) {
+			SPDK_ERRLOG("Could not open bdev %s\n", assoc->bdev_name);
+		}
+		ra_free(ra);
+		return rc;
+	}
+	ra->base_bdev = bdev = spdk_bdev_desc_get_bdev(ra->base_desc);
+
+	rc = ra_init_segments(ra, assoc->opts);
+	if (rc != 0) {
+		goto err_close;
+	}
+
+	spdk_uuid_parse(&ns_uuid, BDEV_READAHEAD_NAMESPACE_UUID);
+	rc = spdk_uuid_generate_sha1(&ra->bdev.uuid, &ns_uuid, (const char *)&bdev->uuid,
+				     sizeof(struct spdk_uuid));
+	if (rc != 0) {
+		SPDK_ERRLOG("Unable to generate new UUID for readahead bdev\n");
+		goto err_close;
+	}
+
+	ra->bdev.product_name = "readahead";
+	ra->bdev.write_cache = bdev->write_cache;
+	ra->bdev.required_alignment = bdev->required_alignment;
+	ra->bdev.optimal_io_boundary = bdev->optimal_io_boundary;
+	ra->bdev.blocklen = bdev->blocklen;
+	ra->bdev.blockcnt = bdev->blockcnt;
+	ra->bdev.numa = bdev->numa;
+	ra->bdev.ctxt = ra;
+	ra->bdev.fn_table = &vbdev_readahead_fn_table;
+	ra->bdev.module = &readahead_if;
+	ra->thread = spdk_get_thread();
+
+	rc = spdk_bdev_module_claim_bdev(bdev, ra->base_desc, &readahead_if);
+	if (rc != 0) {
+		SPDK_ERRLOG("Could not claim bdev %s\n", bdev->name);
+		goto err_close;
+	}
+
+	spdk_io_device_register(ra, ra_ch_create_cb, ra_ch_destroy_cb,
+				sizeof(struct ra_io_channel), assoc->vbdev_name);
+	TAILQ_INSERT_TAIL(&g_ra_nodes, ra, link);
+
+	rc = spdk_bdev_register(&ra->bdev);
+	if (rc != 0) {
+		SPDK_ERRLOG("Could not register readahead bdev %s\n", assoc->vbdev_name);
+		TAILQ_REMOVE(&g_ra_nodes, ra, link);
+		spdk_io_device_unregister(ra, NULL);
+		spdk_bdev_module_release_bdev(bdev);
+		goto err_close;
+	}
+
+	SPDK_NOTICELOG("Created readahead bdev %s on %s with %" PRIu32 " KiB segments\n",
+		       assoc->vbdev_name, assoc->bdev_name, ra->seg_size / 1024);
+
+	return 0;
+
+err_close:
+	spdk_bdev_close(ra->base_desc);
+	ra_free(ra);
+
+	return rc;
+}
+
+void
+bdev_readahead_get_default_opts(struct bdev_readahead_opts *opts)
+{
+	memset(opts, 0, sizeof(*opts));
+	opts->max_window_size = BDEV_READAHEAD_DEFAULT_MAX_WINDOW;
+}
+
+int
+bdev_readahead_create_disk(const char *bdev_name, const char *vbdev_name,
+			   const struct bdev_readahead_opts *opts)
+{
+	struct vbdev_cache_assoc *assoc;
+	int rc;
+
+	if (opts->max_window_size == 0 || opts->max_window_size > BDEV_READAHEAD_MAX_WINDOW) {
+		SPDK_ERRLOG("Readahead window size %" PRIu32 " is not supported\n",
+			    opts->max_window_size);
+		return -EINVAL;
+	}
+
+	rc = vbdev_cache_assoc_add(&g_ra_assocs, vbdev_name, bdev_name, NULL, opts, sizeof(*opts),
+				   &assoc);
+	if (rc == -EEXIST) {
+		SPDK_ERRLOG("Readahead bdev %s already exists\n", vbdev_name);
+	}
+	if (rc != 0) {
+		return rc;
+	}
+
+	rc = ra_register(assoc);
+	if (rc == -ENODEV) {
+		SPDK_NOTICELOG("Readahead bdev %s creation deferred pending base bdev arrival\n",
+			       vbdev_name);
+		return 0;
+	}
+
+	if (rc != 0) {
+		vbdev_cache_assoc_remove(&g_ra_assocs, assoc);
+	}
+
+	return rc;
+}
+
+void
+bdev_readahead_delete_disk(const char *bdev_name, spdk_bdev_unregister_cb cb_fn, void *cb_arg)
+{
+	vbdev_cache_delete_disk(&g_ra_assocs, &readahead_if, bdev_name, cb_fn, cb_arg);
+}
+
+int
+bdev_readahead_get_stats(const char *bdev_name, bdev_readahead_stats_cb cb_fn, void *cb_arg)
+{
+	struct vbdev_readahead *ra;
+	struct bdev_readahead_stats stats;
+	bool found = false;
+
+	TAILQ_FOREACH(ra, &g_ra_nodes, link) {
+		if (bdev_name != NULL && strcmp(bdev_name, ra->bdev.name) != 0) {
+			continue;
+		}
+
+		ra_get_stats(ra, &stats);
+		cb_fn(cb_arg, ra->bdev.name, &stats);
+		found = true;
+	}
+
+	return (bdev_name == NULL || found) ? 0 : -ENODEV;
+}
+
+static void
+vbdev_readahead_examine(struct spdk_bdev *bdev)
+{
+	struct vbdev_cache_assoc *assoc;
+
+	TAILQ_FOREACH(assoc, &g_ra_assocs, link) {
+		if (vbdev_cache_assoc_uses(assoc, bdev->name)) {
+			ra_register(assoc);
+		}
+	}
+
+	spdk_bdev_module_examine_done(&readahead_if);
+}
+
+static int
+vbdev_readahead_init(void)
+{
+	int rc;
+
+	rc = spdk_iobuf_register_module(READAHEAD_IOBUF_NAME);
+	if (rc != 0) {
+		SPDK_ERRLOG("Could not register iobuf module: %s\n", spdk_strerror(-rc));
+	}
+
+	return rc;
+}
+
+static void
+vbdev_readahead_finish(void)
+{
+	vbdev_cache_assoc_clear(&g_ra_assocs);
+}
+
+static int
+vbdev_readahead_get_ctx_size(void)
+{
+	return sizeof(struct ra_bdev_io);
+}
+
+SPDK_LOG_REGISTER_COMPONENT(vbdev_readahead)
@@ -0,0 +1,85 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#ifndef SPDK_VBDEV_READAHEAD_H
+#define SPDK_VBDEV_READAHEAD_H
+
+#include "spdk/stdinc.h"
+
+#include "spdk/bdev.h"
+#include "spdk/bdev_module.h"
+
+#define BDEV_READAHEAD_DEFAULT_MAX_WINDOW	(2 * 1024 * 1024)
+#define BDEV_READAHEAD_MAX_WINDOW		(64 * 1024 * 1024)
+
+struct bdev_readahead_opts {
+	/* Largest amount of data prefetched ahead of a sequential stream, in bytes */
+	uint32_t	max_window_size;
+};
+
+struct bdev_readahead_stats {
+	/* Reads served from prefetched data, the ones among them that had to wait for the
+	 * prefetch to complete, and reads passed to the base bdev
+	 */
+	uint64_t read_hits;
+	uint64_t read_waits;
+	uint64_t read_misses;
+	/* Streams that became sequential enough to be prefetched */
+	uint64_t streams_detected;
+	/* Prefetch reads and their size, prefetched bytes released before they were read, and
+	 * prefetch reads not issued because no buffer was available
+	 */
+	uint64_t prefetch_reads;
+	uint64_t prefetch_bytes;
+	uint64_t prefetch_unused_bytes;
+	uint64_t prefetch_nobuf;
+	/* Prefetched data dropped because it was written meanwhile */
+	uint64_t invalidations;
+};
+
+typedef void (*bdev_readahead_stats_cb)(void *cb_arg, const char *name,
+					const struct bdev_readahead_stats *stats);
+
+/**
+ * Initialize readahead bdev options with default values.
+ *
+ * \param opts Options to initialize.
+ */
+void bdev_readahead_get_default_opts(struct bdev_readahead_opts *opts);
+
+/**
+ * Create a readahead bdev on top of a base bdev.
+ *
+ * If the base bdev does not exist yet, the readahead bdev is created once it appears.
+ *
+ * \param bdev_name Base bdev name.
+ * \param vbdev_name Name of the readahead bdev.
+ * \param opts Readahead bdev options.
+ * \return 0 on success, negative errno on failure.
+ */
+int bdev_readahead_create_disk(const char *bdev_name, const char *vbdev_name,
+			       const struct bdev_readahead_opts *opts);
+
+/**
+ * Delete readahead bdev.
+ *
+ * \param bdev_name Name of the readahead bdev.
+ * \param cb_fn Function to call after deletion.
+ * \param cb_arg Argument to pass to cb_fn.
+ */
+void bdev_readahead_delete_disk(const char *bdev_name, spdk_bdev_unregister_cb cb_fn,
+				void *cb_arg);
+
+/**
+ * Get statistics of readahead bdevs.
+ *
+ * \param bdev_name Name of the readahead bdev or NULL to report all of them.
+ * \param cb_fn Function called synchronously for each reported bdev.
+ * \param cb_arg Argument to pass to cb_fn.
+ * \return 0 on success, -ENODEV if bdev_name is not a readahead bdev.
+ */
+int bdev_readahead_get_stats(const char *bdev_name, bdev_readahead_stats_cb cb_fn, void *cb_arg);
+
+#endif /* SPDK_VBDEV_READAHEAD_H */
@@ -0,0 +1,158 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "vbdev_readahead.h"
+#include "spdk/rpc.h"
+#include "spdk/util.h"
+#include "spdk/string.h"
+#include "spdk/log.h"
+#include "spdk_internal/rpc_autogen.h"
+
+static void
+rpc_bdev_readahead_create(struct spdk_jsonrpc_request *request,
+			  const struct spdk_json_val *params)
+{
+	struct rpc_bdev_readahead_create_ctx req = {};
+	struct bdev_readahead_opts opts;
+	struct spdk_json_write_ctx *w;
+	int rc;
+
+	bdev_readahead_get_default_opts(&opts);
+	req.max_window_kb = opts.max_window_size / 1024;
+
+	if (spdk_json_decode_object(params, rpc_bdev_readahead_create_decoders,
+				    SPDK_COUNTOF(rpc_bdev_readahead_create_decoders),
+				    &req)) {
+		SPDK_DEBUGLOG(vbdev_readahead, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	if (req.max_window_kb > BDEV_READAHEAD_MAX_WINDOW / 1024) {
+		spdk_jsonrpc_send_error_response(request, -EINVAL, spdk_strerror(EINVAL));
+		goto cleanup;
+	}
+
+	opts.max_window_size = req.max_window_kb * 1024;
+
+	rc = bdev_readahead_create_disk(req.base_bdev_name, req.name, &opts);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_string(w, req.name);
+	spdk_jsonrpc_end_result(request, w);
+
+cleanup:
+	free_rpc_bdev_readahead_create(&req);
+}
+SPDK_RPC_REGISTER("bdev_readahead_create", rpc_bdev_readahead_create, SPDK_RPC_RUNTIME)
+
+static void
+rpc_bdev_readahead_delete_cb(void *cb_arg, int bdeverrno)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+
+	if (bdeverrno == 0) {
+		spdk_jsonrpc_send_bool_response(request, true);
+	} else {
+		spdk_jsonrpc_send_error_response(request, bdeverrno, spdk_strerror(-bdeverrno));
+	}
+}
+
+static void
+rpc_bdev_readahead_delete(struct spdk_jsonrpc_request *request,
+			  const struct spdk_json_val *params)
+{
+	struct rpc_bdev_readahead_delete_ctx req = {};
+
+	if (spdk_json_decode_object(params, rpc_bdev_readahead_delete_decoders,
+				    SPDK_COUNTOF(rpc_bdev_readahead_delete_decoders),
+				    &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	bdev_readahead_delete_disk(req.name, rpc_bdev_readahead_delete_cb, request);
+
+cleanup:
+	free_rpc_bdev_readahead_delete(&req);
+}
+SPDK_RPC_REGISTER("bdev_readahead_delete", rpc_bdev_readahead_delete, SPDK_RPC_RUNTIME)
+
+struct rpc_bdev_readahead_get_stats_cb_ctx {
+	struct spdk_jsonrpc_request	*request;
+	struct spdk_json_write_ctx	*w;
+};
+
+static void
+rpc_bdev_readahead_write_stats(void *cb_arg, const char *name,
+			       const struct bdev_readahead_stats *stats)
+{
+	struct rpc_bdev_readahead_get_stats_cb_ctx *ctx = cb_arg;
+	struct spdk_json_write_ctx *w;
+	uint64_t reads = stats->read_hits + stats->read_misses;
+
+	/* The result is only started once we know the request does not fail */
+	if (ctx->w == NULL) {
+		ctx->w = spdk_jsonrpc_begin_result(ctx->request);
+		spdk_json_write_array_begin(ctx->w);
+	}
+	w = ctx->w;
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "name", name);
+	spdk_json_write_named_uint64(w, "read_hits", stats->read_hits);
+	spdk_json_write_named_uint64(w, "read_waits", stats->read_waits);
+	spdk_json_write_named_uint64(w, "read_misses", stats->read_misses);
+	spdk_json_write_named_double(w, "hit_ratio", reads == 0 ? 0.0 :
+				     (double)stats->read_hits / reads);
+	spdk_json_write_named_uint64(w, "streams_detected", stats->streams_detected);
+	spdk_json_write_named_uint64(w, "prefetch_reads", stats->prefetch_reads);
+	spdk_json_write_named_uint64(w, "prefetch_bytes", stats->prefetch_bytes);
+	spdk_json_write_named_uint64(w, "prefetch_unused_bytes", stats->prefetch_unused_bytes);
+	spdk_json_write_named_uint64(w, "prefetch_nobuf", stats->prefetch_nobuf);
+	spdk_json_write_named_uint64(w, "invalidations", stats->invalidations);
+	spdk_json_write_object_end(w);
+}
+
+static void
+rpc_bdev_readahead_get_stats(struct spdk_jsonrpc_request *request,
+			     const struct spdk_json_val *params)
+{
+	struct rpc_bdev_readahead_get_stats_ctx req = {};
+	struct rpc_bdev_readahead_get_stats_cb_ctx ctx = { .request = request };
+	int rc;
+
+	if (params && spdk_json_decode_object(params, rpc_bdev_readahead_get_stats_decoders,
+					      SPDK_COUNTOF(rpc_bdev_readahead_get_stats_decoders),
+					      &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = bdev_readahead_get_stats(req.name, rpc_bdev_readahead_write_stats, &ctx);
+	if (rc != 0) {
+		assert(ctx.w == NULL);
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	if (ctx.w == NULL) {
+		ctx.w = spdk_jsonrpc_begin_result(request);
+		spdk_json_write_array_begin(ctx.w);
+	}
+	spdk_json_write_array_end(ctx.w);
+	spdk_jsonrpc_end_result(request, ctx.w);
+
+cleanup:
+	free_rpc_bdev_readahead_get_stats(&req);
+}
+SPDK_RPC_REGISTER("bdev_readahead_get_stats", rpc_bdev_readahead_get_stats, SPDK_RPC_RUNTIME)
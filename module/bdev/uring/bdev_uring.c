@@ -9,6 +9,7 @@
 #include "spdk/config.h"
 #include "spdk/barrier.h"
 #include "spdk/bdev.h"
+#include "spdk/dma.h"
 #include "spdk/env.h"
 #include "spdk/fd.h"
 #include "spdk/likely.h"
@@ -26,6 +27,18 @@
 #define SECTOR_SHIFT 9
 #endif
 
+#ifdef SPDK_CONFIG_UBLK
+#include <linux/ublk_cmd.h>
+
+#ifndef UBLK_U_IO_REGISTER_IO_BUF
+#define UBLK_U_IO_REGISTER_IO_BUF	_IOWR('u', 0x23, struct ublksrv_io_cmd)
+#endif
+
+#ifndef UBLK_U_IO_UNREGISTER_IO_BUF
+#define UBLK_U_IO_UNREGISTER_IO_BUF	_IOWR('u', 0x24, struct ublksrv_io_cmd)
+#endif
+#endif
+
 #define URING_LOG_FMT "%s,uring:%p,filename:%s"
 #define URING_LOG_ARGS(uring) \
   (uring)->bdev.name, \
@@ -67,11 +80,19 @@ struct bdev_uring_group_channel {
 	struct spdk_poller			*poller;
 	struct io_uring				uring;
 	bool					detached;
+	/* Free slots of the fixed buffer table used for ublk zero-copy requests */
+	uint16_t				*zc_free_slots;
+	uint32_t				zc_num_free_slots;
 };
 
 struct bdev_uring_task {
 	uint64_t			len;
 	struct bdev_uring_io_channel	*ch;
+	/* Zero-copy requests complete once the buffer registration commands are reaped too */
+	uint32_t			zc_cqes;
+	uint16_t			zc_slot;
+	bool				zc_registered;
+	int32_t				res;
 	TAILQ_ENTRY(bdev_uring_task)	link;
 };
 
@@ -93,6 +114,14 @@ static TAILQ_HEAD(, bdev_uring) g_uring_bdev_head = TAILQ_HEAD_INITIALIZER(g_uri
 #define SPDK_URING_QUEUE_DEPTH 512
 #define MAX_EVENTS_PER_POLL 32
 
+/* Tags in the low bits of user_data marking the completions of buffer registration commands */
+#define URING_ZC_REGISTER	0x1ULL
+#define URING_ZC_UNREGISTER	0x2ULL
+#define URING_ZC_CMD_MASK	(URING_ZC_REGISTER | URING_ZC_UNREGISTER)
+
+/* The kernel supports fixed buffer tables, so ublk request pages can be registered */
+static bool g_uring_zero_copy;
+
 static int
 bdev_uring_get_ctx_size(void)
 {
@@ -254,6 +283,7 @@ bdev_uring_readv(struct bdev_uring *uring, struct spdk_io_channel *ch,
 	io_uring_sqe_set_data(sqe, uring_task);
 	uring_task->len = nbytes;
 	uring_task->ch = uring_ch;
+	uring_task->zc_cqes = 0;
 
 	URING_DEBUGLOG(uring, "read %d iovs size %lu to off: %#lx\n", iovcnt, nbytes, offset);
 
@@ -280,6 +310,7 @@ bdev_uring_writev(struct bdev_uring *uring, struct spdk_io_channel *ch,
 	io_uring_sqe_set_data(sqe, uring_task);
 	uring_task->len = nbytes;
 	uring_task->ch = uring_ch;
+	uring_task->zc_cqes = 0;
 
 	URING_DEBUGLOG(uring, "write %d iovs size %lu from off: %#lx\n", iovcnt, nbytes, offset);
 
@@ -287,6 +318,133 @@ bdev_uring_writev(struct bdev_uring *uring, struct spdk_io_channel *ch,
 	return nbytes;
 }
 
+#ifdef SPDK_CONFIG_UBLK
+static void
+bdev_uring_prep_ublk_buf_cmd(struct io_uring_sqe *sqe, uint32_t cmd_op,
+			     const struct spdk_memory_domain_translation_result *translation,
+			     uint16_t slot)
+{
+	struct ublksrv_io_cmd *cmd = (struct ublksrv_io_cmd *)&sqe->addr3;
+
+	io_uring_prep_rw(IORING_OP_URING_CMD, sqe, translation->ublk.fd, NULL, 0, 0);
+	sqe->off = cmd_op;
+	cmd->q_id = translation->ublk.q_id;
+	cmd->tag = translation->ublk.tag;
+	cmd->result = 0;
+	cmd->addr = slot;
+}
+
+/*
+ * Data of ublk requests lives in kernel pages that cannot be mapped.  Register them as a
+ * fixed buffer of this ring, do the I/O on the fixed buffer and unregister it again, all
+ * in one linked chain.  The unregistration is hard-linked so that it runs even if the
+ * I/O fails.
+ */
+static int64_t
+bdev_uring_zcopy_rw(struct bdev_uring *uring, struct spdk_io_channel *ch,
+		    struct bdev_uring_task *uring_task, struct spdk_bdev_io *bdev_io,
+		    uint64_t nbytes, uint64_t offset)
+{
+	struct bdev_uring_io_channel *uring_ch = spdk_io_channel_get_ctx(ch);
+	struct bdev_uring_group_channel *group_ch = uring_ch->group_ch;
+	struct spdk_memory_domain *domain = bdev_io->u.bdev.memory_domain;
+	struct spdk_memory_domain_translation_result translation = { .size = sizeof(translation) };
+	struct io_uring_sqe *sqe;
+	uint16_t slot;
+	int rc;
+
+	if (spdk_memory_domain_get_dma_device_type(domain) != SPDK_DMA_DEVICE_TYPE_UBLK ||
+	    bdev_io->u.bdev.iovcnt != 1) {
+		URING_ERRLOG(uring, "Unsupported data buffer in memory domain %s\n",
+			     spdk_memory_domain_get_dma_device_id(domain));
+		return -ENOTSUP;
+	}
+
+	rc = spdk_memory_domain_translate_data(domain, bdev_io->u.bdev.memory_domain_ctx, domain,
+					       NULL, bdev_io->u.bdev.iovs[0].iov_base,
+					       bdev_io->u.bdev.iovs[0].iov_len, &translation);
+	if (rc != 0) {
+		URING_ERRLOG(uring, "Failed to translate ublk data buffer, rc %d\n", rc);
+		return rc;
+	}
+
+	if (group_ch->zc_num_free_slots == 0 || io_uring_sq_space_left(&group_ch->uring) < 3) {
+		URING_DEBUGLOG(uring, "no fixed buffer slot or sqe available\n");
+		return -ENOMEM;
+	}
+	slot = group_ch->zc_free_slots[--group_ch->zc_num_free_slots];
+
+	sqe = io_uring_get_sqe(&group_ch->uring);
+	bdev_uring_prep_ublk_buf_cmd(sqe, UBLK_U_IO_REGISTER_IO_BUF, &translation, slot);
+	sqe->flags |= IOSQE_IO_LINK;
+	io_uring_sqe_set_data64(sqe, (uintptr_t)uring_task | URING_ZC_REGISTER);
+
+	sqe = io_uring_get_sqe(&group_ch->uring);
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_READ) {
+		io_uring_prep_read_fixed(sqe, uring->fd, (void *)(uintptr_t)translation.ublk.offset,
+					 nbytes, offset, slot);
+	} else {
+		io_uring_prep_write_fixed(sqe, uring->fd,
+					  (void *)(uintptr_t)translation.ublk.offset,
+					  nbytes, offset, slot);
+	}
+	sqe->flags |= IOSQE_IO_HARDLINK;
+	io_uring_sqe_set_data(sqe, uring_task);
+
+	sqe = io_uring_get_sqe(&group_ch->uring);
+	bdev_uring_prep_ublk_buf_cmd(sqe, UBLK_U_IO_UNREGISTER_IO_BUF, &translation, slot);
+	io_uring_sqe_set_data64(sqe, (uintptr_t)uring_task | URING_ZC_UNREGISTER);
+
+	uring_task->len = nbytes;
+	uring_task->ch = uring_ch;
+	uring_task->zc_cqes = 3;
+	uring_task->zc_slot = slot;
+	uring_task->zc_registered = false;
+	uring_task->res = -ECANCELED;
+
+	URING_DEBUGLOG(uring, "zero-copy %s size %lu at off: %#lx, slot %u\n",
+		       bdev_io->type == SPDK_BDEV_IO_TYPE_READ ? "read" : "write",
+		       nbytes, offset, slot);
+
+	group_ch->io_pending += 3;
+	return nbytes;
+}
+
+/* Returns true once all completions of a zero-copy request have been reaped */
+static bool
+bdev_uring_zcopy_reap(struct bdev_uring_group_channel *group_ch,
+		      struct bdev_uring_task *uring_task, uint64_t zc_cmd, int res)
+{
+	switch (zc_cmd) {
+	case URING_ZC_REGISTER:
+		uring_task->zc_registered = (res == 0);
+		break;
+	case URING_ZC_UNREGISTER:
+		if (uring_task->zc_registered && res != 0) {
+			/* Keep the slot out of use, it still holds the request pages */
+			SPDK_ERRLOG("Failed to unregister fixed buffer %u: %s\n",
+				    uring_task->zc_slot, spdk_strerror(-res));
+		} else {
+			uring_task->zc_registered = false;
+		}
+		break;
+	default:
+		uring_task->res = res;
+		break;
+	}
+
+	if (--uring_task->zc_cqes != 0) {
+		return false;
+	}
+
+	if (!uring_task->zc_registered) {
+		group_ch->zc_free_slots[group_ch->zc_num_free_slots++] = uring_task->zc_slot;
+	}
+
+	return true;
+}
+#endif
+
 static int
 bdev_uring_destruct(void *ctx)
 {
@@ -300,16 +458,56 @@ bdev_uring_destruct(void *ctx)
 	return rc;
 }
 
+static void
+bdev_uring_task_complete(struct bdev_uring_group_channel *group_ch,
+			 struct bdev_uring_task *uring_task, int rc)
+{
+	enum spdk_bdev_io_status status;
+	struct spdk_bdev_io *bdev_io;
+	struct bdev_uring *uring;
+
+	bdev_io = spdk_bdev_io_from_ctx(uring_task);
+	if (spdk_unlikely(rc != (signed)uring_task->len)) {
+		uring = uring_from_bdev(bdev_io->bdev);
+
+		/* Since spdk_fd_get_size is not cost-free, we prioritize the check for -EAGAIN/-EWOULDBLOCK
+		 * as it's not likely that these errors are returned when a device is detached.
+		 */
+		if (rc == -EAGAIN || rc == -EWOULDBLOCK) {
+			status = SPDK_BDEV_IO_STATUS_NOMEM;
+		} else {
+			/* When the block device device is detached from the system, IOs fail with different
+			 * observed res such as 0, -EIO or -ENOSPC.
+			 * In this case the ioctl BLKGETSIZE64 yields a device size of 0.
+			 * Note that re-attaching the device will not correct this because the existing fd is
+			 * still invalid.
+			 */
+			if (!group_ch->detached && spdk_fd_get_size(uring->fd) == 0) {
+				group_ch->detached = true;
+			}
+
+			if (group_ch->detached) {
+				bdev_uring_try_hot_remove(uring);
+			} else {
+				URING_ERRLOG(uring, "I/O failed with error %d\n", rc);
+			}
+			status = SPDK_BDEV_IO_STATUS_FAILED;
+		}
+	} else {
+		status = SPDK_BDEV_IO_STATUS_SUCCESS;
+	}
+
+	spdk_bdev_io_complete(bdev_io, status);
+}
+
 static int
 bdev_uring_reap(struct bdev_uring_group_channel *group_ch, int max)
 {
 	int i, count, rc;
 	struct io_uring_cqe *cqe;
 	struct bdev_uring_task *uring_task;
-	enum spdk_bdev_io_status status;
-	struct spdk_bdev_io *bdev_io;
-	struct bdev_uring *uring;
 	struct io_uring *ring = &group_ch->uring;
+	uint64_t user_data;
 
 	count = 0;
 	for (i = 0; i < max; i++) {
@@ -321,43 +519,24 @@ bdev_uring_reap(struct bdev_uring_group_channel *group_ch, int max)
 
 		assert(cqe != NULL);
 
-		uring_task = (struct bdev_uring_task *)cqe->user_data;
-		bdev_io = spdk_bdev_io_from_ctx(uring_task);
+		user_data = cqe->user_data;
+		uring_task = (struct bdev_uring_task *)(uintptr_t)(user_data & ~URING_ZC_CMD_MASK);
 		rc = cqe->res;
-		if (spdk_unlikely(rc != (signed)uring_task->len)) {
-			uring = uring_from_bdev(bdev_io->bdev);
 
-			/* Since spdk_fd_get_size is not cost-free, we prioritize the check for -EAGAIN/-EWOULDBLOCK
-			 * as it's not likely that these errors are returned when a device is detached.
-			 */
-			if (rc == -EAGAIN || rc == -EWOULDBLOCK) {
-				status = SPDK_BDEV_IO_STATUS_NOMEM;
-			} else {
-				/* When the block device device is detached from the system, IOs fail with different
-				 * observed res such as 0, -EIO or -ENOSPC.
-				 * In this case the ioctl BLKGETSIZE64 yields a device size of 0.
-				 * Note that re-attaching the device will not correct this because the existing fd is
-				 * still invalid.
-				 */
-				if (!group_ch->detached && spdk_fd_get_size(uring->fd) == 0) {
-					group_ch->detached = true;
-				}
-
-				if (group_ch->detached) {
-					bdev_uring_try_hot_remove(uring);
-				} else {
-					URING_ERRLOG(uring, "I/O failed with error %d\n", rc);
-				}
-				status = SPDK_BDEV_IO_STATUS_FAILED;
-			}
-		} else {
-			status = SPDK_BDEV_IO_STATUS_SUCCESS;
-		}
-
-		uring_task->ch->group_ch->io_inflight--;
+		group_ch->io_inflight--;
 		io_uring_cqe_seen(ring, cqe);
-		spdk_bdev_io_complete(bdev_io, status);
 		count++;
+
+#ifdef SPDK_CONFIG_UBLK
+		if (uring_task->zc_cqes != 0) {
+			if (!bdev_uring_zcopy_reap(group_ch, uring_task,
+						   user_data & URING_ZC_CMD_MASK, rc)) {
+				continue;
+			}
+			rc = uring_task->res;
+		}
+#endif
+		bdev_uring_task_complete(group_ch, uring_task, rc);
 	}
 
 	return count;
@@ -699,6 +878,24 @@ bdev_uring_check_zoned_support(struct bdev_uring *uring, const char *name, const
 }
 #endif
 
+#ifdef SPDK_CONFIG_UBLK
+static void
+bdev_uring_zcopy_submit(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	int64_t ret;
+
+	ret = bdev_uring_zcopy_rw(uring_from_bdev(bdev_io->bdev), ch,
+				  (struct bdev_uring_task *)bdev_io->driver_ctx, bdev_io,
+				  bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen,
+				  bdev_io->u.bdev.offset_blocks * bdev_io->bdev->blocklen);
+	if (ret == -ENOMEM) {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_NOMEM);
+	} else if (ret < 0) {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+#endif
+
 static int
 _bdev_uring_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
 {
@@ -713,6 +910,12 @@ _bdev_uring_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev
 	 * get the aligned buffer from the pool by calling spdk_bdev_io_get_buf. */
 	case SPDK_BDEV_IO_TYPE_READ:
 	case SPDK_BDEV_IO_TYPE_WRITE:
+#ifdef SPDK_CONFIG_UBLK
+		if (bdev_io->u.bdev.memory_domain != NULL) {
+			bdev_uring_zcopy_submit(ch, bdev_io);
+			return 0;
+		}
+#endif
 		spdk_bdev_io_get_buf(bdev_io, bdev_uring_get_buf_cb,
 				     bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen);
 		return 0;
@@ -806,6 +1009,21 @@ bdev_uring_write_json_config(struct spdk_bdev *bdev, struct spdk_json_write_ctx
 	spdk_json_write_object_end(w);
 }
 
+static int
+bdev_uring_get_memory_domain_types(void *ctx, enum spdk_dma_device_type *types,
+				   uint32_t array_size)
+{
+	if (!g_uring_zero_copy) {
+		return 0;
+	}
+
+	if (array_size > 0) {
+		types[0] = SPDK_DMA_DEVICE_TYPE_UBLK;
+	}
+
+	return 1;
+}
+
 static const struct spdk_bdev_fn_table uring_fn_table = {
 	.destruct		= bdev_uring_destruct,
 	.submit_request		= bdev_uring_submit_request,
@@ -813,6 +1031,7 @@ static const struct spdk_bdev_fn_table uring_fn_table = {
 	.get_io_channel		= bdev_uring_get_io_channel,
 	.dump_info_json		= bdev_uring_dump_info_json,
 	.write_config_json	= bdev_uring_write_json_config,
+	.get_memory_domain_types = bdev_uring_get_memory_domain_types,
 };
 
 static void
@@ -830,6 +1049,7 @@ static int
 bdev_uring_group_create_cb(void *io_device, void *ctx_buf)
 {
 	struct bdev_uring_group_channel *ch = ctx_buf;
+	uint32_t i;
 
 	/* Do not use IORING_SETUP_IOPOLL until the Linux kernel can support not only
 	 * local devices but also devices attached from remote target */
@@ -838,6 +1058,22 @@ bdev_uring_group_create_cb(void *io_device, void *ctx_buf)
 		return -1;
 	}
 
+	if (g_uring_zero_copy) {
+		ch->zc_free_slots = calloc(SPDK_URING_QUEUE_DEPTH, sizeof(*ch->zc_free_slots));
+		if (ch->zc_free_slots == NULL ||
+		    io_uring_register_buffers_sparse(&ch->uring, SPDK_URING_QUEUE_DEPTH) != 0) {
+			SPDK_ERRLOG("uring fixed buffer table setup failure\n");
+			free(ch->zc_free_slots);
+			io_uring_queue_exit(&ch->uring);
+			return -1;
+		}
+
+		for (i = 0; i < SPDK_URING_QUEUE_DEPTH; i++) {
+			ch->zc_free_slots[i] = SPDK_URING_QUEUE_DEPTH - i - 1;
+		}
+		ch->zc_num_free_slots = SPDK_URING_QUEUE_DEPTH;
+	}
+
 	ch->poller = SPDK_POLLER_REGISTER(bdev_uring_group_poll, ch, 0);
 	return 0;
 }
@@ -848,6 +1084,7 @@ bdev_uring_group_destroy_cb(void *io_device, void *ctx_buf)
 	struct bdev_uring_group_channel *ch = ctx_buf;
 
 	io_uring_queue_exit(&ch->uring);
+	free(ch->zc_free_slots);
 
 	spdk_poller_unregister(&ch->poller);
 }
@@ -998,9 +1235,31 @@ delete_uring_bdev(const char *name, spdk_delete_uring_complete cb_fn, void *cb_a
 	}
 }
 
+static bool
+bdev_uring_probe_zero_copy(void)
+{
+#ifdef SPDK_CONFIG_UBLK
+	struct io_uring ring;
+	bool supported;
+
+	if (io_uring_queue_init(1, &ring, 0) < 0) {
+		return false;
+	}
+
+	supported = io_uring_register_buffers_sparse(&ring, 1) == 0;
+	io_uring_queue_exit(&ring);
+
+	return supported;
+#else
+	return false;
+#endif
+}
+
 static int
 bdev_uring_init(void)
 {
+	g_uring_zero_copy = bdev_uring_probe_zero_copy();
+
 	spdk_io_device_register(&uring_if, bdev_uring_group_create_cb, bdev_uring_group_destroy_cb,
 				sizeof(struct bdev_uring_group_channel), "uring_module");
 
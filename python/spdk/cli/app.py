@@ -99,13 +99,20 @@ def add_parser(subparsers):
     def scheduler_set_options(args):
         args.client.scheduler_set_options(
                                       isolated_core_mask=args.isolated_core_mask,
-                                      scheduling_core=args.scheduling_core)
+                                      scheduling_core=args.scheduling_core,
+                                      work_stealing=args.work_stealing,
+                                      work_stealing_period=args.work_stealing_period)
     p = subparsers.add_parser('scheduler_set_options', help='Set scheduler options')
     p.add_argument('-i', '--isolated-core-mask',
                    help='CPU mask of cores excluded from scheduling decisions; must not include scheduling_core', type=str)
     p.add_argument('-s', '--scheduling-core',
                    help='Core that the scheduler runs on; idle threads are moved here. Default: current scheduling core',
                    type=int)
+    p.add_argument('--work-stealing', action=argparse.BooleanOptionalAction,
+                   help='Let idle reactors take threads from busy reactors between scheduling periods')
+    p.add_argument('--work-stealing-period',
+                   help='Period in microseconds over which reactors measure their load for work stealing',
+                   type=int)
     p.set_defaults(func=scheduler_set_options)
 
     def framework_disable_cpumask_locks(args):
@@ -140,6 +147,15 @@ def add_parser(subparsers):
     p.add_argument('-m', '--cpumask', help='CPU mask of cores the thread is allowed to run on', required=True)
     p.set_defaults(func=thread_set_cpumask)
 
+    def thread_set_msg_batching(args):
+        print_dict(args.client.thread_set_msg_batching(enabled=args.enabled))
+
+    p = subparsers.add_parser('thread_set_msg_batching',
+                              help='Enable or disable batching of messages sent between threads')
+    p.add_argument('--enable', dest='enabled', action=argparse.BooleanOptionalAction, required=True,
+                   help='Enable or disable batching of messages sent between threads')
+    p.set_defaults(func=thread_set_msg_batching)
+
     def thread_get_pollers(args):
         print_dict(args.client.thread_get_pollers())
 
@@ -580,6 +580,122 @@ def add_parser(subparsers):
     p.add_argument('name', help='pass through bdev name')
     p.set_defaults(func=bdev_passthru_delete)
 
+    def bdev_dedup_create(args):
+        print_json(args.client.bdev_dedup_create(base_bdev_name=args.base_bdev_name,
+                                                 name=args.name,
+                                                 num_blocks=args.num_blocks))
+
+    p = subparsers.add_parser('bdev_dedup_create', help='Format a bdev and create a dedup bdev on it')
+    p.add_argument('-b', '--base-bdev-name', help="Name of the base bdev, its data is lost", required=True)
+    p.add_argument('-p', '--name', help="Name of the dedup bdev", required=True)
+    p.add_argument('-n', '--num-blocks', help="Number of blocks of the dedup bdev", type=int)
+    p.set_defaults(func=bdev_dedup_create)
+
+    def bdev_dedup_delete(args):
+        args.client.bdev_dedup_delete(name=args.name)
+
+    p = subparsers.add_parser('bdev_dedup_delete', help='Delete a dedup bdev')
+    p.add_argument('name', help='dedup bdev name')
+    p.set_defaults(func=bdev_dedup_delete)
+
+    def bdev_dedup_get_stats(args):
+        print_dict(args.client.bdev_dedup_get_stats(name=args.name))
+
+    p = subparsers.add_parser('bdev_dedup_get_stats', help='Display capacity savings and index statistics of dedup bdevs')
+    p.add_argument('-b', '--name', help="Name of the dedup bdev")
+    p.set_defaults(func=bdev_dedup_get_stats)
+
+    def bdev_compress_create(args):
+        print_json(args.client.bdev_compress_create(base_bdev_name=args.base_bdev_name,
+                                                    name=args.name,
+                                                    num_blocks=args.num_blocks,
+                                                    chunk_size=args.chunk_size,
+                                                    comp_algo=args.comp_algo,
+                                                    comp_level=args.comp_level))
+
+    p = subparsers.add_parser('bdev_compress_create', help='Format a bdev and create a compress bdev on it')
+    p.add_argument('-b', '--base-bdev-name', help="Name of the base bdev, its data is lost", required=True)
+    p.add_argument('-p', '--name', help="Name of the compress bdev", required=True)
+    p.add_argument('-n', '--num-blocks', help="Number of blocks of the compress bdev", type=int)
+    p.add_argument('-c', '--chunk-size', help="Size of the chunks compressed as a unit, in bytes", type=int)
+    p.add_argument('-a', '--comp-algo', help="Compression algorithm", choices=['deflate', 'lz4'])
+    p.add_argument('-l', '--comp-level', help="Compression level", type=int)
+    p.set_defaults(func=bdev_compress_create)
+
+    def bdev_compress_delete(args):
+        args.client.bdev_compress_delete(name=args.name)
+
+    p = subparsers.add_parser('bdev_compress_delete', help='Delete a compress bdev')
+    p.add_argument('name', help='compress bdev name')
+    p.set_defaults(func=bdev_compress_delete)
+
+    def bdev_compress_get_stats(args):
+        print_dict(args.client.bdev_compress_get_stats(name=args.name))
+
+    p = subparsers.add_parser('bdev_compress_get_stats', help='Display compression ratio and latency statistics of compress bdevs')
+    p.add_argument('-b', '--name', help="Name of the compress bdev")
+    p.set_defaults(func=bdev_compress_get_stats)
+
+    def bdev_cache_create(args):
+        print_json(args.client.bdev_cache_create(base_bdev_name=args.base_bdev_name,
+                                                 name=args.name,
+                                                 cache_bdev_name=args.cache_bdev_name,
+                                                 cache_size_mb=args.cache_size_mb,
+                                                 line_size=args.line_size,
+                                                 mode=args.mode,
+                                                 admission_filter=args.admission_filter))
+
+    p = subparsers.add_parser('bdev_cache_create', help='Create a read cache bdev on top of a bdev')
+    p.add_argument('-b', '--base-bdev-name', help="Name of the bdev to cache", required=True)
+    p.add_argument('-p', '--name', help="Name of the cache bdev", required=True)
+    p.add_argument('-c', '--cache-bdev-name', help="Name of the bdev holding the cached data, DRAM if omitted")
+    p.add_argument('-s', '--cache-size-mb', help="Cache capacity in MiB", type=int)
+    p.add_argument('-l', '--line-size', help="Size of the cache lines, in bytes", type=int)
+    p.add_argument('-m', '--mode', help="Write handling", choices=['write_through', 'write_around'])
+    p.add_argument('-n', '--no-admission-filter', help="Admit every missed line into the cache",
+                   action='store_false', dest='admission_filter', default=None)
+    p.set_defaults(func=bdev_cache_create)
+
+    def bdev_cache_delete(args):
+        args.client.bdev_cache_delete(name=args.name)
+
+    p = subparsers.add_parser('bdev_cache_delete', help='Delete a cache bdev')
+    p.add_argument('name', help='cache bdev name')
+    p.set_defaults(func=bdev_cache_delete)
+
+    def bdev_cache_get_stats(args):
+        print_dict(args.client.bdev_cache_get_stats(name=args.name))
+
+    p = subparsers.add_parser('bdev_cache_get_stats', help='Display hit ratio and latency statistics of cache bdevs')
+    p.add_argument('-b', '--name', help="Name of the cache bdev")
+    p.set_defaults(func=bdev_cache_get_stats)
+
+    def bdev_readahead_create(args):
+        print_json(args.client.bdev_readahead_create(base_bdev_name=args.base_bdev_name,
+                                                     name=args.name,
+                                                     max_window_kb=args.max_window_kb))
+
+    p = subparsers.add_parser('bdev_readahead_create', help='Create a bdev prefetching sequential reads from a bdev')
+    p.add_argument('-b', '--base-bdev-name', help="Name of the bdev to read ahead from", required=True)
+    p.add_argument('-p', '--name', help="Name of the readahead bdev", required=True)
+    p.add_argument('-w', '--max-window-kb', help="Largest amount of data prefetched ahead of a stream, in KiB",
+                   type=int)
+    p.set_defaults(func=bdev_readahead_create)
+
+    def bdev_readahead_delete(args):
+        args.client.bdev_readahead_delete(name=args.name)
+
+    p = subparsers.add_parser('bdev_readahead_delete', help='Delete a readahead bdev')
+    p.add_argument('name', help='readahead bdev name')
+    p.set_defaults(func=bdev_readahead_delete)
+
+    def bdev_readahead_get_stats(args):
+        print_dict(args.client.bdev_readahead_get_stats(name=args.name))
+
+    p = subparsers.add_parser('bdev_readahead_get_stats', help='Display hit ratio and prefetch statistics of readahead bdevs')
+    p.add_argument('-b', '--name', help="Name of the readahead bdev")
+    p.set_defaults(func=bdev_readahead_get_stats)
+
     def bdev_get_bdevs(args):
         print_dict(args.client.bdev_get_bdevs(name=args.name, timeout=args.timeout))
 
@@ -697,6 +813,17 @@ def add_parser(subparsers):
                    type=int)
     p.set_defaults(func=bdev_set_qos_limit)
 
+    def bdev_set_io_merge(args):
+        args.client.bdev_set_io_merge(name=args.name, window_us=args.window_us, max_size_kb=args.max_size_kb)
+
+    p = subparsers.add_parser('bdev_set_io_merge',
+                              help='Merge adjacent reads and writes submitted within a time window')
+    p.add_argument('name', help='Blockdev name. Example: Malloc0')
+    p.add_argument('window_us', help='Longest time an I/O is held waiting for adjacent I/Os in microseconds.'
+                   ' If set to 0, merging will be disabled.', type=int)
+    p.add_argument('-s', '--max-size-kb', help='Largest size of a merged I/O in KiB (default: 128)', type=int)
+    p.set_defaults(func=bdev_set_io_merge)
+
     def bdev_error_inject_error(args):
         args.client.bdev_error_inject_error(
                                          name=args.name,
@@ -771,7 +898,7 @@ def add_parser(subparsers):
     p = subparsers.add_parser('bdev_raid_create', help='Create new raid bdev')
     p.add_argument('-n', '--name', help='raid bdev name', required=True)
     p.add_argument('-z', '--strip-size-kb', help='strip size in KB', type=int)
-    p.add_argument('-r', '--raid-level', choices=['raid0', '0', 'raid1', '1', 'raid5f', '5f', 'concat'], help='Raid level', required=True)
+    p.add_argument('-r', '--raid-level', choices=['raid0', '0', 'raid1', '1', 'raid5f', '5f', 'raid6', '6', 'concat'], help='Raid level', required=True)
     p.add_argument('-b', '--base-bdevs', help='base bdevs name, whitespace separated list in quotes', required=True, type=str.split)
     p.add_argument('--uuid', help='UUID for this raid bdev')
     p.add_argument('-s', '--superblock', help='information about raid bdev will be stored in superblock on each base bdev, '
@@ -36,7 +36,9 @@ def add_parser(subparsers):
             max_r2t_per_connection=args.max_r2t_per_connection,
             pdu_pool_size=args.pdu_pool_size,
             immediate_data_pool_size=args.immediate_data_pool_size,
-            data_out_pool_size=args.data_out_pool_size)
+            data_out_pool_size=args.data_out_pool_size,
+            conn_balance_interval=args.conn_balance_interval,
+            conn_balance_threshold=args.conn_balance_threshold)
 
     p = subparsers.add_parser('iscsi_set_options',
                               help="""Set options of iSCSI subsystem""")
@@ -71,6 +73,12 @@ def add_parser(subparsers):
                    help='Number of immediate data buffers in the pool', type=int)
     p.add_argument('-z', '--data-out-pool-size',
                    help='Number of data out buffers in the pool', type=int)
+    p.add_argument('--conn-balance-interval',
+                   help='Period in seconds to move connections from the busiest to the idlest poll group. 0 disables it',
+                   type=int)
+    p.add_argument('--conn-balance-threshold',
+                   help='Minimum busy percentage difference between poll groups to move connections',
+                   type=int)
     p.set_defaults(func=iscsi_set_options)
 
     def iscsi_set_discovery_auth(args):
@@ -486,6 +494,16 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                               help='Display iSCSI connections')
     p.set_defaults(func=iscsi_get_connections)
 
+    def iscsi_migrate_connection(args):
+        print_dict(args.client.iscsi_migrate_connection(id=args.id, thread_name=args.thread_name))
+
+    p = subparsers.add_parser('iscsi_migrate_connection',
+                              help='Move a connection and the other ones of its target to another poll group')
+    p.add_argument('id', help='Connection ID', type=int)
+    p.add_argument('-t', '--thread-name',
+                   help='Name of the thread to move the connection to. The least loaded poll group is used if omitted')
+    p.set_defaults(func=iscsi_migrate_connection)
+
     def iscsi_get_stats(args):
         print_dict(args.client.iscsi_get_stats())
 
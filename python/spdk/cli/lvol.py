@@ -175,6 +175,71 @@ def add_parser(subparsers):
     p.add_argument('operation_id', help='operation identifier', type=int)
     p.set_defaults(func=bdev_lvol_check_shallow_copy)
 
+    def bdev_lvol_get_diff(args):
+        print_json(args.client.bdev_lvol_get_diff(
+                                               src_lvol_name=args.src_lvol_name,
+                                               base_lvol_name=args.base_lvol_name))
+
+    p = subparsers.add_parser('bdev_lvol_get_diff',
+                              help='Get the ranges of an lvol that differ from an older snapshot in its chain')
+    p.add_argument('src_lvol_name', help='UUID or alias of the lvol, usually a snapshot, to compare')
+    p.add_argument('-b', '--base-lvol-name',
+                   help='UUID or alias of an older snapshot in the chain of the lvol. '
+                   'If omitted, every cluster of the chain is reported')
+    p.set_defaults(func=bdev_lvol_get_diff)
+
+    def bdev_lvol_start_diff_copy(args):
+        print_json(args.client.bdev_lvol_start_diff_copy(
+                                                      src_lvol_name=args.src_lvol_name,
+                                                      base_lvol_name=args.base_lvol_name,
+                                                      dst_bdev_name=args.dst_bdev_name))
+
+    p = subparsers.add_parser('bdev_lvol_start_diff_copy',
+                              help="""Start a copy of the clusters of an lvol that differ from an older snapshot over
+    a given bdev.  The status of the operation can be obtained with bdev_lvol_check_shallow_copy""")
+    p.add_argument('src_lvol_name', help='UUID or alias of lvol to create a copy from')
+    p.add_argument('dst_bdev_name', help='Name of the bdev that acts as destination for the copy')
+    p.add_argument('-b', '--base-lvol-name',
+                   help='UUID or alias of an older snapshot in the chain of the lvol. '
+                   'If omitted, every cluster of the chain is copied')
+    p.set_defaults(func=bdev_lvol_start_diff_copy)
+
+    def bdev_lvol_start_inflate(args):
+        print_json(args.client.bdev_lvol_start_inflate(
+                                                    name=args.name,
+                                                    decouple_parent=args.decouple_parent,
+                                                    clusters_in_flight=args.clusters_in_flight,
+                                                    max_bandwidth_mb_sec=args.max_bandwidth_mb_sec,
+                                                    max_clusters_per_sec=args.max_clusters_per_sec))
+
+    p = subparsers.add_parser('bdev_lvol_start_inflate',
+                              help="""Inflate lvol or decouple its parent in the background. The status of the
+    operation can be obtained with bdev_lvol_check_inflate""")
+    p.add_argument('name', help='UUID or alias of the logical volume to inflate')
+    p.add_argument('-d', '--decouple-parent', action='store_true',
+                   help='Only decouple the logical volume from its parent')
+    p.add_argument('-q', '--clusters-in-flight', help='Number of clusters copied concurrently', type=int)
+    p.add_argument('-b', '--max-bandwidth-mb-sec',
+                   help='Maximum bandwidth of cluster copies in MiB/s. 0 means no limit', type=int)
+    p.add_argument('-c', '--max-clusters-per-sec',
+                   help='Maximum number of clusters copied per second. 0 means no limit', type=int)
+    p.set_defaults(func=bdev_lvol_start_inflate)
+
+    def bdev_lvol_check_inflate(args):
+        print_json(args.client.bdev_lvol_check_inflate(operation_id=args.operation_id))
+
+    p = subparsers.add_parser('bdev_lvol_check_inflate', help='Get background inflate status')
+    p.add_argument('operation_id', help='operation identifier', type=int)
+    p.set_defaults(func=bdev_lvol_check_inflate)
+
+    def bdev_lvol_stop_inflate(args):
+        args.client.bdev_lvol_stop_inflate(name=args.name)
+
+    p = subparsers.add_parser('bdev_lvol_stop_inflate',
+                              help='Stop a background inflate, keeping its progress')
+    p.add_argument('name', help='UUID or alias of the logical volume being inflated')
+    p.set_defaults(func=bdev_lvol_stop_inflate)
+
     def bdev_lvol_set_parent(args):
         args.client.bdev_lvol_set_parent(
                                       lvol_name=args.lvol_name,
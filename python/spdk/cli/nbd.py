@@ -13,12 +13,15 @@ def add_parser(subparsers):
     def nbd_start_disk(args):
         print(args.client.nbd_start_disk(
                                      bdev_name=args.bdev_name,
-                                     nbd_device=args.nbd_device))
+                                     nbd_device=args.nbd_device,
+                                     num_connections=args.num_connections))
 
     p = subparsers.add_parser('nbd_start_disk',
                               help='Export a bdev as an nbd disk')
     p.add_argument('bdev_name', help='Name of the bdev to export')
     p.add_argument('nbd_device', help='Path to the NBD device, e.g. "/dev/nbd0". Default: first available device', nargs='?')
+    p.add_argument('-c', '--num-connections', type=int,
+                   help='Number of sockets serving the device, each polled by its own thread. Default: 1')
     p.set_defaults(func=nbd_start_disk)
 
     def nbd_stop_disk(args):
@@ -5,6 +5,7 @@
 #  Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
 #
 
+import argparse
 from functools import partial
 
 from spdk.rpc.cmd_parser import print_dict
@@ -75,3 +76,32 @@ def add_parser(subparsers):
     p = subparsers.add_parser('trace_get_info',
                               help='get name of shared memory file and list of the available trace point groups')
     p.set_defaults(func=trace_get_info)
+
+    def trace_set_tpoint_group_sample_rate(args):
+        args.client.trace_set_tpoint_group_sample_rate(name=args.name, rate=args.rate)
+
+    p = subparsers.add_parser('trace_set_tpoint_group_sample_rate',
+                              help='record only a sample of the events of a tpoint group')
+    p.add_argument(
+        'name', help='Name of a registered trace group, or "all" to set the rate of every group')
+    p.add_argument(
+        'rate',
+        help='Record 1 of every rate events in the trace history; 1 records all, 0 records none',
+        type=int)
+    p.set_defaults(func=trace_set_tpoint_group_sample_rate)
+
+    def trace_enable_latency_histograms(args):
+        args.client.trace_enable_latency_histograms(enable=args.enable)
+
+    p = subparsers.add_parser('trace_enable_latency_histograms',
+                              help='enable or disable latency histograms of enabled tracepoints')
+    p.add_argument('--enable', action=argparse.BooleanOptionalAction, required=True,
+                   help='Enable or disable latency histograms of enabled tracepoints')
+    p.set_defaults(func=trace_enable_latency_histograms)
+
+    def trace_get_latency_histograms(args):
+        print_dict(args.client.trace_get_latency_histograms())
+
+    p = subparsers.add_parser('trace_get_latency_histograms',
+                              help='get latency histograms of tracepoints, merged over all cores')
+    p.set_defaults(func=trace_get_latency_histograms)
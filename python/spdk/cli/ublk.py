@@ -13,11 +13,13 @@ def add_parser(subparsers):
     def ublk_create_target(args):
         args.client.ublk_create_target(
                                     cpumask=args.cpumask,
-                                    disable_user_copy=args.disable_user_copy)
+                                    disable_user_copy=args.disable_user_copy,
+                                    disable_zero_copy=args.disable_zero_copy)
     p = subparsers.add_parser('ublk_create_target',
                               help='Create spdk ublk target for ublk dev')
     p.add_argument('-m', '--cpumask', help="CPU mask for the ublk target's I/O threads")
     p.add_argument('--disable-user-copy', help='Disable the ublk user-copy feature. Default: false', action='store_true')
+    p.add_argument('--disable-zero-copy', help='Disable zero-copy I/O to bdevs supporting it. Default: false', action='store_true')
     p.set_defaults(func=ublk_create_target)
 
     def ublk_destroy_target(args):
@@ -6,6 +6,7 @@
 #
 
 import argparse
+from functools import partial
 
 from spdk.rpc.cmd_parser import print_array, print_dict, print_json, strip_globals
 
@@ -84,6 +85,8 @@ def add_parser(subparsers):
 
     def vhost_create_blk_controller(args):
         params = strip_globals(vars(args))
+        if params.get('queue_thread_map') is not None:
+            params['queue_thread_map'] = [int(i) for i in params['queue_thread_map']]
         args.client.vhost_create_blk_controller(**params)
 
     p = subparsers.add_parser('vhost_create_blk_controller', help='Add a new vhost block controller')
@@ -93,6 +96,10 @@ def add_parser(subparsers):
     p.add_argument('--transport', help='virtio blk transport name (default: vhost_user_blk)')
     p.add_argument("-r", "--readonly", action='store_true', help='Expose the block device as read-only. Default: false')
     p.add_argument("-p", "--packed-ring", action='store_true', help='Set controller as packed ring supported')
+    p.add_argument('--num-queue-threads', type=int,
+                   help='Number of threads polling the virtqueues, each with its own bdev channel. Default: 1, or enough for queue_thread_map')
+    p.add_argument('--queue-thread-map', type=partial(str.split, sep=','),
+                   help='Index of the thread polling each virtqueue. Queues not listed are spread round-robin')
     p.set_defaults(func=vhost_create_blk_controller)
 
     def vhost_get_controllers(args):
@@ -110,6 +110,8 @@ run_test "accel_dualcast" accel_test -t 1 -w dualcast -y
 run_test "accel_compare" accel_test -t 1 -w compare -y
 run_test "accel_xor" accel_test -t 1 -w xor -y
 run_test "accel_xor" accel_test -t 1 -w xor -y -x 3
+run_test "accel_pq_gen" accel_test -t 1 -w pq_gen -y
+run_test "accel_pq_gen" accel_test -t 1 -w pq_gen -y -x 6
 run_test "accel_dif_verify" accel_test -t 1 -w dif_verify
 run_test "accel_dif_generate" accel_test -t 1 -w dif_generate
 run_test "accel_dif_generate_copy" accel_test -t 1 -w dif_generate_copy
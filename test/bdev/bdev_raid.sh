@@ -262,7 +262,7 @@ function verify_raid_bdev_properties() {
 
 function has_redundancy() {
 	case $1 in
-		"raid1" | "raid5f") return 0 ;;
+		"raid1" | "raid5f" | "raid6") return 0 ;;
 		*) return 1 ;;
 	esac
 }
@@ -695,6 +695,9 @@ function raid_rebuild_test() {
 		if [ $raid_level = "raid5f" ]; then
 			write_unit_size=$((strip_size * 2 * (num_base_bdevs - 1)))
 			echo $((base_blocklen * write_unit_size / 1024)) > /sys/block/nbd0/queue/max_sectors_kb
+		elif [ $raid_level = "raid6" ]; then
+			write_unit_size=$((strip_size * 2 * (num_base_bdevs - 2)))
+			echo $((base_blocklen * write_unit_size / 1024)) > /sys/block/nbd0/queue/max_sectors_kb
 		else
 			write_unit_size=1
 		fi
@@ -1249,6 +1252,16 @@ for n in {3..4}; do
 	fi
 done
 
+for n in {4..5}; do
+	run_test "raid6_state_function_test" raid_state_function_test raid6 $n false
+	run_test "raid6_state_function_test_sb" raid_state_function_test raid6 $n true
+	run_test "raid6_superblock_test" raid_superblock_test raid6 $n
+	if [ "$has_nbd" = true ]; then
+		run_test "raid6_rebuild_test" raid_rebuild_test raid6 $n false false true
+		run_test "raid6_rebuild_test_sb" raid_rebuild_test raid6 $n true false true
+	fi
+done
+
 run_test "raid1_delete_clear_sb_test" raid_delete_clear_sb_test raid1 2
 run_test "raid5f_delete_clear_sb_test" raid_delete_clear_sb_test raid5f 3
 
@@ -0,0 +1,623 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+/*
+ * Fixture for unit tests of virtual bdev modules. Base bdevs are emulated by ut_disks, whose
+ * I/O is executed against an in-memory copy of their data and completed asynchronously on
+ * the submitting thread. The module under test is included by the test before this file.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk_internal/cunit.h"
+#include "spdk_internal/mock.h"
+#include "spdk/bdev_module.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+#define BLOCK_SIZE	512
+
+struct ut_disk {
+	struct spdk_bdev	bdev;
+	uint8_t			*data;
+	/* Found by name, opened and examined only while present */
+	bool			present;
+	bool			claimed;
+	/* I/Os are completed only once ut_release_ios() is called */
+	bool			hold;
+	/* Number of I/Os that fail to be submitted with -ENOMEM */
+	int			enomem_count;
+	/* Writes to this block fail */
+	uint64_t		fail_write_lba;
+	uint64_t		reads;
+	uint64_t		writes;
+	TAILQ_ENTRY(ut_disk)	link;
+};
+
+static TAILQ_HEAD(, ut_disk) g_ut_disks = TAILQ_HEAD_INITIALIZER(g_ut_disks);
+static TAILQ_HEAD(, spdk_bdev) g_bdev_list = TAILQ_HEAD_INITIALIZER(g_bdev_list);
+static bool g_examine_done;
+static int g_create_rc;
+static bool g_create_done;
+static int g_delete_rc;
+static bool g_delete_done;
+/* Number of completed virtual bdev I/Os */
+static int g_io_done;
+
+void ut_disk_reset(struct ut_disk *disk);
+int ut_disk_init(struct ut_disk *disk, const char *name, uint64_t num_blocks);
+void ut_disk_fini(struct ut_disk *disk);
+struct ut_disk *ut_disk_get(const char *name);
+void ut_release_ios(void);
+void create_cb(void *cb_arg, int rc);
+void delete_cb(void *cb_arg, int rc);
+void *ut_get_vbdev(const char *name, struct spdk_bdev_module *module);
+void ut_examine_disk(struct spdk_bdev_module *module, struct ut_disk *disk);
+void fill_block(void *buf, uint32_t pattern);
+struct spdk_bdev_io *ut_start_io(struct spdk_bdev *bdev, int thread, enum spdk_bdev_io_type type,
+				 uint64_t lba, uint64_t num_blocks, void *buf);
+enum spdk_bdev_io_status ut_finish_io(struct spdk_bdev_io *bdev_io);
+enum spdk_bdev_io_status ut_submit_io(struct spdk_bdev *bdev, int thread,
+				      enum spdk_bdev_io_type type, uint64_t lba,
+				      uint64_t num_blocks, void *buf);
+
+DEFINE_STUB_V(spdk_bdev_module_list_add, (struct spdk_bdev_module *bdev_module));
+DEFINE_STUB(spdk_bdev_get_buf_align, size_t, (const struct spdk_bdev *bdev), 0);
+DEFINE_STUB(spdk_bdev_io_type_supported, bool, (struct spdk_bdev *bdev,
+		enum spdk_bdev_io_type io_type), true);
+DEFINE_STUB(spdk_json_write_object_begin, int, (struct spdk_json_write_ctx *w), 0);
+DEFINE_STUB(spdk_json_write_named_object_begin, int, (struct spdk_json_write_ctx *w,
+		const char *name), 0);
+DEFINE_STUB(spdk_json_write_named_string, int, (struct spdk_json_write_ctx *w,
+		const char *name, const char *val), 0);
+DEFINE_STUB(spdk_json_write_named_uint32, int, (struct spdk_json_write_ctx *w,
+		const char *name, uint32_t val), 0);
+DEFINE_STUB(spdk_json_write_named_uint64, int, (struct spdk_json_write_ctx *w,
+		const char *name, uint64_t val), 0);
+DEFINE_STUB(spdk_json_write_named_bool, int, (struct spdk_json_write_ctx *w,
+		const char *name, bool val), 0);
+DEFINE_STUB(spdk_json_write_object_end, int, (struct spdk_json_write_ctx *w), 0);
+
+static int
+ut_disk_ch_create_cb(void *io_device, void *ctx_buf)
+{
+	return 0;
+}
+
+static void
+ut_disk_ch_destroy_cb(void *io_device, void *ctx_buf)
+{
+}
+
+void
+ut_disk_reset(struct ut_disk *disk)
+{
+	disk->present = true;
+	disk->hold = false;
+	disk->enomem_count = 0;
+	disk->fail_write_lba = UINT64_MAX;
+	disk->reads = disk->writes = 0;
+}
+
+int
+ut_disk_init(struct ut_disk *disk, const char *name, uint64_t num_blocks)
+{
+	disk->bdev.name = strdup(name);
+	disk->bdev.blocklen = BLOCK_SIZE;
+	disk->bdev.blockcnt = num_blocks;
+	disk->data = calloc(num_blocks, BLOCK_SIZE);
+	if (disk->bdev.name == NULL || disk->data == NULL) {
+		free(disk->bdev.name);
+		free(disk->data);
+		return -ENOMEM;
+	}
+
+	ut_disk_reset(disk);
+	TAILQ_INSERT_TAIL(&g_ut_disks, disk, link);
+	spdk_io_device_register(disk, ut_disk_ch_create_cb, ut_disk_ch_destroy_cb, 0, name);
+
+	return 0;
+}
+
+void
+ut_disk_fini(struct ut_disk *disk)
+{
+	spdk_io_device_unregister(disk, NULL);
+	TAILQ_REMOVE(&g_ut_disks, disk, link);
+	free(disk->bdev.name);
+	free(disk->data);
+}
+
+struct ut_disk *
+ut_disk_get(const char *name)
+{
+	struct ut_disk *disk;
+
+	TAILQ_FOREACH(disk, &g_ut_disks, link) {
+		if (disk->present && strcmp(name, disk->bdev.name) == 0) {
+			return disk;
+		}
+	}
+
+	return NULL;
+}
+
+void
+spdk_bdev_module_examine_done(struct spdk_bdev_module *module)
+{
+	g_examine_done = true;
+}
+
+const char *
+spdk_bdev_get_name(const struct spdk_bdev *bdev)
+{
+	return bdev->name;
+}
+
+uint32_t
+spdk_bdev_get_block_size(const struct spdk_bdev *bdev)
+{
+	return bdev->blocklen;
+}
+
+uint64_t
+spdk_bdev_get_num_blocks(const struct spdk_bdev *bdev)
+{
+	return bdev->blockcnt;
+}
+
+struct spdk_bdev *
+spdk_bdev_get_by_name(const char *bdev_name)
+{
+	struct ut_disk *disk = ut_disk_get(bdev_name);
+	struct spdk_bdev *bdev;
+
+	if (disk != NULL) {
+		return &disk->bdev;
+	}
+
+	TAILQ_FOREACH(bdev, &g_bdev_list, internal.link) {
+		if (strcmp(bdev_name, bdev->name) == 0) {
+			return bdev;
+		}
+	}
+
+	return NULL;
+}
+
+int
+spdk_bdev_open_ext(const char *bdev_name, bool write, spdk_bdev_event_cb_t event_cb,
+		   void *event_ctx, struct spdk_bdev_desc **_desc)
+{
+	struct ut_disk *disk = ut_disk_get(bdev_name);
+
+	if (disk == NULL) {
+		return -ENODEV;
+	}
+
+	*_desc = (void *)disk;
+
+	return 0;
+}
+
+void
+spdk_bdev_close(struct spdk_bdev_desc *desc)
+{
+}
+
+struct spdk_bdev *
+spdk_bdev_desc_get_bdev(struct spdk_bdev_desc *desc)
+{
+	return &((struct ut_disk *)desc)->bdev;
+}
+
+int
+spdk_bdev_module_claim_bdev(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
+			    struct spdk_bdev_module *module)
+{
+	struct ut_disk *disk = SPDK_CONTAINEROF(bdev, struct ut_disk, bdev);
+
+	if (disk->claimed) {
+		return -EPERM;
+	}
+
+	disk->claimed = true;
+
+	return 0;
+}
+
+void
+spdk_bdev_module_release_bdev(struct spdk_bdev *bdev)
+{
+	struct ut_disk *disk = SPDK_CONTAINEROF(bdev, struct ut_disk, bdev);
+
+	CU_ASSERT(disk->claimed);
+	disk->claimed = false;
+}
+
+struct spdk_io_channel *
+spdk_bdev_get_io_channel(struct spdk_bdev_desc *desc)
+{
+	return spdk_get_io_channel(desc);
+}
+
+int
+spdk_bdev_register(struct spdk_bdev *bdev)
+{
+	CU_ASSERT(spdk_bdev_get_by_name(bdev->name) == NULL);
+	TAILQ_INSERT_TAIL(&g_bdev_list, bdev, internal.link);
+
+	return 0;
+}
+
+void
+spdk_bdev_unregister(struct spdk_bdev *bdev, spdk_bdev_unregister_cb cb_fn, void *cb_arg)
+{
+	TAILQ_REMOVE(&g_bdev_list, bdev, internal.link);
+
+	bdev->fn_table->destruct(bdev->ctxt);
+
+	if (cb_fn) {
+		cb_fn(cb_arg, 0);
+	}
+}
+
+int
+spdk_bdev_unregister_by_name(const char *bdev_name, struct spdk_bdev_module *module,
+			     spdk_bdev_unregister_cb cb_fn, void *cb_arg)
+{
+	struct spdk_bdev *bdev;
+
+	TAILQ_FOREACH(bdev, &g_bdev_list, internal.link) {
+		if (strcmp(bdev_name, bdev->name) == 0 && bdev->module == module) {
+			spdk_bdev_unregister(bdev, cb_fn, cb_arg);
+			return 0;
+		}
+	}
+
+	return -ENODEV;
+}
+
+void
+spdk_bdev_io_get_buf(struct spdk_bdev_io *bdev_io, spdk_bdev_io_get_buf_cb cb, uint64_t len)
+{
+	cb(NULL, bdev_io, true);
+}
+
+struct spdk_thread *
+spdk_bdev_io_get_thread(struct spdk_bdev_io *bdev_io)
+{
+	return bdev_io->internal.caller_ctx;
+}
+
+void
+spdk_bdev_io_complete(struct spdk_bdev_io *bdev_io, enum spdk_bdev_io_status status)
+{
+	CU_ASSERT(spdk_get_thread() == bdev_io->internal.caller_ctx);
+	bdev_io->internal.status = status;
+	g_io_done++;
+}
+
+void
+spdk_bdev_io_complete_base_io_status(struct spdk_bdev_io *bdev_io,
+				     const struct spdk_bdev_io *base_io)
+{
+	spdk_bdev_io_complete(bdev_io, base_io->internal.status);
+}
+
+/* Disk I/O */
+
+struct ut_io {
+	struct spdk_bdev_io		bdev_io;
+	spdk_bdev_io_completion_cb	cb;
+	void				*cb_arg;
+	bool				success;
+	struct spdk_thread		*thread;
+	TAILQ_ENTRY(ut_io)		link;
+};
+
+static TAILQ_HEAD(, ut_io) g_held_ios = TAILQ_HEAD_INITIALIZER(g_held_ios);
+
+static void
+ut_io_complete(void *ctx)
+{
+	struct ut_io *io = ctx;
+
+	io->cb(&io->bdev_io, io->success, io->cb_arg);
+}
+
+void
+ut_release_ios(void)
+{
+	struct ut_io *io;
+
+	while ((io = TAILQ_FIRST(&g_held_ios))) {
+		TAILQ_REMOVE(&g_held_ios, io, link);
+		spdk_thread_send_msg(io->thread, ut_io_complete, io);
+	}
+	poll_threads();
+}
+
+void
+spdk_bdev_free_io(struct spdk_bdev_io *bdev_io)
+{
+	free(SPDK_CONTAINEROF(bdev_io, struct ut_io, bdev_io));
+}
+
+static int
+ut_submit(struct spdk_bdev_desc *desc, enum spdk_bdev_io_type type, struct iovec *iovs,
+	  int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
+	  spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	struct ut_disk *disk = (struct ut_disk *)desc;
+	struct ut_io *io;
+	struct iovec iov;
+
+	if (disk->enomem_count > 0) {
+		disk->enomem_count--;
+		return -ENOMEM;
+	}
+
+	SPDK_CU_ASSERT_FATAL(offset_blocks + num_blocks <= disk->bdev.blockcnt);
+
+	io = calloc(1, sizeof(*io));
+	SPDK_CU_ASSERT_FATAL(io != NULL);
+	io->bdev_io.bdev = &disk->bdev;
+	io->bdev_io.type = type;
+	io->bdev_io.internal.status = SPDK_BDEV_IO_STATUS_SUCCESS;
+	io->cb = cb;
+	io->cb_arg = cb_arg;
+	io->success = true;
+	io->thread = spdk_get_thread();
+
+	iov.iov_base = disk->data + offset_blocks * BLOCK_SIZE;
+	iov.iov_len = num_blocks * BLOCK_SIZE;
+
+	switch (type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+		disk->reads++;
+		CU_ASSERT(spdk_iovcpy(&iov, 1, iovs, iovcnt) == iov.iov_len);
+		break;
+	case SPDK_BDEV_IO_TYPE_WRITE:
+		disk->writes++;
+		if (disk->fail_write_lba >= offset_blocks &&
+		    disk->fail_write_lba < offset_blocks + num_blocks) {
+			io->success = false;
+			io->bdev_io.internal.status = SPDK_BDEV_IO_STATUS_FAILED;
+			break;
+		}
+		CU_ASSERT(spdk_iovcpy(iovs, iovcnt, &iov, 1) == iov.iov_len);
+		break;
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+		memset(iov.iov_base, 0, iov.iov_len);
+		break;
+	default:
+		break;
+	}
+
+	if (disk->hold) {
+		TAILQ_INSERT_TAIL(&g_held_ios, io, link);
+	} else {
+		spdk_thread_send_msg(io->thread, ut_io_complete, io);
+	}
+
+	return 0;
+}
+
+int
+spdk_bdev_read_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch, void *buf,
+		      uint64_t offset_blocks, uint64_t num_blocks, spdk_bdev_io_completion_cb cb,
+		      void *cb_arg)
+{
+	struct iovec iov = { .iov_base = buf, .iov_len = num_blocks * BLOCK_SIZE };
+
+	return ut_submit(desc, SPDK_BDEV_IO_TYPE_READ, &iov, 1, offset_blocks, num_blocks, cb,
+			 cb_arg);
+}
+
+int
+spdk_bdev_readv_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		       struct iovec *iov, int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
+		       spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return ut_submit(desc, SPDK_BDEV_IO_TYPE_READ, iov, iovcnt, offset_blocks, num_blocks, cb,
+			 cb_arg);
+}
+
+int
+spdk_bdev_write_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch, void *buf,
+		       uint64_t offset_blocks, uint64_t num_blocks, spdk_bdev_io_completion_cb cb,
+		       void *cb_arg)
+{
+	struct iovec iov = { .iov_base = buf, .iov_len = num_blocks * BLOCK_SIZE };
+
+	return ut_submit(desc, SPDK_BDEV_IO_TYPE_WRITE, &iov, 1, offset_blocks, num_blocks, cb,
+			 cb_arg);
+}
+
+int
+spdk_bdev_writev_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			struct iovec *iov, int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
+			spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return ut_submit(desc, SPDK_BDEV_IO_TYPE_WRITE, iov, iovcnt, offset_blocks, num_blocks, cb,
+			 cb_arg);
+}
+
+int
+spdk_bdev_unmap_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		       uint64_t offset_blocks, uint64_t num_blocks, spdk_bdev_io_completion_cb cb,
+		       void *cb_arg)
+{
+	return ut_submit(desc, SPDK_BDEV_IO_TYPE_UNMAP, NULL, 0, offset_blocks, num_blocks, cb,
+			 cb_arg);
+}
+
+int
+spdk_bdev_write_zeroes_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			      uint64_t offset_blocks, uint64_t num_blocks,
+			      spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return ut_submit(desc, SPDK_BDEV_IO_TYPE_WRITE_ZEROES, NULL, 0, offset_blocks, num_blocks,
+			 cb, cb_arg);
+}
+
+int
+spdk_bdev_flush_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		       uint64_t offset_blocks, uint64_t num_blocks, spdk_bdev_io_completion_cb cb,
+		       void *cb_arg)
+{
+	return ut_submit(desc, SPDK_BDEV_IO_TYPE_FLUSH, NULL, 0, offset_blocks, num_blocks, cb,
+			 cb_arg);
+}
+
+int
+spdk_bdev_reset(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return ut_submit(desc, SPDK_BDEV_IO_TYPE_RESET, NULL, 0, 0, 0, cb, cb_arg);
+}
+
+static void
+ut_queue_io_wait_cb(void *ctx)
+{
+	struct spdk_bdev_io_wait_entry *entry = ctx;
+
+	entry->cb_fn(entry->cb_arg);
+}
+
+int
+spdk_bdev_queue_io_wait(struct spdk_bdev *bdev, struct spdk_io_channel *ch,
+			struct spdk_bdev_io_wait_entry *entry)
+{
+	CU_ASSERT(ut_disk_get(bdev->name) != NULL);
+	spdk_thread_send_msg(spdk_get_thread(), ut_queue_io_wait_cb, entry);
+
+	return 0;
+}
+
+/* Virtual bdev helpers */
+
+void
+create_cb(void *cb_arg, int rc)
+{
+	g_create_rc = rc;
+	g_create_done = true;
+}
+
+void
+delete_cb(void *cb_arg, int rc)
+{
+	g_delete_rc = rc;
+	g_delete_done = true;
+}
+
+void *
+ut_get_vbdev(const char *name, struct spdk_bdev_module *module)
+{
+	struct spdk_bdev *bdev = spdk_bdev_get_by_name(name);
+
+	return bdev != NULL && bdev->module == module ? bdev->ctxt : NULL;
+}
+
+void
+ut_examine_disk(struct spdk_bdev_module *module, struct ut_disk *disk)
+{
+	g_examine_done = false;
+	if (module->examine_config != NULL) {
+		module->examine_config(&disk->bdev);
+	} else {
+		module->examine_disk(&disk->bdev);
+	}
+	poll_threads();
+	CU_ASSERT(g_examine_done);
+}
+
+void
+fill_block(void *buf, uint32_t pattern)
+{
+	uint32_t *p = buf;
+	uint32_t i;
+
+	for (i = 0; i < BLOCK_SIZE / sizeof(uint32_t); i++) {
+		p[i] = pattern * 2654435761u + i + 1;
+	}
+}
+
+/* I/O to a virtual bdev, holding its channel until the I/O is finished like the bdev
+ * layer does
+ */
+struct ut_bdev_io {
+	struct spdk_io_channel	*ch;
+	int			thread;
+	struct iovec		iovs[2];
+	struct spdk_bdev_io	bdev_io;
+};
+
+struct spdk_bdev_io *
+ut_start_io(struct spdk_bdev *bdev, int thread, enum spdk_bdev_io_type type, uint64_t lba,
+	    uint64_t num_blocks, void *buf)
+{
+	struct ut_bdev_io *io;
+	struct spdk_bdev_io *bdev_io;
+
+	io = calloc(1, sizeof(*io) + bdev->module->get_ctx_size());
+	SPDK_CU_ASSERT_FATAL(io != NULL);
+	bdev_io = &io->bdev_io;
+
+	set_thread(thread);
+	io->thread = thread;
+	io->ch = bdev->fn_table->get_io_channel(bdev->ctxt);
+	SPDK_CU_ASSERT_FATAL(io->ch != NULL);
+
+	/* Split the buffer unevenly to exercise iovec handling */
+	io->iovs[0].iov_base = buf;
+	io->iovs[0].iov_len = num_blocks * BLOCK_SIZE / 2 + 8;
+	io->iovs[1].iov_base = (uint8_t *)buf + io->iovs[0].iov_len;
+	io->iovs[1].iov_len = num_blocks * BLOCK_SIZE - io->iovs[0].iov_len;
+
+	bdev_io->bdev = bdev;
+	bdev_io->type = type;
+	bdev_io->u.bdev.iovs = io->iovs;
+	bdev_io->u.bdev.iovcnt = buf != NULL ? 2 : 0;
+	bdev_io->u.bdev.offset_blocks = lba;
+	bdev_io->u.bdev.num_blocks = num_blocks;
+	bdev_io->internal.caller_ctx = spdk_get_thread();
+	bdev_io->internal.status = SPDK_BDEV_IO_STATUS_PENDING;
+
+	bdev->fn_table->submit_request(io->ch, bdev_io);
+	set_thread(0);
+
+	return bdev_io;
+}
+
+enum spdk_bdev_io_status
+ut_finish_io(struct spdk_bdev_io *bdev_io)
+{
+	struct ut_bdev_io *io = SPDK_CONTAINEROF(bdev_io, struct ut_bdev_io, bdev_io);
+	enum spdk_bdev_io_status status = bdev_io->internal.status;
+
+	set_thread(io->thread);
+	spdk_put_io_channel(io->ch);
+	set_thread(0);
+	poll_threads();
+	free(io);
+
+	return status;
+}
+
+enum spdk_bdev_io_status
+ut_submit_io(struct spdk_bdev *bdev, int thread, enum spdk_bdev_io_type type, uint64_t lba,
+	     uint64_t num_blocks, void *buf)
+{
+	struct spdk_bdev_io *bdev_io;
+
+	g_io_done = 0;
+	bdev_io = ut_start_io(bdev, thread, type, lba, num_blocks, buf);
+	poll_threads();
+	CU_ASSERT(g_io_done == 1);
+
+	return ut_finish_io(bdev_io);
+}
@@ -575,6 +575,59 @@ test_spdk_accel_submit_xor(void)
 	CU_ASSERT(expected_accel_task == &task);
 }
 
+static void
+test_spdk_accel_submit_pq(void)
+{
+	const uint64_t nbytes = TEST_SUBMIT_SIZE;
+	uint8_t bufs[4][TEST_SUBMIT_SIZE] = {};
+	void *buffers[] = { bufs[0], bufs[1], bufs[2], bufs[3] };
+	uint32_t ndata = SPDK_COUNTOF(buffers) - 2;
+	uint32_t failed[] = { 1, 2 };
+	int rc;
+	struct spdk_accel_task task;
+	struct spdk_accel_task *expected_accel_task = NULL;
+
+	STAILQ_INIT(&g_accel_ch->task_pool);
+
+	/* Fail with no tasks on _get_task() */
+	rc = spdk_accel_submit_pq_gen(g_ch, buffers, ndata, nbytes, NULL, NULL);
+	CU_ASSERT(rc == -ENOMEM);
+	rc = spdk_accel_submit_pq_recover(g_ch, buffers, ndata, nbytes, failed, 2, NULL, NULL);
+	CU_ASSERT(rc == -ENOMEM);
+
+	/* Invalid number of failed buffers */
+	STAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	rc = spdk_accel_submit_pq_recover(g_ch, buffers, ndata, nbytes, failed, 0, NULL, NULL);
+	CU_ASSERT(rc == -EINVAL);
+	rc = spdk_accel_submit_pq_recover(g_ch, buffers, ndata, nbytes, failed, 3, NULL, NULL);
+	CU_ASSERT(rc == -EINVAL);
+
+	/* P+Q generation submission OK. */
+	rc = spdk_accel_submit_pq_gen(g_ch, buffers, ndata, nbytes, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.nsrcs.srcs == buffers);
+	CU_ASSERT(task.nsrcs.cnt == ndata);
+	CU_ASSERT(task.nbytes == nbytes);
+	CU_ASSERT(task.op_code == SPDK_ACCEL_OPC_PQ_GEN);
+	expected_accel_task = STAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	STAILQ_REMOVE_HEAD(&g_sw_ch->tasks_to_complete, link);
+	CU_ASSERT(expected_accel_task == &task);
+
+	/* P+Q recovery submission OK. */
+	STAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	rc = spdk_accel_submit_pq_recover(g_ch, buffers, ndata, nbytes, failed, 2, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.nsrcs.srcs == buffers);
+	CU_ASSERT(task.nsrcs.cnt == ndata);
+	CU_ASSERT(task.pq.nfailed == 2);
+	CU_ASSERT(task.pq.failed[0] == 1);
+	CU_ASSERT(task.pq.failed[1] == 2);
+	CU_ASSERT(task.op_code == SPDK_ACCEL_OPC_PQ_RECOVER);
+	expected_accel_task = STAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	STAILQ_REMOVE_HEAD(&g_sw_ch->tasks_to_complete, link);
+	CU_ASSERT(expected_accel_task == &task);
+}
+
 static void
 test_spdk_accel_module_find_by_name(void)
 {
@@ -4530,6 +4583,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_spdk_accel_submit_crc32cv);
 	CU_ADD_TEST(suite, test_spdk_accel_submit_copy_crc32c);
 	CU_ADD_TEST(suite, test_spdk_accel_submit_xor);
+	CU_ADD_TEST(suite, test_spdk_accel_submit_pq);
 	CU_ADD_TEST(suite, test_spdk_accel_module_find_by_name);
 	CU_ADD_TEST(suite, test_spdk_accel_module_register);
 
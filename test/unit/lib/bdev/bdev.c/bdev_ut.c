@@ -3790,6 +3790,164 @@ bdev_histograms(void)
 	ut_fini_bdev();
 }
 
+static void
+io_merge_status_cb(void *cb_arg, int status)
+{
+	g_status = status;
+}
+
+static void
+io_merge_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	enum spdk_bdev_io_status *status = cb_arg;
+
+	*status = bdev_io->internal.status;
+	spdk_bdev_free_io(bdev_io);
+}
+
+static void
+bdev_io_merge_test(void)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel *ch;
+	struct ut_expected_io *expected_io;
+	struct spdk_bdev_ext_io_opts ext_opts = { .size = sizeof(ext_opts) };
+	struct spdk_bdev_io *bdev_io;
+	enum spdk_bdev_io_status status[4];
+	uint8_t buf[4096];
+	struct iovec iov = { .iov_base = buf, .iov_len = 1024 };
+	int i, rc;
+
+	ut_init_bdev(NULL);
+	bdev = allocate_bdev("bdev");
+
+	rc = spdk_bdev_open_ext("bdev", true, bdev_ut_event_cb, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(desc != NULL);
+	ch = spdk_bdev_get_io_channel(desc);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	/*
+	 * Leave NVMe command dwords in a bdev_io returned to the pool.  Writes reusing it must
+	 * neither keep them, which would prevent merging, nor pass them to the merged I/O.
+	 */
+	ext_opts.nvme_cdw12.write.dtype = 2;
+	ext_opts.nvme_cdw13.write.dspec = 1;
+	rc = spdk_bdev_writev_blocks_ext(desc, ch, &iov, 1, 0, 2, io_merge_done, &status[0],
+					 &ext_opts);
+	CU_ASSERT(rc == 0);
+	stub_complete_io(1);
+	poll_threads();
+	CU_ASSERT(status[0] == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	/* A merged I/O must be at least two blocks */
+	g_status = 0;
+	spdk_bdev_set_io_merge(bdev, 100, 512, io_merge_status_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_status == -EINVAL);
+
+	g_status = -1;
+	spdk_bdev_set_io_merge(bdev, 100, 4096, io_merge_status_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_status == 0);
+
+	/* Adjacent writes are held until the window expires and submitted as one I/O */
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_WRITE, 0, 6, 3);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+	for (i = 0; i < 3; i++) {
+		ut_expected_io_set_iov(expected_io, i, &buf[i * 1024], 1024);
+		status[i] = SPDK_BDEV_IO_STATUS_PENDING;
+		rc = spdk_bdev_write_blocks(desc, ch, &buf[i * 1024], i * 2, 2, io_merge_done,
+					    &status[i]);
+		CU_ASSERT(rc == 0);
+	}
+	poll_threads();
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 0);
+
+	spdk_delay_us(100);
+	poll_threads();
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+	CU_ASSERT(status[0] == SPDK_BDEV_IO_STATUS_PENDING);
+	CU_ASSERT(TAILQ_EMPTY(&g_bdev_ut_channel->expected_io));
+	bdev_io = spdk_bdev_io_from_ctx(TAILQ_FIRST(&g_bdev_ut_channel->outstanding_io));
+	CU_ASSERT(bdev_io->u.bdev.nvme_cdw12.raw == 0);
+	CU_ASSERT(bdev_io->u.bdev.nvme_cdw13.raw == 0);
+
+	stub_complete_io(1);
+	poll_threads();
+	for (i = 0; i < 3; i++) {
+		CU_ASSERT(status[i] == SPDK_BDEV_IO_STATUS_SUCCESS);
+	}
+
+	/* Reaching the maximum size submits the merged I/O right away */
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_READ, 8, 8, 4);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+	for (i = 0; i < 4; i++) {
+		ut_expected_io_set_iov(expected_io, i, &buf[i * 1024], 1024);
+		status[i] = SPDK_BDEV_IO_STATUS_PENDING;
+		rc = spdk_bdev_read_blocks(desc, ch, &buf[i * 1024], 8 + i * 2, 2, io_merge_done,
+					   &status[i]);
+		CU_ASSERT(rc == 0);
+	}
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+
+	/* A failure of the merged I/O is reported to each of the merged ones */
+	g_io_exp_status = SPDK_BDEV_IO_STATUS_FAILED;
+	stub_complete_io(1);
+	poll_threads();
+	for (i = 0; i < 4; i++) {
+		CU_ASSERT(status[i] == SPDK_BDEV_IO_STATUS_FAILED);
+	}
+	g_io_exp_status = SPDK_BDEV_IO_STATUS_SUCCESS;
+
+	/* I/Os that do not continue the held ones, or are of another type, flush them first */
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_WRITE, 20, 2, 1);
+	ut_expected_io_set_iov(expected_io, 0, buf, 1024);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_READ, 22, 2, 1);
+	ut_expected_io_set_iov(expected_io, 0, buf, 1024);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_WRITE, 40, 2, 1);
+	ut_expected_io_set_iov(expected_io, 0, buf, 1024);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+
+	rc = spdk_bdev_write_blocks(desc, ch, buf, 20, 2, io_merge_done, &status[0]);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_read_blocks(desc, ch, buf, 22, 2, io_merge_done, &status[1]);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+	rc = spdk_bdev_write_blocks(desc, ch, buf, 40, 2, io_merge_done, &status[2]);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 2);
+
+	/* Disabling merging submits the held I/O */
+	g_status = -1;
+	spdk_bdev_set_io_merge(bdev, 0, 0, io_merge_status_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_status == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 3);
+	CU_ASSERT(TAILQ_EMPTY(&g_bdev_ut_channel->expected_io));
+
+	stub_complete_io(3);
+	poll_threads();
+	for (i = 0; i < 3; i++) {
+		CU_ASSERT(status[i] == SPDK_BDEV_IO_STATUS_SUCCESS);
+	}
+
+	/* Without merging, I/Os go straight to the module */
+	rc = spdk_bdev_write_blocks(desc, ch, buf, 0, 2, io_merge_done, &status[0]);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+	stub_complete_io(1);
+	poll_threads();
+
+	spdk_put_io_channel(ch);
+	spdk_bdev_close(desc);
+	free_bdev(bdev);
+	ut_fini_bdev();
+}
+
 static void
 _bdev_compare(bool emulated)
 {
@@ -5052,7 +5210,7 @@ lock_lba_range_check_ranges(void)
 	poll_threads();
 
 	CU_ASSERT(g_lock_lba_range_done == true);
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = RB_MIN(lba_range_tree, &channel->locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 20);
 	CU_ASSERT(range->length == 10);
@@ -5070,7 +5228,7 @@ lock_lba_range_check_ranges(void)
 	poll_threads();
 
 	CU_ASSERT(g_unlock_lba_range_done == true);
-	CU_ASSERT(TAILQ_EMPTY(&channel->locked_ranges));
+	CU_ASSERT(RB_EMPTY(&channel->locked_ranges));
 
 	spdk_put_io_channel(io_ch);
 	spdk_bdev_close(desc);
@@ -5115,7 +5273,7 @@ lock_lba_range_with_io_outstanding(void)
 	 */
 	CU_ASSERT(g_io_done == false);
 	CU_ASSERT(g_lock_lba_range_done == true);
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = RB_MIN(lba_range_tree, &channel->locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 20);
 	CU_ASSERT(range->length == 10);
@@ -5128,7 +5286,7 @@ lock_lba_range_with_io_outstanding(void)
 	spdk_delay_us(100);
 	poll_threads();
 
-	CU_ASSERT(TAILQ_EMPTY(&channel->locked_ranges));
+	CU_ASSERT(RB_EMPTY(&channel->locked_ranges));
 
 	/* Now try again, but with a write I/O. */
 	g_io_done = false;
@@ -5146,7 +5304,7 @@ lock_lba_range_with_io_outstanding(void)
 	 */
 	CU_ASSERT(g_io_done == false);
 	CU_ASSERT(g_lock_lba_range_done == false);
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = RB_MIN(lba_range_tree, &channel->locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 20);
 	CU_ASSERT(range->length == 10);
@@ -5164,7 +5322,7 @@ lock_lba_range_with_io_outstanding(void)
 	CU_ASSERT(rc == 0);
 	poll_threads();
 
-	CU_ASSERT(TAILQ_EMPTY(&channel->locked_ranges));
+	CU_ASSERT(RB_EMPTY(&channel->locked_ranges));
 
 	spdk_put_io_channel(io_ch);
 	spdk_bdev_close(desc);
@@ -5201,7 +5359,7 @@ lock_lba_range_overlapped(void)
 	poll_threads();
 
 	CU_ASSERT(g_lock_lba_range_done == true);
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = RB_MIN(lba_range_tree, &channel->locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 20);
 	CU_ASSERT(range->length == 10);
@@ -5230,7 +5388,7 @@ lock_lba_range_overlapped(void)
 
 	CU_ASSERT(g_unlock_lba_range_done == true);
 	CU_ASSERT(TAILQ_EMPTY(&bdev->internal.pending_locked_ranges));
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = RB_MIN(lba_range_tree, &channel->locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 25);
 	CU_ASSERT(range->length == 15);
@@ -5309,6 +5467,89 @@ lock_lba_range_overlapped(void)
 	ut_fini_bdev();
 }
 
+static void
+lock_lba_range_many(void)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel *io_ch;
+	struct spdk_bdev_channel *channel;
+	struct lba_range *range;
+	char buf[4096];
+	uint64_t offset;
+	int ctx1, ctx2;
+	int i, rc;
+
+	ut_init_bdev(NULL);
+	bdev = allocate_bdev("bdev0");
+
+	rc = spdk_bdev_open_ext("bdev0", true, bdev_ut_event_cb, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(desc != NULL);
+	io_ch = spdk_bdev_get_io_channel(desc);
+	CU_ASSERT(io_ch != NULL);
+	channel = spdk_io_channel_get_ctx(io_ch);
+
+	/* Lock 64 disjoint ranges, 8 blocks each with 8 unlocked blocks in between.  Lock them
+	 * in a shuffled order to exercise the rebalancing of the channel's range tree.
+	 */
+	for (i = 0; i < 64; i++) {
+		g_lock_lba_range_done = false;
+		rc = bdev_lock_lba_range(desc, io_ch, ((i * 37) % 64) * 16, 8, lock_lba_range_done,
+					 &ctx1);
+		CU_ASSERT(rc == 0);
+		poll_threads();
+		CU_ASSERT(g_lock_lba_range_done == true);
+	}
+
+	offset = 0;
+	RB_FOREACH(range, lba_range_tree, &channel->locked_ranges) {
+		CU_ASSERT(range->offset == offset);
+		CU_ASSERT(range->length == 8);
+		offset += 16;
+	}
+	CU_ASSERT(offset == 64 * 16);
+
+	/* Writes that fall between the locked ranges are submitted right away. */
+	for (i = 0; i < 64; i++) {
+		g_io_done = false;
+		rc = spdk_bdev_write_blocks(desc, io_ch, buf, i * 16 + 8, 8, io_done, &ctx2);
+		CU_ASSERT(rc == 0);
+		CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+		stub_complete_io(1);
+		CU_ASSERT(g_io_done == true);
+	}
+
+	/* Writes overlapping any of the locked ranges are held, including those that start
+	 * in a gap and end in the next range.
+	 */
+	rc = spdk_bdev_write_blocks(desc, io_ch, buf, 33 * 16, 1, io_done, &ctx2);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_write_blocks(desc, io_ch, buf, 40 * 16 + 12, 8, io_done, &ctx2);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_write_blocks(desc, io_ch, buf, 63 * 16 + 7, 2, io_done, &ctx2);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 0);
+
+	for (i = 0; i < 64; i++) {
+		g_unlock_lba_range_done = false;
+		rc = bdev_unlock_lba_range(desc, io_ch, i * 16, 8, unlock_lba_range_done, &ctx1);
+		CU_ASSERT(rc == 0);
+		poll_threads();
+		CU_ASSERT(g_unlock_lba_range_done == true);
+	}
+
+	CU_ASSERT(RB_EMPTY(&channel->locked_ranges));
+	CU_ASSERT(TAILQ_EMPTY(&bdev->internal.locked_ranges));
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 3);
+	stub_complete_io(3);
+
+	spdk_put_io_channel(io_ch);
+	spdk_bdev_close(desc);
+	free_bdev(bdev);
+	ut_fini_bdev();
+}
+
 static void
 lock_lba_range_with_split_io(void)
 {
@@ -5358,7 +5599,7 @@ lock_lba_range_with_split_io(void)
 	 */
 	CU_ASSERT(g_io_done == false);
 	CU_ASSERT(g_lock_lba_range_done == false);
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = RB_MIN(lba_range_tree, &channel->locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 20);
 	CU_ASSERT(range->length == 10);
@@ -5383,7 +5624,7 @@ lock_lba_range_with_split_io(void)
 	CU_ASSERT(rc == 0);
 	poll_threads();
 
-	CU_ASSERT(TAILQ_EMPTY(&channel->locked_ranges));
+	CU_ASSERT(RB_EMPTY(&channel->locked_ranges));
 
 	spdk_put_io_channel(io_ch);
 	spdk_bdev_close(desc);
@@ -5444,7 +5685,7 @@ bdev_quiesce(void)
 	poll_threads();
 
 	CU_ASSERT(g_lock_lba_range_done == true);
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = RB_MIN(lba_range_tree, &channel->locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 0);
 	CU_ASSERT(range->length == bdev->blockcnt);
@@ -5462,7 +5703,7 @@ bdev_quiesce(void)
 	poll_threads();
 
 	CU_ASSERT(g_unlock_lba_range_done == true);
-	CU_ASSERT(TAILQ_EMPTY(&channel->locked_ranges));
+	CU_ASSERT(RB_EMPTY(&channel->locked_ranges));
 	CU_ASSERT(TAILQ_EMPTY(&bdev_ut_if.internal.quiesced_ranges));
 
 	g_lock_lba_range_done = false;
@@ -5471,7 +5712,7 @@ bdev_quiesce(void)
 	poll_threads();
 
 	CU_ASSERT(g_lock_lba_range_done == true);
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = RB_MIN(lba_range_tree, &channel->locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 20);
 	CU_ASSERT(range->length == 10);
@@ -5494,7 +5735,7 @@ bdev_quiesce(void)
 	poll_threads();
 
 	CU_ASSERT(g_unlock_lba_range_done == true);
-	CU_ASSERT(TAILQ_EMPTY(&channel->locked_ranges));
+	CU_ASSERT(RB_EMPTY(&channel->locked_ranges));
 	CU_ASSERT(TAILQ_EMPTY(&bdev_ut_if.internal.quiesced_ranges));
 
 	/* Test unquiesce from quiesce cb */
@@ -5520,7 +5761,7 @@ bdev_quiesce(void)
 
 	CU_ASSERT(g_io_done == false);
 	CU_ASSERT(g_lock_lba_range_done == false);
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = RB_MIN(lba_range_tree, &channel->locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 
 	stub_complete_io(1);
@@ -5545,7 +5786,7 @@ bdev_quiesce(void)
 	poll_threads();
 
 	CU_ASSERT(g_unlock_lba_range_done == true);
-	CU_ASSERT(TAILQ_EMPTY(&channel->locked_ranges));
+	CU_ASSERT(RB_EMPTY(&channel->locked_ranges));
 	CU_ASSERT(TAILQ_EMPTY(&bdev_ut_if.internal.quiesced_ranges));
 
 	CU_ASSERT(TAILQ_EMPTY(&channel->io_locked));
@@ -8327,6 +8568,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, bdev_io_alignment_with_boundary);
 	CU_ADD_TEST(suite, bdev_io_alignment);
 	CU_ADD_TEST(suite, bdev_histograms);
+	CU_ADD_TEST(suite, bdev_io_merge_test);
 	CU_ADD_TEST(suite, bdev_write_zeroes);
 	CU_ADD_TEST(suite, bdev_write_uncorrectable);
 	CU_ADD_TEST(suite, bdev_compare_and_write);
@@ -8344,6 +8586,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, lock_lba_range_check_ranges);
 	CU_ADD_TEST(suite, lock_lba_range_with_io_outstanding);
 	CU_ADD_TEST(suite, lock_lba_range_overlapped);
+	CU_ADD_TEST(suite, lock_lba_range_many);
 	CU_ADD_TEST(suite, lock_lba_range_with_split_io);
 	CU_ADD_TEST(suite, bdev_quiesce);
 	CU_ADD_TEST(suite, bdev_unregister_during_quiesced_range_unlock);
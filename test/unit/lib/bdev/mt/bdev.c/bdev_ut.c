@@ -1476,6 +1476,89 @@ enomem(void)
 	teardown_test();
 }
 
+static void
+enomem_priority(void)
+{
+	struct spdk_io_channel *io_ch;
+	struct spdk_bdev_channel *bdev_ch;
+	struct spdk_bdev_shared_resource *shared_resource;
+	struct ut_bdev_channel *ut_ch;
+	struct spdk_bdev_ext_io_opts opts = { .size = sizeof(opts) };
+	struct iovec iov = {};
+	enum spdk_bdev_io_status status[13], status_reset;
+	/* Submission order, by index in status[]: the first one occupies the module */
+	const uint8_t N = SPDK_BDEV_IO_PRIORITY_NORMAL, H = SPDK_BDEV_IO_PRIORITY_HIGH,
+		      L = SPDK_BDEV_IO_PRIORITY_LOW;
+	const uint8_t priority[13] = { N, L, L, N, N, N, N, N, N, N, N, H, N };
+	/*
+	 * The high priority I/O goes first, the normal ones pass the low ones until each low one
+	 * was passed BDEV_IO_PRIORITY_LOW_WEIGHT times and the last normal one queues behind them.
+	 */
+	const uint8_t expected[12] = { 11, 3, 4, 5, 6, 7, 8, 9, 10, 1, 2, 12 };
+	struct spdk_bdev_io *bdev_io;
+	uint32_t i;
+	int rc;
+
+	setup_test();
+
+	set_thread(0);
+	io_ch = spdk_bdev_get_io_channel(g_desc);
+	bdev_ch = spdk_io_channel_get_ctx(io_ch);
+	shared_resource = bdev_ch->shared_resource;
+	ut_ch = spdk_io_channel_get_ctx(bdev_ch->channel);
+	ut_ch->avail_cnt = 1;
+
+	for (i = 0; i < SPDK_COUNTOF(status); i++) {
+		status[i] = SPDK_BDEV_IO_STATUS_PENDING;
+		opts.priority = priority[i];
+		rc = spdk_bdev_readv_blocks_ext(g_desc, io_ch, &iov, 1, 0, 1, enomem_done,
+						&status[i], &opts);
+		CU_ASSERT(rc == 0);
+	}
+
+	CU_ASSERT(bdev_io_tailq_cnt(&shared_resource->nomem_io) == SPDK_COUNTOF(expected));
+	i = 0;
+	TAILQ_FOREACH(bdev_io, &shared_resource->nomem_io, internal.link) {
+		SPDK_CU_ASSERT_FATAL(i < SPDK_COUNTOF(expected));
+		CU_ASSERT(bdev_io->internal.caller_ctx == &status[expected[i]]);
+		CU_ASSERT(spdk_bdev_io_get_priority(bdev_io) == priority[expected[i]]);
+		i++;
+	}
+
+	/* An out of range priority is rejected */
+	opts.priority = SPDK_BDEV_IO_PRIORITY_LOW + 1;
+	rc = spdk_bdev_readv_blocks_ext(g_desc, io_ch, &iov, 1, 0, 1, enomem_done, NULL, &opts);
+	CU_ASSERT(rc == -EINVAL);
+
+	/*
+	 * Completing the outstanding I/O retries the high priority one first.  The module only
+	 * frees its slot after the completion, so the retry comes from the nomem poller.
+	 */
+	stub_complete_io(g_bdev.io_target, 1);
+	CU_ASSERT(status[0] == SPDK_BDEV_IO_STATUS_SUCCESS);
+	spdk_delay_us(10 * SPDK_MSEC_TO_USEC);
+	poll_threads();
+	CU_ASSERT(bdev_io_tailq_cnt(&shared_resource->nomem_io) == SPDK_COUNTOF(expected) - 1);
+	bdev_io = TAILQ_FIRST(&shared_resource->nomem_io);
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	CU_ASSERT(bdev_io->internal.caller_ctx == &status[expected[1]]);
+	stub_complete_io(g_bdev.io_target, 1);
+	CU_ASSERT(status[expected[0]] == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	status_reset = SPDK_BDEV_IO_STATUS_PENDING;
+	rc = spdk_bdev_reset(g_desc, io_ch, enomem_done, &status_reset);
+	poll_threads();
+	CU_ASSERT(rc == 0);
+	stub_complete_io(g_bdev.io_target, 0);
+
+	CU_ASSERT(bdev_io_tailq_cnt(&shared_resource->nomem_io) == 0);
+	CU_ASSERT(shared_resource->io_outstanding == 0);
+
+	spdk_put_io_channel(io_ch);
+	poll_threads();
+	teardown_test();
+}
+
 static void
 enomem_multi_bdev(void)
 {
@@ -2331,7 +2414,7 @@ lock_lba_range_then_submit_io(void)
 	 * write I/O.
 	 */
 	CU_ASSERT(g_lock_lba_range_done == true);
-	range = TAILQ_FIRST(&bdev_ch[0]->locked_ranges);
+	range = RB_MIN(lba_range_tree, &bdev_ch[0]->locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 20);
 	CU_ASSERT(range->length == 10);
@@ -2398,7 +2481,7 @@ lock_lba_range_then_submit_io(void)
 	rc = bdev_unlock_lba_range(desc, io_ch[0], 20, 10, unlock_lba_range_done, &ctx0);
 	CU_ASSERT(rc == 0);
 	poll_threads();
-	CU_ASSERT(TAILQ_EMPTY(&bdev_ch[0]->locked_ranges));
+	CU_ASSERT(RB_EMPTY(&bdev_ch[0]->locked_ranges));
 
 	/* The LBA range is unlocked, so the write IOs should now have started execution. */
 	CU_ASSERT(TAILQ_EMPTY(&bdev_ch[1]->io_locked));
@@ -2872,6 +2955,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, io_during_qos_queue);
 	CU_ADD_TEST(suite, io_during_qos_reset);
 	CU_ADD_TEST(suite, enomem);
+	CU_ADD_TEST(suite, enomem_priority);
 	CU_ADD_TEST(suite, enomem_multi_bdev);
 	CU_ADD_TEST(suite, enomem_multi_bdev_unregister);
 	CU_ADD_TEST(suite, enomem_multi_io_target);
@@ -0,0 +1,1051 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk_internal/cunit.h"
+#include "spdk/env.h"
+#include "spdk/pq.h"
+
+#include "common/lib/ut_multithread.c"
+
+#include "bdev/raid/raid6.c"
+#include "../common.c"
+
+/* Number of stripes exercised by each test, the base bdevs are backed by memory */
+#define TEST_STRIPES_MAX 6
+
+static void *g_accel_p = (void *)0xdeadbeaf;
+static int g_process_status;
+static bool g_process_done;
+
+DEFINE_STUB_V(raid_bdev_module_list_add, (struct raid_bdev_module *raid_module));
+DEFINE_STUB(spdk_bdev_get_buf_align, size_t, (const struct spdk_bdev *bdev), 0);
+DEFINE_STUB_V(raid_bdev_module_stop_done, (struct raid_bdev *raid_bdev));
+DEFINE_STUB(accel_channel_create, int, (void *io_device, void *ctx_buf), 0);
+DEFINE_STUB_V(accel_channel_destroy, (void *io_device, void *ctx_buf));
+DEFINE_STUB(raid_bdev_remap_dix_reftag, int, (void *md_buf, uint64_t num_blocks,
+		struct spdk_bdev *bdev, uint32_t remapped_offset), -1);
+
+struct spdk_io_channel *
+spdk_accel_get_io_channel(void)
+{
+	return spdk_get_io_channel(g_accel_p);
+}
+
+struct pq_ctx {
+	spdk_accel_completion_cb cb_fn;
+	void *cb_arg;
+	int status;
+};
+
+static void
+finish_pq(void *_ctx)
+{
+	struct pq_ctx *ctx = _ctx;
+
+	ctx->cb_fn(ctx->cb_arg, ctx->status);
+
+	free(ctx);
+}
+
+static int
+submit_pq(int status, spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	struct pq_ctx *ctx;
+
+	ctx = malloc(sizeof(*ctx));
+	SPDK_CU_ASSERT_FATAL(ctx != NULL);
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+	ctx->status = status;
+
+	spdk_thread_send_msg(spdk_get_thread(), finish_pq, ctx);
+
+	return 0;
+}
+
+int
+spdk_accel_submit_pq_gen(struct spdk_io_channel *ch, void **buffers, uint32_t ndata,
+			 uint64_t nbytes, spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	return submit_pq(spdk_pq_gen(buffers, ndata, nbytes), cb_fn, cb_arg);
+}
+
+int
+spdk_accel_submit_pq_recover(struct spdk_io_channel *ch, void **buffers, uint32_t ndata,
+			     uint64_t nbytes, const uint32_t *failed, uint32_t nfailed,
+			     spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	return submit_pq(spdk_pq_recover(buffers, ndata, nbytes, failed, nfailed), cb_fn, cb_arg);
+}
+
+void
+raid_bdev_io_init(struct raid_bdev_io *raid_io, struct raid_bdev_io_channel *raid_ch,
+		  enum spdk_bdev_io_type type, uint64_t offset_blocks,
+		  uint64_t num_blocks, struct iovec *iovs, int iovcnt, void *md_buf,
+		  struct spdk_memory_domain *memory_domain, void *memory_domain_ctx)
+{
+	struct spdk_io_channel *ch = spdk_io_channel_from_ctx(raid_ch);
+
+	raid_test_bdev_io_init(raid_io, spdk_io_channel_get_io_device(ch), raid_ch, type,
+			       offset_blocks, num_blocks, iovs, iovcnt, md_buf);
+}
+
+void
+raid_bdev_process_request_complete(struct raid_bdev_process_request *process_req, int status)
+{
+	g_process_status = status;
+	g_process_done = true;
+}
+
+static void
+init_accel(void)
+{
+	spdk_io_device_register(g_accel_p, accel_channel_create, accel_channel_destroy,
+				sizeof(int), "accel_p");
+}
+
+static void
+fini_accel(void)
+{
+	spdk_io_device_unregister(g_accel_p, NULL);
+}
+
+static int
+test_suite_init(void)
+{
+	uint8_t num_base_bdevs_values[] = { 4, 5, 6 };
+	uint64_t base_bdev_blockcnt_values[] = { 1, 1024, 1024 * 1024 };
+	uint32_t base_bdev_blocklen_values[] = { 512, 4096 };
+	uint32_t strip_size_kb_values[] = { 1, 4, 128 };
+	enum raid_params_md_type md_type_values[] = { RAID_PARAMS_MD_NONE, RAID_PARAMS_MD_SEPARATE, RAID_PARAMS_MD_INTERLEAVED };
+	uint8_t *num_base_bdevs;
+	uint64_t *base_bdev_blockcnt;
+	uint32_t *base_bdev_blocklen;
+	uint32_t *strip_size_kb;
+	enum raid_params_md_type *md_type;
+	uint64_t params_count;
+	int rc;
+
+	params_count = SPDK_COUNTOF(num_base_bdevs_values) *
+		       SPDK_COUNTOF(base_bdev_blockcnt_values) *
+		       SPDK_COUNTOF(base_bdev_blocklen_values) *
+		       SPDK_COUNTOF(strip_size_kb_values) *
+		       SPDK_COUNTOF(md_type_values);
+	rc = raid_test_params_alloc(params_count);
+	if (rc) {
+		return rc;
+	}
+
+	ARRAY_FOR_EACH(num_base_bdevs_values, num_base_bdevs) {
+		ARRAY_FOR_EACH(base_bdev_blockcnt_values, base_bdev_blockcnt) {
+			ARRAY_FOR_EACH(base_bdev_blocklen_values, base_bdev_blocklen) {
+				ARRAY_FOR_EACH(strip_size_kb_values, strip_size_kb) {
+					ARRAY_FOR_EACH(md_type_values, md_type) {
+						struct raid_params params = {
+							.num_base_bdevs = *num_base_bdevs,
+							.base_bdev_blockcnt = *base_bdev_blockcnt,
+							.base_bdev_blocklen = *base_bdev_blocklen,
+							.strip_size = *strip_size_kb * 1024 / *base_bdev_blocklen,
+							.md_type = *md_type,
+						};
+						if (params.strip_size == 0 ||
+						    params.strip_size > params.base_bdev_blockcnt) {
+							continue;
+						}
+						raid_test_params_add(&params);
+					}
+				}
+			}
+		}
+	}
+
+	init_accel();
+
+	return 0;
+}
+
+static int
+test_suite_cleanup(void)
+{
+	fini_accel();
+	raid_test_params_free();
+	return 0;
+}
+
+static struct raid6_info *
+create_raid6(struct raid_params *params)
+{
+	struct raid_bdev *raid_bdev = raid_test_create_raid_bdev(params, &g_raid6_module);
+
+	SPDK_CU_ASSERT_FATAL(raid6_start(raid_bdev) == 0);
+
+	return raid_bdev->module_private;
+}
+
+static void
+delete_raid6(struct raid6_info *r6_info)
+{
+	struct raid_bdev *raid_bdev = r6_info->raid_bdev;
+
+	raid6_stop(raid_bdev);
+
+	raid_test_delete_raid_bdev(raid_bdev);
+}
+
+static void
+test_raid6_start(void)
+{
+	struct raid_params *params;
+
+	RAID_PARAMS_FOR_EACH(params) {
+		struct raid6_info *r6_info;
+
+		r6_info = create_raid6(params);
+
+		SPDK_CU_ASSERT_FATAL(r6_info != NULL);
+
+		CU_ASSERT_EQUAL(r6_info->stripe_blocks, params->strip_size * (params->num_base_bdevs - 2));
+		CU_ASSERT_EQUAL(r6_info->total_stripes, params->base_bdev_blockcnt / params->strip_size);
+		CU_ASSERT_EQUAL(r6_info->raid_bdev->bdev.blockcnt,
+				(params->base_bdev_blockcnt - params->base_bdev_blockcnt % params->strip_size) *
+				(params->num_base_bdevs - 2));
+		CU_ASSERT_EQUAL(r6_info->raid_bdev->bdev.optimal_io_boundary, params->strip_size);
+		CU_ASSERT_TRUE(r6_info->raid_bdev->bdev.split_on_optimal_io_boundary);
+		CU_ASSERT_EQUAL(r6_info->raid_bdev->bdev.write_unit_size, r6_info->stripe_blocks);
+		CU_ASSERT_EQUAL(r6_info->buf_alignment % spdk_pq_get_optimal_alignment(), 0);
+
+		delete_raid6(r6_info);
+	}
+}
+
+enum test_bdev_error_type {
+	TEST_BDEV_ERROR_NONE,
+	TEST_BDEV_ERROR_SUBMIT,
+	TEST_BDEV_ERROR_COMPLETE,
+	TEST_BDEV_ERROR_NOMEM,
+};
+
+/* Memory backed base bdev */
+struct test_disk {
+	void *buf;
+	void *md_buf;
+};
+
+struct test_raid6 {
+	struct raid6_info *r6_info;
+	struct raid_bdev *raid_bdev;
+	struct raid_bdev_io_channel *raid_ch;
+	struct test_disk *disks;
+	uint64_t num_stripes;
+	uint64_t disk_blocks;
+	uint32_t md_len;
+	TAILQ_HEAD(, spdk_bdev_io) bdev_io_queue;
+	TAILQ_HEAD(, spdk_bdev_io_wait_entry) bdev_io_wait_queue;
+	struct {
+		enum test_bdev_error_type type;
+		struct spdk_bdev *bdev;
+	} error;
+};
+
+static struct test_raid6 g_test;
+
+struct test_raid_bdev_io {
+	struct raid_bdev_io raid_io;
+	enum spdk_bdev_io_status status;
+	bool completed;
+};
+
+void
+raid_bdev_queue_io_wait(struct raid_bdev_io *raid_io, struct spdk_bdev *bdev,
+			struct spdk_io_channel *ch, spdk_bdev_io_wait_cb cb_fn)
+{
+	raid_io->waitq_entry.bdev = bdev;
+	raid_io->waitq_entry.cb_fn = cb_fn;
+	raid_io->waitq_entry.cb_arg = raid_io;
+	TAILQ_INSERT_TAIL(&g_test.bdev_io_wait_queue, &raid_io->waitq_entry, link);
+}
+
+void
+raid_test_bdev_io_complete(struct raid_bdev_io *raid_io, enum spdk_bdev_io_status status)
+{
+	struct test_raid_bdev_io *test_raid_bdev_io = SPDK_CONTAINEROF(raid_io, struct test_raid_bdev_io,
+			raid_io);
+
+	test_raid_bdev_io->status = status;
+	test_raid_bdev_io->completed = true;
+}
+
+void
+spdk_bdev_free_io(struct spdk_bdev_io *bdev_io)
+{
+	free(bdev_io);
+}
+
+static struct test_disk *
+get_disk(struct spdk_bdev_desc *desc)
+{
+	struct raid_base_bdev_info *base_info = desc->bdev->ctxt;
+
+	return &g_test.disks[raid_bdev_base_bdev_slot(base_info)];
+}
+
+static int
+submit_io(struct spdk_bdev_desc *desc, spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	struct spdk_bdev *bdev = desc->bdev;
+	struct spdk_bdev_io *bdev_io;
+
+	if (bdev == g_test.error.bdev) {
+		if (g_test.error.type == TEST_BDEV_ERROR_SUBMIT) {
+			return -EINVAL;
+		} else if (g_test.error.type == TEST_BDEV_ERROR_NOMEM) {
+			return -ENOMEM;
+		}
+	}
+
+	bdev_io = calloc(1, sizeof(*bdev_io));
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	bdev_io->bdev = bdev;
+	bdev_io->internal.cb = cb;
+	bdev_io->internal.caller_ctx = cb_arg;
+
+	TAILQ_INSERT_TAIL(&g_test.bdev_io_queue, bdev_io, internal.link);
+
+	return 0;
+}
+
+static void
+process_io_completions(void)
+{
+	struct spdk_bdev_io *bdev_io;
+	bool success;
+
+	do {
+		poll_threads();
+
+		while ((bdev_io = TAILQ_FIRST(&g_test.bdev_io_queue))) {
+			TAILQ_REMOVE(&g_test.bdev_io_queue, bdev_io, internal.link);
+
+			if (g_test.error.type == TEST_BDEV_ERROR_COMPLETE &&
+			    g_test.error.bdev == bdev_io->bdev) {
+				success = false;
+			} else {
+				success = true;
+			}
+
+			bdev_io->internal.cb(bdev_io, success, bdev_io->internal.caller_ctx);
+		}
+
+		if (g_test.error.type == TEST_BDEV_ERROR_NOMEM) {
+			struct spdk_bdev_io_wait_entry *waitq_entry, *tmp;
+
+			g_test.error.type = TEST_BDEV_ERROR_NONE;
+
+			TAILQ_FOREACH_SAFE(waitq_entry, &g_test.bdev_io_wait_queue, link, tmp) {
+				TAILQ_REMOVE(&g_test.bdev_io_wait_queue, waitq_entry, link);
+				CU_ASSERT(waitq_entry->bdev == g_test.error.bdev);
+				waitq_entry->cb_fn(waitq_entry->cb_arg);
+			}
+		}
+		poll_threads();
+	} while (!TAILQ_EMPTY(&g_test.bdev_io_queue));
+
+	CU_ASSERT(TAILQ_EMPTY(&g_test.bdev_io_wait_queue));
+}
+
+int
+spdk_bdev_writev_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			    struct iovec *iov, int iovcnt, uint64_t offset_blocks,
+			    uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg,
+			    struct spdk_bdev_ext_io_opts *opts)
+{
+	struct test_disk *disk = get_disk(desc);
+	uint32_t blocklen = g_test.raid_bdev->bdev.blocklen;
+	struct iovec dest;
+	int ret;
+
+	CU_ASSERT_PTR_NULL(opts->memory_domain);
+	CU_ASSERT_PTR_NULL(opts->memory_domain_ctx);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+	SPDK_CU_ASSERT_FATAL(offset_blocks + num_blocks <= g_test.disk_blocks);
+
+	ret = submit_io(desc, cb, cb_arg);
+	if (ret == 0) {
+		dest.iov_base = disk->buf + offset_blocks * blocklen;
+		dest.iov_len = num_blocks * blocklen;
+		spdk_iovcpy(iov, iovcnt, &dest, 1);
+
+		if (g_test.md_len) {
+			SPDK_CU_ASSERT_FATAL(opts->metadata != NULL);
+			memcpy(disk->md_buf + offset_blocks * g_test.md_len, opts->metadata,
+			       num_blocks * g_test.md_len);
+		}
+	}
+
+	return ret;
+}
+
+int
+spdk_bdev_readv_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			   struct iovec *iov, int iovcnt, uint64_t offset_blocks,
+			   uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg,
+			   struct spdk_bdev_ext_io_opts *opts)
+{
+	struct test_disk *disk = get_disk(desc);
+	uint32_t blocklen = g_test.raid_bdev->bdev.blocklen;
+	struct iovec src;
+	int ret;
+
+	CU_ASSERT_PTR_NULL(opts->memory_domain);
+	CU_ASSERT_PTR_NULL(opts->memory_domain_ctx);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+	SPDK_CU_ASSERT_FATAL(offset_blocks + num_blocks <= g_test.disk_blocks);
+
+	ret = submit_io(desc, cb, cb_arg);
+	if (ret == 0) {
+		src.iov_base = disk->buf + offset_blocks * blocklen;
+		src.iov_len = num_blocks * blocklen;
+		spdk_iovcpy(&src, 1, iov, iovcnt);
+
+		if (g_test.md_len) {
+			SPDK_CU_ASSERT_FATAL(opts->metadata != NULL);
+			memcpy(opts->metadata, disk->md_buf + offset_blocks * g_test.md_len,
+			       num_blocks * g_test.md_len);
+		}
+	}
+
+	return ret;
+}
+
+static void
+fill_buf(void *buf, size_t len, uint64_t seed)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		((uint8_t *)buf)[i] = (uint8_t)((seed * 31 + i * 7) ^ (i >> 8));
+	}
+}
+
+static struct test_raid_bdev_io *
+get_raid_io(enum spdk_bdev_io_type io_type, uint64_t offset_blocks, uint64_t num_blocks,
+	    void *buf, void *md_buf)
+{
+	struct test_raid_bdev_io *test_raid_bdev_io;
+	struct iovec *iovs;
+	size_t iov_len, remaining;
+	int iovcnt = 7;
+	int i;
+
+	test_raid_bdev_io = calloc(1, sizeof(*test_raid_bdev_io));
+	SPDK_CU_ASSERT_FATAL(test_raid_bdev_io != NULL);
+
+	iovs = calloc(iovcnt, sizeof(*iovs));
+	SPDK_CU_ASSERT_FATAL(iovs != NULL);
+
+	remaining = num_blocks * g_test.raid_bdev->bdev.blocklen;
+	iov_len = remaining / iovcnt;
+
+	for (i = 0; i < iovcnt; i++) {
+		iovs[i].iov_base = buf;
+		iovs[i].iov_len = iov_len;
+		buf += iov_len;
+		remaining -= iov_len;
+	}
+	iovs[iovcnt - 1].iov_len += remaining;
+
+	raid_test_bdev_io_init(&test_raid_bdev_io->raid_io, g_test.raid_bdev, g_test.raid_ch, io_type,
+			       offset_blocks, num_blocks, iovs, iovcnt, md_buf);
+
+	return test_raid_bdev_io;
+}
+
+static enum spdk_bdev_io_status
+submit_rw_request(enum spdk_bdev_io_type io_type, uint64_t offset_blocks, uint64_t num_blocks,
+		  void *buf, void *md_buf)
+{
+	struct test_raid_bdev_io *test_raid_bdev_io;
+	enum spdk_bdev_io_status status;
+
+	test_raid_bdev_io = get_raid_io(io_type, offset_blocks, num_blocks, buf, md_buf);
+
+	raid6_submit_rw_request(&test_raid_bdev_io->raid_io);
+
+	process_io_completions();
+
+	CU_ASSERT(test_raid_bdev_io->completed);
+	status = test_raid_bdev_io->status;
+
+	free(test_raid_bdev_io->raid_io.iovs);
+	free(test_raid_bdev_io);
+
+	return status;
+}
+
+static int
+test_raid_ch_create(void *io_device, void *ctx_buf)
+{
+	struct raid_bdev_io_channel *raid_ch = ctx_buf;
+	struct raid_bdev_io_channel *tmp;
+
+	tmp = raid_test_create_io_channel(io_device);
+	*raid_ch = *tmp;
+	free(tmp);
+
+	return 0;
+}
+
+static void
+test_raid_ch_destroy(void *io_device, void *ctx_buf)
+{
+	struct raid_bdev_io_channel *raid_ch = ctx_buf;
+
+	free(raid_ch->_base_channels);
+	spdk_put_io_channel(raid_ch->_module_channel);
+}
+
+static void
+test_raid6_setup(struct raid_params *params)
+{
+	struct raid_bdev *raid_bdev;
+	uint8_t i;
+
+	memset(&g_test, 0, sizeof(g_test));
+	TAILQ_INIT(&g_test.bdev_io_queue);
+	TAILQ_INIT(&g_test.bdev_io_wait_queue);
+
+	g_test.r6_info = create_raid6(params);
+	g_test.raid_bdev = raid_bdev = g_test.r6_info->raid_bdev;
+	spdk_io_device_register(raid_bdev, test_raid_ch_create, test_raid_ch_destroy,
+				sizeof(struct raid_bdev_io_channel), NULL);
+	g_test.raid_ch = spdk_io_channel_get_ctx(spdk_get_io_channel(raid_bdev));
+	g_test.num_stripes = spdk_min(g_test.r6_info->total_stripes, TEST_STRIPES_MAX);
+	g_test.disk_blocks = g_test.num_stripes * raid_bdev->strip_size;
+	g_test.md_len = raid_bdev->bdev.md_interleave ? 0 : raid_bdev->bdev.md_len;
+
+	g_test.disks = calloc(raid_bdev->num_base_bdevs, sizeof(*g_test.disks));
+	SPDK_CU_ASSERT_FATAL(g_test.disks != NULL);
+
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		g_test.disks[i].buf = calloc(g_test.disk_blocks, raid_bdev->bdev.blocklen);
+		SPDK_CU_ASSERT_FATAL(g_test.disks[i].buf != NULL);
+		if (g_test.md_len) {
+			g_test.disks[i].md_buf = calloc(g_test.disk_blocks, g_test.md_len);
+			SPDK_CU_ASSERT_FATAL(g_test.disks[i].md_buf != NULL);
+		}
+	}
+}
+
+static void
+test_raid6_teardown(void)
+{
+	uint8_t i;
+
+	for (i = 0; i < g_test.raid_bdev->num_base_bdevs; i++) {
+		free(g_test.disks[i].buf);
+		free(g_test.disks[i].md_buf);
+	}
+	free(g_test.disks);
+
+	spdk_put_io_channel(spdk_io_channel_from_ctx(g_test.raid_ch));
+	spdk_io_device_unregister(g_test.raid_bdev, NULL);
+	poll_threads();
+	delete_raid6(g_test.r6_info);
+}
+
+static void
+set_base_channel(uint8_t idx, bool present)
+{
+	g_test.raid_ch->_base_channels[idx] = present ? (void *)1 : NULL;
+}
+
+/* Write all tested stripes with a data pattern derived from the stripe index */
+static void
+write_stripes(void **data, void **md)
+{
+	struct raid6_info *r6_info = g_test.r6_info;
+	struct raid_bdev *raid_bdev = g_test.raid_bdev;
+	uint64_t stripe_index;
+	enum spdk_bdev_io_status status;
+
+	for (stripe_index = 0; stripe_index < g_test.num_stripes; stripe_index++) {
+		data[stripe_index] = malloc(r6_info->stripe_blocks * raid_bdev->bdev.blocklen);
+		SPDK_CU_ASSERT_FATAL(data[stripe_index] != NULL);
+		fill_buf(data[stripe_index], r6_info->stripe_blocks * raid_bdev->bdev.blocklen, stripe_index);
+
+		md[stripe_index] = NULL;
+		if (g_test.md_len) {
+			md[stripe_index] = malloc(r6_info->stripe_blocks * g_test.md_len);
+			SPDK_CU_ASSERT_FATAL(md[stripe_index] != NULL);
+			fill_buf(md[stripe_index], r6_info->stripe_blocks * g_test.md_len, ~stripe_index);
+		}
+
+		status = submit_rw_request(SPDK_BDEV_IO_TYPE_WRITE, stripe_index * r6_info->stripe_blocks,
+					   r6_info->stripe_blocks, data[stripe_index], md[stripe_index]);
+		CU_ASSERT(status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	}
+}
+
+static void
+free_stripes(void **data, void **md)
+{
+	uint64_t stripe_index;
+
+	for (stripe_index = 0; stripe_index < g_test.num_stripes; stripe_index++) {
+		free(data[stripe_index]);
+		free(md[stripe_index]);
+	}
+}
+
+/* Verify the on-disk layout of a stripe against the data written to it */
+static void
+verify_stripe_on_disks(uint64_t stripe_index, void *data, void *md, uint8_t skip_idx)
+{
+	struct raid_bdev *raid_bdev = g_test.raid_bdev;
+	uint8_t ndata = raid6_stripe_data_chunks_num(raid_bdev);
+	size_t strip_len = raid_bdev->strip_size * raid_bdev->bdev.blocklen;
+	size_t strip_md_len = raid_bdev->strip_size * g_test.md_len;
+	uint64_t disk_offset = stripe_index * strip_len;
+	uint64_t disk_md_offset = stripe_index * strip_md_len;
+	void *bufs[ndata + 2], *md_bufs[ndata + 2];
+	uint8_t p_idx = raid6_stripe_p_chunk_index(raid_bdev, stripe_index);
+	uint8_t q_idx = raid6_stripe_q_chunk_index(raid_bdev, stripe_index);
+	uint8_t d, idx;
+
+	for (d = 0; d < ndata; d++) {
+		idx = raid6_stripe_data_chunk_index(raid_bdev, stripe_index, d);
+		CU_ASSERT(idx != p_idx && idx != q_idx);
+		bufs[d] = data + d * strip_len;
+		if (idx != skip_idx) {
+			CU_ASSERT(memcmp(g_test.disks[idx].buf + disk_offset, bufs[d], strip_len) == 0);
+		}
+		if (g_test.md_len) {
+			md_bufs[d] = md + d * strip_md_len;
+			if (idx != skip_idx) {
+				CU_ASSERT(memcmp(g_test.disks[idx].md_buf + disk_md_offset, md_bufs[d],
+						 strip_md_len) == 0);
+			}
+		}
+	}
+
+	bufs[ndata] = malloc(strip_len);
+	bufs[ndata + 1] = malloc(strip_len);
+	SPDK_CU_ASSERT_FATAL(bufs[ndata] != NULL && bufs[ndata + 1] != NULL);
+	CU_ASSERT(spdk_pq_gen(bufs, ndata, strip_len) == 0);
+	if (p_idx != skip_idx) {
+		CU_ASSERT(memcmp(g_test.disks[p_idx].buf + disk_offset, bufs[ndata], strip_len) == 0);
+	}
+	if (q_idx != skip_idx) {
+		CU_ASSERT(memcmp(g_test.disks[q_idx].buf + disk_offset, bufs[ndata + 1], strip_len) == 0);
+	}
+	free(bufs[ndata]);
+	free(bufs[ndata + 1]);
+
+	if (g_test.md_len) {
+		md_bufs[ndata] = malloc(strip_md_len);
+		md_bufs[ndata + 1] = malloc(strip_md_len);
+		SPDK_CU_ASSERT_FATAL(md_bufs[ndata] != NULL && md_bufs[ndata + 1] != NULL);
+		CU_ASSERT(spdk_pq_gen(md_bufs, ndata, strip_md_len) == 0);
+		if (p_idx != skip_idx) {
+			CU_ASSERT(memcmp(g_test.disks[p_idx].md_buf + disk_md_offset, md_bufs[ndata],
+					 strip_md_len) == 0);
+		}
+		if (q_idx != skip_idx) {
+			CU_ASSERT(memcmp(g_test.disks[q_idx].md_buf + disk_md_offset, md_bufs[ndata + 1],
+					 strip_md_len) == 0);
+		}
+		free(md_bufs[ndata]);
+		free(md_bufs[ndata + 1]);
+	}
+}
+
+static void
+read_and_verify(uint64_t stripe_index, uint64_t stripe_offset, uint64_t num_blocks,
+		void *data, void *md)
+{
+	struct raid_bdev *raid_bdev = g_test.raid_bdev;
+	uint32_t blocklen = raid_bdev->bdev.blocklen;
+	void *buf, *md_buf = NULL;
+	enum spdk_bdev_io_status status;
+
+	buf = malloc(num_blocks * blocklen);
+	SPDK_CU_ASSERT_FATAL(buf != NULL);
+	memset(buf, 0xcd, num_blocks * blocklen);
+	if (g_test.md_len) {
+		md_buf = malloc(num_blocks * g_test.md_len);
+		SPDK_CU_ASSERT_FATAL(md_buf != NULL);
+		memset(md_buf, 0xcd, num_blocks * g_test.md_len);
+	}
+
+	status = submit_rw_request(SPDK_BDEV_IO_TYPE_READ,
+				   stripe_index * g_test.r6_info->stripe_blocks + stripe_offset,
+				   num_blocks, buf, md_buf);
+	CU_ASSERT(status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf, data + stripe_offset * blocklen, num_blocks * blocklen) == 0);
+	if (md_buf) {
+		CU_ASSERT(memcmp(md_buf, md + stripe_offset * g_test.md_len, num_blocks * g_test.md_len) == 0);
+	}
+
+	free(buf);
+	free(md_buf);
+}
+
+static void
+read_and_verify_stripes(void **data, void **md)
+{
+	struct raid_bdev *raid_bdev = g_test.raid_bdev;
+	uint32_t strip_size = raid_bdev->strip_size;
+	uint64_t stripe_index;
+	uint8_t d;
+
+	for (stripe_index = 0; stripe_index < g_test.num_stripes; stripe_index++) {
+		for (d = 0; d < raid6_stripe_data_chunks_num(raid_bdev); d++) {
+			uint64_t stripe_offset = d * strip_size;
+
+			read_and_verify(stripe_index, stripe_offset, strip_size, data[stripe_index], md[stripe_index]);
+			read_and_verify(stripe_index, stripe_offset + strip_size - 1, 1, data[stripe_index],
+					md[stripe_index]);
+			if (strip_size > 2) {
+				read_and_verify(stripe_index, stripe_offset + 1, strip_size - 2, data[stripe_index],
+						md[stripe_index]);
+			}
+		}
+	}
+}
+
+static void
+run_for_each_raid6_config(void (*test_fn)(void))
+{
+	struct raid_params *params;
+
+	RAID_PARAMS_FOR_EACH(params) {
+		test_raid6_setup(params);
+		test_fn();
+		test_raid6_teardown();
+	}
+}
+
+static void
+__test_raid6_stripe_layout(void)
+{
+	struct raid_bdev *raid_bdev = g_test.raid_bdev;
+	uint8_t ndata = raid6_stripe_data_chunks_num(raid_bdev);
+	uint64_t stripe_index;
+	uint8_t d, seen[raid_bdev->num_base_bdevs];
+
+	for (stripe_index = 0; stripe_index < raid_bdev->num_base_bdevs * 2; stripe_index++) {
+		memset(seen, 0, sizeof(seen));
+		seen[raid6_stripe_p_chunk_index(raid_bdev, stripe_index)]++;
+		seen[raid6_stripe_q_chunk_index(raid_bdev, stripe_index)]++;
+		for (d = 0; d < ndata; d++) {
+			seen[raid6_stripe_data_chunk_index(raid_bdev, stripe_index, d)]++;
+		}
+		for (d = 0; d < raid_bdev->num_base_bdevs; d++) {
+			CU_ASSERT(seen[d] == 1);
+		}
+		/* parity rotates over all base bdevs */
+		CU_ASSERT(raid6_stripe_p_chunk_index(raid_bdev, stripe_index) !=
+			  raid6_stripe_p_chunk_index(raid_bdev, stripe_index + 1));
+	}
+}
+static void
+test_raid6_stripe_layout(void)
+{
+	run_for_each_raid6_config(__test_raid6_stripe_layout);
+}
+
+static void
+__test_raid6_submit_full_stripe_write_request(void)
+{
+	void *data[TEST_STRIPES_MAX], *md[TEST_STRIPES_MAX];
+	uint64_t stripe_index;
+
+	write_stripes(data, md);
+
+	for (stripe_index = 0; stripe_index < g_test.num_stripes; stripe_index++) {
+		verify_stripe_on_disks(stripe_index, data[stripe_index], md[stripe_index], UINT8_MAX);
+	}
+
+	read_and_verify_stripes(data, md);
+
+	free_stripes(data, md);
+}
+static void
+test_raid6_submit_full_stripe_write_request(void)
+{
+	run_for_each_raid6_config(__test_raid6_submit_full_stripe_write_request);
+}
+
+static void
+__test_raid6_submit_read_request_degraded(void)
+{
+	struct raid_bdev *raid_bdev = g_test.raid_bdev;
+	void *data[TEST_STRIPES_MAX], *md[TEST_STRIPES_MAX];
+	uint8_t a, b;
+
+	write_stripes(data, md);
+
+	for (a = 0; a < raid_bdev->num_base_bdevs; a++) {
+		/* single failure */
+		set_base_channel(a, false);
+		read_and_verify_stripes(data, md);
+
+		/* double failures */
+		for (b = a + 1; b < raid_bdev->num_base_bdevs; b++) {
+			set_base_channel(b, false);
+			read_and_verify_stripes(data, md);
+			set_base_channel(b, true);
+		}
+		set_base_channel(a, true);
+	}
+
+	free_stripes(data, md);
+}
+static void
+test_raid6_submit_read_request_degraded(void)
+{
+	run_for_each_raid6_config(__test_raid6_submit_read_request_degraded);
+}
+
+static void
+__test_raid6_submit_full_stripe_write_request_degraded(void)
+{
+	struct raid_bdev *raid_bdev = g_test.raid_bdev;
+	void *data[TEST_STRIPES_MAX], *md[TEST_STRIPES_MAX];
+	uint8_t a;
+
+	for (a = 0; a < raid_bdev->num_base_bdevs; a++) {
+		set_base_channel(a, false);
+		set_base_channel((a + 1) % raid_bdev->num_base_bdevs, false);
+
+		write_stripes(data, md);
+		read_and_verify_stripes(data, md);
+
+		set_base_channel(a, true);
+		set_base_channel((a + 1) % raid_bdev->num_base_bdevs, true);
+
+		free_stripes(data, md);
+	}
+}
+static void
+test_raid6_submit_full_stripe_write_request_degraded(void)
+{
+	run_for_each_raid6_config(__test_raid6_submit_full_stripe_write_request_degraded);
+}
+
+static void
+__test_raid6_chunk_write_error(void)
+{
+	struct raid6_info *r6_info = g_test.r6_info;
+	struct raid_bdev *raid_bdev = g_test.raid_bdev;
+	struct raid_base_bdev_info *base_bdev_info;
+	enum test_bdev_error_type error_type;
+	uint64_t stripe_index;
+	enum spdk_bdev_io_status status;
+	void *buf, *md_buf = NULL;
+
+	buf = calloc(r6_info->stripe_blocks, raid_bdev->bdev.blocklen);
+	SPDK_CU_ASSERT_FATAL(buf != NULL);
+	if (g_test.md_len) {
+		md_buf = calloc(r6_info->stripe_blocks, g_test.md_len);
+		SPDK_CU_ASSERT_FATAL(md_buf != NULL);
+	}
+
+	for (error_type = TEST_BDEV_ERROR_SUBMIT; error_type <= TEST_BDEV_ERROR_NOMEM; error_type++) {
+		for (stripe_index = 0; stripe_index < g_test.num_stripes; stripe_index++) {
+			RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_bdev_info) {
+				g_test.error.type = error_type;
+				g_test.error.bdev = base_bdev_info->desc->bdev;
+
+				status = submit_rw_request(SPDK_BDEV_IO_TYPE_WRITE, stripe_index * r6_info->stripe_blocks,
+							   r6_info->stripe_blocks, buf, md_buf);
+
+				if (error_type == TEST_BDEV_ERROR_NOMEM) {
+					CU_ASSERT(status == SPDK_BDEV_IO_STATUS_SUCCESS);
+				} else {
+					CU_ASSERT(status == SPDK_BDEV_IO_STATUS_FAILED);
+				}
+
+				g_test.error.type = TEST_BDEV_ERROR_NONE;
+				g_test.error.bdev = NULL;
+			}
+		}
+	}
+
+	free(buf);
+	free(md_buf);
+}
+static void
+test_raid6_chunk_write_error(void)
+{
+	run_for_each_raid6_config(__test_raid6_chunk_write_error);
+}
+
+static void
+__test_raid6_chunk_read_error_degraded(void)
+{
+	struct raid_bdev *raid_bdev = g_test.raid_bdev;
+	uint32_t blocklen = raid_bdev->bdev.blocklen;
+	enum spdk_bdev_io_status status;
+	void *data[TEST_STRIPES_MAX], *md[TEST_STRIPES_MAX];
+	void *buf, *md_buf = NULL;
+	uint8_t idx, a, b;
+
+	write_stripes(data, md);
+
+	buf = malloc(raid_bdev->strip_size * blocklen);
+	SPDK_CU_ASSERT_FATAL(buf != NULL);
+	if (g_test.md_len) {
+		md_buf = malloc(raid_bdev->strip_size * g_test.md_len);
+		SPDK_CU_ASSERT_FATAL(md_buf != NULL);
+	}
+
+	/* first data chunk of stripe 0 is missing, a chunk used for reconstruction fails */
+	a = raid6_stripe_data_chunk_index(raid_bdev, 0, 0);
+	set_base_channel(a, false);
+	for (idx = 0; idx < raid_bdev->num_base_bdevs; idx++) {
+		if (idx == a) {
+			continue;
+		}
+		g_test.error.type = TEST_BDEV_ERROR_COMPLETE;
+		g_test.error.bdev = raid_bdev->base_bdev_info[idx].desc->bdev;
+
+		status = submit_rw_request(SPDK_BDEV_IO_TYPE_READ, 0, raid_bdev->strip_size, buf, md_buf);
+		if (idx == raid6_stripe_q_chunk_index(raid_bdev, 0)) {
+			/* Q is not needed to recover a single chunk */
+			CU_ASSERT(status == SPDK_BDEV_IO_STATUS_SUCCESS);
+			CU_ASSERT(memcmp(buf, data[0], raid_bdev->strip_size * blocklen) == 0);
+		} else {
+			CU_ASSERT(status == SPDK_BDEV_IO_STATUS_FAILED);
+		}
+	}
+	g_test.error.type = TEST_BDEV_ERROR_NONE;
+	g_test.error.bdev = NULL;
+
+	/* more than two missing chunks */
+	b = raid6_stripe_data_chunk_index(raid_bdev, 0, 1);
+	set_base_channel(b, false);
+	set_base_channel(raid6_stripe_p_chunk_index(raid_bdev, 0), false);
+	status = submit_rw_request(SPDK_BDEV_IO_TYPE_READ, 0, raid_bdev->strip_size, buf, md_buf);
+	CU_ASSERT(status == SPDK_BDEV_IO_STATUS_FAILED);
+
+	free(buf);
+	free(md_buf);
+	free_stripes(data, md);
+}
+static void
+test_raid6_chunk_read_error_degraded(void)
+{
+	run_for_each_raid6_config(__test_raid6_chunk_read_error_degraded);
+}
+
+static void
+rebuild_and_verify(uint8_t target_idx, void **data, void **md)
+{
+	struct raid6_info *r6_info = g_test.r6_info;
+	struct raid_bdev *raid_bdev = g_test.raid_bdev;
+	struct raid_bdev_process_request *process_req;
+	uint64_t stripe_index;
+	int ret;
+
+	process_req = calloc(1, sizeof(*process_req));
+	SPDK_CU_ASSERT_FATAL(process_req != NULL);
+
+	process_req->iov.iov_base = malloc(raid_bdev->strip_size * raid_bdev->bdev.blocklen);
+	SPDK_CU_ASSERT_FATAL(process_req->iov.iov_base != NULL);
+	if (g_test.md_len) {
+		process_req->md_buf = malloc(raid_bdev->strip_size * g_test.md_len);
+		SPDK_CU_ASSERT_FATAL(process_req->md_buf != NULL);
+	}
+	process_req->target = &raid_bdev->base_bdev_info[target_idx];
+	process_req->target_ch = (void *)1;
+
+	memset(g_test.disks[target_idx].buf, 0xab, g_test.disk_blocks * raid_bdev->bdev.blocklen);
+	if (g_test.md_len) {
+		memset(g_test.disks[target_idx].md_buf, 0xab, g_test.disk_blocks * g_test.md_len);
+	}
+
+	for (stripe_index = 0; stripe_index < g_test.num_stripes; stripe_index++) {
+		process_req->offset_blocks = stripe_index * r6_info->stripe_blocks;
+		process_req->num_blocks = r6_info->stripe_blocks;
+		g_process_done = false;
+		g_process_status = -1;
+
+		ret = raid6_submit_process_request(process_req, g_test.raid_ch);
+		CU_ASSERT(ret == (int)r6_info->stripe_blocks);
+
+		process_io_completions();
+
+		CU_ASSERT(g_process_done);
+		CU_ASSERT(g_process_status == 0);
+
+		verify_stripe_on_disks(stripe_index, data[stripe_index], md[stripe_index], UINT8_MAX);
+	}
+
+	free(process_req->iov.iov_base);
+	free(process_req->md_buf);
+	free(process_req);
+}
+
+static void
+__test_raid6_submit_process_request(void)
+{
+	struct raid_bdev *raid_bdev = g_test.raid_bdev;
+	void *data[TEST_STRIPES_MAX], *md[TEST_STRIPES_MAX];
+	uint8_t a, b;
+
+	write_stripes(data, md);
+
+	for (a = 0; a < raid_bdev->num_base_bdevs; a++) {
+		/* rebuild with a single missing base bdev */
+		set_base_channel(a, false);
+		rebuild_and_verify(a, data, md);
+
+		/* rebuild one of two missing base bdevs */
+		b = (a + 2) % raid_bdev->num_base_bdevs;
+		set_base_channel(b, false);
+		rebuild_and_verify(a, data, md);
+		set_base_channel(b, true);
+
+		set_base_channel(a, true);
+	}
+
+	free_stripes(data, md);
+}
+static void
+test_raid6_submit_process_request(void)
+{
+	run_for_each_raid6_config(__test_raid6_submit_process_request);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite suite = NULL;
+	unsigned int num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("raid6", test_suite_init, test_suite_cleanup);
+	CU_ADD_TEST(suite, test_raid6_start);
+	CU_ADD_TEST(suite, test_raid6_stripe_layout);
+	CU_ADD_TEST(suite, test_raid6_submit_full_stripe_write_request);
+	CU_ADD_TEST(suite, test_raid6_submit_read_request_degraded);
+	CU_ADD_TEST(suite, test_raid6_submit_full_stripe_write_request_degraded);
+	CU_ADD_TEST(suite, test_raid6_chunk_write_error);
+	CU_ADD_TEST(suite, test_raid6_chunk_read_error_degraded);
+	CU_ADD_TEST(suite, test_raid6_submit_process_request);
+
+	allocate_threads(1);
+	set_thread(0);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+	CU_cleanup_registry();
+
+	free_threads();
+
+	return num_failures;
+}
@@ -0,0 +1,713 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk_internal/cunit.h"
+#include "spdk/env.h"
+
+#include "common/lib/ut_multithread.c"
+
+#include "bdev/cache/vbdev_cache.c"
+
+#include "common/lib/bdev/ut_vbdev.c"
+
+#define LINE_SIZE	4096
+#define LINE_BLOCKS	(LINE_SIZE / BLOCK_SIZE)
+#define BASE_LINES	128
+#define BASE_BLOCKS	(BASE_LINES * LINE_BLOCKS)
+/* 4 sets of 8 lines, for both the DRAM and the cache bdev caches */
+#define CACHE_LINES	32
+#define CACHE_BLOCKS	(CACHE_LINES * LINE_BLOCKS)
+
+static struct ut_disk g_base;
+static struct ut_disk g_cache_disk;
+
+/* Helpers */
+
+static struct vbdev_cache *
+get_cache(const char *name)
+{
+	return ut_get_vbdev(name, &cache_if);
+}
+
+static struct vbdev_cache_assoc *
+get_assoc(const char *name)
+{
+	return vbdev_cache_assoc_find(&g_cache_assocs, name);
+}
+
+static void
+get_opts(struct bdev_cache_opts *opts, enum bdev_cache_mode mode, bool admission_filter)
+{
+	bdev_cache_get_default_opts(opts);
+	opts->cache_size = CACHE_LINES * LINE_SIZE;
+	opts->line_size = LINE_SIZE;
+	opts->mode = mode;
+	opts->admission_filter = admission_filter;
+}
+
+static struct vbdev_cache *
+create_cache(const char *cache_bdev_name, enum bdev_cache_mode mode, bool admission_filter)
+{
+	struct bdev_cache_opts opts;
+
+	get_opts(&opts, mode, admission_filter);
+	CU_ASSERT(bdev_cache_create_disk("base", cache_bdev_name, "cache0", &opts) == 0);
+
+	return get_cache("cache0");
+}
+
+static int
+delete_cache(const char *name)
+{
+	g_delete_done = false;
+	bdev_cache_delete_disk(name, delete_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_delete_done);
+
+	return g_delete_rc;
+}
+
+static void
+fill_line(void *buf, uint32_t pattern)
+{
+	uint32_t i;
+
+	for (i = 0; i < LINE_BLOCKS; i++) {
+		fill_block((uint8_t *)buf + i * BLOCK_SIZE, pattern * LINE_BLOCKS + i);
+	}
+}
+
+static enum spdk_bdev_io_status
+submit_io(struct vbdev_cache *cache, int thread, enum spdk_bdev_io_type type, uint64_t lba,
+	  uint64_t num_blocks, void *buf)
+{
+	return ut_submit_io(&cache->bdev, thread, type, lba, num_blocks, buf);
+}
+
+static void
+write_line(struct vbdev_cache *cache, uint64_t line, uint32_t pattern)
+{
+	uint8_t buf[LINE_SIZE];
+
+	fill_line(buf, pattern);
+	CU_ASSERT(submit_io(cache, 0, SPDK_BDEV_IO_TYPE_WRITE, line * LINE_BLOCKS, LINE_BLOCKS,
+			    buf) == SPDK_BDEV_IO_STATUS_SUCCESS);
+}
+
+/* Read blocks and compare them with the base bdev */
+static void
+check_blocks(struct vbdev_cache *cache, int thread, uint64_t lba, uint64_t num_blocks)
+{
+	uint8_t *buf;
+
+	buf = calloc(num_blocks, BLOCK_SIZE);
+	SPDK_CU_ASSERT_FATAL(buf != NULL);
+
+	CU_ASSERT(submit_io(cache, thread, SPDK_BDEV_IO_TYPE_READ, lba, num_blocks, buf) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf, g_base.data + lba * BLOCK_SIZE, num_blocks * BLOCK_SIZE) == 0);
+
+	free(buf);
+}
+
+/* Read lines and check whether they were all served from the cache */
+static void
+check_lines(struct vbdev_cache *cache, uint64_t line, uint64_t num_lines, bool hit)
+{
+	uint64_t base_reads = g_base.reads;
+
+	check_blocks(cache, 1, line * LINE_BLOCKS, num_lines * LINE_BLOCKS);
+	CU_ASSERT((g_base.reads == base_reads) == hit);
+}
+
+static struct bdev_cache_stats g_stats;
+static int g_stats_count;
+
+static void
+stats_cb(void *cb_arg, const char *name, const struct bdev_cache_stats *stats)
+{
+	CU_ASSERT(strcmp(name, "cache0") == 0);
+	g_stats = *stats;
+	g_stats_count++;
+}
+
+static struct bdev_cache_stats *
+get_stats(void)
+{
+	g_stats_count = 0;
+	CU_ASSERT(bdev_cache_get_stats("cache0", stats_cb, NULL) == 0);
+	CU_ASSERT(g_stats_count == 1);
+
+	return &g_stats;
+}
+
+static void
+check_cache(struct vbdev_cache *cache)
+{
+	struct cache_set *set;
+	uint64_t i, used = 0;
+	uint32_t way;
+
+	for (i = 0; i < cache->num_sets; i++) {
+		set = &cache->sets[i];
+		for (way = 0; way < CACHE_WAYS; way++) {
+			CU_ASSERT((set->slots[way].seq & 1) == 0);
+			if (set->slots[way].tag != 0) {
+				CU_ASSERT(cache_get_set(cache, set->slots[way].tag - 1) == set);
+				used++;
+			}
+		}
+	}
+
+	CU_ASSERT(cache->used_lines == used);
+	CU_ASSERT(TAILQ_EMPTY(&g_held_ios));
+}
+
+static void
+test_setup(void)
+{
+	uint64_t i;
+
+	for (i = 0; i < BASE_LINES; i++) {
+		fill_line(g_base.data + i * LINE_SIZE, i + 1);
+	}
+	memset(g_cache_disk.data, 0, CACHE_BLOCKS * BLOCK_SIZE);
+	ut_disk_reset(&g_base);
+	ut_disk_reset(&g_cache_disk);
+}
+
+/* Tests */
+
+static void
+test_cache_create(void)
+{
+	struct vbdev_cache *cache;
+	struct bdev_cache_opts opts;
+
+	test_setup();
+
+	/* DRAM cache */
+	cache = create_cache(NULL, BDEV_CACHE_MODE_WRITE_THROUGH, true);
+	SPDK_CU_ASSERT_FATAL(cache != NULL);
+	CU_ASSERT(cache->bdev.blockcnt == BASE_BLOCKS);
+	CU_ASSERT(cache->bdev.blocklen == BLOCK_SIZE);
+	CU_ASSERT(cache->num_sets == CACHE_LINES / CACHE_WAYS);
+	CU_ASSERT(cache->num_lines == CACHE_LINES);
+	CU_ASSERT(cache->line_blocks == LINE_BLOCKS);
+	CU_ASSERT(cache->data != NULL);
+	CU_ASSERT(cache->sketch != NULL);
+	CU_ASSERT(cache->cache_bdev == NULL);
+	CU_ASSERT(g_base.claimed);
+
+	/* The name and the base bdev are in use */
+	get_opts(&opts, BDEV_CACHE_MODE_WRITE_THROUGH, true);
+	CU_ASSERT(bdev_cache_create_disk("base", NULL, "cache0", &opts) == -EEXIST);
+	CU_ASSERT(bdev_cache_create_disk("base", NULL, "cache1", &opts) == -EPERM);
+	CU_ASSERT(get_assoc("cache1") == NULL);
+
+	CU_ASSERT(delete_cache("cache0") == 0);
+	CU_ASSERT(get_cache("cache0") == NULL);
+	CU_ASSERT(get_assoc("cache0") == NULL);
+	CU_ASSERT(!g_base.claimed);
+	CU_ASSERT(delete_cache("cache0") == -ENODEV);
+
+	/* Cache bdev, whose size limits the cache */
+	get_opts(&opts, BDEV_CACHE_MODE_WRITE_AROUND, false);
+	opts.cache_size = 0;
+	CU_ASSERT(bdev_cache_create_disk("base", "cache_disk", "cache0", &opts) == 0);
+	cache = get_cache("cache0");
+	SPDK_CU_ASSERT_FATAL(cache != NULL);
+	CU_ASSERT(cache->num_lines == CACHE_LINES);
+	CU_ASSERT(cache->data == NULL);
+	CU_ASSERT(cache->sketch == NULL);
+	CU_ASSERT(cache->cache_bdev == &g_cache_disk.bdev);
+	CU_ASSERT(g_base.claimed);
+	CU_ASSERT(g_cache_disk.claimed);
+	CU_ASSERT(delete_cache("cache0") == 0);
+	CU_ASSERT(!g_base.claimed);
+	CU_ASSERT(!g_cache_disk.claimed);
+
+	/* Invalid options */
+	get_opts(&opts, BDEV_CACHE_MODE_WRITE_THROUGH, true);
+	opts.line_size = 3 * BLOCK_SIZE;
+	CU_ASSERT(bdev_cache_create_disk("base", NULL, "cache0", &opts) == -EINVAL);
+	opts.line_size = 256;
+	CU_ASSERT(bdev_cache_create_disk("base", NULL, "cache0", &opts) == -EINVAL);
+	opts.line_size = 2 * CACHE_MAX_LINE_SIZE;
+	CU_ASSERT(bdev_cache_create_disk("base", NULL, "cache0", &opts) == -EINVAL);
+	opts.line_size = LINE_SIZE;
+	opts.mode = 2;
+	CU_ASSERT(bdev_cache_create_disk("base", NULL, "cache0", &opts) == -EINVAL);
+	opts.mode = BDEV_CACHE_MODE_WRITE_THROUGH;
+	CU_ASSERT(bdev_cache_create_disk("base", "base", "cache0", &opts) == -EINVAL);
+
+	/* Less than a set of lines */
+	opts.cache_size = (CACHE_WAYS - 1) * LINE_SIZE;
+	CU_ASSERT(bdev_cache_create_disk("base", NULL, "cache0", &opts) == -EINVAL);
+	opts.cache_size = CACHE_LINES * LINE_SIZE;
+
+	/* Cache bdev with another block size */
+	g_cache_disk.bdev.blocklen = 2 * BLOCK_SIZE;
+	CU_ASSERT(bdev_cache_create_disk("base", "cache_disk", "cache0", &opts) == -EINVAL);
+	g_cache_disk.bdev.blocklen = BLOCK_SIZE;
+	CU_ASSERT(!g_base.claimed);
+	CU_ASSERT(!g_cache_disk.claimed);
+	CU_ASSERT(TAILQ_EMPTY(&g_cache_assocs));
+
+	/* Creation waits for the cache bdev */
+	g_cache_disk.present = false;
+	CU_ASSERT(bdev_cache_create_disk("base", "cache_disk", "cache0", &opts) == 0);
+	CU_ASSERT(get_cache("cache0") == NULL);
+	CU_ASSERT(get_assoc("cache0") != NULL);
+	CU_ASSERT(!g_base.claimed);
+
+	g_cache_disk.present = true;
+	ut_examine_disk(&cache_if, &g_cache_disk);
+	cache = get_cache("cache0");
+	SPDK_CU_ASSERT_FATAL(cache != NULL);
+	CU_ASSERT(cache->cache_bdev == &g_cache_disk.bdev);
+	CU_ASSERT(delete_cache("cache0") == 0);
+	CU_ASSERT(get_assoc("cache0") == NULL);
+
+	/* A pending cache bdev can be deleted */
+	g_cache_disk.present = false;
+	CU_ASSERT(bdev_cache_create_disk("base", "cache_disk", "cache0", &opts) == 0);
+	CU_ASSERT(delete_cache("cache0") == 0);
+	CU_ASSERT(get_assoc("cache0") == NULL);
+	g_cache_disk.present = true;
+}
+
+static void
+test_cache_read(void)
+{
+	struct vbdev_cache *cache;
+	struct bdev_cache_stats *stats;
+	uint64_t base_reads;
+
+	test_setup();
+
+	cache = create_cache(NULL, BDEV_CACHE_MODE_WRITE_THROUGH, false);
+	SPDK_CU_ASSERT_FATAL(cache != NULL);
+
+	/* A missed line is filled and then served from the cache, on any thread */
+	check_lines(cache, 3, 1, false);
+	check_lines(cache, 3, 1, true);
+	set_thread(1);
+	check_lines(cache, 3, 1, true);
+	set_thread(0);
+
+	/* Reads hit only if all of their lines are cached */
+	check_lines(cache, 3, 2, false);
+	check_lines(cache, 3, 2, true);
+
+	/* Unaligned reads are served from the cached lines */
+	base_reads = g_base.reads;
+	check_blocks(cache, 0, 3 * LINE_BLOCKS + 2, LINE_BLOCKS + 3);
+	check_blocks(cache, 1, 4 * LINE_BLOCKS + 7, 1);
+	CU_ASSERT(g_base.reads == base_reads);
+
+	/* Partially read lines are not filled */
+	check_blocks(cache, 0, 10 * LINE_BLOCKS + 1, 3);
+	check_lines(cache, 10, 1, false);
+	base_reads = g_base.reads;
+	check_blocks(cache, 0, 10 * LINE_BLOCKS + 1, 3);
+	CU_ASSERT(g_base.reads == base_reads);
+
+	/* Large reads bypass the cache */
+	check_lines(cache, 40, CACHE_MAX_IO_LINES + 1, false);
+	check_lines(cache, 40, 1, false);
+	check_lines(cache, 41, 1, false);
+
+	/* Base bdev out of resources */
+	g_base.enomem_count = 1;
+	check_lines(cache, 50, 1, false);
+	CU_ASSERT(g_base.enomem_count == 0);
+	check_lines(cache, 50, 1, true);
+
+	/* Flush and reset are passed through */
+	CU_ASSERT(submit_io(cache, 0, SPDK_BDEV_IO_TYPE_FLUSH, 0, BASE_BLOCKS, NULL) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(submit_io(cache, 1, SPDK_BDEV_IO_TYPE_RESET, 0, 0, NULL) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	check_lines(cache, 3, 2, true);
+
+	stats = get_stats();
+	CU_ASSERT(stats->capacity_lines == CACHE_LINES);
+	CU_ASSERT(stats->cached_lines == 6);
+	CU_ASSERT(stats->read_hits == 8);
+	CU_ASSERT(stats->read_misses == 7);
+	CU_ASSERT(stats->read_bypassed == 1);
+	CU_ASSERT(stats->lines_admitted == 6);
+	CU_ASSERT(stats->lines_evicted == 0);
+	CU_ASSERT(stats->lines_rejected == 0);
+	CU_ASSERT(cache->used_lines == 6);
+	check_cache(cache);
+
+	CU_ASSERT(delete_cache("cache0") == 0);
+}
+
+static void
+test_cache_write(void)
+{
+	struct vbdev_cache *cache;
+	struct bdev_cache_stats *stats;
+	uint8_t buf[2 * BLOCK_SIZE];
+	uint64_t i;
+
+	test_setup();
+
+	cache = create_cache(NULL, BDEV_CACHE_MODE_WRITE_THROUGH, false);
+	SPDK_CU_ASSERT_FATAL(cache != NULL);
+
+	/* Written lines are updated in the cache, or inserted into it */
+	check_lines(cache, 5, 1, false);
+	write_line(cache, 5, 1000);
+	write_line(cache, 6, 1001);
+	check_lines(cache, 5, 2, true);
+
+	/* Partial writes, unmaps and write zeroes drop the lines */
+	fill_block(buf, 2000);
+	fill_block(buf + BLOCK_SIZE, 2001);
+	CU_ASSERT(submit_io(cache, 0, SPDK_BDEV_IO_TYPE_WRITE, 5 * LINE_BLOCKS + 3, 2, buf) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	check_lines(cache, 5, 1, false);
+	check_lines(cache, 5, 1, true);
+	CU_ASSERT(submit_io(cache, 1, SPDK_BDEV_IO_TYPE_UNMAP, 5 * LINE_BLOCKS + 7, 2, NULL) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	check_lines(cache, 5, 1, false);
+	check_lines(cache, 6, 1, false);
+	CU_ASSERT(submit_io(cache, 0, SPDK_BDEV_IO_TYPE_WRITE_ZEROES, 6 * LINE_BLOCKS,
+			    LINE_BLOCKS, NULL) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	check_lines(cache, 6, 1, false);
+	CU_ASSERT(spdk_mem_all_zero(g_base.data + 6 * LINE_SIZE, LINE_SIZE));
+
+	/* Writes covering more lines than there are sets go through the whole cache */
+	for (i = 0; i < 4; i++) {
+		check_lines(cache, i, 1, false);
+	}
+	CU_ASSERT(submit_io(cache, 1, SPDK_BDEV_IO_TYPE_UNMAP, 0, 20 * LINE_BLOCKS, NULL) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	check_lines(cache, 0, 4, false);
+	check_lines(cache, 0, 4, true);
+
+	stats = get_stats();
+	CU_ASSERT(stats->writes == 3);
+	CU_ASSERT(stats->lines_invalidated == 11);
+	check_cache(cache);
+
+	CU_ASSERT(delete_cache("cache0") == 0);
+
+	/* In write-around mode, written lines are only dropped */
+	cache = create_cache(NULL, BDEV_CACHE_MODE_WRITE_AROUND, false);
+	SPDK_CU_ASSERT_FATAL(cache != NULL);
+
+	check_lines(cache, 5, 1, false);
+	write_line(cache, 5, 1002);
+	write_line(cache, 6, 1003);
+	check_lines(cache, 5, 1, false);
+	check_lines(cache, 6, 1, false);
+	check_lines(cache, 5, 2, true);
+
+	stats = get_stats();
+	CU_ASSERT(stats->lines_invalidated == 1);
+	CU_ASSERT(stats->cached_lines == 2);
+	check_cache(cache);
+
+	CU_ASSERT(delete_cache("cache0") == 0);
+}
+
+static void
+test_cache_base_io(void)
+{
+	struct vbdev_cache *cache;
+	uint8_t buf[LINE_SIZE];
+
+	test_setup();
+
+	cache = create_cache(NULL, BDEV_CACHE_MODE_WRITE_THROUGH, false);
+	SPDK_CU_ASSERT_FATAL(cache != NULL);
+
+	/* Writes, unmaps and flushes are retried once the base bdev has resources again */
+	check_lines(cache, 5, 2, false);
+	g_base.enomem_count = 1;
+	write_line(cache, 5, 3000);
+	CU_ASSERT(g_base.enomem_count == 0);
+	check_lines(cache, 5, 1, true);
+	g_base.enomem_count = 1;
+	CU_ASSERT(submit_io(cache, 1, SPDK_BDEV_IO_TYPE_UNMAP, 6 * LINE_BLOCKS, LINE_BLOCKS,
+			    NULL) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(g_base.enomem_count == 0);
+	CU_ASSERT(spdk_mem_all_zero(g_base.data + 6 * LINE_SIZE, LINE_SIZE));
+	check_lines(cache, 6, 1, false);
+	g_base.enomem_count = 2;
+	CU_ASSERT(submit_io(cache, 0, SPDK_BDEV_IO_TYPE_FLUSH, 0, BASE_BLOCKS, NULL) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(g_base.enomem_count == 0);
+
+	/* A failed write drops the line instead of caching what was not written */
+	g_base.fail_write_lba = 5 * LINE_BLOCKS + 1;
+	fill_line(buf, 3001);
+	CU_ASSERT(submit_io(cache, 0, SPDK_BDEV_IO_TYPE_WRITE, 5 * LINE_BLOCKS, LINE_BLOCKS,
+			    buf) == SPDK_BDEV_IO_STATUS_FAILED);
+	g_base.fail_write_lba = UINT64_MAX;
+	check_lines(cache, 5, 1, false);
+	check_lines(cache, 5, 1, true);
+	check_cache(cache);
+
+	CU_ASSERT(delete_cache("cache0") == 0);
+}
+
+static void
+test_cache_admission(void)
+{
+	struct vbdev_cache *cache;
+	struct bdev_cache_opts opts;
+	struct bdev_cache_stats *stats;
+	uint64_t i;
+
+	test_setup();
+
+	/* A single set, so that all lines compete for the same slots */
+	get_opts(&opts, BDEV_CACHE_MODE_WRITE_THROUGH, true);
+	opts.cache_size = CACHE_WAYS * LINE_SIZE;
+	CU_ASSERT(bdev_cache_create_disk("base", NULL, "cache0", &opts) == 0);
+	cache = get_cache("cache0");
+	SPDK_CU_ASSERT_FATAL(cache != NULL);
+	CU_ASSERT(cache->num_sets == 1);
+
+	/* Free slots take any line */
+	for (i = 0; i < CACHE_WAYS; i++) {
+		check_lines(cache, i, 1, false);
+		check_lines(cache, i, 1, true);
+	}
+
+	/* A line read less often than the cached ones is turned down until it is read more */
+	check_lines(cache, 100, 1, false);
+	check_lines(cache, 100, 1, false);
+	stats = get_stats();
+	CU_ASSERT(stats->lines_rejected == 2);
+	CU_ASSERT(stats->lines_evicted == 0);
+	check_lines(cache, 100, 1, false);
+	check_lines(cache, 100, 1, true);
+	stats = get_stats();
+	CU_ASSERT(stats->lines_rejected == 2);
+	CU_ASSERT(stats->lines_evicted == 1);
+	CU_ASSERT(stats->lines_admitted == CACHE_WAYS + 1);
+	CU_ASSERT(stats->cached_lines == CACHE_WAYS);
+
+	/* Aging halves the estimates */
+	CU_ASSERT(cache_sketch_estimate(cache, 100) == 4);
+	cache_sketch_age(cache);
+	CU_ASSERT(cache_sketch_estimate(cache, 100) == 2);
+	CU_ASSERT(cache_sketch_estimate(cache, 101) == 0);
+
+	/* Writes store lines only if the filter lets them in */
+	write_line(cache, 101, 3000);
+	check_lines(cache, 101, 1, false);
+	check_cache(cache);
+
+	CU_ASSERT(delete_cache("cache0") == 0);
+
+	/* Without filter, lines replace each other in turn */
+	opts.admission_filter = false;
+	CU_ASSERT(bdev_cache_create_disk("base", NULL, "cache0", &opts) == 0);
+	cache = get_cache("cache0");
+	SPDK_CU_ASSERT_FATAL(cache != NULL);
+
+	for (i = 0; i < CACHE_WAYS; i++) {
+		check_lines(cache, i, 1, false);
+		check_lines(cache, i, 1, true);
+	}
+	check_lines(cache, 100, 1, false);
+	check_lines(cache, 100, 1, true);
+	check_lines(cache, 0, 1, false);
+	check_lines(cache, 2, 1, true);
+
+	stats = get_stats();
+	CU_ASSERT(stats->lines_rejected == 0);
+	CU_ASSERT(stats->lines_evicted == 2);
+	check_cache(cache);
+
+	CU_ASSERT(delete_cache("cache0") == 0);
+}
+
+static void
+test_cache_bdev(void)
+{
+	struct vbdev_cache *cache;
+	struct bdev_cache_stats *stats;
+	struct spdk_bdev_io *read_io, *write_io;
+	uint8_t buf[LINE_SIZE], ref[LINE_SIZE], old[LINE_SIZE];
+
+	test_setup();
+
+	cache = create_cache("cache_disk", BDEV_CACHE_MODE_WRITE_THROUGH, false);
+	SPDK_CU_ASSERT_FATAL(cache != NULL);
+
+	/* Missed lines are written to the cache bdev and then read from it */
+	check_lines(cache, 2, 2, false);
+	CU_ASSERT(g_cache_disk.writes == 2);
+	check_lines(cache, 2, 2, true);
+	CU_ASSERT(g_cache_disk.reads == 2);
+	check_blocks(cache, 0, 2 * LINE_BLOCKS + 3, 2);
+	CU_ASSERT(g_cache_disk.reads == 3);
+
+	/* Written lines are updated on the cache bdev */
+	write_line(cache, 2, 1000);
+	CU_ASSERT(g_cache_disk.writes == 3);
+	check_lines(cache, 2, 1, true);
+
+	/* A line dropped while it is being written to the cache bdev is not published */
+	g_cache_disk.hold = true;
+	read_io = ut_start_io(&cache->bdev, 0, SPDK_BDEV_IO_TYPE_READ, 11 * LINE_BLOCKS, LINE_BLOCKS,
+			      buf);
+	poll_threads();
+	CU_ASSERT(read_io->internal.status == SPDK_BDEV_IO_STATUS_PENDING);
+	CU_ASSERT(cache->used_lines == 3);
+	fill_line(ref, 1001);
+	write_io = ut_start_io(&cache->bdev, 1, SPDK_BDEV_IO_TYPE_WRITE, 11 * LINE_BLOCKS,
+			       LINE_BLOCKS, ref);
+	poll_threads();
+	CU_ASSERT(write_io->internal.status == SPDK_BDEV_IO_STATUS_PENDING);
+	CU_ASSERT(cache->used_lines == 4);
+	g_cache_disk.hold = false;
+	ut_release_ios();
+	CU_ASSERT(ut_finish_io(read_io) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(ut_finish_io(write_io) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(cache->used_lines == 3);
+	check_lines(cache, 11, 1, true);
+	check_cache(cache);
+
+	CU_ASSERT(delete_cache("cache0") == 0);
+
+	cache = create_cache("cache_disk", BDEV_CACHE_MODE_WRITE_AROUND, false);
+	SPDK_CU_ASSERT_FATAL(cache != NULL);
+
+	/* A base read that completes after a write to its line does not fill it */
+	memcpy(old, g_base.data + 7 * LINE_SIZE, LINE_SIZE);
+	g_base.hold = true;
+	read_io = ut_start_io(&cache->bdev, 0, SPDK_BDEV_IO_TYPE_READ, 7 * LINE_BLOCKS, LINE_BLOCKS,
+			      buf);
+	g_base.hold = false;
+	write_line(cache, 7, 1002);
+	ut_release_ios();
+	CU_ASSERT(ut_finish_io(read_io) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf, old, LINE_SIZE) == 0);
+	CU_ASSERT(cache->used_lines == 0);
+	check_lines(cache, 7, 1, false);
+	check_lines(cache, 7, 1, true);
+
+	/* A line replaced while it is read from the cache bdev is read again from the base */
+	g_cache_disk.hold = true;
+	read_io = ut_start_io(&cache->bdev, 0, SPDK_BDEV_IO_TYPE_READ, 7 * LINE_BLOCKS, LINE_BLOCKS,
+			      buf);
+	g_cache_disk.hold = false;
+	write_line(cache, 7, 1003);
+	ut_release_ios();
+	CU_ASSERT(ut_finish_io(read_io) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf, g_base.data + 7 * LINE_SIZE, LINE_SIZE) == 0);
+	check_lines(cache, 7, 1, true);
+
+	stats = get_stats();
+	CU_ASSERT(stats->read_hits == 2);
+	CU_ASSERT(stats->read_misses == 3);
+	CU_ASSERT(stats->lines_invalidated == 1);
+	CU_ASSERT(stats->cached_lines == 1);
+	check_cache(cache);
+
+	CU_ASSERT(delete_cache("cache0") == 0);
+}
+
+static void
+test_cache_stats(void)
+{
+	struct vbdev_cache *cache;
+	struct bdev_cache_stats *stats;
+
+	test_setup();
+
+	g_stats_count = 0;
+	CU_ASSERT(bdev_cache_get_stats(NULL, stats_cb, NULL) == 0);
+	CU_ASSERT(g_stats_count == 0);
+	CU_ASSERT(bdev_cache_get_stats("cache0", stats_cb, NULL) == -ENODEV);
+
+	cache = create_cache(NULL, BDEV_CACHE_MODE_WRITE_THROUGH, true);
+	SPDK_CU_ASSERT_FATAL(cache != NULL);
+
+	check_lines(cache, 1, 1, false);
+	check_lines(cache, 1, 1, true);
+	write_line(cache, 2, 1000);
+
+	/* Counters of all channels, including released ones */
+	stats = get_stats();
+	CU_ASSERT(stats->capacity_lines == CACHE_LINES);
+	CU_ASSERT(stats->cached_lines == 2);
+	CU_ASSERT(stats->read_hits == 1);
+	CU_ASSERT(stats->read_misses == 1);
+	CU_ASSERT(stats->writes == 1);
+	CU_ASSERT(stats->lines_admitted == 2);
+	CU_ASSERT(stats->lines_rejected == 0);
+
+	g_stats_count = 0;
+	CU_ASSERT(bdev_cache_get_stats(NULL, stats_cb, NULL) == 0);
+	CU_ASSERT(g_stats_count == 1);
+	CU_ASSERT(bdev_cache_get_stats("cache1", stats_cb, NULL) == -ENODEV);
+
+	CU_ASSERT(delete_cache("cache0") == 0);
+}
+
+static int
+test_suite_init(void)
+{
+	allocate_threads(2);
+	set_thread(0);
+
+	if (ut_disk_init(&g_base, "base", BASE_BLOCKS) != 0) {
+		return -ENOMEM;
+	}
+	if (ut_disk_init(&g_cache_disk, "cache_disk", CACHE_BLOCKS) != 0) {
+		ut_disk_fini(&g_base);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static int
+test_suite_fini(void)
+{
+	ut_disk_fini(&g_cache_disk);
+	ut_disk_fini(&g_base);
+	poll_threads();
+	free_threads();
+
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("cache", test_suite_init, test_suite_fini);
+
+	CU_ADD_TEST(suite, test_cache_create);
+	CU_ADD_TEST(suite, test_cache_read);
+	CU_ADD_TEST(suite, test_cache_write);
+	CU_ADD_TEST(suite, test_cache_base_io);
+	CU_ADD_TEST(suite, test_cache_admission);
+	CU_ADD_TEST(suite, test_cache_bdev);
+	CU_ADD_TEST(suite, test_cache_stats);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+
+	CU_cleanup_registry();
+
+	return num_failures;
+}
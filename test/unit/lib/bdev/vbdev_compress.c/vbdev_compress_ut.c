@@ -0,0 +1,813 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk_internal/cunit.h"
+#include "spdk/env.h"
+
+#include "common/lib/ut_multithread.c"
+
+#include "bdev/map.c"
+#include "bdev/compress/vbdev_compress.c"
+
+#include "common/lib/bdev/ut_vbdev.c"
+
+#define CHUNK_SIZE	4096
+#define CHUNK_BLOCKS	(CHUNK_SIZE / BLOCK_SIZE)
+#define BASE_BLOCKS	512
+#define ENTRIES		(BLOCK_SIZE / sizeof(struct compress_map_entry))
+/* Superblock, 2 map blocks for 63 chunks, 509 data blocks */
+#define NUM_CHUNKS	63
+#define MAP_BLOCKS	2
+#define DATA_BLOCKS	(BASE_BLOCKS - 1 - MAP_BLOCKS)
+
+static struct ut_disk g_base;
+static int g_accel_io_device;
+
+/* Accel compression. Trailing zeroes are dropped on compress and restored on decompress,
+ * which is enough to get both compressible and incompressible chunks.
+ */
+
+struct accel_op {
+	spdk_accel_completion_cb	cb_fn;
+	void				*cb_arg;
+	int				status;
+};
+
+static void
+accel_op_complete(void *ctx)
+{
+	struct accel_op *op = ctx;
+
+	op->cb_fn(op->cb_arg, op->status);
+	free(op);
+}
+
+static void
+accel_op_submit(int status, spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	struct accel_op *op;
+
+	op = calloc(1, sizeof(*op));
+	SPDK_CU_ASSERT_FATAL(op != NULL);
+	op->cb_fn = cb_fn;
+	op->cb_arg = cb_arg;
+	op->status = status;
+
+	spdk_thread_send_msg(spdk_get_thread(), accel_op_complete, op);
+}
+
+struct spdk_io_channel *
+spdk_accel_get_io_channel(void)
+{
+	return spdk_get_io_channel(&g_accel_io_device);
+}
+
+int
+spdk_accel_get_compress_level_range(enum spdk_accel_comp_algo comp_algo, uint32_t *min_level,
+				    uint32_t *max_level)
+{
+	switch (comp_algo) {
+	case SPDK_ACCEL_COMP_ALGO_DEFLATE:
+		*min_level = 0;
+		*max_level = 3;
+		return 0;
+	case SPDK_ACCEL_COMP_ALGO_LZ4:
+		*min_level = 1;
+		*max_level = 65537;
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
+int
+spdk_accel_submit_compress_ext(struct spdk_io_channel *ch, void *dst, uint64_t nbytes,
+			       struct iovec *src_iovs, size_t src_iovcnt,
+			       enum spdk_accel_comp_algo algo, uint32_t level,
+			       uint32_t *output_size, spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	uint8_t data[CHUNK_SIZE];
+	struct iovec iov = { .iov_base = data, .iov_len = sizeof(data) };
+	size_t len;
+
+	CU_ASSERT(spdk_iovcpy(src_iovs, src_iovcnt, &iov, 1) == CHUNK_SIZE);
+
+	for (len = CHUNK_SIZE; len > 0 && data[len - 1] == 0; len--) {
+	}
+
+	if (len > nbytes) {
+		accel_op_submit(-ENOMEM, cb_fn, cb_arg);
+		return 0;
+	}
+
+	memcpy(dst, data, len);
+	*output_size = len;
+	accel_op_submit(0, cb_fn, cb_arg);
+
+	return 0;
+}
+
+int
+spdk_accel_submit_decompress_ext(struct spdk_io_channel *ch, struct iovec *dst_iovs,
+				 size_t dst_iovcnt, struct iovec *src_iovs, size_t src_iovcnt,
+				 enum spdk_accel_comp_algo algo, uint32_t *output_size,
+				 spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	uint8_t data[CHUNK_SIZE] = {};
+	struct iovec iov = { .iov_base = data, .iov_len = sizeof(data) };
+	size_t len = 0, i;
+
+	for (i = 0; i < src_iovcnt; i++) {
+		len += src_iovs[i].iov_len;
+	}
+	SPDK_CU_ASSERT_FATAL(len <= CHUNK_SIZE);
+	spdk_copy_iovs_to_buf(data, len, src_iovs, src_iovcnt);
+
+	*output_size = spdk_iovcpy(&iov, 1, dst_iovs, dst_iovcnt);
+	accel_op_submit(0, cb_fn, cb_arg);
+
+	return 0;
+}
+
+/* Helpers */
+
+static struct vbdev_compress *
+get_compress(const char *name)
+{
+	return ut_get_vbdev(name, &compress_if);
+}
+
+static int
+create_compress_opts(const struct bdev_compress_opts *opts)
+{
+	g_create_done = false;
+	bdev_compress_create_disk("base", "comp0", opts, create_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_create_done);
+
+	return g_create_rc;
+}
+
+static struct vbdev_compress *
+create_compress(uint64_t num_blocks)
+{
+	struct bdev_compress_opts opts;
+
+	bdev_compress_get_default_opts(&opts);
+	opts.num_blocks = num_blocks;
+	opts.chunk_size = CHUNK_SIZE;
+
+	CU_ASSERT(create_compress_opts(&opts) == 0);
+
+	return get_compress("comp0");
+}
+
+static void
+delete_compress(void)
+{
+	g_delete_done = false;
+	bdev_compress_delete_disk("comp0", delete_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_delete_done);
+	CU_ASSERT(g_delete_rc == 0);
+	CU_ASSERT(!g_base.claimed);
+}
+
+static struct vbdev_compress *
+examine_base(void)
+{
+	ut_examine_disk(&compress_if, &g_base);
+
+	return get_compress("comp0");
+}
+
+/* Chunk with data in its first half if compressible, in all of it otherwise */
+static void
+fill_chunk(void *buf, uint32_t pattern, bool compressible)
+{
+	uint32_t i;
+
+	memset(buf, 0, CHUNK_SIZE);
+	for (i = 0; i < (compressible ? CHUNK_BLOCKS / 2 : CHUNK_BLOCKS); i++) {
+		fill_block((uint8_t *)buf + i * BLOCK_SIZE, pattern * CHUNK_BLOCKS + i);
+	}
+}
+
+static enum spdk_bdev_io_status
+submit_io(struct vbdev_compress *comp, int thread, enum spdk_bdev_io_type type, uint64_t lba,
+	  uint64_t num_blocks, void *buf)
+{
+	return ut_submit_io(&comp->bdev, thread, type, lba, num_blocks, buf);
+}
+
+static enum spdk_bdev_io_status
+write_chunk_status(struct vbdev_compress *comp, uint64_t chunk, uint32_t pattern,
+		   bool compressible)
+{
+	uint8_t buf[CHUNK_SIZE];
+
+	fill_chunk(buf, pattern, compressible);
+
+	return submit_io(comp, 0, SPDK_BDEV_IO_TYPE_WRITE, chunk * CHUNK_BLOCKS, CHUNK_BLOCKS, buf);
+}
+
+static void
+write_chunk(struct vbdev_compress *comp, uint64_t chunk, uint32_t pattern, bool compressible)
+{
+	CU_ASSERT(write_chunk_status(comp, chunk, pattern, compressible) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+}
+
+static void
+check_chunk(struct vbdev_compress *comp, uint64_t chunk, uint32_t pattern, bool compressible)
+{
+	uint8_t buf[CHUNK_SIZE], ref[CHUNK_SIZE];
+
+	if (pattern == 0) {
+		memset(ref, 0, sizeof(ref));
+	} else {
+		fill_chunk(ref, pattern, compressible);
+	}
+
+	CU_ASSERT(submit_io(comp, 1, SPDK_BDEV_IO_TYPE_READ, chunk * CHUNK_BLOCKS, CHUNK_BLOCKS,
+			    buf) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf, ref, CHUNK_SIZE) == 0);
+}
+
+/* Compare in-memory state with what is derived from the map */
+static void
+check_map(struct vbdev_compress *comp)
+{
+	struct compress_map_entry *entry;
+	uint64_t chunk, used = 0, mapped = 0;
+	uint32_t i;
+
+	for (chunk = 0; chunk < comp->num_chunks; chunk++) {
+		entry = &comp->map[chunk];
+		CU_ASSERT(comp->locks[chunk] == 0);
+		if (entry->len == 0) {
+			continue;
+		}
+
+		CU_ASSERT(entry->len <= CHUNK_SIZE);
+		for (i = 0; i < compress_entry_blocks(comp, entry); i++) {
+			CU_ASSERT(spdk_bit_pool_is_allocated(comp->pool, entry->offset + i));
+		}
+		used += compress_entry_blocks(comp, entry);
+		mapped += CHUNK_BLOCKS;
+	}
+
+	CU_ASSERT(comp->stats.used_blocks == used);
+	CU_ASSERT(comp->stats.mapped_blocks == mapped);
+	CU_ASSERT(spdk_bit_pool_count_allocated(comp->pool) == used);
+	CU_ASSERT(TAILQ_EMPTY(&g_held_ios));
+	CU_ASSERT(TAILQ_EMPTY(&comp->blocked));
+}
+
+static void
+test_setup(void)
+{
+	memset(g_base.data, 0xa5, BASE_BLOCKS * BLOCK_SIZE);
+	ut_disk_reset(&g_base);
+}
+
+/* Tests */
+
+static void
+test_compress_create(void)
+{
+	struct vbdev_compress *comp;
+	struct compress_sb *sb = (struct compress_sb *)g_base.data;
+	struct bdev_compress_opts opts;
+	uint64_t i;
+
+	test_setup();
+
+	comp = create_compress(0);
+	SPDK_CU_ASSERT_FATAL(comp != NULL);
+	CU_ASSERT(comp->bdev.blockcnt == NUM_CHUNKS * CHUNK_BLOCKS);
+	CU_ASSERT(comp->bdev.blocklen == BLOCK_SIZE);
+	CU_ASSERT(comp->bdev.optimal_io_boundary == CHUNK_BLOCKS);
+	CU_ASSERT(comp->map_blocks == MAP_BLOCKS);
+	CU_ASSERT(comp->data_offset == 1 + MAP_BLOCKS);
+	CU_ASSERT(comp->data_blocks == DATA_BLOCKS);
+	CU_ASSERT(g_base.claimed);
+
+	/* Superblock and a zeroed map are on disk */
+	CU_ASSERT(memcmp(sb->magic, COMPRESS_SB_MAGIC, sizeof(sb->magic)) == 0);
+	CU_ASSERT(strcmp(sb->name, "comp0") == 0);
+	CU_ASSERT(sb->chunk_size == CHUNK_SIZE);
+	CU_ASSERT(spdk_mem_all_zero(g_base.data + BLOCK_SIZE, MAP_BLOCKS * BLOCK_SIZE));
+
+	/* A fresh compress bdev reads zeroes */
+	for (i = 0; i < NUM_CHUNKS; i += 10) {
+		check_chunk(comp, i, 0, false);
+	}
+
+	/* The base bdev is in use */
+	bdev_compress_get_default_opts(&opts);
+	opts.chunk_size = CHUNK_SIZE;
+	CU_ASSERT(create_compress_opts(&opts) == -EEXIST);
+
+	delete_compress();
+	CU_ASSERT(get_compress("comp0") == NULL);
+
+	/* Thin provisioned */
+	comp = create_compress(4 * NUM_CHUNKS * CHUNK_BLOCKS);
+	SPDK_CU_ASSERT_FATAL(comp != NULL);
+	CU_ASSERT(comp->bdev.blockcnt == 4 * NUM_CHUNKS * CHUNK_BLOCKS);
+	CU_ASSERT(comp->data_blocks ==
+		  BASE_BLOCKS - 1 - spdk_divide_round_up(4 * NUM_CHUNKS, ENTRIES));
+	delete_compress();
+
+	/* Too large for the base bdev */
+	opts.num_blocks = BASE_BLOCKS * ENTRIES * CHUNK_BLOCKS;
+	CU_ASSERT(create_compress_opts(&opts) == -ENOSPC);
+	CU_ASSERT(!g_base.claimed);
+
+	/* Not a multiple of the chunk size */
+	opts.num_blocks = CHUNK_BLOCKS + 1;
+	CU_ASSERT(create_compress_opts(&opts) == -EINVAL);
+	opts.num_blocks = 0;
+
+	/* Invalid chunk sizes */
+	opts.chunk_size = BLOCK_SIZE;
+	CU_ASSERT(create_compress_opts(&opts) == -EINVAL);
+	opts.chunk_size = CHUNK_SIZE + 1;
+	CU_ASSERT(create_compress_opts(&opts) == -EINVAL);
+	opts.chunk_size = 2 * COMPRESS_MAX_CHUNK_SIZE;
+	CU_ASSERT(create_compress_opts(&opts) == -EINVAL);
+	opts.chunk_size = CHUNK_SIZE;
+
+	/* Compression level out of range */
+	opts.comp_level = 4;
+	CU_ASSERT(create_compress_opts(&opts) == -EINVAL);
+	opts.comp_algo = SPDK_ACCEL_COMP_ALGO_LZ4;
+	CU_ASSERT(create_compress_opts(&opts) == 0);
+	delete_compress();
+	CU_ASSERT(sb->comp_algo == SPDK_ACCEL_COMP_ALGO_LZ4);
+	CU_ASSERT(sb->comp_level == 4);
+
+	g_create_done = false;
+	bdev_compress_create_disk("nonexistent", "comp0", &opts, create_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_create_done);
+	CU_ASSERT(g_create_rc == -ENODEV);
+}
+
+static void
+test_compress_io(void)
+{
+	struct vbdev_compress *comp;
+	uint8_t buf[3 * CHUNK_SIZE], ref[3 * CHUNK_SIZE];
+	uint32_t i;
+
+	test_setup();
+
+	comp = create_compress(0);
+	SPDK_CU_ASSERT_FATAL(comp != NULL);
+
+	/* Compressible chunks take half of the space */
+	write_chunk(comp, 0, 1, true);
+	CU_ASSERT(comp->stats.used_blocks == CHUNK_BLOCKS / 2);
+	CU_ASSERT(comp->stats.compress_ops == 1);
+	CU_ASSERT(comp->stats.compress_bytes_out == CHUNK_SIZE / 2);
+	CU_ASSERT(comp->map[0].len == CHUNK_SIZE / 2);
+	check_chunk(comp, 0, 1, true);
+	CU_ASSERT(comp->stats.decompress_ops == 1);
+
+	/* Incompressible chunks are stored as they are */
+	write_chunk(comp, 1, 2, false);
+	CU_ASSERT(comp->stats.used_blocks == CHUNK_BLOCKS / 2 + CHUNK_BLOCKS);
+	CU_ASSERT(comp->stats.incompressible_writes == 1);
+	CU_ASSERT(comp->map[1].len == CHUNK_SIZE);
+	check_chunk(comp, 1, 2, false);
+	CU_ASSERT(comp->stats.decompress_ops == 1);
+
+	/* Zero chunks do not use space */
+	memset(buf, 0, CHUNK_SIZE);
+	CU_ASSERT(submit_io(comp, 1, SPDK_BDEV_IO_TYPE_WRITE, 2 * CHUNK_BLOCKS, CHUNK_BLOCKS,
+			    buf) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(comp->stats.zero_writes == 1);
+	CU_ASSERT(comp->map[2].len == 0);
+	check_map(comp);
+
+	/* Multi-chunk reads across compressed, uncompressed and unmapped chunks, unaligned */
+	fill_chunk(ref, 1, true);
+	fill_chunk(ref + CHUNK_SIZE, 2, false);
+	memset(ref + 2 * CHUNK_SIZE, 0, CHUNK_SIZE);
+	CU_ASSERT(submit_io(comp, 1, SPDK_BDEV_IO_TYPE_READ, 3, 2 * CHUNK_BLOCKS, buf) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf, ref + 3 * BLOCK_SIZE, 2 * CHUNK_SIZE) == 0);
+
+	/* Partial writes merge with compressed, uncompressed and unmapped chunks */
+	for (i = 0; i < 3; i++) {
+		fill_block(ref + i * CHUNK_SIZE + 5 * BLOCK_SIZE, 100 + i);
+		fill_block(ref + i * CHUNK_SIZE + 6 * BLOCK_SIZE, 200 + i);
+		CU_ASSERT(submit_io(comp, i % 2, SPDK_BDEV_IO_TYPE_WRITE, i * CHUNK_BLOCKS + 5, 2,
+				    ref + i * CHUNK_SIZE + 5 * BLOCK_SIZE) ==
+			  SPDK_BDEV_IO_STATUS_SUCCESS);
+	}
+	CU_ASSERT(comp->stats.partial_writes == 3);
+	CU_ASSERT(comp->map[0].len == 7 * BLOCK_SIZE);
+	CU_ASSERT(comp->map[1].len == CHUNK_SIZE);
+	CU_ASSERT(comp->map[2].len == 7 * BLOCK_SIZE);
+	CU_ASSERT(submit_io(comp, 1, SPDK_BDEV_IO_TYPE_READ, 0, 3 * CHUNK_BLOCKS, buf) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf, ref, 3 * CHUNK_SIZE) == 0);
+	check_map(comp);
+
+	/* Writes spanning chunks, with the middle one written whole */
+	for (i = 0; i < 2 * CHUNK_BLOCKS; i++) {
+		fill_block(ref + (i + 4) * BLOCK_SIZE, 300 + i);
+	}
+	CU_ASSERT(submit_io(comp, 0, SPDK_BDEV_IO_TYPE_WRITE, 4, 2 * CHUNK_BLOCKS,
+			    ref + 4 * BLOCK_SIZE) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(submit_io(comp, 1, SPDK_BDEV_IO_TYPE_READ, 0, 3 * CHUNK_BLOCKS, buf) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf, ref, 3 * CHUNK_SIZE) == 0);
+	check_map(comp);
+
+	/* Unmap of a partial chunk keeps the rest, of a whole chunk releases it */
+	CU_ASSERT(submit_io(comp, 0, SPDK_BDEV_IO_TYPE_UNMAP, 2, 2, NULL) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	memset(ref + 2 * BLOCK_SIZE, 0, 2 * BLOCK_SIZE);
+	CU_ASSERT(submit_io(comp, 1, SPDK_BDEV_IO_TYPE_WRITE_ZEROES, CHUNK_BLOCKS, CHUNK_BLOCKS,
+			    NULL) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	memset(ref + CHUNK_SIZE, 0, CHUNK_SIZE);
+	CU_ASSERT(comp->map[1].len == 0);
+	CU_ASSERT(submit_io(comp, 1, SPDK_BDEV_IO_TYPE_READ, 0, 3 * CHUNK_BLOCKS, buf) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf, ref, 3 * CHUNK_SIZE) == 0);
+	check_map(comp);
+
+	/* Unmapping all data of a chunk releases it too */
+	CU_ASSERT(submit_io(comp, 0, SPDK_BDEV_IO_TYPE_UNMAP, 2 * CHUNK_BLOCKS, 5, NULL) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(submit_io(comp, 0, SPDK_BDEV_IO_TYPE_UNMAP, 2 * CHUNK_BLOCKS + 5, 2, NULL) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(comp->map[2].len == 0);
+	check_map(comp);
+
+	CU_ASSERT(submit_io(comp, 1, SPDK_BDEV_IO_TYPE_FLUSH, 0, comp->bdev.blockcnt, NULL) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(submit_io(comp, 0, SPDK_BDEV_IO_TYPE_RESET, 0, 0, NULL) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	/* Base bdev out of resources */
+	g_base.enomem_count = 2;
+	write_chunk(comp, 10, 6, true);
+	write_chunk(comp, 11, 7, false);
+	CU_ASSERT(g_base.enomem_count == 0);
+	g_base.enomem_count = 1;
+	check_chunk(comp, 10, 6, true);
+	g_base.enomem_count = 1;
+	check_chunk(comp, 11, 7, false);
+	check_map(comp);
+
+	delete_compress();
+}
+
+static void
+test_compress_chunk_lock(void)
+{
+	struct vbdev_compress *comp;
+	struct spdk_bdev_io *bdev_io[4];
+	uint8_t buf[4][CHUNK_SIZE], ref[CHUNK_SIZE];
+	uint32_t i;
+
+	test_setup();
+
+	comp = create_compress(0);
+	SPDK_CU_ASSERT_FATAL(comp != NULL);
+
+	write_chunk(comp, 0, 1, true);
+
+	/* Overlapping partial writes and reads of the same chunk, forwarded to the owner
+	 * thread in submission order
+	 */
+	fill_chunk(ref, 1, true);
+	fill_block(buf[0], 10);
+	fill_block(buf[2], 11);
+	g_io_done = 0;
+	bdev_io[0] = ut_start_io(&comp->bdev, 1, SPDK_BDEV_IO_TYPE_WRITE, 1, 1, buf[0]);
+	bdev_io[1] = ut_start_io(&comp->bdev, 1, SPDK_BDEV_IO_TYPE_READ, 0, CHUNK_BLOCKS, buf[1]);
+	bdev_io[2] = ut_start_io(&comp->bdev, 1, SPDK_BDEV_IO_TYPE_WRITE, 6, 1, buf[2]);
+	bdev_io[3] = ut_start_io(&comp->bdev, 1, SPDK_BDEV_IO_TYPE_READ, 0, CHUNK_BLOCKS, buf[3]);
+	poll_threads();
+	CU_ASSERT(g_io_done == 4);
+	for (i = 0; i < 4; i++) {
+		CU_ASSERT(ut_finish_io(bdev_io[i]) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	}
+
+	/* Each read sees all writes submitted before it */
+	memcpy(ref + BLOCK_SIZE, buf[0], BLOCK_SIZE);
+	CU_ASSERT(memcmp(buf[1], ref, CHUNK_SIZE) == 0);
+	memcpy(ref + 6 * BLOCK_SIZE, buf[2], BLOCK_SIZE);
+	CU_ASSERT(memcmp(buf[3], ref, CHUNK_SIZE) == 0);
+	CU_ASSERT(comp->stats.partial_writes == 2);
+	check_map(comp);
+
+	delete_compress();
+}
+
+static void
+test_compress_load(void)
+{
+	struct vbdev_compress *comp;
+	uint64_t used, mapped;
+	uint32_t i;
+
+	test_setup();
+
+	/* Nothing to load */
+	CU_ASSERT(examine_base() == NULL);
+	CU_ASSERT(!g_base.claimed);
+
+	comp = create_compress(0);
+	SPDK_CU_ASSERT_FATAL(comp != NULL);
+
+	/* Spread over both map blocks */
+	for (i = 0; i < NUM_CHUNKS; i += 3) {
+		write_chunk(comp, i, i + 1, i % 2);
+	}
+	used = comp->stats.used_blocks;
+	mapped = comp->stats.mapped_blocks;
+
+	delete_compress();
+
+	comp = examine_base();
+	SPDK_CU_ASSERT_FATAL(comp != NULL);
+	CU_ASSERT(g_base.claimed);
+	CU_ASSERT(comp->chunk_size == CHUNK_SIZE);
+	CU_ASSERT(comp->stats.used_blocks == used);
+	CU_ASSERT(comp->stats.mapped_blocks == mapped);
+	check_map(comp);
+	for (i = 0; i < NUM_CHUNKS; i += 3) {
+		check_chunk(comp, i, i + 1, i % 2);
+	}
+
+	/* A failed map write fails the I/O and keeps the old data on disk */
+	g_base.fail_write_lba = comp->map_offset;
+	CU_ASSERT(write_chunk_status(comp, 0, 100, true) == SPDK_BDEV_IO_STATUS_FAILED);
+	g_base.fail_write_lba = UINT64_MAX;
+
+	delete_compress();
+
+	comp = examine_base();
+	SPDK_CU_ASSERT_FATAL(comp != NULL);
+	check_chunk(comp, 0, 1, false);
+	check_chunk(comp, 3, 4, true);
+	check_map(comp);
+
+	/* A failed data write leaves the chunk as it was */
+	g_base.fail_write_lba = comp->data_offset + spdk_bit_pool_count_allocated(comp->pool);
+	CU_ASSERT(write_chunk_status(comp, 3, 101, false) == SPDK_BDEV_IO_STATUS_FAILED);
+	g_base.fail_write_lba = UINT64_MAX;
+	check_chunk(comp, 3, 4, true);
+	check_map(comp);
+
+	delete_compress();
+
+	/* Map entries pointing outside the data region */
+	comp = examine_base();
+	SPDK_CU_ASSERT_FATAL(comp != NULL);
+	((struct compress_map_entry *)(g_base.data + BLOCK_SIZE))[0].offset = DATA_BLOCKS;
+	delete_compress();
+	CU_ASSERT(examine_base() == NULL);
+	CU_ASSERT(!g_base.claimed);
+
+	/* Corrupted superblock */
+	comp = create_compress(0);
+	SPDK_CU_ASSERT_FATAL(comp != NULL);
+	delete_compress();
+	g_base.data[16] ^= 0xff;
+	CU_ASSERT(examine_base() == NULL);
+	CU_ASSERT(!g_base.claimed);
+}
+
+static void
+test_compress_out_of_space(void)
+{
+	struct vbdev_compress *comp;
+	uint32_t i, num_chunks;
+
+	test_setup();
+
+	comp = create_compress(2 * NUM_CHUNKS * CHUNK_BLOCKS);
+	SPDK_CU_ASSERT_FATAL(comp != NULL);
+	num_chunks = comp->data_blocks / CHUNK_BLOCKS;
+
+	for (i = 0; i < num_chunks; i++) {
+		write_chunk(comp, i, i + 1, false);
+	}
+
+	/* Zeroes still fit, data does not */
+	CU_ASSERT(submit_io(comp, 0, SPDK_BDEV_IO_TYPE_WRITE_ZEROES, num_chunks * CHUNK_BLOCKS,
+			    CHUNK_BLOCKS, NULL) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(write_chunk_status(comp, num_chunks + 1, 1000, false) ==
+		  SPDK_BDEV_IO_STATUS_FAILED);
+	check_chunk(comp, num_chunks + 1, 0, false);
+
+	/* Freeing a chunk makes room again. Overwrites need a free run as the old one is
+	 * released only once the map is updated, then shrinking chunks frees more.
+	 */
+	CU_ASSERT(submit_io(comp, 0, SPDK_BDEV_IO_TYPE_UNMAP, 0, CHUNK_BLOCKS, NULL) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	write_chunk(comp, 1, 2, true);
+	write_chunk(comp, 2, 3, true);
+	write_chunk(comp, num_chunks + 1, 1000, false);
+	write_chunk(comp, num_chunks + 2, 1001, false);
+	check_chunk(comp, num_chunks + 1, 1000, false);
+	check_chunk(comp, num_chunks + 2, 1001, false);
+	check_chunk(comp, 1, 2, true);
+	check_map(comp);
+
+	delete_compress();
+}
+
+static void
+test_compress_map_batch(void)
+{
+	struct vbdev_compress *comp;
+	struct spdk_bdev_io *bdev_io[3];
+	uint8_t buf[3][CHUNK_SIZE], ref[2 * CHUNK_SIZE];
+	uint64_t writes, used;
+	uint32_t i;
+
+	test_setup();
+
+	comp = create_compress(0);
+	SPDK_CU_ASSERT_FATAL(comp != NULL);
+
+	/* Chunks sharing a map block. The first map write is held, the updates made meanwhile
+	 * go out together in the next one and no I/O completes before its entry is on disk.
+	 */
+	g_base.hold = true;
+	g_io_done = 0;
+	writes = g_base.writes;
+	for (i = 0; i < 3; i++) {
+		fill_chunk(buf[i], i + 1, true);
+		bdev_io[i] = ut_start_io(&comp->bdev, i % 2, SPDK_BDEV_IO_TYPE_WRITE,
+					 i * CHUNK_BLOCKS, CHUNK_BLOCKS, buf[i]);
+	}
+	poll_threads();
+	CU_ASSERT(g_base.writes == writes + 3);
+
+	/* Data is on disk, the map write of the first chunk is issued */
+	ut_release_ios();
+	CU_ASSERT(g_base.writes == writes + 4);
+	CU_ASSERT(g_io_done == 0);
+
+	/* The second map write covers the two remaining chunks */
+	ut_release_ios();
+	CU_ASSERT(g_base.writes == writes + 5);
+	CU_ASSERT(g_io_done == 1);
+
+	ut_release_ios();
+	g_base.hold = false;
+	CU_ASSERT(g_base.writes == writes + 5);
+	CU_ASSERT(g_io_done == 3);
+	for (i = 0; i < 3; i++) {
+		CU_ASSERT(ut_finish_io(bdev_io[i]) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	}
+	check_map(comp);
+
+	/* A batch spanning both map blocks writes each of them once */
+	writes = g_base.writes;
+	fill_chunk(ref, 10, false);
+	fill_chunk(ref + CHUNK_SIZE, 11, true);
+	CU_ASSERT(submit_io(comp, 1, SPDK_BDEV_IO_TYPE_WRITE, (ENTRIES - 1) * CHUNK_BLOCKS,
+			    2 * CHUNK_BLOCKS, ref) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(g_base.writes == writes + 4);
+	check_map(comp);
+
+	/* A failed write of the second map block fails the I/O, and the runs of the previous
+	 * entries stay allocated as the first map block may already reference the new ones
+	 */
+	used = spdk_bit_pool_count_allocated(comp->pool);
+	g_base.fail_write_lba = comp->map_offset + 1;
+	CU_ASSERT(submit_io(comp, 0, SPDK_BDEV_IO_TYPE_WRITE, (ENTRIES - 1) * CHUNK_BLOCKS,
+			    2 * CHUNK_BLOCKS, buf[0]) == SPDK_BDEV_IO_STATUS_FAILED);
+	g_base.fail_write_lba = UINT64_MAX;
+	CU_ASSERT(spdk_bit_pool_count_allocated(comp->pool) == used + CHUNK_BLOCKS);
+
+	delete_compress();
+
+	/* Reloading rebuilds the pool from what is on disk */
+	comp = examine_base();
+	SPDK_CU_ASSERT_FATAL(comp != NULL);
+	for (i = 0; i < 3; i++) {
+		check_chunk(comp, i, i + 1, true);
+	}
+	check_chunk(comp, ENTRIES, 11, true);
+	check_map(comp);
+
+	delete_compress();
+}
+
+struct stats_ctx {
+	int count;
+	uint32_t chunk_size;
+	struct bdev_compress_stats stats;
+};
+
+static void
+stats_cb(void *cb_arg, const char *name, uint32_t chunk_size,
+	 const struct bdev_compress_stats *stats)
+{
+	struct stats_ctx *ctx = cb_arg;
+
+	CU_ASSERT(strcmp(name, "comp0") == 0);
+	ctx->chunk_size = chunk_size;
+	ctx->stats = *stats;
+	ctx->count++;
+}
+
+static void
+test_compress_stats(void)
+{
+	struct vbdev_compress *comp;
+	struct stats_ctx ctx = {};
+
+	test_setup();
+
+	comp = create_compress(0);
+	SPDK_CU_ASSERT_FATAL(comp != NULL);
+
+	write_chunk(comp, 0, 1, true);
+	write_chunk(comp, 1, 2, true);
+	write_chunk(comp, 2, 3, false);
+	check_chunk(comp, 0, 1, true);
+
+	CU_ASSERT(bdev_compress_get_stats(NULL, stats_cb, &ctx) == 0);
+	CU_ASSERT(bdev_compress_get_stats("comp0", stats_cb, &ctx) == 0);
+	CU_ASSERT(ctx.count == 2);
+	CU_ASSERT(ctx.chunk_size == CHUNK_SIZE);
+	CU_ASSERT(ctx.stats.logical_blocks == NUM_CHUNKS * CHUNK_BLOCKS);
+	CU_ASSERT(ctx.stats.physical_blocks == DATA_BLOCKS);
+	CU_ASSERT(ctx.stats.mapped_blocks == 3 * CHUNK_BLOCKS);
+	CU_ASSERT(ctx.stats.used_blocks == 2 * CHUNK_BLOCKS);
+	CU_ASSERT(ctx.stats.compress_ops == 3);
+	CU_ASSERT(ctx.stats.compress_bytes_in == 3 * CHUNK_SIZE);
+	CU_ASSERT(ctx.stats.compress_bytes_out == 2 * CHUNK_SIZE);
+	CU_ASSERT(ctx.stats.incompressible_writes == 1);
+	CU_ASSERT(ctx.stats.decompress_ops == 1);
+	CU_ASSERT(bdev_compress_get_stats("comp1", stats_cb, &ctx) == -ENODEV);
+	CU_ASSERT(ctx.count == 2);
+
+	delete_compress();
+
+	CU_ASSERT(bdev_compress_get_stats(NULL, stats_cb, &ctx) == 0);
+	CU_ASSERT(ctx.count == 2);
+}
+
+static int
+test_suite_init(void)
+{
+	allocate_threads(2);
+	set_thread(0);
+	spdk_io_device_register(&g_accel_io_device, ut_disk_ch_create_cb, ut_disk_ch_destroy_cb, 0,
+				"accel");
+
+	return ut_disk_init(&g_base, "base", BASE_BLOCKS);
+}
+
+static int
+test_suite_fini(void)
+{
+	ut_disk_fini(&g_base);
+	spdk_io_device_unregister(&g_accel_io_device, NULL);
+	poll_threads();
+	free_threads();
+
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("compress", test_suite_init, test_suite_fini);
+
+	CU_ADD_TEST(suite, test_compress_create);
+	CU_ADD_TEST(suite, test_compress_io);
+	CU_ADD_TEST(suite, test_compress_chunk_lock);
+	CU_ADD_TEST(suite, test_compress_load);
+	CU_ADD_TEST(suite, test_compress_out_of_space);
+	CU_ADD_TEST(suite, test_compress_map_batch);
+	CU_ADD_TEST(suite, test_compress_stats);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+
+	CU_cleanup_registry();
+
+	return num_failures;
+}
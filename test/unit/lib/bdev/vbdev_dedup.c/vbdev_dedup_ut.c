@@ -0,0 +1,607 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk_internal/cunit.h"
+#include "spdk/env.h"
+
+#include "common/lib/ut_multithread.c"
+
+#include "bdev/map.c"
+#include "bdev/dedup/vbdev_dedup.c"
+
+#include "common/lib/bdev/ut_vbdev.c"
+
+#define BASE_BLOCKS	256
+#define ENTRIES		(BLOCK_SIZE / sizeof(uint64_t))
+/* Superblock and 4 map blocks, 251 data blocks */
+#define MAP_BLOCKS	4
+#define DATA_BLOCKS	(BASE_BLOCKS - 1 - MAP_BLOCKS)
+
+static struct ut_disk g_base;
+
+static struct vbdev_dedup *
+get_dedup(const char *name)
+{
+	return ut_get_vbdev(name, &dedup_if);
+}
+
+static struct vbdev_dedup *
+create_dedup(uint64_t num_blocks)
+{
+	g_create_done = false;
+	bdev_dedup_create_disk("base", "dedup0", num_blocks, create_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_create_done);
+	CU_ASSERT(g_create_rc == 0);
+
+	return get_dedup("dedup0");
+}
+
+static void
+delete_dedup(void)
+{
+	g_delete_done = false;
+	bdev_dedup_delete_disk("dedup0", delete_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_delete_done);
+	CU_ASSERT(g_delete_rc == 0);
+	CU_ASSERT(!g_base.claimed);
+}
+
+static struct vbdev_dedup *
+examine_base(void)
+{
+	ut_examine_disk(&dedup_if, &g_base);
+
+	return get_dedup("dedup0");
+}
+
+static enum spdk_bdev_io_status
+submit_io(struct vbdev_dedup *dedup, int thread, enum spdk_bdev_io_type type, uint64_t lba,
+	  uint64_t num_blocks, void *buf)
+{
+	return ut_submit_io(&dedup->bdev, thread, type, lba, num_blocks, buf);
+}
+
+static void
+write_pattern(struct vbdev_dedup *dedup, uint64_t lba, uint32_t pattern)
+{
+	uint8_t buf[BLOCK_SIZE];
+
+	fill_block(buf, pattern);
+	CU_ASSERT(submit_io(dedup, 0, SPDK_BDEV_IO_TYPE_WRITE, lba, 1, buf) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+}
+
+static enum spdk_bdev_io_status
+write_pattern_status(struct vbdev_dedup *dedup, uint64_t lba, uint32_t pattern)
+{
+	uint8_t buf[BLOCK_SIZE];
+
+	fill_block(buf, pattern);
+
+	return submit_io(dedup, 0, SPDK_BDEV_IO_TYPE_WRITE, lba, 1, buf);
+}
+
+static void
+check_pattern(struct vbdev_dedup *dedup, uint64_t lba, uint32_t pattern)
+{
+	uint8_t buf[BLOCK_SIZE], ref[BLOCK_SIZE];
+
+	if (pattern == 0) {
+		memset(ref, 0, sizeof(ref));
+	} else {
+		fill_block(ref, pattern);
+	}
+
+	CU_ASSERT(submit_io(dedup, 1, SPDK_BDEV_IO_TYPE_READ, lba, 1, buf) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf, ref, BLOCK_SIZE) == 0);
+}
+
+/* Compare in-memory state with what is derived from the map */
+static void
+check_refs(struct vbdev_dedup *dedup)
+{
+	uint32_t refs[DATA_BLOCKS] = {};
+	uint64_t lba, used = 0, mapped = 0;
+	uint32_t phys;
+
+	for (lba = 0; lba < dedup->bdev.blockcnt; lba++) {
+		if (dedup->map[lba] != 0) {
+			refs[dedup->map[lba] - 1]++;
+			mapped++;
+		}
+	}
+
+	for (phys = 0; phys < dedup->data_blocks; phys++) {
+		CU_ASSERT(dedup->refcnt[phys] == refs[phys]);
+		used += refs[phys] != 0;
+	}
+
+	CU_ASSERT(dedup->stats.used_blocks == used);
+	CU_ASSERT(dedup->stats.mapped_blocks == mapped);
+	CU_ASSERT(spdk_bit_pool_count_allocated(dedup->pool) == used);
+	CU_ASSERT(TAILQ_EMPTY(&g_held_ios));
+}
+
+static void
+test_setup(void)
+{
+	memset(g_base.data, 0xa5, BASE_BLOCKS * BLOCK_SIZE);
+	ut_disk_reset(&g_base);
+}
+
+/* Tests */
+
+static void
+test_dedup_create(void)
+{
+	struct vbdev_dedup *dedup;
+	struct dedup_sb *sb = (struct dedup_sb *)g_base.data;
+	uint64_t i;
+
+	test_setup();
+
+	dedup = create_dedup(0);
+	SPDK_CU_ASSERT_FATAL(dedup != NULL);
+	CU_ASSERT(dedup->bdev.blockcnt == DATA_BLOCKS);
+	CU_ASSERT(dedup->bdev.blocklen == BLOCK_SIZE);
+	CU_ASSERT(dedup->map_blocks == MAP_BLOCKS);
+	CU_ASSERT(dedup->data_offset == 1 + MAP_BLOCKS);
+	CU_ASSERT(dedup->data_blocks == DATA_BLOCKS);
+	CU_ASSERT(g_base.claimed);
+
+	/* Superblock and a zeroed map are on disk */
+	CU_ASSERT(memcmp(sb->magic, DEDUP_SB_MAGIC, sizeof(sb->magic)) == 0);
+	CU_ASSERT(strcmp(sb->name, "dedup0") == 0);
+	CU_ASSERT(spdk_mem_all_zero(g_base.data + BLOCK_SIZE, MAP_BLOCKS * BLOCK_SIZE));
+
+	/* A fresh dedup bdev reads zeroes */
+	for (i = 0; i < dedup->bdev.blockcnt; i += 50) {
+		check_pattern(dedup, i, 0);
+	}
+
+	/* The base bdev is in use */
+	g_create_done = false;
+	bdev_dedup_create_disk("base", "dedup1", 0, create_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_create_done);
+	CU_ASSERT(g_create_rc == -EEXIST || g_create_rc == -EPERM);
+
+	delete_dedup();
+	CU_ASSERT(get_dedup("dedup0") == NULL);
+
+	/* Thin provisioned */
+	dedup = create_dedup(4 * DATA_BLOCKS);
+	SPDK_CU_ASSERT_FATAL(dedup != NULL);
+	CU_ASSERT(dedup->bdev.blockcnt == 4 * DATA_BLOCKS);
+	CU_ASSERT(dedup->data_blocks ==
+		  BASE_BLOCKS - 1 - spdk_divide_round_up(4 * DATA_BLOCKS, ENTRIES));
+	delete_dedup();
+
+	/* Too large for the base bdev */
+	g_create_done = false;
+	bdev_dedup_create_disk("base", "dedup0", BASE_BLOCKS * ENTRIES, create_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_create_done);
+	CU_ASSERT(g_create_rc == -ENOSPC);
+	CU_ASSERT(!g_base.claimed);
+
+	g_create_done = false;
+	bdev_dedup_create_disk("nonexistent", "dedup0", 0, create_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_create_done);
+	CU_ASSERT(g_create_rc == -ENODEV);
+}
+
+static void
+test_dedup_io(void)
+{
+	struct vbdev_dedup *dedup;
+	uint8_t buf[8 * BLOCK_SIZE];
+	uint64_t writes;
+	uint32_t i;
+
+	test_setup();
+
+	dedup = create_dedup(0);
+	SPDK_CU_ASSERT_FATAL(dedup != NULL);
+
+	/* 4 unique blocks */
+	for (i = 0; i < 4; i++) {
+		fill_block(buf + i * BLOCK_SIZE, i + 1);
+	}
+	CU_ASSERT(submit_io(dedup, 0, SPDK_BDEV_IO_TYPE_WRITE, 0, 4, buf) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(dedup->stats.unique_writes == 4);
+	CU_ASSERT(dedup->stats.used_blocks == 4);
+	CU_ASSERT(dedup->stats.index_hits == 0);
+
+	/* Same data from another thread only updates the map */
+	writes = g_base.writes;
+	CU_ASSERT(submit_io(dedup, 1, SPDK_BDEV_IO_TYPE_WRITE, 4, 4, buf) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(dedup->stats.index_hits == 4);
+	CU_ASSERT(dedup->stats.used_blocks == 4);
+	CU_ASSERT(dedup->stats.mapped_blocks == 8);
+	/* Entries of both writes share a single map block */
+	CU_ASSERT(g_base.writes - writes == 1);
+
+	memset(buf, 0, sizeof(buf));
+	CU_ASSERT(submit_io(dedup, 1, SPDK_BDEV_IO_TYPE_READ, 0, 8, buf) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	for (i = 0; i < 8; i++) {
+		uint8_t ref[BLOCK_SIZE];
+
+		fill_block(ref, i % 4 + 1);
+		CU_ASSERT(memcmp(buf + i * BLOCK_SIZE, ref, BLOCK_SIZE) == 0);
+	}
+
+	/* Zero blocks do not use space */
+	memset(buf, 0, BLOCK_SIZE);
+	CU_ASSERT(submit_io(dedup, 0, SPDK_BDEV_IO_TYPE_WRITE, 8, 1, buf) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(dedup->stats.zero_writes == 1);
+	CU_ASSERT(dedup->stats.used_blocks == 4);
+	check_pattern(dedup, 8, 0);
+
+	/* Overwriting a shared block keeps the other reference */
+	write_pattern(dedup, 0, 5);
+	CU_ASSERT(dedup->stats.used_blocks == 5);
+	check_pattern(dedup, 0, 5);
+	check_pattern(dedup, 4, 1);
+	check_refs(dedup);
+
+	/* Dropping the last reference frees the block */
+	write_pattern(dedup, 4, 5);
+	CU_ASSERT(dedup->stats.used_blocks == 4);
+	check_pattern(dedup, 4, 5);
+	check_refs(dedup);
+
+	/* Overwrite with the same data */
+	write_pattern(dedup, 4, 5);
+	CU_ASSERT(dedup->stats.used_blocks == 4);
+	check_refs(dedup);
+
+	/* Unmap and write zeroes drop the mapping */
+	CU_ASSERT(submit_io(dedup, 0, SPDK_BDEV_IO_TYPE_UNMAP, 1, 1, NULL) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(dedup->stats.used_blocks == 4);
+	CU_ASSERT(submit_io(dedup, 1, SPDK_BDEV_IO_TYPE_WRITE_ZEROES, 5, 1, NULL) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(dedup->stats.used_blocks == 3);
+	check_pattern(dedup, 1, 0);
+	check_pattern(dedup, 5, 0);
+	check_refs(dedup);
+
+	/* Reads spanning mapped and unmapped blocks */
+	CU_ASSERT(submit_io(dedup, 1, SPDK_BDEV_IO_TYPE_READ, 0, 8, buf) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	for (i = 0; i < 8; i++) {
+		uint8_t ref[BLOCK_SIZE];
+		uint32_t pattern[] = { 5, 0, 3, 4, 5, 0, 3, 4 };
+
+		if (pattern[i] == 0) {
+			memset(ref, 0, sizeof(ref));
+		} else {
+			fill_block(ref, pattern[i]);
+		}
+		CU_ASSERT(memcmp(buf + i * BLOCK_SIZE, ref, BLOCK_SIZE) == 0);
+	}
+
+	CU_ASSERT(submit_io(dedup, 1, SPDK_BDEV_IO_TYPE_FLUSH, 0, dedup->bdev.blockcnt, NULL) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(submit_io(dedup, 0, SPDK_BDEV_IO_TYPE_RESET, 0, 0, NULL) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	/* Base bdev out of resources */
+	g_base.enomem_count = 2;
+	write_pattern(dedup, 10, 6);
+	write_pattern(dedup, 11, 6);
+	CU_ASSERT(g_base.enomem_count == 0);
+	g_base.enomem_count = 1;
+	check_pattern(dedup, 11, 6);
+	check_refs(dedup);
+
+	delete_dedup();
+}
+
+static void
+test_dedup_collision(void)
+{
+	struct vbdev_dedup *dedup;
+	uint8_t buf[BLOCK_SIZE];
+	uint32_t phys;
+
+	test_setup();
+
+	dedup = create_dedup(0);
+	SPDK_CU_ASSERT_FATAL(dedup != NULL);
+
+	write_pattern(dedup, 0, 1);
+	phys = dedup->map[0] - 1;
+
+	/* Give the stored block the fingerprint of different data */
+	fill_block(buf, 2);
+	dedup_index_remove(dedup, phys);
+	dedup->crc[phys] = spdk_crc32c_update(buf, BLOCK_SIZE, ~0);
+	dedup_index_insert(dedup, phys);
+
+	write_pattern(dedup, 1, 2);
+	CU_ASSERT(dedup->stats.index_collisions == 1);
+	CU_ASSERT(dedup->stats.index_hits == 0);
+	CU_ASSERT(dedup->stats.used_blocks == 2);
+	CU_ASSERT(dedup->map[1] != dedup->map[0]);
+	check_pattern(dedup, 0, 1);
+	check_pattern(dedup, 1, 2);
+
+	/* The block with the real data is still found behind the colliding one */
+	dedup_index_remove(dedup, phys);
+	dedup_index_insert(dedup, phys);
+	write_pattern(dedup, 2, 2);
+	CU_ASSERT(dedup->stats.index_collisions == 2);
+	CU_ASSERT(dedup->stats.index_hits == 1);
+	CU_ASSERT(dedup->map[2] == dedup->map[1]);
+	check_refs(dedup);
+
+	delete_dedup();
+}
+
+static void
+test_dedup_load(void)
+{
+	struct vbdev_dedup *dedup;
+	uint64_t used, mapped;
+	uint32_t i;
+
+	test_setup();
+
+	/* Nothing to load */
+	CU_ASSERT(examine_base() == NULL);
+	CU_ASSERT(!g_base.claimed);
+
+	dedup = create_dedup(0);
+	SPDK_CU_ASSERT_FATAL(dedup != NULL);
+
+	for (i = 0; i < 2 * ENTRIES; i++) {
+		write_pattern(dedup, i, i % 7 + 1);
+	}
+	used = dedup->stats.used_blocks;
+	mapped = dedup->stats.mapped_blocks;
+	CU_ASSERT(used == 7);
+	CU_ASSERT(mapped == 2 * ENTRIES);
+
+	delete_dedup();
+
+	dedup = examine_base();
+	SPDK_CU_ASSERT_FATAL(dedup != NULL);
+	CU_ASSERT(g_base.claimed);
+	CU_ASSERT(dedup->stats.used_blocks == used);
+	CU_ASSERT(dedup->stats.mapped_blocks == mapped);
+	check_refs(dedup);
+	for (i = 0; i < 2 * ENTRIES; i += 13) {
+		check_pattern(dedup, i, i % 7 + 1);
+	}
+
+	/* The index is rebuilt */
+	write_pattern(dedup, 2 * ENTRIES, 3);
+	CU_ASSERT(dedup->stats.index_hits == 1);
+	CU_ASSERT(dedup->stats.used_blocks == used);
+
+	/* A failed map write fails the I/O and keeps the old data on disk */
+	g_base.fail_write_lba = dedup->map_offset;
+	CU_ASSERT(write_pattern_status(dedup, 0, 100) == SPDK_BDEV_IO_STATUS_FAILED);
+	g_base.fail_write_lba = UINT64_MAX;
+
+	delete_dedup();
+
+	dedup = examine_base();
+	SPDK_CU_ASSERT_FATAL(dedup != NULL);
+	check_pattern(dedup, 0, 1);
+	check_pattern(dedup, 2 * ENTRIES, 3);
+	check_refs(dedup);
+
+	/* A failed data write leaves the block as it was */
+	g_base.fail_write_lba = dedup->data_offset + spdk_bit_pool_count_allocated(dedup->pool);
+	CU_ASSERT(write_pattern_status(dedup, 1, 101) == SPDK_BDEV_IO_STATUS_FAILED);
+	g_base.fail_write_lba = UINT64_MAX;
+	check_pattern(dedup, 1, 2);
+	check_refs(dedup);
+
+	delete_dedup();
+
+	/* Corrupted superblock */
+	g_base.data[16] ^= 0xff;
+	CU_ASSERT(examine_base() == NULL);
+	CU_ASSERT(!g_base.claimed);
+}
+
+static void
+test_dedup_out_of_space(void)
+{
+	struct vbdev_dedup *dedup;
+	uint32_t i, data_blocks;
+
+	test_setup();
+
+	dedup = create_dedup(2 * DATA_BLOCKS);
+	SPDK_CU_ASSERT_FATAL(dedup != NULL);
+	data_blocks = dedup->data_blocks;
+
+	for (i = 0; i < data_blocks; i++) {
+		write_pattern(dedup, i, i + 1);
+	}
+	CU_ASSERT(dedup->stats.used_blocks == data_blocks);
+
+	/* Duplicates and zeroes still fit */
+	write_pattern(dedup, data_blocks, 1);
+	CU_ASSERT(submit_io(dedup, 0, SPDK_BDEV_IO_TYPE_WRITE_ZEROES, data_blocks + 1, 1, NULL) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	/* Unique data does not */
+	CU_ASSERT(write_pattern_status(dedup, data_blocks + 2, 1000) == SPDK_BDEV_IO_STATUS_FAILED);
+	check_pattern(dedup, data_blocks + 2, 0);
+
+	/* Freeing a block makes room again */
+	CU_ASSERT(submit_io(dedup, 0, SPDK_BDEV_IO_TYPE_UNMAP, 1, 1, NULL) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	write_pattern(dedup, data_blocks + 2, 1000);
+	check_pattern(dedup, data_blocks + 2, 1000);
+	check_refs(dedup);
+
+	delete_dedup();
+}
+
+static void
+test_dedup_batch(void)
+{
+	struct vbdev_dedup *dedup;
+	uint64_t num_blocks = DEDUP_BATCH_BLOCKS + 2 * ENTRIES, i;
+	uint8_t *buf;
+
+	test_setup();
+
+	dedup = create_dedup(num_blocks);
+	SPDK_CU_ASSERT_FATAL(dedup != NULL);
+
+	buf = calloc(num_blocks, BLOCK_SIZE);
+	SPDK_CU_ASSERT_FATAL(buf != NULL);
+
+	/* A request spanning several batches and map blocks */
+	for (i = 0; i < num_blocks; i++) {
+		fill_block(buf + i * BLOCK_SIZE, i % 3 + 1);
+	}
+	CU_ASSERT(submit_io(dedup, 1, SPDK_BDEV_IO_TYPE_WRITE, 0, num_blocks, buf) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(dedup->stats.used_blocks == 3);
+	CU_ASSERT(dedup->stats.mapped_blocks == num_blocks);
+	CU_ASSERT(dedup->stats.index_hits == num_blocks - 3);
+	check_refs(dedup);
+
+	/* The previous blocks are released once the batches replacing them are persisted */
+	for (i = 0; i < num_blocks; i++) {
+		fill_block(buf + i * BLOCK_SIZE, i % 3 + 4);
+	}
+	CU_ASSERT(submit_io(dedup, 0, SPDK_BDEV_IO_TYPE_WRITE, 0, num_blocks, buf) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(dedup->stats.used_blocks == 3);
+	check_refs(dedup);
+
+	/* Write zeroes across the batch boundary of a request */
+	CU_ASSERT(submit_io(dedup, 1, SPDK_BDEV_IO_TYPE_WRITE_ZEROES, 10, DEDUP_BATCH_BLOCKS + 10,
+			    NULL) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(dedup->stats.mapped_blocks == num_blocks - DEDUP_BATCH_BLOCKS - 10);
+	check_pattern(dedup, DEDUP_BATCH_BLOCKS + 19, 0);
+	check_pattern(dedup, DEDUP_BATCH_BLOCKS + 20, (DEDUP_BATCH_BLOCKS + 20) % 3 + 4);
+	check_refs(dedup);
+
+	/* Every map block made it to disk */
+	delete_dedup();
+	dedup = examine_base();
+	SPDK_CU_ASSERT_FATAL(dedup != NULL);
+	CU_ASSERT(dedup->stats.mapped_blocks == num_blocks - DEDUP_BATCH_BLOCKS - 10);
+	CU_ASSERT(dedup->stats.used_blocks == 3);
+	check_pattern(dedup, 9, 9 % 3 + 4);
+	check_pattern(dedup, num_blocks - 1, (num_blocks - 1) % 3 + 4);
+	check_refs(dedup);
+
+	delete_dedup();
+	free(buf);
+}
+
+struct stats_ctx {
+	int count;
+	struct bdev_dedup_stats stats;
+};
+
+static void
+stats_cb(void *cb_arg, const char *name, const struct bdev_dedup_stats *stats)
+{
+	struct stats_ctx *ctx = cb_arg;
+
+	CU_ASSERT(strcmp(name, "dedup0") == 0);
+	ctx->stats = *stats;
+	ctx->count++;
+}
+
+static void
+test_dedup_stats(void)
+{
+	struct vbdev_dedup *dedup;
+	struct stats_ctx ctx = {};
+
+	test_setup();
+
+	dedup = create_dedup(0);
+	SPDK_CU_ASSERT_FATAL(dedup != NULL);
+
+	write_pattern(dedup, 0, 1);
+	write_pattern(dedup, 1, 1);
+	write_pattern(dedup, 2, 2);
+
+	CU_ASSERT(bdev_dedup_get_stats(NULL, stats_cb, &ctx) == 0);
+	CU_ASSERT(bdev_dedup_get_stats("dedup0", stats_cb, &ctx) == 0);
+	CU_ASSERT(ctx.count == 2);
+	CU_ASSERT(ctx.stats.logical_blocks == DATA_BLOCKS);
+	CU_ASSERT(ctx.stats.physical_blocks == DATA_BLOCKS);
+	CU_ASSERT(ctx.stats.mapped_blocks == 3);
+	CU_ASSERT(ctx.stats.used_blocks == 2);
+	CU_ASSERT(ctx.stats.index_lookups == 3);
+	CU_ASSERT(ctx.stats.index_hits == 1);
+	CU_ASSERT(ctx.stats.unique_writes == 2);
+	CU_ASSERT(bdev_dedup_get_stats("dedup1", stats_cb, &ctx) == -ENODEV);
+	CU_ASSERT(ctx.count == 2);
+
+	delete_dedup();
+
+	CU_ASSERT(bdev_dedup_get_stats(NULL, stats_cb, &ctx) == 0);
+	CU_ASSERT(ctx.count == 2);
+}
+
+static int
+test_suite_init(void)
+{
+	allocate_threads(2);
+	set_thread(0);
+
+	return ut_disk_init(&g_base, "base", BASE_BLOCKS);
+}
+
+static int
+test_suite_fini(void)
+{
+	ut_disk_fini(&g_base);
+	poll_threads();
+	free_threads();
+
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("dedup", test_suite_init, test_suite_fini);
+
+	CU_ADD_TEST(suite, test_dedup_create);
+	CU_ADD_TEST(suite, test_dedup_io);
+	CU_ADD_TEST(suite, test_dedup_collision);
+	CU_ADD_TEST(suite, test_dedup_load);
+	CU_ADD_TEST(suite, test_dedup_out_of_space);
+	CU_ADD_TEST(suite, test_dedup_batch);
+	CU_ADD_TEST(suite, test_dedup_stats);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+
+	CU_cleanup_registry();
+
+	return num_failures;
+}
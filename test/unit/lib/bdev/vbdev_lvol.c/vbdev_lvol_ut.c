@@ -911,6 +911,23 @@ spdk_lvol_shallow_copy(struct spdk_lvol *lvol, struct spdk_bs_dev *ext_dev,
 	return 0;
 }
 
+int
+spdk_lvol_diff_copy(struct spdk_lvol *lvol, struct spdk_lvol *base, struct spdk_bs_dev *ext_dev,
+		    spdk_blob_diff_copy_status status_cb_fn, void *status_cb_arg,
+		    spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	if (lvol == NULL) {
+		return -ENODEV;
+	}
+
+	if (ext_dev == NULL) {
+		return -ENODEV;
+	}
+
+	cb_fn(cb_arg, 0);
+	return 0;
+}
+
 void
 spdk_lvol_set_external_parent(struct spdk_lvol *lvol, const void *esnap_id, uint32_t id_len,
 			      spdk_lvol_op_complete cb_fn, void *cb_arg)
@@ -2033,6 +2050,22 @@ ut_lvol_shallow_copy(void)
 	CU_ASSERT(rc == 0);
 	CU_ASSERT(g_lvolerrno == 0);
 
+	/* Diff copy errors with NULL lvol or NULL bdev name */
+	rc = vbdev_lvol_diff_copy(NULL, NULL, "", NULL, NULL, vbdev_lvol_shallow_copy_complete,
+				  NULL);
+	CU_ASSERT(rc == -EINVAL);
+	rc = vbdev_lvol_diff_copy(g_lvol, NULL, NULL, NULL, NULL, vbdev_lvol_shallow_copy_complete,
+				  NULL);
+	CU_ASSERT(rc == -EINVAL);
+
+	/* Successful diff copy */
+	g_lvolerrno = -1;
+	lvol_already_opened = false;
+	rc = vbdev_lvol_diff_copy(g_lvol, NULL, DEFAULT_BDEV_NAME, NULL, NULL,
+				  vbdev_lvol_shallow_copy_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvolerrno == 0);
+
 	/* Successful lvol destroy */
 	vbdev_lvol_destroy(g_lvol, lvol_store_op_complete, NULL);
 	CU_ASSERT(g_lvol == NULL);
@@ -0,0 +1,655 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk_internal/cunit.h"
+#include "spdk/env.h"
+
+#include "common/lib/ut_multithread.c"
+
+#include "bdev/readahead/vbdev_readahead.c"
+
+#include "common/lib/bdev/ut_vbdev.c"
+
+/* Smallest iobuf large buffers, which make the segments */
+#define SEG_SIZE	8192
+#define SEG_BLOCKS	(SEG_SIZE / BLOCK_SIZE)
+/* The last segment is cut short by the end of the bdev */
+#define BASE_BLOCKS	(64 * SEG_BLOCKS - SEG_BLOCKS / 2)
+#define MAX_WINDOW	8
+#define LARGE_BUFS	16
+
+static struct ut_disk g_base;
+
+/* Helpers */
+
+static struct vbdev_readahead *
+get_ra(const char *name)
+{
+	return ut_get_vbdev(name, &readahead_if);
+}
+
+static struct vbdev_cache_assoc *
+get_assoc(const char *name)
+{
+	return vbdev_cache_assoc_find(&g_ra_assocs, name);
+}
+
+static struct vbdev_readahead *
+create_ra(void)
+{
+	struct bdev_readahead_opts opts;
+
+	bdev_readahead_get_default_opts(&opts);
+	opts.max_window_size = MAX_WINDOW * SEG_SIZE;
+	CU_ASSERT(bdev_readahead_create_disk("base", "ra0", &opts) == 0);
+
+	return get_ra("ra0");
+}
+
+static int
+delete_ra(const char *name)
+{
+	g_delete_done = false;
+	bdev_readahead_delete_disk(name, delete_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_delete_done);
+
+	return g_delete_rc;
+}
+
+/* Streams live in the channels, which the tests keep open between I/Os */
+static struct ra_io_channel *
+get_channel(struct vbdev_readahead *ra, int thread)
+{
+	struct spdk_io_channel *ch;
+
+	set_thread(thread);
+	ch = spdk_get_io_channel(ra);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+	set_thread(0);
+
+	return spdk_io_channel_get_ctx(ch);
+}
+
+static void
+put_channel(struct ra_io_channel *ch, int thread)
+{
+	set_thread(thread);
+	spdk_put_io_channel(spdk_io_channel_from_ctx(ch));
+	set_thread(0);
+	poll_threads();
+}
+
+static enum spdk_bdev_io_status
+submit_io(struct vbdev_readahead *ra, int thread, enum spdk_bdev_io_type type, uint64_t lba,
+	  uint64_t num_blocks, void *buf)
+{
+	return ut_submit_io(&ra->bdev, thread, type, lba, num_blocks, buf);
+}
+
+static void
+write_blocks(struct vbdev_readahead *ra, int thread, uint64_t lba, uint64_t num_blocks,
+	     uint32_t pattern)
+{
+	uint8_t *buf;
+	uint64_t i;
+
+	buf = calloc(num_blocks, BLOCK_SIZE);
+	SPDK_CU_ASSERT_FATAL(buf != NULL);
+
+	for (i = 0; i < num_blocks; i++) {
+		fill_block(buf + i * BLOCK_SIZE, pattern + i);
+	}
+	CU_ASSERT(submit_io(ra, thread, SPDK_BDEV_IO_TYPE_WRITE, lba, num_blocks, buf) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	free(buf);
+}
+
+/* Read blocks, compare them with the base bdev and tell whether they were prefetched */
+static bool
+check_blocks(struct vbdev_readahead *ra, int thread, uint64_t lba, uint64_t num_blocks)
+{
+	struct ra_io_channel *ch = get_channel(ra, thread);
+	uint64_t hits = ch->stats.read_hits;
+	bool hit;
+	uint8_t *buf;
+
+	buf = calloc(num_blocks, BLOCK_SIZE);
+	SPDK_CU_ASSERT_FATAL(buf != NULL);
+
+	CU_ASSERT(submit_io(ra, thread, SPDK_BDEV_IO_TYPE_READ, lba, num_blocks, buf) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf, g_base.data + lba * BLOCK_SIZE, num_blocks * BLOCK_SIZE) == 0);
+
+	free(buf);
+
+	hit = ch->stats.read_hits != hits;
+	put_channel(ch, thread);
+
+	return hit;
+}
+
+static struct ra_stream *
+get_stream(struct ra_io_channel *ch, uint64_t next_block)
+{
+	uint32_t i;
+
+	for (i = 0; i < READAHEAD_STREAMS; i++) {
+		if (ch->streams[i].seq_reads != 0 && ch->streams[i].next_block == next_block) {
+			return &ch->streams[i];
+		}
+	}
+
+	return NULL;
+}
+
+static struct bdev_readahead_stats g_stats;
+static int g_stats_count;
+
+static void
+stats_cb(void *cb_arg, const char *name, const struct bdev_readahead_stats *stats)
+{
+	CU_ASSERT(strcmp(name, "ra0") == 0);
+	g_stats = *stats;
+	g_stats_count++;
+}
+
+static struct bdev_readahead_stats *
+get_stats(void)
+{
+	g_stats_count = 0;
+	CU_ASSERT(bdev_readahead_get_stats("ra0", stats_cb, NULL) == 0);
+	CU_ASSERT(g_stats_count == 1);
+
+	return &g_stats;
+}
+
+static void
+test_setup(void)
+{
+	uint64_t i;
+
+	for (i = 0; i < BASE_BLOCKS; i++) {
+		fill_block(g_base.data + i * BLOCK_SIZE, i + 1);
+	}
+	ut_disk_reset(&g_base);
+}
+
+/* Tests */
+
+static void
+test_readahead_create(void)
+{
+	struct vbdev_readahead *ra;
+	struct bdev_readahead_opts opts;
+
+	test_setup();
+
+	ra = create_ra();
+	SPDK_CU_ASSERT_FATAL(ra != NULL);
+	CU_ASSERT(ra->bdev.blockcnt == BASE_BLOCKS);
+	CU_ASSERT(ra->bdev.blocklen == BLOCK_SIZE);
+	CU_ASSERT(ra->seg_size == SEG_SIZE);
+	CU_ASSERT(ra->seg_blocks == SEG_BLOCKS);
+	CU_ASSERT(ra->num_segments == 64);
+	CU_ASSERT(ra->max_window == MAX_WINDOW);
+	CU_ASSERT(g_base.claimed);
+
+	/* The name and the base bdev are in use */
+	bdev_readahead_get_default_opts(&opts);
+	CU_ASSERT(opts.max_window_size == BDEV_READAHEAD_DEFAULT_MAX_WINDOW);
+	CU_ASSERT(bdev_readahead_create_disk("base", "ra0", &opts) == -EEXIST);
+	CU_ASSERT(bdev_readahead_create_disk("base", "ra1", &opts) == -EPERM);
+	CU_ASSERT(get_assoc("ra1") == NULL);
+
+	CU_ASSERT(delete_ra("ra0") == 0);
+	CU_ASSERT(get_ra("ra0") == NULL);
+	CU_ASSERT(get_assoc("ra0") == NULL);
+	CU_ASSERT(!g_base.claimed);
+	CU_ASSERT(delete_ra("ra0") == -ENODEV);
+
+	/* A window smaller than a segment still reads one ahead */
+	opts.max_window_size = 1;
+	CU_ASSERT(bdev_readahead_create_disk("base", "ra0", &opts) == 0);
+	ra = get_ra("ra0");
+	SPDK_CU_ASSERT_FATAL(ra != NULL);
+	CU_ASSERT(ra->max_window == 1);
+	CU_ASSERT(delete_ra("ra0") == 0);
+
+	/* Invalid options and base bdevs */
+	opts.max_window_size = 0;
+	CU_ASSERT(bdev_readahead_create_disk("base", "ra0", &opts) == -EINVAL);
+	opts.max_window_size = BDEV_READAHEAD_MAX_WINDOW + 1;
+	CU_ASSERT(bdev_readahead_create_disk("base", "ra0", &opts) == -EINVAL);
+	opts.max_window_size = BDEV_READAHEAD_DEFAULT_MAX_WINDOW;
+	g_base.bdev.md_len = 8;
+	CU_ASSERT(bdev_readahead_create_disk("base", "ra0", &opts) == -EINVAL);
+	g_base.bdev.md_len = 0;
+	g_base.bdev.blocklen = 2 * SEG_SIZE;
+	CU_ASSERT(bdev_readahead_create_disk("base", "ra0", &opts) == -EINVAL);
+	g_base.bdev.blocklen = BLOCK_SIZE;
+	CU_ASSERT(!g_base.claimed);
+	CU_ASSERT(TAILQ_EMPTY(&g_ra_assocs));
+
+	/* Creation waits for the base bdev */
+	g_base.present = false;
+	CU_ASSERT(bdev_readahead_create_disk("base", "ra0", &opts) == 0);
+	CU_ASSERT(get_ra("ra0") == NULL);
+	CU_ASSERT(get_assoc("ra0") != NULL);
+
+	g_base.present = true;
+	ut_examine_disk(&readahead_if, &g_base);
+	CU_ASSERT(get_ra("ra0") != NULL);
+	CU_ASSERT(delete_ra("ra0") == 0);
+	CU_ASSERT(get_assoc("ra0") == NULL);
+
+	/* A pending readahead bdev can be deleted */
+	g_base.present = false;
+	CU_ASSERT(bdev_readahead_create_disk("base", "ra0", &opts) == 0);
+	CU_ASSERT(delete_ra("ra0") == 0);
+	CU_ASSERT(get_assoc("ra0") == NULL);
+	g_base.present = true;
+}
+
+static void
+test_readahead_sequential(void)
+{
+	struct vbdev_readahead *ra;
+	struct ra_io_channel *ch;
+	struct bdev_readahead_stats *stats;
+	uint64_t lba;
+
+	test_setup();
+
+	ra = create_ra();
+	SPDK_CU_ASSERT_FATAL(ra != NULL);
+	ch = get_channel(ra, 1);
+
+	/* The second read detects the stream and starts prefetching the next segment */
+	CU_ASSERT(!check_blocks(ra, 1, 0, SEG_BLOCKS / 2));
+	CU_ASSERT(ch->stats.prefetch_reads == 0);
+	CU_ASSERT(!check_blocks(ra, 1, SEG_BLOCKS / 2, SEG_BLOCKS / 2));
+	CU_ASSERT(ch->stats.streams_detected == 1);
+	CU_ASSERT(ch->stats.prefetch_reads == 1);
+	CU_ASSERT(g_base.reads == 3);
+
+	/* The rest of the stream is served from prefetched segments, one segment ahead */
+	for (lba = SEG_BLOCKS; lba < 16 * SEG_BLOCKS; lba += SEG_BLOCKS / 2) {
+		CU_ASSERT(check_blocks(ra, 1, lba, SEG_BLOCKS / 2));
+	}
+	CU_ASSERT(ch->stats.read_hits == 30);
+	CU_ASSERT(ch->stats.read_misses == 2);
+	CU_ASSERT(ch->stats.prefetch_reads == 16);
+	CU_ASSERT(ch->stats.prefetch_bytes == 16 * SEG_SIZE);
+	CU_ASSERT(ch->stats.prefetch_unused_bytes == 0);
+	CU_ASSERT(g_base.reads == 18);
+	SPDK_CU_ASSERT_FATAL(get_stream(ch, 16 * SEG_BLOCKS) != NULL);
+	CU_ASSERT(get_stream(ch, 16 * SEG_BLOCKS)->window == 1);
+
+	/* Random reads on another channel start no prefetch */
+	CU_ASSERT(!check_blocks(ra, 0, 5 * SEG_BLOCKS, 1));
+	CU_ASSERT(!check_blocks(ra, 0, 40 * SEG_BLOCKS, 3));
+	CU_ASSERT(!check_blocks(ra, 0, 20 * SEG_BLOCKS + 1, 2));
+	CU_ASSERT(g_base.reads == 21);
+
+	/* A stream running into the end of the bdev, whose last segment is shorter */
+	CU_ASSERT(!check_blocks(ra, 1, BASE_BLOCKS - 3 * SEG_BLOCKS / 2, SEG_BLOCKS / 2));
+	CU_ASSERT(!check_blocks(ra, 1, BASE_BLOCKS - SEG_BLOCKS, SEG_BLOCKS / 2));
+	CU_ASSERT(ch->stats.prefetch_reads == 17);
+	CU_ASSERT(ch->stats.prefetch_bytes == 16 * SEG_SIZE + SEG_SIZE / 2);
+	CU_ASSERT(check_blocks(ra, 1, BASE_BLOCKS - SEG_BLOCKS / 2, SEG_BLOCKS / 2));
+	CU_ASSERT(ch->stats.prefetch_reads == 17);
+	CU_ASSERT(TAILQ_EMPTY(&get_stream(ch, BASE_BLOCKS)->segments));
+
+	/* Streams are tracked on each channel */
+	CU_ASSERT(!check_blocks(ra, 0, 16 * SEG_BLOCKS, SEG_BLOCKS));
+	CU_ASSERT(check_blocks(ra, 1, 16 * SEG_BLOCKS, SEG_BLOCKS));
+
+	stats = get_stats();
+	CU_ASSERT(stats->streams_detected == 2);
+
+	put_channel(ch, 1);
+	CU_ASSERT(delete_ra("ra0") == 0);
+}
+
+static void
+test_readahead_window(void)
+{
+	struct vbdev_readahead *ra;
+	struct ra_io_channel *ch;
+	struct ra_stream *s;
+	struct spdk_bdev_io *bdev_io;
+	uint8_t buf[SEG_SIZE];
+
+	test_setup();
+
+	ra = create_ra();
+	SPDK_CU_ASSERT_FATAL(ra != NULL);
+	ch = get_channel(ra, 1);
+	g_base.hold = true;
+
+	bdev_io = ut_start_io(&ra->bdev, 1, SPDK_BDEV_IO_TYPE_READ, 0, SEG_BLOCKS, buf);
+	ut_release_ios();
+	CU_ASSERT(ut_finish_io(bdev_io) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	bdev_io = ut_start_io(&ra->bdev, 1, SPDK_BDEV_IO_TYPE_READ, SEG_BLOCKS, SEG_BLOCKS, buf);
+	ut_release_ios();
+	CU_ASSERT(ut_finish_io(bdev_io) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	s = get_stream(ch, 2 * SEG_BLOCKS);
+	SPDK_CU_ASSERT_FATAL(s != NULL);
+	CU_ASSERT(s->prefetch_next == 3);
+
+	/* Served from the prefetched segment right away */
+	g_io_done = 0;
+	bdev_io = ut_start_io(&ra->bdev, 1, SPDK_BDEV_IO_TYPE_READ, 2 * SEG_BLOCKS, SEG_BLOCKS, buf);
+	CU_ASSERT(g_io_done == 1);
+	CU_ASSERT(ut_finish_io(bdev_io) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf, g_base.data + 2 * SEG_SIZE, SEG_SIZE) == 0);
+	CU_ASSERT(s->num_pending == 1);
+
+	/* Waiting for the prefetch doubles the window */
+	g_io_done = 0;
+	bdev_io = ut_start_io(&ra->bdev, 1, SPDK_BDEV_IO_TYPE_READ, 3 * SEG_BLOCKS, SEG_BLOCKS, buf);
+	CU_ASSERT(g_io_done == 0);
+	CU_ASSERT(s->window == 2);
+	CU_ASSERT(s->num_pending == 3);
+	CU_ASSERT(s->prefetch_next == 6);
+	ut_release_ios();
+	CU_ASSERT(g_io_done == 1);
+	CU_ASSERT(ut_finish_io(bdev_io) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf, g_base.data + 3 * SEG_SIZE, SEG_SIZE) == 0);
+	CU_ASSERT(ch->stats.read_hits == 2);
+	CU_ASSERT(ch->stats.read_waits == 1);
+
+	bdev_io = ut_start_io(&ra->bdev, 1, SPDK_BDEV_IO_TYPE_READ, 4 * SEG_BLOCKS, SEG_BLOCKS, buf);
+	CU_ASSERT(ut_finish_io(bdev_io) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	bdev_io = ut_start_io(&ra->bdev, 1, SPDK_BDEV_IO_TYPE_READ, 5 * SEG_BLOCKS, SEG_BLOCKS, buf);
+	CU_ASSERT(ut_finish_io(bdev_io) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(ch->stats.read_waits == 1);
+	CU_ASSERT(s->prefetch_next == 8);
+
+	/* Waits grow the window up to its maximum */
+	g_io_done = 0;
+	bdev_io = ut_start_io(&ra->bdev, 1, SPDK_BDEV_IO_TYPE_READ, 6 * SEG_BLOCKS, SEG_BLOCKS, buf);
+	CU_ASSERT(s->window == 4);
+	ut_release_ios();
+	CU_ASSERT(ut_finish_io(bdev_io) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(s->prefetch_next == 11);
+	bdev_io = ut_start_io(&ra->bdev, 1, SPDK_BDEV_IO_TYPE_READ, 7 * SEG_BLOCKS, SEG_BLOCKS, buf);
+	CU_ASSERT(ut_finish_io(bdev_io) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	s->window = MAX_WINDOW;
+	bdev_io = ut_start_io(&ra->bdev, 1, SPDK_BDEV_IO_TYPE_READ, 8 * SEG_BLOCKS, SEG_BLOCKS, buf);
+	CU_ASSERT(s->window == MAX_WINDOW);
+	CU_ASSERT(s->prefetch_next == 9 + MAX_WINDOW);
+	ut_release_ios();
+	CU_ASSERT(ut_finish_io(bdev_io) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf, g_base.data + 8 * SEG_SIZE, SEG_SIZE) == 0);
+	CU_ASSERT(ch->stats.read_waits == 2);
+	CU_ASSERT(ch->stats.read_hits == 7);
+
+	/* Skipping prefetched segments halves the window for each of them */
+	CU_ASSERT(check_blocks(ra, 1, 12 * SEG_BLOCKS, SEG_BLOCKS));
+	CU_ASSERT(s->window == MAX_WINDOW / 8);
+	CU_ASSERT(ch->stats.prefetch_unused_bytes == 3 * SEG_SIZE);
+	CU_ASSERT(s->prefetch_next == 17);
+
+	/* Segments of idle streams are released */
+	spdk_delay_us(READAHEAD_IDLE_US);
+	poll_threads();
+	CU_ASSERT(!TAILQ_EMPTY(&s->segments));
+	spdk_delay_us(READAHEAD_IDLE_US);
+	poll_threads();
+	CU_ASSERT(TAILQ_EMPTY(&s->segments));
+	CU_ASSERT(ch->stats.prefetch_unused_bytes == 7 * SEG_SIZE);
+	CU_ASSERT(ch->stats.prefetch_reads * SEG_SIZE == ch->stats.prefetch_bytes);
+
+	g_base.hold = false;
+	put_channel(ch, 1);
+	CU_ASSERT(delete_ra("ra0") == 0);
+}
+
+static void
+test_readahead_write(void)
+{
+	struct vbdev_readahead *ra;
+	struct ra_io_channel *ch;
+	struct spdk_bdev_io *bdev_io, *unmap_io;
+	uint8_t buf[SEG_SIZE];
+
+	test_setup();
+
+	ra = create_ra();
+	SPDK_CU_ASSERT_FATAL(ra != NULL);
+	ch = get_channel(ra, 1);
+
+	/* A write from another channel invalidates the prefetched segment */
+	CU_ASSERT(!check_blocks(ra, 1, 0, SEG_BLOCKS));
+	CU_ASSERT(!check_blocks(ra, 1, SEG_BLOCKS, SEG_BLOCKS));
+	write_blocks(ra, 0, 2 * SEG_BLOCKS + 3, 2, 1000);
+	CU_ASSERT(!check_blocks(ra, 1, 2 * SEG_BLOCKS, SEG_BLOCKS));
+	CU_ASSERT(ch->stats.invalidations == 1);
+	CU_ASSERT(check_blocks(ra, 1, 3 * SEG_BLOCKS, SEG_BLOCKS));
+
+	/* Data prefetched before an unmap completed is not used after it */
+	g_base.hold = true;
+	g_io_done = 0;
+	bdev_io = ut_start_io(&ra->bdev, 1, SPDK_BDEV_IO_TYPE_READ, 4 * SEG_BLOCKS, SEG_BLOCKS, buf);
+	CU_ASSERT(g_io_done == 1);
+	CU_ASSERT(ch->stats.prefetch_reads == 4);
+	unmap_io = ut_start_io(&ra->bdev, 0, SPDK_BDEV_IO_TYPE_UNMAP, 5 * SEG_BLOCKS, 1, NULL);
+	ut_release_ios();
+	CU_ASSERT(g_io_done == 2);
+	CU_ASSERT(ut_finish_io(bdev_io) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(ut_finish_io(unmap_io) == SPDK_BDEV_IO_STATUS_SUCCESS);
+	g_base.hold = false;
+	CU_ASSERT(!check_blocks(ra, 1, 5 * SEG_BLOCKS, SEG_BLOCKS));
+	CU_ASSERT(ch->stats.invalidations == 2);
+	CU_ASSERT(check_blocks(ra, 1, 6 * SEG_BLOCKS, SEG_BLOCKS));
+
+	/* Other I/O types are passed through */
+	CU_ASSERT(submit_io(ra, 0, SPDK_BDEV_IO_TYPE_WRITE_ZEROES, 0, SEG_BLOCKS, NULL) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(submit_io(ra, 0, SPDK_BDEV_IO_TYPE_FLUSH, 0, BASE_BLOCKS, NULL) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(submit_io(ra, 0, SPDK_BDEV_IO_TYPE_RESET, 0, 0, NULL) ==
+		  SPDK_BDEV_IO_STATUS_SUCCESS);
+	g_base.enomem_count = 1;
+	CU_ASSERT(!check_blocks(ra, 1, 0, SEG_BLOCKS));
+	CU_ASSERT(g_base.enomem_count == 0);
+
+	put_channel(ch, 1);
+	CU_ASSERT(delete_ra("ra0") == 0);
+}
+
+static void
+test_readahead_base_io(void)
+{
+	struct vbdev_readahead *ra;
+	struct ra_io_channel *ch;
+	uint8_t buf[2 * BLOCK_SIZE];
+
+	test_setup();
+
+	ra = create_ra();
+	SPDK_CU_ASSERT_FATAL(ra != NULL);
+	ch = get_channel(ra, 1);
+
+	/* A failed write still invalidates the prefetched segment, its blocks are unknown */
+	CU_ASSERT(!check_blocks(ra, 1, 0, SEG_BLOCKS));
+	CU_ASSERT(!check_blocks(ra, 1, SEG_BLOCKS, SEG_BLOCKS));
+	g_base.fail_write_lba = 2 * SEG_BLOCKS + 4;
+	fill_block(buf, 2000);
+	fill_block(buf + BLOCK_SIZE, 2001);
+	CU_ASSERT(submit_io(ra, 0, SPDK_BDEV_IO_TYPE_WRITE, 2 * SEG_BLOCKS + 3, 2, buf) ==
+		  SPDK_BDEV_IO_STATUS_FAILED);
+	g_base.fail_write_lba = UINT64_MAX;
+	CU_ASSERT(!check_blocks(ra, 1, 2 * SEG_BLOCKS, SEG_BLOCKS));
+	CU_ASSERT(ch->stats.invalidations == 1);
+	CU_ASSERT(check_blocks(ra, 1, 3 * SEG_BLOCKS, SEG_BLOCKS));
+
+	/* Writes retried after ENOMEM invalidate once they are done */
+	g_base.enomem_count = 1;
+	write_blocks(ra, 0, 4 * SEG_BLOCKS, 1, 3000);
+	CU_ASSERT(g_base.enomem_count == 0);
+	CU_ASSERT(!check_blocks(ra, 1, 4 * SEG_BLOCKS, SEG_BLOCKS));
+	CU_ASSERT(ch->stats.invalidations == 2);
+
+	put_channel(ch, 1);
+	CU_ASSERT(delete_ra("ra0") == 0);
+}
+
+static void
+test_readahead_nobuf(void)
+{
+	struct vbdev_readahead *ra;
+	struct ra_io_channel *ch;
+	struct spdk_iobuf_channel iobuf;
+	void *bufs[LARGE_BUFS + 1];
+	int i, num_bufs = 0;
+
+	test_setup();
+
+	ra = create_ra();
+	SPDK_CU_ASSERT_FATAL(ra != NULL);
+	ch = get_channel(ra, 1);
+
+	/* Prefetching stops when the iobuf pool is empty, reads still go to the base bdev */
+	set_thread(1);
+	CU_ASSERT(spdk_iobuf_channel_init(&iobuf, "ut", 0, 0) == 0);
+	while (num_bufs < (int)SPDK_COUNTOF(bufs) &&
+	       (bufs[num_bufs] = spdk_iobuf_get(&iobuf, SEG_SIZE, NULL, NULL)) != NULL) {
+		num_bufs++;
+	}
+	set_thread(0);
+	CU_ASSERT(num_bufs == LARGE_BUFS);
+
+	CU_ASSERT(!check_blocks(ra, 1, 0, SEG_BLOCKS));
+	CU_ASSERT(!check_blocks(ra, 1, SEG_BLOCKS, SEG_BLOCKS));
+	CU_ASSERT(!check_blocks(ra, 1, 2 * SEG_BLOCKS, SEG_BLOCKS));
+	CU_ASSERT(ch->stats.prefetch_nobuf == 2);
+	CU_ASSERT(ch->stats.prefetch_reads == 0);
+
+	set_thread(1);
+	for (i = 0; i < num_bufs; i++) {
+		spdk_iobuf_put(&iobuf, bufs[i], SEG_SIZE);
+	}
+	spdk_iobuf_channel_fini(&iobuf);
+	set_thread(0);
+
+	CU_ASSERT(!check_blocks(ra, 1, 3 * SEG_BLOCKS, SEG_BLOCKS));
+	CU_ASSERT(ch->stats.prefetch_reads == 1);
+	CU_ASSERT(check_blocks(ra, 1, 4 * SEG_BLOCKS, SEG_BLOCKS));
+
+	put_channel(ch, 1);
+	CU_ASSERT(delete_ra("ra0") == 0);
+}
+
+static void
+test_readahead_stats(void)
+{
+	struct vbdev_readahead *ra;
+	struct ra_io_channel *ch;
+	struct bdev_readahead_stats *stats;
+
+	test_setup();
+
+	g_stats_count = 0;
+	CU_ASSERT(bdev_readahead_get_stats(NULL, stats_cb, NULL) == 0);
+	CU_ASSERT(g_stats_count == 0);
+	CU_ASSERT(bdev_readahead_get_stats("ra0", stats_cb, NULL) == -ENODEV);
+
+	ra = create_ra();
+	SPDK_CU_ASSERT_FATAL(ra != NULL);
+	ch = get_channel(ra, 1);
+
+	CU_ASSERT(!check_blocks(ra, 1, 0, SEG_BLOCKS));
+	CU_ASSERT(!check_blocks(ra, 1, SEG_BLOCKS, SEG_BLOCKS));
+	CU_ASSERT(check_blocks(ra, 1, 2 * SEG_BLOCKS, SEG_BLOCKS));
+	CU_ASSERT(!check_blocks(ra, 0, 0, SEG_BLOCKS));
+
+	/* Counters of all channels, including released ones */
+	put_channel(ch, 1);
+	stats = get_stats();
+	CU_ASSERT(stats->read_hits == 1);
+	CU_ASSERT(stats->read_misses == 3);
+	CU_ASSERT(stats->streams_detected == 1);
+	CU_ASSERT(stats->prefetch_reads == 2);
+	CU_ASSERT(stats->prefetch_bytes == 2 * SEG_SIZE);
+	CU_ASSERT(stats->prefetch_unused_bytes == SEG_SIZE);
+	CU_ASSERT(stats->invalidations == 0);
+
+	g_stats_count = 0;
+	CU_ASSERT(bdev_readahead_get_stats(NULL, stats_cb, NULL) == 0);
+	CU_ASSERT(g_stats_count == 1);
+	CU_ASSERT(bdev_readahead_get_stats("ra1", stats_cb, NULL) == -ENODEV);
+
+	CU_ASSERT(delete_ra("ra0") == 0);
+}
+
+static int
+test_suite_init(void)
+{
+	struct spdk_iobuf_opts opts;
+
+	allocate_threads(2);
+	set_thread(0);
+
+	if (ut_disk_init(&g_base, "base", BASE_BLOCKS) != 0) {
+		return -ENOMEM;
+	}
+
+	spdk_iobuf_get_opts(&opts, sizeof(opts));
+	opts.small_bufsize = SEG_SIZE / 2;
+	opts.large_bufsize = SEG_SIZE;
+	opts.large_pool_count = LARGE_BUFS;
+	if (spdk_iobuf_set_opts(&opts) != 0 || spdk_iobuf_initialize() != 0 ||
+	    vbdev_readahead_init() != 0 || spdk_iobuf_register_module("ut") != 0) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void
+iobuf_finish_cb(void *cb_arg)
+{
+}
+
+static int
+test_suite_fini(void)
+{
+	spdk_iobuf_finish(iobuf_finish_cb, NULL);
+	ut_disk_fini(&g_base);
+	poll_threads();
+	free_threads();
+
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("readahead", test_suite_init, test_suite_fini);
+
+	CU_ADD_TEST(suite, test_readahead_create);
+	CU_ADD_TEST(suite, test_readahead_sequential);
+	CU_ADD_TEST(suite, test_readahead_window);
+	CU_ADD_TEST(suite, test_readahead_write);
+	CU_ADD_TEST(suite, test_readahead_base_io);
+	CU_ADD_TEST(suite, test_readahead_nobuf);
+	CU_ADD_TEST(suite, test_readahead_stats);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+
+	CU_cleanup_registry();
+
+	return num_failures;
+}
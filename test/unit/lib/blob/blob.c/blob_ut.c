@@ -1203,6 +1203,170 @@ blob_inflate(void)
 	_blob_inflate(true);
 }
 
+static uint64_t g_inflate_copied_clusters;
+static uint64_t g_inflate_total_clusters;
+
+static void
+blob_inflate_status_cb(uint64_t copied_clusters, uint64_t total_clusters, void *cb_arg)
+{
+	g_inflate_copied_clusters = copied_clusters;
+	g_inflate_total_clusters = total_clusters;
+}
+
+static void
+blob_inflate_throttled(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob_opts opts;
+	struct spdk_bs_inflate_opts inflate_opts;
+	struct spdk_blob *blob;
+	spdk_blob_id blobid, snapshotid;
+	struct spdk_io_channel *channel;
+	uint64_t io_units_per_cluster, copied;
+	uint8_t payload[DEV_BUFFER_BLOCKLEN];
+	const void *value;
+	size_t value_len;
+	uint64_t i;
+	int rc;
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
+
+	/* Create a thin blob with 10 clusters and mark the first io_unit of each cluster */
+	ut_spdk_blob_opts_init(&opts);
+	opts.num_clusters = 10;
+	opts.thin_provision = true;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+	io_units_per_cluster = bs_io_units_per_cluster(blob);
+
+	for (i = 0; i < 10; i++) {
+		memset(payload, 0xA0 + i, sizeof(payload));
+		spdk_blob_io_write(blob, channel, payload, i * io_units_per_cluster, 1,
+				   blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	snapshotid = g_blobid;
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == 0);
+
+	/* Nothing is running yet */
+	rc = spdk_bs_inflate_blob_stop(bs, blobid);
+	CU_ASSERT(rc == -ENOENT);
+
+	/* Invalid number of clusters in flight */
+	spdk_bs_inflate_opts_init(&inflate_opts, sizeof(inflate_opts));
+	inflate_opts.clusters_in_flight = 0;
+	spdk_bs_inflate_blob_ext(bs, channel, blobid, &inflate_opts, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EINVAL);
+
+	/* 1) Limit the inflate to one cluster per millisecond */
+	spdk_bs_inflate_opts_init(&inflate_opts, sizeof(inflate_opts));
+	inflate_opts.clusters_in_flight = 2;
+	inflate_opts.max_clusters_per_sec = 1000;
+	inflate_opts.status_cb_fn = blob_inflate_status_cb;
+	g_inflate_copied_clusters = 0;
+	g_inflate_total_clusters = 0;
+	g_bserrno = 1;
+	spdk_bs_inflate_blob_ext(bs, channel, blobid, &inflate_opts, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 1);
+	CU_ASSERT(g_inflate_copied_clusters == 0);
+
+	for (i = 1; i <= 4; i++) {
+		spdk_delay_us(1000);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 1);
+		CU_ASSERT(g_inflate_copied_clusters == i);
+		CU_ASSERT(g_inflate_total_clusters == 10);
+	}
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == 4);
+
+	/* Another operation on the same blob is refused while the inflate runs */
+	spdk_bs_inflate_blob(bs, channel, blobid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EBUSY);
+	g_bserrno = 1;
+
+	/* 2) Stop it and make sure the progress is persisted */
+	rc = spdk_bs_inflate_blob_stop(bs, blobid);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -ECANCELED);
+	CU_ASSERT(spdk_blob_is_thin_provisioned(blob) == true);
+	CU_ASSERT(spdk_blob_get_parent_snapshot(bs, blobid) == snapshotid);
+	copied = g_inflate_copied_clusters;
+	CU_ASSERT(copied == 4);
+
+	rc = blob_get_xattr_value(blob, BLOB_INFLATE_PROGRESS, &value, &value_len, true);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(value_len == sizeof(struct blob_inflate_progress));
+
+	rc = spdk_bs_inflate_blob_stop(bs, blobid);
+	CU_ASSERT(rc == -ENOENT);
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	ut_bs_reload(&bs, NULL);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == copied);
+
+	/* 3) Resume without limits, progress continues from the persisted state */
+	spdk_bs_inflate_opts_init(&inflate_opts, sizeof(inflate_opts));
+	inflate_opts.clusters_in_flight = 4;
+	inflate_opts.status_cb_fn = blob_inflate_status_cb;
+	g_inflate_copied_clusters = 0;
+	g_inflate_total_clusters = 0;
+	spdk_bs_inflate_blob_ext(bs, channel, blobid, &inflate_opts, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_inflate_copied_clusters == 10);
+	CU_ASSERT(g_inflate_total_clusters == 10);
+	CU_ASSERT(spdk_blob_is_thin_provisioned(blob) == false);
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == 10);
+	CU_ASSERT(spdk_blob_get_parent_snapshot(bs, blobid) == SPDK_BLOBID_INVALID);
+	rc = blob_get_xattr_value(blob, BLOB_INFLATE_PROGRESS, &value, &value_len, true);
+	CU_ASSERT(rc == -ENOENT);
+
+	/* Data copied by both runs is intact */
+	for (i = 0; i < 10; i++) {
+		memset(payload, 0, sizeof(payload));
+		spdk_blob_io_read(blob, channel, payload, i * io_units_per_cluster, 1,
+				  blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		CU_ASSERT(payload[0] == 0xA0 + i);
+	}
+
+	spdk_bs_delete_blob(bs, snapshotid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	ut_blob_close_and_delete(bs, blob);
+}
+
 static void
 blob_delete(void)
 {
@@ -4550,7 +4714,7 @@ blob_insert_cluster_msg_test(void)
 	CU_ASSERT(blob->active.clusters[cluster_num] == 0);
 	spdk_spin_unlock(&bs->used_lock);
 
-	blob_insert_cluster_on_md_thread(blob, cluster_num, new_cluster, extent_page, &md.page,
+	blob_insert_cluster_on_md_thread(blob, cluster_num, new_cluster, &extent_page, &md.page,
 					 blob_op_complete, NULL);
 	poll_threads();
 
@@ -4573,6 +4737,158 @@ blob_insert_cluster_msg_test(void)
 	ut_blob_close_and_delete(bs, blob);
 }
 
+static void
+blob_insert_cluster_batch_test(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob;
+	struct spdk_blob_opts opts;
+	struct {
+		struct spdk_blob_md_page page;
+		uint8_t pad[DEV_MAX_PHYS_BLOCKLEN - sizeof(struct spdk_blob_md_page)];
+	} md[6] = {};
+	uint64_t new_cluster[6] = {};
+	uint32_t extent_page[6] = {};
+	uint32_t cluster_num[6] = { 0, 1, 2, 3, 2, 4 };
+	int rc[6];
+	uint64_t free_clusters, write_bytes, expected_bytes;
+	uint32_t free_md_pages;
+	int i;
+
+	free_clusters = spdk_bs_free_cluster_count(bs);
+	free_md_pages = spdk_bit_array_count_clear(bs->used_md_pages);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 8;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+
+	/* Allocate clusters as if writes on different threads hit them at the same time.
+	 * The fifth one races with the third for the same cluster index. */
+	spdk_spin_lock(&bs->used_lock);
+	for (i = 0; i < 6; i++) {
+		CU_ASSERT(bs_allocate_cluster(blob, cluster_num[i], &new_cluster[i],
+					      &extent_page[i], false) == 0);
+	}
+	spdk_spin_unlock(&bs->used_lock);
+
+	write_bytes = g_dev_write_bytes;
+	for (i = 0; i < 6; i++) {
+		rc[i] = 1;
+		blob_insert_cluster_on_md_thread(blob, cluster_num[i], new_cluster[i],
+						 &extent_page[i], &md[i].page,
+						 blob_op_complete, &rc[i]);
+	}
+	poll_threads();
+
+	for (i = 0; i < 6; i++) {
+		CU_ASSERT(rc[i] == (i == 4 ? -EEXIST : 0));
+		CU_ASSERT(blob->active.clusters[cluster_num[i]] != 0);
+	}
+	CU_ASSERT(blob->active.clusters[2] == bs_cluster_to_lba(bs, new_cluster[2]));
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == 5);
+
+	/* Release what the caller of the failed insert would */
+	spdk_spin_lock(&bs->used_lock);
+	bs_release_cluster(bs, new_cluster[4]);
+	if (extent_page[4] != 0) {
+		bs_release_md_page(bs, extent_page[4]);
+	}
+	spdk_spin_unlock(&bs->used_lock);
+	CU_ASSERT(free_clusters - 5 == spdk_bs_free_cluster_count(bs));
+
+	if (g_use_extent_table) {
+		/* The first insert claims the extent page and syncs the blob md. The inserts
+		 * arriving meanwhile are all persisted with a single extent page write. */
+		expected_bytes = 3 * spdk_bs_get_page_size(bs);
+		CU_ASSERT(g_dev_write_bytes - write_bytes == expected_bytes);
+		/* blob use 1 mdpage, cluster mapping use 1 mdpage */
+		CU_ASSERT(free_md_pages - 2 == spdk_bit_array_count_clear(bs->used_md_pages));
+	}
+
+	ut_blob_close_and_delete(bs, blob);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(free_md_pages == spdk_bit_array_count_clear(bs->used_md_pages));
+}
+
+static void
+blob_insert_cluster_batch_fail(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob;
+	struct spdk_blob_opts opts;
+	struct spdk_power_failure_thresholds thresholds = {};
+	struct {
+		struct spdk_blob_md_page page;
+		uint8_t pad[DEV_MAX_PHYS_BLOCKLEN - sizeof(struct spdk_blob_md_page)];
+	} md[5] = {};
+	uint64_t new_cluster[5] = {};
+	uint32_t extent_page[5] = {};
+	int rc[5];
+	uint64_t free_clusters;
+	uint32_t free_md_pages;
+	int i;
+
+	/* Batches are only formed on extent pages */
+	if (!g_use_extent_table) {
+		return;
+	}
+
+	free_clusters = spdk_bs_free_cluster_count(bs);
+	free_md_pages = spdk_bit_array_count_clear(bs->used_md_pages);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 8;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+
+	/* Each allocation claims an extent page, as none is in the extent table yet */
+	spdk_spin_lock(&bs->used_lock);
+	for (i = 0; i < 5; i++) {
+		CU_ASSERT(bs_allocate_cluster(blob, i, &new_cluster[i], &extent_page[i], false) == 0);
+		CU_ASSERT(extent_page[i] != 0);
+	}
+	spdk_spin_unlock(&bs->used_lock);
+
+	/* The first insert records its extent page in the extent table */
+	rc[0] = 1;
+	blob_insert_cluster_on_md_thread(blob, 0, new_cluster[0], &extent_page[0], &md[0].page,
+					 blob_op_complete, &rc[0]);
+	poll_threads();
+	CU_ASSERT(rc[0] == 0);
+	CU_ASSERT(extent_page[0] == 0);
+
+	/* The second insert is in progress when the other ones arrive. The third one waits
+	 * and the last two join it. All extent page writes fail. */
+	thresholds.write_threshold = 1;
+	dev_set_power_failure_thresholds(thresholds);
+	for (i = 1; i < 5; i++) {
+		rc[i] = 1;
+		blob_insert_cluster_on_md_thread(blob, i, new_cluster[i], &extent_page[i],
+						 &md[i].page, blob_op_complete, &rc[i]);
+	}
+	poll_threads();
+	dev_reset_power_failure_event();
+
+	/* The extra extent pages were released by the inserts, their callers must only
+	 * release the clusters */
+	spdk_spin_lock(&bs->used_lock);
+	for (i = 1; i < 5; i++) {
+		CU_ASSERT(rc[i] == -EIO);
+		CU_ASSERT(extent_page[i] == 0);
+		bs_release_cluster(bs, new_cluster[i]);
+	}
+	spdk_spin_unlock(&bs->used_lock);
+	/* blob use 1 mdpage, cluster mapping use 1 mdpage */
+	CU_ASSERT(free_md_pages - 2 == spdk_bit_array_count_clear(bs->used_md_pages));
+
+	ut_blob_close_and_delete(bs, blob);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(free_md_pages == spdk_bit_array_count_clear(bs->used_md_pages));
+}
+
 static void
 blob_thin_prov_rw(void)
 {
@@ -5429,9 +5745,189 @@ blob_thin_prov_update_extpage_ordered(void)
 
 	spdk_bs_free_io_channel(channel1);
 	set_thread(0);
-	spdk_bs_free_io_channel(channel0);
-	ut_blob_close_and_delete(bs, blob);
+	spdk_bs_free_io_channel(channel0);
+	ut_blob_close_and_delete(bs, blob);
+	poll_threads();
+}
+
+static void
+blob_thin_prov_cluster_pool(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob;
+	struct spdk_blob_opts opts;
+	struct spdk_bs_opts bs_opts;
+	struct spdk_io_channel *channel0, *channel1;
+	struct spdk_bs_channel *bs_channel1;
+	spdk_blob_id blobid;
+	uint64_t free_clusters, io_units_per_cluster;
+	uint8_t payload[BLOCKLEN] = {};
+
+	/* Reload the blobstore with cluster pools of 4 clusters per channel */
+	spdk_bs_opts_init(&bs_opts, sizeof(bs_opts));
+	bs_opts.channel_cluster_pool_size = 4;
+	ut_bs_reload(&bs, &bs_opts);
+	g_bs = bs;
+
+	free_clusters = spdk_bs_free_cluster_count(bs);
+	io_units_per_cluster = bs->io_units_per_cluster;
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 10;
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+
+	set_thread(1);
+	channel1 = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel1 != NULL);
+	bs_channel1 = spdk_io_channel_get_ctx(channel1);
+
+	/* The first allocation claims from the blobstore and fills the pool afterwards */
+	spdk_blob_io_write(blob, channel1, payload, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(bs_channel1->cluster_pool_count == 4);
+	CU_ASSERT(bs->num_pooled_clusters == 4);
+	/* Pooled clusters are still reported as free */
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 1);
+
+	/* Next allocations are served by the pool, which is refilled once it is half empty */
+	spdk_blob_io_write(blob, channel1, payload, io_units_per_cluster, 1, blob_op_complete,
+			   NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(bs_channel1->cluster_pool_count == 3);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 2);
+
+	spdk_blob_io_write(blob, channel1, payload, 2 * io_units_per_cluster, 1, blob_op_complete,
+			   NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(bs_channel1->cluster_pool_count == 4);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 3);
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == 3);
+
+	/* Destroying the channel returns its pool */
+	spdk_bs_free_io_channel(channel1);
+	poll_threads();
+	CU_ASSERT(bs->num_pooled_clusters == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 3);
+
+	/* Leave clusters in the pool of the channel used for metadata as well. They must not
+	 * be persisted as used on unload. */
+	set_thread(0);
+	channel0 = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel0 != NULL);
+	spdk_blob_io_write(blob, channel0, payload, 3 * io_units_per_cluster, 1, blob_op_complete,
+			   NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 4);
+	spdk_bs_free_io_channel(channel0);
+	poll_threads();
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	ut_bs_reload(&bs, &bs_opts);
+	g_bs = bs;
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 4);
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == 4);
+
+	ut_blob_close_and_delete(bs, blob);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters);
+}
+
+static void
+blob_thin_prov_cluster_pool_reclaim(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob, *thick_blob;
+	struct spdk_blob_opts opts;
+	struct spdk_bs_opts bs_opts;
+	struct spdk_io_channel *channel0, *channel1;
+	struct spdk_bs_channel *bs_channel1;
+	uint64_t free_clusters, io_units_per_cluster;
+	uint8_t payload[BLOCKLEN] = {};
+
+	spdk_bs_opts_init(&bs_opts, sizeof(bs_opts));
+	bs_opts.channel_cluster_pool_size = 4;
+	ut_bs_reload(&bs, &bs_opts);
+	g_bs = bs;
+
+	free_clusters = spdk_bs_free_cluster_count(bs);
+	io_units_per_cluster = bs->io_units_per_cluster;
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 10;
+	blob = ut_blob_create_and_open(bs, &opts);
+
+	set_thread(1);
+	channel1 = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel1 != NULL);
+	bs_channel1 = spdk_io_channel_get_ctx(channel1);
+
+	spdk_blob_io_write(blob, channel1, payload, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(bs_channel1->cluster_pool_count == 4);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 1);
+
+	/* Use up every cluster that is not pooled */
+	set_thread(0);
+	ut_spdk_blob_opts_init(&opts);
+	opts.num_clusters = free_clusters - 1 - 4;
+	thick_blob = ut_blob_create_and_open(bs, &opts);
+	CU_ASSERT(bs->num_free_clusters == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == 4);
+
+	/* A channel without a pool of its own takes a cluster from the pool of channel1 */
+	channel0 = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel0 != NULL);
+	spdk_blob_io_write(blob, channel0, payload, io_units_per_cluster, 1, blob_op_complete,
+			   NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(bs_channel1->cluster_pool_count == 3);
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == 2);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == 3);
+
+	/* Resizing a thick provisioned blob reclaims the remaining pooled clusters */
+	spdk_blob_resize(thick_blob, free_clusters - 1 - 4 + 3, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(thick_blob) == free_clusters - 1 - 4 + 3);
+	CU_ASSERT(bs_channel1->cluster_pool_count == 0);
+	CU_ASSERT(bs->num_pooled_clusters == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == 0);
+
+	spdk_blob_resize(thick_blob, free_clusters - 1 - 4 + 4, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -ENOSPC);
+
+	spdk_blob_io_write(blob, channel0, payload, 2 * io_units_per_cluster, 1, blob_op_complete,
+			   NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -ENOSPC);
+
+	spdk_bs_free_io_channel(channel0);
+	set_thread(1);
+	spdk_bs_free_io_channel(channel1);
+	set_thread(0);
 	poll_threads();
+
+	ut_blob_close_and_delete(bs, thick_blob);
+	ut_blob_close_and_delete(bs, blob);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters);
 }
 
 static void
@@ -5810,6 +6306,218 @@ blob_snapshot_rw_iov(void)
 	ut_blob_close_and_delete(bs, snapshot);
 }
 
+static void
+blob_snapshot_chain_flat_map(void)
+{
+	static const uint8_t zero[BLOCKLEN] = { 0 };
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob, *snapshot[4];
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	spdk_blob_id blobid;
+	uint64_t io_units_per_cluster;
+	uint8_t payload_read[BLOCKLEN];
+	uint8_t payload_write[BLOCKLEN];
+	struct iovec iov;
+	int i;
+
+	io_units_per_cluster = spdk_bs_get_cluster_size(bs) / spdk_bs_get_io_unit_size(bs);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 5;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+
+	/* Build a chain of three snapshots, each of them owning a different cluster */
+	for (i = 0; i < 3; i++) {
+		memset(payload_write, 0x11 * (i + 1), sizeof(payload_write));
+		spdk_blob_io_write(blob, channel, payload_write, i * io_units_per_cluster, 1,
+				   blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+
+		spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+
+		spdk_bs_open_blob(bs, g_blobid, blob_op_with_handle_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+		snapshot[i] = g_blob;
+	}
+	CU_ASSERT(blob->flat_map == NULL);
+
+	/* Reads of the clone resolve each cluster to the snapshot that owns it */
+	for (i = 0; i < 3; i++) {
+		memset(payload_write, 0x11 * (i + 1), sizeof(payload_write));
+		memset(payload_read, 0, sizeof(payload_read));
+		spdk_blob_io_read(blob, channel, payload_read, i * io_units_per_cluster, 1,
+				  blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		CU_ASSERT(memcmp(payload_write, payload_read, BLOCKLEN) == 0);
+	}
+
+	memset(payload_read, 0xFF, sizeof(payload_read));
+	iov.iov_base = payload_read;
+	iov.iov_len = BLOCKLEN;
+	spdk_blob_io_readv(blob, channel, &iov, 1, 3 * io_units_per_cluster, 1,
+			   blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(zero, payload_read, BLOCKLEN) == 0);
+
+	SPDK_CU_ASSERT_FATAL(blob->flat_map != NULL);
+	CU_ASSERT(blob->flat_map->num_clusters == 5);
+	CU_ASSERT(blob->flat_map->lba[0] == snapshot[0]->active.clusters[0]);
+	CU_ASSERT(blob->flat_map->lba[1] == snapshot[1]->active.clusters[1]);
+	CU_ASSERT(blob->flat_map->lba[2] == snapshot[2]->active.clusters[2]);
+	CU_ASSERT(blob->flat_map->lba[3] == BLOB_FLAT_MAP_ZEROES);
+	CU_ASSERT(blob->flat_map->lba[4] == 0);
+
+	/* Taking another snapshot changes the chain and drops the map */
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	CU_ASSERT(blob->flat_map == NULL);
+
+	spdk_bs_open_blob(bs, g_blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot[3] = g_blob;
+
+	memset(payload_write, 0x22, sizeof(payload_write));
+	memset(payload_read, 0, sizeof(payload_read));
+	spdk_blob_io_read(blob, channel, payload_read, io_units_per_cluster, 1,
+			  blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, BLOCKLEN) == 0);
+	SPDK_CU_ASSERT_FATAL(blob->flat_map != NULL);
+	CU_ASSERT(blob->flat_map->lba[1] == snapshot[1]->active.clusters[1]);
+
+	/* Once the clone owns a cluster, it is read from the clone itself */
+	memset(payload_write, 0x55, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, io_units_per_cluster, 1,
+			   blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	memset(payload_read, 0, sizeof(payload_read));
+	spdk_blob_io_read(blob, channel, payload_read, io_units_per_cluster, 1,
+			  blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, BLOCKLEN) == 0);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	ut_blob_close_and_delete(bs, blob);
+	for (i = 3; i >= 0; i--) {
+		ut_blob_close_and_delete(bs, snapshot[i]);
+	}
+}
+
+static void
+blob_snapshot_chain_flat_map_decouple(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob, *snapshot[2];
+	struct blob_flat_map *map;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	spdk_blob_id blobid, snapshotid[2];
+	uint64_t stale_lba;
+	uint8_t payload_read[BLOCKLEN];
+	uint8_t payload_write[BLOCKLEN];
+	int i;
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 2;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+
+	/* blob -> snapshot[1] -> snapshot[0], with cluster 0 owned by snapshot[0] */
+	memset(payload_write, 0x11, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	for (i = 0; i < 2; i++) {
+		spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+		snapshotid[i] = g_blobid;
+
+		spdk_bs_open_blob(bs, g_blobid, blob_op_with_handle_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+		snapshot[i] = g_blob;
+	}
+
+	memset(payload_read, 0, sizeof(payload_read));
+	spdk_blob_io_read(blob, channel, payload_read, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, BLOCKLEN) == 0);
+
+	map = blob->flat_map;
+	SPDK_CU_ASSERT_FATAL(map != NULL);
+	stale_lba = snapshot[0]->active.clusters[0];
+	CU_ASSERT(map->lba[0] == stale_lba);
+
+	/* Decoupling snapshot[1] detaches snapshot[0] from the chain of the clone, while I/O to
+	 * the clone is not frozen. Its map stays in place, but belongs to an older generation.
+	 */
+	spdk_bs_blob_decouple_parent(bs, channel, snapshotid[1], blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(blob->flat_map == map);
+	CU_ASSERT(map->gen != bs->flat_map_gen);
+	CU_ASSERT(snapshot[1]->active.clusters[0] != 0);
+	CU_ASSERT(snapshot[1]->active.clusters[0] != stale_lba);
+
+	/* A resolve racing with the detach may have stored the LBA in snapshot[0] */
+	map->lba[0] = stale_lba;
+
+	ut_blob_close_and_delete(bs, snapshot[0]);
+
+	/* The next read replaces the map and resolves the cluster to snapshot[1] */
+	memset(payload_read, 0, sizeof(payload_read));
+	spdk_blob_io_read(blob, channel, payload_read, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, BLOCKLEN) == 0);
+	SPDK_CU_ASSERT_FATAL(blob->flat_map != NULL);
+	CU_ASSERT(blob->flat_map != map);
+	CU_ASSERT(blob->flat_map->gen == bs->flat_map_gen);
+	CU_ASSERT(blob->flat_map->lba[0] == snapshot[1]->active.clusters[0]);
+	CU_ASSERT(blob->flat_map_retired == map);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	ut_blob_close_and_delete(bs, blob);
+	ut_blob_close_and_delete(bs, snapshot[1]);
+}
+
 /**
  * Inflate / decouple parent rw unit tests.
  *
@@ -10077,6 +10785,199 @@ blob_shallow_copy(void)
 	poll_threads();
 }
 
+static uint64_t g_diff_extents[8][2];
+static uint32_t g_diff_extent_count;
+static uint64_t g_diff_copied_clusters;
+static uint64_t g_diff_total_clusters;
+
+static void
+blob_diff_extent_cb(uint64_t start_cluster, uint64_t num_clusters, void *cb_arg)
+{
+	SPDK_CU_ASSERT_FATAL(g_diff_extent_count < SPDK_COUNTOF(g_diff_extents));
+	g_diff_extents[g_diff_extent_count][0] = start_cluster;
+	g_diff_extents[g_diff_extent_count][1] = num_clusters;
+	g_diff_extent_count++;
+}
+
+static void
+blob_diff_copy_status_cb(uint64_t copied_clusters, uint64_t total_clusters, void *cb_arg)
+{
+	g_diff_copied_clusters = copied_clusters;
+	g_diff_total_clusters = total_clusters;
+}
+
+static void
+ut_blob_get_diff(struct spdk_blob_store *bs, spdk_blob_id blobid, spdk_blob_id base_id)
+{
+	g_diff_extent_count = 0;
+	g_bserrno = -1;
+	spdk_bs_blob_get_diff(bs, blobid, base_id, blob_diff_extent_cb, NULL,
+			      blob_op_complete, NULL);
+	poll_threads();
+}
+
+static void
+blob_diff(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob_opts blob_opts;
+	struct spdk_blob *blob;
+	spdk_blob_id blobid, snapshotid1, snapshotid2, snapshotid3;
+	uint64_t num_clusters = 4;
+	struct spdk_bs_dev *ext_dev;
+	struct spdk_bs_dev_cb_args ext_args;
+	struct spdk_io_channel *bdev_ch, *blob_ch;
+	uint8_t buf1[DEV_BUFFER_BLOCKLEN];
+	uint8_t buf2[DEV_BUFFER_BLOCKLEN];
+	uint64_t io_units_per_cluster;
+	uint64_t cluster;
+	/* Pattern expected in each cluster of the destination after the diff copy */
+	const uint8_t expected[] = { 0xff, 0x21, 0xff, 0x33 };
+	int rc;
+
+	blob_ch = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(blob_ch != NULL);
+
+	ut_spdk_blob_opts_init(&blob_opts);
+	blob_opts.thin_provision = true;
+	blob_opts.num_clusters = num_clusters;
+
+	blob = ut_blob_create_and_open(bs, &blob_opts);
+	blobid = spdk_blob_get_id(blob);
+	io_units_per_cluster = bs_io_units_per_cluster(blob);
+
+	/*
+	 * Build the chain blob -> snapshot3 -> snapshot2 -> snapshot1, with:
+	 * snapshot1: clusters 0 and 1
+	 * snapshot2: cluster 1
+	 * snapshot3: cluster 3
+	 */
+	for (cluster = 0; cluster < 2; cluster++) {
+		memset(buf1, 0x10 + cluster, DEV_BUFFER_BLOCKLEN);
+		spdk_blob_io_write(blob, blob_ch, buf1, cluster * io_units_per_cluster, 1,
+				   blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid1 = g_blobid;
+
+	memset(buf1, 0x21, DEV_BUFFER_BLOCKLEN);
+	spdk_blob_io_write(blob, blob_ch, buf1, io_units_per_cluster, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid2 = g_blobid;
+
+	memset(buf1, 0x33, DEV_BUFFER_BLOCKLEN);
+	spdk_blob_io_write(blob, blob_ch, buf1, 3 * io_units_per_cluster, 1, blob_op_complete,
+			   NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid3 = g_blobid;
+
+	/* Nothing written to the clone since the last snapshot */
+	ut_blob_get_diff(bs, blobid, snapshotid3);
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_diff_extent_count == 0);
+
+	/* Changes between snapshot1 and snapshot3 */
+	ut_blob_get_diff(bs, snapshotid3, snapshotid1);
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_diff_extent_count == 2);
+	CU_ASSERT(g_diff_extents[0][0] == 1 && g_diff_extents[0][1] == 1);
+	CU_ASSERT(g_diff_extents[1][0] == 3 && g_diff_extents[1][1] == 1);
+
+	ut_blob_get_diff(bs, snapshotid2, snapshotid1);
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_diff_extent_count == 1);
+	CU_ASSERT(g_diff_extents[0][0] == 1 && g_diff_extents[0][1] == 1);
+
+	/* Whole chain, adjacent clusters of different snapshots make a single range */
+	ut_blob_get_diff(bs, snapshotid3, SPDK_BLOBID_INVALID);
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_diff_extent_count == 2);
+	CU_ASSERT(g_diff_extents[0][0] == 0 && g_diff_extents[0][1] == 2);
+	CU_ASSERT(g_diff_extents[1][0] == 3 && g_diff_extents[1][1] == 1);
+
+	/* Base must be an older snapshot of the chain */
+	ut_blob_get_diff(bs, snapshotid1, snapshotid3);
+	CU_ASSERT(g_bserrno == -EINVAL);
+	CU_ASSERT(g_diff_extent_count == 0);
+	ut_blob_get_diff(bs, snapshotid3, snapshotid3);
+	CU_ASSERT(g_bserrno == -EINVAL);
+
+	/* Diff copy of a blob that is not read only */
+	ext_dev = init_ext_dev(num_clusters * 1024 * 1024, DEV_BUFFER_BLOCKLEN);
+	rc = spdk_bs_blob_diff_copy(bs, blob_ch, blobid, snapshotid1, ext_dev,
+				    blob_diff_copy_status_cb, NULL, blob_op_complete, NULL);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EPERM);
+	ext_dev->destroy(ext_dev);
+
+	/* Fill the destination, then copy the changes between snapshot1 and snapshot3 */
+	ext_dev = init_ext_dev(num_clusters * 1024 * 1024, DEV_BUFFER_BLOCKLEN);
+	bdev_ch = ext_dev->create_channel(ext_dev);
+	SPDK_CU_ASSERT_FATAL(bdev_ch != NULL);
+	ext_args.cb_fn = bs_dev_io_complete_cb;
+	memset(buf2, 0xff, DEV_BUFFER_BLOCKLEN);
+	for (cluster = 0; cluster < num_clusters; cluster++) {
+		ext_dev->write(ext_dev, bdev_ch, buf2, cluster * io_units_per_cluster, 1,
+			       &ext_args);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+
+	g_diff_copied_clusters = 0;
+	g_diff_total_clusters = 0;
+	rc = spdk_bs_blob_diff_copy(bs, blob_ch, snapshotid3, snapshotid1, ext_dev,
+				    blob_diff_copy_status_cb, NULL, blob_op_complete, NULL);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_diff_copied_clusters == 2);
+	CU_ASSERT(g_diff_total_clusters == 2);
+
+	/* Clusters are read through snapshot3, whichever snapshot owns them */
+	for (cluster = 0; cluster < num_clusters; cluster++) {
+		memset(buf1, expected[cluster], DEV_BUFFER_BLOCKLEN);
+		ext_dev->read(ext_dev, bdev_ch, buf2, cluster * io_units_per_cluster, 1, &ext_args);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		CU_ASSERT(memcmp(buf1, buf2, DEV_BUFFER_BLOCKLEN) == 0);
+	}
+
+	/* Base that is not in the chain */
+	rc = spdk_bs_blob_diff_copy(bs, blob_ch, snapshotid1, snapshotid3, ext_dev,
+				    blob_diff_copy_status_cb, NULL, blob_op_complete, NULL);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EINVAL);
+
+	/* Clean up */
+	ext_dev->destroy_channel(ext_dev, bdev_ch);
+	ext_dev->destroy(ext_dev);
+	spdk_bs_free_io_channel(blob_ch);
+	ut_blob_close_and_delete(bs, blob);
+	spdk_bs_delete_blob(bs, snapshotid3, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_bs_delete_blob(bs, snapshotid2, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_bs_delete_blob(bs, snapshotid1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+}
+
 static void
 blob_set_parent(void)
 {
@@ -10574,6 +11475,7 @@ main(int argc, char **argv)
 		CU_ADD_TEST(suite_bs, blob_snapshot);
 		CU_ADD_TEST(suite_bs, blob_clone);
 		CU_ADD_TEST(suite_bs, blob_inflate);
+		CU_ADD_TEST(suite_bs, blob_inflate_throttled);
 		CU_ADD_TEST(suite_bs, blob_delete);
 		CU_ADD_TEST(suite_bs, blob_resize_test);
 		CU_ADD_TEST(suite_bs, blob_resize_thin_test);
@@ -10616,6 +11518,8 @@ main(int argc, char **argv)
 		CU_ADD_TEST(suite_bs, blob_set_xattrs_test);
 		CU_ADD_TEST(suite_bs, blob_thin_prov_alloc);
 		CU_ADD_TEST(suite_bs, blob_insert_cluster_msg_test);
+		CU_ADD_TEST(suite_bs, blob_insert_cluster_batch_test);
+		CU_ADD_TEST(suite_bs, blob_insert_cluster_batch_fail);
 		CU_ADD_TEST(suite_bs, blob_thin_prov_rw);
 		CU_ADD_TEST(suite, blob_thin_prov_write_count_io);
 		CU_ADD_TEST(suite, blob_thin_prov_unmap_cluster);
@@ -10623,10 +11527,14 @@ main(int argc, char **argv)
 		CU_ADD_TEST(suite_bs, blob_thin_prov_rw_iov);
 		CU_ADD_TEST(suite_bs, blob_thin_prov_update_extpage_ordered);
 		CU_ADD_TEST(suite_bs, blob_thin_prov_alloc_extpage_concurrently);
+		CU_ADD_TEST(suite_bs, blob_thin_prov_cluster_pool);
+		CU_ADD_TEST(suite_bs, blob_thin_prov_cluster_pool_reclaim);
 		CU_ADD_TEST(suite_bs, blob_thin_prov_unmap_update_extpage_ordered);
 		CU_ADD_TEST(suite, bs_load_iter_test);
 		CU_ADD_TEST(suite_bs, blob_snapshot_rw);
 		CU_ADD_TEST(suite_bs, blob_snapshot_rw_iov);
+		CU_ADD_TEST(suite_bs, blob_snapshot_chain_flat_map);
+		CU_ADD_TEST(suite_bs, blob_snapshot_chain_flat_map_decouple);
 		CU_ADD_TEST(suite, blob_relations);
 		CU_ADD_TEST(suite, blob_relations2);
 		CU_ADD_TEST(suite, blob_relations3);
@@ -10661,6 +11569,7 @@ main(int argc, char **argv)
 		CU_ADD_TEST(suite_bs, blob_clone_resize);
 		CU_ADD_TEST(suite, blob_esnap_clone_resize);
 		CU_ADD_TEST(suite_bs, blob_shallow_copy);
+		CU_ADD_TEST(suite_bs, blob_diff);
 		CU_ADD_TEST(suite_esnap_bs, blob_set_parent);
 		CU_ADD_TEST(suite_esnap_bs, blob_set_external_parent);
 	}
@@ -722,6 +722,152 @@ test_scheduler(void)
 	free_cores();
 }
 
+static void
+test_work_stealing(void)
+{
+	struct spdk_cpuset cpuset = {};
+	struct spdk_thread *thread[3];
+	struct spdk_lw_thread *lw_thread[3];
+	struct spdk_poller *busy[3], *idle;
+	struct spdk_reactor *reactor0, *reactor1;
+	uint64_t cooldown;
+	int i;
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	allocate_cores(2);
+
+	CU_ASSERT(spdk_reactors_init(SPDK_DEFAULT_MSG_MEMPOOL_SIZE) == 0);
+
+	spdk_cpuset_set_cpu(&g_reactor_core_mask, 0, true);
+	spdk_cpuset_set_cpu(&g_reactor_core_mask, 1, true);
+
+	/* spdk_get_ticks_hz() is 1000000, so a period of 10us is 10 ticks */
+	spdk_scheduler_set_work_stealing_period(10);
+	spdk_scheduler_enable_work_stealing(true);
+	CU_ASSERT(spdk_scheduler_work_stealing_enabled() == true);
+	CU_ASSERT(g_work_stealing_period_in_tsc == 10);
+	cooldown = 10 * WORK_STEALING_COOLDOWN_PERIODS;
+
+	reactor0 = spdk_reactor_get(0);
+	SPDK_CU_ASSERT_FATAL(reactor0 != NULL);
+	reactor1 = spdk_reactor_get(1);
+	SPDK_CU_ASSERT_FATAL(reactor1 != NULL);
+
+	/* Create three threads on core 0 which are allowed to run on core 1 as well */
+	MOCK_SET(spdk_get_ticks, 100);
+	spdk_cpuset_set_cpu(&cpuset, 0, true);
+	for (i = 0; i < 3; i++) {
+		thread[i] = spdk_thread_create(NULL, &cpuset);
+		SPDK_CU_ASSERT_FATAL(thread[i] != NULL);
+		lw_thread[i] = spdk_thread_get_ctx(thread[i]);
+		spdk_cpuset_set_cpu(spdk_thread_get_cpumask(thread[i]), 1, true);
+	}
+	CU_ASSERT(event_queue_run_batch(reactor0) == 3);
+	CU_ASSERT(reactor0->thread_count == 3);
+
+	g_reactor_state = SPDK_REACTOR_STATE_RUNNING;
+
+	/* Make all threads busy, thread 0 the most. Threads moved recently cannot be
+	 * stolen, so start after the cooldown.
+	 */
+	MOCK_SET(spdk_get_ticks, 2 * cooldown);
+	reactor0->tsc_last = spdk_get_ticks();
+	reactor1->tsc_last = spdk_get_ticks();
+	for (i = 0; i < 3; i++) {
+		spdk_set_thread(thread[i]);
+		busy[i] = spdk_poller_register(poller_run_busy, (void *)(uint64_t)(30 - 10 * i), 0);
+		CU_ASSERT(busy[i] != NULL);
+	}
+	spdk_set_thread(NULL);
+
+	_reactor_run(reactor0);
+	reactor_work_stealing(reactor0);
+	CU_ASSERT(reactor0->load == 100);
+	CU_ASSERT(reactor0->last_steal_tsc == 0);
+	CU_ASSERT(lw_thread[0]->steal_last_busy_tsc == 30);
+	CU_ASSERT(lw_thread[1]->steal_last_busy_tsc == 20);
+	CU_ASSERT(lw_thread[2]->steal_last_busy_tsc == 10);
+
+	/* Reactor 1 is idle and steals from reactor 0. Thread 0 is the hottest and
+	 * stays, thread 1 is bound, so thread 2 is taken.
+	 */
+	spdk_thread_bind(thread[1], true);
+	MOCK_SET(spdk_env_get_current_core, 1);
+	_reactor_run(reactor1);
+	reactor_work_stealing(reactor1);
+	CU_ASSERT(reactor1->load == 0);
+	CU_ASSERT(reactor1->last_steal_tsc == reactor1->tsc_last);
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+	CU_ASSERT(event_queue_run_batch(reactor0) == 1);
+	CU_ASSERT(lw_thread[0]->resched == false);
+	CU_ASSERT(lw_thread[1]->resched == false);
+	CU_ASSERT(lw_thread[2]->resched == true);
+	CU_ASSERT(lw_thread[2]->lcore == 1);
+
+	_reactor_run(reactor0);
+	CU_ASSERT(reactor0->thread_count == 2);
+
+	MOCK_SET(spdk_env_get_current_core, 1);
+	CU_ASSERT(event_queue_run_batch(reactor1) == 1);
+	CU_ASSERT(TAILQ_FIRST(&reactor1->threads) == lw_thread[2]);
+	CU_ASSERT(lw_thread[2]->lcore == 1);
+
+	/* Reactor 1 is still idle, but does not steal again before its cooldown expires */
+	spdk_set_thread(thread[2]);
+	spdk_poller_unregister(&busy[2]);
+	idle = spdk_poller_register(poller_run_idle, (void *)20, 0);
+	CU_ASSERT(idle != NULL);
+	spdk_set_thread(NULL);
+
+	_reactor_run(reactor1);
+	reactor_work_stealing(reactor1);
+	CU_ASSERT(reactor1->load == 0);
+	MOCK_SET(spdk_env_get_current_core, 0);
+	CU_ASSERT(event_queue_run_batch(reactor0) == 0);
+
+	/* After the cooldown reactor 1 tries again, but the only movable thread left on
+	 * reactor 0 is the hottest one.
+	 */
+	MOCK_SET(spdk_get_ticks, reactor1->tsc_last + cooldown);
+	MOCK_SET(spdk_env_get_current_core, 1);
+	_reactor_run(reactor1);
+	reactor_work_stealing(reactor1);
+	CU_ASSERT(reactor1->last_steal_tsc == reactor1->tsc_last);
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+	CU_ASSERT(event_queue_run_batch(reactor0) == 1);
+	CU_ASSERT(lw_thread[0]->resched == false);
+	CU_ASSERT(lw_thread[1]->resched == false);
+
+	spdk_scheduler_enable_work_stealing(false);
+	g_reactor_state = SPDK_REACTOR_STATE_INITIALIZED;
+
+	/* Destroy threads */
+	spdk_set_thread(thread[0]);
+	spdk_poller_unregister(&busy[0]);
+	spdk_set_thread(thread[1]);
+	spdk_poller_unregister(&busy[1]);
+	spdk_set_thread(thread[2]);
+	spdk_poller_unregister(&idle);
+	for (i = 0; i < 3; i++) {
+		spdk_set_thread(thread[i]);
+		spdk_thread_exit(thread[i]);
+	}
+	reactor_run(reactor0);
+	MOCK_SET(spdk_env_get_current_core, 1);
+	reactor_run(reactor1);
+
+	spdk_set_thread(NULL);
+
+	MOCK_CLEAR(spdk_env_get_current_core);
+
+	spdk_reactors_fini();
+
+	free_cores();
+}
+
 static void
 test_bind_thread(void)
 {
@@ -1243,6 +1389,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_for_each_reactor);
 	CU_ADD_TEST(suite, test_reactor_stats);
 	CU_ADD_TEST(suite, test_scheduler);
+	CU_ADD_TEST(suite, test_work_stealing);
 #ifndef __FreeBSD__
 	/* governor is only supported on Linux, so don't run this specific unit test on FreeBSD */
 	CU_ADD_TEST(suite, test_governor);
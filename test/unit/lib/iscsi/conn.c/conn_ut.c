@@ -22,6 +22,9 @@ DEFINE_STUB(iscsi_get_pdu, struct spdk_iscsi_pdu *,
 DEFINE_STUB(iscsi_param_eq_val, int,
 	    (struct iscsi_param *params, const char *key, const char *val), 0);
 DEFINE_STUB(iscsi_pdu_calc_data_digest, uint32_t, (struct spdk_iscsi_pdu *pdu), 0);
+DEFINE_STUB(iscsi_pdu_submit_data_digest, int,
+	    (struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu, uint32_t data_len,
+	     spdk_accel_completion_cb cb_fn), -ENOTSUP);
 DEFINE_STUB_V(spdk_sock_writev_async,
 	      (struct spdk_sock *sock, struct spdk_sock_request *req));
 
@@ -886,6 +889,38 @@ abort_queued_datain_tasks_test(void)
 	g_new_task = NULL;
 }
 
+static void
+get_idlest_poll_group_test(void)
+{
+	struct spdk_iscsi_poll_group pg1 = {}, pg2 = {}, pg3 = {};
+
+	TAILQ_INIT(&g_iscsi.poll_group_head);
+	TAILQ_INSERT_TAIL(&g_iscsi.poll_group_head, &pg1, link);
+	TAILQ_INSERT_TAIL(&g_iscsi.poll_group_head, &pg2, link);
+	TAILQ_INSERT_TAIL(&g_iscsi.poll_group_head, &pg3, link);
+
+	/* Case 1 - The least busy poll group wins even if it has more connections. */
+	pg1.busy_pct = 80;
+	pg1.num_conns = 1;
+	pg2.busy_pct = 30;
+	pg2.num_conns = 4;
+	pg3.busy_pct = 50;
+	pg3.num_conns = 2;
+	CU_ASSERT(iscsi_get_idlest_poll_group() == &pg2);
+
+	/* Case 2 - Similar busy percentages are decided by the number of connections. */
+	pg3.busy_pct = 35;
+	CU_ASSERT(iscsi_get_idlest_poll_group() == &pg3);
+
+	/* Case 3 - Then by the number of targets. */
+	pg2.num_conns = 2;
+	pg2.num_active_targets = 1;
+	pg3.num_active_targets = 2;
+	CU_ASSERT(iscsi_get_idlest_poll_group() == &pg2);
+
+	TAILQ_INIT(&g_iscsi.poll_group_head);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -904,6 +939,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, free_tasks_with_queued_datain);
 	CU_ADD_TEST(suite, abort_queued_datain_task_test);
 	CU_ADD_TEST(suite, abort_queued_datain_tasks_test);
+	CU_ADD_TEST(suite, get_idlest_poll_group_test);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
 	CU_cleanup_registry();
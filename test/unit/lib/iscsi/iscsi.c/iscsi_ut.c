@@ -122,6 +122,21 @@ DEFINE_STUB(spdk_scsi_lun_get_dif_ctx, bool,
 	    (struct spdk_scsi_lun *lun, struct spdk_scsi_task *task,
 	     struct spdk_dif_ctx *dif_ctx), false);
 
+static spdk_accel_completion_cb g_accel_cb_fn;
+static void *g_accel_cb_arg;
+
+int
+spdk_accel_submit_crc32cv(struct spdk_io_channel *ch, uint32_t *crc_dst, struct iovec *iovs,
+			  uint32_t iovcnt, uint32_t seed, spdk_accel_completion_cb cb_fn,
+			  void *cb_arg)
+{
+	*crc_dst = spdk_crc32c_iov_update(iovs, iovcnt, ~seed);
+	g_accel_cb_fn = cb_fn;
+	g_accel_cb_arg = cb_arg;
+
+	return 0;
+}
+
 static void
 alloc_mock_mobj(struct spdk_mobj *mobj, int len)
 {
@@ -2053,6 +2068,7 @@ pdu_payload_read_test(void)
 {
 	struct spdk_iscsi_conn conn = {};
 	struct spdk_iscsi_pdu pdu = {};
+	struct spdk_iscsi_poll_group pg = {};
 	struct spdk_mobj mobj1 = {}, mobj2 = {};
 	int rc;
 
@@ -2143,6 +2159,40 @@ pdu_payload_read_test(void)
 	CU_ASSERT(pdu.ddigest_valid_bytes == ISCSI_DIGEST_LEN);
 	CU_ASSERT(pdu.mobj[1] == NULL);
 
+	/* Case 6: same as case 5 but the data digest is checked by accel. The connection
+	 * waits for the digest, and a mismatch fails the connection once accel completes.
+	 */
+	conn.scheduled = 1;
+	conn.pg = &pg;
+	conn.pdu_in_progress = &pdu;
+	conn.pdu_recv_state = ISCSI_PDU_RECV_STATE_AWAIT_PDU_PAYLOAD;
+	pg.accel_ch = (struct spdk_io_channel *)0xDEADBEEF;
+	memset(&pdu, 0, sizeof(pdu));
+	pdu.ref = 1;
+	pdu.conn = &conn;
+	pdu.crc32c = SPDK_CRC32C_INITIAL;
+	pdu.data = mobj1.buf;
+	pdu.data_segment_len = SPDK_ISCSI_MAX_RECV_DATA_SEGMENT_LENGTH;
+	pdu.mobj[0] = &mobj1;
+	pdu.data_valid_bytes = SPDK_ISCSI_MAX_RECV_DATA_SEGMENT_LENGTH;
+	g_data_digest++;
+
+	rc = iscsi_pdu_payload_read(&conn, &pdu);
+	CU_ASSERT(rc == 1);
+	CU_ASSERT(conn.pdu_recv_state == ISCSI_PDU_RECV_STATE_AWAIT_DATA_DIGEST);
+	CU_ASSERT(conn.data_digest_cnt == 1);
+	CU_ASSERT(pdu.ref == 2);
+	CU_ASSERT(g_accel_cb_arg == &pdu);
+
+	rc = iscsi_read_pdu(&conn);
+	CU_ASSERT(rc == 0);
+
+	g_accel_cb_fn(g_accel_cb_arg, 0);
+	CU_ASSERT(conn.data_digest_cnt == 0);
+	CU_ASSERT(pdu.ref == 1);
+	CU_ASSERT(conn.pdu_recv_state == ISCSI_PDU_RECV_STATE_ERROR);
+	CU_ASSERT(conn.state == ISCSI_CONN_STATE_EXITING);
+
 	g_conn_read_data_digest = false;
 	g_conn_read_len = 0;
 	MOCK_SET(spdk_mempool_get, &mobj1);
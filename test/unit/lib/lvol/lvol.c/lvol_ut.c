@@ -105,6 +105,24 @@ spdk_bs_blob_decouple_parent(struct spdk_blob_store *bs, struct spdk_io_channel
 	cb_fn(cb_arg, g_inflate_rc);
 }
 
+void
+spdk_bs_inflate_opts_init(struct spdk_bs_inflate_opts *opts, size_t opts_size)
+{
+	memset(opts, 0, opts_size);
+	opts->opts_size = opts_size;
+	opts->clusters_in_flight = 1;
+}
+
+void
+spdk_bs_inflate_blob_ext(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+			 spdk_blob_id blobid, const struct spdk_bs_inflate_opts *opts,
+			 spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	cb_fn(cb_arg, g_inflate_rc);
+}
+
+DEFINE_STUB(spdk_bs_inflate_blob_stop, int, (struct spdk_blob_store *bs, spdk_blob_id blobid), 0);
+
 void
 spdk_bs_iter_next(struct spdk_blob_store *bs, struct spdk_blob *b,
 		  spdk_blob_op_with_handle_complete cb_fn, void *cb_arg)
@@ -263,6 +281,30 @@ spdk_bs_blob_shallow_copy(struct spdk_blob_store *bs, struct spdk_io_channel *ch
 	return 0;
 }
 
+void
+spdk_bs_blob_get_diff(struct spdk_blob_store *bs, spdk_blob_id blobid, spdk_blob_id base_id,
+		      spdk_blob_diff_extent_cb extent_cb_fn, void *extent_cb_arg,
+		      spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	if (blobid == base_id) {
+		cb_fn(cb_arg, -EINVAL);
+		return;
+	}
+
+	extent_cb_fn(0, 1, extent_cb_arg);
+	cb_fn(cb_arg, 0);
+}
+
+int
+spdk_bs_blob_diff_copy(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+		       spdk_blob_id blobid, spdk_blob_id base_id, struct spdk_bs_dev *ext_dev,
+		       spdk_blob_diff_copy_status status_cb_fn, void *status_cb_arg,
+		       spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	cb_fn(cb_arg, 0);
+	return 0;
+}
+
 bool
 spdk_blob_is_snapshot(struct spdk_blob *blob)
 {
@@ -2232,6 +2274,7 @@ lvol_inflate(void)
 {
 	struct lvol_ut_bs_dev dev;
 	struct spdk_lvs_opts opts;
+	struct spdk_bs_inflate_opts inflate_opts;
 	int rc = 0;
 
 	init_dev(&dev);
@@ -2258,6 +2301,27 @@ lvol_inflate(void)
 	spdk_lvol_inflate(g_lvol, op_complete, NULL);
 	CU_ASSERT(g_lvserrno == 0);
 
+	spdk_bs_inflate_opts_init(&inflate_opts, sizeof(inflate_opts));
+	inflate_opts.max_clusters_per_sec = 100;
+
+	g_inflate_rc = -1;
+	spdk_lvol_inflate_ext(g_lvol, &inflate_opts, op_complete, NULL);
+	CU_ASSERT(g_lvserrno != 0);
+
+	/* A stopped inflate is reported to the caller */
+	g_inflate_rc = -ECANCELED;
+	spdk_lvol_inflate_ext(g_lvol, &inflate_opts, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == -ECANCELED);
+
+	g_inflate_rc = 0;
+	spdk_lvol_inflate_ext(g_lvol, &inflate_opts, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+
+	rc = spdk_lvol_inflate_stop(g_lvol);
+	CU_ASSERT(rc == 0);
+	rc = spdk_lvol_inflate_stop(NULL);
+	CU_ASSERT(rc == -ENODEV);
+
 	spdk_lvol_close(g_lvol, op_complete, NULL);
 	CU_ASSERT(g_lvserrno == 0);
 	spdk_lvol_destroy(g_lvol, op_complete, NULL);
@@ -3402,6 +3466,123 @@ lvol_shallow_copy(void)
 	CU_ASSERT(g_io_channel == NULL);
 }
 
+static uint64_t g_diff_extents;
+
+static void
+lvol_diff_extent_cb(uint64_t start_cluster, uint64_t num_clusters, void *cb_arg)
+{
+	g_diff_extents += num_clusters;
+}
+
+static void
+lvol_diff(void)
+{
+	struct lvol_ut_bs_dev bs_dev, bs_dev2;
+	struct spdk_lvs_opts opts;
+	struct spdk_bs_dev ext_dev;
+	struct spdk_lvol_store *lvs, *lvs2;
+	struct spdk_lvol *lvol, *lvol2;
+	int rc = 0;
+
+	init_dev(&bs_dev);
+	init_dev(&bs_dev2);
+
+	ext_dev.blocklen = DEV_BUFFER_BLOCKLEN;
+	ext_dev.blockcnt = BS_CLUSTER_SIZE / DEV_BUFFER_BLOCKLEN;
+
+	spdk_lvs_opts_init(&opts);
+	snprintf(opts.name, sizeof(opts.name), "lvs");
+
+	g_lvserrno = -1;
+	rc = spdk_lvs_init(&bs_dev.bs_dev, &opts, lvol_store_op_with_handle_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol_store != NULL);
+	lvs = g_lvol_store;
+
+	spdk_lvol_create(lvs, "lvol", BS_CLUSTER_SIZE, false, LVOL_CLEAR_WITH_DEFAULT,
+			 lvol_op_with_handle_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol != NULL);
+	lvol = g_lvol;
+
+	spdk_lvol_create_snapshot(lvol, "snap", lvol_op_with_handle_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol != NULL);
+	lvol2 = g_lvol;
+
+	/* Diff against the whole chain and against an older snapshot */
+	g_diff_extents = 0;
+	spdk_lvol_get_diff(lvol, NULL, lvol_diff_extent_cb, NULL, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	CU_ASSERT(g_diff_extents == 1);
+
+	g_diff_extents = 0;
+	spdk_lvol_get_diff(lvol, lvol2, lvol_diff_extent_cb, NULL, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	CU_ASSERT(g_diff_extents == 1);
+
+	/* Errors are reported through the completion */
+	spdk_lvol_get_diff(lvol, lvol, lvol_diff_extent_cb, NULL, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == -EINVAL);
+
+	spdk_lvol_get_diff(NULL, lvol2, lvol_diff_extent_cb, NULL, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == -EINVAL);
+
+	/* Successful diff copy */
+	g_lvserrno = -1;
+	rc = spdk_lvol_diff_copy(lvol2, NULL, &ext_dev, NULL, NULL, op_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+
+	rc = spdk_lvol_diff_copy(NULL, NULL, &ext_dev, NULL, NULL, op_complete, NULL);
+	CU_ASSERT(rc == -EINVAL);
+
+	rc = spdk_lvol_diff_copy(lvol2, NULL, NULL, NULL, NULL, op_complete, NULL);
+	CU_ASSERT(rc == -EINVAL);
+
+	/* Snapshots from another lvol store are refused */
+	snprintf(opts.name, sizeof(opts.name), "lvs2");
+	g_lvserrno = -1;
+	rc = spdk_lvs_init(&bs_dev2.bs_dev, &opts, lvol_store_op_with_handle_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol_store != NULL);
+	lvs2 = g_lvol_store;
+
+	spdk_lvol_create(lvs2, "lvol", BS_CLUSTER_SIZE, false, LVOL_CLEAR_WITH_DEFAULT,
+			 lvol_op_with_handle_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol != NULL);
+
+	spdk_lvol_get_diff(lvol, g_lvol, lvol_diff_extent_cb, NULL, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == -EINVAL);
+	rc = spdk_lvol_diff_copy(lvol2, g_lvol, &ext_dev, NULL, NULL, op_complete, NULL);
+	CU_ASSERT(rc == -EINVAL);
+
+	/* Lvols have to be closed before unloading lvol stores */
+	spdk_lvol_close(g_lvol, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	spdk_lvol_close(lvol2, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	spdk_lvol_close(lvol, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+
+	g_lvserrno = -1;
+	rc = spdk_lvs_unload(lvs2, op_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+
+	g_lvserrno = -1;
+	rc = spdk_lvs_unload(lvs, op_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+	g_lvol_store = NULL;
+
+	free_dev(&bs_dev);
+	free_dev(&bs_dev2);
+}
+
 static void
 lvol_set_parent(void)
 {
@@ -3599,6 +3780,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, lvol_esnap_hotplug);
 	CU_ADD_TEST(suite, lvol_get_by);
 	CU_ADD_TEST(suite, lvol_shallow_copy);
+	CU_ADD_TEST(suite, lvol_diff);
 	CU_ADD_TEST(suite, lvol_set_parent);
 	CU_ADD_TEST(suite, lvol_set_external_parent);
 
@@ -158,6 +158,203 @@ poller_run_done(void *ctx)
 	return -1;
 }
 
+#define BATCH_MSG_COUNT (SPDK_MSG_OUTBOX_SIZE + 4)
+
+struct batch_msg_ctx {
+	uint32_t	expected;
+	uint32_t	received;
+	bool		in_order;
+};
+
+static void
+batch_msg_recv(void *arg)
+{
+	struct batch_msg_ctx *ctx = arg;
+
+	ctx->in_order &= (ctx->received == ctx->expected);
+	ctx->received++;
+	ctx->expected++;
+}
+
+static void
+batch_msg_send(void *arg)
+{
+	struct batch_msg_ctx *ctx = arg;
+	struct spdk_thread *thread1 = g_ut_threads[1].thread;
+	uint32_t i;
+
+	for (i = 0; i < SPDK_MSG_OUTBOX_SIZE - 1; i++) {
+		spdk_thread_send_msg(thread1, batch_msg_recv, ctx);
+	}
+	/* Nothing reaches the target ring until the outbox is full */
+	CU_ASSERT(spdk_ring_count(thread1->messages) == 0);
+
+	for (; i < BATCH_MSG_COUNT; i++) {
+		spdk_thread_send_msg(thread1, batch_msg_recv, ctx);
+	}
+	CU_ASSERT(spdk_ring_count(thread1->messages) == SPDK_MSG_OUTBOX_SIZE);
+}
+
+static void
+thread_msg_batching(void)
+{
+	struct spdk_thread *thread0, *thread1;
+	struct spdk_thread_stats stats;
+	struct batch_msg_ctx ctx = { .in_order = true };
+	uint32_t i;
+
+	allocate_threads(2);
+	thread0 = g_ut_threads[0].thread;
+	thread1 = g_ut_threads[1].thread;
+
+	CU_ASSERT(spdk_thread_lib_get_msg_batching() == false);
+	spdk_thread_lib_set_msg_batching(true);
+	CU_ASSERT(spdk_thread_lib_get_msg_batching() == true);
+
+	/* Messages sent outside of a poll are enqueued right away */
+	set_thread(0);
+	spdk_thread_send_msg(thread1, batch_msg_recv, &ctx);
+	CU_ASSERT(spdk_ring_count(thread1->messages) == 1);
+	poll_thread(1);
+	CU_ASSERT(ctx.received == 1);
+
+	/* Messages sent during a poll are flushed by the time the poll completes */
+	set_thread(1);
+	spdk_thread_send_msg(thread0, batch_msg_send, &ctx);
+	poll_thread(0);
+	CU_ASSERT(spdk_ring_count(thread1->messages) == BATCH_MSG_COUNT);
+	poll_thread(1);
+	CU_ASSERT(ctx.received == BATCH_MSG_COUNT + 1);
+	CU_ASSERT(ctx.in_order == true);
+
+	set_thread(0);
+	spdk_thread_get_stats(&stats);
+	CU_ASSERT(stats.msgs_executed == 1);
+	CU_ASSERT(stats.msgs_sent == BATCH_MSG_COUNT + 1);
+	set_thread(1);
+	spdk_thread_get_stats(&stats);
+	CU_ASSERT(stats.msgs_executed == BATCH_MSG_COUNT + 1);
+	CU_ASSERT(stats.msgs_sent == 1);
+
+	spdk_thread_lib_set_msg_batching(false);
+
+	/* The drain limit grows while the ring stays busy and shrinks back when it does not */
+	set_thread(1);
+	for (i = 0; i < 100; i++) {
+		spdk_thread_send_msg(thread0, batch_msg_recv, &ctx);
+	}
+	CU_ASSERT(thread0->msg_batch_size == SPDK_MSG_BATCH_SIZE);
+	CU_ASSERT(spdk_thread_poll(thread0, 0, 0) > 0);
+	CU_ASSERT(spdk_ring_count(thread0->messages) == 100 - SPDK_MSG_BATCH_SIZE);
+	CU_ASSERT(thread0->msg_batch_size == SPDK_MSG_BATCH_SIZE * 2);
+	CU_ASSERT(spdk_thread_poll(thread0, 0, 0) > 0);
+	CU_ASSERT(spdk_ring_count(thread0->messages) == 100 - SPDK_MSG_BATCH_SIZE * 3);
+	CU_ASSERT(thread0->msg_batch_size == SPDK_MSG_BATCH_SIZE * 4);
+	poll_thread(0);
+	CU_ASSERT(spdk_ring_count(thread0->messages) == 0);
+	CU_ASSERT(ctx.received == BATCH_MSG_COUNT + 101);
+	for (i = 0; i < 3; i++) {
+		spdk_thread_poll(thread0, 0, 0);
+	}
+	CU_ASSERT(thread0->msg_batch_size == SPDK_MSG_BATCH_SIZE);
+
+	/* An explicit limit is honored and does not change the adaptive one */
+	for (i = 0; i < 10; i++) {
+		spdk_thread_send_msg(thread0, batch_msg_recv, &ctx);
+	}
+	CU_ASSERT(spdk_thread_poll(thread0, 3, 0) > 0);
+	CU_ASSERT(spdk_ring_count(thread0->messages) == 7);
+	CU_ASSERT(thread0->msg_batch_size == SPDK_MSG_BATCH_SIZE);
+	poll_thread(0);
+
+	free_threads();
+}
+
+static void
+batch_msg_send_ordered(void *arg)
+{
+	struct batch_msg_ctx *ctx = arg;
+	struct spdk_thread *thread1 = g_ut_threads[1].thread;
+	struct spdk_thread *thread2 = g_ut_threads[2].thread;
+	uint32_t i;
+
+	spdk_thread_send_msg(thread1, batch_msg_recv, ctx);
+	for (i = 0; i < SPDK_MSG_OUTBOX_SIZE; i++) {
+		spdk_thread_send_msg(thread2, batch_msg_recv, ctx);
+	}
+
+	/* Filling up the outbox with messages to thread2 first flushes the one sent to thread1 */
+	CU_ASSERT(spdk_ring_count(thread1->messages) == 1);
+	CU_ASSERT(spdk_ring_count(thread2->messages) == SPDK_MSG_OUTBOX_SIZE - 1);
+}
+
+static void
+thread_msg_batching_order(void)
+{
+	struct spdk_thread *thread1, *thread2;
+	struct batch_msg_ctx ctx = { .in_order = true };
+
+	allocate_threads(3);
+	thread1 = g_ut_threads[1].thread;
+	thread2 = g_ut_threads[2].thread;
+	spdk_thread_lib_set_msg_batching(true);
+
+	set_thread(1);
+	spdk_thread_send_msg(g_ut_threads[0].thread, batch_msg_send_ordered, &ctx);
+	poll_thread(0);
+	CU_ASSERT(spdk_ring_count(thread1->messages) == 1);
+	CU_ASSERT(spdk_ring_count(thread2->messages) == SPDK_MSG_OUTBOX_SIZE);
+
+	poll_threads();
+	CU_ASSERT(ctx.received == SPDK_MSG_OUTBOX_SIZE + 1);
+
+	spdk_thread_lib_set_msg_batching(false);
+	free_threads();
+}
+
+static void
+batch_msg_send_to_exiting(void *arg)
+{
+	struct spdk_thread *thread0 = g_ut_threads[0].thread;
+	struct spdk_thread *thread1 = g_ut_threads[1].thread;
+
+	spdk_thread_send_msg(thread1, batch_msg_recv, arg);
+
+	/* The target can't finish exiting while a message for it is still held in the outbox */
+	spdk_set_thread(thread1);
+	spdk_thread_exit(thread1);
+	spdk_thread_poll(thread1, 0, 0);
+	CU_ASSERT(thread1->outbox_msg_count == 1);
+	CU_ASSERT(!spdk_thread_is_exited(thread1));
+	spdk_set_thread(thread0);
+}
+
+static void
+thread_msg_batching_exit(void)
+{
+	struct spdk_thread *thread1;
+	struct batch_msg_ctx ctx = { .in_order = true };
+
+	allocate_threads(2);
+	thread1 = g_ut_threads[1].thread;
+	spdk_thread_lib_set_msg_batching(true);
+
+	set_thread(1);
+	spdk_thread_send_msg(g_ut_threads[0].thread, batch_msg_send_to_exiting, &ctx);
+	poll_thread(0);
+	CU_ASSERT(thread1->outbox_msg_count == 0);
+	CU_ASSERT(spdk_ring_count(thread1->messages) == 1);
+	CU_ASSERT(!spdk_thread_is_exited(thread1));
+
+	/* Once the message is executed the thread exits */
+	poll_thread(1);
+	CU_ASSERT(ctx.received == 1);
+	CU_ASSERT(spdk_thread_is_exited(thread1));
+
+	spdk_thread_lib_set_msg_batching(false);
+	free_threads();
+}
+
 static void
 thread_poller(void)
 {
@@ -641,6 +838,147 @@ for_each_channel_remove(void)
 	free_threads();
 }
 
+struct parallel_ctx {
+	int			msg_count;
+	int			cpl_count;
+	int			status;
+	struct spdk_thread	*fail_thread;
+	/* Channel contexts seen by parallel_channel_ctx_msg() */
+	uint64_t		*channel_ctx[3];
+};
+
+static void
+parallel_channel_msg(struct spdk_io_channel_iter *i)
+{
+	struct parallel_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	int *ch_ctx = spdk_io_channel_get_ctx(spdk_io_channel_iter_get_channel(i));
+
+	*ch_ctx = 0;
+
+	ctx->msg_count++;
+	spdk_for_each_channel_continue(i, spdk_get_thread() == ctx->fail_thread ? -EINVAL : 0);
+}
+
+static void
+parallel_channel_ctx_msg(struct spdk_io_channel_iter *i)
+{
+	struct parallel_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	uint64_t *channel_ctx = spdk_io_channel_iter_get_channel_ctx(i);
+
+	SPDK_CU_ASSERT_FATAL(channel_ctx != NULL);
+	CU_ASSERT(channel_ctx[0] == 0 && channel_ctx[1] == 0);
+	channel_ctx[0] = channel_ctx[1] = UINT64_MAX;
+
+	ctx->channel_ctx[ctx->msg_count++] = channel_ctx;
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+parallel_channel_cpl(struct spdk_io_channel_iter *i, int status)
+{
+	struct parallel_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+
+	CU_ASSERT(spdk_io_channel_iter_get_channel(i) == NULL);
+	CU_ASSERT(spdk_get_thread() == g_ut_threads[0].thread);
+	ctx->cpl_count++;
+	ctx->status = status;
+}
+
+static void
+for_each_channel_parallel(void)
+{
+	struct spdk_io_channel *ch0, *ch1, *ch2;
+	struct parallel_ctx ctx = {};
+	struct io_device *dev;
+	int ch_count = 0;
+
+	allocate_threads(3);
+	set_thread(0);
+	spdk_io_device_register(&ch_count, channel_create, channel_destroy, sizeof(int), NULL);
+
+	/* No channels, the completion is called right away */
+	spdk_for_each_channel_parallel(&ch_count, parallel_channel_msg, &ctx, parallel_channel_cpl);
+	poll_threads();
+	CU_ASSERT(ctx.msg_count == 0);
+	CU_ASSERT(ctx.cpl_count == 1);
+	CU_ASSERT(ctx.status == 0);
+
+	ch0 = spdk_get_io_channel(&ch_count);
+	set_thread(1);
+	ch1 = spdk_get_io_channel(&ch_count);
+	set_thread(2);
+	ch2 = spdk_get_io_channel(&ch_count);
+	CU_ASSERT(ch_count == 3);
+
+	/* All threads are messaged up front, so they can be polled in any order */
+	memset(&ctx, 0, sizeof(ctx));
+	set_thread(0);
+	spdk_for_each_channel_parallel(&ch_count, parallel_channel_msg, &ctx, parallel_channel_cpl);
+	poll_thread(2);
+	CU_ASSERT(ctx.msg_count == 1);
+	poll_thread(1);
+	CU_ASSERT(ctx.msg_count == 2);
+	CU_ASSERT(ctx.cpl_count == 0);
+	poll_thread(0);
+	poll_thread(0);
+	CU_ASSERT(ctx.msg_count == 3);
+	CU_ASSERT(ctx.cpl_count == 1);
+	CU_ASSERT(ctx.status == 0);
+	CU_ASSERT(g_ut_threads[0].thread->for_each_count == 0);
+
+	/* Each channel gets a zeroed context of its own */
+	memset(&ctx, 0, sizeof(ctx));
+	spdk_for_each_channel_parallel_ext(&ch_count, parallel_channel_ctx_msg, &ctx,
+					   2 * sizeof(uint64_t) - 1, parallel_channel_cpl);
+	poll_threads();
+	CU_ASSERT(ctx.msg_count == 3);
+	CU_ASSERT(ctx.cpl_count == 1);
+	CU_ASSERT(ctx.channel_ctx[0] != ctx.channel_ctx[1]);
+	CU_ASSERT(ctx.channel_ctx[0] != ctx.channel_ctx[2]);
+	CU_ASSERT(ctx.channel_ctx[1] != ctx.channel_ctx[2]);
+
+	/* A failure on one channel does not stop the others and is passed to cpl */
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.fail_thread = g_ut_threads[1].thread;
+	spdk_for_each_channel_parallel(&ch_count, parallel_channel_msg, &ctx, parallel_channel_cpl);
+	poll_threads();
+	CU_ASSERT(ctx.msg_count == 3);
+	CU_ASSERT(ctx.cpl_count == 1);
+	CU_ASSERT(ctx.status == -EINVAL);
+
+	/* A channel released before its message is processed is skipped */
+	memset(&ctx, 0, sizeof(ctx));
+	set_thread(2);
+	spdk_put_io_channel(ch2);
+	CU_ASSERT(ch_count == 3);
+	set_thread(0);
+	spdk_for_each_channel_parallel(&ch_count, parallel_channel_msg, &ctx, parallel_channel_cpl);
+	poll_threads();
+	CU_ASSERT(ch_count == 2);
+	CU_ASSERT(ctx.msg_count == 2);
+	CU_ASSERT(ctx.cpl_count == 1);
+
+	/* Unregistering the device waits for the outstanding iteration */
+	memset(&ctx, 0, sizeof(ctx));
+	set_thread(0);
+	dev = io_device_get(&ch_count);
+	SPDK_CU_ASSERT_FATAL(dev != NULL);
+	spdk_for_each_channel_parallel(&ch_count, parallel_channel_msg, &ctx, parallel_channel_cpl);
+	CU_ASSERT(dev->for_each_count == 1);
+	spdk_put_io_channel(ch0);
+	set_thread(1);
+	spdk_put_io_channel(ch1);
+	set_thread(0);
+	spdk_io_device_unregister(&ch_count, NULL);
+	CU_ASSERT(io_device_get(&ch_count) == dev);
+	poll_threads();
+	CU_ASSERT(ctx.cpl_count == 1);
+	CU_ASSERT(ch_count == 0);
+	CU_ASSERT(io_device_get(&ch_count) == NULL);
+
+	free_threads();
+}
+
 struct unreg_ctx {
 	bool	ch_done;
 	bool	foreach_done;
@@ -2283,10 +2621,14 @@ main(int argc, char **argv)
 
 	CU_ADD_TEST(suite, thread_alloc);
 	CU_ADD_TEST(suite, thread_send_msg);
+	CU_ADD_TEST(suite, thread_msg_batching);
+	CU_ADD_TEST(suite, thread_msg_batching_order);
+	CU_ADD_TEST(suite, thread_msg_batching_exit);
 	CU_ADD_TEST(suite, thread_poller);
 	CU_ADD_TEST(suite, poller_pause);
 	CU_ADD_TEST(suite, thread_for_each);
 	CU_ADD_TEST(suite, for_each_channel_remove);
+	CU_ADD_TEST(suite, for_each_channel_parallel);
 	CU_ADD_TEST(suite, for_each_channel_unreg);
 	CU_ADD_TEST(suite, thread_name);
 	CU_ADD_TEST(suite, channel);
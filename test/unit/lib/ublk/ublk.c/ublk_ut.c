@@ -0,0 +1,499 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk_internal/cunit.h"
+#include "spdk_internal/mock.h"
+
+#include "common/lib/test_env.c"
+#include "unit/lib/json_mock.c"
+#include "dma/dma.c"
+#include "ublk/ublk.c"
+
+DEFINE_STUB(spdk_bdev_get_name, const char *, (const struct spdk_bdev *bdev), "ut_bdev");
+DEFINE_STUB(spdk_bdev_get_block_size, uint32_t, (const struct spdk_bdev *bdev), 4096);
+DEFINE_STUB(spdk_bdev_get_data_block_size, uint32_t, (const struct spdk_bdev *bdev), 4096);
+DEFINE_STUB(spdk_bdev_get_physical_block_size, uint32_t, (const struct spdk_bdev *bdev), 4096);
+DEFINE_STUB(spdk_bdev_get_num_blocks, uint64_t, (const struct spdk_bdev *bdev), 1024);
+DEFINE_STUB(spdk_bdev_get_write_unit_size, uint32_t, (const struct spdk_bdev *bdev), 1);
+DEFINE_STUB(spdk_bdev_get_optimal_io_boundary, uint32_t, (const struct spdk_bdev *bdev), 0);
+DEFINE_STUB(spdk_bdev_io_type_supported, bool, (struct spdk_bdev *bdev,
+		enum spdk_bdev_io_type io_type), true);
+DEFINE_STUB(spdk_bdev_desc_get_bdev, struct spdk_bdev *, (struct spdk_bdev_desc *desc), NULL);
+DEFINE_STUB(spdk_bdev_open_ext, int, (const char *bdev_name, bool write,
+				      spdk_bdev_event_cb_t event_cb, void *event_ctx,
+				      struct spdk_bdev_desc **desc), -ENODEV);
+DEFINE_STUB_V(spdk_bdev_close, (struct spdk_bdev_desc *desc));
+DEFINE_STUB(spdk_bdev_get_io_channel, struct spdk_io_channel *, (struct spdk_bdev_desc *desc),
+	    NULL);
+DEFINE_STUB_V(spdk_bdev_free_io, (struct spdk_bdev_io *bdev_io));
+DEFINE_STUB(spdk_bdev_read_blocks, int, (struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		void *buf, uint64_t offset_blocks, uint64_t num_blocks,
+		spdk_bdev_io_completion_cb cb, void *cb_arg), 0);
+DEFINE_STUB(spdk_bdev_write_blocks, int, (struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		void *buf, uint64_t offset_blocks, uint64_t num_blocks,
+		spdk_bdev_io_completion_cb cb, void *cb_arg), 0);
+DEFINE_STUB(spdk_bdev_flush_blocks, int, (struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		uint64_t offset_blocks, uint64_t num_blocks, spdk_bdev_io_completion_cb cb,
+		void *cb_arg), 0);
+DEFINE_STUB(spdk_bdev_unmap_blocks, int, (struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		uint64_t offset_blocks, uint64_t num_blocks, spdk_bdev_io_completion_cb cb,
+		void *cb_arg), 0);
+DEFINE_STUB(spdk_bdev_write_zeroes_blocks, int, (struct spdk_bdev_desc *desc,
+		struct spdk_io_channel *ch, uint64_t offset_blocks, uint64_t num_blocks,
+		spdk_bdev_io_completion_cb cb, void *cb_arg), 0);
+
+static struct spdk_bdev_io_wait_entry *g_io_wait_entry;
+
+DEFINE_RETURN_MOCK(spdk_bdev_queue_io_wait, int);
+int
+spdk_bdev_queue_io_wait(struct spdk_bdev *bdev, struct spdk_io_channel *ch,
+			struct spdk_bdev_io_wait_entry *entry)
+{
+	HANDLE_RETURN_MOCK(spdk_bdev_queue_io_wait);
+
+	g_io_wait_entry = entry;
+	return 0;
+}
+
+static enum spdk_dma_device_type g_bdev_domain_types[2];
+static int g_bdev_num_domain_types;
+
+int
+spdk_bdev_get_memory_domain_types(struct spdk_bdev *bdev, enum spdk_dma_device_type *types,
+				  uint32_t array_size)
+{
+	int i;
+
+	for (i = 0; i < spdk_min((int)array_size, g_bdev_num_domain_types); i++) {
+		types[i] = g_bdev_domain_types[i];
+	}
+
+	return g_bdev_num_domain_types;
+}
+
+/* Arguments of the last zero-copy I/O submitted to the bdev */
+struct ut_ext_io {
+	bool				is_read;
+	struct iovec			*iov;
+	int				iovcnt;
+	uint64_t			offset_blocks;
+	uint64_t			num_blocks;
+	spdk_bdev_io_completion_cb	cb;
+	void				*cb_arg;
+	struct spdk_memory_domain	*memory_domain;
+	void				*memory_domain_ctx;
+};
+
+static struct ut_ext_io g_ext_io;
+
+static void
+ut_record_ext_io(bool is_read, struct iovec *iov, int iovcnt, uint64_t offset_blocks,
+		 uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg,
+		 struct spdk_bdev_ext_io_opts *opts)
+{
+	g_ext_io.is_read = is_read;
+	g_ext_io.iov = iov;
+	g_ext_io.iovcnt = iovcnt;
+	g_ext_io.offset_blocks = offset_blocks;
+	g_ext_io.num_blocks = num_blocks;
+	g_ext_io.cb = cb;
+	g_ext_io.cb_arg = cb_arg;
+	g_ext_io.memory_domain = opts->memory_domain;
+	g_ext_io.memory_domain_ctx = opts->memory_domain_ctx;
+}
+
+DEFINE_RETURN_MOCK(spdk_bdev_readv_blocks_ext, int);
+int
+spdk_bdev_readv_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			   struct iovec *iov, int iovcnt, uint64_t offset_blocks,
+			   uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg,
+			   struct spdk_bdev_ext_io_opts *opts)
+{
+	HANDLE_RETURN_MOCK(spdk_bdev_readv_blocks_ext);
+
+	ut_record_ext_io(true, iov, iovcnt, offset_blocks, num_blocks, cb, cb_arg, opts);
+	return 0;
+}
+
+DEFINE_RETURN_MOCK(spdk_bdev_writev_blocks_ext, int);
+int
+spdk_bdev_writev_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			    struct iovec *iov, int iovcnt, uint64_t offset_blocks,
+			    uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg,
+			    struct spdk_bdev_ext_io_opts *opts)
+{
+	HANDLE_RETURN_MOCK(spdk_bdev_writev_blocks_ext);
+
+	ut_record_ext_io(false, iov, iovcnt, offset_blocks, num_blocks, cb, cb_arg, opts);
+	return 0;
+}
+
+static struct spdk_ublk_dev g_ublk;
+static struct ublk_poll_group g_poll_group;
+static struct ublksrv_io_desc g_iod;
+static struct ublk_io g_io;
+
+/* Set up an in-flight request of a zero-copy ublk device, 16 sectors at sector 64 */
+static struct ublk_io *
+ut_zero_copy_io_init(uint8_t ublk_op, uint16_t q_id, uint16_t tag)
+{
+	struct ublk_queue *q = &g_ublk.queues[q_id];
+
+	memset(&g_ublk, 0, sizeof(g_ublk));
+	memset(&g_io, 0, sizeof(g_io));
+	memset(&g_ext_io, 0, sizeof(g_ext_io));
+	g_io_wait_entry = NULL;
+
+	g_ublk.zero_copy = true;
+	g_ublk.cdev_fd = -1;
+	/* 4KiB blocks */
+	g_ublk.sector_per_block_shift = 3;
+
+	q->q_id = q_id;
+	q->dev = &g_ublk;
+	q->poll_group = &g_poll_group;
+	TAILQ_INIT(&q->inflight_io_list);
+	TAILQ_INIT(&q->completed_io_list);
+
+	g_iod.op_flags = ublk_op;
+	g_iod.start_sector = 64;
+	g_iod.nr_sectors = 16;
+
+	g_io.q = q;
+	g_io.tag = tag;
+	g_io.iod = &g_iod;
+	g_io.cmd_op = UBLK_IO_FETCH_REQ;
+	TAILQ_INSERT_TAIL(&q->inflight_io_list, &g_io, tailq);
+
+	return &g_io;
+}
+
+static bool
+ut_io_is_completed(struct ublk_io *io)
+{
+	struct ublk_io *tmp;
+
+	TAILQ_FOREACH(tmp, &io->q->completed_io_list, tailq) {
+		if (tmp == io) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static int g_cpl_rc;
+static int g_cpl_count;
+
+static void
+ut_data_cpl(void *ctx, int rc)
+{
+	g_cpl_rc = rc;
+	g_cpl_count++;
+}
+
+static void
+zero_copy_memory_domain(void)
+{
+	struct spdk_memory_domain_translation_result result;
+	struct spdk_memory_domain *bdev_domain, *rdma_domain;
+	struct ublk_io *io;
+	uint64_t pos;
+	int rc;
+
+	rc = spdk_memory_domain_create(&bdev_domain, SPDK_DMA_DEVICE_TYPE_UBLK, NULL, "ut_bdev");
+	CU_ASSERT(rc == 0);
+	rc = spdk_memory_domain_create(&rdma_domain, SPDK_DMA_DEVICE_TYPE_RDMA, NULL, "ut_rdma");
+	CU_ASSERT(rc == 0);
+
+	/* Register the ublk memory domain */
+	rc = ublk_memory_domain_create();
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_ublk_tgt.memory_domain != NULL);
+	CU_ASSERT(spdk_memory_domain_get_dma_device_type(g_ublk_tgt.memory_domain) ==
+		  SPDK_DMA_DEVICE_TYPE_UBLK);
+	CU_ASSERT(spdk_memory_domain_get_first("ublk") == g_ublk_tgt.memory_domain);
+
+	io = ut_zero_copy_io_init(UBLK_IO_OP_READ, 1, 3);
+	io->payload_size = 8192;
+	g_ublk.cdev_fd = 42;
+	pos = ublk_user_copy_pos(1, 3);
+
+	/* Translate part of the request data for a bdev understanding the ublk domain */
+	memset(&result, 0, sizeof(result));
+	rc = spdk_memory_domain_translate_data(g_ublk_tgt.memory_domain, io, bdev_domain, NULL,
+					       (void *)(uintptr_t)(pos + 512), 4096, &result);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(result.iov_count == 1);
+	CU_ASSERT(result.iov.iov_base == (void *)(uintptr_t)(pos + 512));
+	CU_ASSERT(result.iov.iov_len == 4096);
+	CU_ASSERT(result.dst_domain == bdev_domain);
+	CU_ASSERT(result.ublk.fd == 42);
+	CU_ASSERT(result.ublk.q_id == 1);
+	CU_ASSERT(result.ublk.tag == 3);
+	CU_ASSERT(result.ublk.offset == 512);
+
+	/* Other domains have to pull/push the data */
+	rc = spdk_memory_domain_translate_data(g_ublk_tgt.memory_domain, io, rdma_domain, NULL,
+					       (void *)(uintptr_t)pos, 4096, &result);
+	CU_ASSERT(rc == -ENOTSUP);
+
+	/* Buffers outside of the request data */
+	rc = spdk_memory_domain_translate_data(g_ublk_tgt.memory_domain, io, bdev_domain, NULL,
+					       (void *)(uintptr_t)(pos + 4096), 8192, &result);
+	CU_ASSERT(rc == -EINVAL);
+	rc = spdk_memory_domain_translate_data(g_ublk_tgt.memory_domain, io, bdev_domain, NULL,
+					       (void *)(uintptr_t)(pos - 512), 1024, &result);
+	CU_ASSERT(rc == -EINVAL);
+	/* Data of the next request */
+	pos = ublk_user_copy_pos(1, 4);
+	rc = spdk_memory_domain_translate_data(g_ublk_tgt.memory_domain, io, bdev_domain, NULL,
+					       (void *)(uintptr_t)pos, 512, &result);
+	CU_ASSERT(rc == -EINVAL);
+
+	/* Unregister it along with the target */
+	g_ublk_tgt.zero_copy = true;
+	_ublk_fini_done(NULL);
+	CU_ASSERT(g_ublk_tgt.memory_domain == NULL);
+	CU_ASSERT(g_ublk_tgt.zero_copy == false);
+	CU_ASSERT(spdk_memory_domain_get_first("ublk") == NULL);
+
+	spdk_memory_domain_destroy(rdma_domain);
+	spdk_memory_domain_destroy(bdev_domain);
+}
+
+static void
+zero_copy_pull_push(void)
+{
+	char data[1024], buf[1024];
+	struct iovec ublk_iov[2], iov;
+	struct ublk_io *io;
+	uint64_t pos;
+	FILE *cdev;
+	int rc;
+
+	rc = ublk_memory_domain_create();
+	CU_ASSERT(rc == 0);
+
+	/* A sparse file stands in for the ublk character device */
+	cdev = tmpfile();
+	SPDK_CU_ASSERT_FATAL(cdev != NULL);
+	io = ut_zero_copy_io_init(UBLK_IO_OP_WRITE, 0, 1);
+	io->payload_size = 8192;
+	g_ublk.cdev_fd = fileno(cdev);
+	pos = ublk_user_copy_pos(0, 1);
+
+	/* Pull the written data in two pieces */
+	memset(data, 0xa5, sizeof(data));
+	memset(data + 512, 0x5a, 512);
+	CU_ASSERT(pwrite(g_ublk.cdev_fd, data, sizeof(data), pos + 4096) == sizeof(data));
+	ublk_iov[0].iov_base = (void *)(uintptr_t)(pos + 4096);
+	ublk_iov[0].iov_len = 512;
+	ublk_iov[1].iov_base = (void *)(uintptr_t)(pos + 4096 + 512);
+	ublk_iov[1].iov_len = 512;
+	iov.iov_base = buf;
+	iov.iov_len = sizeof(buf);
+	memset(buf, 0, sizeof(buf));
+	g_cpl_count = 0;
+	g_cpl_rc = -1;
+	rc = spdk_memory_domain_pull_data(g_ublk_tgt.memory_domain, io, ublk_iov, 2, &iov, 1,
+					  ut_data_cpl, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_cpl_count == 1);
+	CU_ASSERT(g_cpl_rc == 0);
+	CU_ASSERT(memcmp(buf, data, sizeof(buf)) == 0);
+
+	/* Push the data to be read */
+	memset(data, 0x3c, sizeof(data));
+	iov.iov_base = data;
+	ublk_iov[0].iov_base = (void *)(uintptr_t)pos;
+	ublk_iov[0].iov_len = sizeof(data);
+	rc = spdk_memory_domain_push_data(g_ublk_tgt.memory_domain, io, ublk_iov, 1, &iov, 1,
+					  ut_data_cpl, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_cpl_count == 2);
+	CU_ASSERT(g_cpl_rc == 0);
+	CU_ASSERT(pread(g_ublk.cdev_fd, buf, sizeof(buf), pos) == sizeof(buf));
+	CU_ASSERT(memcmp(buf, data, sizeof(buf)) == 0);
+
+	/* A short transfer fails the copy without completing it */
+	iov.iov_base = buf;
+	ublk_iov[0].iov_base = (void *)(uintptr_t)ublk_user_copy_pos(0, 2);
+	rc = spdk_memory_domain_pull_data(g_ublk_tgt.memory_domain, io, ublk_iov, 1, &iov, 1,
+					  ut_data_cpl, NULL);
+	CU_ASSERT(rc == -EIO);
+	CU_ASSERT(g_cpl_count == 2);
+
+	/* So does an error of the character device */
+	fclose(cdev);
+	g_ublk.cdev_fd = -1;
+	ublk_iov[0].iov_base = (void *)(uintptr_t)pos;
+	rc = spdk_memory_domain_pull_data(g_ublk_tgt.memory_domain, io, ublk_iov, 1, &iov, 1,
+					  ut_data_cpl, NULL);
+	CU_ASSERT(rc == -EBADF);
+	rc = spdk_memory_domain_push_data(g_ublk_tgt.memory_domain, io, ublk_iov, 1, &iov, 1,
+					  ut_data_cpl, NULL);
+	CU_ASSERT(rc == -EBADF);
+	CU_ASSERT(g_cpl_count == 2);
+
+	_ublk_fini_done(NULL);
+}
+
+static void
+zero_copy_submit(void)
+{
+	struct ublk_io *io;
+	int rc;
+
+	rc = ublk_memory_domain_create();
+	CU_ASSERT(rc == 0);
+
+	/* Reads hand the request data to the bdev without taking a buffer */
+	io = ut_zero_copy_io_init(UBLK_IO_OP_READ, 0, 5);
+	ublk_submit_bdev_io(io->q, io);
+	CU_ASSERT(g_ext_io.is_read == true);
+	CU_ASSERT(g_ext_io.iov == &io->zc_iov);
+	CU_ASSERT(g_ext_io.iovcnt == 1);
+	CU_ASSERT(io->zc_iov.iov_base == (void *)(uintptr_t)ublk_user_copy_pos(0, 5));
+	CU_ASSERT(io->zc_iov.iov_len == 16 * 512);
+	CU_ASSERT(g_ext_io.offset_blocks == 8);
+	CU_ASSERT(g_ext_io.num_blocks == 2);
+	CU_ASSERT(g_ext_io.memory_domain == g_ublk_tgt.memory_domain);
+	CU_ASSERT(g_ext_io.memory_domain_ctx == io);
+	CU_ASSERT(io->payload == NULL);
+	CU_ASSERT(io->payload_size == 16 * 512);
+	CU_ASSERT(!ut_io_is_completed(io));
+
+	/* The request is committed with its size */
+	g_ext_io.cb((struct spdk_bdev_io *)0xdeadbeef, true, g_ext_io.cb_arg);
+	CU_ASSERT(ut_io_is_completed(io));
+	CU_ASSERT(io->cmd_op == UBLK_IO_COMMIT_AND_FETCH_REQ);
+	CU_ASSERT(io->result == 16 * 512);
+
+	/* Same for writes, failing on the bdev */
+	io = ut_zero_copy_io_init(UBLK_IO_OP_WRITE, 0, 6);
+	ublk_submit_bdev_io(io->q, io);
+	CU_ASSERT(g_ext_io.is_read == false);
+	CU_ASSERT(g_ext_io.iov == &io->zc_iov);
+	CU_ASSERT(io->zc_iov.iov_base == (void *)(uintptr_t)ublk_user_copy_pos(0, 6));
+	CU_ASSERT(g_ext_io.memory_domain == g_ublk_tgt.memory_domain);
+	CU_ASSERT(g_ext_io.memory_domain_ctx == io);
+	CU_ASSERT(io->payload == NULL);
+
+	g_ext_io.cb((struct spdk_bdev_io *)0xdeadbeef, false, g_ext_io.cb_arg);
+	CU_ASSERT(ut_io_is_completed(io));
+	CU_ASSERT(io->cmd_op == UBLK_IO_COMMIT_AND_FETCH_REQ);
+	CU_ASSERT(io->result == -EIO);
+
+	/* Out of bdev_io: the request waits and is resubmitted in zero-copy mode */
+	io = ut_zero_copy_io_init(UBLK_IO_OP_WRITE, 0, 7);
+	MOCK_SET(spdk_bdev_writev_blocks_ext, -ENOMEM);
+	ublk_submit_bdev_io(io->q, io);
+	MOCK_CLEAR(spdk_bdev_writev_blocks_ext);
+	SPDK_CU_ASSERT_FATAL(g_io_wait_entry == &io->bdev_io_wait);
+	CU_ASSERT(!ut_io_is_completed(io));
+	CU_ASSERT(g_ext_io.cb == NULL);
+
+	g_io_wait_entry->cb_fn(g_io_wait_entry->cb_arg);
+	CU_ASSERT(g_ext_io.is_read == false);
+	CU_ASSERT(g_ext_io.memory_domain == g_ublk_tgt.memory_domain);
+	CU_ASSERT(g_ext_io.memory_domain_ctx == io);
+	g_ext_io.cb((struct spdk_bdev_io *)0xdeadbeef, true, g_ext_io.cb_arg);
+	CU_ASSERT(ut_io_is_completed(io));
+	CU_ASSERT(io->result == 16 * 512);
+
+	/* The wait cannot be queued */
+	io = ut_zero_copy_io_init(UBLK_IO_OP_READ, 0, 8);
+	MOCK_SET(spdk_bdev_readv_blocks_ext, -ENOMEM);
+	MOCK_SET(spdk_bdev_queue_io_wait, -EINVAL);
+	ublk_submit_bdev_io(io->q, io);
+	MOCK_CLEAR(spdk_bdev_readv_blocks_ext);
+	MOCK_CLEAR(spdk_bdev_queue_io_wait);
+	CU_ASSERT(ut_io_is_completed(io));
+	CU_ASSERT(io->result == -EIO);
+
+	/* Submission errors complete the request right away */
+	io = ut_zero_copy_io_init(UBLK_IO_OP_READ, 0, 9);
+	MOCK_SET(spdk_bdev_readv_blocks_ext, -EINVAL);
+	ublk_submit_bdev_io(io->q, io);
+	MOCK_CLEAR(spdk_bdev_readv_blocks_ext);
+	CU_ASSERT(g_io_wait_entry == NULL);
+	CU_ASSERT(ut_io_is_completed(io));
+	CU_ASSERT(io->cmd_op == UBLK_IO_COMMIT_AND_FETCH_REQ);
+	CU_ASSERT(io->result == -EIO);
+
+	/* Requests without data do not go through the memory domain */
+	io = ut_zero_copy_io_init(UBLK_IO_OP_FLUSH, 0, 10);
+	ublk_submit_bdev_io(io->q, io);
+	CU_ASSERT(g_ext_io.cb == NULL);
+
+	_ublk_fini_done(NULL);
+}
+
+static void
+zero_copy_fallback(void)
+{
+	struct spdk_ublk_dev ublk = {};
+
+	/* Only bdevs reporting the ublk domain type get zero copy */
+	g_bdev_num_domain_types = 0;
+	CU_ASSERT(ublk_bdev_supports_zero_copy(NULL) == false);
+	g_bdev_domain_types[0] = SPDK_DMA_DEVICE_TYPE_RDMA;
+	g_bdev_num_domain_types = 1;
+	CU_ASSERT(ublk_bdev_supports_zero_copy(NULL) == false);
+	g_bdev_domain_types[1] = SPDK_DMA_DEVICE_TYPE_UBLK;
+	g_bdev_num_domain_types = 2;
+	CU_ASSERT(ublk_bdev_supports_zero_copy(NULL) == true);
+	g_bdev_num_domain_types = 0;
+
+	/* Zero copy is asked of the kernel on top of user copy */
+	g_ublk_tgt.user_copy = true;
+	ublk.zero_copy = true;
+	ublk_dev_info_init(&ublk);
+	CU_ASSERT(ublk.dev_info.flags & UBLK_F_USER_COPY);
+	CU_ASSERT(ublk.dev_info.flags & UBLK_F_SUPPORT_ZERO_COPY);
+
+	ublk.zero_copy = false;
+	ublk_dev_info_init(&ublk);
+	CU_ASSERT(ublk.dev_info.flags & UBLK_F_USER_COPY);
+	CU_ASSERT(!(ublk.dev_info.flags & UBLK_F_SUPPORT_ZERO_COPY));
+
+	/* Without user copy the request data is copied into the buffers of the ublk driver */
+	g_ublk_tgt.user_copy = false;
+	ublk.zero_copy = true;
+	ublk_dev_info_init(&ublk);
+	CU_ASSERT(!(ublk.dev_info.flags & UBLK_F_SUPPORT_ZERO_COPY));
+	CU_ASSERT(ublk.dev_info.flags & UBLK_F_NEED_GET_DATA);
+
+	/* Devices in user-copy mode keep using bounce buffers */
+	ut_zero_copy_io_init(UBLK_IO_OP_WRITE, 0, 11);
+	g_ublk.zero_copy = false;
+	_ublk_submit_bdev_io(g_io.q, &g_io);
+	CU_ASSERT(g_ext_io.cb == NULL);
+	CU_ASSERT(ut_io_is_completed(&g_io) == false);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite suite = NULL;
+	unsigned int num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("ublk", NULL, NULL);
+
+	CU_ADD_TEST(suite, zero_copy_memory_domain);
+	CU_ADD_TEST(suite, zero_copy_pull_push);
+	CU_ADD_TEST(suite, zero_copy_submit);
+	CU_ADD_TEST(suite, zero_copy_fallback);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+	CU_cleanup_registry();
+
+	return num_failures;
+}
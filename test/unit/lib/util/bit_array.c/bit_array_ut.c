@@ -317,6 +317,132 @@ test_mask_clear(void)
 	spdk_bit_array_free(&ba);
 }
 
+static uint32_t
+ref_find_first_clear(const struct spdk_bit_array *ba, uint32_t start)
+{
+	uint32_t i;
+
+	for (i = start; i < spdk_bit_array_capacity(ba); i++) {
+		if (!spdk_bit_array_get(ba, i)) {
+			return i;
+		}
+	}
+
+	return UINT32_MAX;
+}
+
+static void
+test_find_clear_summary(void)
+{
+	struct spdk_bit_array *ba;
+	/* Sizes covering one, two and three summary levels, with partial last words */
+	const uint32_t sizes[] = { 64, 65, 64 * 64, 64 * 64 + 1, 64 * 64 * 64 + 100 };
+	uint32_t i, j, size, bit;
+
+	for (i = 0; i < SPDK_COUNTOF(sizes); i++) {
+		size = sizes[i];
+		ba = spdk_bit_array_create(size);
+		SPDK_CU_ASSERT_FATAL(ba != NULL);
+
+		/* Fill the whole array, checking first clear bit as it fills up */
+		for (j = 0; j < size; j++) {
+			CU_ASSERT(spdk_bit_array_find_first_clear(ba, 0) == j);
+			CU_ASSERT(spdk_bit_array_set(ba, j) == 0);
+		}
+		CU_ASSERT(spdk_bit_array_find_first_clear(ba, 0) == UINT32_MAX);
+
+		/* Clear the last bit and the bit in the middle */
+		spdk_bit_array_clear(ba, size - 1);
+		CU_ASSERT(spdk_bit_array_find_first_clear(ba, 0) == size - 1);
+		spdk_bit_array_clear(ba, size / 2);
+		CU_ASSERT(spdk_bit_array_find_first_clear(ba, 0) == size / 2);
+		CU_ASSERT(spdk_bit_array_find_first_clear(ba, size / 2 + 1) == size - 1);
+		CU_ASSERT(spdk_bit_array_set(ba, size / 2) == 0);
+		CU_ASSERT(spdk_bit_array_set(ba, size - 1) == 0);
+		CU_ASSERT(spdk_bit_array_find_first_clear(ba, 0) == UINT32_MAX);
+
+		/* Clear random bits and compare against a linear search */
+		for (j = 0; j < 200; j++) {
+			bit = rand() % size;
+			if (rand() % 2) {
+				spdk_bit_array_clear(ba, bit);
+			} else {
+				CU_ASSERT(spdk_bit_array_set(ba, bit) == 0);
+			}
+
+			bit = rand() % size;
+			CU_ASSERT(spdk_bit_array_find_first_clear(ba, bit) == ref_find_first_clear(ba, bit));
+			CU_ASSERT(spdk_bit_array_find_first_clear(ba, 0) == ref_find_first_clear(ba, 0));
+		}
+
+		/* Shrink and grow the array, the summary has to follow */
+		for (j = 0; j < size; j++) {
+			CU_ASSERT(spdk_bit_array_set(ba, j) == 0);
+		}
+		SPDK_CU_ASSERT_FATAL(spdk_bit_array_resize(&ba, size - 1) == 0);
+		CU_ASSERT(spdk_bit_array_find_first_clear(ba, 0) == UINT32_MAX);
+		SPDK_CU_ASSERT_FATAL(spdk_bit_array_resize(&ba, size * 2) == 0);
+		CU_ASSERT(spdk_bit_array_find_first_clear(ba, 0) == size - 1);
+		CU_ASSERT(spdk_bit_array_find_first_clear(ba, size) == size);
+
+		/* Loading a mask rebuilds the summary */
+		spdk_bit_array_clear_mask(ba);
+		CU_ASSERT(spdk_bit_array_find_first_clear(ba, 0) == 0);
+
+		spdk_bit_array_free(&ba);
+	}
+}
+
+static void
+test_bit_pool_run(void)
+{
+	struct spdk_bit_pool *pool;
+	uint32_t bit, i;
+
+	pool = spdk_bit_pool_create(200);
+	SPDK_CU_ASSERT_FATAL(pool != NULL);
+
+	/* Invalid sizes */
+	CU_ASSERT(spdk_bit_pool_allocate_run(pool, 0) == UINT32_MAX);
+	CU_ASSERT(spdk_bit_pool_allocate_run(pool, 201) == UINT32_MAX);
+
+	CU_ASSERT(spdk_bit_pool_allocate_run(pool, 10) == 0);
+	CU_ASSERT(spdk_bit_pool_allocate_run(pool, 100) == 10);
+	CU_ASSERT(spdk_bit_pool_allocate_bit(pool) == 110);
+	CU_ASSERT(spdk_bit_pool_count_allocated(pool) == 111);
+	for (i = 0; i < 111; i++) {
+		CU_ASSERT(spdk_bit_pool_is_allocated(pool, i));
+	}
+	CU_ASSERT(!spdk_bit_pool_is_allocated(pool, 111));
+
+	/* Free a run in the middle, a smaller run should fit there, a larger one shouldn't */
+	spdk_bit_pool_free_run(pool, 20, 50);
+	CU_ASSERT(spdk_bit_pool_count_free(pool) == 139);
+	CU_ASSERT(spdk_bit_pool_allocate_run(pool, 60) == 111);
+	CU_ASSERT(spdk_bit_pool_allocate_run(pool, 40) == 20);
+	CU_ASSERT(spdk_bit_pool_allocate_bit(pool) == 60);
+
+	/* Run too large for any of the free ranges */
+	CU_ASSERT(spdk_bit_pool_allocate_run(pool, 30) == UINT32_MAX);
+	CU_ASSERT(spdk_bit_pool_allocate_run(pool, 29) == 171);
+	CU_ASSERT(spdk_bit_pool_count_free(pool) == 9);
+	CU_ASSERT(spdk_bit_pool_allocate_run(pool, 9) == 61);
+	CU_ASSERT(spdk_bit_pool_count_free(pool) == 0);
+	CU_ASSERT(spdk_bit_pool_allocate_bit(pool) == UINT32_MAX);
+	CU_ASSERT(spdk_bit_pool_allocate_run(pool, 1) == UINT32_MAX);
+
+	/* Run spanning multiple words */
+	spdk_bit_pool_free_run(pool, 3, 190);
+	bit = spdk_bit_pool_allocate_run(pool, 190);
+	CU_ASSERT(bit == 3);
+	spdk_bit_pool_free_run(pool, 3, 190);
+	CU_ASSERT(spdk_bit_pool_allocate_bit(pool) == 3);
+	CU_ASSERT(spdk_bit_pool_allocate_run(pool, 189) == 4);
+	CU_ASSERT(spdk_bit_pool_count_free(pool) == 0);
+
+	spdk_bit_pool_free(&pool);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -335,6 +461,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_count);
 	CU_ADD_TEST(suite, test_mask_store_load);
 	CU_ADD_TEST(suite, test_mask_clear);
+	CU_ADD_TEST(suite, test_find_clear_summary);
+	CU_ADD_TEST(suite, test_bit_pool_run);
 
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
@@ -164,6 +164,42 @@ test_crc32c_nvme(void)
 	CU_ASSERT(crc == 0x214941A8);
 }
 
+static void
+test_crc32c_nvme_multi(void)
+{
+	uint8_t *buf;
+	uint32_t crcs[8], count, len, stride, i;
+
+	buf = malloc(8 * (4096 + 16) + 1);
+	SPDK_CU_ASSERT_FATAL(buf != NULL);
+
+	for (i = 0; i < 8 * (4096 + 16) + 1; i++) {
+		buf[i] = rand();
+	}
+
+	/* Aligned and unaligned buffers and strides, with and without a partial last word */
+	for (count = 1; count <= 8; count++) {
+		for (len = 4093; len <= 4096; len++) {
+			for (stride = 4096; stride <= 4096 + 16; stride += 5) {
+				memset(crcs, 0, sizeof(crcs));
+				spdk_crc32c_nvme_multi(buf + (len & 1), len, stride, count, 0x5a5a, crcs);
+				for (i = 0; i < count; i++) {
+					CU_ASSERT(crcs[i] == spdk_crc32c_nvme(buf + (len & 1) + i * stride, len, 0x5a5a));
+				}
+			}
+		}
+	}
+
+	/* Compliant with the NVM Command Set Specification 1.0c, see test_crc32c_nvme() */
+	memset(buf, 0, 3 * 4096);
+	spdk_crc32c_nvme_multi(buf, 4096, 4096, 3, 0, crcs);
+	for (i = 0; i < 3; i++) {
+		CU_ASSERT(crcs[i] == 0x98F94189);
+	}
+
+	free(buf);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -176,6 +212,7 @@ main(int argc, char **argv)
 
 	CU_ADD_TEST(suite, test_crc32c);
 	CU_ADD_TEST(suite, test_crc32c_nvme);
+	CU_ADD_TEST(suite, test_crc32c_nvme_multi);
 
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
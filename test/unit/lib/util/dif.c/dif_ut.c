@@ -1320,6 +1320,55 @@ dif_inject_error_and_verify(struct iovec *iovs, int iovcnt,
 				     inject_flags, false, dif_pi_format);
 }
 
+/* Cover iovecs holding more blocks than are batched together for guard computation */
+static void
+_dif_multi_iovs_batch_test(uint32_t block_size, uint32_t md_size,
+			   enum spdk_dif_pi_format dif_pi_format)
+{
+	struct iovec iovs[3];
+	const int iov_blocks[3] = { 1, DIF_GUARD_BATCH + 1, DIF_GUARD_BATCH * 2 + 5 };
+	int i, num_blocks;
+	uint32_t dif_flags;
+
+	dif_flags = SPDK_DIF_FLAGS_GUARD_CHECK | SPDK_DIF_FLAGS_APPTAG_CHECK |
+		    SPDK_DIF_FLAGS_REFTAG_CHECK;
+
+	num_blocks = 0;
+
+	for (i = 0; i < 3; i++) {
+		_iov_alloc_buf(&iovs[i], block_size * iov_blocks[i]);
+		num_blocks += iov_blocks[i];
+	}
+
+	dif_generate_and_verify(iovs, 3, block_size, md_size, num_blocks, false, SPDK_DIF_TYPE1,
+				dif_flags, dif_pi_format, 22, 0xFFFF, 0x22);
+
+	dif_generate_and_verify(iovs, 3, block_size, md_size, num_blocks, true, SPDK_DIF_TYPE3,
+				dif_flags, dif_pi_format, 22, 0xFFFF, 0x22);
+
+	for (i = 0; i < 4; i++) {
+		dif_inject_error_and_verify(iovs, 3, block_size, md_size, num_blocks,
+					    SPDK_DIF_GUARD_ERROR, dif_pi_format);
+		dif_inject_error_and_verify(iovs, 3, block_size, md_size, num_blocks,
+					    SPDK_DIF_REFTAG_ERROR, dif_pi_format);
+		dif_inject_error_and_verify(iovs, 3, block_size, md_size, num_blocks,
+					    SPDK_DIF_DATA_ERROR, dif_pi_format);
+	}
+
+	for (i = 0; i < 3; i++) {
+		_iov_free_buf(&iovs[i]);
+	}
+}
+
+static void
+dif_multi_iovs_batch_test(void)
+{
+	_dif_multi_iovs_batch_test(512 + 8, 8, SPDK_DIF_PI_FORMAT_16);
+	_dif_multi_iovs_batch_test(4096 + 128, 128, SPDK_DIF_PI_FORMAT_16);
+	_dif_multi_iovs_batch_test(4096 + 128, 128, SPDK_DIF_PI_FORMAT_32);
+	_dif_multi_iovs_batch_test(4096 + 128, 128, SPDK_DIF_PI_FORMAT_64);
+}
+
 static void
 dif_sec_4096_md_128_inject_1_2_4_8_multi_iovs_test(void)
 {
@@ -4563,6 +4612,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, dif_sec_4096_md_128_prchk_7_multi_iovs_split_reftag_test);
 	CU_ADD_TEST(suite, dif_sec_512_md_8_prchk_7_multi_iovs_complex_splits_test);
 	CU_ADD_TEST(suite, dif_sec_4096_md_128_prchk_7_multi_iovs_complex_splits_test);
+	CU_ADD_TEST(suite, dif_multi_iovs_batch_test);
 	CU_ADD_TEST(suite, dif_sec_4096_md_128_inject_1_2_4_8_multi_iovs_test);
 	CU_ADD_TEST(suite, dif_sec_4096_md_128_inject_1_2_4_8_multi_iovs_split_data_and_md_test);
 	CU_ADD_TEST(suite, dif_sec_4096_md_128_inject_1_2_4_8_multi_iovs_split_data_test);
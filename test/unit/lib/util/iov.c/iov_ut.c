@@ -267,6 +267,51 @@ test_memset(void)
 	CU_ASSERT(_check_val(iov_buffer, 64, 0) == 0);
 }
 
+static void
+test_iov_slice(void)
+{
+	struct iovec iov[4], out[4];
+	uint8_t iov_buffer[64];
+	int iovcnt;
+
+	iov[0].iov_base = iov_buffer;
+	iov[0].iov_len = 5;
+	iov[1].iov_base = iov[0].iov_base + iov[0].iov_len;
+	iov[1].iov_len = 15;
+	iov[2].iov_base = iov[1].iov_base + iov[1].iov_len;
+	iov[2].iov_len = 21;
+	iov[3].iov_base = iov[2].iov_base + iov[2].iov_len;
+	iov[3].iov_len = 23;
+
+	/* Range within a single element */
+	iovcnt = spdk_iov_slice(iov, 4, 6, 10, out);
+	CU_ASSERT(iovcnt == 1);
+	CU_ASSERT(out[0].iov_base == iov_buffer + 6);
+	CU_ASSERT(out[0].iov_len == 10);
+
+	/* Range spanning all elements */
+	iovcnt = spdk_iov_slice(iov, 4, 3, 40, out);
+	CU_ASSERT(iovcnt == 4);
+	CU_ASSERT(out[0].iov_base == iov_buffer + 3);
+	CU_ASSERT(out[0].iov_len == 2);
+	CU_ASSERT(out[1].iov_base == iov[1].iov_base);
+	CU_ASSERT(out[1].iov_len == 15);
+	CU_ASSERT(out[2].iov_base == iov[2].iov_base);
+	CU_ASSERT(out[2].iov_len == 21);
+	CU_ASSERT(out[3].iov_base == iov[3].iov_base);
+	CU_ASSERT(out[3].iov_len == 2);
+
+	/* Range ending exactly at the end of the iovec */
+	iovcnt = spdk_iov_slice(iov, 4, 41, 23, out);
+	CU_ASSERT(iovcnt == 1);
+	CU_ASSERT(out[0].iov_base == iov[3].iov_base);
+	CU_ASSERT(out[0].iov_len == 23);
+
+	/* Empty range */
+	iovcnt = spdk_iov_slice(iov, 4, 10, 0, out);
+	CU_ASSERT(iovcnt == 0);
+}
+
 static void
 test_iov_one(void)
 {
@@ -343,6 +388,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_iovs_to_buf);
 	CU_ADD_TEST(suite, test_buf_to_iovs);
 	CU_ADD_TEST(suite, test_memset);
+	CU_ADD_TEST(suite, test_iov_slice);
 	CU_ADD_TEST(suite, test_iov_one);
 	CU_ADD_TEST(suite, test_iov_xfer);
 
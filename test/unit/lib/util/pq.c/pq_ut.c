@@ -0,0 +1,241 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk_internal/cunit.h"
+
+#include "util/pq.c"
+#include "common/lib/test_env.c"
+
+#define DATA_BUF_COUNT 6
+#define BUF_COUNT (DATA_BUF_COUNT + 2)
+#define BUF_SIZE 4096
+
+static uint8_t
+ref_gf_mul(uint8_t a, uint8_t b)
+{
+	uint8_t r = 0;
+
+	while (b) {
+		if (b & 1) {
+			r ^= a;
+		}
+		a = (a << 1) ^ ((a & 0x80) ? 0x1d : 0);
+		b >>= 1;
+	}
+
+	return r;
+}
+
+static void
+ref_pq_gen(void **bufs, uint32_t n, uint32_t len, uint8_t *p, uint8_t *q)
+{
+	uint8_t coef;
+	uint32_t i, j;
+
+	memset(p, 0, len);
+	memset(q, 0, len);
+
+	for (i = 0, coef = 1; i < n; i++, coef = ref_gf_mul(coef, 2)) {
+		for (j = 0; j < len; j++) {
+			p[j] ^= ((uint8_t *)bufs[i])[j];
+			q[j] ^= ref_gf_mul(coef, ((uint8_t *)bufs[i])[j]);
+		}
+	}
+}
+
+static void **
+alloc_bufs(uint32_t count, size_t size)
+{
+	void **bufs;
+	uint32_t i, j;
+	int ret;
+
+	bufs = calloc(count, sizeof(*bufs));
+	SPDK_CU_ASSERT_FATAL(bufs != NULL);
+
+	for (i = 0; i < count; i++) {
+		ret = posix_memalign(&bufs[i], spdk_pq_get_optimal_alignment(), size);
+		SPDK_CU_ASSERT_FATAL(ret == 0);
+
+		for (j = 0; j < size; j++) {
+			((uint8_t *)bufs[i])[j] = rand();
+		}
+	}
+
+	return bufs;
+}
+
+static void
+free_bufs(void **bufs, uint32_t count)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; i++) {
+		free(bufs[i]);
+	}
+	free(bufs);
+}
+
+static void
+test_gf_tables(void)
+{
+	uint32_t a, b;
+
+	for (a = 0; a < 256; a++) {
+		for (b = 0; b < 256; b++) {
+			CU_ASSERT(gf_mul(a, b) == ref_gf_mul(a, b));
+		}
+		if (a != 0) {
+			CU_ASSERT(gf_mul(a, gf_inv(a)) == 1);
+		}
+	}
+}
+
+static void
+test_pq_gen(void)
+{
+	void **bufs, *bufs2[BUF_COUNT];
+	uint8_t *p, *q;
+	uint32_t n;
+	int ret;
+
+	bufs = alloc_bufs(BUF_COUNT, BUF_SIZE);
+	p = malloc(BUF_SIZE);
+	q = malloc(BUF_SIZE);
+	SPDK_CU_ASSERT_FATAL(p != NULL && q != NULL);
+
+	for (n = 2; n <= DATA_BUF_COUNT; n++) {
+		memcpy(bufs2, bufs, n * sizeof(void *));
+		bufs2[n] = bufs[DATA_BUF_COUNT];
+		bufs2[n + 1] = bufs[DATA_BUF_COUNT + 1];
+
+		ref_pq_gen(bufs2, n, BUF_SIZE, p, q);
+		ret = spdk_pq_gen(bufs2, n, BUF_SIZE);
+		CU_ASSERT(ret == 0);
+		CU_ASSERT(memcmp(bufs2[n], p, BUF_SIZE) == 0);
+		CU_ASSERT(memcmp(bufs2[n + 1], q, BUF_SIZE) == 0);
+	}
+
+	/* len not multiple of alignment */
+	memset(bufs[DATA_BUF_COUNT], 0xba, BUF_SIZE);
+	memset(bufs[DATA_BUF_COUNT + 1], 0xba, BUF_SIZE);
+	ref_pq_gen(bufs, DATA_BUF_COUNT, BUF_SIZE - 1, p, q);
+	ret = spdk_pq_gen(bufs, DATA_BUF_COUNT, BUF_SIZE - 1);
+	CU_ASSERT(ret == 0);
+	CU_ASSERT(memcmp(bufs[DATA_BUF_COUNT], p, BUF_SIZE - 1) == 0);
+	CU_ASSERT(memcmp(bufs[DATA_BUF_COUNT + 1], q, BUF_SIZE - 1) == 0);
+	CU_ASSERT(((uint8_t *)bufs[DATA_BUF_COUNT])[BUF_SIZE - 1] == 0xba);
+
+	/* unaligned buffers */
+	memcpy(bufs2, bufs, sizeof(bufs2));
+	bufs2[1] += 1;
+	bufs2[2] += 2;
+	bufs2[DATA_BUF_COUNT + 1] += 3;
+	ref_pq_gen(bufs2, DATA_BUF_COUNT, BUF_SIZE - 3, p, q);
+	ret = spdk_pq_gen(bufs2, DATA_BUF_COUNT, BUF_SIZE - 3);
+	CU_ASSERT(ret == 0);
+	CU_ASSERT(memcmp(bufs2[DATA_BUF_COUNT], p, BUF_SIZE - 3) == 0);
+	CU_ASSERT(memcmp(bufs2[DATA_BUF_COUNT + 1], q, BUF_SIZE - 3) == 0);
+
+	/* invalid number of data buffers */
+	CU_ASSERT(spdk_pq_gen(bufs, 1, BUF_SIZE) == -EINVAL);
+	CU_ASSERT(spdk_pq_gen(bufs, SPDK_PQ_MAX_DATA + 1, BUF_SIZE) == -EINVAL);
+
+	free(p);
+	free(q);
+	free_bufs(bufs, BUF_COUNT);
+}
+
+static void
+test_pq_recover(void)
+{
+	void **bufs, **ref;
+	uint32_t failed[SPDK_PQ_MAX_FAILED];
+	uint32_t n, a, b, i;
+	int ret;
+
+	bufs = alloc_bufs(BUF_COUNT, BUF_SIZE);
+	ref = alloc_bufs(BUF_COUNT, BUF_SIZE);
+
+	for (n = 2; n <= DATA_BUF_COUNT; n++) {
+		ret = spdk_pq_gen(ref, n, BUF_SIZE);
+		CU_ASSERT(ret == 0);
+
+		/* single failures */
+		for (a = 0; a < n + 2; a++) {
+			for (i = 0; i < n + 2; i++) {
+				memcpy(bufs[i], ref[i], BUF_SIZE);
+			}
+			memset(bufs[a], 0xba, BUF_SIZE);
+
+			failed[0] = a;
+			ret = spdk_pq_recover(bufs, n, BUF_SIZE, failed, 1);
+			CU_ASSERT(ret == 0);
+			CU_ASSERT(memcmp(bufs[a], ref[a], BUF_SIZE) == 0);
+		}
+
+		/* all combinations of double failures, in both orders */
+		for (a = 0; a < n + 2; a++) {
+			for (b = 0; b < n + 2; b++) {
+				if (a == b) {
+					continue;
+				}
+
+				for (i = 0; i < n + 2; i++) {
+					memcpy(bufs[i], ref[i], BUF_SIZE);
+				}
+				memset(bufs[a], 0xba, BUF_SIZE);
+				memset(bufs[b], 0xab, BUF_SIZE);
+
+				failed[0] = a;
+				failed[1] = b;
+				ret = spdk_pq_recover(bufs, n, BUF_SIZE, failed, 2);
+				CU_ASSERT(ret == 0);
+				CU_ASSERT(memcmp(bufs[a], ref[a], BUF_SIZE) == 0);
+				CU_ASSERT(memcmp(bufs[b], ref[b], BUF_SIZE) == 0);
+
+				for (i = 0; i < n + 2; i++) {
+					CU_ASSERT(memcmp(bufs[i], ref[i], BUF_SIZE) == 0);
+				}
+			}
+		}
+	}
+
+	/* invalid arguments */
+	failed[0] = 0;
+	failed[1] = 0;
+	CU_ASSERT(spdk_pq_recover(bufs, DATA_BUF_COUNT, BUF_SIZE, failed, 0) == -EINVAL);
+	CU_ASSERT(spdk_pq_recover(bufs, DATA_BUF_COUNT, BUF_SIZE, failed, 3) == -EINVAL);
+	CU_ASSERT(spdk_pq_recover(bufs, DATA_BUF_COUNT, BUF_SIZE, failed, 2) == -EINVAL);
+	failed[0] = DATA_BUF_COUNT + 2;
+	CU_ASSERT(spdk_pq_recover(bufs, DATA_BUF_COUNT, BUF_SIZE, failed, 1) == -EINVAL);
+	CU_ASSERT(spdk_pq_recover(bufs, 1, BUF_SIZE, failed, 1) == -EINVAL);
+
+	free_bufs(bufs, BUF_COUNT);
+	free_bufs(ref, BUF_COUNT);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("pq", NULL, NULL);
+
+	CU_ADD_TEST(suite, test_gf_tables);
+	CU_ADD_TEST(suite, test_pq_gen);
+	CU_ADD_TEST(suite, test_pq_recover);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+
+	CU_cleanup_registry();
+
+	return num_failures;
+}
@@ -30,6 +30,10 @@ function unittest_bdev() {
 	$valgrind $testdir/lib/bdev/scsi_nvme.c/scsi_nvme_ut
 	$valgrind $testdir/lib/bdev/vbdev_lvol.c/vbdev_lvol_ut
 	$valgrind $testdir/lib/bdev/vbdev_zone_block.c/vbdev_zone_block_ut
+	$valgrind $testdir/lib/bdev/vbdev_dedup.c/vbdev_dedup_ut
+	$valgrind $testdir/lib/bdev/vbdev_compress.c/vbdev_compress_ut
+	$valgrind $testdir/lib/bdev/vbdev_cache.c/vbdev_cache_ut
+	$valgrind $testdir/lib/bdev/vbdev_readahead.c/vbdev_readahead_ut
 	$valgrind $testdir/lib/bdev/mt/bdev.c/bdev_ut
 }
 
@@ -138,6 +142,7 @@ function unittest_util() {
 	$valgrind $testdir/lib/util/iov.c/iov_ut
 	$valgrind $testdir/lib/util/math.c/math_ut
 	$valgrind $testdir/lib/util/pipe.c/pipe_ut
+	$valgrind $testdir/lib/util/pq.c/pq_ut
 	if [ $(uname -s) = Linux ]; then
 		$valgrind $testdir/lib/util/fd_group.c/fd_group_ut
 	fi
@@ -202,6 +207,10 @@ if [[ $CONFIG_RAID5F == y ]]; then
 	run_test "unittest_bdev_raid5f" $valgrind $testdir/lib/bdev/raid/raid5f.c/raid5f_ut
 fi
 
+if [[ $CONFIG_RAID6 == y ]]; then
+	run_test "unittest_bdev_raid6" $valgrind $testdir/lib/bdev/raid/raid6.c/raid6_ut
+fi
+
 run_test "unittest_blob" unittest_blob
 run_test "unittest_event" unittest_event
 if [ $(uname -s) = Linux ]; then
@@ -265,6 +274,9 @@ fi
 if [[ $CONFIG_VHOST == y ]]; then
 	run_test "unittest_vhost" $valgrind $testdir/lib/vhost/vhost.c/vhost_ut
 fi
+if [[ $CONFIG_UBLK == y ]]; then
+	run_test "unittest_ublk" $valgrind $testdir/lib/ublk/ublk.c/ublk_ut
+fi
 run_test "unittest_dma" $valgrind $testdir/lib/dma/dma.c/dma_ut
 
 run_test "unittest_init" unittest_init